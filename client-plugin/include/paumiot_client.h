@@ -36,7 +36,8 @@ typedef enum {
     PAUMIOT_CLIENT_ERROR_AUTHENTICATION_FAILED = -8,
     PAUMIOT_CLIENT_ERROR_AUTHORIZATION_FAILED = -9,
     PAUMIOT_CLIENT_ERROR_ALREADY_SUBSCRIBED = -10,
-    PAUMIOT_CLIENT_ERROR_NOT_SUBSCRIBED = -11
+    PAUMIOT_CLIENT_ERROR_NOT_SUBSCRIBED = -11,
+    PAUMIOT_CLIENT_ERROR_WOULD_BLOCK = -12      /* Inflight window or send buffer full */
 } paumiot_client_result_t;
 
 /* Protocol Types */
@@ -47,6 +48,14 @@ typedef enum {
     PAUMIOT_PROTOCOL_HTTP = 3       /* HTTP/REST (future) */
 } paumiot_protocol_t;
 
+/* CoAP Request Methods (RFC 7252 method codes) */
+typedef enum {
+    PAUMIOT_COAP_GET = 1,
+    PAUMIOT_COAP_POST = 2,
+    PAUMIOT_COAP_PUT = 3,
+    PAUMIOT_COAP_DELETE = 4
+} paumiot_coap_method_t;
+
 /* QoS Levels */
 typedef enum {
     PAUMIOT_QOS_0 = 0,  /* At most once (Fire and forget) */
@@ -65,6 +74,7 @@ typedef enum {
 /* Forward Declarations */
 typedef struct paumiot_client paumiot_client_t;
 typedef struct paumiot_message paumiot_message_t;
+typedef struct paumiot_event_loop paumiot_event_loop_t;
 
 /* Message Structure */
 struct paumiot_message {
@@ -76,13 +86,23 @@ struct paumiot_message {
     void *user_data;                /* User-defined data */
 };
 
+/* CoAP Response */
+typedef struct {
+    uint8_t code;                   /* Class << 5 | detail, e.g. 0x45 = 2.05 Content */
+    const uint8_t *payload;         /* Response payload */
+    size_t payload_len;             /* Payload length */
+} paumiot_coap_response_t;
+
 /* Callback Function Types */
 
 /**
  * @brief Callback for incoming messages
  * @param client Client instance
- * @param message Received message (must not be freed by callback)
+ * @param message Received message, valid only during the call (must not be
+ *        freed or modified; see paumiot_message_retain() to keep it)
  * @param user_data User-defined data passed during subscription
+ * @note With zero_copy_receive the topic and payload point into the
+ *       client's receive buffer, which the next read overwrites.
  */
 typedef void (*paumiot_message_callback_t)(
     paumiot_client_t *client,
@@ -105,9 +125,13 @@ typedef void (*paumiot_connection_callback_t)(
 /**
  * @brief Callback for publish confirmation
  * @param client Client instance
- * @param message_id Unique message identifier
+ * @param message_id Unique message identifier (valid during the call)
  * @param success True if publish was successful
  * @param user_data User-defined data
+ * @note Runs on the thread driving paumiot_client_loop(): for QoS 1/2 when
+ *       the broker acknowledges, for QoS 0 on the loop pass after the
+ *       publish was queued, and with success = false for everything still
+ *       outstanding when the connection drops.
  */
 typedef void (*paumiot_publish_callback_t)(
     paumiot_client_t *client,
@@ -116,6 +140,26 @@ typedef void (*paumiot_publish_callback_t)(
     void *user_data
 );
 
+/**
+ * @brief Callback for a CoAP response
+ * @param client Client instance
+ * @param result PAUMIOT_CLIENT_SUCCESS if a response arrived,
+ *        PAUMIOT_CLIENT_ERROR_TIMEOUT if none came in time,
+ *        PAUMIOT_CLIENT_ERROR_PROTOCOL if the gateway reset the request,
+ *        PAUMIOT_CLIENT_ERROR_NOT_CONNECTED if the client disconnected
+ * @param response Response, NULL unless result is PAUMIOT_CLIENT_SUCCESS;
+ *        valid only during the call (the payload points into the receive
+ *        buffer)
+ * @param user_data User-defined data passed with the request
+ * @note Runs on the thread driving paumiot_client_loop().
+ */
+typedef void (*paumiot_response_callback_t)(
+    paumiot_client_t *client,
+    paumiot_client_result_t result,
+    const paumiot_coap_response_t *response,
+    void *user_data
+);
+
 /* Client Configuration */
 typedef struct {
     /* Connection Settings */
@@ -139,7 +183,9 @@ typedef struct {
     /* Buffer Settings */
     size_t send_buffer_size;        /* Send buffer size (bytes) */
     size_t recv_buffer_size;        /* Receive buffer size (bytes) */
-    size_t max_inflight_messages;   /* Max messages in flight */
+    size_t max_inflight_messages;   /* Unacknowledged QoS 1/2 publishes, or pending
+                                       CoAP requests (1-65535) */
+    bool zero_copy_receive;         /* Lend received messages from recv buffer */
     
     /* Callbacks */
     paumiot_connection_callback_t connection_callback;
@@ -147,8 +193,18 @@ typedef struct {
     
     /* Advanced Settings */
     bool auto_reconnect;            /* Automatic reconnection */
-    uint32_t reconnect_delay_ms;    /* Delay between reconnect attempts */
+    uint32_t reconnect_delay_ms;    /* Shortest delay before a reconnect attempt */
+    uint32_t reconnect_max_delay_ms; /* Longest delay between attempts */
     uint32_t max_reconnect_attempts; /* Max reconnection attempts (0 = infinite) */
+
+    /* Offline Spool (optional) */
+    const char *spool_path;         /* File keeping publishes made while disconnected */
+    size_t spool_size;              /* Spool capacity (bytes) */
+    uint32_t spool_drain_ratio;     /* Spooled sends per live send after reconnecting */
+
+    /* CoAP Settings (PAUMIOT_PROTOCOL_COAP) */
+    uint32_t coap_nstart;           /* Requests outstanding at once (RFC 7252 NSTART) */
+    uint32_t coap_ack_timeout_ms;   /* First retransmission timeout (ACK_TIMEOUT) */
 } paumiot_client_config_t;
 
 /* ============================================================================
@@ -202,6 +258,10 @@ paumiot_connection_state_t paumiot_client_get_state(const paumiot_client_t *clie
 
 /**
  * @brief Publish a message (synchronous)
+ * @details Returns once a QoS 0 message is written to the socket, or a
+ *          QoS 1/2 message is acknowledged, waiting at most
+ *          connect_timeout_ms. Drives the loop itself unless the loop thread
+ *          runs; must not be called from a client callback.
  * @param client Client instance
  * @param topic Topic or URI path
  * @param payload Message payload
@@ -221,15 +281,31 @@ paumiot_client_result_t paumiot_client_publish(
 
 /**
  * @brief Publish a message (asynchronous)
+ * @details Never waits for the broker: the message is encoded into the send
+ *          buffer and written as far as the socket allows. QoS 1/2 messages
+ *          occupy one of max_inflight_messages slots until acknowledged, so
+ *          a full window is on the wire at once rather than one message
+ *          per round trip. Safe to call from any thread.
+ *
+ *          With spool_path set, a message published while disconnected is
+ *          appended to the spool and its callback reports success once it
+ *          is stored. Spooled messages are sent after the next connect,
+ *          interleaved with live ones, and survive a restart of the
+ *          process; one may be delivered twice if the connection drops
+ *          before the broker acknowledges it.
  * @param client Client instance
  * @param topic Topic or URI path
  * @param payload Message payload
  * @param payload_len Payload length
  * @param qos Quality of Service level
  * @param retain Retain flag
- * @param callback Callback for publish confirmation
+ * @param callback Callback for publish confirmation (may be NULL)
  * @param user_data User-defined data passed to callback
- * @return PAUMIOT_CLIENT_SUCCESS on success, error code otherwise
+ * @return PAUMIOT_CLIENT_SUCCESS on success,
+ *         PAUMIOT_CLIENT_ERROR_WOULD_BLOCK if the window or send buffer is
+ *         full (run the loop and retry),
+ *         PAUMIOT_CLIENT_ERROR_BUFFER_OVERFLOW if the spool is full,
+ *         error code otherwise
  */
 paumiot_client_result_t paumiot_client_publish_async(
     paumiot_client_t *client,
@@ -242,6 +318,39 @@ paumiot_client_result_t paumiot_client_publish_async(
     void *user_data
 );
 
+/**
+ * @brief Number of spooled messages not yet acknowledged by the broker
+ * @param client Client instance
+ * @return Message count (0 without a spool)
+ */
+size_t paumiot_client_spooled(const paumiot_client_t *client);
+
+/**
+ * @brief Publish several messages with one socket write (asynchronous)
+ * @details Encodes the messages back to back into the send buffer and then
+ *          writes them with a single send(), so a device reporting many
+ *          readings at once pays one syscall and as few TCP segments as
+ *          the payload allows. Messages are queued in order and each one
+ *          behaves as with paumiot_client_publish_async(). If the window or
+ *          send buffer fills part way, the messages before that point are
+ *          still sent and PAUMIOT_CLIENT_ERROR_WOULD_BLOCK is returned.
+ * @param client Client instance
+ * @param messages Messages to publish; each user_data is passed to callback
+ * @param count Number of messages
+ * @param callback Callback for publish confirmation of each message (may be NULL)
+ * @param published Receives the number of messages queued (may be NULL)
+ * @return PAUMIOT_CLIENT_SUCCESS if all were queued,
+ *         PAUMIOT_CLIENT_ERROR_INVALID_PARAM if any message is invalid
+ *         (none are queued), error code otherwise
+ */
+paumiot_client_result_t paumiot_client_publish_batch(
+    paumiot_client_t *client,
+    const paumiot_message_t *messages,
+    size_t count,
+    paumiot_publish_callback_t callback,
+    size_t *published
+);
+
 /* ============================================================================
  * SUBSCRIBE API
  * ========================================================================= */
@@ -274,12 +383,74 @@ paumiot_client_result_t paumiot_client_unsubscribe(
     const char *topic_filter
 );
 
+/* ============================================================================
+ * COAP REQUEST API
+ * ========================================================================= */
+
+/**
+ * @brief Send a CoAP request without waiting for the response
+ * @details For clients created with PAUMIOT_PROTOCOL_COAP, which connect
+ *          to the gateway over UDP and support only this call for
+ *          traffic. Up to coap_nstart requests are outstanding at once;
+ *          later ones, up to max_inflight_messages in all, wait in order
+ *          for an earlier one to finish. A confirmable request is
+ *          retransmitted with exponential backoff starting at
+ *          coap_ack_timeout_ms. A request without a response after
+ *          MAX_TRANSMIT_WAIT (46.5 x coap_ack_timeout_ms) fails with
+ *          PAUMIOT_CLIENT_ERROR_TIMEOUT.
+ * @param client Client instance
+ * @param method Request method
+ * @param path Uri-Path, e.g. "sensors/12/temp"
+ * @param payload Request payload (can be NULL if payload_len is 0)
+ * @param payload_len Payload length
+ * @param confirmable true for CON (retransmitted until acknowledged),
+ *        false for NON
+ * @param callback Callback for the response (can be NULL)
+ * @param user_data User-defined data passed to callback
+ * @return PAUMIOT_CLIENT_SUCCESS if queued,
+ *         PAUMIOT_CLIENT_ERROR_WOULD_BLOCK if max_inflight_messages
+ *         requests are pending (run the loop and retry),
+ *         PAUMIOT_CLIENT_ERROR_BUFFER_OVERFLOW if the request does not fit
+ *         in a datagram, PAUMIOT_CLIENT_ERROR_PROTOCOL for an MQTT client,
+ *         error code otherwise
+ */
+paumiot_client_result_t paumiot_client_request(
+    paumiot_client_t *client,
+    paumiot_coap_method_t method,
+    const char *path,
+    const uint8_t *payload,
+    size_t payload_len,
+    bool confirmable,
+    paumiot_response_callback_t callback,
+    void *user_data
+);
+
 /* ============================================================================
  * MESSAGE HANDLING API
  * ========================================================================= */
 
+/**
+ * @brief Copy a received message so it outlives the callback
+ * @details Topic, payload and user_data are copied into one allocation.
+ *          Meant for the few messages a callback keeps; the rest are read
+ *          in place.
+ * @param message Message passed to a paumiot_message_callback_t
+ * @return Copy to free with paumiot_message_release(), or NULL on error
+ */
+paumiot_message_t *paumiot_message_retain(const paumiot_message_t *message);
+
+/**
+ * @brief Free a message from paumiot_message_retain()
+ * @param message Retained message (can be NULL)
+ */
+void paumiot_message_release(paumiot_message_t *message);
+
 /**
  * @brief Process pending events (should be called regularly in main loop)
+ * @details Flushes the send buffer, reads acknowledgements and messages,
+ *          keeps the session alive, and runs every callback. Only one
+ *          thread may run the loop at a time, so do not call this for a
+ *          client attached to a running event loop.
  * @param client Client instance
  * @param timeout_ms Timeout in milliseconds (0 = non-blocking)
  * @return PAUMIOT_CLIENT_SUCCESS on success, error code otherwise
@@ -291,8 +462,11 @@ paumiot_client_result_t paumiot_client_loop(
 
 /**
  * @brief Start background thread for event processing
+ * @details Runs the client on a private event loop with its own thread.
  * @param client Client instance
- * @return PAUMIOT_CLIENT_SUCCESS on success, error code otherwise
+ * @return PAUMIOT_CLIENT_SUCCESS on success,
+ *         PAUMIOT_CLIENT_ERROR_INVALID_PARAM if the client is attached to
+ *         a shared event loop, error code otherwise
  * @note Alternative to calling paumiot_client_loop() manually
  */
 paumiot_client_result_t paumiot_client_loop_start(paumiot_client_t *client);
@@ -304,6 +478,96 @@ paumiot_client_result_t paumiot_client_loop_start(paumiot_client_t *client);
  */
 paumiot_client_result_t paumiot_client_loop_stop(paumiot_client_t *client);
 
+/**
+ * @brief File descriptor to embed the client in an application event loop
+ * @details The descriptor stays the same across reconnects. It polls
+ *          readable whenever paumiot_client_loop(client, 0) has work:
+ *          socket data, room to write queued bytes, a keep-alive timer
+ *          expiring, or a wakeup from a publishing thread. Watch it for
+ *          reading only and never read from it.
+ * @param client Client instance
+ * @return Descriptor, or -1 if client is NULL
+ */
+int paumiot_client_get_fd(const paumiot_client_t *client);
+
+/**
+ * @brief Time until the client needs paumiot_client_loop() without I/O
+ * @details For event loops that prefer their own timers over the
+ *          descriptor becoming readable when a keep-alive is due.
+ * @param client Client instance
+ * @return Milliseconds (0 = now), or -1 if no timer is pending
+ */
+int paumiot_client_next_timeout(const paumiot_client_t *client);
+
+/* ============================================================================
+ * SHARED EVENT LOOP API
+ * ========================================================================= */
+
+/**
+ * @brief Create an event loop that serves many clients from one thread
+ * @details Waits on the descriptors of all attached clients at once, so a
+ *          process hosting thousands of clients needs one thread, not one
+ *          per client. Callbacks of every attached client run on the
+ *          thread driving the event loop.
+ * @return Event loop, or NULL on error
+ */
+paumiot_event_loop_t *paumiot_event_loop_create(void);
+
+/**
+ * @brief Stop the event loop, detach every client and free it
+ * @param loop Event loop
+ */
+void paumiot_event_loop_destroy(paumiot_event_loop_t *loop);
+
+/**
+ * @brief Attach a client; it must not be attached to another loop
+ * @param loop Event loop
+ * @param client Client instance
+ * @return PAUMIOT_CLIENT_SUCCESS on success, error code otherwise
+ */
+paumiot_client_result_t paumiot_event_loop_add(
+    paumiot_event_loop_t *loop,
+    paumiot_client_t *client
+);
+
+/**
+ * @brief Detach a client (also done by paumiot_client_destroy())
+ * @param loop Event loop
+ * @param client Client instance
+ * @return PAUMIOT_CLIENT_SUCCESS on success, error code otherwise
+ */
+paumiot_client_result_t paumiot_event_loop_remove(
+    paumiot_event_loop_t *loop,
+    paumiot_client_t *client
+);
+
+/**
+ * @brief Service every attached client that has work, waiting up to timeout_ms
+ * @param loop Event loop
+ * @param timeout_ms Timeout in milliseconds (0 = non-blocking)
+ * @return PAUMIOT_CLIENT_SUCCESS on success,
+ *         PAUMIOT_CLIENT_ERROR_INVALID_PARAM if the loop thread runs or
+ *         another thread is inside this call
+ */
+paumiot_client_result_t paumiot_event_loop_run(
+    paumiot_event_loop_t *loop,
+    uint32_t timeout_ms
+);
+
+/**
+ * @brief Run the event loop on a dedicated I/O thread
+ * @param loop Event loop
+ * @return PAUMIOT_CLIENT_SUCCESS on success, error code otherwise
+ */
+paumiot_client_result_t paumiot_event_loop_start(paumiot_event_loop_t *loop);
+
+/**
+ * @brief Stop the I/O thread; must not be called from a client callback
+ * @param loop Event loop
+ * @return PAUMIOT_CLIENT_SUCCESS on success, error code otherwise
+ */
+paumiot_client_result_t paumiot_event_loop_stop(paumiot_event_loop_t *loop);
+
 /* ============================================================================
  * UTILITY API
  * ========================================================================= */
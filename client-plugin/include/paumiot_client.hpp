@@ -0,0 +1,598 @@
+/**
+ * @file paumiot_client.hpp
+ * @brief Header-only C++ wrapper for the PaumIoT Client Plugin API
+ * @details Owns the C client with RAII handles and hands out received
+ *          messages as move-only objects read through std::string_view
+ *          (and std::span with C++20) without copying. With C++20
+ *          coroutines, publishes and receives can be co_awaited; they
+ *          complete on the thread driving paumiot_client_loop(), so a
+ *          coroutine awaiting them runs on that thread as well.
+ *
+ *          Requires C++17. Apart from publish(), which like the C call is
+ *          safe from any thread, use the objects here from the thread
+ *          that drives the loop.
+ */
+
+#ifndef PAUMIOT_CLIENT_HPP
+#define PAUMIOT_CLIENT_HPP
+
+#include "paumiot_client.h"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 202002L
+#include <span>
+#define PAUMIOT_CLIENT_HPP_SPAN 1
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define PAUMIOT_CLIENT_HPP_COROUTINES 1
+#endif
+
+namespace paumiot {
+
+using result = paumiot_client_result_t;
+
+/**
+ * @brief Thrown when a client or subscription cannot be created
+ */
+class client_error : public std::runtime_error {
+public:
+    explicit client_error(result code)
+        : std::runtime_error(paumiot_client_error_string(code)), code_(code) {}
+
+    result code() const noexcept { return code_; }
+
+private:
+    result code_;
+};
+
+/* ============================================================================
+ * MESSAGES
+ * ========================================================================= */
+
+/**
+ * @brief A received message, either lent by the client or owned
+ * @details A lent message points at the client's message (into the receive
+ *          buffer with zero_copy_receive) and is valid only until control
+ *          returns to the client: for a coroutine, until its next
+ *          suspension. retain() turns it into an owned copy.
+ */
+class message {
+public:
+    message() noexcept = default;
+
+    /**
+     * @brief Borrow a message passed to a paumiot_message_callback_t
+     */
+    static message lend(const paumiot_message_t *msg) noexcept {
+        message out;
+        out.msg_ = msg;
+        return out;
+    }
+
+    message(message &&other) noexcept
+        : msg_(std::exchange(other.msg_, nullptr)), owned_(std::exchange(other.owned_, false)) {}
+
+    message &operator=(message &&other) noexcept {
+        if (this != &other) {
+            reset();
+            msg_ = std::exchange(other.msg_, nullptr);
+            owned_ = std::exchange(other.owned_, false);
+        }
+        return *this;
+    }
+
+    message(const message &) = delete;
+    message &operator=(const message &) = delete;
+
+    ~message() { reset(); }
+
+    /**
+     * @brief Copy a lent message so it outlives the client's buffer
+     * @details Does nothing for an owned or empty message.
+     * @throws std::bad_alloc if the copy cannot be allocated
+     */
+    void retain() {
+        if (msg_ && !owned_) {
+            paumiot_message_t *copy = paumiot_message_retain(msg_);
+            if (!copy) {
+                throw std::bad_alloc();
+            }
+            msg_ = copy;
+            owned_ = true;
+        }
+    }
+
+    explicit operator bool() const noexcept { return msg_ != nullptr; }
+    bool lent() const noexcept { return msg_ && !owned_; }
+
+    std::string_view topic() const noexcept { return msg_->topic; }
+
+    std::string_view payload() const noexcept {
+        return std::string_view(reinterpret_cast<const char *>(msg_->payload), msg_->payload_len);
+    }
+
+#ifdef PAUMIOT_CLIENT_HPP_SPAN
+    std::span<const uint8_t> bytes() const noexcept { return { msg_->payload, msg_->payload_len }; }
+#endif
+
+    paumiot_qos_t qos() const noexcept { return msg_->qos; }
+    bool retain_flag() const noexcept { return msg_->retain; }
+    const paumiot_message_t *get() const noexcept { return msg_; }
+
+private:
+    void reset() noexcept {
+        if (owned_) {
+            paumiot_message_release(const_cast<paumiot_message_t *>(msg_));
+        }
+        msg_ = nullptr;
+        owned_ = false;
+    }
+
+    const paumiot_message_t *msg_ = nullptr;
+    bool owned_ = false;
+};
+
+/* ============================================================================
+ * PUBLISH OPERATIONS
+ * ========================================================================= */
+
+namespace detail {
+
+/**
+ * @brief Completion shared by a publish_operation and the C callback
+ */
+struct publish_state {
+    enum : int { PENDING, WAITING, DONE };
+
+    std::atomic<int> phase{ PENDING };
+    std::atomic<int> refs{ 2 };
+    result outcome = PAUMIOT_CLIENT_SUCCESS;
+#ifdef PAUMIOT_CLIENT_HPP_COROUTINES
+    std::coroutine_handle<> waiter;
+#endif
+
+    void release() noexcept {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    static void done(paumiot_client_t *, const char *, bool success, void *user_data) noexcept {
+        publish_state *state = static_cast<publish_state *>(user_data);
+        state->outcome = success ? PAUMIOT_CLIENT_SUCCESS : PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+        int previous = state->phase.exchange(DONE, std::memory_order_acq_rel);
+#ifdef PAUMIOT_CLIENT_HPP_COROUTINES
+        if (previous == WAITING) {
+            state->waiter.resume();
+        }
+#else
+        (void)previous;
+#endif
+        state->release();
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief A publish in flight, started by client::publish()
+ * @details The message is queued when the operation is created, so holding
+ *          several operations and awaiting them afterwards keeps a whole
+ *          window on the wire. Awaiting yields PAUMIOT_CLIENT_SUCCESS once
+ *          the broker acknowledged (QoS 0: once written), the error that
+ *          stopped it from being queued (e.g.
+ *          PAUMIOT_CLIENT_ERROR_WOULD_BLOCK), or
+ *          PAUMIOT_CLIENT_ERROR_NOT_CONNECTED if the connection dropped
+ *          first. Dropping the operation does not cancel the publish.
+ */
+class publish_operation {
+public:
+    publish_operation(publish_operation &&other) noexcept
+        : state_(std::exchange(other.state_, nullptr)), error_(other.error_) {}
+
+    publish_operation &operator=(publish_operation &&other) noexcept {
+        if (this != &other) {
+            if (state_) {
+                state_->release();
+            }
+            state_ = std::exchange(other.state_, nullptr);
+            error_ = other.error_;
+        }
+        return *this;
+    }
+
+    publish_operation(const publish_operation &) = delete;
+    publish_operation &operator=(const publish_operation &) = delete;
+
+    ~publish_operation() {
+        if (state_) {
+            state_->release();
+        }
+    }
+
+    /**
+     * @brief Whether the outcome is known
+     */
+    bool ready() const noexcept {
+        return !state_ || state_->phase.load(std::memory_order_acquire) == detail::publish_state::DONE;
+    }
+
+    /**
+     * @brief Outcome; meaningful once ready()
+     */
+    result get() const noexcept { return state_ ? state_->outcome : error_; }
+
+#ifdef PAUMIOT_CLIENT_HPP_COROUTINES
+    bool await_ready() const noexcept { return ready(); }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept {
+        state_->waiter = handle;
+        int expected = detail::publish_state::PENDING;
+        return state_->phase.compare_exchange_strong(expected, detail::publish_state::WAITING,
+                                                     std::memory_order_acq_rel);
+    }
+
+    result await_resume() const noexcept { return get(); }
+#endif
+
+private:
+    friend class client;
+
+    explicit publish_operation(result error) noexcept : error_(error) {}
+    explicit publish_operation(detail::publish_state *state) noexcept : state_(state) {}
+
+    detail::publish_state *state_ = nullptr;
+    result error_ = PAUMIOT_CLIENT_SUCCESS;
+};
+
+/* ============================================================================
+ * SUBSCRIPTIONS
+ * ========================================================================= */
+
+namespace detail {
+
+struct client_state;
+
+struct subscription_state {
+    client_state *owner = nullptr;      /* nullptr once detached from the client */
+    bool closed = false;                /* Handle gone, UNSUBSCRIBE still owed */
+    std::string filter;
+    std::deque<message> queue;
+#ifdef PAUMIOT_CLIENT_HPP_COROUTINES
+    std::coroutine_handle<> waiter;
+    message *slot = nullptr;
+#endif
+
+    static void deliver(paumiot_client_t *, const paumiot_message_t *msg,
+                        void *user_data) noexcept {
+        subscription_state *state = static_cast<subscription_state *>(user_data);
+        if (state->closed) {
+            return;
+        }
+#ifdef PAUMIOT_CLIENT_HPP_COROUTINES
+        if (state->waiter) {
+            /* Hand the message over in place; the waiter runs until it suspends */
+            *state->slot = message::lend(msg);
+            std::exchange(state->waiter, nullptr).resume();
+            return;
+        }
+#endif
+        try {
+            message copy = message::lend(msg);
+            copy.retain();
+            state->queue.push_back(std::move(copy));
+        } catch (const std::bad_alloc &) {
+            /* Dropped, as the C client drops a message it cannot copy */
+        }
+    }
+
+    /**
+     * @brief Wake a coroutine still waiting with an empty message
+     */
+    void wake_empty() noexcept {
+#ifdef PAUMIOT_CLIENT_HPP_COROUTINES
+        if (waiter) {
+            *slot = message();
+            std::exchange(waiter, nullptr).resume();
+        }
+#endif
+    }
+};
+
+struct client_state {
+    paumiot_client_config_t config{};
+    std::string strings[8];
+    paumiot_client_t *handle = nullptr;
+    std::vector<std::shared_ptr<subscription_state>> subscriptions;
+
+    /**
+     * @brief Keep private copies of the strings the C client refers to
+     */
+    void copy_strings() {
+        const char **fields[] = { &config.host,          &config.client_id,
+                                  &config.username,      &config.password,
+                                  &config.ca_cert_path,  &config.client_cert_path,
+                                  &config.client_key_path, &config.spool_path };
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+            if (*fields[i]) {
+                strings[i] = *fields[i];
+                *fields[i] = strings[i].c_str();
+            }
+        }
+    }
+
+    void forget(const subscription_state *sub) noexcept {
+        for (size_t i = 0; i < subscriptions.size(); i++) {
+            if (subscriptions[i].get() == sub) {
+                subscriptions[i] = std::move(subscriptions.back());
+                subscriptions.pop_back();
+                return;
+            }
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief An active subscription; unsubscribes when destroyed
+ * @details Messages arriving while a coroutine awaits next() are lent to
+ *          it; others are retained and queued until taken. May outlive
+ *          its client, after which it yields only what is queued.
+ */
+class subscription {
+public:
+    /** A moved-from subscription may only be destroyed or assigned to. */
+    subscription(subscription &&) noexcept = default;
+
+    subscription &operator=(subscription &&other) noexcept {
+        if (this != &other) {
+            close();
+            state_ = std::move(other.state_);
+        }
+        return *this;
+    }
+
+    subscription(const subscription &) = delete;
+    subscription &operator=(const subscription &) = delete;
+
+    ~subscription() { close(); }
+
+    const std::string &filter() const noexcept {
+        assert(state_);
+        return state_->filter;
+    }
+
+    /**
+     * @brief Number of retained messages waiting to be taken
+     */
+    size_t queued() const noexcept { return state_->queue.size(); }
+
+    /**
+     * @brief Take the oldest queued message, if any
+     */
+    std::optional<message> try_receive() {
+        if (state_->queue.empty()) {
+            return std::nullopt;
+        }
+        std::optional<message> out(std::move(state_->queue.front()));
+        state_->queue.pop_front();
+        return out;
+    }
+
+#ifdef PAUMIOT_CLIENT_HPP_COROUTINES
+    class receive_awaiter {
+    public:
+        explicit receive_awaiter(detail::subscription_state *state) noexcept : state_(state) {}
+
+        bool await_ready() noexcept {
+            if (!state_->queue.empty()) {
+                msg_ = std::move(state_->queue.front());
+                state_->queue.pop_front();
+                return true;
+            }
+            return !state_->owner;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            if (state_->waiter) {
+                throw std::logic_error("paumiot::subscription already has a waiter");
+            }
+            state_->waiter = handle;
+            state_->slot = &msg_;
+        }
+
+        message await_resume() noexcept { return std::move(msg_); }
+
+    private:
+        detail::subscription_state *state_;
+        message msg_;
+    };
+
+    /**
+     * @brief Await the next message
+     * @details Yields an empty message once the client is gone. One
+     *          coroutine at a time may wait on a subscription.
+     */
+    receive_awaiter next() noexcept { return receive_awaiter(state_.get()); }
+#endif
+
+private:
+    friend class client;
+
+    explicit subscription(std::shared_ptr<detail::subscription_state> state) noexcept
+        : state_(std::move(state)) {}
+
+    void close() noexcept {
+        if (!state_ || !state_->owner) {
+            return;
+        }
+        detail::client_state *owner = state_->owner;
+        /* If the UNSUBSCRIBE cannot be sent now the C client keeps the
+         * callback, so the client keeps the state until it is destroyed */
+        if (paumiot_client_unsubscribe(owner->handle, state_->filter.c_str()) ==
+            PAUMIOT_CLIENT_SUCCESS) {
+            state_->owner = nullptr;
+            owner->forget(state_.get());
+        } else {
+            state_->closed = true;
+        }
+        state_.reset();
+    }
+
+    std::shared_ptr<detail::subscription_state> state_;
+};
+
+/* ============================================================================
+ * CLIENT
+ * ========================================================================= */
+
+/**
+ * @brief Owning handle for a paumiot_client_t
+ * @details Copies the configuration and its strings, so the caller's may
+ *          go away. Destroying the client disconnects it: outstanding
+ *          publishes complete with PAUMIOT_CLIENT_ERROR_NOT_CONNECTED and
+ *          coroutines waiting on a subscription receive an empty message.
+ */
+class client {
+public:
+    /**
+     * @throws client_error if paumiot_client_create() rejects the configuration
+     */
+    explicit client(const paumiot_client_config_t &config)
+        : state_(std::make_unique<detail::client_state>()) {
+        state_->config = config;
+        state_->copy_strings();
+        state_->handle = paumiot_client_create(&state_->config);
+        if (!state_->handle) {
+            throw client_error(PAUMIOT_CLIENT_ERROR_INVALID_PARAM);
+        }
+    }
+
+    /** A moved-from client may only be destroyed or assigned to. */
+    client(client &&) noexcept = default;
+
+    client &operator=(client &&other) noexcept {
+        if (this != &other) {
+            destroy();
+            state_ = std::move(other.state_);
+        }
+        return *this;
+    }
+
+    client(const client &) = delete;
+    client &operator=(const client &) = delete;
+
+    ~client() { destroy(); }
+
+    paumiot_client_t *get() const noexcept {
+        assert(state_);
+        return state_->handle;
+    }
+
+    result connect() noexcept {
+        assert(state_);
+        return paumiot_client_connect(state_->handle);
+    }
+    result disconnect() noexcept { return paumiot_client_disconnect(state_->handle); }
+    bool connected() const noexcept { return paumiot_client_is_connected(state_->handle); }
+
+    paumiot_connection_state_t state() const noexcept {
+        return paumiot_client_get_state(state_->handle);
+    }
+
+    result loop(uint32_t timeout_ms) noexcept {
+        return paumiot_client_loop(state_->handle, timeout_ms);
+    }
+
+    result loop_start() noexcept { return paumiot_client_loop_start(state_->handle); }
+    result loop_stop() noexcept { return paumiot_client_loop_stop(state_->handle); }
+    int fd() const noexcept { return paumiot_client_get_fd(state_->handle); }
+    int next_timeout() const noexcept { return paumiot_client_next_timeout(state_->handle); }
+
+    /**
+     * @brief Queue a publish, as paumiot_client_publish_async()
+     * @param topic NUL-terminated topic
+     * @param payload Payload, copied into the send buffer before returning
+     */
+    publish_operation publish(const char *topic, std::string_view payload,
+                              paumiot_qos_t qos = PAUMIOT_QOS_0, bool retain = false) {
+        return publish_bytes(topic, reinterpret_cast<const uint8_t *>(payload.data()),
+                             payload.size(), qos, retain);
+    }
+
+#ifdef PAUMIOT_CLIENT_HPP_SPAN
+    publish_operation publish(const char *topic, std::span<const uint8_t> payload,
+                              paumiot_qos_t qos = PAUMIOT_QOS_0, bool retain = false) {
+        return publish_bytes(topic, payload.data(), payload.size(), qos, retain);
+    }
+#endif
+
+    /**
+     * @brief Subscribe to a topic filter
+     * @throws client_error with the paumiot_client_subscribe() result
+     */
+    subscription subscribe(std::string filter, paumiot_qos_t qos = PAUMIOT_QOS_0) {
+        assert(state_);
+        auto sub = std::make_shared<detail::subscription_state>();
+        sub->filter = std::move(filter);
+        state_->subscriptions.reserve(state_->subscriptions.size() + 1);
+        result code = paumiot_client_subscribe(state_->handle, sub->filter.c_str(), qos,
+                                               detail::subscription_state::deliver, sub.get());
+        if (code != PAUMIOT_CLIENT_SUCCESS) {
+            throw client_error(code);
+        }
+        sub->owner = state_.get();
+        state_->subscriptions.push_back(sub);
+        return subscription(std::move(sub));
+    }
+
+private:
+    publish_operation publish_bytes(const char *topic, const uint8_t *payload, size_t len,
+                                    paumiot_qos_t qos, bool retain) {
+        auto *op = new detail::publish_state();
+        result code = paumiot_client_publish_async(state_->handle, topic, payload, len, qos,
+                                                   retain, detail::publish_state::done, op);
+        if (code != PAUMIOT_CLIENT_SUCCESS) {
+            delete op;
+            return publish_operation(code);
+        }
+        return publish_operation(op);
+    }
+
+    void destroy() noexcept {
+        if (!state_) {
+            return;
+        }
+        /* No callbacks run after this, so the subscriptions can be let go */
+        paumiot_client_destroy(state_->handle);
+        std::vector<std::shared_ptr<detail::subscription_state>> subs;
+        subs.swap(state_->subscriptions);
+        for (auto &sub : subs) {
+            sub->owner = nullptr;
+        }
+        for (auto &sub : subs) {
+            sub->wake_empty();
+        }
+        state_.reset();
+    }
+
+    std::unique_ptr<detail::client_state> state_;
+};
+
+} // namespace paumiot
+
+#endif /* PAUMIOT_CLIENT_HPP */
@@ -0,0 +1,66 @@
+/**
+ * @file buffer.c
+ * @brief Client-side send and receive buffering
+ */
+
+#include "client_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+paumiot_client_result_t client_buffer_init(client_buffer_t *buf, size_t size) {
+    buf->data = (uint8_t *)malloc(size);
+    if (!buf->data) {
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    buf->size = size;
+    buf->start = 0;
+    buf->end = 0;
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+void client_buffer_free(client_buffer_t *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->size = 0;
+}
+
+uint8_t *client_buffer_reserve(client_buffer_t *buf, size_t len) {
+    if (buf->size - buf->end >= len) {
+        return buf->data + buf->end;
+    }
+    if (client_buffer_space(buf) < len) {
+        return NULL;
+    }
+
+    /* Slide the unconsumed bytes to the front */
+    size_t used = buf->end - buf->start;
+    memmove(buf->data, buf->data + buf->start, used);
+    buf->start = 0;
+    buf->end = used;
+    return buf->data + buf->end;
+}
+
+void client_buffer_commit(client_buffer_t *buf, size_t len) {
+    buf->end += len;
+}
+
+void client_buffer_consume(client_buffer_t *buf, size_t len) {
+    buf->start += len;
+    if (buf->start == buf->end) {
+        buf->start = 0;
+        buf->end = 0;
+    }
+}
+
+size_t client_buffer_used(const client_buffer_t *buf) {
+    return buf->end - buf->start;
+}
+
+size_t client_buffer_space(const client_buffer_t *buf) {
+    return buf->size - (buf->end - buf->start);
+}
+
+void client_buffer_reset(client_buffer_t *buf) {
+    buf->start = 0;
+    buf->end = 0;
+}
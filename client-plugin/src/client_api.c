@@ -0,0 +1,1846 @@
+/**
+ * @file client_api.c
+ * @brief Client lifecycle, Subscribe/Publish/Unsubscribe APIs and event loop
+ * @details Publishing never waits for the broker. A QoS 1/2 publish takes a
+ *          slot of the inflight window (max_inflight_messages), is encoded
+ *          into the send buffer and written as far as the socket allows;
+ *          the acknowledgement is matched by packet ID when the loop reads
+ *          it, which frees the slot and fires the publish callback. Up to a
+ *          window of publishes is therefore on the wire at once, instead of
+ *          one per round trip.
+ */
+
+#include "client_internal.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CONTROL_RESERVE 64              /* Send buffer bytes kept for acks and pings */
+#define MAX_READS_PER_PASS 16
+#define COMPLETION_BATCH 64
+#define WAIT_SLICE_MS 100
+#define SUBACK_FAILURE 0x80
+#define SPOOL_DRAIN_BATCH 256           /* Spooled publishes per send() */
+
+static atomic_uint g_client_count;
+
+/* ============================================================================
+ * HELPERS
+ * ========================================================================= */
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void format_message_id(char *buf, uint64_t seq) {
+    snprintf(buf, CLIENT_MESSAGE_ID_LEN, "%" PRIu64, seq);
+}
+
+static struct timespec deadline_timespec(uint64_t deadline_ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline_ns / 1000000000ull);
+    ts.tv_nsec = (long)(deadline_ns % 1000000000ull);
+    return ts;
+}
+
+static void notify_state(paumiot_client_t *client, paumiot_connection_state_t state) {
+    if (client->config->connection_callback) {
+        client->config->connection_callback(client, state,
+                                            client->config->connection_callback_data);
+    }
+}
+
+/**
+ * @brief Wake the thread waiting on epoll_fd
+ * @details Coalesced: one eventfd write until the loop drains it.
+ */
+static void wake_loop(paumiot_client_t *client) {
+    if (!atomic_exchange(&client->wake_pending, true)) {
+        uint64_t one = 1;
+        ssize_t n = write(client->wakeup_fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+/**
+ * @brief Queue a 2-4 byte control packet (lock held)
+ * @details Publishes leave CONTROL_RESERVE bytes free, so this only fails
+ *          when the socket has stopped draining altogether.
+ */
+static void send_control_locked(paumiot_client_t *client, const uint8_t *packet, size_t len) {
+    if (client->fd < 0) {
+        return;
+    }
+    uint8_t *dst = client_buffer_reserve(&client->out, len);
+    if (!dst) {
+        client->broken = true;
+        return;
+    }
+    memcpy(dst, packet, len);
+    client_buffer_commit(&client->out, len);
+    if (!client_conn_flush(client)) {
+        client->broken = true;
+    }
+}
+
+/* ============================================================================
+ * INFLIGHT WINDOW
+ * ========================================================================= */
+
+/**
+ * @brief Take a free slot and assign it the next packet ID (lock held)
+ * @return Slot, or NULL if the window is full
+ */
+static client_inflight_t *inflight_acquire(paumiot_client_t *client) {
+    if (client->inflight_count == client->window) {
+        return NULL;
+    }
+
+    /* Some slot is free, so at most one lap of IDs is skipped */
+    for (;;) {
+        uint16_t id = client->next_packet_id;
+        client->next_packet_id = id == CLIENT_MAX_PACKET_ID ? 1 : (uint16_t)(id + 1);
+
+        client_inflight_t *slot = &client->inflight[(id - 1) % client->window];
+        if (slot->state == INFLIGHT_FREE) {
+            memset(slot, 0, sizeof(*slot));
+            slot->packet_id = id;
+            client->inflight_count++;
+            return slot;
+        }
+    }
+}
+
+/**
+ * @brief Slot waiting for an acknowledgement of packet_id in state (lock held)
+ */
+static client_inflight_t *inflight_find(paumiot_client_t *client, uint16_t packet_id,
+                                        client_inflight_state_t state) {
+    if (packet_id == 0) {
+        return NULL;
+    }
+    client_inflight_t *slot = &client->inflight[(packet_id - 1) % client->window];
+    return slot->packet_id == packet_id && slot->state == state ? slot : NULL;
+}
+
+static void inflight_release(paumiot_client_t *client, client_inflight_t *slot) {
+    slot->state = INFLIGHT_FREE;
+    slot->callback = NULL;
+    client->inflight_count--;
+    pthread_cond_broadcast(&client->changed);
+}
+
+/**
+ * @brief Finish the publish in the slot matching packet_id and state
+ */
+static void complete_publish(paumiot_client_t *client, uint16_t packet_id,
+                             client_inflight_state_t state) {
+    pthread_mutex_lock(&client->lock);
+    client_inflight_t *slot = inflight_find(client, packet_id, state);
+    if (!slot) {
+        pthread_mutex_unlock(&client->lock);
+        client_debug("unexpected acknowledgement for packet %u", packet_id);
+        return;
+    }
+    paumiot_publish_callback_t callback = slot->callback;
+    void *user_data = slot->user_data;
+    uint64_t seq = slot->seq;
+    if (slot->spool_ticket) {
+        client_spool_ack(&client->spool, slot->spool_ticket);
+    }
+    inflight_release(client, slot);
+    pthread_mutex_unlock(&client->lock);
+
+    if (callback) {
+        char message_id[CLIENT_MESSAGE_ID_LEN];
+        format_message_id(message_id, seq);
+        callback(client, message_id, true, user_data);
+    }
+}
+
+/* ============================================================================
+ * UTILITY API
+ * ========================================================================= */
+
+void paumiot_client_config_init(paumiot_client_config_t *config) {
+    if (!config) {
+        return;
+    }
+    memset(config, 0, sizeof(*config));
+    config->host = "localhost";
+    config->port = CLIENT_DEFAULT_MQTT_PORT;
+    config->protocol = PAUMIOT_PROTOCOL_AUTO;
+    config->connect_timeout_ms = CLIENT_DEFAULT_CONNECT_TIMEOUT_MS;
+    config->keepalive_interval_ms = CLIENT_DEFAULT_KEEPALIVE_MS;
+    config->send_buffer_size = CLIENT_DEFAULT_BUFFER_SIZE;
+    config->recv_buffer_size = CLIENT_DEFAULT_BUFFER_SIZE;
+    config->max_inflight_messages = CLIENT_DEFAULT_MAX_INFLIGHT;
+    config->reconnect_delay_ms = CLIENT_DEFAULT_RECONNECT_DELAY_MS;
+    config->reconnect_max_delay_ms = CLIENT_DEFAULT_RECONNECT_MAX_DELAY_MS;
+    config->spool_size = CLIENT_DEFAULT_SPOOL_SIZE;
+    config->spool_drain_ratio = CLIENT_DEFAULT_SPOOL_DRAIN_RATIO;
+    config->coap_nstart = CLIENT_DEFAULT_COAP_NSTART;
+    config->coap_ack_timeout_ms = CLIENT_DEFAULT_COAP_ACK_TIMEOUT_MS;
+}
+
+const char *paumiot_client_error_string(paumiot_client_result_t result) {
+    switch (result) {
+    case PAUMIOT_CLIENT_SUCCESS:
+        return "Success";
+    case PAUMIOT_CLIENT_ERROR_INVALID_PARAM:
+        return "Invalid parameter";
+    case PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY:
+        return "Out of memory";
+    case PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED:
+        return "Connection failed";
+    case PAUMIOT_CLIENT_ERROR_TIMEOUT:
+        return "Timeout";
+    case PAUMIOT_CLIENT_ERROR_NOT_CONNECTED:
+        return "Not connected";
+    case PAUMIOT_CLIENT_ERROR_PROTOCOL:
+        return "Protocol error";
+    case PAUMIOT_CLIENT_ERROR_BUFFER_OVERFLOW:
+        return "Buffer overflow";
+    case PAUMIOT_CLIENT_ERROR_AUTHENTICATION_FAILED:
+        return "Authentication failed";
+    case PAUMIOT_CLIENT_ERROR_AUTHORIZATION_FAILED:
+        return "Authorization failed";
+    case PAUMIOT_CLIENT_ERROR_ALREADY_SUBSCRIBED:
+        return "Already subscribed";
+    case PAUMIOT_CLIENT_ERROR_NOT_SUBSCRIBED:
+        return "Not subscribed";
+    case PAUMIOT_CLIENT_ERROR_WOULD_BLOCK:
+        return "Inflight window or send buffer full";
+    }
+    return "Unknown error";
+}
+
+void paumiot_client_get_version(int *major, int *minor, int *patch) {
+    if (major) {
+        *major = PAUMIOT_CLIENT_VERSION_MAJOR;
+    }
+    if (minor) {
+        *minor = PAUMIOT_CLIENT_VERSION_MINOR;
+    }
+    if (patch) {
+        *patch = PAUMIOT_CLIENT_VERSION_PATCH;
+    }
+}
+
+/* ============================================================================
+ * CLIENT LIFECYCLE API
+ * ========================================================================= */
+
+/**
+ * @brief Create epoll_fd with the wakeup and keep-alive descriptors in it
+ */
+static bool open_event_sources(paumiot_client_t *client) {
+    client->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    client->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    client->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (client->epoll_fd < 0 || client->wakeup_fd < 0 || client->timer_fd < 0) {
+        return false;
+    }
+
+    struct epoll_event wakeup = { .events = EPOLLIN, .data.u32 = CLIENT_EVENT_WAKEUP };
+    struct epoll_event timer = { .events = EPOLLIN, .data.u32 = CLIENT_EVENT_TIMER };
+    return epoll_ctl(client->epoll_fd, EPOLL_CTL_ADD, client->wakeup_fd, &wakeup) == 0 &&
+           epoll_ctl(client->epoll_fd, EPOLL_CTL_ADD, client->timer_fd, &timer) == 0;
+}
+
+paumiot_client_t *paumiot_client_create(const paumiot_client_config_t *config) {
+    if (!config || !config->host || config->max_inflight_messages == 0 ||
+        config->max_inflight_messages > CLIENT_MAX_PACKET_ID ||
+        config->send_buffer_size < 2 * CONTROL_RESERVE ||
+        config->recv_buffer_size < 2 * CONTROL_RESERVE ||
+        (config->spool_path && config->spool_drain_ratio == 0)) {
+        return NULL;
+    }
+    if (config->protocol == PAUMIOT_PROTOCOL_COAP &&
+        (config->coap_nstart == 0 || config->coap_ack_timeout_ms == 0 || config->spool_path ||
+         config->recv_buffer_size < CLIENT_COAP_RECV_CHUNK)) {
+        return NULL;
+    }
+    if (config->protocol == PAUMIOT_PROTOCOL_HTTP) {
+        client_debug("HTTP is not implemented");
+        return NULL;
+    }
+    if (config->use_tls) {
+        client_debug("TLS is not available in this build");
+        return NULL;
+    }
+
+    paumiot_client_t *client = (paumiot_client_t *)calloc(1, sizeof(*client));
+    if (!client) {
+        return NULL;
+    }
+    client->config = config;
+    client->fd = -1;
+    client->handshake_fd = -1;
+    client->epoll_fd = -1;
+    client->wakeup_fd = -1;
+    client->timer_fd = -1;
+    client->spool.fd = -1;
+    client->state = PAUMIOT_STATE_DISCONNECTED;
+    client->window = config->max_inflight_messages;
+    client->next_packet_id = 1;
+    client->next_seq = 1;
+    atomic_init(&client->in_loop, false);
+    atomic_init(&client->wake_pending, false);
+
+    /* Devices started together must not draw the same backoff delays */
+    client->random_state = client_now_ns() ^ ((uint64_t)(uintptr_t)client << 16) ^
+                           ((uint64_t)getpid() << 40);
+    if (client->random_state == 0) {
+        client->random_state = 1;
+    }
+
+    if (config->client_id) {
+        snprintf(client->client_id, sizeof(client->client_id), "%s", config->client_id);
+    } else {
+        snprintf(client->client_id, sizeof(client->client_id), "paumiot-%ld-%u",
+                 (long)getpid(), atomic_fetch_add(&g_client_count, 1));
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&client->changed, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&client->lock, NULL);
+
+    client->inflight = (client_inflight_t *)calloc(client->window, sizeof(client_inflight_t));
+    if (!client->inflight ||
+        client_buffer_init(&client->out, config->send_buffer_size) != PAUMIOT_CLIENT_SUCCESS ||
+        client_buffer_init(&client->in, config->recv_buffer_size) != PAUMIOT_CLIENT_SUCCESS ||
+        !open_event_sources(client) ||
+        (config->protocol == PAUMIOT_PROTOCOL_COAP &&
+         client_coap_create(client) != PAUMIOT_CLIENT_SUCCESS) ||
+        (config->spool_path && client_spool_open(&client->spool, config->spool_path,
+                                                 config->spool_size) != PAUMIOT_CLIENT_SUCCESS)) {
+        paumiot_client_destroy(client);
+        return NULL;
+    }
+    return client;
+}
+
+void paumiot_client_destroy(paumiot_client_t *client) {
+    if (!client) {
+        return;
+    }
+    paumiot_client_loop_stop(client);
+    pthread_mutex_lock(&client->lock);
+    paumiot_event_loop_t *loop = client->event_loop;
+    pthread_mutex_unlock(&client->lock);
+    if (loop) {
+        paumiot_event_loop_remove(loop, client);
+    }
+    if (client->fd >= 0 || client->handshake_fd >= 0) {
+        paumiot_client_disconnect(client);
+    }
+
+    for (size_t i = 0; i < client->sub_count; i++) {
+        free(client->subs[i].filter);
+    }
+    free(client->subs);
+    free(client->completions);
+    free(client->inflight);
+    client_buffer_free(&client->out);
+    client_buffer_free(&client->in);
+    client_spool_close(&client->spool);
+    client_coap_destroy(client->coap);
+    int fds[] = { client->epoll_fd, client->wakeup_fd, client->timer_fd };
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    pthread_cond_destroy(&client->changed);
+    pthread_mutex_destroy(&client->lock);
+    free(client);
+}
+
+/**
+ * @brief Send SUBSCRIBE or UNSUBSCRIBE for a filter (lock held)
+ */
+static paumiot_client_result_t send_subscription_locked(paumiot_client_t *client, uint8_t type,
+                                                        const char *filter, paumiot_qos_t qos) {
+    size_t need = 7 + strlen(filter) + 1;
+    if (need + CONTROL_RESERVE > client->out.size) {
+        return PAUMIOT_CLIENT_ERROR_BUFFER_OVERFLOW;
+    }
+    if (client_buffer_space(&client->out) < need + CONTROL_RESERVE) {
+        return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK;
+    }
+    client_inflight_t *slot = inflight_acquire(client);
+    if (!slot) {
+        return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK;
+    }
+
+    uint8_t *dst = client_buffer_reserve(&client->out, need);
+    size_t len = client_mqtt_encode_subscribe(dst, need, type, slot->packet_id, filter, qos);
+    if (len == 0) {
+        inflight_release(client, slot);
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    client_buffer_commit(&client->out, len);
+    slot->state = type == CLIENT_MQTT_SUBSCRIBE ? INFLIGHT_SUBACK : INFLIGHT_UNSUBACK;
+
+    if (!client_conn_flush(client)) {
+        client->broken = true;
+    }
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+/**
+ * @brief Start the session on the freshly attached socket (lock held)
+ */
+static void connected_locked(paumiot_client_t *client) {
+    client->state = PAUMIOT_STATE_CONNECTED;
+    client->broken = false;
+    client->last_tx_ns = client_now_ns();
+    client->ping_sent_ns = 0;
+    client->reconnect_at_ns = 0;
+    client->reconnect_attempts = 0;
+    client->reconnect_delay_ms = 0;
+    client_buffer_reset(&client->out);
+    if (client->coap) {
+        client_coap_reset_locked(client);
+    }
+
+    /* Clean session: the broker forgot our subscriptions */
+    for (size_t i = 0; i < client->sub_count; i++) {
+        send_subscription_locked(client, CLIENT_MQTT_SUBSCRIBE, client->subs[i].filter,
+                                 client->subs[i].qos);
+    }
+    wake_loop(client);                  /* Arm the keep-alive timer, drain the spool */
+}
+
+paumiot_client_result_t paumiot_client_connect(paumiot_client_t *client) {
+    if (!client) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&client->lock);
+    if (client->state != PAUMIOT_STATE_DISCONNECTED) {
+        paumiot_connection_state_t state = client->state;
+        pthread_mutex_unlock(&client->lock);
+        return state == PAUMIOT_STATE_CONNECTED ? PAUMIOT_CLIENT_SUCCESS
+                                                : PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    client->state = PAUMIOT_STATE_CONNECTING;
+    pthread_mutex_unlock(&client->lock);
+    notify_state(client, PAUMIOT_STATE_CONNECTING);
+
+    int fd = -1;
+    paumiot_client_result_t result = client->coap ? client_coap_open(client, &fd)
+                                                  : client_conn_open(client, &fd);
+
+    pthread_mutex_lock(&client->lock);
+    if (result == PAUMIOT_CLIENT_SUCCESS && !client_conn_attach(client, fd)) {
+        close(fd);
+        result = PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+    if (result == PAUMIOT_CLIENT_SUCCESS) {
+        connected_locked(client);
+    } else {
+        client->state = PAUMIOT_STATE_DISCONNECTED;
+    }
+    pthread_cond_broadcast(&client->changed);
+    pthread_mutex_unlock(&client->lock);
+
+    notify_state(client, result == PAUMIOT_CLIENT_SUCCESS ? PAUMIOT_STATE_CONNECTED
+                                                          : PAUMIOT_STATE_DISCONNECTED);
+    return result;
+}
+
+/**
+ * @brief Plan the next automatic reconnect, if any (lock held)
+ * @details Decorrelated jitter: each delay is drawn uniformly between
+ *          reconnect_delay_ms and three times the previous delay, capped at
+ *          reconnect_max_delay_ms. Delays grow about exponentially while the
+ *          broker stays away, and a fleet that lost the broker at the same
+ *          moment spreads its attempts out instead of returning in waves.
+ */
+static void schedule_reconnect_locked(paumiot_client_t *client) {
+    const paumiot_client_config_t *config = client->config;
+    if (!config->auto_reconnect ||
+        (config->max_reconnect_attempts > 0 &&
+         client->reconnect_attempts >= config->max_reconnect_attempts)) {
+        client->reconnect_at_ns = 0;
+        return;
+    }
+
+    uint64_t base = config->reconnect_delay_ms;
+    uint64_t cap = config->reconnect_max_delay_ms > base ? config->reconnect_max_delay_ms : base;
+    uint64_t previous = client->reconnect_delay_ms > base ? client->reconnect_delay_ms : base;
+    uint64_t high = previous * 3 < cap ? previous * 3 : cap;
+    uint64_t delay = base + (high > base ? client_random(client) % (high - base + 1) : 0);
+
+    client->reconnect_delay_ms = (uint32_t)delay;
+    client->reconnect_at_ns = client_now_ns() + delay * 1000000ull;
+    wake_loop(client);                  /* The next pass arms the timer for it */
+}
+
+/**
+ * @brief Fire the callbacks of QoS 0 publishes queued since the last pass
+ * @details Also reports the ones a teardown marked failed.
+ */
+static void run_completions(paumiot_client_t *client) {
+    for (;;) {
+        client_completion_t batch[COMPLETION_BATCH];
+        pthread_mutex_lock(&client->lock);
+        size_t n = client->completion_count < COMPLETION_BATCH ? client->completion_count
+                                                               : COMPLETION_BATCH;
+        if (n == 0) {
+            pthread_mutex_unlock(&client->lock);
+            return;
+        }
+        memcpy(batch, client->completions, n * sizeof(client_completion_t));
+        client->completion_count -= n;
+        memmove(client->completions, client->completions + n,
+                client->completion_count * sizeof(client_completion_t));
+        pthread_mutex_unlock(&client->lock);
+
+        for (size_t i = 0; i < n; i++) {
+            char message_id[CLIENT_MESSAGE_ID_LEN];
+            format_message_id(message_id, batch[i].seq);
+            batch[i].callback(client, message_id, !batch[i].failed, batch[i].user_data);
+        }
+    }
+}
+
+/**
+ * @brief Report the publishes a teardown left in INFLIGHT_FAILED slots
+ * @details Batched through the stack and released slot by slot, so nothing
+ *          is allocated and a concurrent teardown cannot report one twice.
+ */
+static void run_failed_publishes(paumiot_client_t *client) {
+    for (;;) {
+        client_completion_t batch[COMPLETION_BATCH];
+        size_t n = 0;
+        pthread_mutex_lock(&client->lock);
+        for (size_t i = 0; i < client->window && n < COMPLETION_BATCH; i++) {
+            client_inflight_t *slot = &client->inflight[i];
+            if (slot->state == INFLIGHT_FAILED) {
+                batch[n].seq = slot->seq;
+                batch[n].callback = slot->callback;
+                batch[n].user_data = slot->user_data;
+                n++;
+                inflight_release(client, slot);
+            }
+        }
+        pthread_mutex_unlock(&client->lock);
+        if (n == 0) {
+            return;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            char message_id[CLIENT_MESSAGE_ID_LEN];
+            format_message_id(message_id, batch[i].seq);
+            batch[i].callback(client, message_id, false, batch[i].user_data);
+        }
+    }
+}
+
+/**
+ * @brief Close the socket and fail everything outstanding
+ * @details Runs on the loop thread (or the caller when there is none).
+ *          Unacknowledged publishes and QoS 0 publishes whose callback is
+ *          still queued report success = false.
+ */
+static void client_teardown(paumiot_client_t *client, bool graceful) {
+    pthread_mutex_lock(&client->lock);
+    if (client->fd < 0) {
+        pthread_mutex_unlock(&client->lock);
+        return;
+    }
+    if (graceful && !client->broken && !client->coap) {
+        uint8_t packet[2];
+        send_control_locked(client, packet, client_mqtt_encode_simple(packet, CLIENT_MQTT_DISCONNECT));
+    }
+    bool lost = client->state == PAUMIOT_STATE_CONNECTED;
+    client_conn_close(client);
+    client->state = PAUMIOT_STATE_DISCONNECTED;
+    client->broken = false;
+    client->ping_sent_ns = 0;
+    client->generation++;
+    client_buffer_reset(&client->out);
+    client_buffer_reset(&client->in);
+
+    /* Slots with a callback stay taken until run_failed_publishes reports them */
+    size_t failed_count = 0;
+    for (size_t i = 0; i < client->window; i++) {
+        client_inflight_t *slot = &client->inflight[i];
+        if (slot->state == INFLIGHT_FREE) {
+            continue;
+        }
+        if (slot->callback) {
+            slot->state = INFLIGHT_FAILED;
+            failed_count++;
+        } else {
+            slot->state = INFLIGHT_FREE;
+            client->inflight_count--;
+        }
+    }
+    if (client->coap) {
+        client_coap_fail_locked(client, PAUMIOT_CLIENT_ERROR_NOT_CONNECTED);
+    }
+
+    /* Unacknowledged spooled publishes go again after reconnecting */
+    if (client->spool.map) {
+        client_spool_rewind(&client->spool);
+        client_spool_commit(&client->spool);
+    }
+    if (lost) {
+        client->reconnect_attempts = 0;
+        schedule_reconnect_locked(client);
+    }
+
+    for (size_t i = 0; i < client->completion_count; i++) {
+        client->completions[i].failed = true;
+    }
+    failed_count += client->completion_count;
+    pthread_cond_broadcast(&client->changed);
+    pthread_mutex_unlock(&client->lock);
+
+    client_debug("disconnected, %zu publishes failed", failed_count);
+    run_failed_publishes(client);
+    run_completions(client);
+    if (client->coap) {
+        client_coap_run_done(client);
+    }
+    notify_state(client, PAUMIOT_STATE_DISCONNECTED);
+}
+
+paumiot_client_result_t paumiot_client_disconnect(paumiot_client_t *client) {
+    if (!client) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&client->lock);
+    if (client->fd < 0) {
+        /* Waiting to reconnect or reconnecting: stop trying */
+        bool reconnecting = client->reconnect_at_ns != 0;
+        bool handshaking = client->handshake_fd >= 0;
+        client->reconnect_at_ns = 0;
+        if (handshaking) {
+            client_conn_abort(client);
+            client->state = PAUMIOT_STATE_DISCONNECTED;
+            pthread_cond_broadcast(&client->changed);
+        }
+        pthread_mutex_unlock(&client->lock);
+        if (handshaking) {
+            notify_state(client, PAUMIOT_STATE_DISCONNECTED);
+        }
+        return reconnecting || handshaking ? PAUMIOT_CLIENT_SUCCESS
+                                           : PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+    }
+
+    if (client->thread_running && !pthread_equal(pthread_self(), client->thread)) {
+        /* Let the loop thread see EOF and tear down, so callbacks stay there */
+        client->state = PAUMIOT_STATE_DISCONNECTING;
+        if (client->coap) {
+            client->broken = true;      /* UDP sees no EOF; the loop tears down */
+            wake_loop(client);
+        } else {
+            if (!client->broken) {
+                uint8_t packet[2];
+                send_control_locked(client, packet,
+                                    client_mqtt_encode_simple(packet, CLIENT_MQTT_DISCONNECT));
+            }
+            shutdown(client->fd, SHUT_RDWR);
+        }
+        while (client->fd >= 0) {
+            pthread_cond_wait(&client->changed, &client->lock);
+        }
+        pthread_mutex_unlock(&client->lock);
+        return PAUMIOT_CLIENT_SUCCESS;
+    }
+
+    client->state = PAUMIOT_STATE_DISCONNECTING;
+    pthread_mutex_unlock(&client->lock);
+    notify_state(client, PAUMIOT_STATE_DISCONNECTING);
+    client_teardown(client, true);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+bool paumiot_client_is_connected(const paumiot_client_t *client) {
+    return paumiot_client_get_state(client) == PAUMIOT_STATE_CONNECTED;
+}
+
+paumiot_connection_state_t paumiot_client_get_state(const paumiot_client_t *client) {
+    if (!client) {
+        return PAUMIOT_STATE_DISCONNECTED;
+    }
+    paumiot_client_t *c = (paumiot_client_t *)client;
+    pthread_mutex_lock(&c->lock);
+    paumiot_connection_state_t state = c->state;
+    pthread_mutex_unlock(&c->lock);
+    return state;
+}
+
+/* ============================================================================
+ * PUBLISH API
+ * ========================================================================= */
+
+static bool valid_publish(const paumiot_client_t *client, const char *topic,
+                          const uint8_t *payload, size_t payload_len, paumiot_qos_t qos) {
+    return client && topic && topic[0] != '\0' && !strpbrk(topic, "+#") &&
+           (payload || payload_len == 0) && qos >= PAUMIOT_QOS_0 && qos <= PAUMIOT_QOS_2;
+}
+
+/**
+ * @brief Make room for one more completion (lock held)
+ */
+static bool reserve_completion_locked(paumiot_client_t *client) {
+    if (client->completion_count < client->completion_capacity) {
+        return true;
+    }
+    size_t capacity = client->completion_capacity ? client->completion_capacity * 2 : 16;
+    client_completion_t *grown = (client_completion_t *)realloc(
+        client->completions, capacity * sizeof(client_completion_t));
+    if (!grown) {
+        return false;
+    }
+    client->completions = grown;
+    client->completion_capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Queue a successful callback for the loop to run (lock held)
+ */
+static void push_completion_locked(paumiot_client_t *client, uint64_t seq,
+                                   paumiot_publish_callback_t callback, void *user_data) {
+    client_completion_t *done = &client->completions[client->completion_count++];
+    done->seq = seq;
+    done->callback = callback;
+    done->user_data = user_data;
+    done->failed = false;
+    wake_loop(client);
+}
+
+/**
+ * @brief Publishes go to the spool rather than the socket (lock held)
+ */
+static bool spooling_locked(const paumiot_client_t *client) {
+    return client->spool.map &&
+           (client->state != PAUMIOT_STATE_CONNECTED || client->broken);
+}
+
+/**
+ * @brief Store one publish in the offline spool (lock held)
+ * @details The callback reports success once the message is stored; it is
+ *          sent after the next successful connect.
+ */
+static paumiot_client_result_t spool_publish_locked(paumiot_client_t *client,
+                                                    const client_spool_record_t *record,
+                                                    paumiot_publish_callback_t callback,
+                                                    void *user_data, uint64_t *seq_out) {
+    if (callback && !reserve_completion_locked(client)) {
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    if (!client_spool_append(&client->spool, record)) {
+        return PAUMIOT_CLIENT_ERROR_BUFFER_OVERFLOW;
+    }
+    uint64_t seq = client->next_seq++;
+    if (callback) {
+        push_completion_locked(client, seq, callback, user_data);
+    }
+    *seq_out = seq;
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+/**
+ * @brief Encode one publish into the send buffer without writing it (lock held)
+ * @details Only writes to the socket when the buffer is too full to take
+ *          the message. While disconnected with a spool configured the
+ *          message is spooled instead.
+ * @param spool_ticket Spool record being drained, 0 for a live publish
+ * @param seq_out Receives the message ID
+ */
+static paumiot_client_result_t encode_publish_locked(paumiot_client_t *client, const char *topic,
+                                                     size_t topic_len, const uint8_t *payload,
+                                                     size_t payload_len, paumiot_qos_t qos,
+                                                     bool retain,
+                                                     paumiot_publish_callback_t callback,
+                                                     void *user_data, uint64_t spool_ticket,
+                                                     uint64_t *seq_out) {
+    size_t need = client_mqtt_publish_size(topic_len, payload_len, qos);
+    if (topic_len > 0xFFFF || need + CONTROL_RESERVE > client->out.size) {
+        return PAUMIOT_CLIENT_ERROR_BUFFER_OVERFLOW;
+    }
+    if (spooling_locked(client)) {
+        client_spool_record_t record = { qos, retain, topic, topic_len, payload, payload_len };
+        return spool_publish_locked(client, &record, callback, user_data, seq_out);
+    }
+    if (client->state != PAUMIOT_STATE_CONNECTED || client->broken) {
+        return PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+    }
+
+    if (client_buffer_space(&client->out) < need + CONTROL_RESERVE) {
+        if (!client_conn_flush(client)) {
+            client->broken = true;
+            return PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+        }
+        if (client_buffer_space(&client->out) < need + CONTROL_RESERVE) {
+            return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK;
+        }
+    }
+
+    client_inflight_t *slot = NULL;
+    if (qos > PAUMIOT_QOS_0) {
+        slot = inflight_acquire(client);
+        if (!slot) {
+            return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK;
+        }
+    } else if (callback && !reserve_completion_locked(client)) {
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint8_t *dst = client_buffer_reserve(&client->out, need);
+    client_buffer_commit(&client->out,
+                         client_mqtt_encode_publish(dst, need, topic, topic_len, payload,
+                                                    payload_len, qos, retain,
+                                                    slot ? slot->packet_id : 0));
+
+    uint64_t seq = client->next_seq++;
+    if (slot) {
+        slot->state = qos == PAUMIOT_QOS_1 ? INFLIGHT_PUBACK : INFLIGHT_PUBREC;
+        slot->seq = seq;
+        slot->callback = callback;
+        slot->user_data = user_data;
+        slot->spool_ticket = spool_ticket;
+    } else if (callback) {
+        push_completion_locked(client, seq, callback, user_data);
+    }
+    *seq_out = seq;
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+/**
+ * @brief Write the send buffer after queueing publishes (lock held)
+ */
+static void flush_publishes_locked(paumiot_client_t *client) {
+    if (client->fd < 0 || client->broken) {
+        return;                         /* Spooled, or failed by the loop */
+    }
+    if (!client_conn_flush(client)) {
+        client->broken = true;          /* The loop fails the messages */
+    }
+}
+
+/**
+ * @brief Send spooled publishes after a reconnect (lock held)
+ * @details The spool gets spool_drain_ratio parts of the inflight window and
+ *          the send buffer for every part left to live publishes, so a long
+ *          backlog drains alongside new traffic instead of starving it.
+ *          QoS 0 records are released once encoded, QoS 1/2 records when
+ *          acknowledged; anything unacknowledged goes again after the next
+ *          reconnect or restart. Also persists the head moved by
+ *          acknowledgements since the last pass.
+ */
+static void drain_spool_locked(paumiot_client_t *client) {
+    if (!client->spool.map) {
+        return;
+    }
+    if (client->spool.records == 0 || client->state != PAUMIOT_STATE_CONNECTED ||
+        client->broken) {
+        client_spool_commit(&client->spool);
+        return;
+    }
+
+    uint32_t ratio = client->config->spool_drain_ratio;
+    size_t window_share = client->window * ratio / (ratio + 1);
+    size_t buffer_share = client->out.size / (ratio + 1) * ratio;
+    if (window_share == 0) {
+        window_share = 1;
+    }
+
+    size_t drained = 0;
+    client_spool_record_t record;
+    while (drained < SPOOL_DRAIN_BATCH && client_spool_peek(&client->spool, &record)) {
+        size_t need = client_mqtt_publish_size(record.topic_len, record.payload_len, record.qos);
+        if ((record.qos > PAUMIOT_QOS_0 && client->inflight_count >= window_share) ||
+            client_buffer_used(&client->out) + need > buffer_share) {
+            break;
+        }
+
+        /* The record points into the mapping: encode before taking it */
+        uint64_t seq;
+        uint64_t ticket = client_spool_next_ticket(&client->spool);
+        if (encode_publish_locked(client, record.topic, record.topic_len, record.payload,
+                                  record.payload_len, record.qos, record.retain, NULL, NULL,
+                                  ticket, &seq) != PAUMIOT_CLIENT_SUCCESS) {
+            break;
+        }
+        if (client_spool_take(&client->spool) == 0) {
+            client->broken = true;      /* Reconnecting rewinds the spool */
+            break;
+        }
+        if (record.qos == PAUMIOT_QOS_0) {
+            client_spool_ack(&client->spool, ticket);
+        }
+        drained++;
+    }
+    if (drained > 0) {
+        flush_publishes_locked(client);
+    }
+    client_spool_commit(&client->spool);
+    if (drained == SPOOL_DRAIN_BATCH) {
+        wake_loop(client);              /* More next pass, after reading */
+    }
+}
+
+/**
+ * @brief Encode one publish and write it (lock held)
+ */
+static paumiot_client_result_t publish_locked(paumiot_client_t *client, const char *topic,
+                                              const uint8_t *payload, size_t payload_len,
+                                              paumiot_qos_t qos, bool retain,
+                                              paumiot_publish_callback_t callback,
+                                              void *user_data, uint64_t *seq_out) {
+    paumiot_client_result_t result = encode_publish_locked(client, topic, strlen(topic), payload,
+                                                           payload_len, qos, retain, callback,
+                                                           user_data, 0, seq_out);
+    if (result == PAUMIOT_CLIENT_SUCCESS) {
+        flush_publishes_locked(client);
+    }
+    return result;
+}
+
+paumiot_client_result_t paumiot_client_publish_async(
+    paumiot_client_t *client,
+    const char *topic,
+    const uint8_t *payload,
+    size_t payload_len,
+    paumiot_qos_t qos,
+    bool retain,
+    paumiot_publish_callback_t callback,
+    void *user_data
+) {
+    if (!valid_publish(client, topic, payload, payload_len, qos)) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (client->coap) {
+        return PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    }
+
+    uint64_t seq;
+    pthread_mutex_lock(&client->lock);
+    paumiot_client_result_t result = publish_locked(client, topic, payload, payload_len, qos,
+                                                    retain, callback, user_data, &seq);
+    pthread_mutex_unlock(&client->lock);
+    return result;
+}
+
+paumiot_client_result_t paumiot_client_publish_batch(
+    paumiot_client_t *client,
+    const paumiot_message_t *messages,
+    size_t count,
+    paumiot_publish_callback_t callback,
+    size_t *published
+) {
+    if (published) {
+        *published = 0;
+    }
+    if (!client || (!messages && count > 0)) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (client->coap) {
+        return PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const paumiot_message_t *m = &messages[i];
+        if (!valid_publish(client, m->topic, m->payload, m->payload_len, m->qos)) {
+            return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+        }
+    }
+
+    /* Encode back to back, then hand the kernel everything in one send() */
+    paumiot_client_result_t result = PAUMIOT_CLIENT_SUCCESS;
+    size_t queued = 0;
+    pthread_mutex_lock(&client->lock);
+    while (queued < count) {
+        const paumiot_message_t *m = &messages[queued];
+        uint64_t seq;
+        result = encode_publish_locked(client, m->topic, strlen(m->topic), m->payload,
+                                       m->payload_len, m->qos, m->retain, callback,
+                                       m->user_data, 0, &seq);
+        if (result != PAUMIOT_CLIENT_SUCCESS) {
+            break;
+        }
+        queued++;
+    }
+    if (queued > 0) {
+        flush_publishes_locked(client);
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    if (published) {
+        *published = queued;
+    }
+    return result;
+}
+
+/* Outcome of a synchronous publish, shared with its callback. The loop
+ * thread may call back after a timed-out publisher returned, so the last
+ * of the two to let go frees it (refs guarded by client->lock). */
+typedef struct {
+    bool done;
+    bool success;
+    int refs;
+} sync_wait_t;
+
+static void sync_wait_put_locked(sync_wait_t *wait) {
+    if (--wait->refs == 0) {
+        free(wait);
+    }
+}
+
+static void sync_publish_done(paumiot_client_t *client, const char *message_id, bool success,
+                              void *user_data) {
+    (void)message_id;
+    sync_wait_t *wait = (sync_wait_t *)user_data;
+    pthread_mutex_lock(&client->lock);
+    wait->done = true;
+    wait->success = success;
+    sync_wait_put_locked(wait);
+    pthread_cond_broadcast(&client->changed);
+    pthread_mutex_unlock(&client->lock);
+}
+
+/**
+ * @brief Let the loop make progress once (lock held on entry and exit)
+ * @details Waits for the loop thread if one runs, otherwise runs a loop
+ *          pass on this thread.
+ */
+static paumiot_client_result_t wait_locked(paumiot_client_t *client, uint64_t deadline_ns) {
+    uint64_t now = client_now_ns();
+    if (now >= deadline_ns) {
+        return PAUMIOT_CLIENT_ERROR_TIMEOUT;
+    }
+    uint64_t slice = now + (uint64_t)WAIT_SLICE_MS * 1000000ull;
+    if (slice > deadline_ns) {
+        slice = deadline_ns;
+    }
+
+    if (client->thread_running && !pthread_equal(pthread_self(), client->thread)) {
+        struct timespec ts = deadline_timespec(slice);
+        pthread_cond_timedwait(&client->changed, &client->lock, &ts);
+        return PAUMIOT_CLIENT_SUCCESS;
+    }
+
+    pthread_mutex_unlock(&client->lock);
+    paumiot_client_result_t result =
+        paumiot_client_loop(client, (uint32_t)((slice - now + 999999) / 1000000));
+    pthread_mutex_lock(&client->lock);
+    return result == PAUMIOT_CLIENT_ERROR_INVALID_PARAM ? result : PAUMIOT_CLIENT_SUCCESS;
+}
+
+paumiot_client_result_t paumiot_client_publish(
+    paumiot_client_t *client,
+    const char *topic,
+    const uint8_t *payload,
+    size_t payload_len,
+    paumiot_qos_t qos,
+    bool retain
+) {
+    if (!valid_publish(client, topic, payload, payload_len, qos)) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (client->coap) {
+        return PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    }
+
+    uint64_t deadline = client_now_ns() + (uint64_t)client->config->connect_timeout_ms * 1000000ull;
+    sync_wait_t *wait = calloc(1, sizeof(sync_wait_t));
+    if (!wait) {
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    wait->refs = 1;
+    uint64_t seq = 0;
+    paumiot_client_result_t result;
+
+    pthread_mutex_lock(&client->lock);
+    bool spooled = false;
+    for (;;) {
+        spooled = spooling_locked(client);
+        bool callback = qos > PAUMIOT_QOS_0 || spooled;
+        result = publish_locked(client, topic, payload, payload_len, qos, retain,
+                                callback ? sync_publish_done : NULL, wait, &seq);
+        if (result == PAUMIOT_CLIENT_SUCCESS && callback) {
+            wait->refs++;               /* Every queued callback eventually runs */
+        }
+        if (result != PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+            break;
+        }
+        result = wait_locked(client, deadline);
+        if (result != PAUMIOT_CLIENT_SUCCESS) {
+            break;
+        }
+    }
+    if (result != PAUMIOT_CLIENT_SUCCESS) {
+        sync_wait_put_locked(wait);
+        pthread_mutex_unlock(&client->lock);
+        return result;
+    }
+
+    /* QoS 0 is done once the kernel has it, QoS 1/2 once acknowledged,
+     * a spooled message once stored */
+    bool wait_kernel = qos == PAUMIOT_QOS_0 && !spooled;
+    while (wait_kernel ? client_buffer_used(&client->out) > 0 &&
+                                      client->state == PAUMIOT_STATE_CONNECTED
+                                : !wait->done) {
+        result = wait_locked(client, deadline);
+        if (result != PAUMIOT_CLIENT_SUCCESS) {
+            sync_wait_put_locked(wait);
+            pthread_mutex_unlock(&client->lock);
+            return result;
+        }
+    }
+
+    bool delivered = wait_kernel ? client->state == PAUMIOT_STATE_CONNECTED
+                                          : wait->success;
+    sync_wait_put_locked(wait);
+    pthread_mutex_unlock(&client->lock);
+    return delivered ? PAUMIOT_CLIENT_SUCCESS : PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+}
+
+/* ============================================================================
+ * SUBSCRIBE API
+ * ========================================================================= */
+
+static client_subscription_t *find_subscription(paumiot_client_t *client, const char *filter) {
+    for (size_t i = 0; i < client->sub_count; i++) {
+        if (strcmp(client->subs[i].filter, filter) == 0) {
+            return &client->subs[i];
+        }
+    }
+    return NULL;
+}
+
+paumiot_client_result_t paumiot_client_subscribe(
+    paumiot_client_t *client,
+    const char *topic_filter,
+    paumiot_qos_t qos,
+    paumiot_message_callback_t callback,
+    void *user_data
+) {
+    if (!client || !topic_filter || topic_filter[0] == '\0' || !callback ||
+        qos < PAUMIOT_QOS_0 || qos > PAUMIOT_QOS_2) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (client->coap) {
+        return PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    }
+
+    pthread_mutex_lock(&client->lock);
+    if (find_subscription(client, topic_filter)) {
+        pthread_mutex_unlock(&client->lock);
+        return PAUMIOT_CLIENT_ERROR_ALREADY_SUBSCRIBED;
+    }
+
+    /* Sent now if connected, otherwise on the next connect */
+    paumiot_client_result_t result = PAUMIOT_CLIENT_SUCCESS;
+    if (client->state == PAUMIOT_STATE_CONNECTED) {
+        result = send_subscription_locked(client, CLIENT_MQTT_SUBSCRIBE, topic_filter, qos);
+    }
+
+    if (result == PAUMIOT_CLIENT_SUCCESS && client->sub_count == client->sub_capacity) {
+        size_t capacity = client->sub_capacity ? client->sub_capacity * 2 : 8;
+        client_subscription_t *grown = (client_subscription_t *)realloc(
+            client->subs, capacity * sizeof(client_subscription_t));
+        if (grown) {
+            client->subs = grown;
+            client->sub_capacity = capacity;
+        } else {
+            result = PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    if (result == PAUMIOT_CLIENT_SUCCESS) {
+        client_subscription_t *sub = &client->subs[client->sub_count];
+        sub->filter = strdup(topic_filter);
+        if (sub->filter) {
+            sub->qos = qos;
+            sub->callback = callback;
+            sub->user_data = user_data;
+            client->sub_count++;
+        } else {
+            result = PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    pthread_mutex_unlock(&client->lock);
+    return result;
+}
+
+paumiot_client_result_t paumiot_client_unsubscribe(
+    paumiot_client_t *client,
+    const char *topic_filter
+) {
+    if (!client || !topic_filter) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&client->lock);
+    client_subscription_t *sub = find_subscription(client, topic_filter);
+    if (!sub) {
+        pthread_mutex_unlock(&client->lock);
+        return PAUMIOT_CLIENT_ERROR_NOT_SUBSCRIBED;
+    }
+
+    paumiot_client_result_t result = PAUMIOT_CLIENT_SUCCESS;
+    if (client->state == PAUMIOT_STATE_CONNECTED) {
+        result = send_subscription_locked(client, CLIENT_MQTT_UNSUBSCRIBE, topic_filter,
+                                          PAUMIOT_QOS_0);
+    }
+    if (result == PAUMIOT_CLIENT_SUCCESS) {
+        free(sub->filter);
+        *sub = client->subs[--client->sub_count];
+    }
+    pthread_mutex_unlock(&client->lock);
+    return result;
+}
+
+/* ============================================================================
+ * COAP REQUEST API
+ * ========================================================================= */
+
+paumiot_client_result_t paumiot_client_request(
+    paumiot_client_t *client,
+    paumiot_coap_method_t method,
+    const char *path,
+    const uint8_t *payload,
+    size_t payload_len,
+    bool confirmable,
+    paumiot_response_callback_t callback,
+    void *user_data
+) {
+    if (!client || !path || (!payload && payload_len > 0) || method < PAUMIOT_COAP_GET ||
+        method > PAUMIOT_COAP_DELETE) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (!client->coap) {
+        return PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    }
+
+    pthread_mutex_lock(&client->lock);
+    paumiot_client_result_t result = PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+    if (client->state == PAUMIOT_STATE_CONNECTED && !client->broken) {
+        result = client_coap_submit_locked(client, (uint8_t)method, path, payload, payload_len,
+                                           confirmable, callback, user_data);
+    }
+    if (result == PAUMIOT_CLIENT_SUCCESS) {
+        /* A running loop pass sends it along with the rest of its batch */
+        if (!atomic_load(&client->in_loop)) {
+            client_coap_flush_locked(client);
+        }
+        wake_loop(client);              /* Arm the timer for its deadline */
+    }
+    pthread_mutex_unlock(&client->lock);
+    return result;
+}
+
+/* ============================================================================
+ * MESSAGE HANDLING
+ * ========================================================================= */
+
+typedef struct {
+    paumiot_message_callback_t callback;
+    void *user_data;
+} client_match_t;
+
+paumiot_message_t *paumiot_message_retain(const paumiot_message_t *message) {
+    if (!message || !message->topic || (!message->payload && message->payload_len > 0)) {
+        return NULL;
+    }
+    size_t topic_size = strlen(message->topic) + 1;
+    paumiot_message_t *copy =
+        (paumiot_message_t *)malloc(sizeof(*copy) + message->payload_len + topic_size);
+    if (!copy) {
+        return NULL;
+    }
+    *copy = *message;
+    copy->payload = (uint8_t *)(copy + 1);
+    copy->topic = (char *)copy->payload + message->payload_len;
+    if (message->payload_len > 0) {
+        memcpy(copy->payload, message->payload, message->payload_len);
+    }
+    memcpy(copy->topic, message->topic, topic_size);
+    return copy;
+}
+
+void paumiot_message_release(paumiot_message_t *message) {
+    free(message);
+}
+
+/**
+ * @brief Hand a received PUBLISH to every matching subscription
+ * @details topic is NUL-terminated in the receive buffer. Without
+ *          zero_copy_receive the message is copied into one allocation,
+ *          payload first so it keeps malloc's alignment.
+ */
+static void deliver(paumiot_client_t *client, char *topic, size_t topic_len, uint8_t *payload,
+                    size_t payload_len, paumiot_qos_t qos, bool retain) {
+    client_match_t matches[CLIENT_MAX_MATCHES];
+    size_t match_count = 0;
+
+    pthread_mutex_lock(&client->lock);
+    for (size_t i = 0; i < client->sub_count && match_count < CLIENT_MAX_MATCHES; i++) {
+        if (client_mqtt_topic_matches(client->subs[i].filter, topic, topic_len)) {
+            matches[match_count].callback = client->subs[i].callback;
+            matches[match_count].user_data = client->subs[i].user_data;
+            match_count++;
+        }
+    }
+    pthread_mutex_unlock(&client->lock);
+    if (match_count == 0) {
+        return;
+    }
+
+    paumiot_message_t message;
+    uint8_t *copy = NULL;
+    if (client->config->zero_copy_receive) {
+        message.topic = topic;
+        message.payload = payload;
+    } else {
+        copy = (uint8_t *)malloc(payload_len + topic_len + 1);
+        if (!copy) {
+            client_debug("dropped message on %s: out of memory", topic);
+            return;
+        }
+        memcpy(copy, payload, payload_len);
+        memcpy(copy + payload_len, topic, topic_len + 1);
+        message.payload = copy;
+        message.topic = (char *)copy + payload_len;
+    }
+    message.payload_len = payload_len;
+    message.qos = qos;
+    message.retain = retain;
+    message.user_data = NULL;
+
+    for (size_t i = 0; i < match_count; i++) {
+        matches[i].callback(client, &message, matches[i].user_data);
+    }
+    free(copy);
+}
+
+static bool handle_publish(paumiot_client_t *client, uint8_t flags, uint8_t *body, size_t len) {
+    paumiot_qos_t qos = (paumiot_qos_t)((flags >> 1) & 0x03);
+    if (qos > PAUMIOT_QOS_2 || len < 2) {
+        return false;
+    }
+    size_t topic_len = get_u16(body);
+    size_t pos = 2 + topic_len + (qos > PAUMIOT_QOS_0 ? 2 : 0);
+    if (pos > len) {
+        return false;
+    }
+    uint16_t packet_id = qos > PAUMIOT_QOS_0 ? get_u16(body + 2 + topic_len) : 0;
+
+    /* Terminate the topic in place: slide it over its length prefix, as the
+     * byte after it may be the payload's first */
+    memmove(body, body + 2, topic_len);
+    body[topic_len] = '\0';
+    deliver(client, (char *)body, topic_len, body + pos, len - pos, qos, flags & 0x01);
+
+    if (qos > PAUMIOT_QOS_0) {
+        uint8_t packet[4];
+        pthread_mutex_lock(&client->lock);
+        send_control_locked(client, packet,
+                            client_mqtt_encode_ack(packet, qos == PAUMIOT_QOS_1 ? CLIENT_MQTT_PUBACK
+                                                                                : CLIENT_MQTT_PUBREC,
+                                                   packet_id));
+        pthread_mutex_unlock(&client->lock);
+    }
+    return true;
+}
+
+/**
+ * @brief Act on one packet from the broker
+ * @return false on a protocol violation
+ */
+static bool handle_packet(paumiot_client_t *client, uint8_t type, uint8_t flags,
+                          uint8_t *body, size_t len) {
+    if (type == CLIENT_MQTT_PUBLISH) {
+        return handle_publish(client, flags, body, len);
+    }
+    if (type == CLIENT_MQTT_PINGRESP) {
+        pthread_mutex_lock(&client->lock);
+        client->ping_sent_ns = 0;
+        pthread_mutex_unlock(&client->lock);
+        return true;
+    }
+    if (len < 2) {
+        return false;
+    }
+
+    uint16_t packet_id = get_u16(body);
+    uint8_t packet[4];
+    client_inflight_t *slot;
+
+    switch (type) {
+    case CLIENT_MQTT_PUBACK:
+        complete_publish(client, packet_id, INFLIGHT_PUBACK);
+        return true;
+
+    case CLIENT_MQTT_PUBREC:
+        pthread_mutex_lock(&client->lock);
+        slot = inflight_find(client, packet_id, INFLIGHT_PUBREC);
+        if (slot) {
+            slot->state = INFLIGHT_PUBCOMP;
+        }
+        /* Answer even unknown IDs so the broker can release them */
+        send_control_locked(client, packet,
+                            client_mqtt_encode_ack(packet, CLIENT_MQTT_PUBREL, packet_id));
+        pthread_mutex_unlock(&client->lock);
+        return true;
+
+    case CLIENT_MQTT_PUBCOMP:
+        complete_publish(client, packet_id, INFLIGHT_PUBCOMP);
+        return true;
+
+    case CLIENT_MQTT_PUBREL:
+        pthread_mutex_lock(&client->lock);
+        send_control_locked(client, packet,
+                            client_mqtt_encode_ack(packet, CLIENT_MQTT_PUBCOMP, packet_id));
+        pthread_mutex_unlock(&client->lock);
+        return true;
+
+    case CLIENT_MQTT_SUBACK:
+    case CLIENT_MQTT_UNSUBACK:
+        pthread_mutex_lock(&client->lock);
+        slot = inflight_find(client, packet_id,
+                             type == CLIENT_MQTT_SUBACK ? INFLIGHT_SUBACK : INFLIGHT_UNSUBACK);
+        if (slot) {
+            inflight_release(client, slot);
+        }
+        pthread_mutex_unlock(&client->lock);
+        if (type == CLIENT_MQTT_SUBACK && len >= 3 && body[2] == SUBACK_FAILURE) {
+            client_debug("broker refused subscription %u", packet_id);
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Read what the socket has and handle every complete packet
+ * @return false if the connection is gone
+ */
+static bool read_packets(paumiot_client_t *client, uint32_t generation) {
+    client_buffer_t *in = &client->in;
+
+    for (int reads = 0; reads < MAX_READS_PER_PASS; reads++) {
+        uint8_t *dst = client_buffer_reserve(in, client_buffer_space(in));
+        if (!dst || client_buffer_space(in) == 0) {
+            client_debug("packet larger than recv_buffer_size");
+            return false;
+        }
+        ssize_t n = recv(client->fd, dst, in->size - in->end, 0);
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        client_buffer_commit(in, (size_t)n);
+
+        for (;;) {
+            uint8_t type;
+            uint8_t flags;
+            size_t body;
+            size_t body_len;
+            long packet = client_mqtt_parse(in->data + in->start, client_buffer_used(in), &type,
+                                            &flags, &body, &body_len);
+            if (packet == 0) {
+                break;
+            }
+            if (packet < 0 || !handle_packet(client, type, flags, in->data + in->start + body,
+                                             body_len)) {
+                client_debug("protocol error from broker (packet type %u)", type);
+                return false;
+            }
+
+            /* A callback may have disconnected, which resets the buffer */
+            pthread_mutex_lock(&client->lock);
+            bool same = client->generation == generation;
+            pthread_mutex_unlock(&client->lock);
+            if (!same) {
+                return true;
+            }
+            client_buffer_consume(in, (size_t)packet);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Milliseconds until the keep-alive needs the loop (lock held)
+ * @return 0 if due, -1 if keep-alive is off
+ */
+static int keepalive_due_ms_locked(const paumiot_client_t *client, uint64_t now) {
+    uint64_t interval = (uint64_t)client->config->keepalive_interval_ms * 1000000ull;
+    if (interval == 0) {
+        return -1;
+    }
+    uint64_t due = (client->ping_sent_ns ? client->ping_sent_ns : client->last_tx_ns) + interval;
+    if (now >= due) {
+        return 0;
+    }
+    uint64_t ms = (due - now + 999999) / 1000000;
+    return ms > INT32_MAX ? INT32_MAX : (int)ms;
+}
+
+/**
+ * @brief Send PINGREQ when idle for a keep-alive interval (lock held)
+ * @return Milliseconds until the next keep-alive action, -1 if the broker
+ *         missed a PINGRESP, or -2 if keep-alive is off
+ */
+static int keepalive_locked(paumiot_client_t *client) {
+    uint64_t now = client_now_ns();
+    int due_ms = keepalive_due_ms_locked(client, now);
+    if (due_ms != 0) {
+        return due_ms < 0 ? -2 : due_ms;
+    }
+    if (client->ping_sent_ns) {
+        return -1;
+    }
+    uint8_t packet[2];
+    send_control_locked(client, packet, client_mqtt_encode_simple(packet, CLIENT_MQTT_PINGREQ));
+    client->ping_sent_ns = now;
+    return keepalive_due_ms_locked(client, now);
+}
+
+/**
+ * @brief Make timer_fd fire by deadline_ns (loop thread)
+ * @details Only ever moves an armed timer earlier. Deadlines mostly move
+ *          later as traffic flows, and firing early merely runs a pass that
+ *          re-arms, so this costs about one syscall per keep-alive interval.
+ */
+static void arm_timer(paumiot_client_t *client, uint64_t deadline_ns) {
+    if (client->timer_ns != 0 && client->timer_ns <= deadline_ns) {
+        return;
+    }
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value = deadline_timespec(deadline_ns);
+    if (timerfd_settime(client->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) == 0) {
+        client->timer_ns = deadline_ns;
+    }
+}
+
+static void drain_fd(int fd) {
+    uint64_t count;
+    ssize_t n = read(fd, &count, sizeof(count));
+    (void)n;
+}
+
+/**
+ * @brief Take the finished reconnect handshake's outcome (lock held)
+ * @return result, or a failure if fd could not be attached
+ */
+static paumiot_client_result_t reconnected_locked(paumiot_client_t *client,
+                                                  paumiot_client_result_t result, int fd) {
+    if (result == PAUMIOT_CLIENT_SUCCESS && !client_conn_attach(client, fd)) {
+        close(fd);
+        result = PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+    if (result == PAUMIOT_CLIENT_SUCCESS) {
+        connected_locked(client);
+    } else {
+        client->state = PAUMIOT_STATE_DISCONNECTED;
+        schedule_reconnect_locked(client);
+    }
+    pthread_cond_broadcast(&client->changed);
+    return result;
+}
+
+/**
+ * @brief Automatic reconnect attempt (loop thread)
+ * @details Only starts it: the connect and the MQTT handshake run through
+ *          epoll like other socket traffic, so the loop, and every client
+ *          sharing it, keeps going. handshake_step() finishes the attempt,
+ *          or fails it after connect_timeout_ms. Reconnects go to the
+ *          address last connected to, without a blocking name lookup.
+ */
+static void reconnect(paumiot_client_t *client) {
+    pthread_mutex_lock(&client->lock);
+    if (client->state != PAUMIOT_STATE_DISCONNECTED || client->reconnect_at_ns == 0) {
+        pthread_mutex_unlock(&client->lock);
+        return;                         /* Connected or disconnected meanwhile */
+    }
+    client->reconnect_at_ns = 0;
+    uint32_t attempt = ++client->reconnect_attempts;
+    client->state = PAUMIOT_STATE_CONNECTING;
+    int fd = -1;
+    paumiot_client_result_t result = client_conn_begin(client, &fd);
+    if (result != PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+        result = reconnected_locked(client, result, fd);
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    client_debug("reconnect attempt %u", attempt);
+    notify_state(client, PAUMIOT_STATE_CONNECTING);
+    if (result != PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+        notify_state(client, result == PAUMIOT_CLIENT_SUCCESS ? PAUMIOT_STATE_CONNECTED
+                                                              : PAUMIOT_STATE_DISCONNECTED);
+    }
+}
+
+/**
+ * @brief Advance the reconnect handshake on its events or timeout (loop thread)
+ * @return true if the client is connected again
+ */
+static bool handshake_step(paumiot_client_t *client) {
+    pthread_mutex_lock(&client->lock);
+    if (client->handshake_fd < 0) {
+        pthread_mutex_unlock(&client->lock);
+        return false;                   /* None, or paumiot_client_disconnect() gave up */
+    }
+    int fd = -1;
+    paumiot_client_result_t result = client_conn_handshake(client, &fd);
+    if (result == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK &&
+        client_now_ns() >= client->handshake_deadline_ns) {
+        client_debug("reconnect timed out");
+        client_conn_abort(client);
+        result = PAUMIOT_CLIENT_ERROR_TIMEOUT;
+    }
+    if (result != PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+        result = reconnected_locked(client, result, fd);
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    if (result == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+        return false;
+    }
+    notify_state(client, result == PAUMIOT_CLIENT_SUCCESS ? PAUMIOT_STATE_CONNECTED
+                                                          : PAUMIOT_STATE_DISCONNECTED);
+    return result == PAUMIOT_CLIENT_SUCCESS;
+}
+
+static paumiot_client_result_t loop_pass(paumiot_client_t *client, uint32_t timeout_ms) {
+    pthread_mutex_lock(&client->lock);
+    bool reconnect_due = client->fd < 0 && client->reconnect_at_ns != 0 &&
+                         client_now_ns() >= client->reconnect_at_ns;
+    pthread_mutex_unlock(&client->lock);
+    if (reconnect_due) {
+        reconnect(client);
+    }
+    if (client->coap) {
+        client_coap_expire(client);     /* Retransmissions and timeouts */
+    }
+
+    pthread_mutex_lock(&client->lock);
+    bool connected = client->fd >= 0;
+    bool handshaking = client->handshake_fd >= 0;
+    int keepalive_ms = connected && !client->coap ? keepalive_locked(client) : -2;
+    bool broken = connected && (client->broken || keepalive_ms == -1);
+    uint32_t generation = client->generation;
+    uint64_t timer_ns = 0;
+    if (keepalive_ms >= 0) {
+        timer_ns = client_now_ns() + (uint64_t)keepalive_ms * 1000000ull;
+    } else if (!connected) {
+        timer_ns = handshaking ? client->handshake_deadline_ns : client->reconnect_at_ns;
+    } else if (client->coap) {
+        timer_ns = client_coap_next_deadline_locked(client);
+    }
+    if (connected && !broken) {
+        drain_spool_locked(client);
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    if (broken) {
+        client_teardown(client, false);
+        return PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+    }
+    if (timer_ns != 0) {
+        arm_timer(client, timer_ns);
+    }
+
+    /* Completions queued by publishers fire before we sleep */
+    run_completions(client);
+
+    struct epoll_event events[3];
+    int n = epoll_wait(client->epoll_fd, events, 3,
+                       timeout_ms > INT32_MAX ? INT32_MAX : (int)timeout_ms);
+    if (n < 0 && errno != EINTR) {
+        if (connected) {
+            client_teardown(client, false);
+        }
+        return PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+    }
+
+    bool readable = false;
+    bool writable = false;
+    bool handshake = false;
+    for (int i = 0; i < n; i++) {
+        switch (events[i].data.u32) {
+        case CLIENT_EVENT_SOCKET:
+            readable = (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+            writable = (events[i].events & EPOLLOUT) != 0;
+            break;
+        case CLIENT_EVENT_HANDSHAKE:
+            handshake = true;
+            break;
+        case CLIENT_EVENT_WAKEUP:
+            atomic_store(&client->wake_pending, false);
+            drain_fd(client->wakeup_fd);
+            break;
+        case CLIENT_EVENT_TIMER:
+            client->timer_ns = 0;
+            drain_fd(client->timer_fd);
+            if (timer_ns != 0) {
+                arm_timer(client, timer_ns);        /* Fired before the arm above */
+            }
+            handshake = handshaking;                /* Maybe its deadline */
+            break;
+        }
+    }
+    if (!connected) {
+        bool reconnected = handshake && handshake_step(client);
+        run_completions(client);
+        return reconnected ? PAUMIOT_CLIENT_SUCCESS : PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+    }
+
+    bool alive = true;
+    if (writable) {
+        pthread_mutex_lock(&client->lock);
+        if (client->generation == generation && client->coap) {
+            client_coap_flush_locked(client);
+        } else if (client->generation == generation) {
+            alive = client_conn_flush(client);
+        }
+        pthread_cond_broadcast(&client->changed);
+        pthread_mutex_unlock(&client->lock);
+    }
+    if (alive && readable) {
+        alive = client->coap ? client_coap_read(client, generation)
+                             : read_packets(client, generation);
+    }
+
+    pthread_mutex_lock(&client->lock);
+    bool current = client->generation == generation;
+    alive = alive && !client->broken;
+    if (current && alive) {
+        drain_spool_locked(client);     /* Acknowledgements freed window */
+    }
+    pthread_mutex_unlock(&client->lock);
+    if (current && !alive) {
+        client_teardown(client, false);
+        return PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+    }
+
+    run_completions(client);
+    return current ? PAUMIOT_CLIENT_SUCCESS : PAUMIOT_CLIENT_ERROR_NOT_CONNECTED;
+}
+
+paumiot_client_result_t paumiot_client_loop(paumiot_client_t *client, uint32_t timeout_ms) {
+    if (!client) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    /* One loop at a time: not from callbacks, not beside the loop thread */
+    if (atomic_exchange(&client->in_loop, true)) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    paumiot_client_result_t result = loop_pass(client, timeout_ms);
+    atomic_store(&client->in_loop, false);
+    return result;
+}
+
+paumiot_client_result_t paumiot_client_loop_start(paumiot_client_t *client) {
+    if (!client) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (client->own_loop) {
+        return PAUMIOT_CLIENT_SUCCESS;
+    }
+
+    pthread_mutex_lock(&client->lock);
+    bool attached = client->event_loop != NULL;
+    pthread_mutex_unlock(&client->lock);
+    if (attached) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    /* A private event loop with just this client */
+    paumiot_event_loop_t *loop = paumiot_event_loop_create();
+    if (!loop) {
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    paumiot_client_result_t result = paumiot_event_loop_add(loop, client);
+    if (result == PAUMIOT_CLIENT_SUCCESS) {
+        result = paumiot_event_loop_start(loop);
+    }
+    if (result != PAUMIOT_CLIENT_SUCCESS) {
+        paumiot_event_loop_destroy(loop);
+        return result;
+    }
+    client->own_loop = loop;
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+paumiot_client_result_t paumiot_client_loop_stop(paumiot_client_t *client) {
+    if (!client) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    paumiot_event_loop_t *loop = client->own_loop;
+    if (!loop) {
+        return PAUMIOT_CLIENT_SUCCESS;
+    }
+
+    paumiot_client_result_t result = paumiot_event_loop_stop(loop);
+    if (result != PAUMIOT_CLIENT_SUCCESS) {
+        return result;                  /* From a callback */
+    }
+    client->own_loop = NULL;
+    paumiot_event_loop_destroy(loop);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+size_t paumiot_client_spooled(const paumiot_client_t *client) {
+    if (!client) {
+        return 0;
+    }
+    paumiot_client_t *c = (paumiot_client_t *)client;
+    pthread_mutex_lock(&c->lock);
+    size_t records = c->spool.records;
+    pthread_mutex_unlock(&c->lock);
+    return records;
+}
+
+int paumiot_client_get_fd(const paumiot_client_t *client) {
+    return client ? client->epoll_fd : -1;
+}
+
+int paumiot_client_next_timeout(const paumiot_client_t *client) {
+    if (!client) {
+        return -1;
+    }
+    paumiot_client_t *c = (paumiot_client_t *)client;
+    pthread_mutex_lock(&c->lock);
+    int timeout;
+    if (c->completion_count > 0 || (c->fd >= 0 && c->broken)) {
+        timeout = 0;
+    } else if (c->fd < 0 || c->coap) {
+        uint64_t now = client_now_ns();
+        uint64_t at = c->handshake_fd >= 0 ? c->handshake_deadline_ns
+                      : c->fd < 0          ? c->reconnect_at_ns
+                                           : client_coap_next_deadline_locked(c);
+        timeout = at == 0 ? -1 : at <= now ? 0 : (int)((at - now + 999999) / 1000000);
+    } else {
+        timeout = keepalive_due_ms_locked(c, client_now_ns());
+    }
+    pthread_mutex_unlock(&c->lock);
+    return timeout;
+}
@@ -0,0 +1,645 @@
+/**
+ * @file client_internal.h
+ * @brief Client plugin internals shared by the client-plugin/src files
+ * @details Not installed. One paumiot_client_t owns one MQTT session over
+ *          TCP, or CoAP request exchanges over UDP. Everything that publishing threads touch (send buffer,
+ *          inflight window, subscriptions, state) is guarded by the client
+ *          lock; the receive buffer belongs to whichever thread runs the
+ *          loop, and only that thread invokes user callbacks.
+ */
+
+#ifndef PAUMIOT_CLIENT_INTERNAL_H
+#define PAUMIOT_CLIENT_INTERNAL_H
+
+#include "paumiot_client.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+
+/* Defaults for paumiot_client_config_init() */
+#define CLIENT_DEFAULT_MQTT_PORT 1883
+#define CLIENT_DEFAULT_CONNECT_TIMEOUT_MS 5000
+#define CLIENT_DEFAULT_KEEPALIVE_MS 60000
+#define CLIENT_DEFAULT_BUFFER_SIZE (64 * 1024)
+#define CLIENT_DEFAULT_MAX_INFLIGHT 32
+#define CLIENT_DEFAULT_RECONNECT_DELAY_MS 1000
+#define CLIENT_DEFAULT_RECONNECT_MAX_DELAY_MS 60000
+#define CLIENT_DEFAULT_SPOOL_SIZE (4 * 1024 * 1024)
+#define CLIENT_DEFAULT_SPOOL_DRAIN_RATIO 4
+#define CLIENT_DEFAULT_COAP_NSTART 1
+#define CLIENT_DEFAULT_COAP_ACK_TIMEOUT_MS 2000
+
+/* Limits */
+#define CLIENT_MAX_PACKET_ID 65535
+#define CLIENT_MAX_CLIENT_ID 64
+#define CLIENT_MAX_MATCHES 32           /* Subscriptions matched per message */
+#define CLIENT_MESSAGE_ID_LEN 24        /* Decimal uint64 + NUL */
+#define CLIENT_CONNECT_MAX 512          /* CONNECT packet with credentials */
+
+/* MQTT 3.1.1 control packet types */
+#define CLIENT_MQTT_CONNECT 1
+#define CLIENT_MQTT_CONNACK 2
+#define CLIENT_MQTT_PUBLISH 3
+#define CLIENT_MQTT_PUBACK 4
+#define CLIENT_MQTT_PUBREC 5
+#define CLIENT_MQTT_PUBREL 6
+#define CLIENT_MQTT_PUBCOMP 7
+#define CLIENT_MQTT_SUBSCRIBE 8
+#define CLIENT_MQTT_SUBACK 9
+#define CLIENT_MQTT_UNSUBSCRIBE 10
+#define CLIENT_MQTT_UNSUBACK 11
+#define CLIENT_MQTT_PINGREQ 12
+#define CLIENT_MQTT_PINGRESP 13
+#define CLIENT_MQTT_DISCONNECT 14
+
+/* CoAP (RFC 7252) message types */
+#define CLIENT_COAP_CON 0
+#define CLIENT_COAP_NON 1
+#define CLIENT_COAP_ACK 2
+#define CLIENT_COAP_RST 3
+
+#define CLIENT_COAP_TOKEN_LEN 8
+#define CLIENT_COAP_MAX_DATAGRAM 1152   /* RFC 7252 4.6 */
+#define CLIENT_COAP_RECV_CHUNK 1500     /* Receive buffer bytes per datagram */
+#define CLIENT_COAP_WHEEL_SLOTS 1024    /* Power of two */
+#define CLIENT_COAP_TICK_MS 10
+#define CLIENT_COAP_CONTROL_QUEUE 64    /* Empty ACK/RST waiting to be sent */
+
+/* epoll_event.data.u32 of the client's event sources */
+#define CLIENT_EVENT_SOCKET 0
+#define CLIENT_EVENT_WAKEUP 1
+#define CLIENT_EVENT_TIMER 2
+#define CLIENT_EVENT_HANDSHAKE 3
+
+/* ============================================================================
+ * BYTE BUFFERS (buffer.c)
+ * ========================================================================= */
+
+/**
+ * @brief Fixed-capacity byte buffer; bytes live in [start, end)
+ */
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t start;
+    size_t end;
+} client_buffer_t;
+
+paumiot_client_result_t client_buffer_init(client_buffer_t *buf, size_t size);
+void client_buffer_free(client_buffer_t *buf);
+
+/**
+ * @brief Make room for len contiguous bytes at the end
+ * @return Write pointer, or NULL if the bytes do not fit even after compacting
+ */
+uint8_t *client_buffer_reserve(client_buffer_t *buf, size_t len);
+
+/**
+ * @brief Mark len bytes written after client_buffer_reserve()
+ */
+void client_buffer_commit(client_buffer_t *buf, size_t len);
+
+/**
+ * @brief Drop len bytes from the front
+ */
+void client_buffer_consume(client_buffer_t *buf, size_t len);
+
+size_t client_buffer_used(const client_buffer_t *buf);
+size_t client_buffer_space(const client_buffer_t *buf);
+void client_buffer_reset(client_buffer_t *buf);
+
+/* ============================================================================
+ * MQTT PACKETS (mqtt_packet.c)
+ * ========================================================================= */
+
+/**
+ * @brief Encoded size of a PUBLISH packet
+ */
+size_t client_mqtt_publish_size(size_t topic_len, size_t payload_len, paumiot_qos_t qos);
+
+/**
+ * @brief Encode CONNECT
+ * @return Bytes written, 0 if buf is too small
+ */
+size_t client_mqtt_encode_connect(uint8_t *buf, size_t size, const char *client_id,
+                                  const char *username, const char *password,
+                                  uint16_t keepalive_s);
+
+/**
+ * @brief Encode PUBLISH; packet_id is ignored for QoS 0
+ * @return Bytes written, 0 if buf is too small
+ */
+size_t client_mqtt_encode_publish(uint8_t *buf, size_t size, const char *topic,
+                                  size_t topic_len, const uint8_t *payload, size_t payload_len,
+                                  paumiot_qos_t qos, bool retain, uint16_t packet_id);
+
+/**
+ * @brief Encode SUBSCRIBE or UNSUBSCRIBE for one topic filter
+ * @return Bytes written, 0 if buf is too small
+ */
+size_t client_mqtt_encode_subscribe(uint8_t *buf, size_t size, uint8_t type, uint16_t packet_id,
+                                    const char *filter, paumiot_qos_t qos);
+
+/**
+ * @brief Encode PUBACK, PUBREC, PUBREL or PUBCOMP (4 bytes)
+ */
+size_t client_mqtt_encode_ack(uint8_t *buf, uint8_t type, uint16_t packet_id);
+
+/**
+ * @brief Encode PINGREQ or DISCONNECT (2 bytes)
+ */
+size_t client_mqtt_encode_simple(uint8_t *buf, uint8_t type);
+
+/**
+ * @brief Find the next complete packet in received bytes
+ * @param type Receives the packet type
+ * @param flags Receives the fixed header flags
+ * @param body Receives the offset of the variable header
+ * @param body_len Receives the remaining length
+ * @return Total packet length, 0 if incomplete, or -1 if malformed
+ */
+long client_mqtt_parse(const uint8_t *buf, size_t len, uint8_t *type, uint8_t *flags,
+                       size_t *body, size_t *body_len);
+
+/**
+ * @brief Match a topic against a filter with + and # wildcards
+ */
+bool client_mqtt_topic_matches(const char *filter, const char *topic, size_t topic_len);
+
+/* ============================================================================
+ * COAP MESSAGES (coap_packet.c)
+ * ========================================================================= */
+
+/**
+ * @brief Parsed CoAP message; pointers lead into the datagram
+ */
+typedef struct {
+    uint8_t type;                       /* CLIENT_COAP_CON ... CLIENT_COAP_RST */
+    uint8_t code;                       /* Class << 5 | detail, 0 = empty */
+    uint16_t mid;
+    uint8_t token_len;
+    const uint8_t *token;
+    const uint8_t *payload;
+    size_t payload_len;
+} client_coap_message_t;
+
+/**
+ * @brief Encoded size of a message with one Uri-Path option per segment
+ * @return Bytes, or 0 if a path segment exceeds 255 bytes
+ */
+size_t client_coap_encoded_size(const char *path, size_t token_len, size_t payload_len);
+
+/**
+ * @brief Encode a request or response
+ * @param path Slash-separated Uri-Path ("" = none); empty segments are skipped
+ * @return Bytes written, 0 if buf is too small or the path is invalid
+ */
+size_t client_coap_encode(uint8_t *buf, size_t size, uint8_t type, uint8_t code, uint16_t mid,
+                          const uint8_t *token, size_t token_len, const char *path,
+                          const uint8_t *payload, size_t payload_len);
+
+/**
+ * @brief Encode an empty ACK or RST (4 bytes)
+ */
+size_t client_coap_encode_empty(uint8_t *buf, uint8_t type, uint16_t mid);
+
+/**
+ * @brief Parse one datagram
+ * @return false if malformed
+ */
+bool client_coap_parse(const uint8_t *buf, size_t len, client_coap_message_t *msg);
+
+/* ============================================================================
+ * OFFLINE SPOOL (spool.c)
+ * ========================================================================= */
+
+/**
+ * @brief One spooled publish; pointers from peek point into the mapping
+ */
+typedef struct {
+    paumiot_qos_t qos;
+    bool retain;
+    const char *topic;                  /* Not NUL-terminated */
+    size_t topic_len;
+    const uint8_t *payload;
+    size_t payload_len;
+} client_spool_record_t;
+
+/**
+ * @brief Sent record waiting for its acknowledgement
+ */
+typedef struct {
+    uint64_t end;                       /* Offset just past the record */
+    bool acked;
+} client_spool_pending_t;
+
+/**
+ * @brief Publishes stored while disconnected, in a memory-mapped ring file
+ * @details Offsets only grow; a record at offset x lives at x % capacity.
+ *          [head, read) has been sent and awaits acknowledgement,
+ *          [read, tail) waits to be sent. Only head is persisted; tail is
+ *          found again after a crash by scanning CRC-checked records from
+ *          head. Guarded by the client lock.
+ */
+typedef struct {
+    int fd;
+    uint8_t *map;                       /* Header page, then the ring; NULL = no spool */
+    size_t capacity;                    /* Ring bytes */
+    uint64_t head;
+    uint64_t read;
+    uint64_t tail;
+    uint64_t commit_seq;                /* Generation of the newest header slot */
+    bool dirty;                         /* head moved since the last commit */
+    size_t records;                     /* Records in [head, tail) */
+
+    /* Records in [head, read), oldest first; ticket of pending[first] is base */
+    client_spool_pending_t *pending;
+    size_t pending_first;
+    size_t pending_count;
+    size_t pending_capacity;
+    uint64_t pending_base;
+} client_spool_t;
+
+/**
+ * @brief Map the spool file, creating it or recovering what it holds
+ * @param size Ring capacity in bytes; a file of another size starts empty
+ */
+paumiot_client_result_t client_spool_open(client_spool_t *spool, const char *path, size_t size);
+
+/**
+ * @brief Persist the head and unmap
+ */
+void client_spool_close(client_spool_t *spool);
+
+/**
+ * @brief Append a record
+ * @return false if the ring has no room for it
+ */
+bool client_spool_append(client_spool_t *spool, const client_spool_record_t *record);
+
+/**
+ * @brief Record at the read position
+ * @return false if everything has been sent
+ */
+bool client_spool_peek(client_spool_t *spool, client_spool_record_t *record);
+
+/**
+ * @brief Ticket that the next client_spool_take() returns
+ */
+uint64_t client_spool_next_ticket(const client_spool_t *spool);
+
+/**
+ * @brief Mark the peeked record sent
+ * @return Ticket to pass to client_spool_ack(), or 0 if out of memory
+ */
+uint64_t client_spool_take(client_spool_t *spool);
+
+/**
+ * @brief Acknowledge a sent record; head moves past every record that is
+ *        acknowledged along with all records before it
+ */
+void client_spool_ack(client_spool_t *spool, uint64_t ticket);
+
+/**
+ * @brief Forget sends that were never acknowledged, so they go again
+ */
+void client_spool_rewind(client_spool_t *spool);
+
+/**
+ * @brief Write head to the file if it moved
+ */
+void client_spool_commit(client_spool_t *spool);
+
+/* ============================================================================
+ * CLIENT STATE
+ * ========================================================================= */
+
+typedef enum {
+    INFLIGHT_FREE = 0,
+    INFLIGHT_PUBACK,                    /* QoS 1 PUBLISH sent */
+    INFLIGHT_PUBREC,                    /* QoS 2 PUBLISH sent */
+    INFLIGHT_PUBCOMP,                   /* QoS 2 PUBREL sent */
+    INFLIGHT_SUBACK,
+    INFLIGHT_UNSUBACK,
+    INFLIGHT_FAILED                     /* Connection lost, callback not run yet */
+} client_inflight_state_t;
+
+/**
+ * @brief One unacknowledged packet
+ * @details Slot i of the window holds packet IDs with (id - 1) % window == i,
+ *          so an acknowledgement finds its slot without a search.
+ */
+typedef struct {
+    uint16_t packet_id;
+    uint8_t state;                      /* client_inflight_state_t */
+    uint64_t seq;                       /* Message ID reported to the callback */
+    uint64_t spool_ticket;              /* Drained from the spool, 0 = live */
+    paumiot_publish_callback_t callback;
+    void *user_data;
+} client_inflight_t;
+
+/**
+ * @brief QoS 0 publish whose callback is due on the next loop pass
+ */
+typedef struct {
+    uint64_t seq;
+    paumiot_publish_callback_t callback;
+    void *user_data;
+    bool failed;                        /* Connection lost before the callback ran */
+} client_completion_t;
+
+typedef struct {
+    char *filter;
+    paumiot_qos_t qos;
+    paumiot_message_callback_t callback;
+    void *user_data;
+} client_subscription_t;
+
+typedef enum {
+    EXCHANGE_FREE = 0,
+    EXCHANGE_WAITING,                   /* Held back by NSTART */
+    EXCHANGE_SENT,                      /* Awaiting ACK (CON) or response (NON) */
+    EXCHANGE_ACKED,                     /* Empty ACK came; separate response awaited */
+    EXCHANGE_DONE                       /* Failed; callback not yet run */
+} client_exchange_state_t;
+
+/**
+ * @brief One CoAP request
+ * @details Slot i hands out tokens ending in i, so a response finds its
+ *          exchange without a search; empty ACKs and RSTs, which carry no
+ *          token, go through the message ID map.
+ */
+typedef struct {
+    uint8_t state;                      /* client_exchange_state_t */
+    bool confirmable;
+    bool queued;                        /* Index sits in the send ring */
+    uint8_t retransmits;
+    uint16_t mid;
+    uint8_t token[CLIENT_COAP_TOKEN_LEN];
+    paumiot_client_result_t result;     /* Outcome while EXCHANGE_DONE */
+
+    uint64_t timeout_ns;                /* Current retransmission timeout */
+    uint64_t deadline_ns;               /* Next retransmission or give-up time */
+    uint64_t expire_ns;                 /* Give up on a response */
+    int32_t wheel_bucket;               /* -1 = not on the wheel */
+    int32_t wheel_prev;
+    int32_t wheel_next;
+    int32_t next;                       /* Free, waiting or done list */
+
+    uint8_t *datagram;                  /* Kept for retransmission; reused */
+    size_t datagram_len;
+    size_t datagram_capacity;
+    paumiot_response_callback_t callback;
+    void *user_data;
+} client_exchange_t;
+
+/**
+ * @brief CoAP exchange table, timer wheel and send queues (lock held)
+ * @details Deadlines sit on a hashed wheel of CLIENT_COAP_WHEEL_SLOTS
+ *          buckets of CLIENT_COAP_TICK_MS; a bucket holds deadlines of every
+ *          lap and keeps the ones not yet due.
+ */
+typedef struct {
+    client_exchange_t *slots;
+    uint32_t mask;                      /* Slot count - 1 (a power of two) */
+    uint32_t window;                    /* max_inflight_messages */
+    uint32_t used;                      /* Slots not free */
+    uint32_t outstanding;               /* Sent or acked: counted against NSTART */
+    uint16_t next_mid;                  /* Per-endpoint message ID counter */
+    int32_t *mid_slots;                 /* Slot by mid & mid_mask, -1 = none */
+    uint32_t mid_mask;                  /* Map size - 1: at least twice the slots */
+    int32_t free_head;
+    int32_t wait_head;
+    int32_t wait_tail;
+    int32_t done_head;
+    int32_t done_tail;
+
+    uint32_t *send_ring;                /* Slot indices to (re)transmit */
+    uint32_t send_first;
+    uint32_t send_count;
+    uint8_t control[CLIENT_COAP_CONTROL_QUEUE][4];
+    uint32_t control_first;
+    uint32_t control_count;
+
+    int32_t wheel[CLIENT_COAP_WHEEL_SLOTS];
+    uint64_t wheel_tick;                /* Last tick processed */
+    uint32_t wheel_count;
+} client_coap_t;
+
+struct paumiot_client {
+    const paumiot_client_config_t *config;
+    char client_id[CLIENT_MAX_CLIENT_ID];
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;             /* Completion or state change */
+
+    /* Guarded by lock */
+    paumiot_connection_state_t state;
+    int fd;
+    bool broken;                        /* Write failed; the loop tears down */
+    uint32_t generation;                /* Bumped by every teardown */
+    client_buffer_t out;
+
+    client_inflight_t *inflight;
+    size_t window;                      /* max_inflight_messages */
+    size_t inflight_count;
+    uint16_t next_packet_id;
+    uint64_t next_seq;
+
+    client_completion_t *completions;
+    size_t completion_count;
+    size_t completion_capacity;
+
+    client_subscription_t *subs;
+    size_t sub_count;
+    size_t sub_capacity;
+
+    uint64_t last_tx_ns;
+    uint64_t ping_sent_ns;              /* 0 = no PINGREQ outstanding */
+    bool want_write;                    /* EPOLLOUT registered for fd */
+
+    client_spool_t spool;
+    client_coap_t *coap;                /* CoAP exchanges, NULL for MQTT */
+    uint64_t reconnect_at_ns;           /* Next automatic reconnect, 0 = none */
+    uint32_t reconnect_attempts;        /* Failed attempts since the connection was lost */
+    uint32_t reconnect_delay_ms;        /* Last backoff delay, 0 = none yet */
+    uint64_t random_state;              /* xorshift64 state for backoff jitter */
+
+    /* Automatic reconnect in progress, driven by the loop */
+    struct sockaddr_storage peer;       /* Last address connected to */
+    socklen_t peer_len;                 /* 0 = never connected */
+    int handshake_fd;                   /* -1 = none; not yet the client's fd */
+    uint64_t handshake_deadline_ns;     /* connect_timeout_ms after the start */
+    uint8_t handshake_out[CLIENT_CONNECT_MAX]; /* CONNECT packet */
+    size_t handshake_sent;              /* Bytes of it written */
+    size_t handshake_len;
+    uint8_t handshake_in[4];            /* CONNACK bytes read so far */
+    size_t handshake_read;
+
+    /* Event sources: socket (or handshake_fd), wakeup_fd and timer_fd, polled
+     * through epoll_fd */
+    int epoll_fd;                       /* Stable for the client's lifetime */
+    int wakeup_fd;                      /* eventfd: other threads wake the loop */
+    int timer_fd;                       /* timerfd: next keep-alive action */
+    atomic_bool wake_pending;           /* wakeup_fd written, not yet drained */
+
+    /* Loop thread only */
+    client_buffer_t in;
+    atomic_bool in_loop;                /* A paumiot_client_loop() call is running */
+    uint64_t timer_ns;                  /* timer_fd expiry, 0 = not armed */
+
+    /* Event loop membership: written under both the event loop's lock and
+     * the client lock, so either one suffices to read it */
+    paumiot_event_loop_t *event_loop;
+    size_t loop_slot;
+    paumiot_event_loop_t *own_loop;     /* Created by paumiot_client_loop_start() */
+    pthread_t thread;                   /* The event loop's thread, if it runs */
+    bool thread_running;
+};
+
+/* ============================================================================
+ * COAP EXCHANGES (coap.c)
+ * ========================================================================= */
+
+/**
+ * @brief Allocate the exchange table for a PAUMIOT_PROTOCOL_COAP client
+ */
+paumiot_client_result_t client_coap_create(paumiot_client_t *client);
+
+void client_coap_destroy(client_coap_t *coap);
+
+/**
+ * @brief Open a connected, non-blocking UDP socket to the gateway
+ */
+paumiot_client_result_t client_coap_open(paumiot_client_t *client, int *fd_out);
+
+/**
+ * @brief Start the timer wheel at the current time (lock held)
+ */
+void client_coap_reset_locked(paumiot_client_t *client);
+
+/**
+ * @brief Queue a request, sending it once NSTART allows (lock held)
+ * @return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK if max_inflight_messages
+ *         requests are already queued or outstanding
+ */
+paumiot_client_result_t client_coap_submit_locked(paumiot_client_t *client, uint8_t code,
+                                                  const char *path, const uint8_t *payload,
+                                                  size_t payload_len, bool confirmable,
+                                                  paumiot_response_callback_t callback,
+                                                  void *user_data);
+
+/**
+ * @brief Send queued datagrams with sendmmsg() (lock held)
+ * @details Keeps EPOLLOUT registered while datagrams are left over.
+ */
+void client_coap_flush_locked(paumiot_client_t *client);
+
+/**
+ * @brief Retransmit and time out exchanges whose deadline passed, then
+ *        run the callbacks of failed ones (loop thread, lock not held)
+ */
+void client_coap_expire(paumiot_client_t *client);
+
+/**
+ * @brief Earliest wheel tick holding a deadline (lock held)
+ * @return CLOCK_MONOTONIC nanoseconds, 0 if nothing is pending
+ */
+uint64_t client_coap_next_deadline_locked(const paumiot_client_t *client);
+
+/**
+ * @brief Read datagrams with recvmmsg() and complete their exchanges
+ *        (loop thread, lock not held)
+ * @return false if the socket failed
+ */
+bool client_coap_read(paumiot_client_t *client, uint32_t generation);
+
+/**
+ * @brief Fail every exchange with result (lock held); the callbacks run in
+ *        client_coap_run_done()
+ */
+void client_coap_fail_locked(paumiot_client_t *client, paumiot_client_result_t result);
+
+/**
+ * @brief Run the callbacks of failed exchanges (lock not held)
+ */
+void client_coap_run_done(paumiot_client_t *client);
+
+/* ============================================================================
+ * CONNECTION (connection.c)
+ * ========================================================================= */
+
+/**
+ * @brief Open the TCP connection and complete the MQTT handshake
+ * @details Blocks for at most connect_timeout_ms; leaves the socket
+ *          non-blocking. Called without the lock, before the client is
+ *          visible as connected. Remembers the address for reconnects.
+ */
+paumiot_client_result_t client_conn_open(paumiot_client_t *client, int *fd_out);
+
+/**
+ * @brief Start reconnecting to the address of the last connection (lock held)
+ * @details Never blocks: no name lookup, a non-blocking connect, and the
+ *          socket watched through epoll_fd as CLIENT_EVENT_HANDSHAKE.
+ *          client_conn_handshake() finishes it as events arrive.
+ * @return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK while the handshake runs,
+ *         PAUMIOT_CLIENT_SUCCESS with *fd_out set if there is none (CoAP),
+ *         or an error
+ */
+paumiot_client_result_t client_conn_begin(paumiot_client_t *client, int *fd_out);
+
+/**
+ * @brief Advance the reconnect handshake: CONNECT out, CONNACK in (lock held)
+ * @details Reads exactly the CONNACK, so the broker's next packets stay in
+ *          the socket for read_packets(). Closes handshake_fd on failure.
+ * @return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK until it is done, then
+ *         PAUMIOT_CLIENT_SUCCESS with *fd_out set (no longer watched), or
+ *         the error that ended it
+ */
+paumiot_client_result_t client_conn_handshake(paumiot_client_t *client, int *fd_out);
+
+/**
+ * @brief Give up the reconnect handshake and close its socket (lock held)
+ */
+void client_conn_abort(paumiot_client_t *client);
+
+/**
+ * @brief Write as much of the send buffer as the socket takes (lock held)
+ * @details Keeps EPOLLOUT registered exactly while bytes are left over, so
+ *          the loop wakes when the socket drains.
+ * @return false if the connection failed
+ */
+bool client_conn_flush(paumiot_client_t *client);
+
+/**
+ * @brief Make fd the client's socket and watch it through epoll_fd (lock held)
+ * @return false if epoll refused the socket
+ */
+bool client_conn_attach(paumiot_client_t *client, int fd);
+
+/**
+ * @brief Register for EPOLLOUT exactly while want is true (lock held)
+ */
+void client_conn_watch_writes(paumiot_client_t *client, bool want);
+
+/**
+ * @brief Stop watching and close the client's socket (lock held)
+ */
+void client_conn_close(paumiot_client_t *client);
+
+/**
+ * @brief Monotonic clock in nanoseconds
+ */
+uint64_t client_now_ns(void);
+
+/**
+ * @brief Next value of the client's xorshift64 generator (lock held)
+ */
+uint64_t client_random(paumiot_client_t *client);
+
+/**
+ * @brief Print a debug line if paumiot_client_set_debug(true)
+ */
+void client_debug(const char *fmt, ...);
+
+#endif /* PAUMIOT_CLIENT_INTERNAL_H */
@@ -0,0 +1,710 @@
+/**
+ * @file coap.c
+ * @brief CoAP request exchanges: token-indexed table, timer wheel, NSTART
+ * @details Every request occupies one slot of a flat exchange table, and
+ *          its token encodes the slot index. Message IDs come from one
+ *          counter, so an ID recurs only after 65536 requests (RFC 7252
+ *          4.5), and a map at least twice the table size leads an empty ACK
+ *          or RST back to its slot. Either way a reply finds its exchange
+ *          with one array access. Retransmission and give-up deadlines live on a hashed
+ *          timer wheel, so thousands of outstanding requests cost O(1) per
+ *          timer operation. At most coap_nstart requests are outstanding;
+ *          the rest wait in FIFO order. Datagrams leave in sendmmsg()
+ *          batches and arrive in recvmmsg() batches, one syscall for many
+ *          requests each way.
+ */
+
+#define _GNU_SOURCE                     /* sendmmsg, recvmmsg */
+#include "client_internal.h"
+#include <errno.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define COAP_MAX_RETRANSMIT 4
+#define COAP_TICK_NS ((uint64_t)CLIENT_COAP_TICK_MS * 1000000ull)
+#define COAP_MMSG_BATCH 64
+#define COAP_READS_PER_PASS 16
+#define COAP_DONE_BATCH 64
+#define COAP_CLASS_REQUEST 0
+
+/* ============================================================================
+ * TABLE
+ * ========================================================================= */
+
+paumiot_client_result_t client_coap_create(paumiot_client_t *client) {
+    client_coap_t *coap = (client_coap_t *)calloc(1, sizeof(*coap));
+    if (!coap) {
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    client->coap = coap;
+
+    uint32_t count = 1;
+    while (count < client->window) {
+        count <<= 1;
+    }
+    /* Twice the slots, so a free message ID is never far; the ID space caps it */
+    uint32_t mid_count = count < 0x8000 ? count * 2 : 0x10000;
+    coap->slots = (client_exchange_t *)calloc(count, sizeof(client_exchange_t));
+    coap->send_ring = (uint32_t *)malloc(count * sizeof(uint32_t));
+    coap->mid_slots = (int32_t *)malloc(mid_count * sizeof(int32_t));
+    if (!coap->slots || !coap->send_ring || !coap->mid_slots) {
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    coap->mask = count - 1;
+    coap->mid_mask = mid_count - 1;
+    coap->window = (uint32_t)client->window;
+    coap->next_mid = (uint16_t)client_random(client);   /* RFC 7252 4.4 */
+    for (uint32_t i = 0; i < mid_count; i++) {
+        coap->mid_slots[i] = -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        coap->slots[i].next = i + 1 < count ? (int32_t)(i + 1) : -1;
+        coap->slots[i].wheel_bucket = -1;
+    }
+    coap->free_head = 0;
+    coap->wait_head = coap->wait_tail = -1;
+    coap->done_head = coap->done_tail = -1;
+    for (size_t i = 0; i < CLIENT_COAP_WHEEL_SLOTS; i++) {
+        coap->wheel[i] = -1;
+    }
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+void client_coap_destroy(client_coap_t *coap) {
+    if (!coap) {
+        return;
+    }
+    if (coap->slots) {
+        for (uint32_t i = 0; i <= coap->mask; i++) {
+            free(coap->slots[i].datagram);
+        }
+    }
+    free(coap->slots);
+    free(coap->send_ring);
+    free(coap->mid_slots);
+    free(coap);
+}
+
+paumiot_client_result_t client_coap_open(paumiot_client_t *client, int *fd_out) {
+    const paumiot_client_config_t *config = client->config;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", config->port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo *list = NULL;
+    if (getaddrinfo(config->host, service, &hints, &list) != 0) {
+        client_debug("cannot resolve %s", config->host);
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+
+    /* Connected UDP: the kernel filters other senders and we use send() */
+    int fd = -1;
+    for (struct addrinfo *ai = list; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        } else if (fd >= 0) {
+            memcpy(&client->peer, ai->ai_addr, ai->ai_addrlen);
+            client->peer_len = ai->ai_addrlen;
+        }
+    }
+    freeaddrinfo(list);
+    if (fd < 0) {
+        client_debug("cannot reach %s:%u over UDP", config->host, config->port);
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+
+    client_debug("CoAP client bound to %s:%u", config->host, config->port);
+    *fd_out = fd;
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+void client_coap_reset_locked(paumiot_client_t *client) {
+    client->coap->wheel_tick = client_now_ns() / COAP_TICK_NS;
+}
+
+static void list_push(client_coap_t *coap, int32_t *head, int32_t *tail, int32_t index) {
+    coap->slots[index].next = -1;
+    if (*tail >= 0) {
+        coap->slots[*tail].next = index;
+    } else {
+        *head = index;
+    }
+    *tail = index;
+}
+
+static int32_t list_pop(client_coap_t *coap, int32_t *head, int32_t *tail) {
+    int32_t index = *head;
+    if (index >= 0) {
+        *head = coap->slots[index].next;
+        if (*head < 0) {
+            *tail = -1;
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief Exchange awaiting a reply to message ID mid
+ */
+static client_exchange_t *find_by_mid(client_coap_t *coap, uint16_t mid) {
+    int32_t index = coap->mid_slots[mid & coap->mid_mask];
+    if (index < 0) {
+        return NULL;
+    }
+    client_exchange_t *ex = &coap->slots[index];
+    return ex->mid == mid && (ex->state == EXCHANGE_SENT || ex->state == EXCHANGE_ACKED) ? ex
+                                                                                        : NULL;
+}
+
+/**
+ * @brief Exchange awaiting a response carrying token
+ */
+static client_exchange_t *find_by_token(client_coap_t *coap, const uint8_t *token,
+                                        size_t token_len) {
+    if (token_len != CLIENT_COAP_TOKEN_LEN) {
+        return NULL;
+    }
+    uint32_t index = ((uint32_t)token[6] << 8) | token[7];
+    if (index > coap->mask) {
+        return NULL;
+    }
+    client_exchange_t *ex = &coap->slots[index];
+    return (ex->state == EXCHANGE_SENT || ex->state == EXCHANGE_ACKED) &&
+                   memcmp(ex->token, token, CLIENT_COAP_TOKEN_LEN) == 0
+               ? ex
+               : NULL;
+}
+
+static int32_t index_of(const client_coap_t *coap, const client_exchange_t *ex) {
+    return (int32_t)(ex - coap->slots);
+}
+
+/**
+ * @brief Give slot index the next message ID whose map entry is free
+ * @details At most half the entries are taken, so few IDs are skipped and
+ *          an ID still recurs only after about 65536 requests.
+ */
+static uint16_t assign_mid(client_coap_t *coap, int32_t index) {
+    while (coap->mid_slots[coap->next_mid & coap->mid_mask] >= 0) {
+        coap->next_mid++;
+    }
+    uint16_t mid = coap->next_mid++;
+    coap->mid_slots[mid & coap->mid_mask] = index;
+    return mid;
+}
+
+/* ============================================================================
+ * TIMER WHEEL
+ * ========================================================================= */
+
+static void wheel_insert(client_coap_t *coap, int32_t index, uint64_t deadline_ns) {
+    client_exchange_t *ex = &coap->slots[index];
+    uint64_t tick = (deadline_ns + COAP_TICK_NS - 1) / COAP_TICK_NS;
+    if (tick <= coap->wheel_tick) {
+        tick = coap->wheel_tick + 1;
+    }
+    int32_t bucket = (int32_t)(tick & (CLIENT_COAP_WHEEL_SLOTS - 1));
+
+    ex->deadline_ns = deadline_ns;
+    ex->wheel_bucket = bucket;
+    ex->wheel_prev = -1;
+    ex->wheel_next = coap->wheel[bucket];
+    if (ex->wheel_next >= 0) {
+        coap->slots[ex->wheel_next].wheel_prev = index;
+    }
+    coap->wheel[bucket] = index;
+    coap->wheel_count++;
+}
+
+static void wheel_remove(client_coap_t *coap, int32_t index) {
+    client_exchange_t *ex = &coap->slots[index];
+    if (ex->wheel_bucket < 0) {
+        return;
+    }
+    if (ex->wheel_prev >= 0) {
+        coap->slots[ex->wheel_prev].wheel_next = ex->wheel_next;
+    } else {
+        coap->wheel[ex->wheel_bucket] = ex->wheel_next;
+    }
+    if (ex->wheel_next >= 0) {
+        coap->slots[ex->wheel_next].wheel_prev = ex->wheel_prev;
+    }
+    ex->wheel_bucket = -1;
+    coap->wheel_count--;
+}
+
+uint64_t client_coap_next_deadline_locked(const paumiot_client_t *client) {
+    const client_coap_t *coap = client->coap;
+    if (coap->wheel_count == 0) {
+        return 0;
+    }
+    for (uint64_t tick = coap->wheel_tick + 1;; tick++) {
+        if (coap->wheel[tick & (CLIENT_COAP_WHEEL_SLOTS - 1)] >= 0) {
+            return tick * COAP_TICK_NS;
+        }
+    }
+}
+
+/* ============================================================================
+ * EXCHANGES
+ * ========================================================================= */
+
+static uint64_t max_transmit_wait_ns(const paumiot_client_config_t *config) {
+    /* ACK_TIMEOUT * (2 ** (MAX_RETRANSMIT + 1) - 1) * ACK_RANDOM_FACTOR */
+    return (uint64_t)config->coap_ack_timeout_ms * 1000000ull *
+           ((1u << (COAP_MAX_RETRANSMIT + 1)) - 1) * 3 / 2;
+}
+
+static void queue_send(client_coap_t *coap, int32_t index) {
+    client_exchange_t *ex = &coap->slots[index];
+    if (!ex->queued) {
+        ex->queued = true;
+        coap->send_ring[(coap->send_first + coap->send_count) & coap->mask] = (uint32_t)index;
+        coap->send_count++;
+    }
+}
+
+static void queue_control(client_coap_t *coap, uint8_t type, uint16_t mid) {
+    if (coap->control_count == CLIENT_COAP_CONTROL_QUEUE) {
+        return;                         /* The peer retransmits */
+    }
+    uint32_t at = (coap->control_first + coap->control_count) % CLIENT_COAP_CONTROL_QUEUE;
+    client_coap_encode_empty(coap->control[at], type, mid);
+    coap->control_count++;
+}
+
+/**
+ * @brief Put a waiting request on the wire
+ */
+static void start_exchange(paumiot_client_t *client, int32_t index) {
+    client_coap_t *coap = client->coap;
+    client_exchange_t *ex = &coap->slots[index];
+    uint64_t now = client_now_ns();
+    uint64_t ack_ns = (uint64_t)client->config->coap_ack_timeout_ms * 1000000ull;
+
+    /* Initial timeout drawn from [ACK_TIMEOUT, ACK_TIMEOUT * 1.5] */
+    ex->state = EXCHANGE_SENT;
+    ex->timeout_ns = ack_ns + client_random(client) % (ack_ns / 2 + 1);
+    ex->expire_ns = now + max_transmit_wait_ns(client->config);
+    wheel_insert(coap, index, ex->confirmable ? now + ex->timeout_ns : ex->expire_ns);
+    queue_send(coap, index);
+    coap->outstanding++;
+}
+
+static void start_waiting(paumiot_client_t *client) {
+    client_coap_t *coap = client->coap;
+    while (coap->outstanding < client->config->coap_nstart && coap->wait_head >= 0) {
+        start_exchange(client, list_pop(coap, &coap->wait_head, &coap->wait_tail));
+    }
+}
+
+/**
+ * @brief Take an exchange off the wheel and out of the NSTART count
+ */
+static void finish_exchange(client_coap_t *coap, int32_t index) {
+    client_exchange_t *ex = &coap->slots[index];
+    wheel_remove(coap, index);
+    if (ex->state == EXCHANGE_SENT || ex->state == EXCHANGE_ACKED) {
+        coap->outstanding--;
+    }
+}
+
+/**
+ * @brief Return a slot to the free list; a stale send ring entry is skipped
+ */
+static void release_exchange(client_coap_t *coap, int32_t index) {
+    client_exchange_t *ex = &coap->slots[index];
+    coap->mid_slots[ex->mid & coap->mid_mask] = -1;
+    ex->state = EXCHANGE_FREE;
+    ex->callback = NULL;
+    ex->next = coap->free_head;
+    coap->free_head = index;
+    coap->used--;
+}
+
+static void fail_exchange(client_coap_t *coap, int32_t index, paumiot_client_result_t result) {
+    finish_exchange(coap, index);
+    coap->slots[index].state = EXCHANGE_DONE;
+    coap->slots[index].result = result;
+    list_push(coap, &coap->done_head, &coap->done_tail, index);
+}
+
+paumiot_client_result_t client_coap_submit_locked(paumiot_client_t *client, uint8_t code,
+                                                  const char *path, const uint8_t *payload,
+                                                  size_t payload_len, bool confirmable,
+                                                  paumiot_response_callback_t callback,
+                                                  void *user_data) {
+    client_coap_t *coap = client->coap;
+    size_t size = client_coap_encoded_size(path, CLIENT_COAP_TOKEN_LEN, payload_len);
+    if (size == 0) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (size > CLIENT_COAP_MAX_DATAGRAM) {
+        return PAUMIOT_CLIENT_ERROR_BUFFER_OVERFLOW;
+    }
+    if (coap->used == coap->window) {
+        return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK;
+    }
+
+    int32_t index = coap->free_head;
+    client_exchange_t *ex = &coap->slots[index];
+    if (ex->datagram_capacity < size) {
+        /* Grown once per slot; steady traffic reuses the buffer */
+        uint8_t *grown = (uint8_t *)realloc(ex->datagram, CLIENT_COAP_MAX_DATAGRAM);
+        if (!grown) {
+            return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+        }
+        ex->datagram = grown;
+        ex->datagram_capacity = CLIENT_COAP_MAX_DATAGRAM;
+    }
+    coap->free_head = ex->next;
+    coap->used++;
+
+    /* Token: 48 random bits, then the slot index */
+    uint64_t random = client_random(client);
+    memcpy(ex->token, &random, 6);
+    ex->token[6] = (uint8_t)(index >> 8);
+    ex->token[7] = (uint8_t)(index & 0xFF);
+    ex->mid = assign_mid(coap, index);
+
+    ex->datagram_len = client_coap_encode(ex->datagram, ex->datagram_capacity,
+                                          confirmable ? CLIENT_COAP_CON : CLIENT_COAP_NON, code,
+                                          ex->mid, ex->token, CLIENT_COAP_TOKEN_LEN, path,
+                                          payload, payload_len);
+    ex->confirmable = confirmable;
+    ex->retransmits = 0;
+    ex->callback = callback;
+    ex->user_data = user_data;
+    ex->state = EXCHANGE_WAITING;
+    list_push(coap, &coap->wait_head, &coap->wait_tail, index);
+    start_waiting(client);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+void client_coap_fail_locked(paumiot_client_t *client, paumiot_client_result_t result) {
+    client_coap_t *coap = client->coap;
+    for (uint32_t i = 0; i <= coap->mask; i++) {
+        client_exchange_t *ex = &coap->slots[i];
+        ex->queued = false;
+        if (ex->state != EXCHANGE_FREE && ex->state != EXCHANGE_DONE) {
+            fail_exchange(coap, (int32_t)i, result);
+        }
+    }
+    coap->wait_head = coap->wait_tail = -1;
+    coap->send_count = 0;
+    coap->control_count = 0;
+}
+
+void client_coap_run_done(paumiot_client_t *client) {
+    client_coap_t *coap = client->coap;
+    for (;;) {
+        struct {
+            paumiot_response_callback_t callback;
+            void *user_data;
+            paumiot_client_result_t result;
+        } batch[COAP_DONE_BATCH];
+        size_t n = 0;
+
+        pthread_mutex_lock(&client->lock);
+        while (n < COAP_DONE_BATCH && coap->done_head >= 0) {
+            int32_t index = list_pop(coap, &coap->done_head, &coap->done_tail);
+            client_exchange_t *ex = &coap->slots[index];
+            batch[n].callback = ex->callback;
+            batch[n].user_data = ex->user_data;
+            batch[n].result = ex->result;
+            n++;
+            release_exchange(coap, index);
+        }
+        if (client->fd >= 0) {
+            start_waiting(client);
+            client_coap_flush_locked(client);
+        }
+        pthread_mutex_unlock(&client->lock);
+        if (n == 0) {
+            return;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            if (batch[i].callback) {
+                batch[i].callback(client, batch[i].result, NULL, batch[i].user_data);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Act on an exchange whose deadline passed
+ */
+static void fire_deadline(paumiot_client_t *client, int32_t index, uint64_t now) {
+    client_coap_t *coap = client->coap;
+    client_exchange_t *ex = &coap->slots[index];
+
+    if (ex->state == EXCHANGE_SENT && ex->confirmable &&
+        ex->retransmits < COAP_MAX_RETRANSMIT) {
+        ex->retransmits++;
+        ex->timeout_ns *= 2;
+        wheel_insert(coap, index, now + ex->timeout_ns);
+        queue_send(coap, index);
+        return;
+    }
+    if (ex->state == EXCHANGE_SENT && ex->confirmable && now < ex->expire_ns) {
+        wheel_insert(coap, index, ex->expire_ns);   /* Last copy may still be answered */
+        return;
+    }
+    fail_exchange(coap, index, PAUMIOT_CLIENT_ERROR_TIMEOUT);
+}
+
+void client_coap_expire(paumiot_client_t *client) {
+    client_coap_t *coap = client->coap;
+    uint64_t now = client_now_ns();
+
+    pthread_mutex_lock(&client->lock);
+    uint64_t now_tick = now / COAP_TICK_NS;
+    if (client->fd >= 0 && now_tick > coap->wheel_tick) {
+        /* Collect what is due in the ticks passed, at most one lap */
+        uint64_t ticks = now_tick - coap->wheel_tick;
+        if (ticks > CLIENT_COAP_WHEEL_SLOTS) {
+            ticks = CLIENT_COAP_WHEEL_SLOTS;
+        }
+        int32_t due = -1;
+        for (uint64_t t = 1; t <= ticks; t++) {
+            int32_t index = coap->wheel[(coap->wheel_tick + t) & (CLIENT_COAP_WHEEL_SLOTS - 1)];
+            while (index >= 0) {
+                int32_t next = coap->slots[index].wheel_next;
+                if (coap->slots[index].deadline_ns <= now) {
+                    wheel_remove(coap, index);
+                    coap->slots[index].next = due;
+                    due = index;
+                }
+                index = next;
+            }
+        }
+
+        /* Advance first, so rescheduled deadlines land ahead of the cursor */
+        coap->wheel_tick = now_tick;
+        while (due >= 0) {
+            int32_t next = coap->slots[due].next;
+            fire_deadline(client, due, now);
+            due = next;
+        }
+    }
+    if (client->fd >= 0) {
+        client_coap_flush_locked(client);
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    client_coap_run_done(client);
+}
+
+/* ============================================================================
+ * DATAGRAM I/O
+ * ========================================================================= */
+
+/**
+ * @brief Drop sent entries from the front of the send queues
+ */
+static void pop_sent(client_coap_t *coap, size_t controls, size_t ring_entries) {
+    coap->control_first = (coap->control_first + (uint32_t)controls) % CLIENT_COAP_CONTROL_QUEUE;
+    coap->control_count -= (uint32_t)controls;
+    for (size_t i = 0; i < ring_entries; i++) {
+        coap->slots[coap->send_ring[coap->send_first]].queued = false;
+        coap->send_first = (coap->send_first + 1) & coap->mask;
+        coap->send_count--;
+    }
+}
+
+void client_coap_flush_locked(paumiot_client_t *client) {
+    client_coap_t *coap = client->coap;
+
+    while (coap->control_count > 0 || coap->send_count > 0) {
+        struct mmsghdr msgs[COAP_MMSG_BATCH];
+        struct iovec iov[COAP_MMSG_BATCH];
+        size_t ring_used[COAP_MMSG_BATCH];  /* Ring entries covered through message i */
+        size_t n = 0;
+        size_t controls = 0;
+        size_t ring = 0;
+
+        while (controls < coap->control_count && n < COAP_MMSG_BATCH) {
+            iov[n].iov_base =
+                coap->control[(coap->control_first + controls) % CLIENT_COAP_CONTROL_QUEUE];
+            iov[n].iov_len = 4;
+            ring_used[n++] = 0;
+            controls++;
+        }
+        while (ring < coap->send_count && n < COAP_MMSG_BATCH) {
+            client_exchange_t *ex =
+                &coap->slots[coap->send_ring[(coap->send_first + ring) & coap->mask]];
+            ring++;
+            if (ex->state != EXCHANGE_SENT) {
+                continue;               /* Finished or acknowledged since it was queued */
+            }
+            iov[n].iov_base = ex->datagram;
+            iov[n].iov_len = ex->datagram_len;
+            ring_used[n++] = ring;
+        }
+        if (n == 0) {
+            pop_sent(coap, 0, ring);
+            continue;
+        }
+
+        memset(msgs, 0, n * sizeof(msgs[0]));
+        for (size_t i = 0; i < n; i++) {
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(client->fd, msgs, (unsigned int)n, MSG_NOSIGNAL);
+        bool dropped = false;
+        if (sent < 0) {
+            if (errno == EINTR || errno == ECONNREFUSED) {
+                continue;               /* ICMP from an earlier datagram: retry */
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;                  /* The loop finishes on EPOLLOUT */
+            }
+            client_debug("CoAP send failed: %s", strerror(errno));
+            sent = 1;                   /* Drop it; CON requests go again */
+            dropped = true;
+        }
+
+        size_t done = (size_t)sent;
+        if (done == n) {
+            pop_sent(coap, controls, ring);
+            continue;
+        }
+        pop_sent(coap, done < controls ? done : controls,
+                 done > controls ? ring_used[done - 1] : 0);
+        if (!dropped) {
+            break;                      /* Socket buffer full */
+        }
+    }
+    client_conn_watch_writes(client, coap->control_count > 0 || coap->send_count > 0);
+}
+
+/**
+ * @brief Match one datagram from the gateway
+ * @return true if an exchange finished; its callback and result are filled
+ */
+static bool handle_datagram(paumiot_client_t *client, const client_coap_message_t *msg,
+                            paumiot_response_callback_t *callback, void **user_data,
+                            paumiot_client_result_t *result) {
+    client_coap_t *coap = client->coap;
+    client_exchange_t *ex;
+
+    if (msg->type == CLIENT_COAP_RST) {
+        ex = find_by_mid(coap, msg->mid);
+        *result = PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    } else if (msg->code == 0) {
+        /* Empty ACK: a separate response follows; stop retransmitting */
+        ex = msg->type == CLIENT_COAP_ACK ? find_by_mid(coap, msg->mid) : NULL;
+        if (ex && ex->state == EXCHANGE_SENT && ex->confirmable) {
+            int32_t index = index_of(coap, ex);
+            wheel_remove(coap, index);
+            ex->state = EXCHANGE_ACKED;
+            wheel_insert(coap, index, ex->expire_ns);
+        }
+        return false;
+    } else if ((msg->code >> 5) == COAP_CLASS_REQUEST) {
+        if (msg->type == CLIENT_COAP_CON) {
+            queue_control(coap, CLIENT_COAP_RST, msg->mid);    /* We serve nothing */
+        }
+        return false;
+    } else {
+        /* Acknowledge every confirmable response, including duplicates of
+         * one already handled whose ACK was lost */
+        if (msg->type == CLIENT_COAP_CON) {
+            queue_control(coap, CLIENT_COAP_ACK, msg->mid);
+        }
+        ex = find_by_token(coap, msg->token, msg->token_len);
+        if (ex && msg->type == CLIENT_COAP_ACK && ex->mid != msg->mid) {
+            ex = NULL;
+        }
+        *result = PAUMIOT_CLIENT_SUCCESS;
+    }
+    if (!ex) {
+        return false;
+    }
+
+    int32_t index = index_of(coap, ex);
+    *callback = ex->callback;
+    *user_data = ex->user_data;
+    finish_exchange(coap, index);
+    release_exchange(coap, index);
+    start_waiting(client);
+    return true;
+}
+
+bool client_coap_read(paumiot_client_t *client, uint32_t generation) {
+    client_buffer_t *in = &client->in;
+    size_t batch = in->size / CLIENT_COAP_RECV_CHUNK;
+    if (batch > COAP_MMSG_BATCH) {
+        batch = COAP_MMSG_BATCH;
+    }
+
+    for (int reads = 0; reads < COAP_READS_PER_PASS; reads++) {
+        struct mmsghdr msgs[COAP_MMSG_BATCH];
+        struct iovec iov[COAP_MMSG_BATCH];
+        memset(msgs, 0, batch * sizeof(msgs[0]));
+        for (size_t i = 0; i < batch; i++) {
+            iov[i].iov_base = in->data + i * CLIENT_COAP_RECV_CHUNK;
+            iov[i].iov_len = CLIENT_COAP_RECV_CHUNK;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int n = recvmmsg(client->fd, msgs, (unsigned int)batch, MSG_DONTWAIT, NULL);
+        if (n < 0) {
+            if (errno == EINTR || errno == ECONNREFUSED) {
+                continue;               /* Port unreachable: requests time out */
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        for (int i = 0; i < n; i++) {
+            client_coap_message_t msg;
+            if ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ||
+                !client_coap_parse((const uint8_t *)iov[i].iov_base, msgs[i].msg_len, &msg)) {
+                continue;
+            }
+            paumiot_response_callback_t callback = NULL;
+            void *user_data = NULL;
+            paumiot_client_result_t result = PAUMIOT_CLIENT_SUCCESS;
+
+            pthread_mutex_lock(&client->lock);
+            bool same = client->generation == generation;
+            bool finished = same && handle_datagram(client, &msg, &callback, &user_data, &result);
+            pthread_mutex_unlock(&client->lock);
+            if (!same) {
+                return true;            /* A callback disconnected */
+            }
+
+            if (finished && callback) {
+                paumiot_coap_response_t response = { msg.code, msg.payload, msg.payload_len };
+                callback(client, result,
+                         result == PAUMIOT_CLIENT_SUCCESS ? &response : NULL, user_data);
+            }
+        }
+
+        /* ACKs and the requests NSTART let through leave together */
+        pthread_mutex_lock(&client->lock);
+        if (client->generation == generation) {
+            client_coap_flush_locked(client);
+        }
+        pthread_mutex_unlock(&client->lock);
+        if ((size_t)n < batch) {
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file coap_packet.c
+ * @brief CoAP (RFC 7252) message encoding and parsing for the client plugin
+ */
+
+#include "client_internal.h"
+#include <string.h>
+
+#define COAP_VERSION 1
+#define COAP_OPTION_URI_PATH 11
+#define COAP_PAYLOAD_MARKER 0xFF
+#define COAP_MAX_SEGMENT 255            /* Uri-Path option length limit */
+
+/**
+ * @brief Bytes of the extended delta or length for a 4-bit field value
+ */
+static size_t option_extension(size_t value) {
+    return value < 13 ? 0 : value < 269 ? 1 : 2;
+}
+
+static uint8_t option_nibble(size_t value) {
+    return (uint8_t)(value < 13 ? value : value < 269 ? 13 : 14);
+}
+
+static size_t put_extension(uint8_t *buf, size_t value) {
+    if (value < 13) {
+        return 0;
+    }
+    if (value < 269) {
+        buf[0] = (uint8_t)(value - 13);
+        return 1;
+    }
+    buf[0] = (uint8_t)((value - 269) >> 8);
+    buf[1] = (uint8_t)((value - 269) & 0xFF);
+    return 2;
+}
+
+/**
+ * @brief Length of the path segment starting at path
+ */
+static size_t segment_length(const char *path) {
+    const char *slash = strchr(path, '/');
+    return slash ? (size_t)(slash - path) : strlen(path);
+}
+
+size_t client_coap_encoded_size(const char *path, size_t token_len, size_t payload_len) {
+    size_t size = 4 + token_len + (payload_len > 0 ? 1 + payload_len : 0);
+    bool first = true;
+
+    for (const char *p = path; *p != '\0';) {
+        size_t len = segment_length(p);
+        if (len > COAP_MAX_SEGMENT) {
+            return 0;
+        }
+        if (len > 0) {
+            size += 1 + option_extension(first ? COAP_OPTION_URI_PATH : 0) +
+                    option_extension(len) + len;
+            first = false;
+        }
+        p += len + (p[len] == '/' ? 1 : 0);
+    }
+    return size;
+}
+
+size_t client_coap_encode(uint8_t *buf, size_t size, uint8_t type, uint8_t code, uint16_t mid,
+                          const uint8_t *token, size_t token_len, const char *path,
+                          const uint8_t *payload, size_t payload_len) {
+    size_t total = client_coap_encoded_size(path, token_len, payload_len);
+    if (total == 0 || total > size || token_len > 8) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    buf[pos++] = (uint8_t)((COAP_VERSION << 6) | (type << 4) | token_len);
+    buf[pos++] = code;
+    buf[pos++] = (uint8_t)(mid >> 8);
+    buf[pos++] = (uint8_t)(mid & 0xFF);
+    memcpy(buf + pos, token, token_len);
+    pos += token_len;
+
+    /* One Uri-Path option per non-empty segment; all but the first repeat
+     * the option number, so their delta is 0 */
+    size_t delta = COAP_OPTION_URI_PATH;
+    for (const char *p = path; *p != '\0';) {
+        size_t len = segment_length(p);
+        if (len > 0) {
+            buf[pos++] = (uint8_t)((option_nibble(delta) << 4) | option_nibble(len));
+            pos += put_extension(buf + pos, delta);
+            pos += put_extension(buf + pos, len);
+            memcpy(buf + pos, p, len);
+            pos += len;
+            delta = 0;
+        }
+        p += len + (p[len] == '/' ? 1 : 0);
+    }
+
+    if (payload_len > 0) {
+        buf[pos++] = COAP_PAYLOAD_MARKER;
+        memcpy(buf + pos, payload, payload_len);
+        pos += payload_len;
+    }
+    return pos;
+}
+
+size_t client_coap_encode_empty(uint8_t *buf, uint8_t type, uint16_t mid) {
+    buf[0] = (uint8_t)((COAP_VERSION << 6) | (type << 4));
+    buf[1] = 0;
+    buf[2] = (uint8_t)(mid >> 8);
+    buf[3] = (uint8_t)(mid & 0xFF);
+    return 4;
+}
+
+/**
+ * @brief Read an extended option delta or length
+ * @return false if the field is reserved (15) or runs past the end
+ */
+static bool read_extension(const uint8_t *buf, size_t len, size_t *pos, uint8_t nibble,
+                           size_t *value) {
+    if (nibble < 13) {
+        *value = nibble;
+    } else if (nibble == 13) {
+        if (*pos + 1 > len) {
+            return false;
+        }
+        *value = 13 + (size_t)buf[*pos];
+        *pos += 1;
+    } else if (nibble == 14) {
+        if (*pos + 2 > len) {
+            return false;
+        }
+        *value = 269 + (((size_t)buf[*pos] << 8) | buf[*pos + 1]);
+        *pos += 2;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool client_coap_parse(const uint8_t *buf, size_t len, client_coap_message_t *msg) {
+    if (len < 4 || (buf[0] >> 6) != COAP_VERSION) {
+        return false;
+    }
+    msg->type = (uint8_t)((buf[0] >> 4) & 0x03);
+    msg->token_len = (uint8_t)(buf[0] & 0x0F);
+    msg->code = buf[1];
+    msg->mid = (uint16_t)((buf[2] << 8) | buf[3]);
+    if (msg->token_len > 8 || 4 + (size_t)msg->token_len > len) {
+        return false;
+    }
+    msg->token = buf + 4;
+    msg->payload = NULL;
+    msg->payload_len = 0;
+
+    /* Options are skipped; responses are matched by token alone */
+    size_t pos = 4 + msg->token_len;
+    while (pos < len) {
+        uint8_t byte = buf[pos++];
+        if (byte == COAP_PAYLOAD_MARKER) {
+            if (pos == len) {
+                return false;           /* Marker without payload */
+            }
+            msg->payload = buf + pos;
+            msg->payload_len = len - pos;
+            return true;
+        }
+        size_t delta;
+        size_t option_len;
+        if (!read_extension(buf, len, &pos, byte >> 4, &delta) ||
+            !read_extension(buf, len, &pos, byte & 0x0F, &option_len) ||
+            option_len > len - pos) {
+            return false;
+        }
+        pos += option_len;
+    }
+    return msg->code != 0 || (msg->token_len == 0 && len == 4);
+}
@@ -0,0 +1,437 @@
+/**
+ * @file connection.c
+ * @brief Connection management: TCP connect, MQTT handshake, socket writes
+ */
+
+#include "client_internal.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* CONNACK return codes */
+#define CONNACK_ACCEPTED 0
+#define CONNACK_BAD_CREDENTIALS 4
+#define CONNACK_NOT_AUTHORIZED 5
+
+static bool g_debug = false;
+
+void paumiot_client_set_debug(bool enable) {
+    g_debug = enable;
+}
+
+void client_debug(const char *fmt, ...) {
+    if (!g_debug) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "[paumiot-client] ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+uint64_t client_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t client_random(paumiot_client_t *client) {
+    uint64_t x = client->random_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    client->random_state = x;
+    return x;
+}
+
+/**
+ * @brief Milliseconds left until deadline_ns, at least 0
+ */
+static int remaining_ms(uint64_t deadline_ns) {
+    uint64_t now = client_now_ns();
+    return now >= deadline_ns ? 0 : (int)((deadline_ns - now + 999999) / 1000000);
+}
+
+/**
+ * @brief Wait for events on fd until the deadline
+ * @return true if an event arrived
+ */
+static bool wait_fd(int fd, short events, uint64_t deadline_ns) {
+    struct pollfd pfd = { .fd = fd, .events = events, .revents = 0 };
+    for (;;) {
+        int rc = poll(&pfd, 1, remaining_ms(deadline_ns));
+        if (rc > 0) {
+            return true;
+        }
+        if (rc == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+/* Small packets go out at once; batching is the caller's job */
+static void set_nodelay(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/**
+ * @brief Non-blocking connect to the first address that answers
+ */
+static int tcp_connect(paumiot_client_t *client, uint64_t deadline_ns) {
+    const char *host = client->config->host;
+    uint16_t port = client->config->port;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *list = NULL;
+    if (getaddrinfo(host, service, &hints, &list) != 0) {
+        client_debug("cannot resolve %s", host);
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *ai = list; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        int err = connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 ? 0 : errno;
+        if (err == EINPROGRESS && wait_fd(fd, POLLOUT, deadline_ns)) {
+            socklen_t len = sizeof(err);
+            if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0) {
+                err = errno;
+            }
+        }
+        if (err == 0) {
+            memcpy(&client->peer, ai->ai_addr, ai->ai_addrlen);
+            client->peer_len = ai->ai_addrlen;
+            break;
+        }
+        client_debug("connect to %s:%u failed: %s", host, port, strerror(err));
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(list);
+
+    if (fd >= 0) {
+        set_nodelay(fd);
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const uint8_t *data, size_t len, uint64_t deadline_ns) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!wait_fd(fd, POLLOUT, deadline_ns)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Outcome of the CONNACK in the first len bytes of buf
+ * @return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK if more bytes are needed
+ */
+static paumiot_client_result_t parse_connack(const uint8_t *buf, size_t len) {
+    uint8_t type;
+    uint8_t flags;
+    size_t body;
+    size_t body_len;
+    long packet = client_mqtt_parse(buf, len, &type, &flags, &body, &body_len);
+    if (packet < 0 || (packet > 0 && (type != CLIENT_MQTT_CONNACK || body_len != 2))) {
+        return PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    }
+    if (packet == 0) {
+        return len < 4 ? PAUMIOT_CLIENT_ERROR_WOULD_BLOCK : PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    }
+    switch (buf[body + 1]) {
+    case CONNACK_ACCEPTED:
+        return PAUMIOT_CLIENT_SUCCESS;
+    case CONNACK_BAD_CREDENTIALS:
+        return PAUMIOT_CLIENT_ERROR_AUTHENTICATION_FAILED;
+    case CONNACK_NOT_AUTHORIZED:
+        return PAUMIOT_CLIENT_ERROR_AUTHORIZATION_FAILED;
+    default:
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+}
+
+/**
+ * @brief Read until a complete CONNACK arrives
+ * @details Reads exactly its four bytes, so nothing the broker sends next is
+ *          consumed here.
+ */
+static paumiot_client_result_t read_connack(int fd, uint64_t deadline_ns) {
+    uint8_t buf[4];
+    size_t len = 0;
+
+    for (;;) {
+        paumiot_client_result_t result = parse_connack(buf, len);
+        if (result != PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+            return result;
+        }
+
+        ssize_t n = recv(fd, buf + len, sizeof(buf) - len, 0);
+        if (n > 0) {
+            len += (size_t)n;
+        } else if (n == 0) {
+            return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (!wait_fd(fd, POLLIN, deadline_ns)) {
+                return PAUMIOT_CLIENT_ERROR_TIMEOUT;
+            }
+        } else if (errno != EINTR) {
+            return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+        }
+    }
+}
+
+static size_t encode_connect(const paumiot_client_t *client, uint8_t *packet, size_t size) {
+    const paumiot_client_config_t *config = client->config;
+    uint32_t keepalive_s = (config->keepalive_interval_ms + 999) / 1000;
+    return client_mqtt_encode_connect(packet, size, client->client_id, config->username,
+                                      config->password,
+                                      (uint16_t)(keepalive_s > 0xFFFF ? 0xFFFF : keepalive_s));
+}
+
+paumiot_client_result_t client_conn_open(paumiot_client_t *client, int *fd_out) {
+    const paumiot_client_config_t *config = client->config;
+    uint64_t deadline = client_now_ns() + (uint64_t)config->connect_timeout_ms * 1000000ull;
+
+    int fd = tcp_connect(client, deadline);
+    if (fd < 0) {
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+
+    uint8_t packet[CLIENT_CONNECT_MAX];
+    size_t len = encode_connect(client, packet, sizeof(packet));
+    if (len == 0) {
+        close(fd);
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (!send_all(fd, packet, len, deadline)) {
+        close(fd);
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+
+    paumiot_client_result_t result = read_connack(fd, deadline);
+    if (result != PAUMIOT_CLIENT_SUCCESS) {
+        client_debug("handshake with %s:%u failed: %s", config->host, config->port,
+                     paumiot_client_error_string(result));
+        close(fd);
+        return result;
+    }
+
+    client_debug("connected to %s:%u as %s", config->host, config->port, client->client_id);
+    *fd_out = fd;
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+paumiot_client_result_t client_conn_begin(paumiot_client_t *client, int *fd_out) {
+    const paumiot_client_config_t *config = client->config;
+    if (client->peer_len == 0) {
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+    int type = client->coap ? SOCK_DGRAM : SOCK_STREAM;
+    int fd = socket(client->peer.ss_family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+    if (connect(fd, (const struct sockaddr *)&client->peer, client->peer_len) != 0 &&
+        errno != EINPROGRESS) {
+        client_debug("connect to %s:%u failed: %s", config->host, config->port,
+                     strerror(errno));
+        close(fd);
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+    if (client->coap) {
+        *fd_out = fd;                   /* Connected UDP: nothing to wait for */
+        return PAUMIOT_CLIENT_SUCCESS;
+    }
+
+    client->handshake_len = encode_connect(client, client->handshake_out,
+                                           sizeof(client->handshake_out));
+    if (client->handshake_len == 0) {
+        close(fd);
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    struct epoll_event ev = { .events = EPOLLOUT, .data.u32 = CLIENT_EVENT_HANDSHAKE };
+    if (epoll_ctl(client->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        close(fd);
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+    set_nodelay(fd);
+    client->handshake_fd = fd;
+    client->handshake_sent = 0;
+    client->handshake_read = 0;
+    client->handshake_deadline_ns =
+        client_now_ns() + (uint64_t)config->connect_timeout_ms * 1000000ull;
+    return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK;
+}
+
+void client_conn_abort(paumiot_client_t *client) {
+    epoll_ctl(client->epoll_fd, EPOLL_CTL_DEL, client->handshake_fd, NULL);
+    close(client->handshake_fd);
+    client->handshake_fd = -1;
+}
+
+/**
+ * @brief Write the rest of the CONNECT packet once the connect completed
+ * @return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK if the socket is not ready for it
+ */
+static paumiot_client_result_t handshake_send(paumiot_client_t *client) {
+    int fd = client->handshake_fd;
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+        client_debug("connect to %s:%u failed: %s", client->config->host, client->config->port,
+                     strerror(err ? err : errno));
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+    while (client->handshake_sent < client->handshake_len) {
+        ssize_t n = send(fd, client->handshake_out + client->handshake_sent,
+                         client->handshake_len - client->handshake_sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            client->handshake_sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN)) {
+            return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK;
+        } else {
+            return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+        }
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = CLIENT_EVENT_HANDSHAKE };
+    if (epoll_ctl(client->epoll_fd, EPOLL_CTL_MOD, fd, &ev) != 0) {
+        return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+    }
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+/**
+ * @brief Read the CONNACK, no further
+ * @return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK if it is not complete yet
+ */
+static paumiot_client_result_t handshake_recv(paumiot_client_t *client) {
+    for (;;) {
+        paumiot_client_result_t result = parse_connack(client->handshake_in,
+                                                       client->handshake_read);
+        if (result != PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+            return result;
+        }
+        ssize_t n = recv(client->handshake_fd, client->handshake_in + client->handshake_read,
+                         sizeof(client->handshake_in) - client->handshake_read, 0);
+        if (n > 0) {
+            client->handshake_read += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return PAUMIOT_CLIENT_ERROR_WOULD_BLOCK;
+        } else {
+            return PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED;
+        }
+    }
+}
+
+paumiot_client_result_t client_conn_handshake(paumiot_client_t *client, int *fd_out) {
+    paumiot_client_result_t result = client->handshake_sent < client->handshake_len
+                                         ? handshake_send(client)
+                                         : PAUMIOT_CLIENT_SUCCESS;
+    if (result == PAUMIOT_CLIENT_SUCCESS) {
+        result = handshake_recv(client);
+    }
+    if (result == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+        return result;
+    }
+
+    const paumiot_client_config_t *config = client->config;
+    if (result != PAUMIOT_CLIENT_SUCCESS) {
+        client_debug("handshake with %s:%u failed: %s", config->host, config->port,
+                     paumiot_client_error_string(result));
+        client_conn_abort(client);
+        return result;
+    }
+    client_debug("reconnected to %s:%u as %s", config->host, config->port, client->client_id);
+    epoll_ctl(client->epoll_fd, EPOLL_CTL_DEL, client->handshake_fd, NULL);
+    *fd_out = client->handshake_fd;
+    client->handshake_fd = -1;
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+void client_conn_watch_writes(paumiot_client_t *client, bool want) {
+    if (want == client->want_write) {
+        return;
+    }
+    struct epoll_event ev = { .events = EPOLLIN | (want ? EPOLLOUT : 0),
+                              .data.u32 = CLIENT_EVENT_SOCKET };
+    if (epoll_ctl(client->epoll_fd, EPOLL_CTL_MOD, client->fd, &ev) == 0) {
+        client->want_write = want;
+    }
+}
+
+bool client_conn_attach(paumiot_client_t *client, int fd) {
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = CLIENT_EVENT_SOCKET };
+    if (epoll_ctl(client->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        return false;
+    }
+    client->fd = fd;
+    client->want_write = false;
+    return true;
+}
+
+void client_conn_close(paumiot_client_t *client) {
+    epoll_ctl(client->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    client->fd = -1;
+    client->want_write = false;
+}
+
+bool client_conn_flush(paumiot_client_t *client) {
+    client_buffer_t *out = &client->out;
+    while (client_buffer_used(out) > 0) {
+        ssize_t n = send(client->fd, out->data + out->start, client_buffer_used(out),
+                         MSG_NOSIGNAL);
+        if (n > 0) {
+            client_buffer_consume(out, (size_t)n);
+            client->last_tx_ns = client_now_ns();
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;                      /* The loop finishes on EPOLLOUT */
+        } else {
+            client_debug("send failed: %s", strerror(errno));
+            return false;
+        }
+    }
+    client_conn_watch_writes(client, client_buffer_used(out) > 0);
+    return true;
+}
@@ -0,0 +1,320 @@
+/**
+ * @file event_loop.c
+ * @brief One thread serving many clients through nested epoll
+ * @details Every client already gathers its socket, wakeup eventfd and
+ *          keep-alive timerfd behind its own epoll descriptor. The event
+ *          loop waits on those descriptors, one per client, and runs a
+ *          non-blocking paumiot_client_loop() pass for each one that polls
+ *          readable, so an idle client costs nothing per iteration and no
+ *          timeouts need to be tracked here.
+ */
+
+#include "client_internal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define EVENT_BATCH 64
+#define WAKEUP_TOKEN UINT64_MAX
+
+/**
+ * @brief Attached client; gen is bumped on detach, so events still queued
+ *        for a detached client are recognised as stale
+ */
+typedef struct {
+    paumiot_client_t *client;
+    uint32_t gen;
+} loop_slot_t;
+
+struct paumiot_event_loop {
+    int epoll_fd;
+    int wakeup_fd;                      /* eventfd: stop the I/O thread */
+
+    pthread_mutex_t lock;               /* Held while dispatching */
+    loop_slot_t *slots;
+    size_t slot_count;
+    size_t slot_capacity;
+
+    pthread_t thread;
+    bool thread_running;
+    atomic_bool stop;
+    atomic_bool in_run;
+};
+
+/* Loop whose lock this thread holds while dispatching, so attach and
+ * detach from a client callback do not take it again */
+static __thread paumiot_event_loop_t *t_dispatching;
+
+static uint64_t slot_token(const paumiot_event_loop_t *loop, size_t index) {
+    return ((uint64_t)loop->slots[index].gen << 32) | index;
+}
+
+static void lock_loop(paumiot_event_loop_t *loop) {
+    if (t_dispatching != loop) {
+        pthread_mutex_lock(&loop->lock);
+    }
+}
+
+static void unlock_loop(paumiot_event_loop_t *loop) {
+    if (t_dispatching != loop) {
+        pthread_mutex_unlock(&loop->lock);
+    }
+}
+
+/**
+ * @brief Tell a client which thread serves it (loop lock held)
+ */
+static void set_client_thread(paumiot_client_t *client, const paumiot_event_loop_t *loop) {
+    pthread_mutex_lock(&client->lock);
+    client->thread_running = loop && loop->thread_running;
+    if (client->thread_running) {
+        client->thread = loop->thread;
+    }
+    pthread_mutex_unlock(&client->lock);
+}
+
+paumiot_event_loop_t *paumiot_event_loop_create(void) {
+    paumiot_event_loop_t *loop = (paumiot_event_loop_t *)calloc(1, sizeof(*loop));
+    if (!loop) {
+        return NULL;
+    }
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    pthread_mutex_init(&loop->lock, NULL);
+    atomic_init(&loop->stop, false);
+    atomic_init(&loop->in_run, false);
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = WAKEUP_TOKEN };
+    if (loop->epoll_fd < 0 || loop->wakeup_fd < 0 ||
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->wakeup_fd, &ev) != 0) {
+        paumiot_event_loop_destroy(loop);
+        return NULL;
+    }
+    return loop;
+}
+
+void paumiot_event_loop_destroy(paumiot_event_loop_t *loop) {
+    if (!loop) {
+        return;
+    }
+    paumiot_event_loop_stop(loop);
+
+    pthread_mutex_lock(&loop->lock);
+    for (size_t i = 0; i < loop->slot_count; i++) {
+        paumiot_client_t *client = loop->slots[i].client;
+        if (client) {
+            pthread_mutex_lock(&client->lock);
+            client->event_loop = NULL;
+            client->thread_running = false;
+            pthread_mutex_unlock(&client->lock);
+        }
+    }
+    pthread_mutex_unlock(&loop->lock);
+
+    if (loop->epoll_fd >= 0) {
+        close(loop->epoll_fd);
+    }
+    if (loop->wakeup_fd >= 0) {
+        close(loop->wakeup_fd);
+    }
+    free(loop->slots);
+    pthread_mutex_destroy(&loop->lock);
+    free(loop);
+}
+
+paumiot_client_result_t paumiot_event_loop_add(paumiot_event_loop_t *loop,
+                                               paumiot_client_t *client) {
+    if (!loop || !client) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    lock_loop(loop);
+    pthread_mutex_lock(&client->lock);
+    bool attached = client->event_loop != NULL;
+    pthread_mutex_unlock(&client->lock);
+    if (attached) {
+        unlock_loop(loop);
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    size_t index = 0;
+    while (index < loop->slot_count && loop->slots[index].client) {
+        index++;
+    }
+    if (index == loop->slot_capacity) {
+        size_t capacity = loop->slot_capacity ? loop->slot_capacity * 2 : 16;
+        loop_slot_t *grown = (loop_slot_t *)realloc(loop->slots, capacity * sizeof(loop_slot_t));
+        if (!grown) {
+            unlock_loop(loop);
+            return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+        }
+        memset(grown + loop->slot_capacity, 0,
+               (capacity - loop->slot_capacity) * sizeof(loop_slot_t));
+        loop->slots = grown;
+        loop->slot_capacity = capacity;
+    }
+    if (index == loop->slot_count) {
+        loop->slot_count++;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = slot_token(loop, index) };
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, client->epoll_fd, &ev) != 0) {
+        unlock_loop(loop);
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    loop->slots[index].client = client;
+
+    pthread_mutex_lock(&client->lock);
+    client->event_loop = loop;
+    client->loop_slot = index;
+    pthread_mutex_unlock(&client->lock);
+    set_client_thread(client, loop);
+    unlock_loop(loop);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+paumiot_client_result_t paumiot_event_loop_remove(paumiot_event_loop_t *loop,
+                                                  paumiot_client_t *client) {
+    if (!loop || !client) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    lock_loop(loop);
+    pthread_mutex_lock(&client->lock);
+    bool attached = client->event_loop == loop;
+    size_t index = client->loop_slot;
+    if (attached) {
+        client->event_loop = NULL;
+        client->thread_running = false;
+    }
+    pthread_mutex_unlock(&client->lock);
+    if (!attached) {
+        unlock_loop(loop);
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, client->epoll_fd, NULL);
+    loop->slots[index].client = NULL;
+    loop->slots[index].gen++;
+    unlock_loop(loop);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+/**
+ * @brief Wait for ready clients and run one pass for each
+ */
+static paumiot_client_result_t run_once(paumiot_event_loop_t *loop, int timeout_ms) {
+    struct epoll_event events[EVENT_BATCH];
+    int n = epoll_wait(loop->epoll_fd, events, EVENT_BATCH, timeout_ms);
+    if (n < 0) {
+        return errno == EINTR ? PAUMIOT_CLIENT_SUCCESS : PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&loop->lock);
+    t_dispatching = loop;
+    for (int i = 0; i < n; i++) {
+        uint64_t token = events[i].data.u64;
+        if (token == WAKEUP_TOKEN) {
+            uint64_t count;
+            ssize_t r = read(loop->wakeup_fd, &count, sizeof(count));
+            (void)r;
+            continue;
+        }
+
+        /* The client may have been detached since epoll_wait() returned */
+        size_t index = (size_t)(token & 0xFFFFFFFFu);
+        if (index < loop->slot_count && loop->slots[index].client &&
+            slot_token(loop, index) == token) {
+            paumiot_client_loop(loop->slots[index].client, 0);
+        }
+    }
+    t_dispatching = NULL;
+    pthread_mutex_unlock(&loop->lock);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+paumiot_client_result_t paumiot_event_loop_run(paumiot_event_loop_t *loop, uint32_t timeout_ms) {
+    if (!loop) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (atomic_exchange(&loop->in_run, true)) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    paumiot_client_result_t result =
+        run_once(loop, timeout_ms > INT32_MAX ? INT32_MAX : (int)timeout_ms);
+    atomic_store(&loop->in_run, false);
+    return result;
+}
+
+static void *loop_thread(void *arg) {
+    paumiot_event_loop_t *loop = (paumiot_event_loop_t *)arg;
+    while (!atomic_load(&loop->stop)) {
+        run_once(loop, -1);
+    }
+    return NULL;
+}
+
+paumiot_client_result_t paumiot_event_loop_start(paumiot_event_loop_t *loop) {
+    if (!loop) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (atomic_exchange(&loop->in_run, true)) {
+        pthread_mutex_lock(&loop->lock);
+        bool running = loop->thread_running;
+        pthread_mutex_unlock(&loop->lock);
+        return running ? PAUMIOT_CLIENT_SUCCESS : PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    /* Clients learn their thread before it dispatches anything */
+    pthread_mutex_lock(&loop->lock);
+    atomic_store(&loop->stop, false);
+    if (pthread_create(&loop->thread, NULL, loop_thread, loop) != 0) {
+        pthread_mutex_unlock(&loop->lock);
+        atomic_store(&loop->in_run, false);
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    loop->thread_running = true;
+    for (size_t i = 0; i < loop->slot_count; i++) {
+        if (loop->slots[i].client) {
+            set_client_thread(loop->slots[i].client, loop);
+        }
+    }
+    pthread_mutex_unlock(&loop->lock);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+paumiot_client_result_t paumiot_event_loop_stop(paumiot_event_loop_t *loop) {
+    if (!loop) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    if (t_dispatching == loop) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;  /* From a callback */
+    }
+
+    pthread_mutex_lock(&loop->lock);
+    bool running = loop->thread_running;
+    pthread_mutex_unlock(&loop->lock);
+    if (!running) {
+        return PAUMIOT_CLIENT_SUCCESS;
+    }
+
+    atomic_store(&loop->stop, true);
+    uint64_t one = 1;
+    ssize_t w = write(loop->wakeup_fd, &one, sizeof(one));
+    (void)w;
+    pthread_join(loop->thread, NULL);
+
+    pthread_mutex_lock(&loop->lock);
+    loop->thread_running = false;
+    for (size_t i = 0; i < loop->slot_count; i++) {
+        if (loop->slots[i].client) {
+            set_client_thread(loop->slots[i].client, loop);
+        }
+    }
+    pthread_mutex_unlock(&loop->lock);
+    atomic_store(&loop->in_run, false);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file mqtt_packet.c
+ * @brief MQTT 3.1.1 packet encoding and framing for the client plugin
+ */
+
+#include "client_internal.h"
+#include <string.h>
+
+#define MQTT_PROTOCOL_LEVEL_311 4
+#define MQTT_MAX_REMAINING 268435455
+
+/**
+ * @brief Bytes needed for a remaining-length varint
+ */
+static size_t varint_size(size_t value) {
+    size_t n = 1;
+    while (value >= 128) {
+        value /= 128;
+        n++;
+    }
+    return n;
+}
+
+static size_t put_varint(uint8_t *buf, size_t value) {
+    size_t pos = 0;
+    do {
+        uint8_t byte = (uint8_t)(value % 128);
+        value /= 128;
+        if (value > 0) {
+            byte |= 0x80;
+        }
+        buf[pos++] = byte;
+    } while (value > 0);
+    return pos;
+}
+
+static size_t put_u16(uint8_t *buf, uint16_t value) {
+    buf[0] = (uint8_t)(value >> 8);
+    buf[1] = (uint8_t)(value & 0xFF);
+    return 2;
+}
+
+static size_t put_string(uint8_t *buf, const char *str, size_t len) {
+    put_u16(buf, (uint16_t)len);
+    memcpy(buf + 2, str, len);
+    return 2 + len;
+}
+
+size_t client_mqtt_publish_size(size_t topic_len, size_t payload_len, paumiot_qos_t qos) {
+    size_t remaining = 2 + topic_len + (qos > PAUMIOT_QOS_0 ? 2 : 0) + payload_len;
+    return 1 + varint_size(remaining) + remaining;
+}
+
+size_t client_mqtt_encode_connect(uint8_t *buf, size_t size, const char *client_id,
+                                  const char *username, const char *password,
+                                  uint16_t keepalive_s) {
+    size_t id_len = strlen(client_id);
+    size_t user_len = username ? strlen(username) : 0;
+    size_t pass_len = password ? strlen(password) : 0;
+    if (id_len > 0xFFFF || user_len > 0xFFFF || pass_len > 0xFFFF) {
+        return 0;
+    }
+
+    size_t remaining = 10 + 2 + id_len;
+    uint8_t flags = 0x02;               /* Clean session */
+    if (username) {
+        remaining += 2 + user_len;
+        flags |= 0x80;
+    }
+    if (password) {
+        remaining += 2 + pass_len;
+        flags |= 0x40;
+    }
+
+    size_t total = 1 + varint_size(remaining) + remaining;
+    if (total > size) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    buf[pos++] = CLIENT_MQTT_CONNECT << 4;
+    pos += put_varint(buf + pos, remaining);
+    pos += put_string(buf + pos, "MQTT", 4);
+    buf[pos++] = MQTT_PROTOCOL_LEVEL_311;
+    buf[pos++] = flags;
+    pos += put_u16(buf + pos, keepalive_s);
+    pos += put_string(buf + pos, client_id, id_len);
+    if (username) {
+        pos += put_string(buf + pos, username, user_len);
+    }
+    if (password) {
+        pos += put_string(buf + pos, password, pass_len);
+    }
+    return pos;
+}
+
+size_t client_mqtt_encode_publish(uint8_t *buf, size_t size, const char *topic,
+                                  size_t topic_len, const uint8_t *payload, size_t payload_len,
+                                  paumiot_qos_t qos, bool retain, uint16_t packet_id) {
+    size_t remaining = 2 + topic_len + (qos > PAUMIOT_QOS_0 ? 2 : 0) + payload_len;
+    if (topic_len > 0xFFFF || remaining > MQTT_MAX_REMAINING ||
+        1 + varint_size(remaining) + remaining > size) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    buf[pos++] = (uint8_t)((CLIENT_MQTT_PUBLISH << 4) | ((unsigned)qos << 1) | (retain ? 1 : 0));
+    pos += put_varint(buf + pos, remaining);
+    pos += put_string(buf + pos, topic, topic_len);
+    if (qos > PAUMIOT_QOS_0) {
+        pos += put_u16(buf + pos, packet_id);
+    }
+    if (payload_len > 0) {
+        memcpy(buf + pos, payload, payload_len);
+        pos += payload_len;
+    }
+    return pos;
+}
+
+size_t client_mqtt_encode_subscribe(uint8_t *buf, size_t size, uint8_t type, uint16_t packet_id,
+                                    const char *filter, paumiot_qos_t qos) {
+    size_t filter_len = strlen(filter);
+    size_t remaining = 2 + 2 + filter_len + (type == CLIENT_MQTT_SUBSCRIBE ? 1 : 0);
+    size_t total = 1 + varint_size(remaining) + remaining;
+    if (filter_len > 0xFFFF || total > size) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    buf[pos++] = (uint8_t)((type << 4) | 0x02);     /* Reserved flags 0010 */
+    pos += put_varint(buf + pos, remaining);
+    pos += put_u16(buf + pos, packet_id);
+    pos += put_string(buf + pos, filter, filter_len);
+    if (type == CLIENT_MQTT_SUBSCRIBE) {
+        buf[pos++] = (uint8_t)qos;
+    }
+    return pos;
+}
+
+size_t client_mqtt_encode_ack(uint8_t *buf, uint8_t type, uint16_t packet_id) {
+    buf[0] = (uint8_t)((type << 4) | (type == CLIENT_MQTT_PUBREL ? 0x02 : 0x00));
+    buf[1] = 2;
+    put_u16(buf + 2, packet_id);
+    return 4;
+}
+
+size_t client_mqtt_encode_simple(uint8_t *buf, uint8_t type) {
+    buf[0] = (uint8_t)(type << 4);
+    buf[1] = 0;
+    return 2;
+}
+
+long client_mqtt_parse(const uint8_t *buf, size_t len, uint8_t *type, uint8_t *flags,
+                       size_t *body, size_t *body_len) {
+    if (len < 2) {
+        return 0;
+    }
+
+    size_t remaining = 0;
+    size_t multiplier = 1;
+    size_t pos = 1;
+    for (;;) {
+        if (pos >= len) {
+            return 0;
+        }
+        if (pos > 4) {
+            return -1;                  /* More than four length bytes */
+        }
+        uint8_t byte = buf[pos++];
+        remaining += (size_t)(byte & 0x7F) * multiplier;
+        multiplier *= 128;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    if (len - pos < remaining) {
+        return 0;
+    }
+    *type = buf[0] >> 4;
+    *flags = buf[0] & 0x0F;
+    *body = pos;
+    *body_len = remaining;
+    return (long)(pos + remaining);
+}
+
+bool client_mqtt_topic_matches(const char *filter, const char *topic, size_t topic_len) {
+    const char *end = topic + topic_len;
+
+    /* Wildcards never match topics starting with $ (broker internals) */
+    if (topic_len > 0 && topic[0] == '$' && (filter[0] == '+' || filter[0] == '#')) {
+        return false;
+    }
+
+    while (*filter) {
+        if (filter[0] == '#') {
+            return true;
+        }
+        if (filter[0] == '+') {
+            while (topic < end && *topic != '/') {
+                topic++;
+            }
+            filter++;
+        } else {
+            while (*filter && *filter != '/') {
+                if (topic == end || *topic != *filter) {
+                    return false;
+                }
+                topic++;
+                filter++;
+            }
+        }
+
+        /* At a level boundary in both */
+        if (*filter == '/') {
+            if (topic == end) {
+                /* "a/#" also matches "a" */
+                return filter[1] == '#' && filter[2] == '\0';
+            }
+            if (*topic != '/') {
+                return false;
+            }
+            filter++;
+            topic++;
+        } else if (topic != end) {
+            return false;
+        }
+    }
+    return topic == end;
+}
@@ -0,0 +1,384 @@
+/**
+ * @file spool.c
+ * @brief Store-and-forward spool: a bounded ring of publishes in an mmap'd file
+ * @details File layout: a header page holding two header slots, then the
+ *          ring. Each record is a frame header (its own logical offset,
+ *          body length, CRC-32) followed by the body (QoS, retain, topic,
+ *          payload), padded to 8 bytes. A record that would cross the end
+ *          of the ring is preceded by a pad frame and starts the next lap.
+ *
+ *          Only head is persisted, alternating between the two header
+ *          slots so a torn header write leaves the previous one intact.
+ *          After a crash the tail is recovered by walking frames from head
+ *          while each one carries the expected offset and a valid CRC:
+ *          a torn append fails its CRC, and a stale frame from an earlier
+ *          lap carries an offset one lap too small.
+ */
+
+#include "client_internal.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SPOOL_MAGIC 0x4c4f5053u         /* "SPOL" */
+#define SPOOL_VERSION 1
+#define SPOOL_HEADER_PAGE 4096
+#define SPOOL_SLOT_STRIDE 64
+#define SPOOL_MIN_CAPACITY 4096
+#define SPOOL_PAD_LEN UINT32_MAX        /* Frame length of a pad to the lap end */
+#define SPOOL_BODY_FIXED 4              /* QoS, retain, topic length */
+
+/* Header slot */
+typedef struct {
+    uint32_t magic;                     /* SPOOL_MAGIC */
+    uint32_t version;                   /* SPOOL_VERSION */
+    uint64_t capacity;                  /* Ring bytes */
+    uint64_t head;                      /* Oldest record still needed */
+    uint64_t seq;                       /* Higher wins */
+    uint32_t crc;                       /* Over the fields above */
+    uint32_t reserved;
+} spool_header_t;
+
+/* Frame header */
+typedef struct {
+    uint64_t offset;                    /* Logical offset of this frame */
+    uint32_t len;                       /* Body bytes, or SPOOL_PAD_LEN */
+    uint32_t crc;                       /* Over offset, len and body */
+} spool_frame_t;
+
+/* ============================================================================
+ * CRC-32 (IEEE 802.3)
+ * ========================================================================= */
+
+static uint32_t g_crc_table[256];
+static pthread_once_t g_crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        g_crc_table[i] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (len--) {
+        crc = g_crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t frame_crc(const spool_frame_t *frame, const uint8_t *body, size_t body_len) {
+    uint32_t crc = crc_update(0, &frame->offset, sizeof(frame->offset));
+    crc = crc_update(crc, &frame->len, sizeof(frame->len));
+    return crc_update(crc, body, body_len);
+}
+
+static uint32_t header_crc(const spool_header_t *header) {
+    return crc_update(0, header, offsetof(spool_header_t, crc));
+}
+
+/* ============================================================================
+ * RING ACCESS
+ * ========================================================================= */
+
+static size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+static uint8_t *ring_at(const client_spool_t *spool, uint64_t offset) {
+    return spool->map + SPOOL_HEADER_PAGE + offset % spool->capacity;
+}
+
+/**
+ * @brief Bytes from offset to the end of its lap
+ */
+static size_t lap_room(const client_spool_t *spool, uint64_t offset) {
+    return spool->capacity - (size_t)(offset % spool->capacity);
+}
+
+/**
+ * @brief Advance offset over padding at the end of a lap
+ * @return true if offset moved
+ */
+static bool skip_pad(const client_spool_t *spool, uint64_t *offset) {
+    size_t room = lap_room(spool, *offset);
+    if (room < sizeof(spool_frame_t)) {
+        *offset += room;                /* Too small for a frame: implicit pad */
+        return true;
+    }
+    const spool_frame_t *frame = (const spool_frame_t *)ring_at(spool, *offset);
+    if (frame->offset == *offset && frame->len == SPOOL_PAD_LEN &&
+        frame->crc == frame_crc(frame, NULL, 0)) {
+        *offset += room;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Size of the valid record at offset, or 0
+ */
+static size_t valid_frame(const client_spool_t *spool, uint64_t offset) {
+    const spool_frame_t *frame = (const spool_frame_t *)ring_at(spool, offset);
+    size_t room = lap_room(spool, offset);
+    if (frame->offset != offset || frame->len < SPOOL_BODY_FIXED ||
+        frame->len > room - sizeof(spool_frame_t)) {
+        return 0;
+    }
+    const uint8_t *body = (const uint8_t *)(frame + 1);
+    size_t topic_len = ((size_t)body[2] << 8) | body[3];
+    if (SPOOL_BODY_FIXED + topic_len > frame->len ||
+        frame->crc != frame_crc(frame, body, frame->len)) {
+        return 0;
+    }
+    return align8(sizeof(spool_frame_t) + frame->len);
+}
+
+/* ============================================================================
+ * HEADER
+ * ========================================================================= */
+
+static spool_header_t *header_slot(const client_spool_t *spool, uint64_t seq) {
+    return (spool_header_t *)(spool->map + (seq % 2) * SPOOL_SLOT_STRIDE);
+}
+
+static bool header_valid(const spool_header_t *header, size_t capacity) {
+    return header->magic == SPOOL_MAGIC && header->version == SPOOL_VERSION &&
+           header->capacity == capacity && header->crc == header_crc(header);
+}
+
+static void write_header(client_spool_t *spool) {
+    spool->commit_seq++;
+    spool_header_t *header = header_slot(spool, spool->commit_seq);
+    header->magic = SPOOL_MAGIC;
+    header->version = SPOOL_VERSION;
+    header->capacity = spool->capacity;
+    header->head = spool->head;
+    header->seq = spool->commit_seq;
+    header->crc = header_crc(header);
+    header->reserved = 0;
+    msync(spool->map, SPOOL_HEADER_PAGE, MS_ASYNC);
+    spool->dirty = false;
+}
+
+/**
+ * @brief Load head from the newest valid header slot and walk to the tail
+ */
+static void recover(client_spool_t *spool) {
+    const spool_header_t *newest = NULL;
+    for (uint64_t slot = 0; slot < 2; slot++) {
+        const spool_header_t *header = header_slot(spool, slot);
+        if (header_valid(header, spool->capacity) && (!newest || header->seq > newest->seq)) {
+            newest = header;
+        }
+    }
+    if (!newest) {
+        /* Frames left by a file of another size must not look valid */
+        client_debug("spool: starting empty");
+        memset(spool->map + SPOOL_HEADER_PAGE, 0, spool->capacity);
+        write_header(spool);
+        return;
+    }
+
+    spool->head = newest->head;
+    spool->commit_seq = newest->seq;
+    uint64_t tail = spool->head;
+    while (tail - spool->head < spool->capacity) {
+        if (skip_pad(spool, &tail)) {
+            continue;
+        }
+        size_t size = valid_frame(spool, tail);
+        if (size == 0 || tail + size - spool->head > spool->capacity) {
+            break;
+        }
+        tail += size;
+        spool->records++;
+    }
+    spool->tail = tail;
+    spool->read = spool->head;
+    client_debug("spool: recovered %zu records", spool->records);
+}
+
+/* ============================================================================
+ * API
+ * ========================================================================= */
+
+paumiot_client_result_t client_spool_open(client_spool_t *spool, const char *path, size_t size) {
+    pthread_once(&g_crc_once, crc_table_init);
+    memset(spool, 0, sizeof(*spool));
+    spool->fd = -1;
+    spool->pending_base = 1;            /* Ticket 0 means "not spooled" */
+    spool->capacity = size & ~(size_t)7;
+    if (spool->capacity < SPOOL_MIN_CAPACITY) {
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    size_t file_size = SPOOL_HEADER_PAGE + spool->capacity;
+    spool->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    struct stat st;
+    if (spool->fd < 0 || fstat(spool->fd, &st) != 0 ||
+        ((size_t)st.st_size != file_size && ftruncate(spool->fd, (off_t)file_size) != 0)) {
+        client_debug("spool: cannot open %s", path);
+        client_spool_close(spool);
+        return PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+
+    void *map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, spool->fd, 0);
+    if (map == MAP_FAILED) {
+        client_spool_close(spool);
+        return PAUMIOT_CLIENT_ERROR_OUT_OF_MEMORY;
+    }
+    spool->map = (uint8_t *)map;
+    recover(spool);
+    return PAUMIOT_CLIENT_SUCCESS;
+}
+
+void client_spool_close(client_spool_t *spool) {
+    if (spool->map) {
+        client_spool_commit(spool);
+        munmap(spool->map, SPOOL_HEADER_PAGE + spool->capacity);
+        spool->map = NULL;
+    }
+    if (spool->fd >= 0) {
+        close(spool->fd);
+        spool->fd = -1;
+    }
+    free(spool->pending);
+    spool->pending = NULL;
+}
+
+bool client_spool_append(client_spool_t *spool, const client_spool_record_t *record) {
+    size_t body_len = SPOOL_BODY_FIXED + record->topic_len + record->payload_len;
+    size_t size = align8(sizeof(spool_frame_t) + body_len);
+    size_t room = lap_room(spool, spool->tail);
+    size_t pad = room < size ? room : 0;
+    if (record->topic_len > 0xFFFF || body_len >= SPOOL_PAD_LEN ||
+        spool->tail - spool->head + pad + size > spool->capacity) {
+        return false;
+    }
+
+    if (pad >= sizeof(spool_frame_t)) {
+        spool_frame_t *frame = (spool_frame_t *)ring_at(spool, spool->tail);
+        frame->offset = spool->tail;
+        frame->len = SPOOL_PAD_LEN;
+        frame->crc = frame_crc(frame, NULL, 0);
+    }
+    spool->tail += pad;
+
+    /* Body first, then the header that makes it valid */
+    spool_frame_t *frame = (spool_frame_t *)ring_at(spool, spool->tail);
+    uint8_t *body = (uint8_t *)(frame + 1);
+    body[0] = (uint8_t)record->qos;
+    body[1] = record->retain ? 1 : 0;
+    body[2] = (uint8_t)(record->topic_len >> 8);
+    body[3] = (uint8_t)(record->topic_len & 0xFF);
+    memcpy(body + SPOOL_BODY_FIXED, record->topic, record->topic_len);
+    if (record->payload_len > 0) {
+        memcpy(body + SPOOL_BODY_FIXED + record->topic_len, record->payload,
+               record->payload_len);
+    }
+    frame->offset = spool->tail;
+    frame->len = (uint32_t)body_len;
+    frame->crc = frame_crc(frame, body, body_len);
+
+    spool->tail += size;
+    spool->records++;
+    return true;
+}
+
+bool client_spool_peek(client_spool_t *spool, client_spool_record_t *record) {
+    while (spool->read < spool->tail && skip_pad(spool, &spool->read)) {
+    }
+    if (spool->pending_count == spool->pending_first && spool->head < spool->read) {
+        spool->head = spool->read;      /* Only padding was left behind */
+        spool->dirty = true;
+    }
+    if (spool->read >= spool->tail) {
+        return false;
+    }
+
+    const spool_frame_t *frame = (const spool_frame_t *)ring_at(spool, spool->read);
+    const uint8_t *body = (const uint8_t *)(frame + 1);
+    record->qos = (paumiot_qos_t)body[0];
+    record->retain = body[1] != 0;
+    record->topic_len = ((size_t)body[2] << 8) | body[3];
+    record->topic = (const char *)body + SPOOL_BODY_FIXED;
+    record->payload = body + SPOOL_BODY_FIXED + record->topic_len;
+    record->payload_len = frame->len - SPOOL_BODY_FIXED - record->topic_len;
+    return true;
+}
+
+uint64_t client_spool_next_ticket(const client_spool_t *spool) {
+    return spool->pending_base + (spool->pending_count - spool->pending_first);
+}
+
+uint64_t client_spool_take(client_spool_t *spool) {
+    if (spool->pending_count == spool->pending_capacity) {
+        if (spool->pending_first > 0) {
+            memmove(spool->pending, spool->pending + spool->pending_first,
+                    (spool->pending_count - spool->pending_first) *
+                        sizeof(client_spool_pending_t));
+            spool->pending_count -= spool->pending_first;
+            spool->pending_first = 0;
+        } else {
+            size_t capacity = spool->pending_capacity ? spool->pending_capacity * 2 : 64;
+            client_spool_pending_t *grown = (client_spool_pending_t *)realloc(
+                spool->pending, capacity * sizeof(client_spool_pending_t));
+            if (!grown) {
+                return 0;
+            }
+            spool->pending = grown;
+            spool->pending_capacity = capacity;
+        }
+    }
+
+    uint64_t ticket = client_spool_next_ticket(spool);
+    const spool_frame_t *frame = (const spool_frame_t *)ring_at(spool, spool->read);
+    spool->read += align8(sizeof(spool_frame_t) + frame->len);
+    spool->pending[spool->pending_count].end = spool->read;
+    spool->pending[spool->pending_count].acked = false;
+    spool->pending_count++;
+    return ticket;
+}
+
+void client_spool_ack(client_spool_t *spool, uint64_t ticket) {
+    if (ticket < spool->pending_base ||
+        ticket - spool->pending_base >= spool->pending_count - spool->pending_first) {
+        return;                         /* Sent before a rewind */
+    }
+    spool->pending[spool->pending_first + (ticket - spool->pending_base)].acked = true;
+
+    while (spool->pending_first < spool->pending_count &&
+           spool->pending[spool->pending_first].acked) {
+        spool->head = spool->pending[spool->pending_first].end;
+        spool->pending_first++;
+        spool->pending_base++;
+        spool->records--;
+        spool->dirty = true;
+    }
+    if (spool->pending_first == spool->pending_count) {
+        spool->pending_first = 0;
+        spool->pending_count = 0;
+    }
+}
+
+void client_spool_rewind(client_spool_t *spool) {
+    spool->pending_base += spool->pending_count - spool->pending_first;
+    spool->pending_first = 0;
+    spool->pending_count = 0;
+    spool->read = spool->head;
+}
+
+void client_spool_commit(client_spool_t *spool) {
+    if (spool->map && spool->dirty) {
+        write_header(spool);
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * @file cpu_topology.h
+ * @brief CPU and NUMA node discovery and thread pinning (Linux)
+ * @details The topology is read from sysfs (devices/system/cpu/online and
+ *          devices/system/node/node<N>/cpulist) and limited to the CPUs the
+ *          process may run on. Machines without NUMA information are treated
+ *          as a single node.
+ */
+
+#ifndef PAUMIOT_CPU_TOPOLOGY_H
+#define PAUMIOT_CPU_TOPOLOGY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Highest CPU number + 1 and most NUMA nodes handled */
+#define CPU_TOPOLOGY_MAX_CPUS 1024
+#define CPU_TOPOLOGY_MAX_NODES 64
+
+/* cpu_node value of a CPU that cannot be used */
+#define CPU_TOPOLOGY_NO_NODE 0xFFFF
+
+/* Usable CPUs grouped by NUMA node */
+typedef struct {
+    uint16_t num_cpus;                          /* Usable CPUs */
+    uint16_t num_nodes;                         /* Nodes with a usable CPU */
+    uint16_t cpus[CPU_TOPOLOGY_MAX_CPUS];       /* Usable CPU numbers, ascending */
+    uint16_t node_ids[CPU_TOPOLOGY_MAX_NODES];  /* System number of each node index */
+    uint16_t cpu_node[CPU_TOPOLOGY_MAX_CPUS];   /* Node index by CPU number */
+} cpu_topology_t;
+
+/**
+ * Discover the usable CPUs and their NUMA nodes
+ *
+ * @param topology Receives the topology
+ * @param sysfs_root sysfs mount point, or NULL for "/sys" limited to the
+ *        process's CPU affinity mask (another root is read as-is, for tests)
+ * @return true on success, false if no usable CPU was found
+ */
+bool cpu_topology_discover(cpu_topology_t *topology, const char *sysfs_root);
+
+/**
+ * Get the node index of a CPU
+ *
+ * @param topology Topology
+ * @param cpu CPU number
+ * @return Node index, or -1 if the CPU is not usable
+ */
+int cpu_topology_node(const cpu_topology_t *topology, int cpu);
+
+/**
+ * Restrict the calling thread to one CPU
+ *
+ * @param cpu CPU number
+ * @return true on success
+ */
+bool cpu_pin_current_thread(int cpu);
+
+/**
+ * Get the CPU the calling thread is running on
+ *
+ * @return CPU number, or -1 if unknown
+ */
+int cpu_current(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_CPU_TOPOLOGY_H */
@@ -14,11 +14,11 @@ typedef struct memory_pool memory_pool_t;
 /**
  * Create a new memory pool
  * 
- * @param block_size Size of each block in bytes (must be > 0)
  * @param num_blocks Number of blocks in the pool (must be > 0)
+ * @param block_size Size of each block in bytes (must be > 0)
  * @return Pointer to the created pool, or NULL on error
  */
-memory_pool_t *pool_create(size_t block_size, size_t num_blocks);
+memory_pool_t *pool_create(size_t num_blocks, size_t block_size);
 
 /**
  * Destroy a memory pool and free all resources
@@ -0,0 +1,243 @@
+/**
+ * @file metrics.h
+ * @brief Metrics registry with per-thread counters and histograms
+ * @details Every counter and histogram keeps one cache-line padded cell per
+ *          thread slot. The data path updates only its own slot with a
+ *          relaxed atomic add, so concurrent writers never share a line and
+ *          never wait. Cells are summed when the registry is rendered, in the
+ *          Prometheus text exposition format (version 0.0.4).
+ *
+ *          Threads get a slot on their first update. Slots are not recycled;
+ *          past METRICS_MAX_THREADS threads share slots, which stays correct
+ *          but may share lines again.
+ *
+ *          Registration and rendering are serialised by a registry mutex that
+ *          updates never take. Values kept in plain statistics structs can be
+ *          exposed with a collector, which is called on each render.
+ */
+
+#ifndef PAUMIOT_METRICS_H
+#define PAUMIOT_METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Thread slots per metric */
+#ifndef METRICS_MAX_THREADS
+#define METRICS_MAX_THREADS 64
+#endif
+
+#define METRICS_CACHE_LINE 64
+
+/* Most upper bounds per histogram (+Inf is implicit) */
+#define METRICS_MAX_BUCKETS 32
+
+/* Kind of an exposed metric */
+typedef enum {
+    METRICS_COUNTER = 0,
+    METRICS_GAUGE,
+    METRICS_HISTOGRAM
+} metrics_type_t;
+
+/* Forward Declarations */
+typedef struct metrics_registry metrics_registry_t;
+typedef struct metrics_counter metrics_counter_t;
+typedef struct metrics_histogram metrics_histogram_t;
+typedef struct metrics_writer metrics_writer_t;
+
+/**
+ * Collector callback, run while rendering
+ *
+ * @param writer Pass to metrics_write()
+ * @param user_data Value given at registration
+ */
+typedef void (*metrics_collector_t)(metrics_writer_t *writer, void *user_data);
+
+/* ============================================================================
+ * REGISTRY
+ * ========================================================================= */
+
+/**
+ * Create an empty registry
+ *
+ * @return Registry, or NULL on allocation failure
+ */
+metrics_registry_t *metrics_registry_create(void);
+
+/**
+ * Destroy a registry and every metric registered in it
+ *
+ * @param registry Registry (can be NULL); no thread may still update it
+ */
+void metrics_registry_destroy(metrics_registry_t *registry);
+
+/**
+ * Register a monotonic counter
+ *
+ * @param registry Registry
+ * @param name Metric name, e.g. "paumiot_messages_total" (copied)
+ * @param help One-line description (copied)
+ * @return Counter, or NULL if the name is invalid or already registered
+ */
+metrics_counter_t *metrics_counter_register(metrics_registry_t *registry,
+                                            const char *name, const char *help);
+
+/**
+ * Register a histogram
+ *
+ * @param registry Registry
+ * @param name Metric name (copied)
+ * @param help One-line description (copied)
+ * @param bounds Ascending bucket upper bounds, in observed units
+ * @param num_bounds Number of bounds (1 to METRICS_MAX_BUCKETS)
+ * @param scale Factor applied to bounds and the sum when rendering
+ *        (e.g. 1e-6 to observe microseconds and expose seconds)
+ * @return Histogram, or NULL if the name or bounds are invalid
+ */
+metrics_histogram_t *metrics_histogram_register(metrics_registry_t *registry,
+                                                const char *name, const char *help,
+                                                const uint64_t *bounds, size_t num_bounds,
+                                                double scale);
+
+/**
+ * Register a collector for values kept elsewhere
+ *
+ * @param registry Registry
+ * @param collector Callback
+ * @param user_data Passed to the callback
+ * @return true on success
+ */
+bool metrics_collector_register(metrics_registry_t *registry,
+                                metrics_collector_t collector, void *user_data);
+
+/**
+ * Remove a counter or histogram and free it
+ *
+ * @param registry Registry
+ * @param name Metric name
+ * @details No thread may still update the metric.
+ */
+void metrics_unregister(metrics_registry_t *registry, const char *name);
+
+/**
+ * Remove a collector
+ *
+ * @param registry Registry
+ * @param collector Callback given at registration
+ * @param user_data Value given at registration
+ */
+void metrics_collector_unregister(metrics_registry_t *registry,
+                                  metrics_collector_t collector, void *user_data);
+
+/**
+ * Write one sample from a collector
+ *
+ * @param writer Writer passed to the collector
+ * @param type METRICS_COUNTER or METRICS_GAUGE
+ * @param name Metric name
+ * @param help One-line description
+ * @param value Sample value
+ */
+void metrics_write(metrics_writer_t *writer, metrics_type_t type,
+                   const char *name, const char *help, double value);
+
+/**
+ * Render every metric in the Prometheus text format
+ *
+ * @param registry Registry
+ * @param length Receives the text length (can be NULL)
+ * @return NUL-terminated text to free(), or NULL on allocation failure
+ */
+char *metrics_render(metrics_registry_t *registry, size_t *length);
+
+/* ============================================================================
+ * COUNTERS
+ * ========================================================================= */
+
+/* Counter cell of one thread slot */
+typedef struct {
+    atomic_uint_fast64_t value;
+    char pad[METRICS_CACHE_LINE - sizeof(atomic_uint_fast64_t)];
+} metrics_cell_t;
+
+struct metrics_counter {
+    metrics_cell_t cells[METRICS_MAX_THREADS];
+    atomic_uint_fast64_t reset_base;    /* Total at the last reset */
+};
+
+/* Slot of the calling thread + 1 (0 = not assigned yet) */
+extern __thread unsigned metrics_slot_plus_one;
+
+/**
+ * Give the calling thread a slot
+ */
+unsigned metrics_thread_slot_assign(void);
+
+/**
+ * Slot of the calling thread
+ */
+static inline unsigned metrics_thread_slot(void) {
+    unsigned slot = metrics_slot_plus_one;
+    return slot ? slot - 1 : metrics_thread_slot_assign();
+}
+
+/**
+ * Add to a counter
+ */
+static inline void metrics_counter_add(metrics_counter_t *counter, uint64_t n) {
+    atomic_fetch_add_explicit(&counter->cells[metrics_thread_slot()].value, n,
+                              memory_order_relaxed);
+}
+
+/**
+ * Add one to a counter
+ */
+static inline void metrics_counter_inc(metrics_counter_t *counter) {
+    metrics_counter_add(counter, 1);
+}
+
+/**
+ * Sum of all slots since registration (what is exposed)
+ */
+uint64_t metrics_counter_total(const metrics_counter_t *counter);
+
+/**
+ * Sum of all slots since the last metrics_counter_reset()
+ */
+uint64_t metrics_counter_value(const metrics_counter_t *counter);
+
+/**
+ * Restart metrics_counter_value() from zero
+ *
+ * @details The exposed total keeps counting, as scrapers expect.
+ */
+void metrics_counter_reset(metrics_counter_t *counter);
+
+/* ============================================================================
+ * HISTOGRAMS
+ * ========================================================================= */
+
+/**
+ * Record one observation
+ *
+ * @param histogram Histogram
+ * @param value Observed value, in the units of the bounds
+ */
+void metrics_histogram_observe(metrics_histogram_t *histogram, uint64_t value);
+
+/**
+ * Total observations in all slots
+ */
+uint64_t metrics_histogram_count(const metrics_histogram_t *histogram);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_METRICS_H */
@@ -69,6 +69,9 @@ paumiot_result_t queue_peek(queue_t* queue, void* element);
 /**
  * @brief Check if queue is empty
  * 
+ * Agrees with queue_dequeue(): false means an element has been published
+ * and a dequeue will succeed unless another consumer takes it first.
+ * 
  * @param queue Queue handle
  * @return true if empty, false otherwise
  */
@@ -85,6 +88,11 @@ bool queue_is_full(const queue_t* queue);
 /**
  * @brief Get current number of elements in queue
  * 
+ * Counts positions producers have claimed, including elements still
+ * being copied in, so under concurrency it is an estimate: it can be
+ * non-zero while queue_dequeue() still reports the queue empty. Use
+ * queue_is_empty() to decide whether to dequeue.
+ * 
  * @param queue Queue handle
  * @return Number of elements (approximate in concurrent scenarios)
  */
@@ -0,0 +1,103 @@
+/**
+ * @file rcu.h
+ * @brief Minimal read-copy-update domain for read-mostly pointers
+ * @details Readers bracket their use of a published pointer with
+ *          rcu_read_lock()/rcu_read_unlock(); these only touch one of a set
+ *          of cache-line padded counters chosen from the caller's stack
+ *          address, so concurrent readers rarely share a line. A writer
+ *          publishes the replacement with an atomic store, then calls
+ *          rcu_synchronize() before freeing the old version. The grace
+ *          period flips between two counter generations twice, so it waits
+ *          only for readers that could still hold the old pointer and is not
+ *          starved by new ones.
+ *
+ *          Readers must not call rcu_synchronize() on the same domain, and
+ *          writers must be serialised by the caller.
+ */
+
+#ifndef PAUMIOT_RCU_H
+#define PAUMIOT_RCU_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sched.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Reader counter stripes per generation (power of 2) */
+#ifndef RCU_STRIPES
+#define RCU_STRIPES 16
+#endif
+
+#define RCU_CACHE_LINE 64
+
+/* Reader counter on its own cache line */
+typedef struct {
+    atomic_uint_fast64_t readers;
+    char pad[RCU_CACHE_LINE - sizeof(atomic_uint_fast64_t)];
+} rcu_counter_t;
+
+/* RCU domain */
+typedef struct {
+    atomic_uint generation;         /* Low bit selects the counter set */
+    rcu_counter_t counters[2][RCU_STRIPES];
+} rcu_domain_t;
+
+/**
+ * @brief Initialise a domain
+ */
+static inline void rcu_init(rcu_domain_t *rcu) {
+    atomic_init(&rcu->generation, 0);
+    for (int g = 0; g < 2; g++) {
+        for (int i = 0; i < RCU_STRIPES; i++) {
+            atomic_init(&rcu->counters[g][i].readers, 0);
+        }
+    }
+}
+
+/**
+ * @brief Enter a read-side critical section
+ * @return Token to pass to rcu_read_unlock()
+ */
+static inline unsigned rcu_read_lock(rcu_domain_t *rcu) {
+    /* Thread stacks are disjoint, so the frame address picks a stable stripe */
+    char frame;
+    uintptr_t addr = (uintptr_t)&frame >> 12;
+    unsigned stripe = (unsigned)((addr * 0x9E3779B97F4A7C15ULL) >> 32) & (RCU_STRIPES - 1);
+    unsigned gen = atomic_load(&rcu->generation) & 1u;
+
+    atomic_fetch_add(&rcu->counters[gen][stripe].readers, 1);
+    return gen * RCU_STRIPES + stripe;
+}
+
+/**
+ * @brief Leave a read-side critical section
+ * @param token Value returned by the matching rcu_read_lock()
+ */
+static inline void rcu_read_unlock(rcu_domain_t *rcu, unsigned token) {
+    atomic_fetch_sub_explicit(&rcu->counters[token / RCU_STRIPES][token % RCU_STRIPES].readers,
+                              1, memory_order_release);
+}
+
+/**
+ * @brief Wait until no reader can still see a pointer replaced before the call
+ */
+static inline void rcu_synchronize(rcu_domain_t *rcu) {
+    for (int flip = 0; flip < 2; flip++) {
+        unsigned old = atomic_fetch_add(&rcu->generation, 1) & 1u;
+
+        for (int i = 0; i < RCU_STRIPES; i++) {
+            while (atomic_load(&rcu->counters[old][i].readers) != 0) {
+                sched_yield();
+            }
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_RCU_H */
@@ -0,0 +1,45 @@
+/**
+ * @file time_utils.h
+ * @brief Clock helpers shared by the middleware components
+ */
+
+#ifndef PAUMIOT_TIME_UTILS_H
+#define PAUMIOT_TIME_UTILS_H
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Monotonic clock in nanoseconds (for intervals and deadlines)
+ */
+static inline uint64_t time_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Monotonic clock in milliseconds (for intervals and deadlines)
+ */
+static inline uint64_t time_monotonic_ms(void) {
+    return time_monotonic_ns() / 1000000ULL;
+}
+
+/**
+ * @brief Wall clock in Unix epoch milliseconds (for data timestamps)
+ */
+static inline uint64_t time_realtime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_TIME_UTILS_H */
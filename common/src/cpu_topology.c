@@ -0,0 +1,190 @@
+/**
+ * @file cpu_topology.c
+ * @brief CPU and NUMA node discovery and thread pinning (Linux)
+ */
+
+#define _GNU_SOURCE     /* cpu_set_t, sched_getcpu() */
+
+#include "../include/cpu_topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sched.h>
+
+#define MASK_WORDS (CPU_TOPOLOGY_MAX_CPUS / 64)
+
+typedef uint64_t cpu_mask_t[MASK_WORDS];
+
+static void mask_set(cpu_mask_t mask, unsigned cpu) {
+    mask[cpu / 64] |= 1ULL << (cpu % 64);
+}
+
+static bool mask_test(const cpu_mask_t mask, unsigned cpu) {
+    return (mask[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+/**
+ * Read a sysfs CPU list such as "0-3,8-11"
+ */
+static bool read_cpu_list(const char *path, cpu_mask_t mask) {
+    char buf[8192];
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    bool ok = fgets(buf, sizeof(buf), file) != NULL;
+    fclose(file);
+
+    memset(mask, 0, sizeof(cpu_mask_t));
+    if (!ok) {
+        return true;    /* Empty list (e.g. a memory-only node) */
+    }
+
+    char *p = buf;
+    while (*p >= '0' && *p <= '9') {
+        unsigned long first = strtoul(p, &p, 10);
+        unsigned long last = first;
+        if (*p == '-') {
+            last = strtoul(p + 1, &p, 10);
+        }
+        for (unsigned long cpu = first; cpu <= last && cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+            mask_set(mask, (unsigned)cpu);
+        }
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return true;
+}
+
+static int compare_u16(const void *a, const void *b) {
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+/**
+ * List the node numbers under devices/system/node, ascending
+ */
+static size_t list_nodes(const char *base, uint16_t *nodes) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/devices/system/node", base);
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return 0;
+    }
+
+    size_t count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < CPU_TOPOLOGY_MAX_NODES) {
+        unsigned node;
+        char tail;
+        if (sscanf(entry->d_name, "node%u%c", &node, &tail) == 1 && node < 0xFFFF) {
+            nodes[count++] = (uint16_t)node;
+        }
+    }
+    closedir(dir);
+
+    qsort(nodes, count, sizeof(uint16_t), compare_u16);
+    return count;
+}
+
+bool cpu_topology_discover(cpu_topology_t *topology, const char *sysfs_root) {
+    if (!topology) {
+        return false;
+    }
+
+    const char *base = sysfs_root ? sysfs_root : "/sys";
+    char path[512];
+    cpu_mask_t usable;
+
+    memset(topology, 0, sizeof(*topology));
+    for (int cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+        topology->cpu_node[cpu] = CPU_TOPOLOGY_NO_NODE;
+    }
+
+    snprintf(path, sizeof(path), "%s/devices/system/cpu/online", base);
+    if (!read_cpu_list(path, usable)) {
+        if (sysfs_root) {
+            return false;
+        }
+        memset(usable, 0xFF, sizeof(usable));
+    }
+
+    if (!sysfs_root) {
+        cpu_set_t allowed;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+            for (unsigned cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+                if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)) {
+                    usable[cpu / 64] &= ~(1ULL << (cpu % 64));
+                }
+            }
+        }
+    }
+
+    uint16_t nodes[CPU_TOPOLOGY_MAX_NODES];
+    size_t num_nodes = list_nodes(base, nodes);
+    for (size_t i = 0; i < num_nodes; i++) {
+        cpu_mask_t node_cpus;
+        snprintf(path, sizeof(path), "%s/devices/system/node/node%u/cpulist", base,
+                 (unsigned)nodes[i]);
+        if (!read_cpu_list(path, node_cpus)) {
+            continue;
+        }
+
+        /* Nodes without usable CPUs (memory-only, or outside the mask) are skipped */
+        uint16_t index = topology->num_nodes;
+        for (unsigned cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+            if (mask_test(node_cpus, cpu) && mask_test(usable, cpu) &&
+                topology->cpu_node[cpu] == CPU_TOPOLOGY_NO_NODE) {
+                topology->cpu_node[cpu] = index;
+                if (topology->num_nodes == index) {
+                    topology->node_ids[index] = nodes[i];
+                    topology->num_nodes++;
+                }
+            }
+        }
+    }
+
+    /* Without NUMA information every CPU belongs to the first node */
+    for (unsigned cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+        if (mask_test(usable, cpu) && topology->cpu_node[cpu] == CPU_TOPOLOGY_NO_NODE) {
+            topology->cpu_node[cpu] = 0;
+            if (topology->num_nodes == 0) {
+                topology->node_ids[0] = 0;
+                topology->num_nodes = 1;
+            }
+        }
+    }
+
+    for (unsigned cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+        if (topology->cpu_node[cpu] != CPU_TOPOLOGY_NO_NODE) {
+            topology->cpus[topology->num_cpus++] = (uint16_t)cpu;
+        }
+    }
+
+    return topology->num_cpus > 0;
+}
+
+int cpu_topology_node(const cpu_topology_t *topology, int cpu) {
+    if (!topology || cpu < 0 || cpu >= CPU_TOPOLOGY_MAX_CPUS ||
+        topology->cpu_node[cpu] == CPU_TOPOLOGY_NO_NODE) {
+        return -1;
+    }
+    return topology->cpu_node[cpu];
+}
+
+bool cpu_pin_current_thread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+int cpu_current(void) {
+    return sched_getcpu();
+}
@@ -2,22 +2,23 @@
 #include <stdarg.h>
 #include <time.h>
 #include <string.h>
+#include <stdatomic.h>
 
-/* Global log level - default to INFO */
-static log_level_t global_log_level = LOG_LEVEL_INFO;
+/* Global log level - default to INFO (atomic so it can change at runtime) */
+static atomic_int global_log_level = LOG_LEVEL_INFO;
 
 /**
  * Set the global log level
  */
 void log_set_level(log_level_t level) {
-    global_log_level = level;
+    atomic_store_explicit(&global_log_level, level, memory_order_relaxed);
 }
 
 /**
  * Get the current global log level
  */
 log_level_t log_get_level(void) {
-    return global_log_level;
+    return (log_level_t)atomic_load_explicit(&global_log_level, memory_order_relaxed);
 }
 
 /**
@@ -60,7 +61,7 @@ static void format_timestamp(char *buffer, size_t size) {
 void log_message(log_level_t level, const char *file, int line, 
                  const char *fmt, ...) {
     /* Check if we should log this message */
-    if (level < global_log_level || level == LOG_LEVEL_NONE) {
+    if (level < log_get_level() || level == LOG_LEVEL_NONE) {
         return;
     }
     
@@ -17,7 +17,7 @@ struct memory_pool {
 /**
  * Create a new memory pool
  */
-memory_pool_t *pool_create(size_t block_size, size_t num_blocks) {
+memory_pool_t *pool_create(size_t num_blocks, size_t block_size) {
     if (block_size == 0 || num_blocks == 0) {
         return NULL;
     }
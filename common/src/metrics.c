@@ -0,0 +1,498 @@
+/**
+ * @file metrics.c
+ * @brief Metrics registry with per-thread counters and histograms
+ */
+
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <pthread.h>
+
+__thread unsigned metrics_slot_plus_one;
+
+static atomic_uint next_slot;
+
+/* Histogram: per slot, one cell per bucket (the last is +Inf) then the sum */
+struct metrics_histogram {
+    size_t num_bounds;
+    size_t stride;                  /* Cells per slot, a whole number of lines */
+    double scale;
+    uint64_t bounds[METRICS_MAX_BUCKETS];
+    atomic_uint_fast64_t *cells;
+};
+
+typedef struct metrics_entry {
+    metrics_type_t type;
+    char *name;
+    char *help;
+    union {
+        metrics_counter_t *counter;
+        metrics_histogram_t *histogram;
+    } metric;
+    struct metrics_entry *next;
+} metrics_entry_t;
+
+typedef struct metrics_collector_entry {
+    metrics_collector_t collector;
+    void *user_data;
+    struct metrics_collector_entry *next;
+} metrics_collector_entry_t;
+
+struct metrics_registry {
+    pthread_mutex_t lock;           /* Registration and rendering only */
+    metrics_entry_t *entries;       /* In registration order */
+    metrics_entry_t **tail;
+    metrics_collector_entry_t *collectors;
+    metrics_collector_entry_t **collectors_tail;
+};
+
+/* Growing text buffer */
+struct metrics_writer {
+    char *data;
+    size_t length;
+    size_t capacity;
+    bool failed;
+};
+
+unsigned metrics_thread_slot_assign(void) {
+    unsigned slot = atomic_fetch_add_explicit(&next_slot, 1, memory_order_relaxed) %
+                    METRICS_MAX_THREADS;
+    metrics_slot_plus_one = slot + 1;
+    return slot;
+}
+
+/* ============================================================================
+ * INTERNAL HELPERS
+ * ========================================================================= */
+
+static bool valid_name(const char *name) {
+    if (!name || !*name || (name[0] >= '0' && name[0] <= '9')) {
+        return false;
+    }
+    for (const char *p = name; *p; p++) {
+        if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
+              (*p >= '0' && *p <= '9') || *p == '_' || *p == ':')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static metrics_entry_t *find_entry(metrics_registry_t *registry, const char *name) {
+    for (metrics_entry_t *entry = registry->entries; entry; entry = entry->next) {
+        if (strcmp(entry->name, name) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Add an entry for a new metric (registry lock held)
+ */
+static metrics_entry_t *add_entry(metrics_registry_t *registry, metrics_type_t type,
+                                  const char *name, const char *help) {
+    if (find_entry(registry, name)) {
+        return NULL;
+    }
+
+    metrics_entry_t *entry = calloc(1, sizeof(*entry));
+    if (!entry) {
+        return NULL;
+    }
+    entry->type = type;
+    entry->name = strdup(name);
+    entry->help = strdup(help ? help : "");
+    if (!entry->name || !entry->help) {
+        free(entry->name);
+        free(entry->help);
+        free(entry);
+        return NULL;
+    }
+
+    *registry->tail = entry;
+    registry->tail = &entry->next;
+    return entry;
+}
+
+static void writer_printf(metrics_writer_t *writer, const char *fmt, ...) {
+    if (writer->failed) {
+        return;
+    }
+
+    for (;;) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(writer->data + writer->length, writer->capacity - writer->length,
+                          fmt, args);
+        va_end(args);
+
+        if (n < 0) {
+            writer->failed = true;
+            return;
+        }
+        if ((size_t)n < writer->capacity - writer->length) {
+            writer->length += (size_t)n;
+            return;
+        }
+
+        size_t capacity = writer->capacity * 2;
+        while (capacity - writer->length <= (size_t)n) {
+            capacity *= 2;
+        }
+        char *data = realloc(writer->data, capacity);
+        if (!data) {
+            writer->failed = true;
+            return;
+        }
+        writer->data = data;
+        writer->capacity = capacity;
+    }
+}
+
+/**
+ * Write a float the way the exposition format spells it
+ */
+static void write_value(metrics_writer_t *writer, double value) {
+    if (isnan(value)) {
+        writer_printf(writer, "NaN");
+    } else if (isinf(value)) {
+        writer_printf(writer, value > 0 ? "+Inf" : "-Inf");
+    } else {
+        writer_printf(writer, "%.15g", value);
+    }
+}
+
+static void write_header(metrics_writer_t *writer, const char *name, const char *help,
+                         metrics_type_t type) {
+    static const char *const type_names[] = { "counter", "gauge", "histogram" };
+
+    writer_printf(writer, "# HELP %s ", name);
+    for (const char *p = help; *p; p++) {
+        if (*p == '\\') {
+            writer_printf(writer, "\\\\");
+        } else if (*p == '\n') {
+            writer_printf(writer, "\\n");
+        } else {
+            writer_printf(writer, "%c", *p);
+        }
+    }
+    writer_printf(writer, "\n# TYPE %s %s\n", name, type_names[type]);
+}
+
+static void write_histogram(metrics_writer_t *writer, const char *name,
+                            const metrics_histogram_t *histogram) {
+    uint64_t buckets[METRICS_MAX_BUCKETS + 1] = { 0 };
+    uint64_t sum = 0;
+
+    for (unsigned slot = 0; slot < METRICS_MAX_THREADS; slot++) {
+        const atomic_uint_fast64_t *cells = histogram->cells + slot * histogram->stride;
+        for (size_t b = 0; b <= histogram->num_bounds; b++) {
+            buckets[b] += atomic_load_explicit(&cells[b], memory_order_relaxed);
+        }
+        sum += atomic_load_explicit(&cells[histogram->num_bounds + 1], memory_order_relaxed);
+    }
+
+    uint64_t cumulative = 0;
+    for (size_t b = 0; b < histogram->num_bounds; b++) {
+        cumulative += buckets[b];
+        writer_printf(writer, "%s_bucket{le=\"%.15g\"} %llu\n", name,
+                      (double)histogram->bounds[b] * histogram->scale,
+                      (unsigned long long)cumulative);
+    }
+    cumulative += buckets[histogram->num_bounds];
+    writer_printf(writer, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)cumulative);
+    writer_printf(writer, "%s_sum ", name);
+    write_value(writer, (double)sum * histogram->scale);
+    writer_printf(writer, "\n%s_count %llu\n", name, (unsigned long long)cumulative);
+}
+
+/* ============================================================================
+ * REGISTRY
+ * ========================================================================= */
+
+metrics_registry_t *metrics_registry_create(void) {
+    metrics_registry_t *registry = calloc(1, sizeof(*registry));
+    if (!registry) {
+        return NULL;
+    }
+    pthread_mutex_init(&registry->lock, NULL);
+    registry->tail = &registry->entries;
+    registry->collectors_tail = &registry->collectors;
+    return registry;
+}
+
+static void free_entry(metrics_entry_t *entry) {
+    if (entry->type == METRICS_HISTOGRAM) {
+        free(entry->metric.histogram->cells);
+        free(entry->metric.histogram);
+    } else {
+        free(entry->metric.counter);
+    }
+    free(entry->name);
+    free(entry->help);
+    free(entry);
+}
+
+void metrics_registry_destroy(metrics_registry_t *registry) {
+    if (!registry) {
+        return;
+    }
+
+    metrics_entry_t *entry = registry->entries;
+    while (entry) {
+        metrics_entry_t *next = entry->next;
+        free_entry(entry);
+        entry = next;
+    }
+
+    metrics_collector_entry_t *collector = registry->collectors;
+    while (collector) {
+        metrics_collector_entry_t *next = collector->next;
+        free(collector);
+        collector = next;
+    }
+
+    pthread_mutex_destroy(&registry->lock);
+    free(registry);
+}
+
+metrics_counter_t *metrics_counter_register(metrics_registry_t *registry,
+                                            const char *name, const char *help) {
+    if (!registry || !valid_name(name)) {
+        return NULL;
+    }
+
+    void *memory;
+    if (posix_memalign(&memory, METRICS_CACHE_LINE, sizeof(metrics_counter_t)) != 0) {
+        return NULL;
+    }
+    metrics_counter_t *counter = memory;
+    for (unsigned slot = 0; slot < METRICS_MAX_THREADS; slot++) {
+        atomic_init(&counter->cells[slot].value, 0);
+    }
+    atomic_init(&counter->reset_base, 0);
+
+    pthread_mutex_lock(&registry->lock);
+    metrics_entry_t *entry = add_entry(registry, METRICS_COUNTER, name, help);
+    if (entry) {
+        entry->metric.counter = counter;
+    }
+    pthread_mutex_unlock(&registry->lock);
+
+    if (!entry) {
+        free(counter);
+        return NULL;
+    }
+    return counter;
+}
+
+metrics_histogram_t *metrics_histogram_register(metrics_registry_t *registry,
+                                                const char *name, const char *help,
+                                                const uint64_t *bounds, size_t num_bounds,
+                                                double scale) {
+    if (!registry || !valid_name(name) || !bounds || num_bounds == 0 ||
+        num_bounds > METRICS_MAX_BUCKETS || !(scale > 0)) {
+        return NULL;
+    }
+    for (size_t b = 1; b < num_bounds; b++) {
+        if (bounds[b] <= bounds[b - 1]) {
+            return NULL;
+        }
+    }
+
+    metrics_histogram_t *histogram = calloc(1, sizeof(*histogram));
+    if (!histogram) {
+        return NULL;
+    }
+
+    size_t per_line = METRICS_CACHE_LINE / sizeof(atomic_uint_fast64_t);
+    histogram->num_bounds = num_bounds;
+    histogram->stride = (num_bounds + 2 + per_line - 1) / per_line * per_line;
+    histogram->scale = scale;
+    memcpy(histogram->bounds, bounds, num_bounds * sizeof(uint64_t));
+
+    size_t cells = histogram->stride * METRICS_MAX_THREADS;
+    void *memory;
+    if (posix_memalign(&memory, METRICS_CACHE_LINE, cells * sizeof(atomic_uint_fast64_t)) != 0) {
+        free(histogram);
+        return NULL;
+    }
+    histogram->cells = memory;
+    for (size_t i = 0; i < cells; i++) {
+        atomic_init(&histogram->cells[i], 0);
+    }
+
+    pthread_mutex_lock(&registry->lock);
+    metrics_entry_t *entry = add_entry(registry, METRICS_HISTOGRAM, name, help);
+    if (entry) {
+        entry->metric.histogram = histogram;
+    }
+    pthread_mutex_unlock(&registry->lock);
+
+    if (!entry) {
+        free(histogram->cells);
+        free(histogram);
+        return NULL;
+    }
+    return histogram;
+}
+
+bool metrics_collector_register(metrics_registry_t *registry,
+                                metrics_collector_t collector, void *user_data) {
+    if (!registry || !collector) {
+        return false;
+    }
+
+    metrics_collector_entry_t *entry = calloc(1, sizeof(*entry));
+    if (!entry) {
+        return false;
+    }
+    entry->collector = collector;
+    entry->user_data = user_data;
+
+    pthread_mutex_lock(&registry->lock);
+    *registry->collectors_tail = entry;
+    registry->collectors_tail = &entry->next;
+    pthread_mutex_unlock(&registry->lock);
+    return true;
+}
+
+void metrics_unregister(metrics_registry_t *registry, const char *name) {
+    if (!registry || !name) {
+        return;
+    }
+
+    pthread_mutex_lock(&registry->lock);
+    for (metrics_entry_t **link = &registry->entries; *link; link = &(*link)->next) {
+        metrics_entry_t *entry = *link;
+        if (strcmp(entry->name, name) == 0) {
+            *link = entry->next;
+            if (registry->tail == &entry->next) {
+                registry->tail = link;
+            }
+            free_entry(entry);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&registry->lock);
+}
+
+void metrics_collector_unregister(metrics_registry_t *registry,
+                                  metrics_collector_t collector, void *user_data) {
+    if (!registry) {
+        return;
+    }
+
+    pthread_mutex_lock(&registry->lock);
+    for (metrics_collector_entry_t **link = &registry->collectors; *link;
+         link = &(*link)->next) {
+        metrics_collector_entry_t *entry = *link;
+        if (entry->collector == collector && entry->user_data == user_data) {
+            *link = entry->next;
+            if (registry->collectors_tail == &entry->next) {
+                registry->collectors_tail = link;
+            }
+            free(entry);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&registry->lock);
+}
+
+void metrics_write(metrics_writer_t *writer, metrics_type_t type,
+                   const char *name, const char *help, double value) {
+    if (!writer || !valid_name(name) || type == METRICS_HISTOGRAM) {
+        return;
+    }
+    write_header(writer, name, help ? help : "", type);
+    writer_printf(writer, "%s ", name);
+    write_value(writer, value);
+    writer_printf(writer, "\n");
+}
+
+char *metrics_render(metrics_registry_t *registry, size_t *length) {
+    if (!registry) {
+        return NULL;
+    }
+
+    metrics_writer_t writer = { malloc(4096), 0, 4096, false };
+    if (!writer.data) {
+        return NULL;
+    }
+    writer.data[0] = '\0';
+
+    pthread_mutex_lock(&registry->lock);
+
+    for (metrics_entry_t *entry = registry->entries; entry; entry = entry->next) {
+        write_header(&writer, entry->name, entry->help, entry->type);
+        if (entry->type == METRICS_HISTOGRAM) {
+            write_histogram(&writer, entry->name, entry->metric.histogram);
+        } else {
+            writer_printf(&writer, "%s %llu\n", entry->name,
+                          (unsigned long long)metrics_counter_total(entry->metric.counter));
+        }
+    }
+
+    for (metrics_collector_entry_t *c = registry->collectors; c; c = c->next) {
+        c->collector(&writer, c->user_data);
+    }
+
+    pthread_mutex_unlock(&registry->lock);
+
+    if (writer.failed) {
+        free(writer.data);
+        return NULL;
+    }
+    if (length) {
+        *length = writer.length;
+    }
+    return writer.data;
+}
+
+/* ============================================================================
+ * COUNTERS AND HISTOGRAMS
+ * ========================================================================= */
+
+uint64_t metrics_counter_total(const metrics_counter_t *counter) {
+    uint64_t total = 0;
+    for (unsigned slot = 0; slot < METRICS_MAX_THREADS; slot++) {
+        total += atomic_load_explicit(&counter->cells[slot].value, memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t metrics_counter_value(const metrics_counter_t *counter) {
+    return metrics_counter_total(counter) -
+           atomic_load_explicit(&counter->reset_base, memory_order_relaxed);
+}
+
+void metrics_counter_reset(metrics_counter_t *counter) {
+    atomic_store_explicit(&counter->reset_base, metrics_counter_total(counter),
+                          memory_order_relaxed);
+}
+
+void metrics_histogram_observe(metrics_histogram_t *histogram, uint64_t value) {
+    size_t bucket = 0;
+    while (bucket < histogram->num_bounds && value > histogram->bounds[bucket]) {
+        bucket++;
+    }
+
+    atomic_uint_fast64_t *cells = histogram->cells + metrics_thread_slot() * histogram->stride;
+    atomic_fetch_add_explicit(&cells[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&cells[histogram->num_bounds + 1], value, memory_order_relaxed);
+}
+
+uint64_t metrics_histogram_count(const metrics_histogram_t *histogram) {
+    uint64_t count = 0;
+    for (unsigned slot = 0; slot < METRICS_MAX_THREADS; slot++) {
+        const atomic_uint_fast64_t *cells = histogram->cells + slot * histogram->stride;
+        for (size_t b = 0; b <= histogram->num_bounds; b++) {
+            count += atomic_load_explicit(&cells[b], memory_order_relaxed);
+        }
+    }
+    return count;
+}
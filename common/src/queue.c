@@ -9,17 +9,24 @@
 #include <stdatomic.h>
 
 /**
- * @brief Queue structure (circular buffer with atomics)
+ * @brief Queue structure (bounded MPMC ring with per-slot sequence numbers)
+ *
+ * Slot i is free for the producer claiming position pos when
+ * sequence[i] == pos, and holds that producer's element once
+ * sequence[i] == pos + 1. A consumer that takes it sets
+ * sequence[i] = pos + capacity, handing the slot to the next lap. A
+ * position is claimed before its element is copied, so the sequence is
+ * what tells consumers the copy is complete.
  */
 struct queue {
     void* buffer;              /* Circular buffer for elements */
+    atomic_size_t* sequence;   /* Per-slot lap counters */
     size_t capacity;           /* Maximum number of elements (power of 2) */
     size_t element_size;       /* Size of each element in bytes */
     size_t mask;               /* Bit mask for wrapping (capacity - 1) */
     
-    atomic_size_t head;        /* Write position (producer) */
-    atomic_size_t tail;        /* Read position (consumer) */
-    atomic_size_t count;       /* Current number of elements */
+    atomic_size_t head;        /* Next position to claim (producers) */
+    atomic_size_t tail;        /* Next position to take (consumers) */
 };
 
 /**
@@ -37,6 +44,15 @@ static void* get_element_ptr(queue_t* queue, size_t index) {
     return (char*)queue->buffer + offset;
 }
 
+/**
+ * @brief Reset slot sequences so slot i expects position i
+ */
+static void reset_sequences(queue_t* queue) {
+    for (size_t i = 0; i < queue->capacity; i++) {
+        atomic_init(&queue->sequence[i], i);
+    }
+}
+
 queue_t* queue_create(size_t capacity, size_t element_size) {
     /* Validate parameters */
     if (capacity == 0 || element_size == 0) {
@@ -53,9 +69,12 @@ queue_t* queue_create(size_t capacity, size_t element_size) {
         return NULL;
     }
     
-    /* Allocate buffer */
+    /* Allocate buffer and slot sequences */
     queue->buffer = malloc(capacity * element_size);
-    if (!queue->buffer) {
+    queue->sequence = (atomic_size_t*)malloc(capacity * sizeof(atomic_size_t));
+    if (!queue->buffer || !queue->sequence) {
+        free(queue->buffer);
+        free(queue->sequence);
         free(queue);
         return NULL;
     }
@@ -67,7 +86,7 @@ queue_t* queue_create(size_t capacity, size_t element_size) {
     
     atomic_init(&queue->head, 0);
     atomic_init(&queue->tail, 0);
-    atomic_init(&queue->count, 0);
+    reset_sequences(queue);
     
     /* Zero the buffer */
     memset(queue->buffer, 0, capacity * element_size);
@@ -80,10 +99,8 @@ void queue_destroy(queue_t* queue) {
         return;
     }
     
-    if (queue->buffer) {
-        free(queue->buffer);
-    }
-    
+    free(queue->buffer);
+    free(queue->sequence);
     free(queue);
 }
 
@@ -92,27 +109,30 @@ paumiot_result_t queue_enqueue(queue_t* queue, const void* element) {
         return PAUMIOT_ERROR_INVALID_PARAM;
     }
     
-    /* Check if queue is full (atomic load) */
-    size_t current_count = atomic_load(&queue->count);
-    if (current_count >= queue->capacity) {
-        return PAUMIOT_ERROR_QUEUE_FULL;
-    }
-    
-    /* Try to increment count atomically */
-    size_t expected = current_count;
-    while (!atomic_compare_exchange_weak(&queue->count, &expected, expected + 1)) {
-        /* If queue became full, fail */
-        if (expected >= queue->capacity) {
+    /* Claim a position whose slot the consumers have released */
+    size_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    for (;;) {
+        size_t seq = atomic_load_explicit(&queue->sequence[pos & queue->mask],
+                                          memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Slot still holds the element from the previous lap */
             return PAUMIOT_ERROR_QUEUE_FULL;
+        } else {
+            pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
         }
     }
     
-    /* Get head position and increment atomically */
-    size_t head = atomic_fetch_add(&queue->head, 1);
-    
-    /* Copy element to buffer */
-    void* dest = get_element_ptr(queue, head);
-    memcpy(dest, element, queue->element_size);
+    /* Copy element to buffer, then publish it to consumers */
+    memcpy(get_element_ptr(queue, pos), element, queue->element_size);
+    atomic_store_explicit(&queue->sequence[pos & queue->mask], pos + 1, memory_order_release);
     
     return PAUMIOT_SUCCESS;
 }
@@ -122,31 +142,38 @@ paumiot_result_t queue_dequeue(queue_t* queue, void* element) {
         return PAUMIOT_ERROR_INVALID_PARAM;
     }
     
-    /* Check if queue is empty (atomic load) */
-    size_t current_count = atomic_load(&queue->count);
-    if (current_count == 0) {
-        return PAUMIOT_ERROR_QUEUE_EMPTY;
-    }
-    
-    /* Try to decrement count atomically */
-    size_t expected = current_count;
-    while (!atomic_compare_exchange_weak(&queue->count, &expected, expected - 1)) {
-        /* If queue became empty, fail */
-        if (expected == 0) {
+    /* Claim a position whose element has been published */
+    size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    for (;;) {
+        size_t seq = atomic_load_explicit(&queue->sequence[pos & queue->mask],
+                                          memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - (pos + 1));
+        
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Nothing published at this position yet */
             return PAUMIOT_ERROR_QUEUE_EMPTY;
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
         }
     }
     
-    /* Get tail position and increment atomically */
-    size_t tail = atomic_fetch_add(&queue->tail, 1);
-    
     /* Copy element from buffer */
-    void* src = get_element_ptr(queue, tail);
+    void* src = get_element_ptr(queue, pos);
     memcpy(element, src, queue->element_size);
     
     /* Zero the slot for security/debugging */
     memset(src, 0, queue->element_size);
     
+    /* Release the slot to the producer of the next lap */
+    atomic_store_explicit(&queue->sequence[pos & queue->mask], pos + queue->capacity,
+                          memory_order_release);
+    
     return PAUMIOT_SUCCESS;
 }
 
@@ -155,15 +182,14 @@ paumiot_result_t queue_peek(queue_t* queue, void* element) {
         return PAUMIOT_ERROR_INVALID_PARAM;
     }
     
-    /* Check if queue is empty */
-    size_t current_count = atomic_load(&queue->count);
-    if (current_count == 0) {
+    /* Read tail position without modifying */
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t seq = atomic_load_explicit(&queue->sequence[tail & queue->mask],
+                                      memory_order_acquire);
+    if (seq != tail + 1) {
         return PAUMIOT_ERROR_QUEUE_EMPTY;
     }
     
-    /* Read tail position without modifying */
-    size_t tail = atomic_load(&queue->tail);
-    
     /* Copy element from buffer */
     void* src = get_element_ptr(queue, tail);
     memcpy(element, src, queue->element_size);
@@ -176,7 +202,21 @@ bool queue_is_empty(const queue_t* queue) {
         return true;
     }
     
-    return atomic_load(&queue->count) == 0;
+    /* Same test as queue_dequeue: is the element at tail published yet? */
+    queue_t* q = (queue_t*)queue;
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    for (;;) {
+        size_t seq = atomic_load_explicit(&q->sequence[pos & q->mask], memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - (pos + 1));
+        
+        if (diff == 0) {
+            return false;
+        }
+        if (diff < 0) {
+            return true;
+        }
+        pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    }
 }
 
 bool queue_is_full(const queue_t* queue) {
@@ -184,7 +224,21 @@ bool queue_is_full(const queue_t* queue) {
         return false;
     }
     
-    return atomic_load(&queue->count) >= queue->capacity;
+    /* Same test as queue_enqueue: has the slot at head been released? */
+    queue_t* q = (queue_t*)queue;
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    for (;;) {
+        size_t seq = atomic_load_explicit(&q->sequence[pos & q->mask], memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+        
+        if (diff == 0) {
+            return false;
+        }
+        if (diff < 0) {
+            return true;
+        }
+        pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    }
 }
 
 size_t queue_size(const queue_t* queue) {
@@ -192,7 +246,15 @@ size_t queue_size(const queue_t* queue) {
         return 0;
     }
     
-    return atomic_load(&queue->count);
+    /* Claimed positions, including copies still in flight, so only an
+     * estimate under concurrency; clamp the transient tail-ahead-of-head
+     * reading */
+    size_t tail = atomic_load((atomic_size_t*)&queue->tail);
+    size_t head = atomic_load((atomic_size_t*)&queue->head);
+    if ((ptrdiff_t)(head - tail) <= 0) {
+        return 0;
+    }
+    return head - tail < queue->capacity ? head - tail : queue->capacity;
 }
 
 size_t queue_capacity(const queue_t* queue) {
@@ -211,7 +273,7 @@ void queue_clear(queue_t* queue) {
     /* Reset atomics */
     atomic_store(&queue->head, 0);
     atomic_store(&queue->tail, 0);
-    atomic_store(&queue->count, 0);
+    reset_sequences(queue);
     
     /* Zero the buffer */
     memset(queue->buffer, 0, queue->capacity * queue->element_size);
@@ -13,11 +13,80 @@ extern "C" {
 
 #include "common/types.h"
 #include "common/errors.h"
+#include <stdatomic.h>
 
 /* Forward declarations */
 struct protocol_adapter;
 typedef struct protocol_adapter protocol_adapter_t;
 
+/* Statistics limits */
+#define PAL_STATS_MAX_THREADS 64        /**< Thread slots per adapter (shared beyond) */
+#define PAL_STATS_CACHE_LINE 64         /**< Cell alignment */
+#define PAL_STATS_MAX_ERROR_CODES 16    /**< Distinct error codes tracked per thread */
+#define PAL_STATS_LATENCY_BUCKETS 16    /**< Decode latency buckets */
+#define PAL_STATS_LATENCY_MIN_SHIFT 8   /**< First bucket holds decodes under 2^8 ns */
+
+/**
+ * @brief Per-thread adapter counters
+ *
+ * Each thread writes only its own cell, so updates are relaxed atomic adds
+ * on a cache line no other writer touches. Readers sum all cells.
+ */
+typedef struct {
+    atomic_uint_fast64_t packets_decoded;
+    atomic_uint_fast64_t bytes_decoded;
+    atomic_uint_fast64_t packets_encoded;
+    atomic_uint_fast64_t bytes_encoded;
+    atomic_uint_fast64_t decode_errors;
+    atomic_uint_fast64_t encode_errors;
+    atomic_uint_fast64_t errors_other;  /* Codes beyond PAL_STATS_MAX_ERROR_CODES */
+    atomic_int error_codes[PAL_STATS_MAX_ERROR_CODES];   /* 0 = free entry */
+    atomic_uint_fast64_t error_counts[PAL_STATS_MAX_ERROR_CODES];
+    atomic_uint_fast64_t decode_latency[PAL_STATS_LATENCY_BUCKETS];
+    atomic_uint_fast64_t decode_latency_sum_ns;
+} pal_stats_counters_t;
+
+typedef union {
+    pal_stats_counters_t counters;
+    char pad[(sizeof(pal_stats_counters_t) + PAL_STATS_CACHE_LINE - 1) /
+             PAL_STATS_CACHE_LINE * PAL_STATS_CACHE_LINE];
+} pal_stats_cell_t;
+
+/**
+ * @brief Statistics storage of one registered adapter
+ */
+typedef struct {
+    pal_stats_cell_t cells[PAL_STATS_MAX_THREADS];
+} pal_stats_t;
+
+/**
+ * @brief Merged adapter statistics
+ */
+typedef struct {
+    uint64_t packets_decoded;          /**< Packets decoded successfully */
+    uint64_t bytes_decoded;            /**< Bytes of those packets */
+    uint64_t packets_encoded;          /**< Messages encoded successfully */
+    uint64_t bytes_encoded;            /**< Bytes written for them */
+    uint64_t decode_errors;            /**< Failed decodes */
+    uint64_t encode_errors;            /**< Failed encodes */
+    
+    /* Failures by result code, in first-seen order */
+    struct {
+        paumiot_result_t code;
+        uint64_t count;
+    } errors[PAL_STATS_MAX_ERROR_CODES];
+    size_t num_error_codes;            /**< Entries used in errors */
+    uint64_t errors_other;             /**< Failures not broken down by code */
+    
+    /**
+     * Decode latency: bucket i counts decodes (successful or not) that took
+     * less than 2^(PAL_STATS_LATENCY_MIN_SHIFT + i) ns; the last bucket also
+     * takes everything slower.
+     */
+    uint64_t decode_latency[PAL_STATS_LATENCY_BUCKETS];
+    uint64_t decode_latency_sum_ns;    /**< Total decode time */
+} pal_adapter_stats_t;
+
 /**
  * @brief PAL configuration structure
  */
@@ -122,6 +191,9 @@ struct protocol_adapter {
     
     /* Private adapter data */
     void *private_data;  /**< Adapter-specific private data */
+    
+    /* Statistics, allocated while the adapter is registered with a context */
+    pal_stats_t *stats;  /**< Per-thread counters (NULL when unregistered) */
 };
 
 /**
@@ -140,7 +212,7 @@ struct pal_context {
     pal_config_t *config;             /**< PAL configuration */
     
     /* Statistics */
-    system_stats_t stats;             /**< PAL statistics */
+    system_stats_t stats;             /**< Totals of adapters already unregistered */
 };
 
 /* PAL management functions */
@@ -223,6 +295,45 @@ paumiot_result_t pal_encode_message(
     size_t *bytes_written
 );
 
+/**
+ * @brief Get PAL statistics
+ * 
+ * Sums the counters of every registered adapter with those of adapters
+ * unregistered earlier. Decode and encode failures of all adapters are
+ * reported together in errors.
+ * 
+ * @param ctx PAL context
+ * @param stats Output statistics
+ * @return PAUMIOT_SUCCESS on success, error code on failure
+ */
+paumiot_result_t pal_get_stats(pal_context_t *ctx, system_stats_t *stats);
+
+/**
+ * @brief Get the statistics of one registered adapter
+ * 
+ * @param ctx PAL context
+ * @param protocol_type Protocol type of the adapter
+ * @param stats Output statistics
+ * @return PAUMIOT_SUCCESS on success, error code on failure
+ */
+paumiot_result_t pal_get_adapter_stats(pal_context_t *ctx, protocol_type_t protocol_type,
+                                       pal_adapter_stats_t *stats);
+
+/**
+ * @brief Slot of the calling thread in pal_stats_t.cells
+ * 
+ * @return Slot index below PAL_STATS_MAX_THREADS
+ */
+unsigned pal_stats_thread_slot(void);
+
+/**
+ * @brief Count a failed decode or encode under its result code
+ * 
+ * @param adapter Adapter instance
+ * @param result Failure code
+ */
+void pal_stats_record_error(const protocol_adapter_t *adapter, paumiot_result_t result);
+
 /* Utility functions */
 
 /**
@@ -293,10 +404,13 @@ paumiot_result_t message_generate_timestamp(char *buffer, size_t buf_len);
         } \
     } while(0)
 
-#define ADAPTER_UPDATE_STATS(adapter, field) \
+/* Add amount to a pal_stats_counters_t field of the calling thread's cell */
+#define ADAPTER_UPDATE_STATS(adapter, field, amount) \
     do { \
-        if (adapter && adapter->private_data) { \
-            /* Update adapter statistics */ \
+        if ((adapter) && (adapter)->stats) { \
+            atomic_fetch_add_explicit( \
+                &(adapter)->stats->cells[pal_stats_thread_slot()].counters.field, \
+                (uint64_t)(amount), memory_order_relaxed); \
         } \
     } while(0)
 
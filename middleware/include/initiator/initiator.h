@@ -76,6 +76,11 @@ struct initiator_config {
     /* Rate Limiting */
     uint32_t global_rate_limit;     /* Global requests per second */
     uint32_t per_client_rate_limit; /* Per-client requests per second */
+
+    /* Admission Control (see paumiot_admission.h) */
+    uint32_t connect_rate_limit;    /* Handshakes started per second (0 = unlimited) */
+    uint32_t connect_burst;         /* Handshakes started back to back after a lull */
+    uint32_t admission_queue_size;  /* Connections waiting to start a handshake */
     
     /* Protocol Detection */
     bool fast_protocol_detect;      /* Enable fast first-byte detection */
@@ -0,0 +1,148 @@
+/**
+ * @file paumiot_admission.h
+ * @brief PaumIoT Middleware - CONNECT admission control for the initiator
+ * @details When a gateway restarts, every device reconnects at once and the
+ *          TLS and MQTT handshakes alone saturate the CPU. The initiator
+ *          asks for admission before starting a handshake. Handshakes are
+ *          admitted at [network] connect_rate_limit per second, with bursts
+ *          of up to connect_burst. The rest wait in a queue of
+ *          admission_queue_size connections, or are refused once it is full.
+ *
+ *          Sessions the gateway already holds (a device resuming a
+ *          persistent session) queue ahead of new ones, so devices that
+ *          were serving traffic come back first. Queued connections that
+ *          wait longer than connection_timeout_ms are handed back expired
+ *          rather than admitted, as their clients have given up.
+ *
+ *          The limiter is a GCRA token bucket kept as one timestamp, so
+ *          admission costs a comparison and no timer runs while the queue
+ *          is empty. All calls are thread safe.
+ */
+
+#ifndef PAUMIOT_ADMISSION_H
+#define PAUMIOT_ADMISSION_H
+
+#include "paumiot_core.h"
+#include "initiator/initiator.h"
+#include "metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Forward Declarations */
+typedef struct paumiot_admission paumiot_admission_t;
+
+/* Answer to an admission request */
+typedef enum {
+    PAUMIOT_ADMIT_NOW = 0,          /* Start the handshake */
+    PAUMIOT_ADMIT_QUEUED = 1,       /* Wait for paumiot_admission_poll() */
+    PAUMIOT_ADMIT_REJECTED = 2      /* Queue full: refuse (CONNACK 0x03) and close */
+} paumiot_admit_t;
+
+/* Connection handed out by paumiot_admission_poll() */
+typedef struct {
+    void *connection;               /* Value given to paumiot_admission_request() */
+    bool expired;                   /* Waited too long: close instead of admitting */
+} paumiot_admission_entry_t;
+
+/* Statistics */
+typedef struct {
+    uint64_t admitted;              /* Handshakes started */
+    uint64_t queued;                /* Requests that had to wait */
+    uint64_t rejected;              /* Refused with the queue full */
+    uint64_t expired;               /* Timed out in the queue */
+    uint32_t queue_depth;           /* Connections waiting now */
+    double admit_rate;              /* Handshakes admitted per second, recently */
+} paumiot_admission_stats_t;
+
+/* ============================================================================
+ * ADMISSION API
+ * ========================================================================= */
+
+/**
+ * @brief Create an admission controller
+ * @details Exports paumiot_initiator_connects_{admitted,queued,rejected,
+ *          expired}_total and the gauges paumiot_initiator_admission_rate,
+ *          paumiot_initiator_admission_rate_limit and
+ *          paumiot_initiator_admission_queue_depth.
+ * @param config Initiator configuration (connect_rate_limit, connect_burst,
+ *        admission_queue_size, connection_timeout_ms; 0 rate = unlimited)
+ * @param metrics Registry for the metrics (NULL = not exported)
+ * @return Controller, or NULL on allocation failure
+ */
+paumiot_admission_t *paumiot_admission_create(const initiator_config_t *config,
+                                              metrics_registry_t *metrics);
+
+/**
+ * @brief Destroy a controller; queued connections are forgotten
+ * @param admission Controller (can be NULL)
+ */
+void paumiot_admission_destroy(paumiot_admission_t *admission);
+
+/**
+ * @brief Apply reloaded limits
+ * @details A larger admission_queue_size grows the queue, keeping who is
+ *          waiting; a smaller one only refuses new requests until it
+ *          drains below the limit.
+ * @param admission Controller
+ * @param config Initiator configuration
+ */
+void paumiot_admission_configure(paumiot_admission_t *admission,
+                                 const initiator_config_t *config);
+
+/**
+ * @brief Ask to start a handshake
+ * @param admission Controller
+ * @param connection Caller's handle, returned by paumiot_admission_poll()
+ * @param established true if the client resumes a session the gateway holds
+ * @param now_ns CLOCK_MONOTONIC time
+ * @return PAUMIOT_ADMIT_NOW, PAUMIOT_ADMIT_QUEUED or PAUMIOT_ADMIT_REJECTED
+ */
+paumiot_admit_t paumiot_admission_request(paumiot_admission_t *admission, void *connection,
+                                          bool established, uint64_t now_ns);
+
+/**
+ * @brief Take the queued connections that may proceed or have expired
+ * @details Established sessions come first, then new ones, each in arrival
+ *          order. Call when paumiot_admission_next_ms() has elapsed.
+ * @param admission Controller
+ * @param now_ns CLOCK_MONOTONIC time
+ * @param entries Receives the connections
+ * @param max_entries Capacity of entries
+ * @return Number of entries filled
+ */
+size_t paumiot_admission_poll(paumiot_admission_t *admission, uint64_t now_ns,
+                              paumiot_admission_entry_t *entries, size_t max_entries);
+
+/**
+ * @brief Time until paumiot_admission_poll() has something to hand out
+ * @param admission Controller
+ * @param now_ns CLOCK_MONOTONIC time
+ * @return Milliseconds (0 = now), or -1 if the queue is empty
+ */
+int paumiot_admission_next_ms(paumiot_admission_t *admission, uint64_t now_ns);
+
+/**
+ * @brief Drop a queued connection whose client went away
+ * @details Scans the queue; meant for the rare close while waiting.
+ * @param admission Controller
+ * @param connection Handle given to paumiot_admission_request()
+ * @return true if it was queued
+ */
+bool paumiot_admission_cancel(paumiot_admission_t *admission, void *connection);
+
+/**
+ * @brief Get statistics
+ * @param admission Controller
+ * @param now_ns CLOCK_MONOTONIC time
+ * @param stats Statistics output
+ */
+void paumiot_admission_get_stats(paumiot_admission_t *admission, uint64_t now_ns,
+                                 paumiot_admission_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_ADMISSION_H */
@@ -0,0 +1,285 @@
+/**
+ * @file paumiot_config.h
+ * @brief PaumIoT Middleware - Configuration file loading
+ * @details paumiot.conf is a subset of TOML:
+ *
+ *            # comment
+ *            [section]            or [section.subsection]
+ *            key = "string"       escapes: \" \\ \n \t
+ *            key = 42             underscores allowed: 10_000
+ *            key = true | false
+ *            key = [0, 2, "4-7"]  single-line arrays
+ *
+ *          Sizes accept B, KB, MB, GB and TB suffixes (powers of 1024, KiB
+ *          etc. also accepted), e.g. "512MB". Durations accept us, ms, s, m,
+ *          h, d and w, e.g. "30d"; bare numbers use the unit the setting is
+ *          documented in (seconds for most timeouts). Unknown sections and
+ *          keys are ignored so the file can carry settings for components
+ *          not built into this binary.
+ *
+ *          The file is parsed in one pass into the runtime configuration,
+ *          which keeps every layer's settings in a single allocation.
+ *
+ *          A configuration store publishes the running configuration as an
+ *          immutable snapshot. Readers take it with one acquire load inside
+ *          an RCU read-side section; a reload (SIGHUP or an admin request)
+ *          parses and validates a new snapshot, swaps the pointer and frees
+ *          the old one after a grace period, so the data path never stops.
+ *          Components pick up reloaded settings through listeners; those
+ *          for the sensor manager and admission control are provided here.
+ */
+
+#ifndef PAUMIOT_CONFIG_H
+#define PAUMIOT_CONFIG_H
+
+#include "paumiot_core.h"
+#include "paumiot_placement.h"
+#include "engine/engine.h"
+#include "state/state_management.h"
+#include "initiator/initiator.h"
+#include "sensor_manager/sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest configuration file accepted */
+#define PAUMIOT_CONFIG_MAX_FILE_SIZE (1024 * 1024)
+
+/* Where and why loading or validation failed */
+typedef struct {
+    uint32_t line;                  /* 1-based line (0 = not tied to a line) */
+    char message[128];
+} paumiot_config_error_t;
+
+/* Configuration of every layer */
+typedef struct {
+    paumiot_config_t core;          /* Also holds the string storage */
+    engine_config_t engine;
+    state_config_t state;
+    initiator_config_t initiator;
+    sensor_manager_config_t sensor_manager;
+
+    /* sensor_manager.dispatch_cpus, set by paumiot_runtime_config_place() */
+    int16_t dispatch_cpus[PAUMIOT_MAX_WORKER_THREADS];
+} paumiot_runtime_config_t;
+
+/* Most reload listeners per store */
+#define PAUMIOT_CONFIG_MAX_LISTENERS 8
+
+/* Forward Declarations */
+typedef struct paumiot_config_store paumiot_config_store_t;
+
+/**
+ * @brief Called after a new configuration has been published
+ * @details Runs on the reloading thread. `previous` stays valid until the
+ *          listener returns; neither snapshot may be modified.
+ */
+typedef void (*paumiot_config_listener_t)(const paumiot_runtime_config_t *previous,
+                                          const paumiot_runtime_config_t *current,
+                                          void *user_data);
+
+/* ============================================================================
+ * RUNTIME CONFIGURATION API
+ * ========================================================================= */
+
+/**
+ * @brief Initialize every layer's configuration with defaults
+ * @param config Configuration to initialize
+ */
+void paumiot_runtime_config_init(paumiot_runtime_config_t *config);
+
+/**
+ * @brief Apply configuration text
+ * @details Settings not present keep their current values.
+ * @param text Configuration text (need not be NUL-terminated)
+ * @param len Length of `text`
+ * @param config Configuration to update (may be partially updated on error)
+ * @param error Receives the failing line and reason (can be NULL)
+ * @return PAUMIOT_SUCCESS or PAUMIOT_ERROR_INVALID_PARAM
+ */
+paumiot_result_t paumiot_runtime_config_parse(const char *text, size_t len,
+                                              paumiot_runtime_config_t *config,
+                                              paumiot_config_error_t *error);
+
+/**
+ * @brief Apply a configuration file
+ * @param path Path to paumiot.conf
+ * @param config Configuration to update (may be partially updated on error)
+ * @param error Receives the failing line and reason (can be NULL)
+ * @return PAUMIOT_SUCCESS, PAUMIOT_ERROR_INVALID_PARAM for malformed
+ *         settings, or PAUMIOT_ERROR_OPERATION_FAILED if the file cannot be read
+ */
+paumiot_result_t paumiot_runtime_config_load(const char *path,
+                                             paumiot_runtime_config_t *config,
+                                             paumiot_config_error_t *error);
+
+/**
+ * @brief Check settings and their consistency across layers
+ * @param config Configuration to validate
+ * @param error Receives the first problem found (can be NULL)
+ * @return PAUMIOT_SUCCESS if valid, PAUMIOT_ERROR_INVALID_PARAM otherwise
+ */
+paumiot_result_t paumiot_runtime_config_validate(const paumiot_runtime_config_t *config,
+                                                 paumiot_config_error_t *error);
+
+/**
+ * @brief Pin the sensor dispatch workers where placement puts workers
+ * @details Plans [performance] io_threads, worker_threads and cpu_affinity
+ *          with paumiot_placement_plan() and points
+ *          sensor_manager.dispatch_cpus at the planned worker CPUs, kept in
+ *          the configuration itself. Without cpu_affinity the workers stay
+ *          unpinned. Configuration stores do this for every snapshot they
+ *          load, before anything is started from it.
+ * @param config Validated configuration
+ * @param topology Usable CPUs and nodes, or NULL to discover them
+ * @param error Receives the reason placement failed (can be NULL)
+ * @return PAUMIOT_SUCCESS, or PAUMIOT_ERROR_INVALID_PARAM if cpu_affinity
+ *         lists a CPU that cannot be used
+ */
+paumiot_result_t paumiot_runtime_config_place(paumiot_runtime_config_t *config,
+                                              const cpu_topology_t *topology,
+                                              paumiot_config_error_t *error);
+
+/**
+ * @brief Check whether moving to a configuration needs a restart
+ * @details Only settings something applies live may change: the log
+ *          level, the CONNECT admission limits ([network] connect_rate_limit,
+ *          connect_burst, admission_queue_size, connection_timeout), cache
+ *          TTLs and [dal] compression_enabled. Everything else is fixed
+ *          when components start.
+ * @param running Configuration in use
+ * @param updated Configuration to move to
+ * @param error Receives the first setting that differs and needs a restart
+ *        (can be NULL)
+ * @return true if a setting that needs a restart differs
+ */
+bool paumiot_runtime_config_needs_restart(const paumiot_runtime_config_t *running,
+                                          const paumiot_runtime_config_t *updated,
+                                          paumiot_config_error_t *error);
+
+/**
+ * @brief Parse a size such as "512MB" into bytes
+ * @param text Size text
+ * @param bytes Receives the size
+ * @return true if `text` is a valid size
+ */
+bool paumiot_config_parse_size(const char *text, uint64_t *bytes);
+
+/**
+ * @brief Parse a duration such as "30d" into microseconds
+ * @param text Duration text
+ * @param default_unit_us Unit of a bare number, in microseconds
+ * @param us Receives the duration
+ * @return true if `text` is a valid duration
+ */
+bool paumiot_config_parse_duration(const char *text, uint64_t default_unit_us, uint64_t *us);
+
+/* ============================================================================
+ * CONFIGURATION STORE API
+ * ========================================================================= */
+
+/**
+ * @brief Load, validate and publish a configuration file
+ * @param path Path to paumiot.conf (reloads read it again)
+ * @param error Receives the failing line and reason (can be NULL)
+ * @return Store instance or NULL if the file is unreadable or invalid
+ */
+paumiot_config_store_t *paumiot_config_store_create(const char *path,
+                                                    paumiot_config_error_t *error);
+
+/**
+ * @brief Destroy a store
+ * @details Stops the SIGHUP watcher if running. No reader may still hold
+ *          a snapshot.
+ * @param store Store instance (can be NULL)
+ */
+void paumiot_config_store_destroy(paumiot_config_store_t *store);
+
+/**
+ * @brief Take the current configuration
+ * @details Wait-free: one counter increment and one acquire load. Hold the
+ *          snapshot only briefly (e.g. per message); a reload waits for it
+ *          before freeing the previous one. Do not reload while holding it.
+ * @param store Store instance
+ * @param token Receives the value to pass to paumiot_config_store_release()
+ * @return Current configuration (never NULL)
+ */
+const paumiot_runtime_config_t *paumiot_config_store_acquire(paumiot_config_store_t *store,
+                                                             unsigned *token);
+
+/**
+ * @brief Release a configuration taken with paumiot_config_store_acquire()
+ * @param store Store instance
+ * @param token Value returned through paumiot_config_store_acquire()
+ */
+void paumiot_config_store_release(paumiot_config_store_t *store, unsigned token);
+
+/**
+ * @brief Number of configurations published, starting at 1
+ * @param store Store instance
+ * @return Generation of the current configuration
+ */
+uint64_t paumiot_config_store_generation(paumiot_config_store_t *store);
+
+/**
+ * @brief Register a listener for published configurations
+ * @param store Store instance
+ * @param listener Listener callback
+ * @param user_data User data for the listener
+ * @return PAUMIOT_SUCCESS, or PAUMIOT_ERROR_OUT_OF_MEMORY if
+ *         PAUMIOT_CONFIG_MAX_LISTENERS are registered
+ */
+paumiot_result_t paumiot_config_store_add_listener(paumiot_config_store_t *store,
+                                                   paumiot_config_listener_t listener,
+                                                   void *user_data);
+
+/**
+ * @brief Re-read the configuration file and publish it
+ * @details The running configuration is kept if the file is unreadable,
+ *          invalid, or changes a setting that needs a restart. On success
+ *          the log level is applied, listeners run, and the call returns
+ *          once no reader can still see the previous configuration.
+ * @param store Store instance
+ * @param error Receives the failing line and reason (can be NULL)
+ * @return PAUMIOT_SUCCESS, PAUMIOT_ERROR_INVALID_PARAM for an invalid or
+ *         incompatible file, or PAUMIOT_ERROR_OPERATION_FAILED if the file
+ *         cannot be read
+ */
+paumiot_result_t paumiot_config_store_reload(paumiot_config_store_t *store,
+                                             paumiot_config_error_t *error);
+
+/**
+ * @brief Listener that applies reloads to a sensor manager
+ * @details Register with paumiot_config_store_add_listener(), passing the
+ *          sensor manager as user data. Calls sensor_manager_reconfigure().
+ */
+void paumiot_config_apply_sensor_manager(const paumiot_runtime_config_t *previous,
+                                         const paumiot_runtime_config_t *current,
+                                         void *sensor_manager);
+
+/**
+ * @brief Listener that applies reloads to CONNECT admission control
+ * @details Register with paumiot_config_store_add_listener(), passing the
+ *          paumiot_admission_t as user data. Calls paumiot_admission_configure().
+ */
+void paumiot_config_apply_admission(const paumiot_runtime_config_t *previous,
+                                    const paumiot_runtime_config_t *current,
+                                    void *admission);
+
+/**
+ * @brief Reload on SIGHUP
+ * @details Installs a SIGHUP handler that wakes a watcher thread, which
+ *          calls paumiot_config_store_reload() and logs the outcome. Only
+ *          one store per process can watch SIGHUP.
+ * @param store Store instance
+ * @return PAUMIOT_SUCCESS, PAUMIOT_ERROR_ALREADY_INITIALIZED if a store is
+ *         already watching, or PAUMIOT_ERROR_OPERATION_FAILED
+ */
+paumiot_result_t paumiot_config_store_watch_sighup(paumiot_config_store_t *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_CONFIG_H */
@@ -64,22 +64,26 @@ typedef enum {
     OPERATION_DELETE = 6    /* CoAP DELETE */
 } operation_type_t;
 
+/* Limits of the loaded configuration */
+#define PAUMIOT_MAX_AFFINITY_CPUS 64            /* CPUs in cpu_affinity */
+#define PAUMIOT_MAX_CPU_ID 1024                 /* Highest CPU number + 1 */
+#define PAUMIOT_CONFIG_STRING_STORAGE 2048      /* Bytes for loaded string values */
+
 /* Server Configuration */
 struct paumiot_config {
+    /* Hot-path Settings (checked per message: kept in the first cache line) */
+    uint32_t io_threads;
+    uint32_t worker_threads;
+    uint32_t max_queue_size;
+    uint32_t request_timeout_ms;
+    size_t memory_limit;            /* Bytes (0 = unlimited) */
+
     /* Network Settings */
     const char *host;
     uint16_t mqtt_port;
     uint16_t coap_port;
     uint16_t http_port;
     
-    /* Threading */
-    uint32_t io_threads;
-    uint32_t worker_threads;
-    
-    /* Engine Settings */
-    uint32_t max_queue_size;
-    uint32_t request_timeout_ms;
-    
     /* State Management */
     const char *state_backend;      /* "memory", "redis", "persistent" */
     bool state_persistence;
@@ -103,6 +107,21 @@ struct paumiot_config {
     const char *cert_file;
     const char *key_file;
     const char *ca_file;
+
+    /* Monitoring */
+    bool metrics_enabled;           /* Serve metrics over HTTP */
+    uint16_t metrics_port;
+    const char *metrics_endpoint;   /* Path of the Prometheus text exposition */
+    const char *health_endpoint;    /* Path answering "OK" */
+
+    /* CPU Placement */
+    uint16_t cpu_affinity_count;    /* CPUs listed (0 = no pinning) */
+    uint16_t cpu_affinity[PAUMIOT_MAX_AFFINITY_CPUS];
+
+    /* Storage for strings read by paumiot_config_load (string fields point
+     * here, so a loaded configuration must not be copied by value) */
+    char string_storage[PAUMIOT_CONFIG_STRING_STORAGE];
+    size_t string_storage_used;
 };
 
 /* Statistics */
@@ -178,15 +197,22 @@ paumiot_result_t paumiot_reset_stats(paumiot_context_t *ctx);
 void paumiot_config_init(paumiot_config_t *config);
 
 /**
- * @brief Load configuration from YAML file
+ * @brief Load configuration from a paumiot.conf file
+ * @details Settings missing from the file keep their current values, so
+ *          call paumiot_config_init() first. See paumiot_config.h for the
+ *          file format and for loading every layer's configuration at once.
+ *          The result is checked with paumiot_config_validate().
  * @param path Path to configuration file
- * @param config Configuration output
- * @return PAUMIOT_SUCCESS on success, error code otherwise
+ * @param config Configuration output (may be partially updated on error)
+ * @return PAUMIOT_SUCCESS on success, PAUMIOT_ERROR_INVALID_PARAM for
+ *         malformed or invalid settings, PAUMIOT_ERROR_OPERATION_FAILED if
+ *         the file cannot be read
  */
 paumiot_result_t paumiot_config_load(const char *path, paumiot_config_t *config);
 
 /**
  * @brief Validate configuration
+ * @details The first problem found is logged.
  * @param config Configuration to validate
  * @return PAUMIOT_SUCCESS if valid, error code otherwise
  */
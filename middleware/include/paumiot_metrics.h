@@ -0,0 +1,70 @@
+/**
+ * @file paumiot_metrics.h
+ * @brief PaumIoT Middleware - Prometheus /metrics endpoint
+ * @details A small HTTP/1.x responder for [monitoring]. GET on
+ *          metrics_endpoint renders a metrics registry in the Prometheus
+ *          text format; GET on health_endpoint answers "OK". Each request is
+ *          answered on the server's own thread and the connection closed.
+ *          A connection gets PAUMIOT_METRICS_IO_TIMEOUT_MS in total, so a
+ *          slow client delays other scrapes by at most that long and never
+ *          delays paumiot_metrics_server_stop().
+ *
+ *          Rendering sums the per-thread cells of every counter and
+ *          histogram; the data path is never locked or paused by a scrape.
+ */
+
+#ifndef PAUMIOT_METRICS_SERVER_H
+#define PAUMIOT_METRICS_SERVER_H
+
+#include "paumiot_core.h"
+#include "metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest request head accepted */
+#define PAUMIOT_METRICS_MAX_REQUEST 4096
+
+/* Time allowed for a whole connection, from accept to close (ms) */
+#define PAUMIOT_METRICS_IO_TIMEOUT_MS 2000
+
+/* Most unread input discarded after responding */
+#define PAUMIOT_METRICS_MAX_DRAIN (64 * 1024)
+
+/* Forward Declarations */
+typedef struct paumiot_metrics_server paumiot_metrics_server_t;
+
+/* ============================================================================
+ * METRICS SERVER API
+ * ========================================================================= */
+
+/**
+ * @brief Start serving a registry
+ * @details Listens on config->host, port config->metrics_port (0 picks a free
+ *          port). The caller checks config->metrics_enabled.
+ * @param config Core configuration (endpoint paths are copied)
+ * @param registry Registry to expose (must outlive the server)
+ * @return Server instance or NULL if the address cannot be bound
+ */
+paumiot_metrics_server_t *paumiot_metrics_server_start(const paumiot_config_t *config,
+                                                       metrics_registry_t *registry);
+
+/**
+ * @brief Get the port the server listens on
+ * @param server Server instance
+ * @return Port number
+ */
+uint16_t paumiot_metrics_server_port(const paumiot_metrics_server_t *server);
+
+/**
+ * @brief Stop the server and free it
+ * @param server Server instance (can be NULL)
+ */
+void paumiot_metrics_server_stop(paumiot_metrics_server_t *server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_METRICS_SERVER_H */
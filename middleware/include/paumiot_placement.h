@@ -0,0 +1,95 @@
+/**
+ * @file paumiot_placement.h
+ * @brief PaumIoT Middleware - Thread placement across CPUs and NUMA nodes
+ * @details Turns [performance] io_threads, worker_threads and cpu_affinity
+ *          into a CPU for every I/O reactor and worker. Both kinds of thread
+ *          are spread over the NUMA nodes in proportion to their CPUs, with
+ *          at least one of each per node when there are enough threads, and
+ *          workers are numbered node by node. A reactor hands a connection
+ *          to a worker on its own node (paumiot_placement_worker_for_node),
+ *          so its buffers are never touched from the other socket. The
+ *          sensor dispatch workers take the worker CPUs through
+ *          paumiot_runtime_config_place().
+ *
+ *          Pools and queues a thread owns should be allocated and first
+ *          written by that thread after it pins itself, so the kernel places
+ *          their pages on the thread's node.
+ */
+
+#ifndef PAUMIOT_PLACEMENT_H
+#define PAUMIOT_PLACEMENT_H
+
+#include "paumiot_core.h"
+#include "cpu_topology.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Thread limits (as enforced by configuration validation) */
+#define PAUMIOT_MAX_IO_THREADS 256
+#define PAUMIOT_MAX_WORKER_THREADS 1024
+
+/* CPU of each I/O reactor and worker */
+typedef struct {
+    uint32_t io_threads;
+    uint32_t worker_threads;
+    uint16_t num_nodes;                                 /* Nodes used */
+
+    int16_t io_cpu[PAUMIOT_MAX_IO_THREADS];             /* CPU per reactor */
+    uint16_t io_node[PAUMIOT_MAX_IO_THREADS];           /* Node index per reactor */
+    int16_t worker_cpu[PAUMIOT_MAX_WORKER_THREADS];     /* CPU per worker */
+    uint16_t worker_node[PAUMIOT_MAX_WORKER_THREADS];   /* Node index per worker */
+
+    uint32_t node_first_worker[CPU_TOPOLOGY_MAX_NODES]; /* Workers of a node are */
+    uint32_t node_workers[CPU_TOPOLOGY_MAX_NODES];      /* contiguous */
+} paumiot_placement_t;
+
+/* ============================================================================
+ * PLACEMENT API
+ * ========================================================================= */
+
+/**
+ * @brief Assign CPUs to reactors and workers
+ * @details With an empty cpu_affinity list every usable CPU in `topology`
+ *          is available. Reactors take the first CPUs of their node and
+ *          workers the rest; threads share CPUs only when a node has fewer
+ *          CPUs than threads.
+ * @param config Core configuration (io_threads, worker_threads, cpu_affinity)
+ * @param topology Usable CPUs and nodes
+ * @param placement Receives the assignment
+ * @return PAUMIOT_SUCCESS, or PAUMIOT_ERROR_INVALID_PARAM if a thread count
+ *         is out of range or cpu_affinity lists a CPU that cannot be used
+ */
+paumiot_result_t paumiot_placement_plan(const paumiot_config_t *config,
+                                        const cpu_topology_t *topology,
+                                        paumiot_placement_t *placement);
+
+/**
+ * @brief Pick the worker for a connection that arrived on a node
+ * @param placement Placement
+ * @param node Node index of the receiving reactor (see io_node)
+ * @param hash Connection hash (same hash = same worker)
+ * @return Worker index on `node`, or on any node if it has no workers
+ */
+uint32_t paumiot_placement_worker_for_node(const paumiot_placement_t *placement,
+                                           uint16_t node, uint32_t hash);
+
+/**
+ * @brief Pick the worker for a connection whose packets arrive on a CPU
+ * @details For use with SO_INCOMING_CPU or the reactor's own CPU.
+ * @param placement Placement
+ * @param topology Topology the placement was planned with
+ * @param cpu Receiving CPU (-1 = unknown)
+ * @param hash Connection hash
+ * @return Worker index on the CPU's node, or on any node if unknown
+ */
+uint32_t paumiot_placement_worker_for_cpu(const paumiot_placement_t *placement,
+                                          const cpu_topology_t *topology,
+                                          int cpu, uint32_t hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_PLACEMENT_H */
@@ -0,0 +1,155 @@
+/**
+ * @file sensor_aggregator.h
+ * @brief Sensor Manager - Streaming windowed aggregation
+ * @details Keeps per-sensor tumbling or sliding windows in constant memory.
+ *          A window is split into panes of `slide_ms`; each pane keeps
+ *          count/sum/min/max/last and a t-digest, and closing a window
+ *          combines the panes it covers into one sensor_aggregate_t.
+ *          Windows are aligned to multiples of `slide_ms` in event time and
+ *          close when a later point arrives or the aggregator is advanced.
+ */
+
+#ifndef PAUMIOT_SENSOR_AGGREGATOR_H
+#define PAUMIOT_SENSOR_AGGREGATOR_H
+
+#include "sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Upper bound on panes per window (window_ms / slide_ms) */
+#ifndef SENSOR_AGGREGATOR_MAX_PANES
+#define SENSOR_AGGREGATOR_MAX_PANES 60
+#endif
+
+/* Forward Declarations */
+typedef struct sensor_aggregator sensor_aggregator_t;
+typedef struct agg_series sensor_aggregator_series_t;
+
+/* Aggregate of one closed window */
+struct sensor_aggregate {
+    const char *sensor_id;          /* Source sensor ID */
+    uint64_t window_start;          /* Window start (inclusive, epoch ms) */
+    uint64_t window_end;            /* Window end (exclusive, epoch ms) */
+    uint64_t count;                 /* Number of samples */
+    double sum;
+    double min;
+    double max;
+    double mean;
+    double last;                    /* Latest sample by timestamp */
+    uint64_t last_timestamp;
+    double p50;                     /* Approximate quantiles (t-digest) */
+    double p90;
+    double p99;
+};
+
+/* ============================================================================
+ * SENSOR AGGREGATOR API
+ * ========================================================================= */
+
+/**
+ * @brief Create an aggregator
+ * @param window_ms Window length (> 0)
+ * @param slide_ms Window step (0 or window_ms = tumbling; must divide
+ *                 window_ms into at most SENSOR_AGGREGATOR_MAX_PANES panes)
+ * @param callback Called once per closed, non-empty window, with the
+ *                 sensor's window state locked (must not add samples for
+ *                 the same sensor)
+ * @param user_data User-defined data
+ * @return Aggregator instance or NULL on error
+ */
+sensor_aggregator_t *sensor_aggregator_create(uint32_t window_ms, uint32_t slide_ms,
+                                              sensor_aggregate_callback_t callback,
+                                              void *user_data);
+
+/**
+ * @brief Destroy aggregator (open windows are discarded)
+ * @details Every acquired reference must have been released.
+ * @param agg Aggregator instance (can be NULL)
+ */
+void sensor_aggregator_destroy(sensor_aggregator_t *agg);
+
+/**
+ * @brief Add one sample
+ * @details Samples older than the oldest open pane are dropped and counted
+ *          in sensor_aggregator_late_samples().
+ * @param agg Aggregator instance
+ * @param sensor_id Sensor identifier
+ * @param timestamp Sample timestamp (epoch ms)
+ * @param value Sample value (NaN is rejected)
+ * @return PAUMIOT_SUCCESS on success (including dropped late samples),
+ *         error code otherwise
+ */
+paumiot_result_t sensor_aggregator_add(sensor_aggregator_t *agg, const char *sensor_id,
+                                       uint64_t timestamp, double value);
+
+/**
+ * @brief Get a sensor's window state, creating it if needed
+ * @details The reference keeps the state valid across a concurrent
+ *          sensor_aggregator_remove(), after which adds through it are
+ *          discarded. Acquire while the sensor is known to exist (e.g. under
+ *          the registry lock) so a removed sensor is never recreated.
+ * @param agg Aggregator instance
+ * @param sensor_id Sensor identifier
+ * @return Referenced window state, or NULL on error
+ */
+sensor_aggregator_series_t *sensor_aggregator_acquire(sensor_aggregator_t *agg,
+                                                      const char *sensor_id);
+
+/**
+ * @brief Add one sample through an acquired reference
+ * @details As sensor_aggregator_add(); a no-op once the sensor is removed.
+ * @param agg Aggregator that owns the series
+ * @param series Reference from sensor_aggregator_acquire()
+ * @param timestamp Sample timestamp (epoch ms)
+ * @param value Sample value (NaN is rejected)
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_aggregator_add_series(sensor_aggregator_t *agg,
+                                              sensor_aggregator_series_t *series,
+                                              uint64_t timestamp, double value);
+
+/**
+ * @brief Drop a reference from sensor_aggregator_acquire()
+ * @param series Window state (can be NULL)
+ */
+void sensor_aggregator_release(sensor_aggregator_series_t *series);
+
+/**
+ * @brief Close every window that ends at or before `now_ms`
+ * @details Call periodically so idle sensors still emit their last window.
+ *          Samples for a closed window are late, so pass the current time
+ *          minus whatever delivery delay should still be accepted.
+ * @param agg Aggregator instance
+ * @param now_ms Close windows ending at or before this time (epoch ms)
+ */
+void sensor_aggregator_advance(sensor_aggregator_t *agg, uint64_t now_ms);
+
+/**
+ * @brief Drop a sensor's window state without emitting
+ * @param agg Aggregator instance
+ * @param sensor_id Sensor identifier
+ */
+void sensor_aggregator_remove(sensor_aggregator_t *agg, const char *sensor_id);
+
+/**
+ * @brief Number of late samples dropped so far
+ * @param agg Aggregator instance
+ */
+uint64_t sensor_aggregator_late_samples(const sensor_aggregator_t *agg);
+
+/**
+ * @brief Render an aggregate as a compact JSON message
+ * @param aggregate Window aggregate
+ * @param buf Output buffer
+ * @param len Buffer size
+ * @return Characters written (excluding NUL), or -1 if the buffer is too small
+ */
+int sensor_aggregate_to_json(const sensor_aggregate_t *aggregate, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_SENSOR_AGGREGATOR_H */
@@ -0,0 +1,124 @@
+/**
+ * @file sensor_cache.h
+ * @brief Sensor Manager - Concurrent last-value cache
+ * @details Fixed-slot cache keyed by sensor ID. Each slot is guarded by a
+ *          sequence lock so readers never block writers; writers only
+ *          serialize on inserts and CLOCK evictions.
+ */
+
+#ifndef PAUMIOT_SENSOR_CACHE_H
+#define PAUMIOT_SENSOR_CACHE_H
+
+#include "sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-slot inline storage limits (payloads larger than this are not cached) */
+#ifndef SENSOR_CACHE_MAX_ID
+#define SENSOR_CACHE_MAX_ID 64
+#endif
+
+#ifndef SENSOR_CACHE_MAX_TOPIC
+#define SENSOR_CACHE_MAX_TOPIC 128
+#endif
+
+#ifndef SENSOR_CACHE_MAX_PAYLOAD
+#define SENSOR_CACHE_MAX_PAYLOAD 256
+#endif
+
+/* Forward Declarations */
+typedef struct sensor_cache sensor_cache_t;
+
+/* Cached Value (copied out of a slot by value) */
+typedef struct {
+    char sensor_id[SENSOR_CACHE_MAX_ID];
+    char topic[SENSOR_CACHE_MAX_TOPIC];
+    uint8_t payload[SENSOR_CACHE_MAX_PAYLOAD];
+    size_t payload_len;
+    data_format_t format;
+    uint64_t timestamp;
+    qos_level_t qos;
+} sensor_cache_value_t;
+
+/* ============================================================================
+ * SENSOR CACHE API
+ * ========================================================================= */
+
+/**
+ * @brief Create a last-value cache
+ * @param max_entries Number of slots (must be > 0)
+ * @param max_bytes Byte budget for cached data (0 = limited by slots only)
+ * @param ttl_ms Entry time-to-live checked on read (0 = no expiry)
+ * @return Cache instance or NULL on error
+ */
+sensor_cache_t *sensor_cache_create(size_t max_entries, size_t max_bytes,
+                                    uint32_t ttl_ms);
+
+/**
+ * @brief Destroy cache
+ * @param cache Cache instance (can be NULL)
+ */
+void sensor_cache_destroy(sensor_cache_t *cache);
+
+/**
+ * @brief Insert or overwrite the last value for a sensor
+ * @param cache Cache instance
+ * @param data Sensor data (sensor_id required)
+ * @return PAUMIOT_SUCCESS on success, PAUMIOT_ERROR_NOT_SUPPORTED if the
+ *         data does not fit a slot or the byte budget (any stale entry is
+ *         dropped)
+ */
+paumiot_result_t sensor_cache_put(sensor_cache_t *cache, const sensor_data_t *data);
+
+/**
+ * @brief Read the last value for a sensor without taking any lock
+ * @param cache Cache instance
+ * @param sensor_id Sensor identifier
+ * @param value Value output (copied)
+ * @return PAUMIOT_SUCCESS on hit, SENSOR_MANAGER_ERROR_NOT_FOUND on miss,
+ *         expiry, or when a concurrent writer kept the slot busy
+ */
+paumiot_result_t sensor_cache_get(sensor_cache_t *cache, const char *sensor_id,
+                                  sensor_cache_value_t *value);
+
+/**
+ * @brief Drop a sensor's entry
+ * @param cache Cache instance
+ * @param sensor_id Sensor identifier
+ */
+void sensor_cache_remove(sensor_cache_t *cache, const char *sensor_id);
+
+/**
+ * @brief Drop all entries
+ * @param cache Cache instance
+ */
+void sensor_cache_clear(sensor_cache_t *cache);
+
+/**
+ * @brief Get number of cached entries
+ * @param cache Cache instance
+ * @return Entry count, or 0 if cache is NULL
+ */
+size_t sensor_cache_count(const sensor_cache_t *cache);
+
+/**
+ * @brief Get bytes of sensor data currently held
+ * @param cache Cache instance
+ * @return Charged bytes (ID + topic + payload per entry), or 0 if NULL
+ */
+size_t sensor_cache_memory_usage(const sensor_cache_t *cache);
+
+/**
+ * @brief Change the entry time-to-live while the cache is in use
+ * @param cache Cache instance (can be NULL)
+ * @param ttl_ms New time-to-live, applied to existing entries (0 = no expiry)
+ */
+void sensor_cache_set_ttl(sensor_cache_t *cache, uint32_t ttl_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_SENSOR_CACHE_H */
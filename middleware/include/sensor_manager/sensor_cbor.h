@@ -0,0 +1,211 @@
+/**
+ * @file sensor_cbor.h
+ * @brief Sensor Manager - Streaming CBOR (RFC 8949) encoder and decoder
+ * @details Both sides work on caller-provided buffers and never allocate.
+ *          The writer appends items and records overflow instead of failing
+ *          each call, so a document can be written without checks and
+ *          validated once at the end. The reader is pull-style: each call
+ *          returns the next item head, and string contents are returned as
+ *          pointers into the input.
+ */
+
+#ifndef PAUMIOT_SENSOR_CBOR_H
+#define PAUMIOT_SENSOR_CBOR_H
+
+#include "sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Major Types */
+#define CBOR_MAJOR_UINT   0
+#define CBOR_MAJOR_NEGINT 1
+#define CBOR_MAJOR_BYTES  2
+#define CBOR_MAJOR_TEXT   3
+#define CBOR_MAJOR_ARRAY  4
+#define CBOR_MAJOR_MAP    5
+#define CBOR_MAJOR_TAG    6
+#define CBOR_MAJOR_SIMPLE 7
+
+/* Item Types */
+typedef enum {
+    CBOR_TYPE_UINT = 0,             /* value */
+    CBOR_TYPE_NEGINT,               /* -1 - value */
+    CBOR_TYPE_BYTES,                /* data/length, or chunks follow if indefinite */
+    CBOR_TYPE_TEXT,                 /* data/length, or chunks follow if indefinite */
+    CBOR_TYPE_ARRAY,                /* value items follow, or until BREAK if indefinite */
+    CBOR_TYPE_MAP,                  /* value key/value pairs follow, or until BREAK */
+    CBOR_TYPE_TAG,                  /* value is the tag; the tagged item follows */
+    CBOR_TYPE_FALSE,
+    CBOR_TYPE_TRUE,
+    CBOR_TYPE_NULL,
+    CBOR_TYPE_UNDEFINED,
+    CBOR_TYPE_SIMPLE,               /* Other simple value in value */
+    CBOR_TYPE_FLOAT,                /* number (half, single or double on the wire) */
+    CBOR_TYPE_BREAK                 /* End of an indefinite-length item */
+} cbor_type_t;
+
+/* Decoded Item Head */
+typedef struct {
+    cbor_type_t type;
+    bool indefinite;                /* Indefinite-length string, array or map */
+    uint64_t value;                 /* Argument (see cbor_type_t) */
+    double number;                  /* CBOR_TYPE_FLOAT */
+    const uint8_t *data;            /* Definite string contents (points into input) */
+} cbor_item_t;
+
+/* Writer */
+typedef struct {
+    uint8_t *buf;
+    size_t capacity;
+    size_t len;                     /* Bytes written (or needed, after overflow) */
+    bool overflow;                  /* An item did not fit */
+} cbor_writer_t;
+
+/* Reader */
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+} cbor_reader_t;
+
+/* ============================================================================
+ * CBOR WRITER API
+ * ========================================================================= */
+
+/**
+ * @brief Start writing into a buffer
+ * @param writer Writer state
+ * @param buf Output buffer (can be NULL with capacity 0 to measure)
+ * @param capacity Buffer size
+ */
+void cbor_writer_init(cbor_writer_t *writer, uint8_t *buf, size_t capacity);
+
+/**
+ * @brief Outcome of the items written so far
+ * @return PAUMIOT_SUCCESS, or SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL if any
+ *         item overflowed (`len` then holds the size required)
+ */
+paumiot_result_t cbor_writer_result(const cbor_writer_t *writer);
+
+/**
+ * @brief Append pre-encoded bytes verbatim
+ */
+void cbor_write_raw(cbor_writer_t *writer, const void *data, size_t len);
+
+/**
+ * @brief Write an unsigned integer
+ */
+void cbor_write_uint(cbor_writer_t *writer, uint64_t value);
+
+/**
+ * @brief Write a signed integer (major type 0 or 1)
+ */
+void cbor_write_int(cbor_writer_t *writer, int64_t value);
+
+/**
+ * @brief Write a definite-length byte string
+ */
+void cbor_write_bytes(cbor_writer_t *writer, const uint8_t *data, size_t len);
+
+/**
+ * @brief Write a definite-length text string (`text` must be UTF-8)
+ */
+void cbor_write_text(cbor_writer_t *writer, const char *text, size_t len);
+
+/**
+ * @brief Start an array of `count` items
+ */
+void cbor_write_array(cbor_writer_t *writer, uint64_t count);
+
+/**
+ * @brief Start a map of `pairs` key/value pairs
+ */
+void cbor_write_map(cbor_writer_t *writer, uint64_t pairs);
+
+/**
+ * @brief Start an indefinite-length array (end with cbor_write_break())
+ */
+void cbor_write_array_indefinite(cbor_writer_t *writer);
+
+/**
+ * @brief Start an indefinite-length map (end with cbor_write_break())
+ */
+void cbor_write_map_indefinite(cbor_writer_t *writer);
+
+/**
+ * @brief End an indefinite-length item
+ */
+void cbor_write_break(cbor_writer_t *writer);
+
+/**
+ * @brief Tag the next item
+ */
+void cbor_write_tag(cbor_writer_t *writer, uint64_t tag);
+
+/**
+ * @brief Write true or false
+ */
+void cbor_write_bool(cbor_writer_t *writer, bool value);
+
+/**
+ * @brief Write null
+ */
+void cbor_write_null(cbor_writer_t *writer);
+
+/**
+ * @brief Write a floating-point number in its shortest lossless width
+ * @details Values exactly representable as half or single precision are
+ *          written as such (RFC 8949 preferred serialization).
+ */
+void cbor_write_double(cbor_writer_t *writer, double value);
+
+/**
+ * @brief Write a head with a fixed-width argument (1, 2, 4 or 8 bytes)
+ * @details For heads that must be patched in place once their argument is
+ *          known; cbor_head_size() gives the preferred width.
+ * @param writer Writer state
+ * @param major Major type (0-7)
+ * @param value Argument
+ * @param width Argument bytes (0 = value in the initial byte, value < 24)
+ */
+void cbor_write_head_fixed(cbor_writer_t *writer, uint8_t major, uint64_t value, size_t width);
+
+/**
+ * @brief Encoded size of a head with the given argument (1, 2, 3, 5 or 9)
+ */
+size_t cbor_head_size(uint64_t value);
+
+/* ============================================================================
+ * CBOR READER API
+ * ========================================================================= */
+
+/**
+ * @brief Start reading a buffer
+ */
+void cbor_reader_init(cbor_reader_t *reader, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Read the next item head
+ * @details Definite-length string contents are consumed with the head.
+ * @param reader Reader state
+ * @param item Decoded item (output)
+ * @return PAUMIOT_SUCCESS, SENSOR_MANAGER_ERROR_NO_DATA at the end of the
+ *         input, or SENSOR_MANAGER_ERROR_MALFORMED
+ */
+paumiot_result_t cbor_reader_next(cbor_reader_t *reader, cbor_item_t *item);
+
+/**
+ * @brief Skip a complete item, including nested items
+ * @param reader Reader state
+ * @param item Head already returned by cbor_reader_next()
+ * @return PAUMIOT_SUCCESS or SENSOR_MANAGER_ERROR_MALFORMED
+ */
+paumiot_result_t cbor_reader_skip(cbor_reader_t *reader, const cbor_item_t *item);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_SENSOR_CBOR_H */
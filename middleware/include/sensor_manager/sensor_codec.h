@@ -0,0 +1,160 @@
+/**
+ * @file sensor_codec.h
+ * @brief Sensor Manager - Payload format conversion and per-route selection
+ * @details Converts payloads between data_format_t encodings without heap
+ *          allocation. JSON is mapped to CBOR following RFC 8949 section 6.2:
+ *          objects become maps, integers become CBOR integers and other
+ *          numbers the shortest float that preserves them. The reverse
+ *          direction follows section 6.1 (byte strings become base64url,
+ *          non-finite floats and undefined become null, tags are dropped).
+ *
+ *          Routes select the format and compression delivered on a topic,
+ *          e.g. to bridge JSON publishers to constrained CBOR consumers or to
+ *          compress everything bound for a metered backhaul link.
+ */
+
+#ifndef PAUMIOT_SENSOR_CODEC_H
+#define PAUMIOT_SENSOR_CODEC_H
+
+#include "sensor_manager.h"
+#include "sensor_compress.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Deepest object/array nesting accepted by the transcoders */
+#define SENSOR_CODEC_MAX_DEPTH 32
+
+/* Delivery settings of a route (route tables: sensor_codec_routes_t) */
+typedef struct {
+    data_format_t format;                   /* Payload format */
+    sensor_compression_t compression;       /* Compression codec */
+    const sensor_compress_dict_t *dict;     /* Dictionary for dictionary codecs */
+} sensor_codec_route_t;
+
+/* ============================================================================
+ * SENSOR CODEC API
+ * ========================================================================= */
+
+/**
+ * @brief Convert a JSON document to CBOR
+ * @param json JSON text (UTF-8, need not be NUL-terminated)
+ * @param len Length of `json`
+ * @param out Output buffer (can be NULL with capacity 0 to measure)
+ * @param capacity Output buffer size
+ * @param out_len Bytes written, or bytes required if the buffer is too small
+ * @return PAUMIOT_SUCCESS, SENSOR_MANAGER_ERROR_MALFORMED,
+ *         SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL, or PAUMIOT_ERROR_NOT_SUPPORTED
+ *         if nesting exceeds SENSOR_CODEC_MAX_DEPTH
+ */
+paumiot_result_t sensor_codec_json_to_cbor(const char *json, size_t len,
+                                           uint8_t *out, size_t capacity, size_t *out_len);
+
+/**
+ * @brief Convert a CBOR item to compact JSON
+ * @details The output is not NUL-terminated. Map keys must be text or
+ *          integers (integers are written as their decimal string).
+ * @param cbor Encoded item
+ * @param len Length of `cbor`
+ * @param out Output buffer (can be NULL with capacity 0 to measure)
+ * @param capacity Output buffer size
+ * @param out_len Bytes written, or bytes required if the buffer is too small
+ * @return PAUMIOT_SUCCESS, SENSOR_MANAGER_ERROR_MALFORMED,
+ *         SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL, or PAUMIOT_ERROR_NOT_SUPPORTED
+ *         for other key types or nesting beyond SENSOR_CODEC_MAX_DEPTH
+ */
+paumiot_result_t sensor_codec_cbor_to_json(const uint8_t *cbor, size_t len,
+                                           char *out, size_t capacity, size_t *out_len);
+
+/**
+ * @brief Convert a payload between formats
+ * @details Identical formats are copied. Only JSON and CBOR are convertible.
+ * @param from Format of `in`
+ * @param to Requested format
+ * @param in Input payload
+ * @param in_len Input length
+ * @param out Output buffer
+ * @param capacity Output buffer size
+ * @param out_len Bytes written, or bytes required if the buffer is too small
+ * @return PAUMIOT_SUCCESS, PAUMIOT_ERROR_NOT_SUPPORTED for other
+ *         conversions, or an error from the transcoder
+ */
+paumiot_result_t sensor_codec_transcode(data_format_t from, data_format_t to,
+                                        const uint8_t *in, size_t in_len,
+                                        uint8_t *out, size_t capacity, size_t *out_len);
+
+/**
+ * @brief MIME content type of a format ("application/cbor", ...)
+ * @param format Data format
+ * @return Content type (static string)
+ */
+const char *sensor_codec_content_type(data_format_t format);
+
+/* ============================================================================
+ * FORMAT ROUTES API
+ * ========================================================================= */
+
+/**
+ * @brief Create an empty route table
+ * @return Route table or NULL on error
+ */
+sensor_codec_routes_t *sensor_codec_routes_create(void);
+
+/**
+ * @brief Destroy a route table
+ * @param routes Route table (can be NULL)
+ */
+void sensor_codec_routes_destroy(sensor_codec_routes_t *routes);
+
+/**
+ * @brief Deliver payloads on matching topics in `format`
+ * @details Filters use the sensor topic pattern syntax ("+", "{name}" and a
+ *          trailing "#"). Routes are matched in the order they were added.
+ *          The table is not synchronised: build it before sharing it.
+ * @param routes Route table
+ * @param topic_filter Topic filter
+ * @param format Format to deliver
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_codec_routes_add(sensor_codec_routes_t *routes,
+                                         const char *topic_filter, data_format_t format);
+
+/**
+ * @brief Format to deliver on a topic
+ * @param routes Route table (can be NULL)
+ * @param topic Topic
+ * @param source Format of the payload
+ * @return Format of the first matching route, or `source` if none matches
+ */
+data_format_t sensor_codec_routes_format(const sensor_codec_routes_t *routes,
+                                         const char *topic, data_format_t source);
+
+/**
+ * @brief Deliver payloads on matching topics in a format and compression
+ * @details As sensor_codec_routes_add(); the dictionary, if any, must outlive
+ *          the table.
+ * @param routes Route table
+ * @param topic_filter Topic filter
+ * @param route Delivery settings (copied)
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_codec_routes_add_route(sensor_codec_routes_t *routes,
+                                               const char *topic_filter,
+                                               const sensor_codec_route_t *route);
+
+/**
+ * @brief Delivery settings for a topic
+ * @param routes Route table (can be NULL)
+ * @param topic Topic
+ * @param route Receives the settings of the first matching route
+ * @return true if a route matched (otherwise deliver as published)
+ */
+bool sensor_codec_routes_lookup(const sensor_codec_routes_t *routes, const char *topic,
+                                sensor_codec_route_t *route);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_SENSOR_CODEC_H */
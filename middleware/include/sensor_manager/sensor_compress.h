@@ -0,0 +1,275 @@
+/**
+ * @file sensor_compress.h
+ * @brief Sensor Manager - Payload compression stage
+ * @details Compresses payloads into self-describing frames:
+ *
+ *            [codec:1][original length:varint][dictionary id:4 LE, dictionary
+ *            codecs only][compressed data]
+ *
+ *          so that a receiver can decode any frame without out-of-band
+ *          negotiation. Transports with a content-encoding field can use
+ *          sensor_compress_encoding() instead of inspecting the frame.
+ *
+ *          LZ4 (block format) is built in, both plain and with a shared
+ *          dictionary. Payloads under ~200 bytes rarely repeat enough to
+ *          compress on their own; a dictionary trained on representative
+ *          payloads gives the matcher something to refer back to. Other
+ *          codecs (e.g. zstd) can be plugged in with
+ *          sensor_compress_register().
+ *
+ *          Output buffers come from a fixed pool owned by the compressor, so
+ *          the hot path does not allocate.
+ */
+
+#ifndef PAUMIOT_SENSOR_COMPRESS_H
+#define PAUMIOT_SENSOR_COMPRESS_H
+
+#include "sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest dictionary: LZ4 offsets cannot reach further back */
+#define SENSOR_COMPRESS_MAX_DICT_SIZE 65535
+
+/* Largest frame header (codec, 10-byte varint, dictionary id) */
+#define SENSOR_COMPRESS_FRAME_OVERHEAD 15
+
+/* Compression Codec */
+typedef enum {
+    SENSOR_COMPRESSION_NONE = 0,        /* Stored as-is */
+    SENSOR_COMPRESSION_LZ4 = 1,         /* LZ4 block */
+    SENSOR_COMPRESSION_LZ4_DICT = 2,    /* LZ4 block against a shared dictionary */
+    SENSOR_COMPRESSION_ZSTD = 3,        /* zstd (not built in, see sensor_compress_register) */
+    SENSOR_COMPRESSION_ZSTD_DICT = 4,   /* zstd with a dictionary (not built in) */
+    SENSOR_COMPRESSION_MAX = 8
+} sensor_compression_t;
+
+/* Forward Declarations */
+typedef struct sensor_compress_dict sensor_compress_dict_t;
+typedef struct sensor_compressor sensor_compressor_t;
+
+/**
+ * @brief Codec implementation
+ * @details `compress` must fail with SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL
+ *          rather than write past `capacity`; the compressor relies on this
+ *          to fall back to storing payloads that do not shrink. `decompress`
+ *          must reject malformed input. Dictionary codecs receive the frame's
+ *          dictionary, others NULL.
+ */
+typedef struct {
+    const char *encoding;           /* Content-encoding name */
+    bool uses_dict;                 /* Frames carry a dictionary id */
+    paumiot_result_t (*compress)(const uint8_t *in, size_t len,
+                                 const sensor_compress_dict_t *dict,
+                                 uint8_t *out, size_t capacity, size_t *out_len);
+    paumiot_result_t (*decompress)(const uint8_t *in, size_t len,
+                                   const sensor_compress_dict_t *dict,
+                                   uint8_t *out, size_t capacity, size_t *out_len);
+} sensor_compress_codec_t;
+
+/* ============================================================================
+ * CODEC API
+ * ========================================================================= */
+
+/**
+ * @brief Install a codec implementation
+ * @details Call during start-up, before any compressor uses `codec`.
+ *          Built-in codecs can be replaced.
+ * @param codec Codec identifier (not SENSOR_COMPRESSION_NONE)
+ * @param impl Implementation (must outlive its use; NULL to remove)
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_compress_register(sensor_compression_t codec,
+                                          const sensor_compress_codec_t *impl);
+
+/**
+ * @brief Check whether a codec has an implementation
+ * @param codec Codec identifier
+ * @return true if frames using `codec` can be produced and decoded
+ */
+bool sensor_compress_available(sensor_compression_t codec);
+
+/**
+ * @brief Content-encoding name of a codec ("identity", "lz4", ...)
+ * @param codec Codec identifier
+ * @return Name, or NULL if the codec is not available
+ */
+const char *sensor_compress_encoding(sensor_compression_t codec);
+
+/**
+ * @brief Compress into a caller buffer using the LZ4 block format
+ * @param in Input
+ * @param len Input length
+ * @param dict Dictionary preceding the input (can be NULL)
+ * @param out Output buffer
+ * @param capacity Output buffer size (sensor_compress_lz4_bound(len) always fits)
+ * @param out_len Bytes written
+ * @return PAUMIOT_SUCCESS or SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL (output
+ *         is then incomplete)
+ */
+paumiot_result_t sensor_compress_lz4(const uint8_t *in, size_t len,
+                                     const sensor_compress_dict_t *dict,
+                                     uint8_t *out, size_t capacity, size_t *out_len);
+
+/**
+ * @brief Decode an LZ4 block
+ * @param in Compressed block
+ * @param len Block length
+ * @param dict Dictionary used to compress (can be NULL)
+ * @param out Output buffer
+ * @param capacity Output buffer size
+ * @param out_len Bytes decoded
+ * @return PAUMIOT_SUCCESS, SENSOR_MANAGER_ERROR_MALFORMED or
+ *         SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL
+ */
+paumiot_result_t sensor_decompress_lz4(const uint8_t *in, size_t len,
+                                       const sensor_compress_dict_t *dict,
+                                       uint8_t *out, size_t capacity, size_t *out_len);
+
+/**
+ * @brief Worst-case LZ4 block size for `len` input bytes
+ */
+size_t sensor_compress_lz4_bound(size_t len);
+
+/* ============================================================================
+ * DICTIONARY API
+ * ========================================================================= */
+
+/**
+ * @brief Wrap existing dictionary contents
+ * @param data Dictionary contents (copied)
+ * @param len Length (1 to SENSOR_COMPRESS_MAX_DICT_SIZE)
+ * @return Dictionary or NULL on error
+ */
+sensor_compress_dict_t *sensor_compress_dict_create(const uint8_t *data, size_t len);
+
+/**
+ * @brief Build a dictionary from sample payloads
+ * @details Greedily picks the sample segments whose 8-byte substrings recur
+ *          most often across the samples, until `capacity` bytes are used.
+ *          Train on a few hundred payloads of the traffic to be compressed;
+ *          both ends must then share the resulting dictionary.
+ * @param samples Sample payloads
+ * @param sizes Length of each sample
+ * @param count Number of samples
+ * @param capacity Dictionary size (at most SENSOR_COMPRESS_MAX_DICT_SIZE)
+ * @return Dictionary (possibly shorter than `capacity`), or NULL on error
+ *         or if no content recurs across the samples
+ */
+sensor_compress_dict_t *sensor_compress_dict_train(const uint8_t *const *samples,
+                                                   const size_t *sizes, size_t count,
+                                                   size_t capacity);
+
+/**
+ * @brief Destroy a dictionary
+ * @param dict Dictionary (can be NULL)
+ */
+void sensor_compress_dict_destroy(sensor_compress_dict_t *dict);
+
+/**
+ * @brief Dictionary contents, e.g. to distribute to receivers
+ * @param dict Dictionary
+ * @param len Receives the length
+ * @return Contents (owned by the dictionary)
+ */
+const uint8_t *sensor_compress_dict_data(const sensor_compress_dict_t *dict, size_t *len);
+
+/**
+ * @brief Identifier carried in frames (a hash of the contents)
+ */
+uint32_t sensor_compress_dict_id(const sensor_compress_dict_t *dict);
+
+/* ============================================================================
+ * COMPRESSOR API
+ * ========================================================================= */
+
+/**
+ * @brief Create a compressor with a pool of output buffers
+ * @param max_payload Largest payload to compress or decompress
+ * @param buffers Buffers in the pool (frames held at once)
+ * @return Compressor or NULL on error
+ */
+sensor_compressor_t *sensor_compressor_create(size_t max_payload, size_t buffers);
+
+/**
+ * @brief Destroy a compressor
+ * @details All buffers must have been released.
+ * @param compressor Compressor (can be NULL)
+ */
+void sensor_compressor_destroy(sensor_compressor_t *compressor);
+
+/**
+ * @brief Make a dictionary known for decoding
+ * @details Frames naming its id are decoded with it. Up to 8 dictionaries
+ *          can be added; the dictionary must outlive the compressor.
+ * @param compressor Compressor
+ * @param dict Dictionary
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_compressor_add_dict(sensor_compressor_t *compressor,
+                                            const sensor_compress_dict_t *dict);
+
+/**
+ * @brief Compress a payload into a pooled frame
+ * @details If the codec does not make the payload smaller, the frame stores
+ *          it uncompressed (codec SENSOR_COMPRESSION_NONE). Thread-safe.
+ * @param compressor Compressor
+ * @param codec Codec to use
+ * @param dict Dictionary for dictionary codecs (ignored otherwise)
+ * @param in Payload
+ * @param len Payload length (at most max_payload)
+ * @param frame Receives the frame buffer (release with sensor_compressor_release)
+ * @param frame_len Receives the frame length
+ * @return PAUMIOT_SUCCESS, PAUMIOT_ERROR_NOT_SUPPORTED if the codec is not
+ *         available, PAUMIOT_ERROR_OUT_OF_MEMORY if the pool is exhausted,
+ *         or another error code
+ */
+paumiot_result_t sensor_compressor_compress(sensor_compressor_t *compressor,
+                                            sensor_compression_t codec,
+                                            const sensor_compress_dict_t *dict,
+                                            const uint8_t *in, size_t len,
+                                            uint8_t **frame, size_t *frame_len);
+
+/**
+ * @brief Decode a frame into a pooled buffer
+ * @param compressor Compressor
+ * @param frame Frame
+ * @param frame_len Frame length
+ * @param out Receives the payload buffer (release with sensor_compressor_release)
+ * @param out_len Receives the payload length
+ * @param codec Receives the frame's codec (can be NULL)
+ * @return PAUMIOT_SUCCESS, SENSOR_MANAGER_ERROR_MALFORMED,
+ *         SENSOR_MANAGER_ERROR_NOT_FOUND for an unknown dictionary,
+ *         PAUMIOT_ERROR_NOT_SUPPORTED for an unavailable codec, or
+ *         PAUMIOT_ERROR_OUT_OF_MEMORY if the pool is exhausted
+ */
+paumiot_result_t sensor_compressor_decompress(sensor_compressor_t *compressor,
+                                              const uint8_t *frame, size_t frame_len,
+                                              uint8_t **out, size_t *out_len,
+                                              sensor_compression_t *codec);
+
+/**
+ * @brief Take an empty buffer from the pool
+ * @details For staging a payload before it is compressed (e.g. after
+ *          transcoding it), so the delivery path does not allocate.
+ * @param compressor Compressor
+ * @param capacity Receives the buffer size (at least max_payload)
+ * @return Buffer (release with sensor_compressor_release), or NULL if the
+ *         pool is exhausted
+ */
+uint8_t *sensor_compressor_acquire(sensor_compressor_t *compressor, size_t *capacity);
+
+/**
+ * @brief Return a buffer to the pool
+ * @param compressor Compressor
+ * @param buffer Buffer from acquire/compress/decompress (can be NULL)
+ */
+void sensor_compressor_release(sensor_compressor_t *compressor, uint8_t *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_SENSOR_COMPRESS_H */
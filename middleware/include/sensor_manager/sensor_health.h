@@ -0,0 +1,101 @@
+/**
+ * @file sensor_health.h
+ * @brief Sensor Manager - Deadline-bucketed liveness tracking
+ * @details A timing wheel of `tick_ms` wide buckets. Each tracked sensor
+ *          sits in the bucket of the first tick at or after its deadline
+ *          (last activity + timeout_ms). Re-arming moves a node between
+ *          buckets in O(1), and is free while the deadline stays in the same
+ *          bucket; expiry only visits buckets whose tick has passed, so the
+ *          cost of a check is proportional to the sensors that went quiet,
+ *          not to the registry size.
+ */
+
+#ifndef PAUMIOT_SENSOR_HEALTH_H
+#define PAUMIOT_SENSOR_HEALTH_H
+
+#include "sensor_manager.h"
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Slot of a node that is not in the wheel */
+#define SENSOR_HEALTH_UNTRACKED UINT64_MAX
+
+/* Forward Declarations */
+typedef struct sensor_health sensor_health_t;
+
+/* Wheel node, embedded in the tracked object */
+typedef struct sensor_health_node {
+    struct sensor_health_node *prev;
+    struct sensor_health_node *next;
+    atomic_uint_fast64_t slot;      /* Absolute tick of its bucket */
+} sensor_health_node_t;
+
+/* ============================================================================
+ * SENSOR HEALTH API
+ * ========================================================================= */
+
+/**
+ * @brief Create a tracker
+ * @param tick_ms Bucket width, i.e. the check interval (> 0)
+ * @param timeout_ms Inactivity before a node expires (> 0)
+ * @return Tracker instance or NULL on error
+ */
+sensor_health_t *sensor_health_create(uint32_t tick_ms, uint32_t timeout_ms);
+
+/**
+ * @brief Destroy a tracker (nodes are not touched)
+ * @param health Tracker instance (can be NULL)
+ */
+void sensor_health_destroy(sensor_health_t *health);
+
+/**
+ * @brief Initialise a node as untracked
+ * @param node Wheel node
+ */
+void sensor_health_node_init(sensor_health_node_t *node);
+
+/**
+ * @brief Arm or re-arm a node for activity at `now_ms`
+ * @details Lock-free when the new deadline falls in the node's current bucket.
+ * @param health Tracker instance
+ * @param node Wheel node
+ * @param now_ms Time of the activity (monotonic milliseconds)
+ */
+void sensor_health_touch(sensor_health_t *health, sensor_health_node_t *node, uint64_t now_ms);
+
+/**
+ * @brief Stop tracking a node
+ * @param health Tracker instance
+ * @param node Wheel node
+ */
+void sensor_health_remove(sensor_health_t *health, sensor_health_node_t *node);
+
+/**
+ * @brief Pop up to `max` nodes whose bucket tick is at or before `now_ms`
+ * @details Popped nodes are untracked. Activity racing with the pop is not
+ *          reflected in the wheel, so callers should confirm the node's last
+ *          activity and re-arm it if it is still live. Call until it
+ *          returns 0.
+ * @param health Tracker instance
+ * @param now_ms Current time (monotonic milliseconds)
+ * @param nodes Output array
+ * @param max Capacity of `nodes`
+ * @return Number of nodes popped
+ */
+size_t sensor_health_expire(sensor_health_t *health, uint64_t now_ms,
+                            sensor_health_node_t **nodes, size_t max);
+
+/**
+ * @brief Number of nodes in the wheel
+ * @param health Tracker instance
+ */
+size_t sensor_health_tracked(sensor_health_t *health);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_SENSOR_HEALTH_H */
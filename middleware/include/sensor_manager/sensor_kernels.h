@@ -0,0 +1,136 @@
+/**
+ * @file sensor_kernels.h
+ * @brief Sensor Manager - Vectorized batch statistics over sensor readings
+ * @details Computes count/sum/min/max/variance and threshold crossings over
+ *          columnar (SoA) arrays of readings. The kernel is picked at
+ *          runtime from AVX2, SSE4.2, NEON or a portable scalar loop.
+ *          Batches fold into a running sensor_batch_stats_t, so a long range
+ *          can be summarised one decoded block at a time.
+ *
+ *          Inputs must be finite: min/max of a batch containing NaN differ
+ *          between kernels.
+ */
+
+#ifndef PAUMIOT_SENSOR_KERNELS_H
+#define PAUMIOT_SENSOR_KERNELS_H
+
+#include "sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Kernel instruction sets */
+typedef enum {
+    SENSOR_KERNEL_SCALAR = 0,
+    SENSOR_KERNEL_SSE42,
+    SENSOR_KERNEL_AVX2,
+    SENSOR_KERNEL_NEON
+} sensor_kernel_isa_t;
+
+/* Running statistics over one or more batches */
+struct sensor_batch_stats {
+    uint64_t count;                 /* Number of readings */
+    double sum;
+    double min;
+    double max;
+    double m2;                      /* Sum of squared deviations from the mean */
+    double first;                   /* First reading (in input order) */
+    double last;                    /* Last reading (in input order) */
+    double threshold;               /* Crossing threshold (NAN = disabled) */
+    uint64_t crossings;             /* Transitions across the threshold */
+};
+
+/* ============================================================================
+ * DISPATCH
+ * ========================================================================= */
+
+/**
+ * @brief Kernel in use (detected on first call)
+ */
+sensor_kernel_isa_t sensor_kernels_active(void);
+
+/**
+ * @brief Check whether a kernel is compiled in and supported by this CPU
+ * @param isa Instruction set
+ */
+bool sensor_kernels_supported(sensor_kernel_isa_t isa);
+
+/**
+ * @brief Force a kernel (for tests and benchmarks)
+ * @details Not synchronised with concurrent kernel calls.
+ * @param isa Instruction set
+ * @return PAUMIOT_SUCCESS, or PAUMIOT_ERROR_NOT_SUPPORTED if unavailable
+ */
+paumiot_result_t sensor_kernels_select(sensor_kernel_isa_t isa);
+
+/**
+ * @brief Name of an instruction set ("scalar", "sse4.2", "avx2", "neon")
+ * @param isa Instruction set
+ */
+const char *sensor_kernels_isa_name(sensor_kernel_isa_t isa);
+
+/* ============================================================================
+ * BATCH STATISTICS API
+ * ========================================================================= */
+
+/**
+ * @brief Reset statistics
+ * @param stats Statistics to reset
+ * @param threshold Value whose crossings are counted (NAN to disable).
+ *                  A crossing is a change of (reading >= threshold)
+ *                  between consecutive readings.
+ */
+void sensor_batch_stats_init(sensor_batch_stats_t *stats, double threshold);
+
+/**
+ * @brief Fold a batch of double readings into `stats`
+ * @param stats Running statistics
+ * @param values Readings (finite)
+ * @param count Number of readings
+ */
+void sensor_batch_stats_add_f64(sensor_batch_stats_t *stats, const double *values,
+                                size_t count);
+
+/**
+ * @brief Fold a batch of float readings into `stats`
+ * @param stats Running statistics
+ * @param values Readings (finite)
+ * @param count Number of readings
+ */
+void sensor_batch_stats_add_f32(sensor_batch_stats_t *stats, const float *values,
+                                size_t count);
+
+/**
+ * @brief Fold a batch of integer readings into `stats`
+ * @param stats Running statistics
+ * @param values Readings
+ * @param count Number of readings
+ */
+void sensor_batch_stats_add_i32(sensor_batch_stats_t *stats, const int32_t *values,
+                                size_t count);
+
+/**
+ * @brief Append the statistics of a later batch sequence `src` to `dst`
+ * @details Both must use the same threshold; the crossing between dst's last
+ *          and src's first reading is counted.
+ * @param dst Running statistics
+ * @param src Statistics of the readings that follow dst's
+ */
+void sensor_batch_stats_merge(sensor_batch_stats_t *dst, const sensor_batch_stats_t *src);
+
+/**
+ * @brief Mean of the readings (NAN if empty)
+ */
+double sensor_batch_stats_mean(const sensor_batch_stats_t *stats);
+
+/**
+ * @brief Population variance of the readings (NAN if empty)
+ */
+double sensor_batch_stats_variance(const sensor_batch_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_SENSOR_KERNELS_H */
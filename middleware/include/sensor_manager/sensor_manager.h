@@ -8,6 +8,7 @@
 #define PAUMIOT_SENSOR_MANAGER_H
 
 #include "../paumiot_core.h"
+#include "metrics.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
@@ -22,6 +23,7 @@ typedef struct sensor_manager_config sensor_manager_config_t;
 typedef struct sensor_entry sensor_entry_t;
 typedef struct sensor_data sensor_data_t;
 typedef struct sensor_capabilities sensor_capabilities_t;
+typedef struct sensor_codec_routes sensor_codec_routes_t;
 
 /* Sensor Type */
 typedef enum {
@@ -55,6 +57,15 @@ typedef enum {
     DATA_FORMAT_PROTOBUF = 3    /* Protobuf encoded */
 } data_format_t;
 
+/* Sensor Manager Result Codes */
+typedef enum {
+    SENSOR_MANAGER_ERROR_NOT_FOUND = PAUMIOT_ERROR_SENSOR_BASE - 1,
+    SENSOR_MANAGER_ERROR_ALREADY_EXISTS = PAUMIOT_ERROR_SENSOR_BASE - 2,
+    SENSOR_MANAGER_ERROR_NO_DATA = PAUMIOT_ERROR_SENSOR_BASE - 3,
+    SENSOR_MANAGER_ERROR_MALFORMED = PAUMIOT_ERROR_SENSOR_BASE - 4,
+    SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL = PAUMIOT_ERROR_SENSOR_BASE - 5
+} sensor_manager_error_t;
+
 /* Sensor Capabilities */
 struct sensor_capabilities {
     bool supports_streaming;        /* Supports continuous streaming */
@@ -88,6 +99,7 @@ struct sensor_data {
     data_format_t format;           /* Data format */
     uint64_t timestamp;             /* Data timestamp */
     qos_level_t qos;                /* QoS level */
+    bool compressed;                /* Payload is a sensor_compress.h frame (set on delivery only) */
 };
 
 /* Sensor Manager Configuration */
@@ -96,10 +108,13 @@ struct sensor_manager_config {
     size_t cache_size;              /* Maximum cached entries */
     uint32_t cache_ttl_ms;          /* Cache TTL */
     bool enable_cache;              /* Enable caching */
+    size_t cache_memory_limit;      /* Cached data byte budget (0 = unlimited) */
     
     /* Data Aggregation */
     bool enable_aggregation;        /* Enable data aggregation */
     uint32_t aggregation_window_ms; /* Aggregation window */
+    uint32_t aggregation_slide_ms;  /* Sliding step (0 = tumbling windows) */
+    uint32_t aggregation_grace_ms;  /* Delay before a running manager closes idle windows */
     
     /* Health Monitoring */
     bool enable_health_monitoring;  /* Enable health monitoring */
@@ -107,9 +122,25 @@ struct sensor_manager_config {
     uint32_t offline_threshold_ms;  /* Offline threshold */
     
     /* Storage */
-    bool enable_historical;         /* Enable historical storage */
+    bool enable_historical;         /* Record numeric readings to storage_path */
     const char *storage_path;       /* Storage path for historical data */
     uint32_t retention_days;        /* Data retention period */
+    
+    /* Callback Dispatch */
+    size_t dispatch_threads;        /* Workers for deferred data callbacks */
+    size_t dispatch_queue_size;     /* Deferred callbacks queued per worker */
+    uint32_t slow_callback_us;      /* Defer inline callbacks slower than this (0 = never) */
+    const int16_t *dispatch_cpus;   /* CPU per worker, -1 = any (NULL = unpinned; copied) */
+
+    /* Delivery Encoding */
+    const sensor_codec_routes_t *routes; /* Format and compression per topic (NULL = deliver
+                                            as published; must outlive the manager) */
+    bool enable_compression;        /* Apply the routes' compression codecs */
+    size_t max_payload_size;        /* Largest payload the routes re-encode */
+
+    /* Metrics */
+    metrics_registry_t *metrics;    /* Registry for the manager's counters (NULL = private;
+                                       must outlive the manager) */
 };
 
 /* Sensor Manager Statistics */
@@ -122,8 +153,18 @@ typedef struct {
     uint64_t cache_misses;
     size_t cache_memory_usage;
     uint64_t health_checks;
+    uint64_t deferred_callbacks;    /* Data callbacks run on dispatch workers */
+    uint64_t deferred_dropped;      /* Deferred callbacks lost to full queues */
+    uint64_t payloads_encoded;      /* Deliveries transcoded or compressed for a route */
+    uint64_t encode_failures;       /* Deliveries sent as published after encoding failed */
 } sensor_manager_stats_t;
 
+/* Data Subscription Flags */
+typedef enum {
+    SENSOR_SUBSCRIBE_DEFAULT = 0,
+    SENSOR_SUBSCRIBE_DEFERRED = 1 << 0 /* Run on a dispatch worker, not the updating thread */
+} sensor_subscribe_flags_t;
+
 /* Callback Types */
 
 /**
@@ -152,6 +193,22 @@ typedef void (*sensor_status_callback_t)(
     void *user_data
 );
 
+/* Batch statistics (see sensor_kernels.h) */
+typedef struct sensor_batch_stats sensor_batch_stats_t;
+
+/* Window aggregate (see sensor_aggregator.h) */
+typedef struct sensor_aggregate sensor_aggregate_t;
+
+/**
+ * @brief Callback for closed aggregation windows
+ * @param aggregate Window aggregate (valid for the call only)
+ * @param user_data User-defined data
+ */
+typedef void (*sensor_aggregate_callback_t)(
+    const sensor_aggregate_t *aggregate,
+    void *user_data
+);
+
 /* ============================================================================
  * SENSOR MANAGER API
  * ========================================================================= */
@@ -238,7 +295,8 @@ paumiot_result_t sensor_manager_update_status(
 /**
  * @brief List all sensors
  * @param sm Sensor manager instance
- * @param sensors Array of sensor entries (output, must be freed)
+ * @param sensors Array of sensor entries (output; free each entry with
+ *                sensor_entry_free(), then the array with free())
  * @param count Number of sensors (output)
  * @return PAUMIOT_SUCCESS on success, error code otherwise
  */
@@ -252,7 +310,7 @@ paumiot_result_t sensor_manager_list_sensors(
  * @brief Find sensors matching topic
  * @param sm Sensor manager instance
  * @param topic Topic to match
- * @param sensors Array of matching sensors (output, must be freed)
+ * @param sensors Array of matching sensors (output, freed as for list)
  * @param count Number of matches (output)
  * @return PAUMIOT_SUCCESS on success, error code otherwise
  */
@@ -282,8 +340,15 @@ paumiot_result_t sensor_manager_get_data(
 
 /**
  * @brief Update sensor data (cache and notify subscribers)
+ * @details If a route in `routes` matches the topic, data subscribers
+ *          receive the payload converted to the route's format and, with
+ *          enable_compression, compressed into a frame (`compressed` set).
+ *          The reading is stored as published. If the payload cannot be
+ *          encoded (unconvertible, larger than max_payload_size, or no pooled
+ *          buffer free) it is delivered as published and counted in
+ *          `encode_failures`.
  * @param sm Sensor manager instance
- * @param data Sensor data
+ * @param data Sensor data (not compressed)
  * @return PAUMIOT_SUCCESS on success, error code otherwise
  */
 paumiot_result_t sensor_manager_update_data(
@@ -293,6 +358,9 @@ paumiot_result_t sensor_manager_update_data(
 
 /**
  * @brief Subscribe to sensor data updates
+ * @details Callbacks run on the thread calling sensor_manager_update_data().
+ *          Dispatch takes no lock and may run concurrently with subscribing,
+ *          but an inline callback must not subscribe to data itself.
  * @param sm Sensor manager instance
  * @param sensor_id Sensor identifier (or NULL for all sensors)
  * @param callback Callback for data updates
@@ -306,6 +374,29 @@ paumiot_result_t sensor_manager_subscribe_data(
     void *user_data
 );
 
+/**
+ * @brief Subscribe to sensor data updates with dispatch options
+ * @details With SENSOR_SUBSCRIBE_DEFERRED the callback receives a copy of
+ *          the reading on one of `dispatch_threads` workers. Readings of one
+ *          sensor are delivered in order; when the worker's queue is full
+ *          the reading is dropped for that callback and counted in
+ *          `deferred_dropped`. Inline callbacks that take longer than
+ *          `slow_callback_us` are switched to deferred delivery.
+ * @param sm Sensor manager instance
+ * @param sensor_id Sensor identifier (or NULL for all sensors)
+ * @param callback Callback for data updates
+ * @param user_data User-defined data
+ * @param flags Bitwise OR of sensor_subscribe_flags_t
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_manager_subscribe_data_ex(
+    sensor_manager_t *sm,
+    const char *sensor_id,
+    sensor_data_callback_t callback,
+    void *user_data,
+    uint32_t flags
+);
+
 /**
  * @brief Subscribe to sensor status changes
  * @param sm Sensor manager instance
@@ -321,19 +412,78 @@ paumiot_result_t sensor_manager_subscribe_status(
     void *user_data
 );
 
+/**
+ * @brief Subscribe to aggregated (downsampled) windows
+ * @details Requires enable_aggregation. One callback fires per closed,
+ *          non-empty window; sensor_aggregate_to_json() renders the
+ *          downsampled message.
+ * @param sm Sensor manager instance
+ * @param sensor_id Sensor identifier (or NULL for all sensors)
+ * @param callback Callback for closed windows
+ * @param user_data User-defined data
+ * @return PAUMIOT_SUCCESS on success, PAUMIOT_ERROR_NOT_SUPPORTED if
+ *         aggregation is disabled, error code otherwise
+ */
+paumiot_result_t sensor_manager_subscribe_aggregates(
+    sensor_manager_t *sm,
+    const char *sensor_id,
+    sensor_aggregate_callback_t callback,
+    void *user_data
+);
+
+/**
+ * @brief Close aggregation windows that ended at or before `now_ms`
+ * @details A started manager does this on its own, aggregation_grace_ms
+ *          behind the wall clock, so quiet sensors still report. Call it to
+ *          close windows sooner or when the manager is not started.
+ * @param sm Sensor manager instance
+ * @param now_ms Cut-off time (Unix epoch milliseconds)
+ * @return PAUMIOT_SUCCESS on success, PAUMIOT_ERROR_NOT_SUPPORTED if
+ *         aggregation is disabled
+ */
+paumiot_result_t sensor_manager_flush_aggregates(sensor_manager_t *sm, uint64_t now_ms);
+
+/* ============================================================================
+ * HEALTH MONITORING API
+ * ========================================================================= */
+
+/**
+ * @brief Mark sensors offline that have been silent for offline_threshold_ms
+ * @details Runs every health_check_interval_ms on a background thread once
+ *          the manager is started. Only sensors whose deadline has passed
+ *          are visited. ONLINE sensors become OFFLINE, and status
+ *          subscribers are notified in one batch after the registry is
+ *          released. Readings bring OFFLINE and UNKNOWN sensors back ONLINE.
+ * @param sm Sensor manager instance
+ * @param now_ms Current time (monotonic milliseconds, see time_monotonic_ms())
+ * @param transitions Number of sensors marked offline (output, optional)
+ * @return PAUMIOT_SUCCESS on success, PAUMIOT_ERROR_NOT_SUPPORTED if
+ *         health monitoring is disabled, error code otherwise
+ */
+paumiot_result_t sensor_manager_check_health(
+    sensor_manager_t *sm,
+    uint64_t now_ms,
+    size_t *transitions
+);
+
 /* ============================================================================
  * HISTORICAL DATA API
  * ========================================================================= */
 
 /**
  * @brief Query historical sensor data
+ * @details Only numeric readings are recorded (see enable_historical). Each
+ *          returned point carries its value as a DATA_FORMAT_RAW native
+ *          double payload.
  * @param sm Sensor manager instance
  * @param sensor_id Sensor identifier
- * @param start_time Start timestamp (Unix epoch milliseconds)
- * @param end_time End timestamp
- * @param data Array of sensor data (output, must be freed)
+ * @param start_time Start timestamp (Unix epoch milliseconds, inclusive)
+ * @param end_time End timestamp (inclusive)
+ * @param data Array of sensor data (output; a single allocation released
+ *             with free(), NULL when no points match)
  * @param count Number of data points (output)
- * @return PAUMIOT_SUCCESS on success, error code otherwise
+ * @return PAUMIOT_SUCCESS on success, PAUMIOT_ERROR_NOT_SUPPORTED if
+ *         historical storage is disabled, error code otherwise
  */
 paumiot_result_t sensor_manager_query_historical(
     sensor_manager_t *sm,
@@ -344,6 +494,29 @@ paumiot_result_t sensor_manager_query_historical(
     size_t *count
 );
 
+/**
+ * @brief Summarise historical sensor data without materialising it
+ * @details Folds each decoded block into `stats` with the vectorized batch
+ *          kernels (see sensor_kernels.h), so backfilling aggregates over a
+ *          long range costs one pass over the compressed history.
+ * @param sm Sensor manager instance
+ * @param sensor_id Sensor identifier
+ * @param start_time Start timestamp (Unix epoch milliseconds, inclusive)
+ * @param end_time End timestamp (inclusive)
+ * @param threshold Crossing threshold (NAN to disable)
+ * @param stats Statistics output (count is 0 when no points match)
+ * @return PAUMIOT_SUCCESS on success, PAUMIOT_ERROR_NOT_SUPPORTED if
+ *         historical storage is disabled, error code otherwise
+ */
+paumiot_result_t sensor_manager_query_stats(
+    sensor_manager_t *sm,
+    const char *sensor_id,
+    uint64_t start_time,
+    uint64_t end_time,
+    double threshold,
+    sensor_batch_stats_t *stats
+);
+
 /* ============================================================================
  * STATISTICS API
  * ========================================================================= */
@@ -359,6 +532,15 @@ paumiot_result_t sensor_manager_get_stats(
     sensor_manager_stats_t *stats
 );
 
+/**
+ * @brief Get the registry holding the manager's metrics
+ * @details The configured registry, or the manager's private one; render it
+ *          or serve it with paumiot_metrics_server_start().
+ * @param sm Sensor manager instance
+ * @return Registry (NULL if sm is NULL)
+ */
+metrics_registry_t *sensor_manager_metrics(sensor_manager_t *sm);
+
 /**
  * @brief Reset statistics counters
  * @param sm Sensor manager instance
@@ -376,13 +558,24 @@ paumiot_result_t sensor_manager_reset_stats(sensor_manager_t *sm);
  */
 void sensor_manager_config_init(sensor_manager_config_t *config);
 
+/**
+ * @brief Apply the settings that can change while running
+ * @details Currently the cache TTL and enable_compression. Other fields
+ *          are ignored; changing them needs a new sensor manager.
+ * @param sm Sensor manager instance
+ * @param config Updated configuration
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_manager_reconfigure(sensor_manager_t *sm,
+                                            const sensor_manager_config_t *config);
+
 /* ============================================================================
  * UTILITY API
  * ========================================================================= */
 
 /**
- * @brief Free sensor entry
- * @param sensor Sensor entry to free
+ * @brief Free the strings owned by a sensor entry
+ * @param sensor Sensor entry (the structure itself is not freed)
  */
 void sensor_entry_free(sensor_entry_t *sensor);
 
@@ -0,0 +1,115 @@
+/**
+ * @file sensor_tsdb.h
+ * @brief Sensor Manager - Append-only columnar time-series store
+ * @details Each sensor gets a directory of daily segment files
+ *          (`<storage_path>/<sensor_id>/YYYYMMDD.seg`). A segment is a run of
+ *          blocks of up to SENSOR_TSDB_BLOCK_POINTS points; each block stores
+ *          timestamps as delta-of-delta codes and values as Gorilla XOR codes,
+ *          and its header doubles as the sparse time index used to skip
+ *          blocks during range queries. Segments are mmap'd for reading, and
+ *          retention removes whole days with unlink().
+ */
+
+#ifndef PAUMIOT_SENSOR_TSDB_H
+#define PAUMIOT_SENSOR_TSDB_H
+
+#include "sensor_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Points per block (bounds decode buffers and the sparse index granularity) */
+#ifndef SENSOR_TSDB_BLOCK_POINTS
+#define SENSOR_TSDB_BLOCK_POINTS 1024
+#endif
+
+/* Forward Declarations */
+typedef struct sensor_tsdb sensor_tsdb_t;
+
+/**
+ * @brief Callback receiving decoded points in columnar batches
+ * @param timestamps Timestamps (Unix epoch milliseconds)
+ * @param values Values, parallel to timestamps
+ * @param count Number of points in this batch
+ * @param user_data User-defined data
+ */
+typedef void (*sensor_tsdb_visit_fn)(
+    const uint64_t *timestamps,
+    const double *values,
+    size_t count,
+    void *user_data
+);
+
+/* ============================================================================
+ * SENSOR TSDB API
+ * ========================================================================= */
+
+/**
+ * @brief Open (or create) a store rooted at a directory
+ * @param path Storage directory (created if missing)
+ * @param retention_days Days of data to keep (0 = keep forever)
+ * @return Store instance or NULL on error
+ */
+sensor_tsdb_t *sensor_tsdb_open(const char *path, uint32_t retention_days);
+
+/**
+ * @brief Flush pending blocks and close the store
+ * @param db Store instance (can be NULL)
+ */
+void sensor_tsdb_close(sensor_tsdb_t *db);
+
+/**
+ * @brief Append one point to a sensor's series
+ * @details Points are buffered in the sensor's open block and written when
+ *          the block fills or the UTC day changes.
+ * @param db Store instance
+ * @param sensor_id Sensor identifier
+ * @param timestamp Point timestamp (Unix epoch milliseconds)
+ * @param value Point value
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_tsdb_append(sensor_tsdb_t *db, const char *sensor_id,
+                                    uint64_t timestamp, double value);
+
+/**
+ * @brief Write all open blocks to their segments
+ * @details Each segment written is synced with fdatasync(), so points
+ *          appended before the call survive a crash. Blocks written as they
+ *          fill up are synced by the kernel in its own time.
+ * @param db Store instance
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_tsdb_flush(sensor_tsdb_t *db);
+
+/**
+ * @brief Scan a sensor's points within [start_time, end_time]
+ * @details Points are delivered in storage order, which is ascending for
+ *          in-order appends. Pending (unflushed) points are included.
+ * @param db Store instance
+ * @param sensor_id Sensor identifier
+ * @param start_time Start timestamp (inclusive)
+ * @param end_time End timestamp (inclusive)
+ * @param visit Batch callback
+ * @param user_data User-defined data
+ * @return PAUMIOT_SUCCESS on success (also when no points match)
+ */
+paumiot_result_t sensor_tsdb_scan(sensor_tsdb_t *db, const char *sensor_id,
+                                  uint64_t start_time, uint64_t end_time,
+                                  sensor_tsdb_visit_fn visit, void *user_data);
+
+/**
+ * @brief Unlink segments older than the retention period
+ * @param db Store instance
+ * @param now_ms Reference time (Unix epoch milliseconds)
+ * @param removed Number of segments removed (output, optional)
+ * @return PAUMIOT_SUCCESS on success, error code otherwise
+ */
+paumiot_result_t sensor_tsdb_enforce_retention(sensor_tsdb_t *db, uint64_t now_ms,
+                                               size_t *removed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAUMIOT_SENSOR_TSDB_H */
@@ -0,0 +1,407 @@
+/**
+ * @file paumiot_admission.c
+ * @brief CONNECT admission control: rate-limited handshakes, prioritized queue
+ */
+
+#include "paumiot_admission.h"
+#include "logging.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NS_PER_SEC 1000000000ull
+#define NS_PER_MS 1000000ull
+
+/* Queue classes, in the order they are served */
+enum {
+    CLASS_ESTABLISHED = 0,
+    CLASS_NEW = 1,
+    CLASS_COUNT = 2
+};
+
+typedef struct {
+    void *connection;
+    uint64_t queued_ns;
+} waiter_t;
+
+/* Ring of waiting connections, oldest at head */
+typedef struct {
+    waiter_t *entries;
+    size_t head;
+    size_t count;
+} waiter_fifo_t;
+
+struct paumiot_admission {
+    pthread_mutex_t lock;
+    metrics_registry_t *metrics;
+
+    /* Limits */
+    uint64_t interval_ns;           /* Between admissions; 0 = unlimited */
+    uint64_t burst_ns;              /* Credit a quiet period can build up */
+    uint64_t timeout_ns;            /* Longest wait; 0 = forever */
+    size_t queue_limit;
+    uint32_t rate_limit;
+
+    /* GCRA: theoretical arrival time of the next admission */
+    uint64_t tat_ns;
+
+    waiter_fifo_t queues[CLASS_COUNT];
+    size_t capacity;                /* Per queue */
+
+    /* Admissions in the current rate window */
+    uint64_t window_start_ns;
+    uint64_t window_admitted;
+    double last_rate;
+
+    paumiot_admission_stats_t stats;
+};
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * RATE LIMITER
+ * ========================================================================= */
+
+/**
+ * @brief Earliest time the next admission conforms (lock held)
+ */
+static uint64_t conform_at(const paumiot_admission_t *admission) {
+    uint64_t slack = admission->burst_ns - admission->interval_ns;
+    return admission->tat_ns > slack ? admission->tat_ns - slack : 0;
+}
+
+static bool may_admit(const paumiot_admission_t *admission, uint64_t now_ns) {
+    return admission->interval_ns == 0 || conform_at(admission) <= now_ns;
+}
+
+/**
+ * @brief Spend one admission (lock held)
+ */
+static void admit(paumiot_admission_t *admission, uint64_t now_ns) {
+    if (admission->interval_ns > 0) {
+        uint64_t base = admission->tat_ns > now_ns ? admission->tat_ns : now_ns;
+        admission->tat_ns = base + admission->interval_ns;
+    }
+
+    if (now_ns >= admission->window_start_ns + NS_PER_SEC) {
+        admission->last_rate = (double)admission->window_admitted * (double)NS_PER_SEC /
+                               (double)(now_ns - admission->window_start_ns);
+        admission->window_start_ns = now_ns;
+        admission->window_admitted = 0;
+    }
+    admission->window_admitted++;
+    admission->stats.admitted++;
+}
+
+/**
+ * @brief Admissions per second over the last full window (lock held)
+ */
+static double admit_rate(const paumiot_admission_t *admission, uint64_t now_ns) {
+    uint64_t elapsed = now_ns - admission->window_start_ns;
+    if (now_ns < admission->window_start_ns || elapsed < NS_PER_SEC) {
+        return admission->last_rate;
+    }
+    return (double)admission->window_admitted * (double)NS_PER_SEC / (double)elapsed;
+}
+
+/**
+ * @brief Take limits from the configuration (lock held)
+ */
+static void apply_config(paumiot_admission_t *admission, const initiator_config_t *config) {
+    uint32_t burst = config->connect_burst > 0 ? config->connect_burst : 1;
+    admission->rate_limit = config->connect_rate_limit;
+    admission->interval_ns = config->connect_rate_limit > 0
+                                 ? NS_PER_SEC / config->connect_rate_limit
+                                 : 0;
+    admission->burst_ns = admission->interval_ns * burst;
+    admission->timeout_ns = (uint64_t)config->connection_timeout_ms * NS_PER_MS;
+    admission->queue_limit = config->admission_queue_size < admission->capacity
+                                 ? config->admission_queue_size
+                                 : admission->capacity;
+}
+
+/* ============================================================================
+ * QUEUES
+ * ========================================================================= */
+
+static waiter_t *fifo_at(const paumiot_admission_t *admission, const waiter_fifo_t *fifo,
+                         size_t i) {
+    return &fifo->entries[(fifo->head + i) % admission->capacity];
+}
+
+static void fifo_pop(const paumiot_admission_t *admission, waiter_fifo_t *fifo) {
+    fifo->head = (fifo->head + 1) % admission->capacity;
+    fifo->count--;
+}
+
+/**
+ * @brief Enlarge both queues to hold @p capacity waiters each (lock held)
+ * @details Waiters are unwrapped to the start of the new rings. Nothing
+ *          changes unless both allocations succeed.
+ */
+static bool grow_queues(paumiot_admission_t *admission, size_t capacity) {
+    waiter_t *entries[CLASS_COUNT];
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        entries[c] = calloc(capacity, sizeof(waiter_t));
+        if (!entries[c]) {
+            while (c-- > 0) {
+                free(entries[c]);
+            }
+            return false;
+        }
+    }
+
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        waiter_fifo_t *fifo = &admission->queues[c];
+        for (size_t i = 0; i < fifo->count; i++) {
+            entries[c][i] = *fifo_at(admission, fifo, i);
+        }
+        free(fifo->entries);
+        fifo->entries = entries[c];
+        fifo->head = 0;
+    }
+    admission->capacity = capacity;
+    return true;
+}
+
+static size_t queue_depth(const paumiot_admission_t *admission) {
+    return admission->queues[CLASS_ESTABLISHED].count + admission->queues[CLASS_NEW].count;
+}
+
+static bool expired(const paumiot_admission_t *admission, const waiter_t *waiter,
+                    uint64_t now_ns) {
+    return admission->timeout_ns > 0 && now_ns - waiter->queued_ns >= admission->timeout_ns;
+}
+
+/* ============================================================================
+ * METRICS
+ * ========================================================================= */
+
+static void collect_metrics(metrics_writer_t *writer, void *user_data) {
+    paumiot_admission_t *admission = user_data;
+    paumiot_admission_stats_t stats;
+    paumiot_admission_get_stats(admission, monotonic_ns(), &stats);
+
+    pthread_mutex_lock(&admission->lock);
+    uint32_t rate_limit = admission->rate_limit;
+    pthread_mutex_unlock(&admission->lock);
+
+    metrics_write(writer, METRICS_COUNTER, "paumiot_initiator_connects_admitted_total",
+                  "Handshakes admitted", (double)stats.admitted);
+    metrics_write(writer, METRICS_COUNTER, "paumiot_initiator_connects_queued_total",
+                  "Connections that waited for admission", (double)stats.queued);
+    metrics_write(writer, METRICS_COUNTER, "paumiot_initiator_connects_rejected_total",
+                  "Connections refused with the admission queue full", (double)stats.rejected);
+    metrics_write(writer, METRICS_COUNTER, "paumiot_initiator_connects_expired_total",
+                  "Connections that timed out waiting for admission", (double)stats.expired);
+    metrics_write(writer, METRICS_GAUGE, "paumiot_initiator_admission_queue_depth",
+                  "Connections waiting for admission", (double)stats.queue_depth);
+    metrics_write(writer, METRICS_GAUGE, "paumiot_initiator_admission_rate",
+                  "Handshakes admitted per second", stats.admit_rate);
+    metrics_write(writer, METRICS_GAUGE, "paumiot_initiator_admission_rate_limit",
+                  "Handshakes admitted per second at most (0 = unlimited)", (double)rate_limit);
+}
+
+/* ============================================================================
+ * API
+ * ========================================================================= */
+
+paumiot_admission_t *paumiot_admission_create(const initiator_config_t *config,
+                                              metrics_registry_t *metrics) {
+    if (!config) {
+        return NULL;
+    }
+
+    paumiot_admission_t *admission = calloc(1, sizeof(*admission));
+    if (!admission) {
+        return NULL;
+    }
+    pthread_mutex_init(&admission->lock, NULL);
+    admission->capacity = config->admission_queue_size > 0 ? config->admission_queue_size : 1;
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        admission->queues[c].entries = calloc(admission->capacity, sizeof(waiter_t));
+        if (!admission->queues[c].entries) {
+            paumiot_admission_destroy(admission);
+            return NULL;
+        }
+    }
+    apply_config(admission, config);
+
+    if (metrics) {
+        if (!metrics_collector_register(metrics, collect_metrics, admission)) {
+            paumiot_admission_destroy(admission);
+            return NULL;
+        }
+        admission->metrics = metrics;
+    }
+
+    LOG_DEBUG("Admission control: %u handshakes/s, burst %u, queue %u",
+              config->connect_rate_limit, config->connect_burst, config->admission_queue_size);
+    return admission;
+}
+
+void paumiot_admission_destroy(paumiot_admission_t *admission) {
+    if (!admission) {
+        return;
+    }
+    if (admission->metrics) {
+        metrics_collector_unregister(admission->metrics, collect_metrics, admission);
+    }
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        free(admission->queues[c].entries);
+    }
+    pthread_mutex_destroy(&admission->lock);
+    free(admission);
+}
+
+void paumiot_admission_configure(paumiot_admission_t *admission,
+                                 const initiator_config_t *config) {
+    if (!admission || !config) {
+        return;
+    }
+    pthread_mutex_lock(&admission->lock);
+    if (config->admission_queue_size > admission->capacity &&
+        !grow_queues(admission, config->admission_queue_size)) {
+        LOG_WARN("Admission queue stays at %zu: cannot grow it to %u", admission->capacity,
+                 config->admission_queue_size);
+    }
+    apply_config(admission, config);
+    pthread_mutex_unlock(&admission->lock);
+}
+
+paumiot_admit_t paumiot_admission_request(paumiot_admission_t *admission, void *connection,
+                                          bool established, uint64_t now_ns) {
+    if (!admission) {
+        return PAUMIOT_ADMIT_REJECTED;
+    }
+
+    int cls = established ? CLASS_ESTABLISHED : CLASS_NEW;
+    pthread_mutex_lock(&admission->lock);
+
+    /* Nobody of equal or higher priority may be waiting for the credit */
+    bool ahead = admission->queues[CLASS_ESTABLISHED].count > 0 ||
+                 (cls == CLASS_NEW && admission->queues[CLASS_NEW].count > 0);
+    if (!ahead && may_admit(admission, now_ns)) {
+        admit(admission, now_ns);
+        pthread_mutex_unlock(&admission->lock);
+        return PAUMIOT_ADMIT_NOW;
+    }
+
+    if (queue_depth(admission) >= admission->queue_limit) {
+        admission->stats.rejected++;
+        pthread_mutex_unlock(&admission->lock);
+        return PAUMIOT_ADMIT_REJECTED;
+    }
+
+    waiter_fifo_t *fifo = &admission->queues[cls];
+    waiter_t *waiter = fifo_at(admission, fifo, fifo->count);
+    waiter->connection = connection;
+    waiter->queued_ns = now_ns;
+    fifo->count++;
+    admission->stats.queued++;
+    pthread_mutex_unlock(&admission->lock);
+    return PAUMIOT_ADMIT_QUEUED;
+}
+
+size_t paumiot_admission_poll(paumiot_admission_t *admission, uint64_t now_ns,
+                              paumiot_admission_entry_t *entries, size_t max_entries) {
+    if (!admission || !entries) {
+        return 0;
+    }
+
+    size_t n = 0;
+    pthread_mutex_lock(&admission->lock);
+    for (int c = 0; c < CLASS_COUNT && n < max_entries; c++) {
+        waiter_fifo_t *fifo = &admission->queues[c];
+        while (fifo->count > 0 && n < max_entries) {
+            const waiter_t *waiter = fifo_at(admission, fifo, 0);
+            bool late = expired(admission, waiter, now_ns);
+            if (!late && !may_admit(admission, now_ns)) {
+                break;                  /* Younger ones behind have not expired */
+            }
+            if (late) {
+                admission->stats.expired++;
+            } else {
+                admit(admission, now_ns);
+            }
+            entries[n].connection = waiter->connection;
+            entries[n].expired = late;
+            n++;
+            fifo_pop(admission, fifo);
+        }
+    }
+    pthread_mutex_unlock(&admission->lock);
+    return n;
+}
+
+int paumiot_admission_next_ms(paumiot_admission_t *admission, uint64_t now_ns) {
+    if (!admission) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&admission->lock);
+    uint64_t due = UINT64_MAX;
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        const waiter_fifo_t *fifo = &admission->queues[c];
+        if (fifo->count == 0) {
+            continue;
+        }
+        uint64_t at = may_admit(admission, now_ns) ? now_ns : conform_at(admission);
+        if (admission->timeout_ns > 0) {
+            uint64_t timeout_at = fifo_at(admission, fifo, 0)->queued_ns + admission->timeout_ns;
+            at = timeout_at < at ? timeout_at : at;
+        }
+        due = at < due ? at : due;
+    }
+    pthread_mutex_unlock(&admission->lock);
+
+    if (due == UINT64_MAX) {
+        return -1;
+    }
+    if (due <= now_ns) {
+        return 0;
+    }
+    uint64_t ms = (due - now_ns + NS_PER_MS - 1) / NS_PER_MS;
+    return ms > INT32_MAX ? INT32_MAX : (int)ms;
+}
+
+bool paumiot_admission_cancel(paumiot_admission_t *admission, void *connection) {
+    if (!admission) {
+        return false;
+    }
+
+    pthread_mutex_lock(&admission->lock);
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        waiter_fifo_t *fifo = &admission->queues[c];
+        for (size_t i = 0; i < fifo->count; i++) {
+            if (fifo_at(admission, fifo, i)->connection != connection) {
+                continue;
+            }
+            for (size_t j = i + 1; j < fifo->count; j++) {
+                *fifo_at(admission, fifo, j - 1) = *fifo_at(admission, fifo, j);
+            }
+            fifo->count--;
+            pthread_mutex_unlock(&admission->lock);
+            return true;
+        }
+    }
+    pthread_mutex_unlock(&admission->lock);
+    return false;
+}
+
+void paumiot_admission_get_stats(paumiot_admission_t *admission, uint64_t now_ns,
+                                 paumiot_admission_stats_t *stats) {
+    if (!admission || !stats) {
+        return;
+    }
+    pthread_mutex_lock(&admission->lock);
+    *stats = admission->stats;
+    stats->queue_depth = (uint32_t)queue_depth(admission);
+    stats->admit_rate = admit_rate(admission, now_ns);
+    pthread_mutex_unlock(&admission->lock);
+}
@@ -0,0 +1,1200 @@
+/**
+ * @file paumiot_config.c
+ * @brief Configuration defaults, paumiot.conf parsing and validation
+ * @details Settings are described by a table mapping (section, key) to a
+ *          field of one layer's configuration, so a key that feeds several
+ *          layers (e.g. worker_threads) simply has several rows. The parser
+ *          walks the file once, line by line, without building a tree.
+ */
+
+#include "paumiot_config.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <errno.h>
+
+#define CONFIG_MAX_SECTION 64
+#define CONFIG_MAX_KEY 64
+#define CONFIG_MAX_VALUE 512
+#define CONFIG_MAX_FRACTION_DIGITS 3
+
+#define MS_US 1000ull
+#define SECOND_US 1000000ull
+#define DAY_US (86400ull * SECOND_US)
+
+/* Configuration a setting is stored in */
+typedef enum {
+    TARGET_CORE = 0,
+    TARGET_ENGINE,
+    TARGET_STATE,
+    TARGET_INITIATOR,
+    TARGET_SENSOR_MANAGER,
+    TARGET_COUNT
+} config_target_t;
+
+/* Stored representation of a setting */
+typedef enum {
+    SETTING_BOOL,                   /* bool */
+    SETTING_U16,                    /* uint16_t */
+    SETTING_U32,                    /* uint32_t */
+    SETTING_COUNT,                  /* size_t */
+    SETTING_BYTES,                  /* size_t, size units */
+    SETTING_MS,                     /* uint32_t milliseconds, duration units */
+    SETTING_DAYS,                   /* uint32_t days, duration units */
+    SETTING_STRING,                 /* const char * into the string storage */
+    SETTING_CPUS                    /* paumiot_config_t cpu_affinity list */
+} setting_type_t;
+
+/* Setting flags */
+#define SETTING_RELOADABLE 0x01     /* Applied live by the store or a reload listener */
+
+typedef struct {
+    const char *section;
+    const char *key;
+    setting_type_t type;
+    config_target_t target;
+    size_t offset;
+    uint64_t unit_us;               /* Unit of a bare duration */
+    uint8_t flags;
+} setting_t;
+
+#define HOT SETTING_RELOADABLE
+
+#define CORE(field) TARGET_CORE, offsetof(paumiot_config_t, field)
+#define ENGINE(field) TARGET_ENGINE, offsetof(engine_config_t, field)
+#define STATE(field) TARGET_STATE, offsetof(state_config_t, field)
+#define INITIATOR(field) TARGET_INITIATOR, offsetof(initiator_config_t, field)
+#define SENSOR(field) TARGET_SENSOR_MANAGER, offsetof(sensor_manager_config_t, field)
+
+static const setting_t settings[] = {
+    { "general", "log_level", SETTING_STRING, CORE(log_level), 0, HOT },
+    { "general", "log_file", SETTING_STRING, CORE(log_file), 0, 0 },
+
+    { "network", "bind_address", SETTING_STRING, CORE(host), 0, 0 },
+    { "network", "bind_address", SETTING_STRING, INITIATOR(bind_address), 0, 0 },
+    { "network", "max_connections", SETTING_U32, INITIATOR(max_connections), 0, 0 },
+    { "network", "connection_timeout", SETTING_MS, INITIATOR(connection_timeout_ms), SECOND_US, HOT },
+    { "network", "global_rate_limit", SETTING_U32, CORE(global_rate_limit), 0, 0 },
+    { "network", "global_rate_limit", SETTING_U32, INITIATOR(global_rate_limit), 0, 0 },
+    { "network", "per_client_rate_limit", SETTING_U32, CORE(per_client_rate_limit), 0, 0 },
+    { "network", "per_client_rate_limit", SETTING_U32, INITIATOR(per_client_rate_limit), 0, 0 },
+    { "network", "connect_rate_limit", SETTING_U32, INITIATOR(connect_rate_limit), 0, HOT },
+    { "network", "connect_burst", SETTING_U32, INITIATOR(connect_burst), 0, HOT },
+    { "network", "admission_queue_size", SETTING_U32, INITIATOR(admission_queue_size), 0, HOT },
+
+    { "smp", "health_check_interval", SETTING_MS, SENSOR(health_check_interval_ms), SECOND_US, 0 },
+    { "smp", "state_persistence", SETTING_BOOL, CORE(state_persistence), 0, 0 },
+    { "smp", "state_persistence", SETTING_BOOL, STATE(enable_persistence), 0, 0 },
+    { "smp", "state_file", SETTING_STRING, CORE(state_db_path), 0, 0 },
+    { "smp", "state_file", SETTING_STRING, STATE(db_path), 0, 0 },
+
+    { "pdl", "max_packet_size", SETTING_BYTES, ENGINE(max_payload_size), 0, 0 },
+    { "pdl", "max_packet_size", SETTING_BYTES, SENSOR(max_payload_size), 0, 0 },
+    { "pdl", "buffer_size", SETTING_BYTES, INITIATOR(recv_buffer_size), 0, 0 },
+    { "pdl", "buffer_size", SETTING_BYTES, INITIATOR(send_buffer_size), 0, 0 },
+    { "pdl", "load_balancing", SETTING_STRING, INITIATOR(lb_algorithm), 0, 0 },
+    { "pdl.mqtt", "port", SETTING_U16, CORE(mqtt_port), 0, 0 },
+    { "pdl.mqtt", "port", SETTING_U16, INITIATOR(mqtt_port), 0, 0 },
+    { "pdl.coap", "port", SETTING_U16, CORE(coap_port), 0, 0 },
+    { "pdl.coap", "port", SETTING_U16, INITIATOR(coap_port), 0, 0 },
+
+    { "pal", "message_queue_size", SETTING_U32, CORE(max_queue_size), 0, 0 },
+    { "pal", "message_queue_size", SETTING_U32, ENGINE(max_queue_size), 0, 0 },
+    { "pal", "high_watermark", SETTING_U32, ENGINE(high_watermark), 0, 0 },
+    { "pal", "low_watermark", SETTING_U32, ENGINE(low_watermark), 0, 0 },
+    { "pal.mqtt", "max_inflight", SETTING_U32, ENGINE(max_inflight_messages), 0, 0 },
+
+    { "bll", "request_timeout", SETTING_MS, CORE(request_timeout_ms), SECOND_US, 0 },
+    { "bll", "request_timeout", SETTING_MS, ENGINE(request_timeout_ms), SECOND_US, 0 },
+    { "bll", "cache_enabled", SETTING_BOOL, SENSOR(enable_cache), 0, 0 },
+    { "bll", "cache_ttl", SETTING_MS, CORE(sensor_cache_ttl_ms), SECOND_US, HOT },
+    { "bll", "cache_ttl", SETTING_MS, SENSOR(cache_ttl_ms), SECOND_US, HOT },
+    { "bll", "aggregation_enabled", SETTING_BOOL, SENSOR(enable_aggregation), 0, 0 },
+    { "bll", "aggregation_window", SETTING_MS, SENSOR(aggregation_window_ms), SECOND_US, 0 },
+    { "bll", "aggregation_grace", SETTING_MS, SENSOR(aggregation_grace_ms), SECOND_US, 0 },
+
+    { "dal", "buffer_size", SETTING_U32, CORE(sensor_cache_size), 0, 0 },
+    { "dal", "buffer_size", SETTING_COUNT, SENSOR(cache_size), 0, 0 },
+    { "dal", "compression_enabled", SETTING_BOOL, SENSOR(enable_compression), 0, HOT },
+    { "dal.database", "retention_policy", SETTING_DAYS, SENSOR(retention_days), DAY_US, 0 },
+
+    { "security", "tls_enabled", SETTING_BOOL, CORE(enable_tls), 0, 0 },
+    { "security", "cert_file", SETTING_STRING, CORE(cert_file), 0, 0 },
+    { "security", "key_file", SETTING_STRING, CORE(key_file), 0, 0 },
+    { "security", "ca_file", SETTING_STRING, CORE(ca_file), 0, 0 },
+
+    { "performance", "worker_threads", SETTING_U32, CORE(worker_threads), 0, 0 },
+    { "performance", "worker_threads", SETTING_U32, ENGINE(worker_threads), 0, 0 },
+    { "performance", "worker_threads", SETTING_COUNT, SENSOR(dispatch_threads), 0, 0 },
+    { "performance", "io_threads", SETTING_U32, CORE(io_threads), 0, 0 },
+    { "performance", "io_threads", SETTING_U32, INITIATOR(io_threads), 0, 0 },
+    { "performance", "memory_limit", SETTING_BYTES, CORE(memory_limit), 0, 0 },
+    { "performance", "cpu_affinity", SETTING_CPUS, CORE(cpu_affinity), 0, 0 },
+
+    { "monitoring", "metrics_enabled", SETTING_BOOL, CORE(metrics_enabled), 0, 0 },
+    { "monitoring", "metrics_port", SETTING_U16, CORE(metrics_port), 0, 0 },
+    { "monitoring", "metrics_endpoint", SETTING_STRING, CORE(metrics_endpoint), 0, 0 },
+    { "monitoring", "health_endpoint", SETTING_STRING, CORE(health_endpoint), 0, 0 },
+};
+
+/* Unit suffix of a size or duration */
+typedef struct {
+    const char *suffix;
+    uint64_t scale;
+} unit_t;
+
+static const unit_t size_units[] = {
+    { "b", 1 },
+    { "k", 1ull << 10 }, { "kb", 1ull << 10 }, { "kib", 1ull << 10 },
+    { "m", 1ull << 20 }, { "mb", 1ull << 20 }, { "mib", 1ull << 20 },
+    { "g", 1ull << 30 }, { "gb", 1ull << 30 }, { "gib", 1ull << 30 },
+    { "t", 1ull << 40 }, { "tb", 1ull << 40 }, { "tib", 1ull << 40 },
+    { NULL, 0 }
+};
+
+static const unit_t duration_units[] = {
+    { "us", 1 },
+    { "ms", MS_US },
+    { "s", SECOND_US },
+    { "m", 60 * SECOND_US }, { "min", 60 * SECOND_US },
+    { "h", 3600 * SECOND_US },
+    { "d", DAY_US },
+    { "w", 7 * DAY_US },
+    { NULL, 0 }
+};
+
+typedef enum { VALUE_BARE, VALUE_STRING, VALUE_ARRAY } value_kind_t;
+
+typedef struct {
+    value_kind_t kind;
+    char text[CONFIG_MAX_VALUE];    /* Token, unescaped string, or array contents */
+} config_value_t;
+
+typedef struct {
+    void *targets[TARGET_COUNT];    /* NULL = not being loaded */
+    paumiot_config_t *core;         /* Owns the string storage */
+    paumiot_config_error_t *error;
+    uint32_t line;
+    char section[CONFIG_MAX_SECTION];
+    const char *line_string;        /* String stored for the current line */
+} config_parser_t;
+
+static paumiot_result_t fail(config_parser_t *parser, const char *fmt, ...) {
+    if (parser->error) {
+        va_list args;
+        va_start(args, fmt);
+        parser->error->line = parser->line;
+        vsnprintf(parser->error->message, sizeof(parser->error->message), fmt, args);
+        va_end(args);
+    }
+    return PAUMIOT_ERROR_INVALID_PARAM;
+}
+
+static paumiot_result_t invalid(paumiot_config_error_t *error, const char *fmt, ...) {
+    if (error) {
+        va_list args;
+        va_start(args, fmt);
+        error->line = 0;
+        vsnprintf(error->message, sizeof(error->message), fmt, args);
+        va_end(args);
+    }
+    return PAUMIOT_ERROR_INVALID_PARAM;
+}
+
+/* ============================================================================
+ * VALUES
+ * ========================================================================= */
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief Parse digits with optional '_' separators between them
+ */
+static const char *parse_digits(const char *p, uint64_t *value, bool *ok) {
+    *value = 0;
+    *ok = is_digit(*p);
+    if (!*ok) {
+        return p;
+    }
+
+    while (is_digit(*p) || (*p == '_' && is_digit(p[1]))) {
+        if (*p != '_') {
+            uint64_t digit = (uint64_t)(*p - '0');
+            if (*value > (UINT64_MAX - digit) / 10) {
+                *ok = false;
+            }
+            *value = *value * 10 + digit;
+        }
+        p++;
+    }
+    return p;
+}
+
+static bool parse_uint(const char *text, uint64_t *value) {
+    bool ok;
+    const char *end = parse_digits(text, value, &ok);
+    return ok && *end == '\0';
+}
+
+/**
+ * @brief Parse "<number>[.<fraction>][ ]<unit>" into base units
+ */
+static bool parse_quantity(const char *text, const unit_t *units, uint64_t default_scale,
+                           uint64_t *result) {
+    uint64_t whole;
+    uint64_t fraction = 0;
+    uint64_t denominator = 1;
+    bool ok;
+
+    const char *p = parse_digits(text, &whole, &ok);
+    if (!ok) {
+        return false;
+    }
+    if (*p == '.') {
+        p++;
+        if (!is_digit(*p)) {
+            return false;
+        }
+        for (int digits = 0; is_digit(*p); digits++, p++) {
+            if (digits == CONFIG_MAX_FRACTION_DIGITS) {
+                return false;
+            }
+            fraction = fraction * 10 + (uint64_t)(*p - '0');
+            denominator *= 10;
+        }
+    }
+    while (*p == ' ') {
+        p++;
+    }
+
+    uint64_t scale = default_scale;
+    if (*p) {
+        scale = 0;
+        for (const unit_t *unit = units; unit->suffix; unit++) {
+            if (strcasecmp(p, unit->suffix) == 0) {
+                scale = unit->scale;
+                break;
+            }
+        }
+        if (scale == 0) {
+            return false;
+        }
+    }
+
+    /* Fractions must land on a whole base unit */
+    if ((fraction * scale) % denominator != 0) {
+        return false;
+    }
+    if (whole > UINT64_MAX / scale) {
+        return false;
+    }
+    uint64_t total = whole * scale;
+    uint64_t extra = fraction * scale / denominator;
+    if (total > UINT64_MAX - extra) {
+        return false;
+    }
+
+    *result = total + extra;
+    return true;
+}
+
+bool paumiot_config_parse_size(const char *text, uint64_t *bytes) {
+    return text && bytes && parse_quantity(text, size_units, 1, bytes);
+}
+
+bool paumiot_config_parse_duration(const char *text, uint64_t default_unit_us, uint64_t *us) {
+    return text && us && default_unit_us > 0 &&
+           parse_quantity(text, duration_units, default_unit_us, us);
+}
+
+static const char *store_string(config_parser_t *parser, const char *text) {
+    paumiot_config_t *core = parser->core;
+    size_t len = strlen(text) + 1;
+
+    if (parser->line_string) {
+        return parser->line_string;
+    }
+    if (PAUMIOT_CONFIG_STRING_STORAGE - core->string_storage_used < len) {
+        return NULL;
+    }
+
+    char *stored = core->string_storage + core->string_storage_used;
+    memcpy(stored, text, len);
+    core->string_storage_used += len;
+    parser->line_string = stored;
+    return stored;
+}
+
+/**
+ * @brief Parse a CPU list: [0, 2, "4-7"]
+ */
+static paumiot_result_t store_cpus(config_parser_t *parser, const setting_t *setting,
+                                   const char *list, paumiot_config_t *core) {
+    uint16_t cpus[PAUMIOT_MAX_AFFINITY_CPUS];
+    uint16_t count = 0;
+    const char *p = list;
+
+    for (;;) {
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+
+        bool quoted = *p == '"';
+        if (quoted) {
+            p++;
+        }
+
+        uint64_t first, last;
+        bool ok;
+        p = parse_digits(p, &first, &ok);
+        last = first;
+        if (ok && quoted && *p == '-') {
+            p = parse_digits(p + 1, &last, &ok);
+        }
+        if (quoted && ok) {
+            ok = *p++ == '"';
+        }
+        if (!ok || first > last || last >= PAUMIOT_MAX_CPU_ID) {
+            return fail(parser, "[%s] %s: expected CPU numbers below %d or \"first-last\" ranges",
+                        setting->section, setting->key, PAUMIOT_MAX_CPU_ID);
+        }
+
+        for (uint64_t cpu = first; cpu <= last; cpu++) {
+            for (uint16_t i = 0; i < count; i++) {
+                if (cpus[i] == cpu) {
+                    return fail(parser, "[%s] %s: CPU %u listed twice", setting->section,
+                                setting->key, (unsigned)cpu);
+                }
+            }
+            if (count == PAUMIOT_MAX_AFFINITY_CPUS) {
+                return fail(parser, "[%s] %s: more than %d CPUs", setting->section, setting->key,
+                            PAUMIOT_MAX_AFFINITY_CPUS);
+            }
+            cpus[count++] = (uint16_t)cpu;
+        }
+
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return fail(parser, "[%s] %s: expected ',' between CPUs", setting->section,
+                        setting->key);
+        }
+    }
+
+    memcpy(core->cpu_affinity, cpus, count * sizeof(uint16_t));
+    core->cpu_affinity_count = count;
+    return PAUMIOT_SUCCESS;
+}
+
+static paumiot_result_t store_setting(config_parser_t *parser, const setting_t *setting,
+                                      const config_value_t *value) {
+    uint8_t *field = (uint8_t *)parser->targets[setting->target] + setting->offset;
+    const char *text = value->text;
+    uint64_t number;
+
+    if (value->kind == VALUE_ARRAY && setting->type != SETTING_CPUS) {
+        return fail(parser, "[%s] %s does not take a list", setting->section, setting->key);
+    }
+
+    switch (setting->type) {
+    case SETTING_BOOL: {
+        if (value->kind != VALUE_BARE ||
+            (strcmp(text, "true") != 0 && strcmp(text, "false") != 0)) {
+            return fail(parser, "[%s] %s: expected true or false", setting->section, setting->key);
+        }
+        bool flag = text[0] == 't';
+        memcpy(field, &flag, sizeof(flag));
+        return PAUMIOT_SUCCESS;
+    }
+
+    case SETTING_U16:
+    case SETTING_U32:
+    case SETTING_COUNT: {
+        uint64_t max = setting->type == SETTING_U16 ? UINT16_MAX :
+                       setting->type == SETTING_U32 ? UINT32_MAX : SIZE_MAX;
+        if (value->kind != VALUE_BARE || !parse_uint(text, &number) || number > max) {
+            return fail(parser, "[%s] %s: expected a whole number up to %llu", setting->section,
+                        setting->key, (unsigned long long)max);
+        }
+        if (setting->type == SETTING_U16) {
+            uint16_t v = (uint16_t)number;
+            memcpy(field, &v, sizeof(v));
+        } else if (setting->type == SETTING_U32) {
+            uint32_t v = (uint32_t)number;
+            memcpy(field, &v, sizeof(v));
+        } else {
+            size_t v = (size_t)number;
+            memcpy(field, &v, sizeof(v));
+        }
+        return PAUMIOT_SUCCESS;
+    }
+
+    case SETTING_BYTES: {
+        if (!paumiot_config_parse_size(text, &number) || number > SIZE_MAX) {
+            return fail(parser, "[%s] %s: expected a size such as \"512MB\"", setting->section,
+                        setting->key);
+        }
+        size_t v = (size_t)number;
+        memcpy(field, &v, sizeof(v));
+        return PAUMIOT_SUCCESS;
+    }
+
+    case SETTING_MS:
+    case SETTING_DAYS: {
+        uint64_t unit = setting->type == SETTING_MS ? MS_US : DAY_US;
+        if (!paumiot_config_parse_duration(text, setting->unit_us, &number)) {
+            return fail(parser, "[%s] %s: expected a duration such as \"30s\" or \"30d\"",
+                        setting->section, setting->key);
+        }
+        if (number % unit != 0 || number / unit > UINT32_MAX) {
+            return fail(parser, "[%s] %s: must be a whole number of %s up to %u",
+                        setting->section, setting->key,
+                        setting->type == SETTING_MS ? "milliseconds" : "days", UINT32_MAX);
+        }
+        uint32_t v = (uint32_t)(number / unit);
+        memcpy(field, &v, sizeof(v));
+        return PAUMIOT_SUCCESS;
+    }
+
+    case SETTING_STRING: {
+        if (value->kind != VALUE_STRING) {
+            return fail(parser, "[%s] %s: expected a quoted string", setting->section,
+                        setting->key);
+        }
+        const char *stored = store_string(parser, text);
+        if (!stored) {
+            return fail(parser, "string values exceed %d bytes", PAUMIOT_CONFIG_STRING_STORAGE);
+        }
+        memcpy(field, &stored, sizeof(stored));
+        return PAUMIOT_SUCCESS;
+    }
+
+    case SETTING_CPUS:
+        if (value->kind != VALUE_ARRAY) {
+            return fail(parser, "[%s] %s: expected a list such as [0, 1, \"4-7\"]",
+                        setting->section, setting->key);
+        }
+        return store_cpus(parser, setting, text, parser->targets[TARGET_CORE]);
+    }
+
+    return PAUMIOT_ERROR_INVALID_PARAM;
+}
+
+/* ============================================================================
+ * PARSER
+ * ========================================================================= */
+
+static const char *skip_blank(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+static bool is_key_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || is_digit(c) ||
+           c == '_' || c == '-';
+}
+
+/* Only blanks and a comment may follow */
+static bool at_line_end(const char *p, const char *end) {
+    p = skip_blank(p, end);
+    return p == end || *p == '#';
+}
+
+static paumiot_result_t parse_value(config_parser_t *parser, const char *p, const char *end,
+                                    config_value_t *value, const char **next) {
+    size_t len = 0;
+
+    if (p == end || *p == '#') {
+        return fail(parser, "missing value");
+    }
+
+    if (*p == '"') {
+        value->kind = VALUE_STRING;
+        for (p++;; p++) {
+            if (p == end) {
+                return fail(parser, "unterminated string");
+            }
+            char c = *p;
+            if (c == '"') {
+                p++;
+                break;
+            }
+            if (c == '\\') {
+                if (++p == end) {
+                    return fail(parser, "unterminated string");
+                }
+                switch (*p) {
+                case '"': c = '"'; break;
+                case '\\': c = '\\'; break;
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                default:
+                    return fail(parser, "unsupported escape \\%c", *p);
+                }
+            }
+            if (len + 1 == CONFIG_MAX_VALUE) {
+                return fail(parser, "value longer than %d bytes", CONFIG_MAX_VALUE - 1);
+            }
+            value->text[len++] = c;
+        }
+    } else if (*p == '[') {
+        value->kind = VALUE_ARRAY;
+        bool in_string = false;
+        for (p++;; p++) {
+            if (p == end) {
+                return fail(parser, "unterminated list");
+            }
+            if (*p == '"') {
+                in_string = !in_string;
+            } else if (*p == ']' && !in_string) {
+                p++;
+                break;
+            }
+            if (len + 1 == CONFIG_MAX_VALUE) {
+                return fail(parser, "value longer than %d bytes", CONFIG_MAX_VALUE - 1);
+            }
+            value->text[len++] = *p;
+        }
+    } else {
+        value->kind = VALUE_BARE;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '#') {
+            if (len + 1 == CONFIG_MAX_VALUE) {
+                return fail(parser, "value longer than %d bytes", CONFIG_MAX_VALUE - 1);
+            }
+            value->text[len++] = *p++;
+        }
+    }
+
+    value->text[len] = '\0';
+    *next = p;
+    return PAUMIOT_SUCCESS;
+}
+
+static paumiot_result_t parse_line(config_parser_t *parser, const char *p, const char *end) {
+    p = skip_blank(p, end);
+    if (p == end || *p == '#') {
+        return PAUMIOT_SUCCESS;
+    }
+
+    if (*p == '[') {
+        const char *name = skip_blank(p + 1, end);
+        const char *close = name;
+        while (close < end && (is_key_char(*close) || *close == '.')) {
+            close++;
+        }
+        const char *name_end = close;
+        close = skip_blank(close, end);
+        if (close == end || *close != ']' || name_end == name) {
+            return fail(parser, "malformed section header");
+        }
+        if ((size_t)(name_end - name) >= CONFIG_MAX_SECTION) {
+            return fail(parser, "section name too long");
+        }
+        if (!at_line_end(close + 1, end)) {
+            return fail(parser, "unexpected text after section header");
+        }
+        memcpy(parser->section, name, (size_t)(name_end - name));
+        parser->section[name_end - name] = '\0';
+        return PAUMIOT_SUCCESS;
+    }
+
+    char key[CONFIG_MAX_KEY];
+    size_t key_len = 0;
+    while (p < end && is_key_char(*p)) {
+        if (key_len + 1 == CONFIG_MAX_KEY) {
+            return fail(parser, "key too long");
+        }
+        key[key_len++] = *p++;
+    }
+    key[key_len] = '\0';
+    if (key_len == 0) {
+        return fail(parser, "expected a key");
+    }
+
+    p = skip_blank(p, end);
+    if (p == end || *p != '=') {
+        return fail(parser, "expected '=' after %s", key);
+    }
+
+    config_value_t value;
+    paumiot_result_t result = parse_value(parser, skip_blank(p + 1, end), end, &value, &p);
+    if (result != PAUMIOT_SUCCESS) {
+        return result;
+    }
+    if (!at_line_end(p, end)) {
+        return fail(parser, "unexpected text after the value of %s", key);
+    }
+
+    bool known = false;
+    parser->line_string = NULL;
+    for (size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); i++) {
+        const setting_t *setting = &settings[i];
+        if (strcmp(setting->key, key) != 0 || strcmp(setting->section, parser->section) != 0) {
+            continue;
+        }
+        known = true;
+        if (!parser->targets[setting->target]) {
+            continue;
+        }
+        result = store_setting(parser, setting, &value);
+        if (result != PAUMIOT_SUCCESS) {
+            return result;
+        }
+    }
+
+    if (!known) {
+        LOG_DEBUG("config line %u: ignoring [%s] %s", parser->line, parser->section, key);
+    }
+    return PAUMIOT_SUCCESS;
+}
+
+static paumiot_result_t parse_text(config_parser_t *parser, const char *text, size_t len) {
+    const char *p = text;
+    const char *end = text + len;
+
+    parser->section[0] = '\0';
+    parser->line = 0;
+
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', (size_t)(end - p));
+        const char *next = line_end ? line_end + 1 : end;
+        if (!line_end) {
+            line_end = end;
+        }
+        if (line_end > p && line_end[-1] == '\r') {
+            line_end--;
+        }
+
+        parser->line++;
+        paumiot_result_t result = parse_line(parser, p, line_end);
+        if (result != PAUMIOT_SUCCESS) {
+            return result;
+        }
+        p = next;
+    }
+
+    return PAUMIOT_SUCCESS;
+}
+
+static paumiot_result_t read_file(const char *path, char **text, size_t *len,
+                                  paumiot_config_error_t *error) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        invalid(error, "cannot open %s: %s", path, strerror(errno));
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    char *buffer = malloc(PAUMIOT_CONFIG_MAX_FILE_SIZE + 1);
+    if (!buffer) {
+        fclose(file);
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t n = fread(buffer, 1, PAUMIOT_CONFIG_MAX_FILE_SIZE + 1, file);
+    bool failed = ferror(file);
+    fclose(file);
+
+    if (failed || n > PAUMIOT_CONFIG_MAX_FILE_SIZE) {
+        free(buffer);
+        invalid(error, failed ? "cannot read %s" : "%s is larger than 1 MiB", path);
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    *text = buffer;
+    *len = n;
+    return PAUMIOT_SUCCESS;
+}
+
+static paumiot_result_t load_file(const char *path, config_parser_t *parser) {
+    char *text;
+    size_t len;
+
+    paumiot_result_t result = read_file(path, &text, &len, parser->error);
+    if (result == PAUMIOT_SUCCESS) {
+        result = parse_text(parser, text, len);
+        free(text);
+    }
+    return result;
+}
+
+/* ============================================================================
+ * DEFAULTS
+ * ========================================================================= */
+
+void paumiot_config_init(paumiot_config_t *config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+
+    config->io_threads = 2;
+    config->worker_threads = 4;
+    config->max_queue_size = 10000;
+    config->request_timeout_ms = 30000;
+    config->memory_limit = 0;
+
+    config->host = "0.0.0.0";
+    config->mqtt_port = 1883;
+    config->coap_port = 5683;
+    config->http_port = 0;
+
+    config->state_backend = "memory";
+    config->state_persistence = false;
+    config->state_db_path = NULL;
+
+    config->sensor_cache_size = 1024;
+    config->sensor_cache_ttl_ms = 300000;
+
+    config->global_rate_limit = 0;
+    config->per_client_rate_limit = 0;
+
+    config->log_level = "info";
+    config->log_format = "text";
+    config->log_file = NULL;
+
+    config->enable_tls = false;
+
+    config->metrics_enabled = false;
+    config->metrics_port = 9090;
+    config->metrics_endpoint = "/metrics";
+    config->health_endpoint = "/health";
+}
+
+void engine_config_init(engine_config_t *config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+
+    config->worker_threads = 4;
+    config->max_queue_size = 10000;
+    config->high_watermark = 8000;
+    config->low_watermark = 2000;
+    config->request_timeout_ms = 30000;
+    config->response_timeout_ms = 5000;
+    config->rate_limit_window_ms = 1000;
+    config->max_burst_size = 100;
+    config->max_subscriptions_per_client = 100;
+    config->max_inflight_messages = 20;
+    config->max_payload_size = 65536;
+    config->enable_authorization = false;
+    config->enable_transformation = true;
+    config->enable_logging = false;
+}
+
+void state_config_init(state_config_t *config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+
+    config->backend = STORAGE_MEMORY;
+    config->db_path = NULL;
+    config->redis_host = "localhost";
+    config->redis_port = 6379;
+    config->enable_persistence = false;
+    config->sync_interval_ms = 1000;
+    config->snapshot_interval_ms = 60000;
+    config->session_cache_size = 10000;
+    config->subscription_cache_size = 50000;
+    config->cache_ttl_ms = 300000;
+    config->cleanup_interval_ms = 60000;
+    config->session_ttl_ms = 3600000;
+}
+
+void initiator_config_init(initiator_config_t *config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+
+    config->bind_address = "0.0.0.0";
+    config->mqtt_port = 1883;
+    config->coap_port = 5683;
+    config->io_threads = 2;
+    config->backlog = 128;
+    config->max_connections = 1000;
+    config->connection_timeout_ms = 30000;
+    config->idle_timeout_ms = 300000;
+    config->recv_buffer_size = 65536;
+    config->send_buffer_size = 65536;
+    config->global_rate_limit = 0;
+    config->per_client_rate_limit = 0;
+    config->connect_rate_limit = 1000;
+    config->connect_burst = 100;
+    config->admission_queue_size = 10000;
+    config->fast_protocol_detect = true;
+    config->detect_timeout_ms = 5000;
+    config->enable_load_balancing = true;
+    config->lb_algorithm = "round-robin";
+}
+
+void paumiot_runtime_config_init(paumiot_runtime_config_t *config) {
+    if (!config) {
+        return;
+    }
+
+    paumiot_config_init(&config->core);
+    engine_config_init(&config->engine);
+    state_config_init(&config->state);
+    initiator_config_init(&config->initiator);
+    sensor_manager_config_init(&config->sensor_manager);
+}
+
+/* ============================================================================
+ * LOADING
+ * ========================================================================= */
+
+paumiot_result_t paumiot_config_load(const char *path, paumiot_config_t *config) {
+    if (!path || !config) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    paumiot_config_error_t error = { 0, "" };
+    config_parser_t parser = { .core = config, .error = &error };
+    parser.targets[TARGET_CORE] = config;
+
+    paumiot_result_t result = load_file(path, &parser);
+    if (result != PAUMIOT_SUCCESS) {
+        LOG_ERROR("%s:%u: %s", path, error.line, error.message);
+        return result;
+    }
+    return paumiot_config_validate(config);
+}
+
+paumiot_result_t paumiot_runtime_config_parse(const char *text, size_t len,
+                                              paumiot_runtime_config_t *config,
+                                              paumiot_config_error_t *error) {
+    if (!text || !config) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    config_parser_t parser = {
+        .targets = { &config->core, &config->engine, &config->state, &config->initiator,
+                     &config->sensor_manager },
+        .core = &config->core,
+        .error = error,
+    };
+    return parse_text(&parser, text, len);
+}
+
+paumiot_result_t paumiot_runtime_config_load(const char *path,
+                                             paumiot_runtime_config_t *config,
+                                             paumiot_config_error_t *error) {
+    if (!path || !config) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    char *text;
+    size_t len;
+    paumiot_result_t result = read_file(path, &text, &len, error);
+    if (result != PAUMIOT_SUCCESS) {
+        return result;
+    }
+
+    result = paumiot_runtime_config_parse(text, len, config, error);
+    free(text);
+    return result;
+}
+
+/* ============================================================================
+ * PLACEMENT
+ * ========================================================================= */
+
+paumiot_result_t paumiot_runtime_config_place(paumiot_runtime_config_t *config,
+                                              const cpu_topology_t *topology,
+                                              paumiot_config_error_t *error) {
+    if (!config) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    sensor_manager_config_t *sensors = &config->sensor_manager;
+    sensors->dispatch_cpus = NULL;
+    if (config->core.cpu_affinity_count == 0) {
+        return PAUMIOT_SUCCESS;
+    }
+
+    cpu_topology_t discovered;
+    if (!topology) {
+        if (!cpu_topology_discover(&discovered, NULL)) {
+            return invalid(error, "no usable CPU found for cpu_affinity");
+        }
+        topology = &discovered;
+    }
+
+    paumiot_placement_t *placement = malloc(sizeof(*placement));
+    if (!placement) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+    paumiot_result_t result = paumiot_placement_plan(&config->core, topology, placement);
+    if (result == PAUMIOT_SUCCESS && sensors->dispatch_threads <= PAUMIOT_MAX_WORKER_THREADS) {
+        /* Both counts come from worker_threads; wrap if set apart in code */
+        for (size_t i = 0; i < sensors->dispatch_threads; i++) {
+            config->dispatch_cpus[i] = placement->worker_cpu[i % placement->worker_threads];
+        }
+        sensors->dispatch_cpus = config->dispatch_cpus;
+    }
+    free(placement);
+
+    if (result != PAUMIOT_SUCCESS) {
+        return invalid(error, "cpu_affinity cannot place %u I/O and %u worker threads",
+                       config->core.io_threads, config->core.worker_threads);
+    }
+    return PAUMIOT_SUCCESS;
+}
+
+/* ============================================================================
+ * RELOAD COMPATIBILITY
+ * ========================================================================= */
+
+static bool setting_equal(const setting_t *setting, const void *a, const void *b) {
+    const uint8_t *x = (const uint8_t *)a + setting->offset;
+    const uint8_t *y = (const uint8_t *)b + setting->offset;
+
+    switch (setting->type) {
+    case SETTING_BOOL:
+        return memcmp(x, y, sizeof(bool)) == 0;
+    case SETTING_U16:
+        return memcmp(x, y, sizeof(uint16_t)) == 0;
+    case SETTING_U32:
+    case SETTING_MS:
+    case SETTING_DAYS:
+        return memcmp(x, y, sizeof(uint32_t)) == 0;
+    case SETTING_COUNT:
+    case SETTING_BYTES:
+        return memcmp(x, y, sizeof(size_t)) == 0;
+    case SETTING_STRING: {
+        const char *sx, *sy;
+        memcpy(&sx, x, sizeof(sx));
+        memcpy(&sy, y, sizeof(sy));
+        return sx == sy || (sx && sy && strcmp(sx, sy) == 0);
+    }
+    case SETTING_CPUS: {
+        const paumiot_config_t *cx = a, *cy = b;
+        return cx->cpu_affinity_count == cy->cpu_affinity_count &&
+               memcmp(cx->cpu_affinity, cy->cpu_affinity,
+                      cx->cpu_affinity_count * sizeof(uint16_t)) == 0;
+    }
+    }
+    return false;
+}
+
+bool paumiot_runtime_config_needs_restart(const paumiot_runtime_config_t *running,
+                                          const paumiot_runtime_config_t *updated,
+                                          paumiot_config_error_t *error) {
+    const void *old_targets[TARGET_COUNT] = {
+        &running->core, &running->engine, &running->state, &running->initiator,
+        &running->sensor_manager
+    };
+    const void *new_targets[TARGET_COUNT] = {
+        &updated->core, &updated->engine, &updated->state, &updated->initiator,
+        &updated->sensor_manager
+    };
+
+    for (size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); i++) {
+        const setting_t *setting = &settings[i];
+        if (setting->flags & SETTING_RELOADABLE) {
+            continue;
+        }
+        if (!setting_equal(setting, old_targets[setting->target], new_targets[setting->target])) {
+            invalid(error, "[%s] %s cannot change without a restart", setting->section,
+                    setting->key);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ============================================================================
+ * VALIDATION
+ * ========================================================================= */
+
+static bool one_of(const char *value, const char *const *allowed) {
+    for (; value && *allowed; allowed++) {
+        if (strcasecmp(value, *allowed) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_empty(const char *s) {
+    return !s || !*s;
+}
+
+static paumiot_result_t validate_core(const paumiot_config_t *config,
+                                      paumiot_config_error_t *error) {
+    static const char *const log_levels[] = { "debug", "info", "warn", "error", NULL };
+    static const char *const log_formats[] = { "text", "json", NULL };
+    static const char *const backends[] = { "memory", "persistent", "redis", NULL };
+
+    if (is_empty(config->host)) {
+        return invalid(error, "bind address is empty");
+    }
+    if (config->mqtt_port == 0 || config->coap_port == 0) {
+        return invalid(error, "MQTT and CoAP ports must be set");
+    }
+    if (config->mqtt_port == config->coap_port ||
+        (config->http_port != 0 && (config->http_port == config->mqtt_port ||
+                                    config->http_port == config->coap_port))) {
+        return invalid(error, "protocol ports must differ");
+    }
+    if (config->io_threads == 0 || config->io_threads > 256) {
+        return invalid(error, "io_threads must be between 1 and 256");
+    }
+    if (config->worker_threads == 0 || config->worker_threads > 1024) {
+        return invalid(error, "worker_threads must be between 1 and 1024");
+    }
+    if (config->max_queue_size == 0) {
+        return invalid(error, "message queue size must be positive");
+    }
+    if (config->request_timeout_ms == 0) {
+        return invalid(error, "request timeout must be positive");
+    }
+    if (config->memory_limit != 0 && config->memory_limit < (1u << 20)) {
+        return invalid(error, "memory_limit must be 0 (unlimited) or at least 1MB");
+    }
+    if (!one_of(config->log_level, log_levels)) {
+        return invalid(error, "log_level must be DEBUG, INFO, WARN or ERROR");
+    }
+    if (!one_of(config->log_format, log_formats)) {
+        return invalid(error, "log format must be text or json");
+    }
+    if (!one_of(config->state_backend, backends)) {
+        return invalid(error, "state backend must be memory, persistent or redis");
+    }
+    if (config->state_persistence && is_empty(config->state_db_path)) {
+        return invalid(error, "state_persistence requires state_file");
+    }
+    if (config->enable_tls && (is_empty(config->cert_file) || is_empty(config->key_file))) {
+        return invalid(error, "tls_enabled requires cert_file and key_file");
+    }
+    if (config->cpu_affinity_count > PAUMIOT_MAX_AFFINITY_CPUS) {
+        return invalid(error, "cpu_affinity lists more than %d CPUs", PAUMIOT_MAX_AFFINITY_CPUS);
+    }
+    for (uint16_t i = 0; i < config->cpu_affinity_count; i++) {
+        if (config->cpu_affinity[i] >= PAUMIOT_MAX_CPU_ID) {
+            return invalid(error, "cpu_affinity CPU %u out of range", config->cpu_affinity[i]);
+        }
+    }
+    if (config->metrics_enabled) {
+        if (config->metrics_port == 0) {
+            return invalid(error, "metrics_enabled requires metrics_port");
+        }
+        if (config->metrics_port == config->mqtt_port ||
+            config->metrics_port == config->coap_port ||
+            config->metrics_port == config->http_port) {
+            return invalid(error, "metrics_port must differ from the protocol ports");
+        }
+        if (!config->metrics_endpoint || config->metrics_endpoint[0] != '/' ||
+            !config->health_endpoint || config->health_endpoint[0] != '/') {
+            return invalid(error, "metrics and health endpoints must start with '/'");
+        }
+        if (strcmp(config->metrics_endpoint, config->health_endpoint) == 0) {
+            return invalid(error, "metrics and health endpoints must differ");
+        }
+    }
+
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t paumiot_config_validate(const paumiot_config_t *config) {
+    if (!config) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    paumiot_config_error_t error;
+    paumiot_result_t result = validate_core(config, &error);
+    if (result != PAUMIOT_SUCCESS) {
+        LOG_ERROR("Invalid configuration: %s", error.message);
+    }
+    return result;
+}
+
+paumiot_result_t paumiot_runtime_config_validate(const paumiot_runtime_config_t *config,
+                                                 paumiot_config_error_t *error) {
+    static const char *const lb_algorithms[] = {
+        "round-robin", "round_robin", "least-connections", "least_connections", "random", NULL
+    };
+
+    if (!config) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    paumiot_result_t result = validate_core(&config->core, error);
+    if (result != PAUMIOT_SUCCESS) {
+        return result;
+    }
+
+    const engine_config_t *engine = &config->engine;
+    if (engine->worker_threads == 0 || engine->max_queue_size == 0) {
+        return invalid(error, "engine needs worker threads and a queue");
+    }
+    if (engine->low_watermark > engine->high_watermark ||
+        engine->high_watermark > engine->max_queue_size) {
+        return invalid(error, "engine watermarks must satisfy low <= high <= queue size");
+    }
+    if (engine->max_payload_size == 0) {
+        return invalid(error, "max_packet_size must be positive");
+    }
+
+    const state_config_t *state = &config->state;
+    if (state->backend == STORAGE_PERSISTENT && is_empty(state->db_path)) {
+        return invalid(error, "persistent state backend requires state_file");
+    }
+    if (state->backend == STORAGE_REDIS && (is_empty(state->redis_host) || !state->redis_port)) {
+        return invalid(error, "redis state backend requires a host and port");
+    }
+
+    const initiator_config_t *initiator = &config->initiator;
+    if (initiator->io_threads == 0 || initiator->max_connections == 0) {
+        return invalid(error, "max_connections and io_threads must be positive");
+    }
+    if (initiator->connect_rate_limit > 0 &&
+        (initiator->connect_burst == 0 || initiator->admission_queue_size == 0)) {
+        return invalid(error, "connect_rate_limit needs a positive connect_burst and "
+                              "admission_queue_size");
+    }
+    if (initiator->recv_buffer_size < engine->max_payload_size) {
+        return invalid(error, "buffer_size (%zu) is smaller than max_packet_size (%zu)",
+                       initiator->recv_buffer_size, engine->max_payload_size);
+    }
+    if (initiator->enable_load_balancing && !one_of(initiator->lb_algorithm, lb_algorithms)) {
+        return invalid(error, "load_balancing must be round_robin, least_connections or random");
+    }
+
+    const sensor_manager_config_t *sensors = &config->sensor_manager;
+    if (sensors->enable_cache && sensors->cache_size == 0) {
+        return invalid(error, "sensor cache is enabled with no capacity");
+    }
+    if (sensors->enable_aggregation &&
+        (sensors->aggregation_window_ms == 0 ||
+         sensors->aggregation_slide_ms > sensors->aggregation_window_ms)) {
+        return invalid(error, "aggregation_window must be positive and cover the slide");
+    }
+    if (sensors->enable_health_monitoring && sensors->health_check_interval_ms == 0) {
+        return invalid(error, "health_check_interval must be positive");
+    }
+    if (sensors->dispatch_threads == 0 || sensors->dispatch_queue_size == 0) {
+        return invalid(error, "sensor dispatch needs threads and a queue");
+    }
+
+    return PAUMIOT_SUCCESS;
+}
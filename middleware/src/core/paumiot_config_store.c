@@ -0,0 +1,340 @@
+/**
+ * @file paumiot_config_store.c
+ * @brief RCU-published configuration snapshots and SIGHUP reload
+ * @details The current snapshot is a single atomic pointer. Reloads are
+ *          serialised by a mutex, build the replacement off to the side,
+ *          publish it with a release store and free the previous snapshot
+ *          after rcu_synchronize(), so readers never lock or copy.
+ *
+ *          Reloaded settings reach components through listeners, which run
+ *          after the new snapshot is published.
+ *
+ *          SIGHUP is turned into a byte on a self-pipe (the only thing the
+ *          handler does) and a watcher thread performs the reload.
+ */
+
+#include "paumiot_config.h"
+#include "paumiot_admission.h"
+#include "logging.h"
+#include "rcu.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#define WATCH_RELOAD 'r'
+#define WATCH_STOP 's'
+
+typedef struct {
+    paumiot_config_listener_t callback;
+    void *user_data;
+} config_listener_t;
+
+struct paumiot_config_store {
+    _Atomic(paumiot_runtime_config_t *) current;
+    rcu_domain_t rcu;
+    char *path;
+
+    pthread_mutex_t lock;           /* Serialises reloads and listeners */
+    atomic_uint_fast64_t generation;
+    config_listener_t listeners[PAUMIOT_CONFIG_MAX_LISTENERS];
+    size_t num_listeners;
+
+    bool watching;                  /* SIGHUP watcher running */
+    pthread_t watcher;
+    struct sigaction previous_action;
+};
+
+/* SIGHUP self-pipe, owned by the watching store */
+static int watch_pipe[2] = { -1, -1 };
+static pthread_mutex_t watch_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ============================================================================
+ * SNAPSHOTS
+ * ========================================================================= */
+
+static paumiot_runtime_config_t *load_snapshot(const char *path, paumiot_config_error_t *error,
+                                               paumiot_result_t *result) {
+    paumiot_runtime_config_t *config = malloc(sizeof(*config));
+    if (!config) {
+        *result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+        return NULL;
+    }
+
+    /* Settings removed from the file go back to their defaults */
+    paumiot_runtime_config_init(config);
+    *result = paumiot_runtime_config_load(path, config, error);
+    if (*result == PAUMIOT_SUCCESS) {
+        *result = paumiot_runtime_config_validate(config, error);
+    }
+    if (*result == PAUMIOT_SUCCESS) {
+        *result = paumiot_runtime_config_place(config, NULL, error);
+    }
+    if (*result != PAUMIOT_SUCCESS) {
+        free(config);
+        return NULL;
+    }
+    return config;
+}
+
+static void apply_log_level(const char *level) {
+    static const struct {
+        const char *name;
+        log_level_t level;
+    } levels[] = {
+        { "debug", LOG_LEVEL_DEBUG },
+        { "info", LOG_LEVEL_INFO },
+        { "warn", LOG_LEVEL_WARN },
+        { "error", LOG_LEVEL_ERROR },
+    };
+
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        if (strcasecmp(level, levels[i].name) == 0) {
+            log_set_level(levels[i].level);
+            return;
+        }
+    }
+}
+
+/* ============================================================================
+ * STORE API
+ * ========================================================================= */
+
+paumiot_config_store_t *paumiot_config_store_create(const char *path,
+                                                    paumiot_config_error_t *error) {
+    if (!path) {
+        return NULL;
+    }
+
+    paumiot_config_store_t *store = calloc(1, sizeof(*store));
+    if (!store) {
+        return NULL;
+    }
+
+    store->path = strdup(path);
+    if (!store->path) {
+        free(store);
+        return NULL;
+    }
+
+    paumiot_result_t result;
+    paumiot_runtime_config_t *config = load_snapshot(path, error, &result);
+    if (!config) {
+        free(store->path);
+        free(store);
+        return NULL;
+    }
+
+    rcu_init(&store->rcu);
+    pthread_mutex_init(&store->lock, NULL);
+    atomic_init(&store->current, config);
+    atomic_init(&store->generation, 1);
+    apply_log_level(config->core.log_level);
+
+    LOG_INFO("Loaded configuration from %s", path);
+    return store;
+}
+
+void paumiot_config_store_destroy(paumiot_config_store_t *store) {
+    if (!store) {
+        return;
+    }
+
+    pthread_mutex_lock(&watch_lock);
+    if (store->watching) {
+        char stop = WATCH_STOP;
+        while (write(watch_pipe[1], &stop, 1) < 0 && (errno == EINTR || errno == EAGAIN)) {
+            sched_yield();
+        }
+        pthread_join(store->watcher, NULL);
+
+        sigaction(SIGHUP, &store->previous_action, NULL);
+        close(watch_pipe[0]);
+        close(watch_pipe[1]);
+        watch_pipe[0] = watch_pipe[1] = -1;
+        store->watching = false;
+    }
+    pthread_mutex_unlock(&watch_lock);
+
+    pthread_mutex_destroy(&store->lock);
+    free(atomic_load(&store->current));
+    free(store->path);
+    free(store);
+}
+
+const paumiot_runtime_config_t *paumiot_config_store_acquire(paumiot_config_store_t *store,
+                                                             unsigned *token) {
+    *token = rcu_read_lock(&store->rcu);
+    return atomic_load_explicit(&store->current, memory_order_acquire);
+}
+
+void paumiot_config_store_release(paumiot_config_store_t *store, unsigned token) {
+    rcu_read_unlock(&store->rcu, token);
+}
+
+uint64_t paumiot_config_store_generation(paumiot_config_store_t *store) {
+    return store ? atomic_load(&store->generation) : 0;
+}
+
+paumiot_result_t paumiot_config_store_add_listener(paumiot_config_store_t *store,
+                                                   paumiot_config_listener_t listener,
+                                                   void *user_data) {
+    if (!store || !listener) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    paumiot_result_t result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+    pthread_mutex_lock(&store->lock);
+    if (store->num_listeners < PAUMIOT_CONFIG_MAX_LISTENERS) {
+        store->listeners[store->num_listeners].callback = listener;
+        store->listeners[store->num_listeners].user_data = user_data;
+        store->num_listeners++;
+        result = PAUMIOT_SUCCESS;
+    }
+    pthread_mutex_unlock(&store->lock);
+
+    return result;
+}
+
+paumiot_result_t paumiot_config_store_reload(paumiot_config_store_t *store,
+                                             paumiot_config_error_t *error) {
+    if (!store) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    paumiot_result_t result;
+    paumiot_runtime_config_t *updated = load_snapshot(store->path, error, &result);
+    if (!updated) {
+        return result;
+    }
+
+    pthread_mutex_lock(&store->lock);
+
+    /* Only the reloader replaces the pointer, so the lock makes this stable */
+    paumiot_runtime_config_t *previous = atomic_load_explicit(&store->current,
+                                                              memory_order_relaxed);
+    if (paumiot_runtime_config_needs_restart(previous, updated, error)) {
+        pthread_mutex_unlock(&store->lock);
+        free(updated);
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    atomic_store_explicit(&store->current, updated, memory_order_release);
+    uint64_t generation = atomic_fetch_add(&store->generation, 1) + 1;
+    apply_log_level(updated->core.log_level);
+
+    for (size_t i = 0; i < store->num_listeners; i++) {
+        store->listeners[i].callback(previous, updated, store->listeners[i].user_data);
+    }
+
+    rcu_synchronize(&store->rcu);
+    pthread_mutex_unlock(&store->lock);
+    free(previous);
+
+    LOG_INFO("Reloaded configuration from %s (generation %llu)", store->path,
+             (unsigned long long)generation);
+    return PAUMIOT_SUCCESS;
+}
+
+/* ============================================================================
+ * COMPONENT LISTENERS
+ * ========================================================================= */
+
+void paumiot_config_apply_sensor_manager(const paumiot_runtime_config_t *previous,
+                                         const paumiot_runtime_config_t *current,
+                                         void *sensor_manager) {
+    (void)previous;
+    if (sensor_manager_reconfigure(sensor_manager, &current->sensor_manager) != PAUMIOT_SUCCESS) {
+        LOG_ERROR("Failed to apply reloaded sensor manager settings");
+    }
+}
+
+void paumiot_config_apply_admission(const paumiot_runtime_config_t *previous,
+                                    const paumiot_runtime_config_t *current,
+                                    void *admission) {
+    (void)previous;
+    paumiot_admission_configure(admission, &current->initiator);
+}
+
+/* ============================================================================
+ * SIGHUP
+ * ========================================================================= */
+
+static void sighup_handler(int signo) {
+    int saved_errno = errno;
+    char reload = WATCH_RELOAD;
+
+    (void)signo;
+    /* A full pipe already has a reload pending */
+    if (write(watch_pipe[1], &reload, 1) < 0) {
+        /* Nothing useful to do in a signal handler */
+    }
+    errno = saved_errno;
+}
+
+static void *watcher_main(void *arg) {
+    paumiot_config_store_t *store = arg;
+
+    for (;;) {
+        char command;
+        ssize_t n = read(watch_pipe[0], &command, 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0 || command == WATCH_STOP) {
+            break;
+        }
+
+        paumiot_config_error_t error = { 0, "" };
+        paumiot_result_t result = paumiot_config_store_reload(store, &error);
+        if (result != PAUMIOT_SUCCESS) {
+            LOG_ERROR("Configuration reload failed, keeping the running configuration: "
+                      "%s:%u: %s", store->path, error.line, error.message);
+        }
+    }
+
+    return NULL;
+}
+
+paumiot_result_t paumiot_config_store_watch_sighup(paumiot_config_store_t *store) {
+    if (!store) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&watch_lock);
+    if (watch_pipe[0] >= 0) {
+        pthread_mutex_unlock(&watch_lock);
+        return PAUMIOT_ERROR_ALREADY_INITIALIZED;
+    }
+
+    if (pipe(watch_pipe) != 0) {
+        pthread_mutex_unlock(&watch_lock);
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+    fcntl(watch_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(watch_pipe[1], F_SETFD, FD_CLOEXEC);
+    fcntl(watch_pipe[1], F_SETFL, fcntl(watch_pipe[1], F_GETFL) | O_NONBLOCK);
+
+    if (pthread_create(&store->watcher, NULL, watcher_main, store) != 0) {
+        close(watch_pipe[0]);
+        close(watch_pipe[1]);
+        watch_pipe[0] = watch_pipe[1] = -1;
+        pthread_mutex_unlock(&watch_lock);
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = sighup_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGHUP, &action, &store->previous_action);
+
+    store->watching = true;
+    pthread_mutex_unlock(&watch_lock);
+    return PAUMIOT_SUCCESS;
+}
@@ -0,0 +1,371 @@
+/**
+ * @file paumiot_metrics.c
+ * @brief Prometheus /metrics endpoint
+ * @details One thread polls the listening socket and a stop pipe, and
+ *          answers each connection in turn: read the request head, render
+ *          or reject, write, close. Scrapes are infrequent and cheap, so
+ *          there is no connection concurrency or keep-alive to manage.
+ *
+ *          Accepted sockets are non-blocking. Every wait polls the socket
+ *          together with the stop pipe, bounded by the connection's
+ *          deadline, so neither a slow client nor a stop request can be
+ *          held up by the other.
+ */
+
+#include "paumiot_metrics.h"
+#include "logging.h"
+#include "time_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+struct paumiot_metrics_server {
+    metrics_registry_t *registry;
+    char *metrics_endpoint;
+    char *health_endpoint;
+    int listen_fd;
+    int stop_pipe[2];
+    uint16_t port;
+    pthread_t thread;
+};
+
+/* Connection being answered */
+typedef struct {
+    int fd;
+    int stop_fd;                    /* Read end of the stop pipe */
+    uint64_t deadline_ms;           /* Monotonic time the connection is dropped at */
+} connection_t;
+
+/* ============================================================================
+ * REQUEST HANDLING
+ * ========================================================================= */
+
+/**
+ * @brief Wait until the socket is ready
+ * @return false on the deadline, a stop request or a poll error
+ */
+static bool wait_ready(const connection_t *conn, short events) {
+    struct pollfd fds[2] = {
+        { .fd = conn->fd, .events = events },
+        { .fd = conn->stop_fd, .events = POLLIN },
+    };
+
+    for (;;) {
+        uint64_t now = time_monotonic_ms();
+        if (now >= conn->deadline_ms) {
+            return false;
+        }
+        int n = poll(fds, 2, (int)(conn->deadline_ms - now));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 || fds[1].revents) {
+            return false;
+        }
+        if (fds[0].revents) {
+            return true;
+        }
+    }
+}
+
+static bool send_all(const connection_t *conn, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(conn->fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!wait_ready(conn, POLLOUT)) {
+                return false;
+            }
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static void respond(const connection_t *conn, const char *status, const char *content_type,
+                    const char *body, size_t body_len, bool head_only) {
+    char header[256];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %s\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Connection: close\r\n"
+                     "\r\n",
+                     status, content_type, body_len);
+
+    if (send_all(conn, header, (size_t)n) && !head_only) {
+        send_all(conn, body, body_len);
+    }
+}
+
+static void respond_text(const connection_t *conn, const char *status, const char *body,
+                         bool head_only) {
+    respond(conn, status, "text/plain; charset=utf-8", body, strlen(body), head_only);
+}
+
+/**
+ * @brief Read until the end of the request head
+ * @return Head length, 0 if the peer closed, timed out or the server is
+ *         stopping, or -1 if too long
+ */
+static ssize_t read_head(const connection_t *conn, char *buf, size_t size) {
+    size_t len = 0;
+
+    while (len < size - 1) {
+        ssize_t n = recv(conn->fd, buf + len, size - 1 - len, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!wait_ready(conn, POLLIN)) {
+                return 0;
+            }
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        len += (size_t)n;
+        buf[len] = '\0';
+        if (strstr(buf, "\r\n\r\n") || strstr(buf, "\n\n")) {
+            return (ssize_t)len;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Discard what the client sent past the request head
+ * @details Closing a socket with unread input resets the connection, which
+ *          can destroy the response before the client reads it.
+ */
+static void drain(const connection_t *conn) {
+    char discard[512];
+    size_t total = 0;
+
+    while (total < PAUMIOT_METRICS_MAX_DRAIN) {
+        ssize_t n = recv(conn->fd, discard, sizeof(discard), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!wait_ready(conn, POLLIN)) {
+                return;
+            }
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        total += (size_t)n;
+    }
+}
+
+static void handle_connection(paumiot_metrics_server_t *server, const connection_t *conn) {
+    char request[PAUMIOT_METRICS_MAX_REQUEST];
+    ssize_t len = read_head(conn, request, sizeof(request));
+    if (len == 0) {
+        return;
+    }
+    if (len < 0) {
+        respond_text(conn, "431 Request Header Fields Too Large", "Request too large\n", false);
+        return;
+    }
+
+    /* Request line: METHOD SP target SP version */
+    char *method = request;
+    char *target = strchr(method, ' ');
+    char *version = target ? strchr(target + 1, ' ') : NULL;
+    if (!target || !version || strncmp(version + 1, "HTTP/1.", 7) != 0) {
+        respond_text(conn, "400 Bad Request", "Bad request\n", false);
+        return;
+    }
+    *target++ = '\0';
+    *version = '\0';
+    target[strcspn(target, "?")] = '\0';
+
+    bool head_only = strcmp(method, "HEAD") == 0;
+    if (!head_only && strcmp(method, "GET") != 0) {
+        respond_text(conn, "405 Method Not Allowed", "Method not allowed\n", false);
+        return;
+    }
+
+    if (strcmp(target, server->metrics_endpoint) == 0) {
+        size_t body_len;
+        char *body = metrics_render(server->registry, &body_len);
+        if (!body) {
+            respond_text(conn, "500 Internal Server Error", "Out of memory\n", head_only);
+            return;
+        }
+        respond(conn, "200 OK", METRICS_CONTENT_TYPE, body, body_len, head_only);
+        free(body);
+    } else if (strcmp(target, server->health_endpoint) == 0) {
+        respond_text(conn, "200 OK", "OK\n", head_only);
+    } else {
+        respond_text(conn, "404 Not Found", "Not found\n", head_only);
+    }
+}
+
+static void *server_main(void *arg) {
+    paumiot_metrics_server_t *server = arg;
+    struct pollfd fds[2] = {
+        { .fd = server->listen_fd, .events = POLLIN },
+        { .fd = server->stop_pipe[0], .events = POLLIN },
+    };
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Metrics server poll failed: %s", strerror(errno));
+            break;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        connection_t conn = {
+            .fd = fd,
+            .stop_fd = server->stop_pipe[0],
+            .deadline_ms = time_monotonic_ms() + PAUMIOT_METRICS_IO_TIMEOUT_MS,
+        };
+        handle_connection(server, &conn);
+
+        /* Let the client read the response before closing on unread input */
+        shutdown(fd, SHUT_WR);
+        drain(&conn);
+        close(fd);
+    }
+
+    return NULL;
+}
+
+/* ============================================================================
+ * METRICS SERVER API
+ * ========================================================================= */
+
+static void server_free(paumiot_metrics_server_t *server) {
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+    }
+    if (server->stop_pipe[0] >= 0) {
+        close(server->stop_pipe[0]);
+        close(server->stop_pipe[1]);
+    }
+    free(server->metrics_endpoint);
+    free(server->health_endpoint);
+    free(server);
+}
+
+paumiot_metrics_server_t *paumiot_metrics_server_start(const paumiot_config_t *config,
+                                                       metrics_registry_t *registry) {
+    if (!config || !registry || !config->metrics_endpoint || !config->health_endpoint) {
+        return NULL;
+    }
+
+    paumiot_metrics_server_t *server = calloc(1, sizeof(*server));
+    if (!server) {
+        return NULL;
+    }
+    server->registry = registry;
+    server->listen_fd = -1;
+    server->stop_pipe[0] = server->stop_pipe[1] = -1;
+    server->metrics_endpoint = strdup(config->metrics_endpoint);
+    server->health_endpoint = strdup(config->health_endpoint);
+    if (!server->metrics_endpoint || !server->health_endpoint) {
+        server_free(server);
+        return NULL;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config->metrics_port);
+    const char *host = config->host ? config->host : "0.0.0.0";
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        LOG_ERROR("Metrics server: invalid bind address %s", host);
+        server_free(server);
+        return NULL;
+    }
+
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listen_fd < 0) {
+        server_free(server);
+        return NULL;
+    }
+    fcntl(server->listen_fd, F_SETFD, FD_CLOEXEC);
+
+    int one = 1;
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    socklen_t addr_len = sizeof(addr);
+    if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, 16) != 0 ||
+        getsockname(server->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        LOG_ERROR("Metrics server: cannot listen on %s:%u: %s", host,
+                  (unsigned)config->metrics_port, strerror(errno));
+        server_free(server);
+        return NULL;
+    }
+    server->port = ntohs(addr.sin_port);
+
+    if (pipe(server->stop_pipe) != 0) {
+        server->stop_pipe[0] = server->stop_pipe[1] = -1;
+        server_free(server);
+        return NULL;
+    }
+    fcntl(server->stop_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(server->stop_pipe[1], F_SETFD, FD_CLOEXEC);
+
+    if (pthread_create(&server->thread, NULL, server_main, server) != 0) {
+        server_free(server);
+        return NULL;
+    }
+
+    LOG_INFO("Serving metrics on http://%s:%u%s", host, (unsigned)server->port,
+             server->metrics_endpoint);
+    return server;
+}
+
+uint16_t paumiot_metrics_server_port(const paumiot_metrics_server_t *server) {
+    return server ? server->port : 0;
+}
+
+void paumiot_metrics_server_stop(paumiot_metrics_server_t *server) {
+    if (!server) {
+        return;
+    }
+
+    char stop = 's';
+    while (write(server->stop_pipe[1], &stop, 1) < 0 && errno == EINTR) {
+    }
+    pthread_join(server->thread, NULL);
+    server_free(server);
+}
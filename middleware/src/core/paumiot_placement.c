@@ -0,0 +1,158 @@
+/**
+ * @file paumiot_placement.c
+ * @brief Thread placement across CPUs and NUMA nodes
+ */
+
+#include "paumiot_placement.h"
+#include "logging.h"
+#include <string.h>
+
+/**
+ * @brief Split threads over nodes in proportion to their CPUs
+ * @details Every node with CPUs gets one thread first if there are enough,
+ *          so each socket has a reactor and a worker of its own. The rest
+ *          are shared by largest remainder, ties going to the lower node.
+ */
+static void distribute(uint32_t threads, const uint32_t *sizes, uint16_t num_nodes,
+                       uint32_t *shares) {
+    uint32_t total = 0;
+    uint32_t nodes_used = 0;
+    bool extra[CPU_TOPOLOGY_MAX_NODES] = { false };
+
+    for (uint16_t n = 0; n < num_nodes; n++) {
+        shares[n] = 0;
+        total += sizes[n];
+        nodes_used += sizes[n] > 0;
+    }
+    if (total == 0) {
+        return;                         /* No CPUs: nothing to share out */
+    }
+
+    uint32_t remaining = threads;
+    if (threads >= nodes_used) {
+        for (uint16_t n = 0; n < num_nodes; n++) {
+            shares[n] = sizes[n] > 0;
+        }
+        remaining -= nodes_used;
+    }
+
+    uint32_t given = 0;
+    for (uint16_t n = 0; n < num_nodes; n++) {
+        uint32_t share = (uint32_t)((uint64_t)remaining * sizes[n] / total);
+        shares[n] += share;
+        given += share;
+    }
+
+    while (given < remaining) {
+        int best = -1;
+        uint64_t best_remainder = 0;
+        for (uint16_t n = 0; n < num_nodes; n++) {
+            uint64_t remainder = (uint64_t)remaining * sizes[n] % total;
+            if (sizes[n] > 0 && !extra[n] && (best < 0 || remainder > best_remainder)) {
+                best = n;
+                best_remainder = remainder;
+            }
+        }
+        extra[best] = true;
+        shares[best]++;
+        given++;
+    }
+}
+
+paumiot_result_t paumiot_placement_plan(const paumiot_config_t *config,
+                                        const cpu_topology_t *topology,
+                                        paumiot_placement_t *placement) {
+    if (!config || !topology || !placement || topology->num_nodes == 0 ||
+        config->io_threads == 0 || config->io_threads > PAUMIOT_MAX_IO_THREADS ||
+        config->worker_threads == 0 || config->worker_threads > PAUMIOT_MAX_WORKER_THREADS) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    bool in_pool[CPU_TOPOLOGY_MAX_CPUS] = { false };
+    if (config->cpu_affinity_count > 0) {
+        for (uint16_t i = 0; i < config->cpu_affinity_count; i++) {
+            int cpu = config->cpu_affinity[i];
+            if (cpu_topology_node(topology, cpu) < 0) {
+                LOG_ERROR("cpu_affinity lists CPU %d, which is offline or not allowed", cpu);
+                return PAUMIOT_ERROR_INVALID_PARAM;
+            }
+            in_pool[cpu] = true;
+        }
+    } else {
+        for (uint16_t i = 0; i < topology->num_cpus; i++) {
+            in_pool[topology->cpus[i]] = true;
+        }
+    }
+
+    /* Pool CPUs grouped by node */
+    uint16_t pool[CPU_TOPOLOGY_MAX_CPUS];
+    uint32_t node_start[CPU_TOPOLOGY_MAX_NODES];
+    uint32_t sizes[CPU_TOPOLOGY_MAX_NODES];
+    uint32_t pool_size = 0;
+    for (uint16_t n = 0; n < topology->num_nodes; n++) {
+        node_start[n] = pool_size;
+        for (uint16_t i = 0; i < topology->num_cpus; i++) {
+            uint16_t cpu = topology->cpus[i];
+            if (in_pool[cpu] && topology->cpu_node[cpu] == n) {
+                pool[pool_size++] = cpu;
+            }
+        }
+        sizes[n] = pool_size - node_start[n];
+    }
+    if (pool_size == 0) {
+        LOG_ERROR("No usable CPU to place threads on");
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t io_shares[CPU_TOPOLOGY_MAX_NODES];
+    uint32_t worker_shares[CPU_TOPOLOGY_MAX_NODES];
+    distribute(config->io_threads, sizes, topology->num_nodes, io_shares);
+    distribute(config->worker_threads, sizes, topology->num_nodes, worker_shares);
+
+    memset(placement, 0, sizeof(*placement));
+    placement->io_threads = config->io_threads;
+    placement->worker_threads = config->worker_threads;
+    placement->num_nodes = topology->num_nodes;
+
+    uint32_t io = 0;
+    uint32_t worker = 0;
+    for (uint16_t n = 0; n < topology->num_nodes; n++) {
+        const uint16_t *cpus = &pool[node_start[n]];
+        uint32_t m = sizes[n];
+        uint32_t reactors = io_shares[n];
+
+        for (uint32_t k = 0; k < reactors; k++, io++) {
+            placement->io_cpu[io] = (int16_t)cpus[k % m];
+            placement->io_node[io] = n;
+        }
+
+        /* Workers avoid the reactors' CPUs while the node has spare ones */
+        placement->node_first_worker[n] = worker;
+        placement->node_workers[n] = worker_shares[n];
+        for (uint32_t k = 0; k < worker_shares[n]; k++, worker++) {
+            uint16_t cpu = m > reactors ? cpus[reactors + k % (m - reactors)] : cpus[k % m];
+            placement->worker_cpu[worker] = (int16_t)cpu;
+            placement->worker_node[worker] = n;
+        }
+    }
+
+    return PAUMIOT_SUCCESS;
+}
+
+uint32_t paumiot_placement_worker_for_node(const paumiot_placement_t *placement,
+                                           uint16_t node, uint32_t hash) {
+    if (node < placement->num_nodes && placement->node_workers[node] > 0) {
+        return placement->node_first_worker[node] + hash % placement->node_workers[node];
+    }
+    return hash % placement->worker_threads;
+}
+
+uint32_t paumiot_placement_worker_for_cpu(const paumiot_placement_t *placement,
+                                          const cpu_topology_t *topology,
+                                          int cpu, uint32_t hash) {
+    int node = cpu_topology_node(topology, cpu);
+    if (node < 0) {
+        return hash % placement->worker_threads;
+    }
+    return paumiot_placement_worker_for_node(placement, (uint16_t)node, hash);
+}
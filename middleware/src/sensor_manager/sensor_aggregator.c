@@ -0,0 +1,450 @@
+/**
+ * @file sensor_aggregator.c
+ * @brief Pane-based tumbling/sliding window aggregation
+ * @details A window of N panes is kept as a ring indexed by pane number
+ *          (timestamp / slide_ms). Adding a sample is O(1); closing a
+ *          window folds at most N panes. Tumbling windows are the N = 1 case
+ *          and hand the pane's digest to the callback without copying.
+ */
+
+#include "sensor_manager/sensor_aggregator.h"
+#include "sensor_manager_internal.h"
+#include "tdigest.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define AGG_SERIES_BUCKETS 1024
+#define AGG_PANE_UNUSED UINT64_MAX
+
+/* One slide-sized slice of a window */
+typedef struct {
+    uint64_t id;                    /* Pane number, or AGG_PANE_UNUSED */
+    uint64_t count;
+    double sum;
+    double min;
+    double max;
+    double last;
+    uint64_t last_ts;
+    tdigest_t digest;
+} agg_pane_t;
+
+/* Per-sensor window state */
+struct agg_series {
+    char *sensor_id;                /* Owned copy of the sensor ID */
+    uint32_t hash;
+    atomic_uint refs;               /* One for the table, one per acquirer */
+    pthread_mutex_t lock;           /* Guards removed, head and panes */
+    bool removed;                   /* Unlinked; samples are discarded */
+    bool started;                   /* head is valid */
+    uint64_t head;                  /* Newest pane number seen */
+    struct agg_series *next;        /* Hash chain */
+    agg_pane_t panes[];             /* Ring of num_panes panes */
+};
+
+typedef sensor_aggregator_series_t agg_series_t;
+
+struct sensor_aggregator {
+    uint32_t window_ms;
+    uint32_t slide_ms;
+    size_t num_panes;               /* window_ms / slide_ms */
+    sensor_aggregate_callback_t callback;
+    void *user_data;
+
+    pthread_rwlock_t lock;          /* Guards the series table */
+    agg_series_t *buckets[AGG_SERIES_BUCKETS];
+
+    atomic_uint_fast64_t late_samples;
+};
+
+/* ============================================================================
+ * WINDOW STATE
+ * ========================================================================= */
+
+static void pane_reset(agg_pane_t *pane, uint64_t id) {
+    pane->id = id;
+    pane->count = 0;
+    pane->sum = 0.0;
+    pane->min = INFINITY;
+    pane->max = -INFINITY;
+    pane->last = 0.0;
+    pane->last_ts = 0;
+    tdigest_reset(&pane->digest);
+}
+
+/**
+ * @brief Emit the window ending at the start of pane `end_pane`
+ * @details The window covers panes [end_pane - num_panes, end_pane - 1].
+ */
+static void series_emit(sensor_aggregator_t *agg, agg_series_t *series, uint64_t end_pane) {
+    uint64_t first = end_pane >= agg->num_panes ? end_pane - agg->num_panes : 0;
+    sensor_aggregate_t out = {
+        .sensor_id = series->sensor_id,
+        .window_start = first * agg->slide_ms,
+        .window_end = end_pane * agg->slide_ms,
+        .min = INFINITY,
+        .max = -INFINITY
+    };
+
+    tdigest_t *digest = NULL;
+    tdigest_t merged;
+    if (agg->num_panes > 1) {
+        tdigest_reset(&merged);
+        digest = &merged;
+    }
+
+    for (size_t i = 0; i < agg->num_panes; i++) {
+        agg_pane_t *pane = &series->panes[i];
+        if (pane->count == 0 || pane->id == AGG_PANE_UNUSED ||
+            pane->id < first || pane->id >= end_pane) {
+            continue;
+        }
+
+        out.count += pane->count;
+        out.sum += pane->sum;
+        if (pane->min < out.min) {
+            out.min = pane->min;
+        }
+        if (pane->max > out.max) {
+            out.max = pane->max;
+        }
+        if (out.last_timestamp == 0 || pane->last_ts >= out.last_timestamp) {
+            out.last = pane->last;
+            out.last_timestamp = pane->last_ts;
+        }
+
+        if (agg->num_panes > 1) {
+            tdigest_merge(&merged, &pane->digest);
+        } else {
+            digest = &pane->digest;
+        }
+    }
+
+    if (out.count == 0) {
+        return;
+    }
+
+    out.mean = out.sum / (double)out.count;
+    out.p50 = tdigest_quantile(digest, 0.50);
+    out.p90 = tdigest_quantile(digest, 0.90);
+    out.p99 = tdigest_quantile(digest, 0.99);
+
+    agg->callback(&out, agg->user_data);
+}
+
+/**
+ * @brief Close windows ending at panes head+1 .. pane (caller holds lock)
+ */
+static void series_advance(sensor_aggregator_t *agg, agg_series_t *series, uint64_t pane) {
+    if (!series->started || pane <= series->head) {
+        return;
+    }
+
+    /* After num_panes steps every pane has slid out; skip the empty rest */
+    uint64_t steps = pane - series->head;
+    if (steps > agg->num_panes) {
+        steps = agg->num_panes;
+    }
+
+    for (uint64_t p = series->head + 1; p <= series->head + steps; p++) {
+        series_emit(agg, series, p);
+    }
+
+    series->head = pane;
+}
+
+static agg_series_t *series_find(sensor_aggregator_t *agg, const char *sensor_id,
+                                 uint32_t hash) {
+    for (agg_series_t *s = agg->buckets[hash % AGG_SERIES_BUCKETS]; s; s = s->next) {
+        if (s->hash == hash && strcmp(s->sensor_id, sensor_id) == 0) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+static void series_free(agg_series_t *series) {
+    pthread_mutex_destroy(&series->lock);
+    free(series->sensor_id);
+    free(series);
+}
+
+/* ============================================================================
+ * SENSOR AGGREGATOR API
+ * ========================================================================= */
+
+sensor_aggregator_series_t *sensor_aggregator_acquire(sensor_aggregator_t *agg,
+                                                      const char *sensor_id) {
+    if (!agg || !sensor_id) {
+        return NULL;
+    }
+
+    uint32_t hash = sensor_id_hash(sensor_id, NULL);
+
+    pthread_rwlock_rdlock(&agg->lock);
+    agg_series_t *series = series_find(agg, sensor_id, hash);
+    if (series) {
+        atomic_fetch_add_explicit(&series->refs, 1, memory_order_relaxed);
+    }
+    pthread_rwlock_unlock(&agg->lock);
+    if (series) {
+        return series;
+    }
+
+    pthread_rwlock_wrlock(&agg->lock);
+
+    series = series_find(agg, sensor_id, hash);
+    if (series) {
+        atomic_fetch_add_explicit(&series->refs, 1, memory_order_relaxed);
+    } else {
+        series = calloc(1, sizeof(agg_series_t) + agg->num_panes * sizeof(agg_pane_t));
+        if (series) {
+            series->sensor_id = strdup(sensor_id);
+            if (!series->sensor_id) {
+                free(series);
+                series = NULL;
+            } else {
+                series->hash = hash;
+                atomic_init(&series->refs, 2);
+                pthread_mutex_init(&series->lock, NULL);
+                for (size_t i = 0; i < agg->num_panes; i++) {
+                    series->panes[i].id = AGG_PANE_UNUSED;
+                }
+                series->next = agg->buckets[hash % AGG_SERIES_BUCKETS];
+                agg->buckets[hash % AGG_SERIES_BUCKETS] = series;
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&agg->lock);
+    return series;
+}
+
+void sensor_aggregator_release(sensor_aggregator_series_t *series) {
+    if (series && atomic_fetch_sub_explicit(&series->refs, 1, memory_order_acq_rel) == 1) {
+        series_free(series);
+    }
+}
+
+sensor_aggregator_t *sensor_aggregator_create(uint32_t window_ms, uint32_t slide_ms,
+                                              sensor_aggregate_callback_t callback,
+                                              void *user_data) {
+    if (window_ms == 0 || !callback) {
+        return NULL;
+    }
+
+    if (slide_ms == 0) {
+        slide_ms = window_ms;
+    }
+
+    if (slide_ms > window_ms || window_ms % slide_ms != 0 ||
+        window_ms / slide_ms > SENSOR_AGGREGATOR_MAX_PANES) {
+        return NULL;
+    }
+
+    sensor_aggregator_t *agg = calloc(1, sizeof(sensor_aggregator_t));
+    if (!agg) {
+        return NULL;
+    }
+
+    agg->window_ms = window_ms;
+    agg->slide_ms = slide_ms;
+    agg->num_panes = window_ms / slide_ms;
+    agg->callback = callback;
+    agg->user_data = user_data;
+    pthread_rwlock_init(&agg->lock, NULL);
+    atomic_init(&agg->late_samples, 0);
+
+    return agg;
+}
+
+void sensor_aggregator_destroy(sensor_aggregator_t *agg) {
+    if (!agg) {
+        return;
+    }
+
+    for (size_t i = 0; i < AGG_SERIES_BUCKETS; i++) {
+        agg_series_t *series = agg->buckets[i];
+        while (series) {
+            agg_series_t *next = series->next;
+            sensor_aggregator_release(series);
+            series = next;
+        }
+    }
+
+    pthread_rwlock_destroy(&agg->lock);
+    free(agg);
+}
+
+paumiot_result_t sensor_aggregator_add(sensor_aggregator_t *agg, const char *sensor_id,
+                                       uint64_t timestamp, double value) {
+    if (!agg || !sensor_id || isnan(value)) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    agg_series_t *series = sensor_aggregator_acquire(agg, sensor_id);
+    if (!series) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    paumiot_result_t result = sensor_aggregator_add_series(agg, series, timestamp, value);
+    sensor_aggregator_release(series);
+    return result;
+}
+
+paumiot_result_t sensor_aggregator_add_series(sensor_aggregator_t *agg,
+                                              sensor_aggregator_series_t *series,
+                                              uint64_t timestamp, double value) {
+    if (!agg || !series || isnan(value)) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t pane_id = timestamp / agg->slide_ms;
+
+    pthread_mutex_lock(&series->lock);
+
+    if (series->removed) {
+        pthread_mutex_unlock(&series->lock);
+        return PAUMIOT_SUCCESS;
+    }
+
+    if (!series->started) {
+        series->started = true;
+        series->head = pane_id;
+    } else if (pane_id > series->head) {
+        series_advance(agg, series, pane_id);
+    } else if (series->head - pane_id >= agg->num_panes) {
+        /* Every window that could hold this sample has been emitted */
+        pthread_mutex_unlock(&series->lock);
+        atomic_fetch_add_explicit(&agg->late_samples, 1, memory_order_relaxed);
+        return PAUMIOT_SUCCESS;
+    }
+
+    agg_pane_t *pane = &series->panes[pane_id % agg->num_panes];
+    if (pane->id != pane_id) {
+        pane_reset(pane, pane_id);
+    }
+
+    pane->count++;
+    pane->sum += value;
+    if (value < pane->min) {
+        pane->min = value;
+    }
+    if (value > pane->max) {
+        pane->max = value;
+    }
+    if (pane->count == 1 || timestamp >= pane->last_ts) {
+        pane->last = value;
+        pane->last_ts = timestamp;
+    }
+    tdigest_add(&pane->digest, value, 1.0);
+
+    pthread_mutex_unlock(&series->lock);
+    return PAUMIOT_SUCCESS;
+}
+
+void sensor_aggregator_advance(sensor_aggregator_t *agg, uint64_t now_ms) {
+    if (!agg) {
+        return;
+    }
+
+    uint64_t pane_id = now_ms / agg->slide_ms;
+
+    /* Series are only removed under the write lock, so they stay valid here */
+    pthread_rwlock_rdlock(&agg->lock);
+    for (size_t i = 0; i < AGG_SERIES_BUCKETS; i++) {
+        for (agg_series_t *series = agg->buckets[i]; series; series = series->next) {
+            pthread_mutex_lock(&series->lock);
+            series_advance(agg, series, pane_id);
+            pthread_mutex_unlock(&series->lock);
+        }
+    }
+    pthread_rwlock_unlock(&agg->lock);
+}
+
+void sensor_aggregator_remove(sensor_aggregator_t *agg, const char *sensor_id) {
+    if (!agg || !sensor_id) {
+        return;
+    }
+
+    uint32_t hash = sensor_id_hash(sensor_id, NULL);
+
+    pthread_rwlock_wrlock(&agg->lock);
+
+    agg_series_t **link = &agg->buckets[hash % AGG_SERIES_BUCKETS];
+    while (*link && ((*link)->hash != hash || strcmp((*link)->sensor_id, sensor_id) != 0)) {
+        link = &(*link)->next;
+    }
+
+    agg_series_t *series = *link;
+    if (series) {
+        *link = series->next;
+    }
+
+    pthread_rwlock_unlock(&agg->lock);
+
+    if (series) {
+        /* Holders of a reference may still add; make them discard */
+        pthread_mutex_lock(&series->lock);
+        series->removed = true;
+        pthread_mutex_unlock(&series->lock);
+        sensor_aggregator_release(series);
+    }
+}
+
+uint64_t sensor_aggregator_late_samples(const sensor_aggregator_t *agg) {
+    if (!agg) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&((sensor_aggregator_t *)agg)->late_samples,
+                                memory_order_relaxed);
+}
+
+int sensor_aggregate_to_json(const sensor_aggregate_t *aggregate, char *buf, size_t len) {
+    if (!aggregate || !buf || len == 0) {
+        return -1;
+    }
+
+    /* Quotes, backslashes and control characters are escaped; IDs are
+     * truncated rather than split inside an escape */
+    char id[128];
+    size_t pos = 0;
+    for (const char *p = aggregate->sensor_id ? aggregate->sensor_id : ""; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c < 0x20) {
+            if (pos + 6 >= sizeof(id)) {
+                break;
+            }
+            pos += (size_t)snprintf(id + pos, sizeof(id) - pos, "\\u%04x", c);
+        } else {
+            if (pos + 2 >= sizeof(id)) {
+                break;
+            }
+            if (c == '"' || c == '\\') {
+                id[pos++] = '\\';
+            }
+            id[pos++] = (char)c;
+        }
+    }
+    id[pos] = '\0';
+
+    int written = snprintf(buf, len,
+        "{\"sensor_id\":\"%s\",\"start\":%llu,\"end\":%llu,\"count\":%llu,"
+        "\"sum\":%.10g,\"min\":%.10g,\"max\":%.10g,\"mean\":%.10g,\"last\":%.10g,"
+        "\"p50\":%.10g,\"p90\":%.10g,\"p99\":%.10g}",
+        id,
+        (unsigned long long)aggregate->window_start,
+        (unsigned long long)aggregate->window_end,
+        (unsigned long long)aggregate->count,
+        aggregate->sum, aggregate->min, aggregate->max, aggregate->mean,
+        aggregate->last, aggregate->p50, aggregate->p90, aggregate->p99);
+
+    if (written < 0 || (size_t)written >= len) {
+        return -1;
+    }
+    return written;
+}
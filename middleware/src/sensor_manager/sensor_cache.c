@@ -0,0 +1,585 @@
+/**
+ * @file sensor_cache.c
+ * @brief Seqlock-protected last-value cache with CLOCK eviction
+ * @details Readers walk a bucket chain and copy a slot between two reads of
+ *          its sequence counter; they never write shared state except the
+ *          CLOCK reference bit. Updates to an existing key lock only that
+ *          slot. Inserts, removals and evictions serialize on one mutex.
+ */
+
+#include "sensor_manager/sensor_cache.h"
+#include "sensor_manager_internal.h"
+#include "time_utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define CACHE_SLOT_NIL UINT32_MAX
+
+/* Bounded reader retries before reporting a miss */
+#define CACHE_READ_RETRIES 64
+
+/**
+ * @brief Cache slot
+ * @details Everything after `seq` is written only while the sequence is
+ *          odd. `next` and `in_use` are additionally owned by the mutex.
+ */
+typedef struct {
+    atomic_uint seq;                /* Sequence lock (odd = write in progress) */
+    atomic_uint next;               /* Next slot in bucket chain */
+    atomic_uchar referenced;        /* CLOCK reference bit */
+    bool in_use;                    /* Slot holds a live entry */
+    uint32_t hash;                  /* Hash of sensor_id */
+    size_t id_len;                  /* Length of sensor_id */
+    size_t topic_len;               /* Length of topic */
+    size_t charge;                  /* Bytes charged to the budget */
+    uint64_t stored_at_ms;          /* Monotonic insert/update time */
+    sensor_cache_value_t value;     /* Cached value */
+} cache_slot_t;
+
+struct sensor_cache {
+    cache_slot_t *slots;            /* Slot array */
+    size_t num_slots;               /* Number of slots */
+    atomic_uint *buckets;           /* Bucket heads (slot index or NIL) */
+    size_t bucket_mask;             /* Bucket count - 1 (power of 2) */
+
+    size_t max_bytes;               /* Byte budget (0 = unlimited) */
+    atomic_uint ttl_ms;             /* Entry TTL (0 = no expiry), adjustable */
+
+    pthread_mutex_t lock;           /* Serializes insert/remove/evict */
+    uint32_t *free_slots;           /* Stack of unused slot indices */
+    size_t free_count;              /* Number of unused slots */
+    size_t clock_hand;              /* CLOCK sweep position */
+
+    atomic_size_t count;            /* Live entries */
+    atomic_size_t memory_usage;     /* Charged bytes */
+};
+
+/* Result of reading one slot */
+typedef enum {
+    SLOT_READ_MISMATCH = 0,
+    SLOT_READ_MATCH = 1,
+    SLOT_READ_BUSY = 2
+} slot_read_t;
+
+/* ============================================================================
+ * SEQUENCE LOCK
+ * ========================================================================= */
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * @brief Acquire a slot for writing (spins only against other writers)
+ */
+static void slot_write_lock(cache_slot_t *slot) {
+    for (;;) {
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+        if (!(seq & 1) &&
+            atomic_compare_exchange_weak_explicit(&slot->seq, &seq, seq + 1,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            /* Order the odd sequence before any data store */
+            atomic_thread_fence(memory_order_release);
+            return;
+        }
+        cpu_relax();
+    }
+}
+
+static void slot_write_unlock(cache_slot_t *slot) {
+    atomic_fetch_add_explicit(&slot->seq, 1, memory_order_release);
+}
+
+/**
+ * @brief Read a slot if it holds the requested key
+ * @param value Copy destination (may be NULL to only test the key)
+ * @param stored_at Insert time output (valid on match)
+ * @param next Chain successor observed in the same read
+ */
+static slot_read_t slot_read(cache_slot_t *slot, const char *key, size_t key_len,
+                             uint32_t hash, sensor_cache_value_t *value,
+                             uint64_t *stored_at, uint32_t *next) {
+    unsigned before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    if (before & 1) {
+        return SLOT_READ_BUSY;
+    }
+
+    bool match = slot->in_use && slot->hash == hash && slot->id_len == key_len &&
+                 memcmp(slot->value.sensor_id, key, key_len) == 0;
+    *next = atomic_load_explicit(&slot->next, memory_order_relaxed);
+
+    if (match) {
+        *stored_at = slot->stored_at_ms;
+        if (value) {
+            size_t topic_len = slot->topic_len;
+            size_t payload_len = slot->value.payload_len;
+
+            /* Lengths may be torn; clamp before copying */
+            if (topic_len >= SENSOR_CACHE_MAX_TOPIC) {
+                topic_len = SENSOR_CACHE_MAX_TOPIC - 1;
+            }
+            if (payload_len > SENSOR_CACHE_MAX_PAYLOAD) {
+                payload_len = SENSOR_CACHE_MAX_PAYLOAD;
+            }
+
+            memcpy(value->sensor_id, key, key_len);
+            value->sensor_id[key_len] = '\0';
+            memcpy(value->topic, slot->value.topic, topic_len);
+            value->topic[topic_len] = '\0';
+            memcpy(value->payload, slot->value.payload, payload_len);
+            value->payload_len = payload_len;
+            value->format = slot->value.format;
+            value->timestamp = slot->value.timestamp;
+            value->qos = slot->value.qos;
+        }
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    unsigned after = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    if (before != after) {
+        return SLOT_READ_BUSY;
+    }
+
+    return match ? SLOT_READ_MATCH : SLOT_READ_MISMATCH;
+}
+
+/* ============================================================================
+ * INTERNAL HELPERS
+ * ========================================================================= */
+
+static size_t next_power_of_two(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+/**
+ * @brief Walk a bucket chain without locking
+ * @return Slot index holding the key, or CACHE_SLOT_NIL
+ */
+static uint32_t cache_find(sensor_cache_t *cache, const char *key, size_t key_len,
+                           uint32_t hash, sensor_cache_value_t *value,
+                           uint64_t *stored_at) {
+    uint32_t idx = atomic_load_explicit(&cache->buckets[hash & cache->bucket_mask],
+                                        memory_order_acquire);
+    size_t steps = 0;
+    int retries = 0;
+
+    /* Bounded walk: a slot recycled mid-walk can move us to another chain */
+    while (idx != CACHE_SLOT_NIL && steps < cache->num_slots) {
+        uint32_t next = CACHE_SLOT_NIL;
+        slot_read_t r = slot_read(&cache->slots[idx], key, key_len, hash,
+                                  value, stored_at, &next);
+
+        if (r == SLOT_READ_BUSY) {
+            if (++retries > CACHE_READ_RETRIES) {
+                return CACHE_SLOT_NIL;
+            }
+            cpu_relax();
+            continue;
+        }
+
+        if (r == SLOT_READ_MATCH) {
+            return idx;
+        }
+
+        idx = next;
+        steps++;
+    }
+
+    return CACHE_SLOT_NIL;
+}
+
+/**
+ * @brief Walk a bucket chain while holding the mutex
+ * @details Chain links, `in_use`, `hash` and the key only change under the
+ *          mutex, so no sequence check is needed here.
+ */
+static uint32_t cache_find_locked(sensor_cache_t *cache, const char *key,
+                                  size_t key_len, uint32_t hash) {
+    uint32_t idx = atomic_load_explicit(&cache->buckets[hash & cache->bucket_mask],
+                                        memory_order_relaxed);
+
+    while (idx != CACHE_SLOT_NIL) {
+        const cache_slot_t *slot = &cache->slots[idx];
+        if (slot->in_use && slot->hash == hash && slot->id_len == key_len &&
+            memcmp(slot->value.sensor_id, key, key_len) == 0) {
+            return idx;
+        }
+        idx = atomic_load_explicit(&slot->next, memory_order_relaxed);
+    }
+
+    return CACHE_SLOT_NIL;
+}
+
+/**
+ * @brief Copy a reading into a locked slot (the key is set on insert only)
+ */
+static void slot_fill(cache_slot_t *slot, const sensor_data_t *data,
+                      size_t topic_len, uint64_t now_ms) {
+    if (topic_len > 0) {
+        memcpy(slot->value.topic, data->topic, topic_len);
+    }
+    slot->value.topic[topic_len] = '\0';
+    if (data->payload_len > 0) {
+        memcpy(slot->value.payload, data->payload, data->payload_len);
+    }
+    slot->value.payload_len = data->payload_len;
+    slot->value.format = data->format;
+    slot->value.timestamp = data->timestamp;
+    slot->value.qos = data->qos;
+    slot->topic_len = topic_len;
+    slot->stored_at_ms = now_ms;
+}
+
+static bool slot_expired(const sensor_cache_t *cache, const cache_slot_t *slot,
+                         uint64_t now_ms) {
+    unsigned ttl_ms = atomic_load_explicit(&((sensor_cache_t *)cache)->ttl_ms,
+                                           memory_order_relaxed);
+    return ttl_ms > 0 && now_ms - slot->stored_at_ms > ttl_ms;
+}
+
+/**
+ * @brief Unlink and release a slot (caller holds the mutex)
+ */
+static void cache_evict_slot(sensor_cache_t *cache, uint32_t idx) {
+    cache_slot_t *slot = &cache->slots[idx];
+    atomic_uint *link = &cache->buckets[slot->hash & cache->bucket_mask];
+
+    /* Unlink from the bucket chain; readers on this slot follow `next` */
+    uint32_t cur = atomic_load_explicit(link, memory_order_relaxed);
+    while (cur != CACHE_SLOT_NIL && cur != idx) {
+        link = &cache->slots[cur].next;
+        cur = atomic_load_explicit(link, memory_order_relaxed);
+    }
+    if (cur == idx) {
+        atomic_store_explicit(link,
+                              atomic_load_explicit(&slot->next, memory_order_relaxed),
+                              memory_order_release);
+    }
+
+    slot_write_lock(slot);
+    size_t charge = slot->charge;
+    slot->in_use = false;
+    slot->id_len = 0;
+    slot->hash = 0;
+    slot->charge = 0;
+    slot_write_unlock(slot);
+
+    atomic_fetch_sub_explicit(&cache->memory_usage, charge, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&cache->count, 1, memory_order_relaxed);
+    cache->free_slots[cache->free_count++] = idx;
+}
+
+/**
+ * @brief Advance the CLOCK hand and evict one entry (caller holds the mutex)
+ * @return true if an entry was evicted
+ */
+static bool cache_evict_one(sensor_cache_t *cache, uint64_t now_ms) {
+    /* Two sweeps: the first clears reference bits, the second must find a victim */
+    for (size_t scanned = 0; scanned < 2 * cache->num_slots; scanned++) {
+        uint32_t idx = (uint32_t)cache->clock_hand;
+        cache->clock_hand = (cache->clock_hand + 1) % cache->num_slots;
+
+        cache_slot_t *slot = &cache->slots[idx];
+        if (!slot->in_use) {
+            continue;
+        }
+
+        if (slot_expired(cache, slot, now_ms) ||
+            !atomic_exchange_explicit(&slot->referenced, 0, memory_order_relaxed)) {
+            cache_evict_slot(cache, idx);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Evict until `incoming` more bytes fit the budget (caller holds the mutex)
+ */
+static void cache_enforce_budget(sensor_cache_t *cache, size_t incoming, uint64_t now_ms) {
+    if (cache->max_bytes == 0) {
+        return;
+    }
+
+    while (atomic_load_explicit(&cache->memory_usage, memory_order_relaxed) + incoming >
+           cache->max_bytes) {
+        if (!cache_evict_one(cache, now_ms)) {
+            break;
+        }
+    }
+}
+
+/* ============================================================================
+ * SENSOR CACHE API
+ * ========================================================================= */
+
+sensor_cache_t *sensor_cache_create(size_t max_entries, size_t max_bytes,
+                                    uint32_t ttl_ms) {
+    if (max_entries == 0 || max_entries >= CACHE_SLOT_NIL) {
+        return NULL;
+    }
+
+    sensor_cache_t *cache = calloc(1, sizeof(sensor_cache_t));
+    if (!cache) {
+        return NULL;
+    }
+
+    size_t num_buckets = next_power_of_two(max_entries);
+
+    cache->slots = calloc(max_entries, sizeof(cache_slot_t));
+    cache->buckets = malloc(num_buckets * sizeof(atomic_uint));
+    cache->free_slots = malloc(max_entries * sizeof(uint32_t));
+    if (!cache->slots || !cache->buckets || !cache->free_slots) {
+        free(cache->slots);
+        free(cache->buckets);
+        free(cache->free_slots);
+        free(cache);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+        free(cache->slots);
+        free(cache->buckets);
+        free(cache->free_slots);
+        free(cache);
+        return NULL;
+    }
+
+    cache->num_slots = max_entries;
+    cache->bucket_mask = num_buckets - 1;
+    cache->max_bytes = max_bytes;
+    atomic_init(&cache->ttl_ms, ttl_ms);
+
+    for (size_t i = 0; i < num_buckets; i++) {
+        atomic_init(&cache->buckets[i], CACHE_SLOT_NIL);
+    }
+
+    /* Push in reverse so slot 0 is handed out first */
+    for (size_t i = 0; i < max_entries; i++) {
+        atomic_init(&cache->slots[i].seq, 0);
+        atomic_init(&cache->slots[i].next, CACHE_SLOT_NIL);
+        atomic_init(&cache->slots[i].referenced, 0);
+        cache->free_slots[i] = (uint32_t)(max_entries - 1 - i);
+    }
+    cache->free_count = max_entries;
+
+    atomic_init(&cache->count, 0);
+    atomic_init(&cache->memory_usage, 0);
+
+    return cache;
+}
+
+void sensor_cache_destroy(sensor_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->free_slots);
+    free(cache->buckets);
+    free(cache->slots);
+    free(cache);
+}
+
+paumiot_result_t sensor_cache_put(sensor_cache_t *cache, const sensor_data_t *data) {
+    if (!cache || !data || !data->sensor_id || (!data->payload && data->payload_len > 0)) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    size_t id_len;
+    uint32_t hash = sensor_id_hash(data->sensor_id, &id_len);
+    size_t topic_len = data->topic ? strlen(data->topic) : 0;
+
+    size_t charge = id_len + topic_len + data->payload_len;
+
+    if (id_len >= SENSOR_CACHE_MAX_ID || topic_len >= SENSOR_CACHE_MAX_TOPIC ||
+        data->payload_len > SENSOR_CACHE_MAX_PAYLOAD ||
+        (cache->max_bytes > 0 && charge > cache->max_bytes)) {
+        /* Never leave an older value behind for a reading we cannot hold */
+        sensor_cache_remove(cache, data->sensor_id);
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+
+    uint64_t now_ms = time_monotonic_ms();
+
+    /* Fast path: overwrite an existing entry under its slot lock only */
+    uint64_t stored_at;
+    uint32_t idx = cache_find(cache, data->sensor_id, id_len, hash, NULL, &stored_at);
+    if (idx != CACHE_SLOT_NIL) {
+        cache_slot_t *slot = &cache->slots[idx];
+        slot_write_lock(slot);
+
+        /* The slot may have been recycled between lookup and lock */
+        if (slot->in_use && slot->hash == hash && slot->id_len == id_len &&
+            memcmp(slot->value.sensor_id, data->sensor_id, id_len) == 0) {
+            size_t old_charge = slot->charge;
+            slot_fill(slot, data, topic_len, now_ms);
+            slot->charge = charge;
+            slot_write_unlock(slot);
+
+            atomic_store_explicit(&slot->referenced, 1, memory_order_relaxed);
+            if (charge != old_charge) {
+                atomic_fetch_add_explicit(&cache->memory_usage, charge, memory_order_relaxed);
+                atomic_fetch_sub_explicit(&cache->memory_usage, old_charge, memory_order_relaxed);
+                if (charge > old_charge && cache->max_bytes > 0 &&
+                    atomic_load_explicit(&cache->memory_usage, memory_order_relaxed) >
+                    cache->max_bytes) {
+                    pthread_mutex_lock(&cache->lock);
+                    cache_enforce_budget(cache, 0, now_ms);
+                    pthread_mutex_unlock(&cache->lock);
+                }
+            }
+            return PAUMIOT_SUCCESS;
+        }
+
+        slot_write_unlock(slot);
+    }
+
+    /* Slow path: insert under the mutex */
+    pthread_mutex_lock(&cache->lock);
+
+    idx = cache_find_locked(cache, data->sensor_id, id_len, hash);
+    if (idx != CACHE_SLOT_NIL) {
+        /* Lost a race with another inserter; evict and reinsert below */
+        cache_evict_slot(cache, idx);
+    }
+
+    cache_enforce_budget(cache, charge, now_ms);
+    if (cache->free_count == 0 && !cache_evict_one(cache, now_ms)) {
+        pthread_mutex_unlock(&cache->lock);
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    idx = cache->free_slots[--cache->free_count];
+    cache_slot_t *slot = &cache->slots[idx];
+    atomic_uint *head = &cache->buckets[hash & cache->bucket_mask];
+
+    slot_write_lock(slot);
+    memcpy(slot->value.sensor_id, data->sensor_id, id_len);
+    slot->value.sensor_id[id_len] = '\0';
+    slot->id_len = id_len;
+    slot_fill(slot, data, topic_len, now_ms);
+    slot->hash = hash;
+    slot->charge = charge;
+    slot->in_use = true;
+    atomic_store_explicit(&slot->next, atomic_load_explicit(head, memory_order_relaxed),
+                          memory_order_relaxed);
+    slot_write_unlock(slot);
+
+    atomic_store_explicit(&slot->referenced, 1, memory_order_relaxed);
+
+    /* Publish only after the slot is complete */
+    atomic_store_explicit(head, idx, memory_order_release);
+    atomic_fetch_add_explicit(&cache->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&cache->memory_usage, charge, memory_order_relaxed);
+
+    pthread_mutex_unlock(&cache->lock);
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_cache_get(sensor_cache_t *cache, const char *sensor_id,
+                                  sensor_cache_value_t *value) {
+    if (!cache || !sensor_id || !value) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    size_t id_len;
+    uint32_t hash = sensor_id_hash(sensor_id, &id_len);
+    if (id_len >= SENSOR_CACHE_MAX_ID) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+    }
+
+    uint64_t stored_at = 0;
+    uint32_t idx = cache_find(cache, sensor_id, id_len, hash, value, &stored_at);
+    if (idx == CACHE_SLOT_NIL) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+    }
+
+    unsigned ttl_ms = atomic_load_explicit(&cache->ttl_ms, memory_order_relaxed);
+    if (ttl_ms > 0 && time_monotonic_ms() - stored_at > ttl_ms) {
+        /* Expired entries stay until CLOCK reclaims them */
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+    }
+
+    /* Avoid dirtying the cache line when the bit is already set */
+    if (!atomic_load_explicit(&cache->slots[idx].referenced, memory_order_relaxed)) {
+        atomic_store_explicit(&cache->slots[idx].referenced, 1, memory_order_relaxed);
+    }
+
+    return PAUMIOT_SUCCESS;
+}
+
+void sensor_cache_remove(sensor_cache_t *cache, const char *sensor_id) {
+    if (!cache || !sensor_id) {
+        return;
+    }
+
+    size_t id_len;
+    uint32_t hash = sensor_id_hash(sensor_id, &id_len);
+    if (id_len >= SENSOR_CACHE_MAX_ID) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    uint32_t idx = cache_find_locked(cache, sensor_id, id_len, hash);
+    if (idx != CACHE_SLOT_NIL) {
+        cache_evict_slot(cache, idx);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void sensor_cache_clear(sensor_cache_t *cache) {
+    if (!cache) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    for (size_t i = 0; i < cache->num_slots; i++) {
+        if (cache->slots[i].in_use) {
+            cache_evict_slot(cache, (uint32_t)i);
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+size_t sensor_cache_count(const sensor_cache_t *cache) {
+    if (!cache) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&((sensor_cache_t *)cache)->count, memory_order_relaxed);
+}
+
+size_t sensor_cache_memory_usage(const sensor_cache_t *cache) {
+    if (!cache) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&((sensor_cache_t *)cache)->memory_usage,
+                                memory_order_relaxed);
+}
+
+void sensor_cache_set_ttl(sensor_cache_t *cache, uint32_t ttl_ms) {
+    if (!cache) {
+        return;
+    }
+
+    /* Applies to existing entries too: expiry is checked against the TTL on read */
+    atomic_store_explicit(&cache->ttl_ms, ttl_ms, memory_order_relaxed);
+}
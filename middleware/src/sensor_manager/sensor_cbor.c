@@ -0,0 +1,415 @@
+/**
+ * @file sensor_cbor.c
+ * @brief Streaming CBOR encoder and decoder
+ * @details Heads use the preferred (shortest) argument encoding. Floats are
+ *          narrowed to half or single precision only when the conversion is
+ *          exact, so decoding always returns the value that was written.
+ */
+
+#include "sensor_manager/sensor_cbor.h"
+#include <string.h>
+#include <math.h>
+
+/* Nesting tracked by cbor_reader_skip() */
+#define CBOR_SKIP_MAX_DEPTH 64
+
+/* Items remaining in an indefinite-length level */
+#define CBOR_UNTIL_BREAK UINT64_MAX
+
+/**
+ * @brief Encode a head with a fixed argument width into `out`
+ * @return Bytes written (1 + width)
+ */
+static size_t encode_head(uint8_t *out, uint8_t major, uint64_t value, size_t width) {
+    static const uint8_t info[9] = {0, 24, 25, 0, 26, 0, 0, 0, 27};
+
+    if (width == 0) {
+        out[0] = (uint8_t)((major << 5) | value);
+        return 1;
+    }
+
+    out[0] = (uint8_t)((major << 5) | info[width]);
+    for (size_t i = 0; i < width; i++) {
+        out[width - i] = (uint8_t)(value >> (8 * i));
+    }
+    return 1 + width;
+}
+
+/**
+ * @brief Preferred argument width for a value
+ */
+static size_t head_width(uint64_t value) {
+    if (value < 24) {
+        return 0;
+    }
+    if (value <= UINT8_MAX) {
+        return 1;
+    }
+    if (value <= UINT16_MAX) {
+        return 2;
+    }
+    if (value <= UINT32_MAX) {
+        return 4;
+    }
+    return 8;
+}
+
+static void write_head(cbor_writer_t *writer, uint8_t major, uint64_t value) {
+    uint8_t head[9];
+    cbor_write_raw(writer, head, encode_head(head, major, value, head_width(value)));
+}
+
+/**
+ * @brief Half-precision bits for a double, if the conversion is exact
+ */
+static bool double_to_half(double value, uint16_t *half) {
+    uint16_t sign = signbit(value) ? 0x8000 : 0;
+    double magnitude = fabs(value);
+
+    if (magnitude == 0.0) {
+        *half = sign;
+        return true;
+    }
+    if (isinf(value)) {
+        *half = sign | 0x7c00;
+        return true;
+    }
+
+    int exp;
+    double mant = frexp(magnitude, &exp);   /* magnitude = mant * 2^exp, mant in [0.5, 1) */
+
+    if (exp >= -13 && exp <= 16) {
+        /* Normal: 11 significant bits */
+        double scaled = ldexp(mant, 11);
+        if (scaled != floor(scaled)) {
+            return false;
+        }
+        *half = sign | (uint16_t)((exp + 14) << 10) | ((uint16_t)scaled & 0x3ff);
+        return true;
+    }
+
+    if (exp < -13 && exp >= -23) {
+        /* Subnormal: multiples of 2^-24 */
+        double scaled = ldexp(magnitude, 24);
+        if (scaled != floor(scaled)) {
+            return false;
+        }
+        *half = sign | (uint16_t)scaled;
+        return true;
+    }
+
+    return false;
+}
+
+static double half_to_double(uint16_t half) {
+    int exp = (half >> 10) & 0x1f;
+    int mant = half & 0x3ff;
+    double value;
+
+    if (exp == 0) {
+        value = ldexp(mant, -24);
+    } else if (exp == 31) {
+        value = mant ? NAN : INFINITY;
+    } else {
+        value = ldexp(mant + 1024, exp - 25);
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+/* ============================================================================
+ * CBOR WRITER API
+ * ========================================================================= */
+
+void cbor_writer_init(cbor_writer_t *writer, uint8_t *buf, size_t capacity) {
+    writer->buf = buf;
+    writer->capacity = buf ? capacity : 0;
+    writer->len = 0;
+    writer->overflow = false;
+}
+
+paumiot_result_t cbor_writer_result(const cbor_writer_t *writer) {
+    return writer->overflow ? (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL
+                            : PAUMIOT_SUCCESS;
+}
+
+void cbor_write_raw(cbor_writer_t *writer, const void *data, size_t len) {
+    /* After an overflow only the required length is tracked */
+    if (!writer->overflow && writer->capacity - writer->len >= len) {
+        if (len > 0) {
+            memcpy(writer->buf + writer->len, data, len);
+        }
+    } else {
+        writer->overflow = true;
+    }
+    writer->len += len;
+}
+
+void cbor_write_uint(cbor_writer_t *writer, uint64_t value) {
+    write_head(writer, CBOR_MAJOR_UINT, value);
+}
+
+void cbor_write_int(cbor_writer_t *writer, int64_t value) {
+    if (value >= 0) {
+        write_head(writer, CBOR_MAJOR_UINT, (uint64_t)value);
+    } else {
+        write_head(writer, CBOR_MAJOR_NEGINT, (uint64_t)(-(value + 1)));
+    }
+}
+
+void cbor_write_bytes(cbor_writer_t *writer, const uint8_t *data, size_t len) {
+    write_head(writer, CBOR_MAJOR_BYTES, len);
+    cbor_write_raw(writer, data, len);
+}
+
+void cbor_write_text(cbor_writer_t *writer, const char *text, size_t len) {
+    write_head(writer, CBOR_MAJOR_TEXT, len);
+    cbor_write_raw(writer, text, len);
+}
+
+void cbor_write_array(cbor_writer_t *writer, uint64_t count) {
+    write_head(writer, CBOR_MAJOR_ARRAY, count);
+}
+
+void cbor_write_map(cbor_writer_t *writer, uint64_t pairs) {
+    write_head(writer, CBOR_MAJOR_MAP, pairs);
+}
+
+void cbor_write_array_indefinite(cbor_writer_t *writer) {
+    uint8_t ib = (CBOR_MAJOR_ARRAY << 5) | 31;
+    cbor_write_raw(writer, &ib, 1);
+}
+
+void cbor_write_map_indefinite(cbor_writer_t *writer) {
+    uint8_t ib = (CBOR_MAJOR_MAP << 5) | 31;
+    cbor_write_raw(writer, &ib, 1);
+}
+
+void cbor_write_break(cbor_writer_t *writer) {
+    uint8_t ib = 0xff;
+    cbor_write_raw(writer, &ib, 1);
+}
+
+void cbor_write_tag(cbor_writer_t *writer, uint64_t tag) {
+    write_head(writer, CBOR_MAJOR_TAG, tag);
+}
+
+void cbor_write_bool(cbor_writer_t *writer, bool value) {
+    uint8_t ib = value ? 0xf5 : 0xf4;
+    cbor_write_raw(writer, &ib, 1);
+}
+
+void cbor_write_null(cbor_writer_t *writer) {
+    uint8_t ib = 0xf6;
+    cbor_write_raw(writer, &ib, 1);
+}
+
+void cbor_write_double(cbor_writer_t *writer, double value) {
+    uint8_t out[9];
+    uint16_t half;
+
+    if (isnan(value)) {
+        /* Canonical quiet NaN */
+        half = 0x7e00;
+        cbor_write_raw(writer, out, encode_head(out, CBOR_MAJOR_SIMPLE, half, 2));
+        return;
+    }
+
+    if (double_to_half(value, &half)) {
+        cbor_write_raw(writer, out, encode_head(out, CBOR_MAJOR_SIMPLE, half, 2));
+        return;
+    }
+
+    float single = (float)value;
+    if ((double)single == value) {
+        uint32_t bits;
+        memcpy(&bits, &single, sizeof(bits));
+        cbor_write_raw(writer, out, encode_head(out, CBOR_MAJOR_SIMPLE, bits, 4));
+        return;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    cbor_write_raw(writer, out, encode_head(out, CBOR_MAJOR_SIMPLE, bits, 8));
+}
+
+void cbor_write_head_fixed(cbor_writer_t *writer, uint8_t major, uint64_t value, size_t width) {
+    uint8_t head[9];
+    cbor_write_raw(writer, head, encode_head(head, major & 7, value, width));
+}
+
+size_t cbor_head_size(uint64_t value) {
+    return 1 + head_width(value);
+}
+
+/* ============================================================================
+ * CBOR READER API
+ * ========================================================================= */
+
+void cbor_reader_init(cbor_reader_t *reader, const uint8_t *buf, size_t len) {
+    reader->buf = buf;
+    reader->len = buf ? len : 0;
+    reader->pos = 0;
+}
+
+paumiot_result_t cbor_reader_next(cbor_reader_t *reader, cbor_item_t *item) {
+    if (reader->pos >= reader->len) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NO_DATA;
+    }
+
+    uint8_t ib = reader->buf[reader->pos++];
+    uint8_t major = ib >> 5;
+    uint8_t info = ib & 0x1f;
+    uint64_t value = info;
+
+    memset(item, 0, sizeof(*item));
+
+    if (info >= 24 && info <= 27) {
+        size_t width = (size_t)1 << (info - 24);
+        if (reader->len - reader->pos < width) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        value = 0;
+        for (size_t i = 0; i < width; i++) {
+            value = (value << 8) | reader->buf[reader->pos++];
+        }
+    } else if (info == 31) {
+        if (major < CBOR_MAJOR_BYTES || major == CBOR_MAJOR_TAG) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        item->indefinite = major != CBOR_MAJOR_SIMPLE;
+    } else if (info > 27) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+    }
+
+    item->value = value;
+
+    switch (major) {
+        case CBOR_MAJOR_UINT:
+            item->type = CBOR_TYPE_UINT;
+            break;
+        case CBOR_MAJOR_NEGINT:
+            item->type = CBOR_TYPE_NEGINT;
+            break;
+        case CBOR_MAJOR_BYTES:
+        case CBOR_MAJOR_TEXT:
+            item->type = major == CBOR_MAJOR_BYTES ? CBOR_TYPE_BYTES : CBOR_TYPE_TEXT;
+            if (!item->indefinite) {
+                if (value > reader->len - reader->pos) {
+                    return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                }
+                item->data = reader->buf + reader->pos;
+                reader->pos += (size_t)value;
+            }
+            break;
+        case CBOR_MAJOR_ARRAY:
+            item->type = CBOR_TYPE_ARRAY;
+            break;
+        case CBOR_MAJOR_MAP:
+            item->type = CBOR_TYPE_MAP;
+            break;
+        case CBOR_MAJOR_TAG:
+            item->type = CBOR_TYPE_TAG;
+            break;
+        default:
+            switch (info) {
+                case 20: item->type = CBOR_TYPE_FALSE; break;
+                case 21: item->type = CBOR_TYPE_TRUE; break;
+                case 22: item->type = CBOR_TYPE_NULL; break;
+                case 23: item->type = CBOR_TYPE_UNDEFINED; break;
+                case 24:
+                    /* Two-byte encodings of simple values below 32 are not well-formed */
+                    if (value < 32) {
+                        return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                    }
+                    item->type = CBOR_TYPE_SIMPLE;
+                    break;
+                case 25:
+                    item->type = CBOR_TYPE_FLOAT;
+                    item->number = half_to_double((uint16_t)value);
+                    break;
+                case 26: {
+                    uint32_t bits = (uint32_t)value;
+                    float single;
+                    memcpy(&single, &bits, sizeof(single));
+                    item->type = CBOR_TYPE_FLOAT;
+                    item->number = single;
+                    break;
+                }
+                case 27:
+                    item->type = CBOR_TYPE_FLOAT;
+                    memcpy(&item->number, &value, sizeof(item->number));
+                    break;
+                case 31:
+                    item->type = CBOR_TYPE_BREAK;
+                    break;
+                default:
+                    item->type = CBOR_TYPE_SIMPLE;
+                    break;
+            }
+            break;
+    }
+
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t cbor_reader_skip(cbor_reader_t *reader, const cbor_item_t *item) {
+    uint64_t pending[CBOR_SKIP_MAX_DEPTH];     /* Items left per open level */
+    size_t depth = 0;
+    cbor_item_t current = *item;
+
+    for (;;) {
+        bool complete = true;
+        uint64_t children = 0;
+
+        switch (current.type) {
+            case CBOR_TYPE_BREAK:
+                if (depth == 0 || pending[depth - 1] != CBOR_UNTIL_BREAK) {
+                    return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                }
+                depth--;
+                break;
+            case CBOR_TYPE_BYTES:
+            case CBOR_TYPE_TEXT:
+                children = current.indefinite ? CBOR_UNTIL_BREAK : 0;
+                break;
+            case CBOR_TYPE_ARRAY:
+                children = current.indefinite ? CBOR_UNTIL_BREAK : current.value;
+                break;
+            case CBOR_TYPE_MAP:
+                if (!current.indefinite && current.value > UINT64_MAX / 2 - 1) {
+                    return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                }
+                children = current.indefinite ? CBOR_UNTIL_BREAK : current.value * 2;
+                break;
+            case CBOR_TYPE_TAG:
+                children = 1;
+                break;
+            default:
+                break;
+        }
+
+        if (children > 0) {
+            if (depth == CBOR_SKIP_MAX_DEPTH) {
+                return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+            }
+            pending[depth++] = children;
+            complete = false;
+        }
+
+        /* A finished item may finish its enclosing definite-length levels */
+        while (complete) {
+            if (depth == 0) {
+                return PAUMIOT_SUCCESS;
+            }
+            if (pending[depth - 1] == CBOR_UNTIL_BREAK || --pending[depth - 1] > 0) {
+                break;
+            }
+            depth--;
+        }
+
+        paumiot_result_t result = cbor_reader_next(reader, &current);
+        if (result != PAUMIOT_SUCCESS) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+    }
+}
@@ -0,0 +1,1102 @@
+/**
+ * @file sensor_codec.c
+ * @brief JSON <-> CBOR transcoding and format routes
+ * @details Both transcoders stream straight into the caller's buffer. The
+ *          JSON side finds string ends, escapes and whitespace runs 16 bytes
+ *          at a time with SSE2 or NEON (baseline on x86-64 and AArch64);
+ *          sensor documents are mostly short keys and numbers, so wider
+ *          vectors would rarely fill. Container lengths are unknown until a
+ *          container closes, so a one-byte head is reserved and widened in
+ *          place when a map or array reaches 24 entries.
+ */
+
+#include "sensor_manager/sensor_codec.h"
+#include "sensor_manager/sensor_cbor.h"
+#include "sensor_manager_internal.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* Longest JSON number converted through strtod */
+#define NUMBER_MAX_LEN 128
+
+/* Items remaining in an indefinite-length CBOR level */
+#define ITEMS_UNTIL_BREAK UINT64_MAX
+
+/* Open JSON container while converting to CBOR */
+typedef struct {
+    size_t head;                    /* Offset of its one-byte head placeholder */
+    uint64_t count;                 /* Items (array) or pairs (map) so far */
+    bool is_map;
+} json_frame_t;
+
+/* Open CBOR container while converting to JSON */
+typedef struct {
+    uint64_t remaining;             /* Items left (ITEMS_UNTIL_BREAK if indefinite) */
+    uint64_t index;                 /* Items emitted */
+    bool is_map;
+} cbor_frame_t;
+
+/* Format Route */
+typedef struct {
+    char *filter;
+    sensor_codec_route_t target;
+} codec_route_t;
+
+struct sensor_codec_routes {
+    codec_route_t *routes;
+    size_t count;
+    size_t capacity;
+};
+
+/* ============================================================================
+ * SCANNING
+ * ========================================================================= */
+
+static bool is_json_ws(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * @brief Bytes before the first '"', '\\' or control character
+ * @details Finds the end of a JSON string, and the bytes that need escaping
+ *          when writing one.
+ */
+static size_t string_run(const uint8_t *p, size_t len) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i stop = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                                 _mm_cmpeq_epi8(v, backslash)),
+                                    _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        unsigned mask = (unsigned)_mm_movemask_epi8(stop);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x1f);
+
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8(p + i);
+        uint8x16_t stop = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                                   vcleq_u8(v, control));
+        /* Narrow to 4 bits per byte to get a scalar mask */
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(stop), 4)), 0);
+        if (mask) {
+            return i + (size_t)(__builtin_ctzll(mask) >> 2);
+        }
+    }
+#endif
+
+    for (; i < len; i++) {
+        uint8_t c = p[i];
+        if (c == '"' || c == '\\' || c < 0x20) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * @brief Position of the first non-whitespace byte at or after `pos`
+ */
+static size_t skip_ws(const uint8_t *p, size_t pos, size_t len) {
+    /* Compact documents have no whitespace at all */
+    if (pos >= len || !is_json_ws(p[pos])) {
+        return pos;
+    }
+
+#if defined(__SSE2__)
+    for (; pos + 16 <= len; pos += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + pos));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                               _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                                               _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(ws) & 0xffffu;
+        if (mask) {
+            return pos + (size_t)__builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    for (; pos + 16 <= len; pos += 16) {
+        uint8x16_t v = vld1q_u8(p + pos);
+        uint8x16_t ws = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')),
+                                          vceqq_u8(v, vdupq_n_u8('\n'))),
+                                 vorrq_u8(vceqq_u8(v, vdupq_n_u8('\r')),
+                                          vceqq_u8(v, vdupq_n_u8('\t'))));
+        uint64_t mask = ~vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(ws), 4)), 0);
+        if (mask) {
+            return pos + (size_t)(__builtin_ctzll(mask) >> 2);
+        }
+    }
+#endif
+
+    while (pos < len && is_json_ws(p[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+/* ============================================================================
+ * JSON TO CBOR
+ * ========================================================================= */
+
+static void write_head(cbor_writer_t *writer, uint8_t major, uint64_t value) {
+    cbor_write_head_fixed(writer, major, value, cbor_head_size(value) - 1);
+}
+
+/**
+ * @brief Rewrite a head written with `reserved` bytes, resizing it to fit `value`
+ */
+static void patch_head(cbor_writer_t *writer, size_t pos, size_t reserved,
+                       uint8_t major, uint64_t value) {
+    size_t needed = cbor_head_size(value);
+    size_t body = pos + reserved;
+
+    if (needed > reserved) {
+        size_t grow = needed - reserved;
+        if (writer->overflow || writer->capacity - writer->len < grow) {
+            writer->overflow = true;
+            writer->len += grow;
+            return;
+        }
+        memmove(writer->buf + pos + needed, writer->buf + body, writer->len - body);
+        writer->len += grow;
+    } else if (needed < reserved) {
+        if (!writer->overflow) {
+            memmove(writer->buf + pos + needed, writer->buf + body, writer->len - body);
+        }
+        writer->len -= reserved - needed;
+    }
+
+    if (!writer->overflow) {
+        cbor_writer_t head;
+        cbor_writer_init(&head, writer->buf + pos, needed);
+        write_head(&head, major, value);
+    }
+}
+
+static int hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Parse the four hex digits of a \\u escape
+ */
+static bool parse_hex4(const uint8_t *p, uint32_t *value) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_value(p[i]);
+        if (digit < 0) {
+            return false;
+        }
+        v = (v << 4) | (uint32_t)digit;
+    }
+    *value = v;
+    return true;
+}
+
+static void write_utf8(cbor_writer_t *writer, uint32_t cp) {
+    uint8_t out[4];
+    size_t n;
+
+    if (cp < 0x80) {
+        out[0] = (uint8_t)cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        out[0] = (uint8_t)(0xc0 | (cp >> 6));
+        out[1] = (uint8_t)(0x80 | (cp & 0x3f));
+        n = 2;
+    } else if (cp < 0x10000) {
+        out[0] = (uint8_t)(0xe0 | (cp >> 12));
+        out[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+        out[2] = (uint8_t)(0x80 | (cp & 0x3f));
+        n = 3;
+    } else {
+        out[0] = (uint8_t)(0xf0 | (cp >> 18));
+        out[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3f));
+        out[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+        out[3] = (uint8_t)(0x80 | (cp & 0x3f));
+        n = 4;
+    }
+    cbor_write_raw(writer, out, n);
+}
+
+/**
+ * @brief Decode the escapes of a string body into the writer
+ * @param p String body (between the quotes)
+ * @param len Body length
+ */
+static paumiot_result_t json_unescape(cbor_writer_t *writer, const uint8_t *p, size_t len) {
+    size_t i = 0;
+
+    while (i < len) {
+        size_t run = string_run(p + i, len - i);
+        cbor_write_raw(writer, p + i, run);
+        i += run;
+        if (i == len) {
+            break;
+        }
+
+        /* Only escapes remain: the body ends before the closing quote */
+        if (p[i] != '\\' || i + 1 >= len) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+
+        uint8_t escape = p[i + 1];
+        uint8_t byte;
+        i += 2;
+
+        switch (escape) {
+            case '"':  byte = '"'; break;
+            case '\\': byte = '\\'; break;
+            case '/':  byte = '/'; break;
+            case 'b':  byte = '\b'; break;
+            case 'f':  byte = '\f'; break;
+            case 'n':  byte = '\n'; break;
+            case 'r':  byte = '\r'; break;
+            case 't':  byte = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (len - i < 4 || !parse_hex4(p + i, &cp)) {
+                    return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                }
+                i += 4;
+
+                if (cp >= 0xdc00 && cp <= 0xdfff) {
+                    return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                }
+                if (cp >= 0xd800 && cp <= 0xdbff) {
+                    /* Characters outside the BMP come as a surrogate pair */
+                    uint32_t low;
+                    if (len - i < 6 || p[i] != '\\' || p[i + 1] != 'u' ||
+                        !parse_hex4(p + i + 2, &low) || low < 0xdc00 || low > 0xdfff) {
+                        return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                    }
+                    i += 6;
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                }
+                write_utf8(writer, cp);
+                continue;
+            }
+            default:
+                return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        cbor_write_raw(writer, &byte, 1);
+    }
+
+    return PAUMIOT_SUCCESS;
+}
+
+/**
+ * @brief Convert a JSON string whose opening quote precedes `*pos`
+ */
+static paumiot_result_t json_string(cbor_writer_t *writer, const uint8_t *p, size_t len,
+                                    size_t *pos) {
+    size_t start = *pos;
+    size_t end = start + string_run(p + start, len - start);
+
+    /* Fast path: no escapes, copied verbatim */
+    if (end < len && p[end] == '"') {
+        cbor_write_text(writer, (const char *)p + start, end - start);
+        *pos = end + 1;
+        return PAUMIOT_SUCCESS;
+    }
+
+    /* Find the closing quote, stepping over escaped characters */
+    while (end < len && p[end] == '\\') {
+        end += 2;
+        if (end < len) {
+            end += string_run(p + end, len - end);
+        }
+    }
+    if (end >= len || p[end] != '"') {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+    }
+
+    /* Decoded text is never longer than the escaped form */
+    size_t raw = end - start;
+    size_t reserved = cbor_head_size(raw);
+    size_t head = writer->len;
+    cbor_write_head_fixed(writer, CBOR_MAJOR_TEXT, raw, reserved - 1);
+
+    size_t body = writer->len;
+    paumiot_result_t result = json_unescape(writer, p + start, raw);
+    if (result != PAUMIOT_SUCCESS) {
+        return result;
+    }
+
+    patch_head(writer, head, reserved, CBOR_MAJOR_TEXT, writer->len - body);
+    *pos = end + 1;
+    return PAUMIOT_SUCCESS;
+}
+
+static bool is_digit(const uint8_t *p, size_t pos, size_t len) {
+    return pos < len && p[pos] >= '0' && p[pos] <= '9';
+}
+
+/**
+ * @brief Convert a JSON number at `*pos`
+ * @details Integers that fit in 64 bits become CBOR integers; everything
+ *          else is parsed as a double.
+ */
+static paumiot_result_t json_number(cbor_writer_t *writer, const uint8_t *p, size_t len,
+                                    size_t *pos) {
+    size_t i = *pos;
+    bool negative = p[i] == '-';
+    bool integral = true;
+
+    if (negative) {
+        i++;
+    }
+
+    size_t digits = i;
+    if (!is_digit(p, i, len)) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+    }
+    if (p[i] == '0') {
+        i++;
+    } else {
+        while (is_digit(p, i, len)) {
+            i++;
+        }
+    }
+    size_t digits_end = i;
+
+    if (i < len && p[i] == '.') {
+        integral = false;
+        i++;
+        if (!is_digit(p, i, len)) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        while (is_digit(p, i, len)) {
+            i++;
+        }
+    }
+    if (i < len && (p[i] == 'e' || p[i] == 'E')) {
+        integral = false;
+        i++;
+        if (i < len && (p[i] == '+' || p[i] == '-')) {
+            i++;
+        }
+        if (!is_digit(p, i, len)) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        while (is_digit(p, i, len)) {
+            i++;
+        }
+    }
+
+    if (integral) {
+        uint64_t magnitude = 0;
+        bool fits = true;
+
+        for (size_t k = digits; k < digits_end; k++) {
+            uint64_t digit = (uint64_t)(p[k] - '0');
+            if (magnitude > (UINT64_MAX - digit) / 10) {
+                fits = false;
+                break;
+            }
+            magnitude = magnitude * 10 + digit;
+        }
+
+        /* -2^64 is the most negative CBOR integer */
+        static const char min_negint[] = "18446744073709551616";
+        if (!fits && negative && digits_end - digits == sizeof(min_negint) - 1 &&
+            memcmp(p + digits, min_negint, sizeof(min_negint) - 1) == 0) {
+            write_head(writer, CBOR_MAJOR_NEGINT, UINT64_MAX);
+            *pos = i;
+            return PAUMIOT_SUCCESS;
+        }
+
+        /* "-0" keeps its sign as a float */
+        if (fits && !(negative && magnitude == 0)) {
+            if (negative) {
+                write_head(writer, CBOR_MAJOR_NEGINT, magnitude - 1);
+            } else {
+                write_head(writer, CBOR_MAJOR_UINT, magnitude);
+            }
+            *pos = i;
+            return PAUMIOT_SUCCESS;
+        }
+    }
+
+    char text[NUMBER_MAX_LEN + 1];
+    size_t n = i - *pos;
+    if (n > NUMBER_MAX_LEN) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+    memcpy(text, p + *pos, n);
+    text[n] = '\0';
+
+    cbor_write_double(writer, strtod(text, NULL));
+    *pos = i;
+    return PAUMIOT_SUCCESS;
+}
+
+static bool json_literal(const uint8_t *p, size_t len, size_t *pos, const char *literal) {
+    size_t n = strlen(literal);
+    if (len - *pos < n || memcmp(p + *pos, literal, n) != 0) {
+        return false;
+    }
+    *pos += n;
+    return true;
+}
+
+/* ============================================================================
+ * CBOR TO JSON
+ * ========================================================================= */
+
+static void put_char(cbor_writer_t *writer, char c) {
+    cbor_write_raw(writer, &c, 1);
+}
+
+static void put_str(cbor_writer_t *writer, const char *s) {
+    cbor_write_raw(writer, s, strlen(s));
+}
+
+/**
+ * @brief Write string contents with JSON escaping (no quotes)
+ */
+static void put_escaped(cbor_writer_t *writer, const uint8_t *s, size_t len) {
+    size_t i = 0;
+
+    while (i < len) {
+        size_t run = string_run(s + i, len - i);
+        cbor_write_raw(writer, s + i, run);
+        i += run;
+        if (i == len) {
+            break;
+        }
+
+        uint8_t c = s[i++];
+        char escape[8];
+        switch (c) {
+            case '"':  put_str(writer, "\\\""); break;
+            case '\\': put_str(writer, "\\\\"); break;
+            case '\b': put_str(writer, "\\b"); break;
+            case '\f': put_str(writer, "\\f"); break;
+            case '\n': put_str(writer, "\\n"); break;
+            case '\r': put_str(writer, "\\r"); break;
+            case '\t': put_str(writer, "\\t"); break;
+            default:
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                put_str(writer, escape);
+                break;
+        }
+    }
+}
+
+/* base64url without padding, carried across byte string chunks */
+typedef struct {
+    uint8_t pending[3];
+    size_t count;
+} base64_state_t;
+
+static const char BASE64URL[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static void base64_flush(cbor_writer_t *writer, base64_state_t *state) {
+    if (state->count == 0) {
+        return;
+    }
+
+    uint32_t bits = (uint32_t)state->pending[0] << 16;
+    if (state->count > 1) {
+        bits |= (uint32_t)state->pending[1] << 8;
+    }
+    if (state->count > 2) {
+        bits |= state->pending[2];
+    }
+
+    char out[4];
+    for (size_t i = 0; i < 4; i++) {
+        out[i] = BASE64URL[(bits >> (18 - 6 * i)) & 0x3f];
+    }
+    cbor_write_raw(writer, out, state->count + 1);
+    state->count = 0;
+}
+
+static void base64_put(cbor_writer_t *writer, base64_state_t *state,
+                       const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        state->pending[state->count++] = data[i];
+        if (state->count == 3) {
+            base64_flush(writer, state);
+        }
+    }
+}
+
+/**
+ * @brief Write a CBOR string item (both kinds, any length form) as a JSON string
+ */
+static paumiot_result_t put_string(cbor_writer_t *writer, cbor_reader_t *reader,
+                                   const cbor_item_t *item) {
+    base64_state_t base64 = {{0}, 0};
+    bool bytes = item->type == CBOR_TYPE_BYTES;
+
+    put_char(writer, '"');
+
+    if (!item->indefinite) {
+        if (bytes) {
+            base64_put(writer, &base64, item->data, (size_t)item->value);
+        } else {
+            put_escaped(writer, item->data, (size_t)item->value);
+        }
+    } else {
+        cbor_item_t chunk;
+        for (;;) {
+            if (cbor_reader_next(reader, &chunk) != PAUMIOT_SUCCESS) {
+                return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+            }
+            if (chunk.type == CBOR_TYPE_BREAK) {
+                break;
+            }
+            if (chunk.type != item->type || chunk.indefinite) {
+                return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+            }
+            if (bytes) {
+                base64_put(writer, &base64, chunk.data, (size_t)chunk.value);
+            } else {
+                put_escaped(writer, chunk.data, (size_t)chunk.value);
+            }
+        }
+    }
+
+    base64_flush(writer, &base64);
+    put_char(writer, '"');
+    return PAUMIOT_SUCCESS;
+}
+
+/**
+ * @brief Format `value` in decimal, ending just before `end`
+ * @return Start of the digits
+ */
+static char *format_u64(char *end, uint64_t value) {
+    do {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return end;
+}
+
+static void put_integer(cbor_writer_t *writer, const cbor_item_t *item) {
+    char text[24];
+    char *end = text + sizeof(text);
+    char *start;
+
+    if (item->type == CBOR_TYPE_UINT) {
+        start = format_u64(end, item->value);
+    } else if (item->value == UINT64_MAX) {
+        /* -2^64 does not fit in a uint64_t */
+        put_str(writer, "-18446744073709551616");
+        return;
+    } else {
+        start = format_u64(end, item->value + 1);
+        *--start = '-';
+    }
+    cbor_write_raw(writer, start, (size_t)(end - start));
+}
+
+/**
+ * @brief Write a float with at most 6 decimals without going through libc
+ * @details Most sensor values are short decimals. m / 10^k is correctly
+ *          rounded, as is reading the printed "m.k" back, so the check below
+ *          proves the text round-trips.
+ * @return true if written
+ */
+static bool put_short_decimal(cbor_writer_t *writer, double value) {
+    static const double scale[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+    double magnitude = fabs(value);
+
+    if (!(magnitude < 1e9) || (magnitude == 0.0 && signbit(value))) {
+        return false;
+    }
+
+    for (int k = 0; k < (int)(sizeof(scale) / sizeof(scale[0])); k++) {
+        double scaled = magnitude * scale[k];
+        uint64_t m = (uint64_t)(scaled + 0.5);
+        if ((double)m / scale[k] != magnitude) {
+            continue;
+        }
+
+        char text[32];
+        char *end = text + sizeof(text);
+        char *start = end;
+
+        if (k == 0) {
+            /* Keep it a float when read back */
+            *--start = '0';
+            *--start = '.';
+        }
+        for (int d = 0; d < k; d++) {
+            *--start = (char)('0' + m % 10);
+            m /= 10;
+        }
+        if (k > 0) {
+            *--start = '.';
+        }
+        start = format_u64(start, m);
+        if (value < 0) {
+            *--start = '-';
+        }
+        cbor_write_raw(writer, start, (size_t)(end - start));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Write a float with the fewest digits that read back exactly
+ */
+static void put_double(cbor_writer_t *writer, double value) {
+    if (!isfinite(value)) {
+        put_str(writer, "null");
+        return;
+    }
+    if (put_short_decimal(writer, value)) {
+        return;
+    }
+
+    /*
+     * Any decimal of up to DBL_DIG (15) digits survives a round trip, so %.15g
+     * (which drops trailing zeros) already prints the shortest form when one
+     * that short exists. Only the rest need 16 or 17 digits.
+     */
+    char text[32];
+    int n = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        n = snprintf(text, sizeof(text), "%.*g", precision, value);
+        if (strtod(text, NULL) == value) {
+            break;
+        }
+    }
+
+    /* Keep it a float when read back */
+    if (!strpbrk(text, ".e") && n + 2 < (int)sizeof(text)) {
+        memcpy(text + n, ".0", 3);
+    }
+    put_str(writer, text);
+}
+
+/* ============================================================================
+ * SENSOR CODEC API
+ * ========================================================================= */
+
+paumiot_result_t sensor_codec_json_to_cbor(const char *json, size_t len,
+                                           uint8_t *out, size_t capacity, size_t *out_len) {
+    if (!json || !out_len) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    enum { EXPECT_VALUE, EXPECT_KEY, AFTER_VALUE } state = EXPECT_VALUE;
+    const uint8_t *p = (const uint8_t *)json;
+    json_frame_t stack[SENSOR_CODEC_MAX_DEPTH];
+    size_t depth = 0;
+    size_t pos = 0;
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+    cbor_writer_t writer;
+
+    cbor_writer_init(&writer, out, capacity);
+
+    while (result == PAUMIOT_SUCCESS) {
+        pos = skip_ws(p, pos, len);
+
+        if (state == AFTER_VALUE) {
+            if (depth == 0) {
+                break;
+            }
+
+            json_frame_t *top = &stack[depth - 1];
+            top->count++;
+
+            if (pos >= len) {
+                result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+            } else if (p[pos] == ',') {
+                state = top->is_map ? EXPECT_KEY : EXPECT_VALUE;
+                pos++;
+            } else if (p[pos] == (top->is_map ? '}' : ']')) {
+                patch_head(&writer, top->head, 1,
+                           top->is_map ? CBOR_MAJOR_MAP : CBOR_MAJOR_ARRAY, top->count);
+                depth--;
+                pos++;
+            } else {
+                result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+            }
+            continue;
+        }
+
+        if (pos >= len) {
+            result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+            break;
+        }
+
+        if (state == EXPECT_KEY) {
+            if (p[pos] != '"') {
+                result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                break;
+            }
+            pos++;
+            result = json_string(&writer, p, len, &pos);
+            if (result != PAUMIOT_SUCCESS) {
+                break;
+            }
+
+            pos = skip_ws(p, pos, len);
+            if (pos >= len || p[pos] != ':') {
+                result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                break;
+            }
+            pos++;
+            state = EXPECT_VALUE;
+            continue;
+        }
+
+        uint8_t c = p[pos];
+        switch (c) {
+            case '{':
+            case '[': {
+                if (depth == SENSOR_CODEC_MAX_DEPTH) {
+                    result = PAUMIOT_ERROR_NOT_SUPPORTED;
+                    break;
+                }
+
+                bool is_map = c == '{';
+                stack[depth].head = writer.len;
+                stack[depth].count = 0;
+                stack[depth].is_map = is_map;
+                cbor_write_head_fixed(&writer, is_map ? CBOR_MAJOR_MAP : CBOR_MAJOR_ARRAY, 0, 0);
+
+                pos = skip_ws(p, pos + 1, len);
+                if (pos < len && p[pos] == (is_map ? '}' : ']')) {
+                    /* Empty: the placeholder head is already correct */
+                    pos++;
+                    state = AFTER_VALUE;
+                } else {
+                    depth++;
+                    state = is_map ? EXPECT_KEY : EXPECT_VALUE;
+                }
+                continue;
+            }
+            case '"':
+                pos++;
+                result = json_string(&writer, p, len, &pos);
+                break;
+            case 't':
+            case 'f':
+                if (json_literal(p, len, &pos, c == 't' ? "true" : "false")) {
+                    cbor_write_bool(&writer, c == 't');
+                } else {
+                    result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                }
+                break;
+            case 'n':
+                if (json_literal(p, len, &pos, "null")) {
+                    cbor_write_null(&writer);
+                } else {
+                    result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                }
+                break;
+            default:
+                if (c == '-' || (c >= '0' && c <= '9')) {
+                    result = json_number(&writer, p, len, &pos);
+                } else {
+                    result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                }
+                break;
+        }
+        state = AFTER_VALUE;
+    }
+
+    if (result == PAUMIOT_SUCCESS && skip_ws(p, pos, len) != len) {
+        result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+    }
+    if (result == PAUMIOT_SUCCESS) {
+        result = cbor_writer_result(&writer);
+    }
+
+    *out_len = writer.len;
+    return result;
+}
+
+paumiot_result_t sensor_codec_cbor_to_json(const uint8_t *cbor, size_t len,
+                                           char *out, size_t capacity, size_t *out_len) {
+    if (!cbor || !out_len) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    cbor_frame_t stack[SENSOR_CODEC_MAX_DEPTH];
+    size_t depth = 0;
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+    cbor_reader_t reader;
+    cbor_writer_t writer;
+
+    cbor_reader_init(&reader, cbor, len);
+    cbor_writer_init(&writer, (uint8_t *)out, capacity);
+
+    for (;;) {
+        cbor_item_t item;
+        if (cbor_reader_next(&reader, &item) != PAUMIOT_SUCCESS) {
+            result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+            break;
+        }
+
+        /* Tags have no JSON form; the tagged item stands alone */
+        if (item.type == CBOR_TYPE_TAG) {
+            continue;
+        }
+
+        cbor_frame_t *top = depth > 0 ? &stack[depth - 1] : NULL;
+
+        if (item.type == CBOR_TYPE_BREAK) {
+            if (!top || top->remaining != ITEMS_UNTIL_BREAK || (top->is_map && top->index % 2)) {
+                result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                break;
+            }
+            put_char(&writer, top->is_map ? '}' : ']');
+            depth--;
+        } else {
+            bool is_key = top && top->is_map && top->index % 2 == 0;
+
+            /* Map values always follow their key, so index > 0 */
+            if (top && top->index > 0) {
+                put_char(&writer, top->is_map && !is_key ? ':' : ',');
+            }
+
+            if (is_key && item.type != CBOR_TYPE_TEXT) {
+                if (item.type != CBOR_TYPE_UINT && item.type != CBOR_TYPE_NEGINT) {
+                    result = PAUMIOT_ERROR_NOT_SUPPORTED;
+                    break;
+                }
+                put_char(&writer, '"');
+                put_integer(&writer, &item);
+                put_char(&writer, '"');
+            } else {
+                switch (item.type) {
+                    case CBOR_TYPE_UINT:
+                    case CBOR_TYPE_NEGINT:
+                        put_integer(&writer, &item);
+                        break;
+                    case CBOR_TYPE_BYTES:
+                    case CBOR_TYPE_TEXT:
+                        result = put_string(&writer, &reader, &item);
+                        break;
+                    case CBOR_TYPE_ARRAY:
+                    case CBOR_TYPE_MAP: {
+                        bool is_map = item.type == CBOR_TYPE_MAP;
+                        put_char(&writer, is_map ? '{' : '[');
+
+                        if (!item.indefinite && item.value == 0) {
+                            put_char(&writer, is_map ? '}' : ']');
+                            break;
+                        }
+                        if (!item.indefinite && is_map && item.value > UINT64_MAX / 2 - 1) {
+                            result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+                            break;
+                        }
+                        if (depth == SENSOR_CODEC_MAX_DEPTH) {
+                            result = PAUMIOT_ERROR_NOT_SUPPORTED;
+                            break;
+                        }
+
+                        stack[depth].remaining = item.indefinite ? ITEMS_UNTIL_BREAK
+                                               : is_map ? item.value * 2 : item.value;
+                        stack[depth].index = 0;
+                        stack[depth].is_map = is_map;
+                        depth++;
+                        continue;
+                    }
+                    case CBOR_TYPE_FALSE:
+                        put_str(&writer, "false");
+                        break;
+                    case CBOR_TYPE_TRUE:
+                        put_str(&writer, "true");
+                        break;
+                    case CBOR_TYPE_FLOAT:
+                        put_double(&writer, item.number);
+                        break;
+                    default:
+                        /* null, undefined and unassigned simple values */
+                        put_str(&writer, "null");
+                        break;
+                }
+            }
+            if (result != PAUMIOT_SUCCESS) {
+                break;
+            }
+        }
+
+        /* A finished item may finish its enclosing definite-length containers */
+        while (depth > 0) {
+            top = &stack[depth - 1];
+            top->index++;
+            if (top->remaining == ITEMS_UNTIL_BREAK || --top->remaining > 0) {
+                break;
+            }
+            put_char(&writer, top->is_map ? '}' : ']');
+            depth--;
+        }
+        if (depth == 0) {
+            break;
+        }
+    }
+
+    if (result == PAUMIOT_SUCCESS && reader.pos != reader.len) {
+        result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+    }
+    if (result == PAUMIOT_SUCCESS) {
+        result = cbor_writer_result(&writer);
+    }
+
+    *out_len = writer.len;
+    return result;
+}
+
+paumiot_result_t sensor_codec_transcode(data_format_t from, data_format_t to,
+                                        const uint8_t *in, size_t in_len,
+                                        uint8_t *out, size_t capacity, size_t *out_len) {
+    if ((!in && in_len > 0) || !out_len) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    if (from == to) {
+        *out_len = in_len;
+        if (in_len > capacity || (!out && in_len > 0)) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL;
+        }
+        if (in_len > 0) {
+            memcpy(out, in, in_len);
+        }
+        return PAUMIOT_SUCCESS;
+    }
+
+    if (from == DATA_FORMAT_JSON && to == DATA_FORMAT_CBOR) {
+        return sensor_codec_json_to_cbor((const char *)in, in_len, out, capacity, out_len);
+    }
+    if (from == DATA_FORMAT_CBOR && to == DATA_FORMAT_JSON) {
+        return sensor_codec_cbor_to_json(in, in_len, (char *)out, capacity, out_len);
+    }
+
+    return PAUMIOT_ERROR_NOT_SUPPORTED;
+}
+
+/* ============================================================================
+ * FORMAT ROUTES API
+ * ========================================================================= */
+
+sensor_codec_routes_t *sensor_codec_routes_create(void) {
+    return calloc(1, sizeof(sensor_codec_routes_t));
+}
+
+void sensor_codec_routes_destroy(sensor_codec_routes_t *routes) {
+    if (!routes) {
+        return;
+    }
+
+    for (size_t i = 0; i < routes->count; i++) {
+        free(routes->routes[i].filter);
+    }
+    free(routes->routes);
+    free(routes);
+}
+
+paumiot_result_t sensor_codec_routes_add(sensor_codec_routes_t *routes,
+                                         const char *topic_filter, data_format_t format) {
+    sensor_codec_route_t route = { format, SENSOR_COMPRESSION_NONE, NULL };
+    return sensor_codec_routes_add_route(routes, topic_filter, &route);
+}
+
+paumiot_result_t sensor_codec_routes_add_route(sensor_codec_routes_t *routes,
+                                               const char *topic_filter,
+                                               const sensor_codec_route_t *route) {
+    if (!routes || !topic_filter || !route ||
+        route->format < DATA_FORMAT_RAW || route->format > DATA_FORMAT_PROTOBUF ||
+        route->compression < SENSOR_COMPRESSION_NONE ||
+        route->compression >= SENSOR_COMPRESSION_MAX) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    if (routes->count == routes->capacity) {
+        size_t capacity = routes->capacity ? routes->capacity * 2 : 8;
+        codec_route_t *grown = realloc(routes->routes, capacity * sizeof(codec_route_t));
+        if (!grown) {
+            return PAUMIOT_ERROR_OUT_OF_MEMORY;
+        }
+        routes->routes = grown;
+        routes->capacity = capacity;
+    }
+
+    char *filter = strdup(topic_filter);
+    if (!filter) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    routes->routes[routes->count].filter = filter;
+    routes->routes[routes->count].target = *route;
+    routes->count++;
+
+    return PAUMIOT_SUCCESS;
+}
+
+bool sensor_codec_routes_lookup(const sensor_codec_routes_t *routes, const char *topic,
+                                sensor_codec_route_t *route) {
+    if (!routes || !topic || !route) {
+        return false;
+    }
+
+    for (size_t i = 0; i < routes->count; i++) {
+        if (sensor_topic_matches(routes->routes[i].filter, topic)) {
+            *route = routes->routes[i].target;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+data_format_t sensor_codec_routes_format(const sensor_codec_routes_t *routes,
+                                         const char *topic, data_format_t source) {
+    sensor_codec_route_t route;
+    return sensor_codec_routes_lookup(routes, topic, &route) ? route.format : source;
+}
+
+const char *sensor_codec_content_type(data_format_t format) {
+    switch (format) {
+    case DATA_FORMAT_JSON:
+        return "application/json";
+    case DATA_FORMAT_CBOR:
+        return "application/cbor";
+    case DATA_FORMAT_PROTOBUF:
+        return "application/x-protobuf";
+    case DATA_FORMAT_RAW:
+    default:
+        return "application/octet-stream";
+    }
+}
@@ -0,0 +1,789 @@
+/**
+ * @file sensor_compress.c
+ * @brief LZ4 block codec, dictionary training and the pooled compressor
+ * @details The LZ4 encoder is the single-probe greedy matcher of the
+ *          reference implementation. A dictionary is treated as data that
+ *          immediately precedes the input: its hash table is built once, and
+ *          each call probes the input's own table first and the dictionary's
+ *          second, so a dictionary costs nothing per call.
+ */
+
+#include "sensor_manager/sensor_compress.h"
+#include "memory_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5             /* The block ends with literals */
+#define LZ4_MFLIMIT 12                  /* No match starts this close to the end */
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_LOG_MAX 12             /* Input table: 16 KiB on the stack at most */
+#define LZ4_SKIP_TRIGGER 6              /* Probe less often after 2^6 misses */
+
+#define DICT_HASH_LOG 14
+#define TRAIN_DMER 8                    /* Substring length scored by the trainer */
+#define TRAIN_SEGMENT 64                /* Bytes copied per pick */
+#define TRAIN_HASH_LOG 16
+
+#define COMPRESSOR_MAX_DICTS 8
+
+struct sensor_compress_dict {
+    uint8_t *data;
+    size_t len;
+    uint32_t id;
+    uint32_t table[1u << DICT_HASH_LOG];    /* Last position + 1 per hash, 0 = empty */
+};
+
+struct sensor_compressor {
+    pthread_mutex_t lock;               /* Guards the pool and dictionaries */
+    memory_pool_t *pool;
+    size_t max_payload;
+    const sensor_compress_dict_t *dicts[COMPRESSOR_MAX_DICTS];
+    size_t num_dicts;
+};
+
+/* LZ4 output cursor */
+typedef struct {
+    uint8_t *buf;
+    size_t capacity;
+    size_t pos;
+} lz4_out_t;
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t sequence, unsigned log) {
+    return (sequence * 2654435761u) >> (32 - log);
+}
+
+/**
+ * @brief Length of the common prefix of `a` and `b`, at most `limit`
+ */
+static size_t common_prefix(const uint8_t *a, const uint8_t *b, size_t limit) {
+    size_t n = 0;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (n + 8 <= limit) {
+        uint64_t diff = read64(a + n) ^ read64(b + n);
+        if (diff) {
+            return n + (size_t)(__builtin_ctzll(diff) >> 3);
+        }
+        n += 8;
+    }
+#endif
+    while (n < limit && a[n] == b[n]) {
+        n++;
+    }
+    return n;
+}
+
+/* ============================================================================
+ * LZ4 BLOCK FORMAT
+ * ========================================================================= */
+
+static bool emit_length(lz4_out_t *out, size_t extra) {
+    while (extra >= 255) {
+        if (out->pos == out->capacity) {
+            return false;
+        }
+        out->buf[out->pos++] = 255;
+        extra -= 255;
+    }
+    if (out->pos == out->capacity) {
+        return false;
+    }
+    out->buf[out->pos++] = (uint8_t)extra;
+    return true;
+}
+
+/**
+ * @brief Write one sequence: literals, then a match unless `match_len` is 0
+ */
+static bool emit_sequence(lz4_out_t *out, const uint8_t *literals, size_t literal_len,
+                          size_t offset, size_t match_len) {
+    if (out->pos == out->capacity) {
+        return false;
+    }
+    size_t token = out->pos++;
+    out->buf[token] = (uint8_t)((literal_len < 15 ? literal_len : 15) << 4);
+    if (literal_len >= 15 && !emit_length(out, literal_len - 15)) {
+        return false;
+    }
+
+    if (out->capacity - out->pos < literal_len) {
+        return false;
+    }
+    memcpy(out->buf + out->pos, literals, literal_len);
+    out->pos += literal_len;
+
+    if (match_len == 0) {
+        return true;
+    }
+
+    if (out->capacity - out->pos < 2) {
+        return false;
+    }
+    out->buf[out->pos++] = (uint8_t)offset;
+    out->buf[out->pos++] = (uint8_t)(offset >> 8);
+
+    size_t extra = match_len - LZ4_MIN_MATCH;
+    out->buf[token] |= (uint8_t)(extra < 15 ? extra : 15);
+    return extra < 15 || emit_length(out, extra - 15);
+}
+
+size_t sensor_compress_lz4_bound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+paumiot_result_t sensor_compress_lz4(const uint8_t *in, size_t len,
+                                     const sensor_compress_dict_t *dict,
+                                     uint8_t *out, size_t capacity, size_t *out_len) {
+    if (!out_len || (!in && len > 0) || (!out && capacity > 0)) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+    *out_len = 0;
+
+    lz4_out_t cursor = { out, capacity, 0 };
+    size_t anchor = 0;
+
+    if (len > LZ4_MFLIMIT) {
+        unsigned log = 8;
+        while (log < LZ4_HASH_LOG_MAX && ((size_t)1 << log) < len) {
+            log++;
+        }
+
+        /* Position + 1 of the last occurrence per hash, 0 = empty */
+        uint32_t table[1u << LZ4_HASH_LOG_MAX];
+        memset(table, 0, sizeof(uint32_t) << log);
+
+        const size_t dict_len = dict ? dict->len : 0;
+        const size_t last_start = len - LZ4_MFLIMIT;
+        const size_t match_end = len - LZ4_LAST_LITERALS;
+        unsigned misses = 1u << LZ4_SKIP_TRIGGER;
+        size_t ip = 0;
+
+        while (ip <= last_start) {
+            uint32_t sequence = read32(in + ip);
+            uint32_t *slot = &table[hash4(sequence, log)];
+            size_t candidate = *slot;
+            size_t match = 0;
+            size_t offset = 0;
+            bool from_dict = false;
+
+            *slot = (uint32_t)(ip + 1);
+
+            if (candidate && ip - (candidate - 1) <= LZ4_MAX_OFFSET &&
+                read32(in + candidate - 1) == sequence) {
+                match = candidate - 1;
+                offset = ip - match;
+            } else if (dict) {
+                candidate = dict->table[hash4(sequence, DICT_HASH_LOG)];
+                if (candidate && ip + dict_len - (candidate - 1) <= LZ4_MAX_OFFSET &&
+                    read32(dict->data + candidate - 1) == sequence) {
+                    match = candidate - 1;
+                    offset = ip + dict_len - match;
+                    from_dict = true;
+                }
+            }
+
+            if (offset == 0) {
+                ip += misses++ >> LZ4_SKIP_TRIGGER;
+                continue;
+            }
+            misses = 1u << LZ4_SKIP_TRIGGER;
+
+            /* Extend backwards into the pending literals */
+            const uint8_t *source = from_dict ? dict->data : in;
+            while (ip > anchor && match > 0 && source[match - 1] == in[ip - 1]) {
+                ip--;
+                match--;
+            }
+
+            /* Extend forwards; a dictionary match may run on into the input */
+            size_t limit = match_end - ip;
+            size_t match_len;
+            if (from_dict) {
+                size_t dict_run = dict_len - match < limit ? dict_len - match : limit;
+                match_len = common_prefix(dict->data + match, in + ip, dict_run);
+                if (match_len == dict_len - match) {
+                    match_len += common_prefix(in, in + ip + match_len, limit - match_len);
+                }
+            } else {
+                match_len = common_prefix(in + match, in + ip, limit);
+            }
+
+            if (!emit_sequence(&cursor, in + anchor, ip - anchor, offset, match_len)) {
+                return (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL;
+            }
+            ip += match_len;
+            anchor = ip;
+
+            if (ip <= last_start) {
+                table[hash4(read32(in + ip - 2), log)] = (uint32_t)(ip - 1);
+            }
+        }
+    }
+
+    if (!emit_sequence(&cursor, in + anchor, len - anchor, 0, 0)) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL;
+    }
+    *out_len = cursor.pos;
+    return PAUMIOT_SUCCESS;
+}
+
+static bool read_length(const uint8_t *in, size_t len, size_t *pos, size_t *value) {
+    uint8_t byte;
+    do {
+        if (*pos == len) {
+            return false;
+        }
+        byte = in[(*pos)++];
+        *value += byte;
+    } while (byte == 255);
+    return true;
+}
+
+paumiot_result_t sensor_decompress_lz4(const uint8_t *in, size_t len,
+                                       const sensor_compress_dict_t *dict,
+                                       uint8_t *out, size_t capacity, size_t *out_len) {
+    if (!in || !out_len || (!out && capacity > 0)) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+    *out_len = 0;
+
+    const size_t dict_len = dict ? dict->len : 0;
+    size_t ip = 0;
+    size_t op = 0;
+
+    for (;;) {
+        if (ip == len) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        uint8_t token = in[ip++];
+
+        size_t literal_len = token >> 4;
+        if (literal_len == 15 && !read_length(in, len, &ip, &literal_len)) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        if (len - ip < literal_len) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        if (capacity - op < literal_len) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL;
+        }
+        memcpy(out + op, in + ip, literal_len);
+        ip += literal_len;
+        op += literal_len;
+
+        /* The last sequence has no match */
+        if (ip == len) {
+            break;
+        }
+
+        if (len - ip < 2) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        size_t offset = (size_t)in[ip] | ((size_t)in[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op + dict_len) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+
+        size_t match_len = token & 15;
+        if (match_len == 15 && !read_length(in, len, &ip, &match_len)) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        match_len += LZ4_MIN_MATCH;
+        if (capacity - op < match_len) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL;
+        }
+
+        if (offset > op) {
+            /* Starts in the dictionary, may continue at the output's start */
+            size_t back = offset - op;
+            size_t n = back < match_len ? back : match_len;
+            memcpy(out + op, dict->data + dict_len - back, n);
+            op += n;
+            match_len -= n;
+        }
+
+        if (offset >= match_len) {
+            memcpy(out + op, out + op - offset, match_len);
+            op += match_len;
+        } else {
+            /* Overlapping copy repeats the last `offset` bytes */
+            for (size_t i = 0; i < match_len; i++, op++) {
+                out[op] = out[op - offset];
+            }
+        }
+    }
+
+    *out_len = op;
+    return PAUMIOT_SUCCESS;
+}
+
+/* ============================================================================
+ * CODEC API
+ * ========================================================================= */
+
+static paumiot_result_t lz4_plain_compress(const uint8_t *in, size_t len,
+                                           const sensor_compress_dict_t *dict,
+                                           uint8_t *out, size_t capacity, size_t *out_len) {
+    (void)dict;
+    return sensor_compress_lz4(in, len, NULL, out, capacity, out_len);
+}
+
+static paumiot_result_t lz4_plain_decompress(const uint8_t *in, size_t len,
+                                             const sensor_compress_dict_t *dict,
+                                             uint8_t *out, size_t capacity, size_t *out_len) {
+    (void)dict;
+    return sensor_decompress_lz4(in, len, NULL, out, capacity, out_len);
+}
+
+static const sensor_compress_codec_t lz4_codec = {
+    "lz4", false, lz4_plain_compress, lz4_plain_decompress
+};
+
+static const sensor_compress_codec_t lz4_dict_codec = {
+    "lz4-dict", true, sensor_compress_lz4, sensor_decompress_lz4
+};
+
+static const sensor_compress_codec_t *codecs[SENSOR_COMPRESSION_MAX] = {
+    [SENSOR_COMPRESSION_LZ4] = &lz4_codec,
+    [SENSOR_COMPRESSION_LZ4_DICT] = &lz4_dict_codec,
+};
+
+paumiot_result_t sensor_compress_register(sensor_compression_t codec,
+                                          const sensor_compress_codec_t *impl) {
+    if (codec <= SENSOR_COMPRESSION_NONE || codec >= SENSOR_COMPRESSION_MAX) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+    if (impl && (!impl->encoding || !impl->compress || !impl->decompress)) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    codecs[codec] = impl;
+    return PAUMIOT_SUCCESS;
+}
+
+bool sensor_compress_available(sensor_compression_t codec) {
+    return codec == SENSOR_COMPRESSION_NONE ||
+           (codec > SENSOR_COMPRESSION_NONE && codec < SENSOR_COMPRESSION_MAX && codecs[codec]);
+}
+
+const char *sensor_compress_encoding(sensor_compression_t codec) {
+    if (codec == SENSOR_COMPRESSION_NONE) {
+        return "identity";
+    }
+    return sensor_compress_available(codec) ? codecs[codec]->encoding : NULL;
+}
+
+/* ============================================================================
+ * DICTIONARY API
+ * ========================================================================= */
+
+sensor_compress_dict_t *sensor_compress_dict_create(const uint8_t *data, size_t len) {
+    if (!data || len == 0 || len > SENSOR_COMPRESS_MAX_DICT_SIZE) {
+        return NULL;
+    }
+
+    sensor_compress_dict_t *dict = calloc(1, sizeof(sensor_compress_dict_t));
+    if (!dict) {
+        return NULL;
+    }
+    dict->data = malloc(len);
+    if (!dict->data) {
+        free(dict);
+        return NULL;
+    }
+    memcpy(dict->data, data, len);
+    dict->len = len;
+
+    /* FNV-1a */
+    uint32_t id = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        id = (id ^ data[i]) * 16777619u;
+    }
+    dict->id = id;
+
+    /* Later positions overwrite earlier ones: shorter offsets */
+    for (size_t i = 0; i + LZ4_MIN_MATCH <= len; i++) {
+        dict->table[hash4(read32(data + i), DICT_HASH_LOG)] = (uint32_t)(i + 1);
+    }
+
+    return dict;
+}
+
+static inline uint32_t hash_dmer(const uint8_t *p) {
+    return (uint32_t)((read64(p) * 0xcf1bbcdcb7a56463ull) >> (64 - TRAIN_HASH_LOG));
+}
+
+/* Only substrings seen in more than one sample are worth storing */
+static inline uint64_t dmer_score(uint32_t frequency) {
+    return frequency > 1 ? frequency : 0;
+}
+
+sensor_compress_dict_t *sensor_compress_dict_train(const uint8_t *const *samples,
+                                                   const size_t *sizes, size_t count,
+                                                   size_t capacity) {
+    if (!samples || !sizes || count == 0 || capacity == 0 ||
+        capacity > SENSOR_COMPRESS_MAX_DICT_SIZE) {
+        return NULL;
+    }
+
+    uint32_t *frequency = calloc(1u << TRAIN_HASH_LOG, sizeof(uint32_t));
+    uint32_t *last_sample = calloc(1u << TRAIN_HASH_LOG, sizeof(uint32_t));
+    uint8_t *contents = malloc(capacity);
+    if (!frequency || !last_sample || !contents) {
+        free(frequency);
+        free(last_sample);
+        free(contents);
+        return NULL;
+    }
+
+    /* Number of samples containing each substring */
+    for (size_t s = 0; s < count; s++) {
+        for (size_t p = 0; sizes[s] >= TRAIN_DMER && p <= sizes[s] - TRAIN_DMER; p++) {
+            uint32_t h = hash_dmer(samples[s] + p);
+            if (last_sample[h] != s + 1) {
+                last_sample[h] = (uint32_t)(s + 1);
+                frequency[h]++;
+            }
+        }
+    }
+
+    /*
+     * Pick the best-scoring segment of any sample, then zero its substrings
+     * so the next pick covers something else.
+     */
+    size_t used = 0;
+    while (used < capacity) {
+        uint64_t best_score = 0;
+        const uint8_t *best = NULL;
+        size_t segment = capacity - used < TRAIN_SEGMENT ? capacity - used : TRAIN_SEGMENT;
+
+        if (segment < TRAIN_DMER) {
+            break;
+        }
+
+        for (size_t s = 0; s < count; s++) {
+            if (sizes[s] < segment) {
+                continue;
+            }
+            const uint8_t *sample = samples[s];
+            size_t dmers = segment - TRAIN_DMER + 1;
+            uint64_t score = 0;
+
+            for (size_t p = 0; p < dmers; p++) {
+                score += dmer_score(frequency[hash_dmer(sample + p)]);
+            }
+            for (size_t start = 0;; start++) {
+                if (score > best_score) {
+                    best_score = score;
+                    best = sample + start;
+                }
+                if (start + segment == sizes[s]) {
+                    break;
+                }
+                score -= dmer_score(frequency[hash_dmer(sample + start)]);
+                score += dmer_score(frequency[hash_dmer(sample + start + dmers)]);
+            }
+        }
+
+        if (!best) {
+            break;
+        }
+
+        memcpy(contents + used, best, segment);
+        used += segment;
+        for (size_t p = 0; p + TRAIN_DMER <= segment; p++) {
+            frequency[hash_dmer(best + p)] = 0;
+        }
+    }
+
+    sensor_compress_dict_t *dict = used > 0 ? sensor_compress_dict_create(contents, used) : NULL;
+    free(frequency);
+    free(last_sample);
+    free(contents);
+    return dict;
+}
+
+void sensor_compress_dict_destroy(sensor_compress_dict_t *dict) {
+    if (!dict) {
+        return;
+    }
+    free(dict->data);
+    free(dict);
+}
+
+const uint8_t *sensor_compress_dict_data(const sensor_compress_dict_t *dict, size_t *len) {
+    if (!dict) {
+        return NULL;
+    }
+    if (len) {
+        *len = dict->len;
+    }
+    return dict->data;
+}
+
+uint32_t sensor_compress_dict_id(const sensor_compress_dict_t *dict) {
+    return dict ? dict->id : 0;
+}
+
+/* ============================================================================
+ * COMPRESSOR API
+ * ========================================================================= */
+
+static size_t put_varint(uint8_t *p, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        p[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool get_varint(const uint8_t *p, size_t len, size_t *pos, uint64_t *value) {
+    *value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (*pos == len) {
+            return false;
+        }
+        uint8_t byte = p[(*pos)++];
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t *acquire_buffer(sensor_compressor_t *compressor) {
+    pthread_mutex_lock(&compressor->lock);
+    uint8_t *buffer = pool_alloc(compressor->pool);
+    pthread_mutex_unlock(&compressor->lock);
+    return buffer;
+}
+
+sensor_compressor_t *sensor_compressor_create(size_t max_payload, size_t buffers) {
+    if (max_payload == 0 || buffers == 0) {
+        return NULL;
+    }
+
+    sensor_compressor_t *compressor = calloc(1, sizeof(sensor_compressor_t));
+    if (!compressor) {
+        return NULL;
+    }
+
+    /* Compressed frames are only kept when smaller than the payload */
+    compressor->pool = pool_create(buffers, max_payload + SENSOR_COMPRESS_FRAME_OVERHEAD);
+    if (!compressor->pool) {
+        free(compressor);
+        return NULL;
+    }
+    compressor->max_payload = max_payload;
+    pthread_mutex_init(&compressor->lock, NULL);
+
+    return compressor;
+}
+
+void sensor_compressor_destroy(sensor_compressor_t *compressor) {
+    if (!compressor) {
+        return;
+    }
+    pool_destroy(compressor->pool);
+    pthread_mutex_destroy(&compressor->lock);
+    free(compressor);
+}
+
+paumiot_result_t sensor_compressor_add_dict(sensor_compressor_t *compressor,
+                                            const sensor_compress_dict_t *dict) {
+    if (!compressor || !dict) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+    pthread_mutex_lock(&compressor->lock);
+    if (compressor->num_dicts == COMPRESSOR_MAX_DICTS) {
+        result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+    } else {
+        compressor->dicts[compressor->num_dicts++] = dict;
+    }
+    pthread_mutex_unlock(&compressor->lock);
+
+    return result;
+}
+
+paumiot_result_t sensor_compressor_compress(sensor_compressor_t *compressor,
+                                            sensor_compression_t codec,
+                                            const sensor_compress_dict_t *dict,
+                                            const uint8_t *in, size_t len,
+                                            uint8_t **frame, size_t *frame_len) {
+    if (!compressor || !frame || !frame_len || (!in && len > 0)) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+    if (!sensor_compress_available(codec)) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+    if (len > compressor->max_payload) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    const sensor_compress_codec_t *impl = codec ? codecs[codec] : NULL;
+    if (impl && impl->uses_dict && !dict) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    uint8_t *buffer = acquire_buffer(compressor);
+    if (!buffer) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t header = 1 + put_varint(buffer + 1, len);
+    size_t dict_bytes = impl && impl->uses_dict ? 4 : 0;
+
+    /* The codec must beat storing the payload as-is */
+    if (impl && len > dict_bytes + 1) {
+        size_t compressed_len;
+        paumiot_result_t result = impl->compress(in, len, dict_bytes ? dict : NULL,
+                                                 buffer + header + dict_bytes,
+                                                 len - dict_bytes - 1, &compressed_len);
+        if (result == PAUMIOT_SUCCESS) {
+            buffer[0] = (uint8_t)codec;
+            if (dict_bytes) {
+                uint32_t id = dict->id;
+                for (size_t i = 0; i < 4; i++) {
+                    buffer[header + i] = (uint8_t)(id >> (8 * i));
+                }
+            }
+            *frame = buffer;
+            *frame_len = header + dict_bytes + compressed_len;
+            return PAUMIOT_SUCCESS;
+        }
+        if (result != (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL) {
+            sensor_compressor_release(compressor, buffer);
+            return result;
+        }
+    }
+
+    buffer[0] = SENSOR_COMPRESSION_NONE;
+    if (len > 0) {
+        memcpy(buffer + header, in, len);
+    }
+    *frame = buffer;
+    *frame_len = header + len;
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_compressor_decompress(sensor_compressor_t *compressor,
+                                              const uint8_t *frame, size_t frame_len,
+                                              uint8_t **out, size_t *out_len,
+                                              sensor_compression_t *codec) {
+    if (!compressor || !frame || !out || !out_len) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    size_t pos = 1;
+    uint64_t len;
+    if (frame_len < 2 || !get_varint(frame, frame_len, &pos, &len)) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+    }
+
+    sensor_compression_t frame_codec = (sensor_compression_t)frame[0];
+    if (frame[0] >= SENSOR_COMPRESSION_MAX) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+    }
+    if (!sensor_compress_available(frame_codec)) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+    if (len > compressor->max_payload) {
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    const sensor_compress_codec_t *impl = frame_codec ? codecs[frame_codec] : NULL;
+    const sensor_compress_dict_t *dict = NULL;
+    if (impl && impl->uses_dict) {
+        if (frame_len - pos < 4) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+        uint32_t id = (uint32_t)frame[pos] | ((uint32_t)frame[pos + 1] << 8) |
+                      ((uint32_t)frame[pos + 2] << 16) | ((uint32_t)frame[pos + 3] << 24);
+        pos += 4;
+
+        pthread_mutex_lock(&compressor->lock);
+        for (size_t i = 0; i < compressor->num_dicts; i++) {
+            if (compressor->dicts[i]->id == id) {
+                dict = compressor->dicts[i];
+                break;
+            }
+        }
+        pthread_mutex_unlock(&compressor->lock);
+
+        if (!dict) {
+            return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+        }
+    }
+
+    uint8_t *buffer = acquire_buffer(compressor);
+    if (!buffer) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+    size_t decoded = frame_len - pos;
+    if (!impl) {
+        if (decoded != len) {
+            result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        } else if (len > 0) {
+            memcpy(buffer, frame + pos, len);
+        }
+    } else {
+        result = impl->decompress(frame + pos, frame_len - pos, dict, buffer, (size_t)len,
+                                  &decoded);
+        /* Output must match the recorded length exactly */
+        if (result == (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL ||
+            (result == PAUMIOT_SUCCESS && decoded != len)) {
+            result = (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED;
+        }
+    }
+
+    if (result != PAUMIOT_SUCCESS) {
+        sensor_compressor_release(compressor, buffer);
+        return result;
+    }
+
+    *out = buffer;
+    *out_len = (size_t)len;
+    if (codec) {
+        *codec = frame_codec;
+    }
+    return PAUMIOT_SUCCESS;
+}
+
+uint8_t *sensor_compressor_acquire(sensor_compressor_t *compressor, size_t *capacity) {
+    if (!compressor || !capacity) {
+        return NULL;
+    }
+    *capacity = compressor->max_payload + SENSOR_COMPRESS_FRAME_OVERHEAD;
+    return acquire_buffer(compressor);
+}
+
+void sensor_compressor_release(sensor_compressor_t *compressor, uint8_t *buffer) {
+    if (!compressor || !buffer) {
+        return;
+    }
+    pthread_mutex_lock(&compressor->lock);
+    pool_free(compressor->pool, buffer);
+    pthread_mutex_unlock(&compressor->lock);
+}
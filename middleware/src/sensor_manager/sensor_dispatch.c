@@ -0,0 +1,237 @@
+/**
+ * @file sensor_dispatch.c
+ * @brief Worker pool for deferred data callbacks
+ * @details Every worker has its own ring and lock, so submitters for
+ *          different sensors rarely contend and a slow callback only delays
+ *          the sensors that hash to its worker.
+ */
+
+#include "sensor_dispatch.h"
+#include "cpu_topology.h"
+#include "logging.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/* Queued callback invocation */
+typedef struct {
+    sensor_data_callback_t callback;
+    void *user_data;
+    sensor_dispatch_data_t *shared;
+} dispatch_job_t;
+
+/* Worker and its queue */
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;           /* Guards the ring and stop */
+    pthread_cond_t cond;
+    dispatch_job_t *jobs;           /* Ring of `capacity` jobs */
+    size_t capacity;
+    size_t head;                    /* Oldest job */
+    size_t count;                   /* Queued jobs */
+    bool stop;                      /* Exit once the ring is empty */
+    bool ready;                     /* Ring allocated (or failed to) */
+    int cpu;                        /* CPU to pin to (-1 = any) */
+} dispatch_worker_t;
+
+struct sensor_dispatch {
+    size_t num_threads;
+    dispatch_worker_t workers[];
+};
+
+static void *worker_main(void *arg) {
+    dispatch_worker_t *worker = arg;
+
+    if (worker->cpu >= 0 && !cpu_pin_current_thread(worker->cpu)) {
+        LOG_WARN("Could not pin dispatch worker to CPU %d", worker->cpu);
+    }
+
+    /* Written here first so its pages land on this thread's NUMA node */
+    dispatch_job_t *jobs = malloc(worker->capacity * sizeof(dispatch_job_t));
+    if (jobs) {
+        memset(jobs, 0, worker->capacity * sizeof(dispatch_job_t));
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    worker->jobs = jobs;
+    worker->ready = true;
+    pthread_cond_broadcast(&worker->cond);
+    if (!jobs) {
+        pthread_mutex_unlock(&worker->lock);
+        return NULL;
+    }
+
+    for (;;) {
+        while (worker->count == 0 && !worker->stop) {
+            pthread_cond_wait(&worker->cond, &worker->lock);
+        }
+        if (worker->count == 0) {
+            break;
+        }
+
+        dispatch_job_t job = worker->jobs[worker->head];
+        worker->head = (worker->head + 1) % worker->capacity;
+        worker->count--;
+
+        pthread_mutex_unlock(&worker->lock);
+
+        sensor_data_t *data = job.shared->data;
+        job.callback(data->sensor_id, data, job.user_data);
+        sensor_dispatch_data_release(job.shared);
+
+        pthread_mutex_lock(&worker->lock);
+    }
+
+    pthread_mutex_unlock(&worker->lock);
+    return NULL;
+}
+
+/**
+ * @brief Stop and join the first `started` workers, then free the pool
+ */
+static void dispatch_teardown(sensor_dispatch_t *dispatch, size_t started) {
+    for (size_t i = 0; i < started; i++) {
+        dispatch_worker_t *worker = &dispatch->workers[i];
+
+        pthread_mutex_lock(&worker->lock);
+        worker->stop = true;
+        pthread_cond_signal(&worker->cond);
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    for (size_t i = 0; i < dispatch->num_threads; i++) {
+        dispatch_worker_t *worker = &dispatch->workers[i];
+
+        if (i < started) {
+            pthread_join(worker->thread, NULL);
+        }
+        pthread_cond_destroy(&worker->cond);
+        pthread_mutex_destroy(&worker->lock);
+        free(worker->jobs);
+    }
+
+    free(dispatch);
+}
+
+/* ============================================================================
+ * SENSOR DISPATCH API
+ * ========================================================================= */
+
+sensor_dispatch_t *sensor_dispatch_create(size_t num_threads, size_t queue_size,
+                                          const int16_t *cpus) {
+    if (num_threads == 0 || queue_size == 0) {
+        return NULL;
+    }
+
+    sensor_dispatch_t *dispatch = calloc(1, sizeof(sensor_dispatch_t) +
+                                            num_threads * sizeof(dispatch_worker_t));
+    if (!dispatch) {
+        return NULL;
+    }
+    dispatch->num_threads = num_threads;
+
+    bool ok = true;
+    for (size_t i = 0; i < num_threads; i++) {
+        dispatch_worker_t *worker = &dispatch->workers[i];
+
+        pthread_mutex_init(&worker->lock, NULL);
+        pthread_cond_init(&worker->cond, NULL);
+        worker->capacity = queue_size;
+        worker->cpu = cpus ? cpus[i] : -1;
+    }
+
+    size_t started = 0;
+    while (ok && started < num_threads) {
+        dispatch_worker_t *worker = &dispatch->workers[started];
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            ok = false;
+            break;
+        }
+        started++;
+    }
+
+    /* Workers allocate their own rings; wait until they have */
+    for (size_t i = 0; i < started; i++) {
+        dispatch_worker_t *worker = &dispatch->workers[i];
+
+        pthread_mutex_lock(&worker->lock);
+        while (!worker->ready) {
+            pthread_cond_wait(&worker->cond, &worker->lock);
+        }
+        ok = ok && worker->jobs;
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    if (!ok) {
+        dispatch_teardown(dispatch, started);
+        return NULL;
+    }
+
+    return dispatch;
+}
+
+void sensor_dispatch_destroy(sensor_dispatch_t *dispatch) {
+    if (!dispatch) {
+        return;
+    }
+
+    dispatch_teardown(dispatch, dispatch->num_threads);
+}
+
+sensor_dispatch_data_t *sensor_dispatch_data_create(sensor_data_t *data) {
+    if (!data) {
+        return NULL;
+    }
+
+    sensor_dispatch_data_t *shared = malloc(sizeof(sensor_dispatch_data_t));
+    if (!shared) {
+        sensor_data_free(data);
+        return NULL;
+    }
+
+    atomic_init(&shared->refs, 1);
+    shared->data = data;
+    return shared;
+}
+
+void sensor_dispatch_data_release(sensor_dispatch_data_t *shared) {
+    if (!shared) {
+        return;
+    }
+
+    if (atomic_fetch_sub_explicit(&shared->refs, 1, memory_order_acq_rel) == 1) {
+        sensor_data_free(shared->data);
+        free(shared);
+    }
+}
+
+paumiot_result_t sensor_dispatch_submit(sensor_dispatch_t *dispatch, uint32_t key,
+                                        sensor_data_callback_t callback, void *user_data,
+                                        sensor_dispatch_data_t *shared) {
+    if (!dispatch || !callback || !shared) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    /* Map the full 32-bit key range onto the workers */
+    size_t index = (size_t)(((uint64_t)key * dispatch->num_threads) >> 32);
+    dispatch_worker_t *worker = &dispatch->workers[index];
+
+    pthread_mutex_lock(&worker->lock);
+
+    if (worker->count == worker->capacity) {
+        pthread_mutex_unlock(&worker->lock);
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    atomic_fetch_add_explicit(&shared->refs, 1, memory_order_relaxed);
+    dispatch_job_t *job = &worker->jobs[(worker->head + worker->count) % worker->capacity];
+    job->callback = callback;
+    job->user_data = user_data;
+    job->shared = shared;
+    worker->count++;
+
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+
+    return PAUMIOT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file sensor_dispatch.h
+ * @brief Worker pool for deferred data callbacks
+ * @details Each worker owns a bounded queue and jobs are sharded by key
+ *          (the sensor ID hash), so callbacks for one sensor run in order on
+ *          one thread. Readings are shared between the jobs of one update
+ *          through a reference-counted copy.
+ */
+
+#ifndef PAUMIOT_SENSOR_DISPATCH_H
+#define PAUMIOT_SENSOR_DISPATCH_H
+
+#include "sensor_manager/sensor_manager.h"
+#include <stdatomic.h>
+
+/* Forward Declarations */
+typedef struct sensor_dispatch sensor_dispatch_t;
+
+/* Reading shared by the jobs of one update */
+typedef struct {
+    atomic_uint refs;
+    sensor_data_t *data;
+} sensor_dispatch_data_t;
+
+/**
+ * @brief Start a pool
+ * @details Each worker pins itself before allocating its queue, so the
+ *          queue lives on the worker's NUMA node.
+ * @param num_threads Worker threads (> 0)
+ * @param queue_size Jobs queued per worker before submissions are dropped (> 0)
+ * @param cpus CPU per worker, -1 = any (NULL = none pinned)
+ * @return Pool instance or NULL on error
+ */
+sensor_dispatch_t *sensor_dispatch_create(size_t num_threads, size_t queue_size,
+                                          const int16_t *cpus);
+
+/**
+ * @brief Run queued jobs, then stop and free the pool
+ * @param dispatch Pool instance (can be NULL)
+ */
+void sensor_dispatch_destroy(sensor_dispatch_t *dispatch);
+
+/**
+ * @brief Wrap a reading for deferred delivery
+ * @param data Heap-allocated reading; ownership passes to the wrapper, and
+ *        it is released with sensor_data_free() (even on failure)
+ * @return Shared reading holding one reference, or NULL on allocation failure
+ */
+sensor_dispatch_data_t *sensor_dispatch_data_create(sensor_data_t *data);
+
+/**
+ * @brief Drop a reference to a shared reading (freed with the last one)
+ */
+void sensor_dispatch_data_release(sensor_dispatch_data_t *shared);
+
+/**
+ * @brief Queue a callback invocation
+ * @details Takes its own reference to `shared` on success.
+ * @param dispatch Pool instance
+ * @param key Shard key (same key = same worker, in submission order)
+ * @param callback Callback to run
+ * @param user_data Callback user data
+ * @param shared Reading to deliver
+ * @return PAUMIOT_SUCCESS, or PAUMIOT_ERROR_OPERATION_FAILED if the
+ *         worker's queue is full (the job is dropped)
+ */
+paumiot_result_t sensor_dispatch_submit(sensor_dispatch_t *dispatch, uint32_t key,
+                                        sensor_data_callback_t callback, void *user_data,
+                                        sensor_dispatch_data_t *shared);
+
+#endif /* PAUMIOT_SENSOR_DISPATCH_H */
@@ -0,0 +1,201 @@
+/**
+ * @file sensor_health.c
+ * @brief Timing wheel for sensor liveness deadlines
+ * @details Buckets are indexed by absolute tick modulo the wheel size. The
+ *          wheel spans more ticks than the timeout, so a freshly armed node
+ *          never shares a bucket with an expiring one; nodes left in a bucket
+ *          from a later lap (only possible when checks fall behind) are
+ *          skipped by comparing their absolute tick.
+ */
+
+#include "sensor_manager/sensor_health.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+struct sensor_health {
+    uint32_t tick_ms;
+    uint32_t timeout_ms;
+    size_t num_slots;               /* Power of 2, > timeout_ms / tick_ms + 1 */
+
+    pthread_mutex_t lock;           /* Guards the lists, next_slot and tracked */
+    uint64_t next_slot;             /* First tick not yet expired */
+    size_t tracked;
+    sensor_health_node_t *slots[];  /* Bucket list heads */
+};
+
+static sensor_health_node_t **bucket_of(sensor_health_t *health, uint64_t slot) {
+    return &health->slots[slot & (health->num_slots - 1)];
+}
+
+/**
+ * @brief Unlink a tracked node (caller holds lock)
+ */
+static void node_unlink(sensor_health_t *health, sensor_health_node_t *node, uint64_t slot) {
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        *bucket_of(health, slot) = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+
+    node->prev = NULL;
+    node->next = NULL;
+    atomic_store_explicit(&node->slot, SENSOR_HEALTH_UNTRACKED, memory_order_relaxed);
+    health->tracked--;
+}
+
+/* ============================================================================
+ * SENSOR HEALTH API
+ * ========================================================================= */
+
+sensor_health_t *sensor_health_create(uint32_t tick_ms, uint32_t timeout_ms) {
+    if (tick_ms == 0 || timeout_ms == 0) {
+        return NULL;
+    }
+
+    /* Deadlines lie at most ceil(timeout / tick) ticks ahead of the check */
+    size_t span = (size_t)timeout_ms / tick_ms + 2;
+    size_t num_slots = 1;
+    while (num_slots < span) {
+        num_slots <<= 1;
+    }
+
+    sensor_health_t *health = calloc(1, sizeof(sensor_health_t) +
+                                        num_slots * sizeof(sensor_health_node_t *));
+    if (!health) {
+        return NULL;
+    }
+
+    health->tick_ms = tick_ms;
+    health->timeout_ms = timeout_ms;
+    health->num_slots = num_slots;
+    pthread_mutex_init(&health->lock, NULL);
+
+    return health;
+}
+
+void sensor_health_destroy(sensor_health_t *health) {
+    if (!health) {
+        return;
+    }
+
+    pthread_mutex_destroy(&health->lock);
+    free(health);
+}
+
+void sensor_health_node_init(sensor_health_node_t *node) {
+    if (!node) {
+        return;
+    }
+
+    node->prev = NULL;
+    node->next = NULL;
+    atomic_init(&node->slot, SENSOR_HEALTH_UNTRACKED);
+}
+
+void sensor_health_touch(sensor_health_t *health, sensor_health_node_t *node, uint64_t now_ms) {
+    if (!health || !node) {
+        return;
+    }
+
+    uint64_t slot = (now_ms + health->timeout_ms + health->tick_ms - 1) / health->tick_ms;
+
+    /* Fast path: the deadline moved within the same bucket */
+    if (atomic_load_explicit(&node->slot, memory_order_relaxed) == slot) {
+        return;
+    }
+
+    pthread_mutex_lock(&health->lock);
+
+    if (slot < health->next_slot) {
+        slot = health->next_slot;
+    }
+
+    uint64_t current = atomic_load_explicit(&node->slot, memory_order_relaxed);
+    if (current != slot) {
+        if (current != SENSOR_HEALTH_UNTRACKED) {
+            node_unlink(health, node, current);
+        }
+
+        sensor_health_node_t **head = bucket_of(health, slot);
+        node->prev = NULL;
+        node->next = *head;
+        if (*head) {
+            (*head)->prev = node;
+        }
+        *head = node;
+        atomic_store_explicit(&node->slot, slot, memory_order_relaxed);
+        health->tracked++;
+    }
+
+    pthread_mutex_unlock(&health->lock);
+}
+
+void sensor_health_remove(sensor_health_t *health, sensor_health_node_t *node) {
+    if (!health || !node) {
+        return;
+    }
+
+    pthread_mutex_lock(&health->lock);
+
+    uint64_t current = atomic_load_explicit(&node->slot, memory_order_relaxed);
+    if (current != SENSOR_HEALTH_UNTRACKED) {
+        node_unlink(health, node, current);
+    }
+
+    pthread_mutex_unlock(&health->lock);
+}
+
+size_t sensor_health_expire(sensor_health_t *health, uint64_t now_ms,
+                            sensor_health_node_t **nodes, size_t max) {
+    if (!health || !nodes || max == 0) {
+        return 0;
+    }
+
+    uint64_t current = now_ms / health->tick_ms;
+    size_t count = 0;
+
+    pthread_mutex_lock(&health->lock);
+
+    /* After a stall every bucket is due once; skipped ticks alias onto them */
+    if (current >= health->num_slots && health->next_slot < current - health->num_slots + 1) {
+        health->next_slot = current - health->num_slots + 1;
+    }
+
+    while (health->next_slot <= current) {
+        sensor_health_node_t *node = *bucket_of(health, health->next_slot);
+
+        while (node && count < max) {
+            sensor_health_node_t *next = node->next;
+            uint64_t slot = atomic_load_explicit(&node->slot, memory_order_relaxed);
+            if (slot <= current) {
+                node_unlink(health, node, slot);
+                nodes[count++] = node;
+            }
+            node = next;
+        }
+
+        if (node) {
+            /* Output full; resume this bucket on the next call */
+            break;
+        }
+        health->next_slot++;
+    }
+
+    pthread_mutex_unlock(&health->lock);
+    return count;
+}
+
+size_t sensor_health_tracked(sensor_health_t *health) {
+    if (!health) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&health->lock);
+    size_t tracked = health->tracked;
+    pthread_mutex_unlock(&health->lock);
+
+    return tracked;
+}
@@ -0,0 +1,516 @@
+/**
+ * @file sensor_kernels.c
+ * @brief Batch statistics kernels with runtime CPU dispatch
+ * @details Each kernel makes two passes over a batch: sum/min/max/crossings,
+ *          then the sum of squared deviations from the batch mean. Batches
+ *          are combined with Chan's parallel variance update, which keeps
+ *          the variance accurate over long ranges where sum-of-squares
+ *          would cancel. x86 kernels are compiled with target attributes so
+ *          the rest of the build keeps the baseline instruction set.
+ */
+
+#include "sensor_manager/sensor_kernels.h"
+#include <math.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Narrow readings are widened in chunks that stay in L1 */
+#define KERNEL_CHUNK 512
+
+/* Result of the first pass over a batch */
+typedef struct {
+    double sum;
+    double min;
+    double max;
+    uint64_t crossings;
+} kernel_pass_t;
+
+/* Kernel entry points (n >= 1) */
+typedef struct {
+    void (*summarize)(const double *v, size_t n, double threshold, kernel_pass_t *out);
+    double (*sqdev)(const double *v, size_t n, double mean);
+} kernel_ops_t;
+
+/* ============================================================================
+ * SCALAR KERNEL
+ * ========================================================================= */
+
+/**
+ * @brief Finish a batch from index i (shared by the vector kernels' tails)
+ */
+static void scalar_summarize_from(const double *v, size_t i, size_t n, double threshold,
+                                  bool above, kernel_pass_t *out) {
+    for (; i < n; i++) {
+        double x = v[i];
+        bool a = x >= threshold;
+
+        out->sum += x;
+        if (x < out->min) {
+            out->min = x;
+        }
+        if (x > out->max) {
+            out->max = x;
+        }
+        out->crossings += a != above;
+        above = a;
+    }
+}
+
+static void scalar_summarize(const double *v, size_t n, double threshold, kernel_pass_t *out) {
+    out->sum = 0.0;
+    out->min = v[0];
+    out->max = v[0];
+    out->crossings = 0;
+    scalar_summarize_from(v, 0, n, threshold, v[0] >= threshold, out);
+}
+
+static double scalar_sqdev(const double *v, size_t n, double mean) {
+    double acc = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = v[i] - mean;
+        acc += d * d;
+    }
+    return acc;
+}
+
+static const kernel_ops_t scalar_ops = { scalar_summarize, scalar_sqdev };
+
+/* ============================================================================
+ * X86 KERNELS
+ * ========================================================================= */
+
+#ifdef KERNELS_X86
+
+__attribute__((target("avx2,popcnt")))
+static void avx2_summarize(const double *v, size_t n, double threshold, kernel_pass_t *out) {
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d vmin = _mm256_set1_pd(v[0]);
+    __m256d vmax = vmin;
+    __m256d vt = _mm256_set1_pd(threshold);
+    unsigned carry = v[0] >= threshold;
+    uint64_t crossings = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256d a = _mm256_loadu_pd(v + i);
+        __m256d b = _mm256_loadu_pd(v + i + 4);
+
+        sum0 = _mm256_add_pd(sum0, a);
+        sum1 = _mm256_add_pd(sum1, b);
+        vmin = _mm256_min_pd(vmin, _mm256_min_pd(a, b));
+        vmax = _mm256_max_pd(vmax, _mm256_max_pd(a, b));
+
+        /* Bit k is reading i+k >= threshold; compare with the bit before it */
+        unsigned bits = (unsigned)_mm256_movemask_pd(_mm256_cmp_pd(a, vt, _CMP_GE_OQ)) |
+                        (unsigned)_mm256_movemask_pd(_mm256_cmp_pd(b, vt, _CMP_GE_OQ)) << 4;
+        crossings += (uint64_t)__builtin_popcount(bits ^ (((bits << 1) | carry) & 0xFFu));
+        carry = bits >> 7;
+    }
+
+    double lanes[4];
+    double mins[4];
+    double maxs[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(sum0, sum1));
+    _mm256_storeu_pd(mins, vmin);
+    _mm256_storeu_pd(maxs, vmax);
+
+    out->sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    out->min = mins[0];
+    out->max = maxs[0];
+    for (int k = 1; k < 4; k++) {
+        out->min = mins[k] < out->min ? mins[k] : out->min;
+        out->max = maxs[k] > out->max ? maxs[k] : out->max;
+    }
+    out->crossings = crossings;
+
+    scalar_summarize_from(v, i, n, threshold, carry != 0, out);
+}
+
+__attribute__((target("avx2")))
+static double avx2_sqdev(const double *v, size_t n, double mean) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d vmean = _mm256_set1_pd(mean);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256d a = _mm256_sub_pd(_mm256_loadu_pd(v + i), vmean);
+        __m256d b = _mm256_sub_pd(_mm256_loadu_pd(v + i + 4), vmean);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(a, a));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(b, b));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    double acc = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (; i < n; i++) {
+        double d = v[i] - mean;
+        acc += d * d;
+    }
+    return acc;
+}
+
+static const kernel_ops_t avx2_ops = { avx2_summarize, avx2_sqdev };
+
+__attribute__((target("sse4.2,popcnt")))
+static void sse42_summarize(const double *v, size_t n, double threshold, kernel_pass_t *out) {
+    __m128d sum0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd();
+    __m128d vmin = _mm_set1_pd(v[0]);
+    __m128d vmax = vmin;
+    __m128d vt = _mm_set1_pd(threshold);
+    unsigned carry = v[0] >= threshold;
+    uint64_t crossings = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128d a = _mm_loadu_pd(v + i);
+        __m128d b = _mm_loadu_pd(v + i + 2);
+
+        sum0 = _mm_add_pd(sum0, a);
+        sum1 = _mm_add_pd(sum1, b);
+        vmin = _mm_min_pd(vmin, _mm_min_pd(a, b));
+        vmax = _mm_max_pd(vmax, _mm_max_pd(a, b));
+
+        unsigned bits = (unsigned)_mm_movemask_pd(_mm_cmpge_pd(a, vt)) |
+                        (unsigned)_mm_movemask_pd(_mm_cmpge_pd(b, vt)) << 2;
+        crossings += (uint64_t)__builtin_popcount(bits ^ (((bits << 1) | carry) & 0xFu));
+        carry = bits >> 3;
+    }
+
+    double lanes[2];
+    double mins[2];
+    double maxs[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+    _mm_storeu_pd(mins, vmin);
+    _mm_storeu_pd(maxs, vmax);
+
+    out->sum = lanes[0] + lanes[1];
+    out->min = mins[1] < mins[0] ? mins[1] : mins[0];
+    out->max = maxs[1] > maxs[0] ? maxs[1] : maxs[0];
+    out->crossings = crossings;
+
+    scalar_summarize_from(v, i, n, threshold, carry != 0, out);
+}
+
+__attribute__((target("sse4.2")))
+static double sse42_sqdev(const double *v, size_t n, double mean) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    __m128d vmean = _mm_set1_pd(mean);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        __m128d a = _mm_sub_pd(_mm_loadu_pd(v + i), vmean);
+        __m128d b = _mm_sub_pd(_mm_loadu_pd(v + i + 2), vmean);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(a, a));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(b, b));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    double acc = lanes[0] + lanes[1];
+
+    for (; i < n; i++) {
+        double d = v[i] - mean;
+        acc += d * d;
+    }
+    return acc;
+}
+
+static const kernel_ops_t sse42_ops = { sse42_summarize, sse42_sqdev };
+
+#endif /* KERNELS_X86 */
+
+/* ============================================================================
+ * NEON KERNEL
+ * ========================================================================= */
+
+#ifdef KERNELS_NEON
+
+static void neon_summarize(const double *v, size_t n, double threshold, kernel_pass_t *out) {
+    float64x2_t sum0 = vdupq_n_f64(0.0);
+    float64x2_t sum1 = vdupq_n_f64(0.0);
+    float64x2_t vmin = vdupq_n_f64(v[0]);
+    float64x2_t vmax = vmin;
+    float64x2_t vt = vdupq_n_f64(threshold);
+    unsigned carry = v[0] >= threshold;
+    uint64_t crossings = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        float64x2_t a = vld1q_f64(v + i);
+        float64x2_t b = vld1q_f64(v + i + 2);
+
+        sum0 = vaddq_f64(sum0, a);
+        sum1 = vaddq_f64(sum1, b);
+        vmin = vminq_f64(vmin, vminq_f64(a, b));
+        vmax = vmaxq_f64(vmax, vmaxq_f64(a, b));
+
+        uint64x2_t ma = vcgeq_f64(a, vt);
+        uint64x2_t mb = vcgeq_f64(b, vt);
+        unsigned bits = (unsigned)(vgetq_lane_u64(ma, 0) & 1) |
+                        (unsigned)(vgetq_lane_u64(ma, 1) & 1) << 1 |
+                        (unsigned)(vgetq_lane_u64(mb, 0) & 1) << 2 |
+                        (unsigned)(vgetq_lane_u64(mb, 1) & 1) << 3;
+        crossings += (uint64_t)__builtin_popcount(bits ^ (((bits << 1) | carry) & 0xFu));
+        carry = bits >> 3;
+    }
+
+    out->sum = vaddvq_f64(vaddq_f64(sum0, sum1));
+    out->min = vminvq_f64(vmin);
+    out->max = vmaxvq_f64(vmax);
+    out->crossings = crossings;
+
+    scalar_summarize_from(v, i, n, threshold, carry != 0, out);
+}
+
+static double neon_sqdev(const double *v, size_t n, double mean) {
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    float64x2_t vmean = vdupq_n_f64(mean);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        float64x2_t a = vsubq_f64(vld1q_f64(v + i), vmean);
+        float64x2_t b = vsubq_f64(vld1q_f64(v + i + 2), vmean);
+        acc0 = vaddq_f64(acc0, vmulq_f64(a, a));
+        acc1 = vaddq_f64(acc1, vmulq_f64(b, b));
+    }
+
+    double acc = vaddvq_f64(vaddq_f64(acc0, acc1));
+    for (; i < n; i++) {
+        double d = v[i] - mean;
+        acc += d * d;
+    }
+    return acc;
+}
+
+static const kernel_ops_t neon_ops = { neon_summarize, neon_sqdev };
+
+#endif /* KERNELS_NEON */
+
+/* ============================================================================
+ * DISPATCH
+ * ========================================================================= */
+
+/* Selected kernel, -1 until first use */
+static atomic_int active_isa = -1;
+
+static const kernel_ops_t *kernel_ops_for(sensor_kernel_isa_t isa) {
+    switch (isa) {
+    case SENSOR_KERNEL_SCALAR:
+        return &scalar_ops;
+#ifdef KERNELS_X86
+    case SENSOR_KERNEL_AVX2:
+        return &avx2_ops;
+    case SENSOR_KERNEL_SSE42:
+        return &sse42_ops;
+#endif
+#ifdef KERNELS_NEON
+    case SENSOR_KERNEL_NEON:
+        return &neon_ops;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+bool sensor_kernels_supported(sensor_kernel_isa_t isa) {
+    if (!kernel_ops_for(isa)) {
+        return false;
+    }
+
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (isa == SENSOR_KERNEL_AVX2) {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    }
+    if (isa == SENSOR_KERNEL_SSE42) {
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+    }
+#endif
+    return true;
+}
+
+sensor_kernel_isa_t sensor_kernels_active(void) {
+    int isa = atomic_load_explicit(&active_isa, memory_order_relaxed);
+    if (isa >= 0) {
+        return (sensor_kernel_isa_t)isa;
+    }
+
+    /* Detection is idempotent, so racing first callers agree */
+    static const sensor_kernel_isa_t preference[] = {
+        SENSOR_KERNEL_AVX2, SENSOR_KERNEL_NEON, SENSOR_KERNEL_SSE42
+    };
+    isa = SENSOR_KERNEL_SCALAR;
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        if (sensor_kernels_supported(preference[i])) {
+            isa = (int)preference[i];
+            break;
+        }
+    }
+
+    atomic_store_explicit(&active_isa, isa, memory_order_relaxed);
+    return (sensor_kernel_isa_t)isa;
+}
+
+paumiot_result_t sensor_kernels_select(sensor_kernel_isa_t isa) {
+    if (!sensor_kernels_supported(isa)) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+
+    atomic_store_explicit(&active_isa, (int)isa, memory_order_relaxed);
+    return PAUMIOT_SUCCESS;
+}
+
+const char *sensor_kernels_isa_name(sensor_kernel_isa_t isa) {
+    switch (isa) {
+    case SENSOR_KERNEL_SCALAR: return "scalar";
+    case SENSOR_KERNEL_SSE42:  return "sse4.2";
+    case SENSOR_KERNEL_AVX2:   return "avx2";
+    case SENSOR_KERNEL_NEON:   return "neon";
+    default:                   return "unknown";
+    }
+}
+
+/* ============================================================================
+ * BATCH STATISTICS API
+ * ========================================================================= */
+
+void sensor_batch_stats_init(sensor_batch_stats_t *stats, double threshold) {
+    if (!stats) {
+        return;
+    }
+
+    stats->count = 0;
+    stats->sum = 0.0;
+    stats->min = INFINITY;
+    stats->max = -INFINITY;
+    stats->m2 = 0.0;
+    stats->first = 0.0;
+    stats->last = 0.0;
+    stats->threshold = threshold;
+    stats->crossings = 0;
+}
+
+void sensor_batch_stats_merge(sensor_batch_stats_t *dst, const sensor_batch_stats_t *src) {
+    if (!dst || !src || src->count == 0) {
+        return;
+    }
+
+    if (dst->count == 0) {
+        double threshold = dst->threshold;
+        *dst = *src;
+        dst->threshold = threshold;
+        return;
+    }
+
+    double na = (double)dst->count;
+    double nb = (double)src->count;
+    double delta = src->sum / nb - dst->sum / na;
+
+    dst->m2 += src->m2 + delta * delta * na * nb / (na + nb);
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->crossings += src->crossings +
+                      ((dst->last >= dst->threshold) != (src->first >= dst->threshold));
+    dst->last = src->last;
+}
+
+/**
+ * @brief Fold one batch of doubles using the active kernel
+ */
+static void batch_stats_fold(sensor_batch_stats_t *stats, const kernel_ops_t *ops,
+                             const double *values, size_t count) {
+    kernel_pass_t pass;
+    ops->summarize(values, count, stats->threshold, &pass);
+
+    sensor_batch_stats_t batch = {
+        .count = count,
+        .sum = pass.sum,
+        .min = pass.min,
+        .max = pass.max,
+        .m2 = ops->sqdev(values, count, pass.sum / (double)count),
+        .first = values[0],
+        .last = values[count - 1],
+        .threshold = stats->threshold,
+        .crossings = pass.crossings
+    };
+
+    sensor_batch_stats_merge(stats, &batch);
+}
+
+void sensor_batch_stats_add_f64(sensor_batch_stats_t *stats, const double *values,
+                                size_t count) {
+    if (!stats || !values || count == 0) {
+        return;
+    }
+
+    batch_stats_fold(stats, kernel_ops_for(sensor_kernels_active()), values, count);
+}
+
+void sensor_batch_stats_add_f32(sensor_batch_stats_t *stats, const float *values,
+                                size_t count) {
+    if (!stats || !values || count == 0) {
+        return;
+    }
+
+    const kernel_ops_t *ops = kernel_ops_for(sensor_kernels_active());
+    double chunk[KERNEL_CHUNK];
+
+    for (size_t i = 0; i < count; i += KERNEL_CHUNK) {
+        size_t n = count - i < KERNEL_CHUNK ? count - i : KERNEL_CHUNK;
+        for (size_t k = 0; k < n; k++) {
+            chunk[k] = values[i + k];
+        }
+        batch_stats_fold(stats, ops, chunk, n);
+    }
+}
+
+void sensor_batch_stats_add_i32(sensor_batch_stats_t *stats, const int32_t *values,
+                                size_t count) {
+    if (!stats || !values || count == 0) {
+        return;
+    }
+
+    const kernel_ops_t *ops = kernel_ops_for(sensor_kernels_active());
+    double chunk[KERNEL_CHUNK];
+
+    for (size_t i = 0; i < count; i += KERNEL_CHUNK) {
+        size_t n = count - i < KERNEL_CHUNK ? count - i : KERNEL_CHUNK;
+        for (size_t k = 0; k < n; k++) {
+            chunk[k] = values[i + k];
+        }
+        batch_stats_fold(stats, ops, chunk, n);
+    }
+}
+
+double sensor_batch_stats_mean(const sensor_batch_stats_t *stats) {
+    if (!stats || stats->count == 0) {
+        return NAN;
+    }
+    return stats->sum / (double)stats->count;
+}
+
+double sensor_batch_stats_variance(const sensor_batch_stats_t *stats) {
+    if (!stats || stats->count == 0) {
+        return NAN;
+    }
+    return stats->m2 / (double)stats->count;
+}
@@ -0,0 +1,1884 @@
+/**
+ * @file sensor_manager.c
+ * @brief Sensor Manager - registry, last-value storage and subscriptions
+ * @details The registry is the authoritative store for each sensor's last
+ *          reading. When caching is enabled, reads are served lock-free from
+ *          the sensor cache and only fall back to the registry on a miss.
+ *          Data subscribers are an immutable array swapped under RCU, so
+ *          dispatching an update is a pointer load and a scan. Readings on
+ *          a topic with a codec route are converted and compressed once,
+ *          into pooled buffers, before the scan. Event counts
+ *          are per-thread metrics counters, summed only when read or scraped.
+ */
+
+#include "sensor_manager/sensor_manager.h"
+#include "sensor_manager/sensor_cache.h"
+#include "sensor_manager/sensor_tsdb.h"
+#include "sensor_manager/sensor_aggregator.h"
+#include "sensor_manager/sensor_kernels.h"
+#include "sensor_manager/sensor_health.h"
+#include "sensor_manager/sensor_codec.h"
+#include "sensor_manager/sensor_compress.h"
+#include "sensor_manager_internal.h"
+#include "sensor_dispatch.h"
+#include "logging.h"
+#include "metrics.h"
+#include "time_utils.h"
+#include "rcu.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/* Registry sizing */
+#define REGISTRY_INITIAL_BUCKETS 1024
+#define REGISTRY_MAX_LOAD 2
+
+/* Longest text payload scanned for a numeric historical value */
+#define HISTORICAL_TEXT_MAX 256
+
+/* Upper bound on the wait between flushes of idle aggregation windows */
+#define AGGREGATE_FLUSH_MS 1000
+
+/* Expired sensors handled per pass of the health check */
+#define HEALTH_BATCH_SIZE 256
+
+/* Pooled buffers for route encoding (two per delivery at most) */
+#define ENCODE_BUFFERS 16
+
+/* Registry Record */
+typedef struct sensor_record {
+    sensor_entry_t entry;           /* Owned copy of the registered entry */
+    uint32_t hash;                  /* Hash of entry.sensor_id */
+    pthread_mutex_t data_lock;      /* Guards status and last reading */
+    sensor_data_t last;             /* Last reading (sensor_id borrowed from entry) */
+    size_t payload_capacity;        /* Allocated size of last.payload */
+    bool has_data;                  /* A reading has been stored */
+    atomic_uint_fast64_t seen_ms;   /* Last activity (monotonic ms) */
+    sensor_health_node_t health;    /* Offline deadline */
+    struct sensor_record *next;     /* Hash chain */
+} sensor_record_t;
+
+/* Data Subscriber */
+typedef struct {
+    char *sensor_id;                /* Sensor filter (NULL = all sensors), shared by all versions */
+    uint32_t hash;                  /* Hash of sensor_id */
+    sensor_data_callback_t callback;
+    void *user_data;
+    atomic_uint flags;              /* sensor_subscribe_flags_t */
+} data_subscriber_t;
+
+/* Published data subscribers (immutable once published) */
+typedef struct {
+    size_t count;
+    data_subscriber_t entries[];
+} data_subscriber_set_t;
+
+/* Status Subscription */
+typedef struct status_subscription {
+    char *sensor_id;                /* Sensor filter (NULL = all sensors) */
+    sensor_status_callback_t callback;
+    void *user_data;
+    struct status_subscription *next;
+} status_subscription_t;
+
+/* Aggregate Subscription */
+typedef struct aggregate_subscription {
+    char *sensor_id;                /* Sensor filter (NULL = all sensors) */
+    sensor_aggregate_callback_t callback;
+    void *user_data;
+    struct aggregate_subscription *next;
+} aggregate_subscription_t;
+
+/* Sensor Manager */
+struct sensor_manager {
+    sensor_manager_config_t config; /* Configuration (storage_path, dispatch_cpus owned) */
+    bool running;                   /* Background tasks started */
+
+    /* Registry */
+    pthread_rwlock_t registry_lock; /* Guards buckets and chain membership */
+    sensor_record_t **buckets;      /* Hash buckets */
+    size_t bucket_count;            /* Number of buckets (power of 2) */
+    size_t sensor_count;            /* Registered sensors */
+
+    /* Last-value cache (NULL when disabled) */
+    sensor_cache_t *cache;
+
+    /* Historical store (NULL when disabled) */
+    sensor_tsdb_t *tsdb;
+
+    /* Windowed aggregation (NULL when disabled) */
+    sensor_aggregator_t *aggregator;
+
+    /* Offline detection (NULL when disabled) */
+    sensor_health_t *health;
+
+    /* Background health checks and window flushes */
+    pthread_t timer_thread;
+    pthread_mutex_t timer_lock;     /* Guards timer_stop */
+    pthread_cond_t timer_cond;
+    bool timer_stop;
+
+    /* Data subscriptions */
+    _Atomic(data_subscriber_set_t *) data_subscribers;
+    pthread_mutex_t data_subscribe_lock;    /* Serialises replacing the set */
+    rcu_domain_t data_rcu;
+    _Atomic(sensor_dispatch_t *) dispatch;  /* Deferred callbacks (NULL until needed) */
+
+    /* Delivery encoding (NULL without routes) */
+    sensor_compressor_t *compressor;
+    atomic_bool compress;           /* enable_compression, reloadable */
+
+    /* Subscriptions */
+    pthread_rwlock_t subscriber_lock;
+    status_subscription_t *status_subscribers;
+    aggregate_subscription_t *aggregate_subscribers;
+
+    /* Statistics */
+    atomic_uint_fast64_t registered_sensors;    /* Mirrors sensor_count for scrapes */
+    atomic_uint_fast64_t online_sensors;
+    atomic_uint_fast64_t offline_sensors;
+    metrics_registry_t *metrics;
+    bool owns_metrics;
+    metrics_counter_t *data_updates;
+    metrics_counter_t *cache_hits;
+    metrics_counter_t *cache_misses;
+    metrics_counter_t *health_checks;
+    metrics_counter_t *deferred_callbacks;
+    metrics_counter_t *deferred_dropped;
+    metrics_counter_t *payloads_encoded;
+    metrics_counter_t *encode_failures;
+    metrics_histogram_t *callback_duration;     /* Timed inline callbacks, us */
+};
+
+/* Counters registered by each manager */
+static const struct {
+    const char *name;
+    const char *help;
+    size_t offset;
+} counter_metrics[] = {
+    { "paumiot_sensor_data_updates_total", "Sensor readings stored",
+      offsetof(sensor_manager_t, data_updates) },
+    { "paumiot_sensor_cache_hits_total", "Sensor reads served from the cache",
+      offsetof(sensor_manager_t, cache_hits) },
+    { "paumiot_sensor_cache_misses_total", "Sensor reads that missed the cache",
+      offsetof(sensor_manager_t, cache_misses) },
+    { "paumiot_sensor_health_checks_total", "Offline detection passes",
+      offsetof(sensor_manager_t, health_checks) },
+    { "paumiot_sensor_deferred_callbacks_total", "Data callbacks queued to dispatch workers",
+      offsetof(sensor_manager_t, deferred_callbacks) },
+    { "paumiot_sensor_deferred_dropped_total", "Deferred data callbacks lost to full queues",
+      offsetof(sensor_manager_t, deferred_dropped) },
+    { "paumiot_sensor_payloads_encoded_total", "Deliveries transcoded or compressed for a route",
+      offsetof(sensor_manager_t, payloads_encoded) },
+    { "paumiot_sensor_encode_failures_total",
+      "Deliveries sent as published because route encoding failed",
+      offsetof(sensor_manager_t, encode_failures) },
+};
+
+#define CALLBACK_DURATION_METRIC "paumiot_sensor_callback_duration_seconds"
+
+/* Upper bounds of the callback duration histogram (us) */
+static const uint64_t callback_duration_bounds[] = {
+    10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000, 500000
+};
+
+/* Pending status notification */
+typedef struct {
+    char *sensor_id;
+    sensor_status_t old_status;
+    sensor_status_t new_status;
+} status_transition_t;
+
+/* ============================================================================
+ * INTERNAL HELPERS
+ * ========================================================================= */
+
+static char *str_dup_or_null(const char *s) {
+    return s ? strdup(s) : NULL;
+}
+
+/**
+ * @brief Deep copy a sensor entry (strings duplicated, metadata borrowed)
+ */
+static paumiot_result_t sensor_entry_copy(sensor_entry_t *dst, const sensor_entry_t *src) {
+    memset(dst, 0, sizeof(*dst));
+
+    dst->sensor_id = str_dup_or_null(src->sensor_id);
+    dst->name = str_dup_or_null(src->name);
+    dst->topic_pattern = str_dup_or_null(src->topic_pattern);
+    dst->location = str_dup_or_null(src->location);
+
+    if ((src->sensor_id && !dst->sensor_id) || (src->name && !dst->name) ||
+        (src->topic_pattern && !dst->topic_pattern) ||
+        (src->location && !dst->location)) {
+        sensor_entry_free(dst);
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    dst->type = src->type;
+    dst->status = src->status;
+    dst->capabilities = src->capabilities;
+    dst->last_update_ts = src->last_update_ts;
+    dst->metadata = src->metadata;
+
+    return PAUMIOT_SUCCESS;
+}
+
+/**
+ * @brief Allocate a standalone copy of sensor data
+ */
+static sensor_data_t *sensor_data_dup(const sensor_data_t *src) {
+    sensor_data_t *dst = calloc(1, sizeof(sensor_data_t));
+    if (!dst) {
+        return NULL;
+    }
+
+    dst->sensor_id = str_dup_or_null(src->sensor_id);
+    dst->topic = str_dup_or_null(src->topic);
+    if (src->payload_len > 0) {
+        dst->payload = malloc(src->payload_len);
+        if (dst->payload) {
+            memcpy(dst->payload, src->payload, src->payload_len);
+        }
+    }
+
+    if ((src->sensor_id && !dst->sensor_id) || (src->topic && !dst->topic) ||
+        (src->payload_len > 0 && !dst->payload)) {
+        sensor_data_free(dst);
+        return NULL;
+    }
+
+    dst->payload_len = src->payload_len;
+    dst->format = src->format;
+    dst->timestamp = src->timestamp;
+    dst->qos = src->qos;
+    dst->compressed = src->compressed;
+
+    return dst;
+}
+
+/**
+ * @brief Allocate sensor data from a cache snapshot
+ */
+static sensor_data_t *sensor_data_from_cache(const sensor_cache_value_t *value) {
+    sensor_data_t view = {
+        .sensor_id = (char *)value->sensor_id,
+        .topic = value->topic[0] ? (char *)value->topic : NULL,
+        .payload = (uint8_t *)value->payload,
+        .payload_len = value->payload_len,
+        .format = value->format,
+        .timestamp = value->timestamp,
+        .qos = value->qos
+    };
+
+    return sensor_data_dup(&view);
+}
+
+/**
+ * @brief Extract the numeric value fed to history and aggregation
+ * @details RAW payloads of 4 or 8 bytes are native float/double. JSON and
+ *          other RAW payloads use the "value" member if present, otherwise
+ *          the leading number of the payload (e.g. "21.5"). Non-finite
+ *          values are not recorded.
+ */
+static bool sensor_data_numeric_value(const sensor_data_t *data, double *value) {
+    if (data->payload_len == 0) {
+        return false;
+    }
+
+    if (data->format == DATA_FORMAT_RAW) {
+        if (data->payload_len == sizeof(double)) {
+            memcpy(value, data->payload, sizeof(double));
+            return isfinite(*value);
+        }
+        if (data->payload_len == sizeof(float)) {
+            float f;
+            memcpy(&f, data->payload, sizeof(float));
+            *value = f;
+            return isfinite(*value);
+        }
+    } else if (data->format != DATA_FORMAT_JSON) {
+        return false;
+    }
+
+    char text[HISTORICAL_TEXT_MAX];
+    size_t len = data->payload_len < sizeof(text) - 1 ? data->payload_len : sizeof(text) - 1;
+    memcpy(text, data->payload, len);
+    text[len] = '\0';
+
+    const char *p = strstr(text, "\"value\"");
+    if (p) {
+        p = strchr(p + 7, ':');
+        if (!p) {
+            return false;
+        }
+        p++;
+    } else {
+        p = text;
+    }
+
+    char *end;
+    double v = strtod(p, &end);
+    if (end == p || !isfinite(v)) {
+        return false;
+    }
+
+    *value = v;
+    return true;
+}
+
+/**
+ * @brief Store a reading in a record (caller holds record->data_lock)
+ * @details The payload buffer is reused across updates and only grows.
+ */
+static paumiot_result_t record_store_data(sensor_record_t *record, const sensor_data_t *data) {
+    if (data->payload_len > record->payload_capacity) {
+        uint8_t *payload = realloc(record->last.payload, data->payload_len);
+        if (!payload) {
+            return PAUMIOT_ERROR_OUT_OF_MEMORY;
+        }
+        record->last.payload = payload;
+        record->payload_capacity = data->payload_len;
+    }
+
+    if (!data->topic) {
+        free(record->last.topic);
+        record->last.topic = NULL;
+    } else if (!record->last.topic || strcmp(record->last.topic, data->topic) != 0) {
+        char *topic = strdup(data->topic);
+        if (!topic) {
+            return PAUMIOT_ERROR_OUT_OF_MEMORY;
+        }
+        free(record->last.topic);
+        record->last.topic = topic;
+    }
+
+    if (data->payload_len > 0) {
+        memcpy(record->last.payload, data->payload, data->payload_len);
+    }
+    record->last.payload_len = data->payload_len;
+    record->last.format = data->format;
+    record->last.timestamp = data->timestamp ? data->timestamp : time_realtime_ms();
+    record->last.qos = data->qos;
+    record->has_data = true;
+
+    record->entry.last_update_ts = record->last.timestamp;
+
+    return PAUMIOT_SUCCESS;
+}
+
+static void record_free(sensor_record_t *record) {
+    if (!record) {
+        return;
+    }
+
+    pthread_mutex_destroy(&record->data_lock);
+    free(record->last.topic);
+    free(record->last.payload);
+    sensor_entry_free(&record->entry);
+    free(record);
+}
+
+/**
+ * @brief Find a record (caller holds registry_lock)
+ */
+static sensor_record_t *registry_find(const sensor_manager_t *sm, const char *sensor_id) {
+    uint32_t hash = sensor_id_hash(sensor_id, NULL);
+    sensor_record_t *record = sm->buckets[hash & (sm->bucket_count - 1)];
+
+    while (record) {
+        if (record->hash == hash && strcmp(record->entry.sensor_id, sensor_id) == 0) {
+            return record;
+        }
+        record = record->next;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Double the bucket array (caller holds registry_lock for writing)
+ */
+static void registry_grow(sensor_manager_t *sm) {
+    size_t new_count = sm->bucket_count * 2;
+    sensor_record_t **buckets = calloc(new_count, sizeof(sensor_record_t *));
+    if (!buckets) {
+        /* Keep the longer chains; correctness is unaffected */
+        return;
+    }
+
+    for (size_t i = 0; i < sm->bucket_count; i++) {
+        sensor_record_t *record = sm->buckets[i];
+        while (record) {
+            sensor_record_t *next = record->next;
+            size_t b = record->hash & (new_count - 1);
+            record->next = buckets[b];
+            buckets[b] = record;
+            record = next;
+        }
+    }
+
+    free(sm->buckets);
+    sm->buckets = buckets;
+    sm->bucket_count = new_count;
+}
+
+static void status_counters_update(sensor_manager_t *sm, sensor_status_t old_status,
+                                   sensor_status_t new_status) {
+    if (old_status == SENSOR_STATUS_ONLINE) {
+        atomic_fetch_sub(&sm->online_sensors, 1);
+    } else if (old_status == SENSOR_STATUS_OFFLINE) {
+        atomic_fetch_sub(&sm->offline_sensors, 1);
+    }
+
+    if (new_status == SENSOR_STATUS_ONLINE) {
+        atomic_fetch_add(&sm->online_sensors, 1);
+    } else if (new_status == SENSOR_STATUS_OFFLINE) {
+        atomic_fetch_add(&sm->offline_sensors, 1);
+    }
+}
+
+/**
+ * @brief Queue a data callback on the dispatch pool
+ * @param shared Copy of the reading, made on first use and shared by the
+ *        remaining deferred subscribers of this update
+ */
+static void dispatch_deferred(sensor_manager_t *sm, const data_subscriber_t *sub,
+                              const sensor_data_t *data, uint32_t hash,
+                              sensor_dispatch_data_t **shared) {
+    sensor_dispatch_t *dispatch = atomic_load_explicit(&sm->dispatch, memory_order_acquire);
+
+    if (!*shared) {
+        *shared = sensor_dispatch_data_create(sensor_data_dup(data));
+    }
+
+    if (*shared &&
+        sensor_dispatch_submit(dispatch, hash, sub->callback, sub->user_data,
+                               *shared) == PAUMIOT_SUCCESS) {
+        metrics_counter_inc(sm->deferred_callbacks);
+    } else {
+        metrics_counter_inc(sm->deferred_dropped);
+    }
+}
+
+/**
+ * @brief Encode a reading for its topic's route
+ * @details Converts the payload to the route's format, then compresses it
+ *          if compression is enabled. If either step fails the reading is
+ *          delivered as published.
+ * @param out Receives the reading to deliver
+ * @param buffers Receives the pooled buffers behind out->payload (release
+ *        with sensor_compressor_release)
+ */
+static void encode_for_route(sensor_manager_t *sm, const sensor_data_t *data,
+                             sensor_data_t *out, uint8_t *buffers[2]) {
+    sensor_codec_route_t route;
+
+    *out = *data;
+    buffers[0] = buffers[1] = NULL;
+
+    if (!sm->compressor || !data->topic ||
+        !sensor_codec_routes_lookup(sm->config.routes, data->topic, &route)) {
+        return;
+    }
+
+    bool compress = route.compression != SENSOR_COMPRESSION_NONE &&
+                    atomic_load_explicit(&sm->compress, memory_order_relaxed);
+    if (route.format == data->format && !compress) {
+        return;
+    }
+
+    if (route.format != data->format) {
+        size_t capacity;
+        size_t len;
+        buffers[0] = sensor_compressor_acquire(sm->compressor, &capacity);
+        if (!buffers[0] ||
+            sensor_codec_transcode(data->format, route.format, data->payload, data->payload_len,
+                                   buffers[0], capacity, &len) != PAUMIOT_SUCCESS) {
+            sensor_compressor_release(sm->compressor, buffers[0]);
+            buffers[0] = NULL;
+            metrics_counter_inc(sm->encode_failures);
+            return;
+        }
+        out->payload = buffers[0];
+        out->payload_len = len;
+        out->format = route.format;
+    }
+
+    if (compress) {
+        size_t frame_len;
+        if (sensor_compressor_compress(sm->compressor, route.compression, route.dict,
+                                       out->payload, out->payload_len, &buffers[1],
+                                       &frame_len) != PAUMIOT_SUCCESS) {
+            sensor_compressor_release(sm->compressor, buffers[0]);
+            buffers[0] = buffers[1] = NULL;
+            *out = *data;
+            metrics_counter_inc(sm->encode_failures);
+            return;
+        }
+        out->payload = buffers[1];
+        out->payload_len = frame_len;
+        out->compressed = true;
+    }
+
+    metrics_counter_inc(sm->payloads_encoded);
+}
+
+/**
+ * @brief Invoke data subscribers (no registry lock held)
+ * @note Inline callbacks must not subscribe from within the callback; the
+ *       writer would wait for the grace period the callback is holding open.
+ */
+static void dispatch_data(sensor_manager_t *sm, const sensor_data_t *published,
+                          uint32_t hash) {
+    unsigned token = rcu_read_lock(&sm->data_rcu);
+    data_subscriber_set_t *set = atomic_load(&sm->data_subscribers);
+    sensor_dispatch_data_t *shared = NULL;
+    uint64_t slow_ns = (uint64_t)sm->config.slow_callback_us * 1000;
+    sensor_data_t encoded;
+    const sensor_data_t *data = published;
+    uint8_t *buffers[2] = { NULL, NULL };
+    bool encoding = sm->compressor != NULL;
+
+    for (size_t i = 0; set && i < set->count; i++) {
+        data_subscriber_t *sub = &set->entries[i];
+
+        if (sub->sensor_id &&
+            (sub->hash != hash || strcmp(sub->sensor_id, data->sensor_id) != 0)) {
+            continue;
+        }
+
+        /* Encode once, for the first subscriber that receives the reading */
+        if (encoding) {
+            encode_for_route(sm, published, &encoded, buffers);
+            data = &encoded;
+            encoding = false;
+        }
+
+        if (atomic_load_explicit(&sub->flags, memory_order_relaxed) & SENSOR_SUBSCRIBE_DEFERRED) {
+            dispatch_deferred(sm, sub, data, hash, &shared);
+            continue;
+        }
+
+        if (slow_ns == 0) {
+            sub->callback(data->sensor_id, data, sub->user_data);
+            continue;
+        }
+
+        uint64_t start = time_monotonic_ns();
+        sub->callback(data->sensor_id, data, sub->user_data);
+        uint64_t elapsed = time_monotonic_ns() - start;
+        metrics_histogram_observe(sm->callback_duration, elapsed / 1000);
+
+        if (elapsed > slow_ns) {
+            atomic_fetch_or_explicit(&sub->flags, SENSOR_SUBSCRIBE_DEFERRED, memory_order_relaxed);
+            LOG_WARN("Data callback for %s took %llu us; deferring it to dispatch workers",
+                     sub->sensor_id ? sub->sensor_id : "all sensors",
+                     (unsigned long long)(elapsed / 1000));
+        }
+    }
+
+    rcu_read_unlock(&sm->data_rcu, token);
+    sensor_dispatch_data_release(shared);
+    sensor_compressor_release(sm->compressor, buffers[0]);
+    sensor_compressor_release(sm->compressor, buffers[1]);
+}
+
+/**
+ * @brief Invoke status subscribers (no registry lock held)
+ */
+static void dispatch_status(sensor_manager_t *sm, const char *sensor_id,
+                            sensor_status_t old_status, sensor_status_t new_status) {
+    pthread_rwlock_rdlock(&sm->subscriber_lock);
+
+    for (status_subscription_t *sub = sm->status_subscribers; sub; sub = sub->next) {
+        if (!sub->sensor_id || strcmp(sub->sensor_id, sensor_id) == 0) {
+            sub->callback(sensor_id, old_status, new_status, sub->user_data);
+        }
+    }
+
+    pthread_rwlock_unlock(&sm->subscriber_lock);
+}
+
+/**
+ * @brief Invoke status subscribers for a batch of transitions (no registry lock held)
+ */
+static void dispatch_status_batch(sensor_manager_t *sm, const status_transition_t *batch,
+                                  size_t count) {
+    pthread_rwlock_rdlock(&sm->subscriber_lock);
+
+    for (status_subscription_t *sub = sm->status_subscribers; sub; sub = sub->next) {
+        for (size_t i = 0; i < count; i++) {
+            if (!sub->sensor_id || strcmp(sub->sensor_id, batch[i].sensor_id) == 0) {
+                sub->callback(batch[i].sensor_id, batch[i].old_status, batch[i].new_status,
+                              sub->user_data);
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&sm->subscriber_lock);
+}
+
+/**
+ * @brief Record activity for the offline deadline (record stays registered)
+ */
+static void record_mark_seen(sensor_manager_t *sm, sensor_record_t *record) {
+    if (!sm->health) {
+        return;
+    }
+
+    uint64_t now = time_monotonic_ms();
+    atomic_store_explicit(&record->seen_ms, now, memory_order_relaxed);
+    sensor_health_touch(sm->health, &record->health, now);
+}
+
+/**
+ * @brief Milliseconds between window flushes (the slide, at most AGGREGATE_FLUSH_MS)
+ */
+static uint64_t aggregate_flush_interval(const sensor_manager_t *sm) {
+    uint64_t slide = sm->config.aggregation_slide_ms ? sm->config.aggregation_slide_ms
+                                                     : sm->config.aggregation_window_ms;
+    return slide < AGGREGATE_FLUSH_MS ? slide : AGGREGATE_FLUSH_MS;
+}
+
+/**
+ * @brief Background loop running the health check and closing idle windows
+ * @details Windows are in event time, so they are flushed against the wall
+ *          clock less aggregation_grace_ms; a sensor that goes quiet still
+ *          emits its last window.
+ */
+static void *timer_thread_main(void *arg) {
+    sensor_manager_t *sm = (sensor_manager_t *)arg;
+
+    uint64_t now = time_monotonic_ms();
+    uint64_t next_health = sm->health ? now + sm->config.health_check_interval_ms : UINT64_MAX;
+    uint64_t next_flush = sm->aggregator ? now + aggregate_flush_interval(sm) : UINT64_MAX;
+
+    pthread_mutex_lock(&sm->timer_lock);
+    while (!sm->timer_stop) {
+        uint64_t wake = next_health < next_flush ? next_health : next_flush;
+        struct timespec deadline = {
+            .tv_sec = (time_t)(wake / 1000),
+            .tv_nsec = (long)(wake % 1000) * 1000000L
+        };
+
+        pthread_cond_timedwait(&sm->timer_cond, &sm->timer_lock, &deadline);
+        if (sm->timer_stop) {
+            break;
+        }
+
+        pthread_mutex_unlock(&sm->timer_lock);
+
+        now = time_monotonic_ms();
+        if (now >= next_health) {
+            sensor_manager_check_health(sm, now, NULL);
+            next_health = now + sm->config.health_check_interval_ms;
+        }
+        if (now >= next_flush) {
+            uint64_t wall = time_realtime_ms();
+            uint64_t grace = sm->config.aggregation_grace_ms;
+            sensor_aggregator_advance(sm->aggregator, wall > grace ? wall - grace : 0);
+            next_flush = now + aggregate_flush_interval(sm);
+        }
+
+        pthread_mutex_lock(&sm->timer_lock);
+    }
+    pthread_mutex_unlock(&sm->timer_lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Invoke aggregate subscribers (called from the aggregator)
+ */
+static void dispatch_aggregate(const sensor_aggregate_t *aggregate, void *user_data) {
+    sensor_manager_t *sm = (sensor_manager_t *)user_data;
+
+    pthread_rwlock_rdlock(&sm->subscriber_lock);
+
+    for (aggregate_subscription_t *sub = sm->aggregate_subscribers; sub; sub = sub->next) {
+        if (!sub->sensor_id || strcmp(sub->sensor_id, aggregate->sensor_id) == 0) {
+            sub->callback(aggregate, sub->user_data);
+        }
+    }
+
+    pthread_rwlock_unlock(&sm->subscriber_lock);
+}
+
+/* ============================================================================
+ * SENSOR MANAGER API
+ * ========================================================================= */
+
+void sensor_manager_config_init(sensor_manager_config_t *config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+
+    config->cache_size = 1024;
+    config->cache_ttl_ms = 300000;
+    config->enable_cache = true;
+    config->cache_memory_limit = 0;
+
+    config->enable_aggregation = false;
+    config->aggregation_window_ms = 60000;
+    config->aggregation_slide_ms = 0;
+    config->aggregation_grace_ms = 5000;
+
+    config->enable_health_monitoring = true;
+    config->health_check_interval_ms = 5000;
+    config->offline_threshold_ms = 30000;
+
+    config->enable_historical = false;
+    config->storage_path = NULL;
+    config->retention_days = 30;
+
+    config->dispatch_threads = 1;
+    config->dispatch_queue_size = 1024;
+    config->slow_callback_us = 0;
+    config->dispatch_cpus = NULL;
+
+    config->routes = NULL;
+    config->enable_compression = false;
+    config->max_payload_size = 65536;
+
+    config->metrics = NULL;
+}
+
+paumiot_result_t sensor_manager_reconfigure(sensor_manager_t *sm,
+                                            const sensor_manager_config_t *config) {
+    if (!sm || !config) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    sensor_cache_set_ttl(sm->cache, config->cache_ttl_ms);
+    atomic_store_explicit(&sm->compress, config->enable_compression, memory_order_relaxed);
+    return PAUMIOT_SUCCESS;
+}
+
+/**
+ * @brief Copy the configuration's pointed-to data so the caller can free it
+ * @details On failure, free_owned_config() releases whatever was copied.
+ */
+static bool own_config(sensor_manager_config_t *config) {
+    const char *storage_path = config->storage_path;
+    const int16_t *dispatch_cpus = config->dispatch_cpus;
+
+    config->storage_path = NULL;
+    config->dispatch_cpus = NULL;
+
+    if (storage_path) {
+        config->storage_path = strdup(storage_path);
+        if (!config->storage_path) {
+            return false;
+        }
+    }
+
+    if (dispatch_cpus && config->dispatch_threads > 0) {
+        int16_t *cpus = malloc(config->dispatch_threads * sizeof(int16_t));
+        if (!cpus) {
+            return false;
+        }
+        memcpy(cpus, dispatch_cpus, config->dispatch_threads * sizeof(int16_t));
+        config->dispatch_cpus = cpus;
+    }
+
+    return true;
+}
+
+static void free_owned_config(sensor_manager_config_t *config) {
+    free((char *)config->storage_path);
+    free((int16_t *)config->dispatch_cpus);
+}
+
+/**
+ * @brief Expose the gauges kept in the manager (runs on the scraping thread)
+ */
+static void collect_metrics(metrics_writer_t *writer, void *user_data) {
+    sensor_manager_t *sm = user_data;
+
+    metrics_write(writer, METRICS_GAUGE, "paumiot_sensors_registered", "Registered sensors",
+                  (double)atomic_load_explicit(&sm->registered_sensors, memory_order_relaxed));
+    metrics_write(writer, METRICS_GAUGE, "paumiot_sensors_online", "Sensors online",
+                  (double)atomic_load_explicit(&sm->online_sensors, memory_order_relaxed));
+    metrics_write(writer, METRICS_GAUGE, "paumiot_sensors_offline", "Sensors offline",
+                  (double)atomic_load_explicit(&sm->offline_sensors, memory_order_relaxed));
+    metrics_write(writer, METRICS_GAUGE, "paumiot_sensor_cache_memory_bytes",
+                  "Memory held by the sensor cache",
+                  (double)sensor_cache_memory_usage(sm->cache));
+}
+
+/**
+ * @brief Register the manager's metrics in its own or the configured registry
+ */
+static bool register_metrics(sensor_manager_t *sm) {
+    sm->metrics = sm->config.metrics;
+    if (!sm->metrics) {
+        sm->metrics = metrics_registry_create();
+        sm->owns_metrics = true;
+        if (!sm->metrics) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(counter_metrics) / sizeof(counter_metrics[0]); i++) {
+        metrics_counter_t *counter = metrics_counter_register(sm->metrics, counter_metrics[i].name,
+                                                              counter_metrics[i].help);
+        if (!counter) {
+            return false;
+        }
+        *(metrics_counter_t **)((char *)sm + counter_metrics[i].offset) = counter;
+    }
+
+    sm->callback_duration = metrics_histogram_register(
+        sm->metrics, CALLBACK_DURATION_METRIC, "Duration of timed inline data callbacks",
+        callback_duration_bounds,
+        sizeof(callback_duration_bounds) / sizeof(callback_duration_bounds[0]), 1e-6);
+
+    return sm->callback_duration &&
+           metrics_collector_register(sm->metrics, collect_metrics, sm);
+}
+
+/**
+ * @brief Remove what register_metrics() added (also after a partial failure)
+ */
+static void unregister_metrics(sensor_manager_t *sm) {
+    if (!sm->metrics) {
+        return;
+    }
+
+    if (sm->owns_metrics) {
+        metrics_registry_destroy(sm->metrics);
+        return;
+    }
+
+    metrics_collector_unregister(sm->metrics, collect_metrics, sm);
+    for (size_t i = 0; i < sizeof(counter_metrics) / sizeof(counter_metrics[0]); i++) {
+        if (*(metrics_counter_t **)((char *)sm + counter_metrics[i].offset)) {
+            metrics_unregister(sm->metrics, counter_metrics[i].name);
+        }
+    }
+    if (sm->callback_duration) {
+        metrics_unregister(sm->metrics, CALLBACK_DURATION_METRIC);
+    }
+}
+
+sensor_manager_t *sensor_manager_init(const sensor_manager_config_t *config) {
+    sensor_manager_t *sm = calloc(1, sizeof(sensor_manager_t));
+    if (!sm) {
+        return NULL;
+    }
+
+    if (config) {
+        sm->config = *config;
+    } else {
+        sensor_manager_config_init(&sm->config);
+    }
+
+    /* What sensor_manager_cleanup() releases unconditionally, so any
+     * failure below can hand the partial manager to it */
+    atomic_init(&sm->data_subscribers, NULL);
+    atomic_init(&sm->dispatch, NULL);
+    pthread_mutex_init(&sm->data_subscribe_lock, NULL);
+    rcu_init(&sm->data_rcu);
+
+    pthread_rwlock_init(&sm->registry_lock, NULL);
+    pthread_rwlock_init(&sm->subscriber_lock, NULL);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sm->timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&sm->timer_lock, NULL);
+
+    atomic_init(&sm->registered_sensors, 0);
+    atomic_init(&sm->online_sensors, 0);
+    atomic_init(&sm->offline_sensors, 0);
+    atomic_init(&sm->compress, sm->config.enable_compression);
+
+    if (!own_config(&sm->config)) {
+        goto fail;
+    }
+
+    sm->buckets = calloc(REGISTRY_INITIAL_BUCKETS, sizeof(sensor_record_t *));
+    if (!sm->buckets) {
+        goto fail;
+    }
+    sm->bucket_count = REGISTRY_INITIAL_BUCKETS;
+
+    if (sm->config.enable_cache && sm->config.cache_size > 0) {
+        sm->cache = sensor_cache_create(sm->config.cache_size,
+                                        sm->config.cache_memory_limit,
+                                        sm->config.cache_ttl_ms);
+        if (!sm->cache) {
+            LOG_ERROR("Failed to create sensor cache (%zu entries)", sm->config.cache_size);
+            goto fail;
+        }
+    }
+
+    if (sm->config.enable_historical) {
+        if (!sm->config.storage_path) {
+            LOG_WARN("Historical storage enabled without storage_path; disabled");
+        } else {
+            sm->tsdb = sensor_tsdb_open(sm->config.storage_path, sm->config.retention_days);
+            if (!sm->tsdb) {
+                LOG_ERROR("Failed to open historical store at %s", sm->config.storage_path);
+                goto fail;
+            }
+        }
+    }
+
+    if (sm->config.enable_aggregation) {
+        sm->aggregator = sensor_aggregator_create(sm->config.aggregation_window_ms,
+                                                  sm->config.aggregation_slide_ms,
+                                                  dispatch_aggregate, sm);
+        if (!sm->aggregator) {
+            LOG_ERROR("Invalid aggregation window %u ms / slide %u ms",
+                      sm->config.aggregation_window_ms, sm->config.aggregation_slide_ms);
+            goto fail;
+        }
+    }
+
+    if (sm->config.enable_health_monitoring) {
+        sm->health = sensor_health_create(sm->config.health_check_interval_ms,
+                                          sm->config.offline_threshold_ms);
+        if (!sm->health) {
+            LOG_ERROR("Invalid health check interval %u ms / offline threshold %u ms",
+                      sm->config.health_check_interval_ms, sm->config.offline_threshold_ms);
+            goto fail;
+        }
+    }
+
+    if (sm->config.slow_callback_us > 0) {
+        /* Slow callbacks are moved from the dispatch path, so the pool must exist */
+        sensor_dispatch_t *dispatch = sensor_dispatch_create(sm->config.dispatch_threads,
+                                                             sm->config.dispatch_queue_size,
+                                                             sm->config.dispatch_cpus);
+        if (!dispatch) {
+            LOG_ERROR("Failed to start %zu dispatch workers (queue %zu)",
+                      sm->config.dispatch_threads, sm->config.dispatch_queue_size);
+            goto fail;
+        }
+        atomic_store(&sm->dispatch, dispatch);
+    }
+
+    if (sm->config.routes) {
+        sm->compressor = sensor_compressor_create(sm->config.max_payload_size, ENCODE_BUFFERS);
+        if (!sm->compressor) {
+            LOG_ERROR("Failed to create delivery encoder (%zu byte payloads)",
+                      sm->config.max_payload_size);
+            goto fail;
+        }
+    }
+
+    if (!register_metrics(sm)) {
+        LOG_ERROR("Failed to register sensor manager metrics");
+        goto fail;
+    }
+
+    return sm;
+
+fail:
+    sensor_manager_cleanup(sm);
+    return NULL;
+}
+
+paumiot_result_t sensor_manager_start(sensor_manager_t *sm) {
+    if (!sm) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    if (sm->running) {
+        return PAUMIOT_ERROR_ALREADY_INITIALIZED;
+    }
+
+    if (sm->health || sm->aggregator) {
+        sm->timer_stop = false;
+        if (pthread_create(&sm->timer_thread, NULL, timer_thread_main, sm) != 0) {
+            LOG_ERROR("Failed to start sensor manager timer thread");
+            return PAUMIOT_ERROR_OPERATION_FAILED;
+        }
+    }
+
+    sm->running = true;
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_manager_stop(sensor_manager_t *sm) {
+    if (!sm) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    if (!sm->running) {
+        return PAUMIOT_ERROR_NOT_INITIALIZED;
+    }
+
+    if (sm->health || sm->aggregator) {
+        pthread_mutex_lock(&sm->timer_lock);
+        sm->timer_stop = true;
+        pthread_cond_signal(&sm->timer_cond);
+        pthread_mutex_unlock(&sm->timer_lock);
+        pthread_join(sm->timer_thread, NULL);
+    }
+
+    sm->running = false;
+    return PAUMIOT_SUCCESS;
+}
+
+void sensor_manager_cleanup(sensor_manager_t *sm) {
+    if (!sm) {
+        return;
+    }
+
+    if (sm->running) {
+        sensor_manager_stop(sm);
+    }
+
+    /* Deliver queued callbacks while everything they may touch still exists */
+    sensor_dispatch_destroy(atomic_load(&sm->dispatch));
+    unregister_metrics(sm);
+
+    for (size_t i = 0; i < sm->bucket_count; i++) {
+        sensor_record_t *record = sm->buckets[i];
+        while (record) {
+            sensor_record_t *next = record->next;
+            record_free(record);
+            record = next;
+        }
+    }
+
+    data_subscriber_set_t *set = atomic_load(&sm->data_subscribers);
+    if (set) {
+        for (size_t i = 0; i < set->count; i++) {
+            free(set->entries[i].sensor_id);
+        }
+        free(set);
+    }
+
+    status_subscription_t *ss = sm->status_subscribers;
+    while (ss) {
+        status_subscription_t *next = ss->next;
+        free(ss->sensor_id);
+        free(ss);
+        ss = next;
+    }
+
+    aggregate_subscription_t *as = sm->aggregate_subscribers;
+    while (as) {
+        aggregate_subscription_t *next = as->next;
+        free(as->sensor_id);
+        free(as);
+        as = next;
+    }
+
+    sensor_health_destroy(sm->health);
+    pthread_cond_destroy(&sm->timer_cond);
+    pthread_mutex_destroy(&sm->timer_lock);
+    sensor_aggregator_destroy(sm->aggregator);
+    sensor_tsdb_close(sm->tsdb);
+    sensor_cache_destroy(sm->cache);
+    sensor_compressor_destroy(sm->compressor);
+    pthread_mutex_destroy(&sm->data_subscribe_lock);
+    pthread_rwlock_destroy(&sm->subscriber_lock);
+    pthread_rwlock_destroy(&sm->registry_lock);
+    free(sm->buckets);
+    free_owned_config(&sm->config);
+    free(sm);
+}
+
+/* ============================================================================
+ * SENSOR REGISTRY API
+ * ========================================================================= */
+
+paumiot_result_t sensor_manager_register(sensor_manager_t *sm, const sensor_entry_t *sensor) {
+    if (!sm || !sensor || !sensor->sensor_id) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    sensor_record_t *record = calloc(1, sizeof(sensor_record_t));
+    if (!record) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    paumiot_result_t result = sensor_entry_copy(&record->entry, sensor);
+    if (result != PAUMIOT_SUCCESS) {
+        free(record);
+        return result;
+    }
+
+    record->hash = sensor_id_hash(record->entry.sensor_id, NULL);
+    record->last.sensor_id = record->entry.sensor_id;
+    pthread_mutex_init(&record->data_lock, NULL);
+    sensor_health_node_init(&record->health);
+
+    pthread_rwlock_wrlock(&sm->registry_lock);
+
+    if (registry_find(sm, sensor->sensor_id)) {
+        pthread_rwlock_unlock(&sm->registry_lock);
+        record_free(record);
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_ALREADY_EXISTS;
+    }
+
+    if (sm->sensor_count + 1 > sm->bucket_count * REGISTRY_MAX_LOAD) {
+        registry_grow(sm);
+    }
+
+    size_t b = record->hash & (sm->bucket_count - 1);
+    record->next = sm->buckets[b];
+    sm->buckets[b] = record;
+    sm->sensor_count++;
+    atomic_fetch_add_explicit(&sm->registered_sensors, 1, memory_order_relaxed);
+    status_counters_update(sm, SENSOR_STATUS_UNKNOWN, record->entry.status);
+    record_mark_seen(sm, record);
+
+    pthread_rwlock_unlock(&sm->registry_lock);
+
+    LOG_DEBUG("Registered sensor %s", sensor->sensor_id);
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_manager_unregister(sensor_manager_t *sm, const char *sensor_id) {
+    if (!sm || !sensor_id) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t hash = sensor_id_hash(sensor_id, NULL);
+
+    pthread_rwlock_wrlock(&sm->registry_lock);
+
+    sensor_record_t **link = &sm->buckets[hash & (sm->bucket_count - 1)];
+    while (*link && ((*link)->hash != hash ||
+                     strcmp((*link)->entry.sensor_id, sensor_id) != 0)) {
+        link = &(*link)->next;
+    }
+
+    sensor_record_t *record = *link;
+    if (!record) {
+        pthread_rwlock_unlock(&sm->registry_lock);
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+    }
+
+    *link = record->next;
+    sm->sensor_count--;
+    atomic_fetch_sub_explicit(&sm->registered_sensors, 1, memory_order_relaxed);
+    status_counters_update(sm, record->entry.status, SENSOR_STATUS_UNKNOWN);
+
+    /* Drop the cached value while no writer can re-insert it */
+    sensor_cache_remove(sm->cache, sensor_id);
+    sensor_aggregator_remove(sm->aggregator, sensor_id);
+    sensor_health_remove(sm->health, &record->health);
+
+    pthread_rwlock_unlock(&sm->registry_lock);
+
+    record_free(record);
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_manager_get_sensor(sensor_manager_t *sm, const char *sensor_id,
+                                           sensor_entry_t *sensor) {
+    if (!sm || !sensor_id || !sensor) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_rwlock_rdlock(&sm->registry_lock);
+
+    sensor_record_t *record = registry_find(sm, sensor_id);
+    if (!record) {
+        pthread_rwlock_unlock(&sm->registry_lock);
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+    }
+
+    pthread_mutex_lock(&record->data_lock);
+    paumiot_result_t result = sensor_entry_copy(sensor, &record->entry);
+    pthread_mutex_unlock(&record->data_lock);
+
+    pthread_rwlock_unlock(&sm->registry_lock);
+    return result;
+}
+
+paumiot_result_t sensor_manager_update_status(sensor_manager_t *sm, const char *sensor_id,
+                                              sensor_status_t status) {
+    if (!sm || !sensor_id) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_rwlock_rdlock(&sm->registry_lock);
+
+    sensor_record_t *record = registry_find(sm, sensor_id);
+    if (!record) {
+        pthread_rwlock_unlock(&sm->registry_lock);
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+    }
+
+    pthread_mutex_lock(&record->data_lock);
+    sensor_status_t old_status = record->entry.status;
+    record->entry.status = status;
+    pthread_mutex_unlock(&record->data_lock);
+
+    if (old_status != status) {
+        status_counters_update(sm, old_status, status);
+    }
+    if (status == SENSOR_STATUS_ONLINE) {
+        record_mark_seen(sm, record);
+    }
+
+    pthread_rwlock_unlock(&sm->registry_lock);
+
+    if (old_status != status) {
+        dispatch_status(sm, sensor_id, old_status, status);
+    }
+
+    return PAUMIOT_SUCCESS;
+}
+
+/**
+ * @brief Collect matching entries (topic NULL = all)
+ */
+static paumiot_result_t registry_collect(sensor_manager_t *sm, const char *topic,
+                                         sensor_entry_t **sensors, size_t *count) {
+    pthread_rwlock_rdlock(&sm->registry_lock);
+
+    sensor_entry_t *out = NULL;
+    size_t n = 0;
+
+    if (sm->sensor_count > 0) {
+        out = calloc(sm->sensor_count, sizeof(sensor_entry_t));
+        if (!out) {
+            pthread_rwlock_unlock(&sm->registry_lock);
+            return PAUMIOT_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+    for (size_t i = 0; i < sm->bucket_count && result == PAUMIOT_SUCCESS; i++) {
+        for (sensor_record_t *record = sm->buckets[i]; record; record = record->next) {
+            if (topic && (!record->entry.topic_pattern ||
+                          !sensor_topic_matches(record->entry.topic_pattern, topic))) {
+                continue;
+            }
+
+            pthread_mutex_lock(&record->data_lock);
+            result = sensor_entry_copy(&out[n], &record->entry);
+            pthread_mutex_unlock(&record->data_lock);
+
+            if (result != PAUMIOT_SUCCESS) {
+                break;
+            }
+            n++;
+        }
+    }
+
+    pthread_rwlock_unlock(&sm->registry_lock);
+
+    if (result != PAUMIOT_SUCCESS) {
+        for (size_t i = 0; i < n; i++) {
+            sensor_entry_free(&out[i]);
+        }
+        free(out);
+        return result;
+    }
+
+    *sensors = out;
+    *count = n;
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_manager_list_sensors(sensor_manager_t *sm, sensor_entry_t **sensors,
+                                             size_t *count) {
+    if (!sm || !sensors || !count) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    return registry_collect(sm, NULL, sensors, count);
+}
+
+paumiot_result_t sensor_manager_find_by_topic(sensor_manager_t *sm, const char *topic,
+                                              sensor_entry_t **sensors, size_t *count) {
+    if (!sm || !topic || !sensors || !count) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    return registry_collect(sm, topic, sensors, count);
+}
+
+/* ============================================================================
+ * DATA MANAGEMENT API
+ * ========================================================================= */
+
+paumiot_result_t sensor_manager_get_data(sensor_manager_t *sm, const char *sensor_id,
+                                         sensor_data_t **data) {
+    if (!sm || !sensor_id || !data) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    /* Fast path: lock-free cache read */
+    if (sm->cache) {
+        sensor_cache_value_t value;
+        if (sensor_cache_get(sm->cache, sensor_id, &value) == PAUMIOT_SUCCESS) {
+            metrics_counter_inc(sm->cache_hits);
+            *data = sensor_data_from_cache(&value);
+            return *data ? PAUMIOT_SUCCESS : PAUMIOT_ERROR_OUT_OF_MEMORY;
+        }
+        metrics_counter_inc(sm->cache_misses);
+    }
+
+    /* Slow path: authoritative copy in the registry */
+    pthread_rwlock_rdlock(&sm->registry_lock);
+
+    sensor_record_t *record = registry_find(sm, sensor_id);
+    if (!record) {
+        pthread_rwlock_unlock(&sm->registry_lock);
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+    }
+
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+    pthread_mutex_lock(&record->data_lock);
+
+    if (!record->has_data) {
+        result = (paumiot_result_t)SENSOR_MANAGER_ERROR_NO_DATA;
+    } else {
+        *data = sensor_data_dup(&record->last);
+        if (!*data) {
+            result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+        } else if (sm->cache) {
+            /* Refill so the next poll is served lock-free */
+            sensor_cache_put(sm->cache, &record->last);
+        }
+    }
+
+    pthread_mutex_unlock(&record->data_lock);
+    pthread_rwlock_unlock(&sm->registry_lock);
+
+    return result;
+}
+
+paumiot_result_t sensor_manager_update_data(sensor_manager_t *sm, const sensor_data_t *data) {
+    if (!sm || !data || !data->sensor_id || (!data->payload && data->payload_len > 0) ||
+        data->compressed) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_rwlock_rdlock(&sm->registry_lock);
+
+    sensor_record_t *record = registry_find(sm, data->sensor_id);
+    if (!record) {
+        pthread_rwlock_unlock(&sm->registry_lock);
+        return (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND;
+    }
+
+    pthread_mutex_lock(&record->data_lock);
+
+    paumiot_result_t result = record_store_data(record, data);
+    if (result == PAUMIOT_SUCCESS && sm->cache) {
+        /* Same lock order as the registry so the cache never goes backwards */
+        sensor_cache_put(sm->cache, &record->last);
+    }
+    uint64_t timestamp = record->last.timestamp;
+    uint32_t hash = record->hash;
+
+    /* A reading proves a monitored sensor is alive */
+    sensor_status_t old_status = record->entry.status;
+    bool revived = result == PAUMIOT_SUCCESS && sm->health &&
+                   (old_status == SENSOR_STATUS_OFFLINE || old_status == SENSOR_STATUS_UNKNOWN);
+    if (revived) {
+        record->entry.status = SENSOR_STATUS_ONLINE;
+    }
+
+    pthread_mutex_unlock(&record->data_lock);
+
+    if (result == PAUMIOT_SUCCESS) {
+        record_mark_seen(sm, record);
+    }
+    if (revived) {
+        status_counters_update(sm, old_status, SENSOR_STATUS_ONLINE);
+    }
+
+    double value;
+    bool numeric = result == PAUMIOT_SUCCESS && (sm->tsdb || sm->aggregator) &&
+                   sensor_data_numeric_value(data, &value);
+
+    /* Unregister removes the series under the write lock, so this never recreates one */
+    sensor_aggregator_series_t *series =
+        numeric ? sensor_aggregator_acquire(sm->aggregator, data->sensor_id) : NULL;
+
+    pthread_rwlock_unlock(&sm->registry_lock);
+
+    if (result != PAUMIOT_SUCCESS) {
+        return result;
+    }
+
+    if (revived) {
+        dispatch_status(sm, data->sensor_id, old_status, SENSOR_STATUS_ONLINE);
+    }
+
+    if (numeric) {
+        if (sm->tsdb &&
+            sensor_tsdb_append(sm->tsdb, data->sensor_id, timestamp, value) != PAUMIOT_SUCCESS) {
+            LOG_WARN("Failed to record history for sensor %s", data->sensor_id);
+        }
+        if (series) {
+            sensor_aggregator_add_series(sm->aggregator, series, timestamp, value);
+            sensor_aggregator_release(series);
+        }
+    }
+
+    metrics_counter_inc(sm->data_updates);
+    dispatch_data(sm, data, hash);
+
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_manager_subscribe_data(sensor_manager_t *sm, const char *sensor_id,
+                                               sensor_data_callback_t callback,
+                                               void *user_data) {
+    return sensor_manager_subscribe_data_ex(sm, sensor_id, callback, user_data,
+                                            SENSOR_SUBSCRIBE_DEFAULT);
+}
+
+paumiot_result_t sensor_manager_subscribe_data_ex(sensor_manager_t *sm, const char *sensor_id,
+                                                  sensor_data_callback_t callback,
+                                                  void *user_data, uint32_t flags) {
+    if (!sm || !callback || (flags & ~(uint32_t)SENSOR_SUBSCRIBE_DEFERRED)) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    char *id = str_dup_or_null(sensor_id);
+    if (sensor_id && !id) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_lock(&sm->data_subscribe_lock);
+
+    if ((flags & SENSOR_SUBSCRIBE_DEFERRED) && !atomic_load(&sm->dispatch)) {
+        if (sm->config.dispatch_threads == 0 || sm->config.dispatch_queue_size == 0) {
+            pthread_mutex_unlock(&sm->data_subscribe_lock);
+            free(id);
+            return PAUMIOT_ERROR_NOT_SUPPORTED;
+        }
+
+        sensor_dispatch_t *dispatch = sensor_dispatch_create(sm->config.dispatch_threads,
+                                                             sm->config.dispatch_queue_size,
+                                                             sm->config.dispatch_cpus);
+        if (!dispatch) {
+            pthread_mutex_unlock(&sm->data_subscribe_lock);
+            free(id);
+            return PAUMIOT_ERROR_OPERATION_FAILED;
+        }
+        atomic_store_explicit(&sm->dispatch, dispatch, memory_order_release);
+    }
+
+    data_subscriber_set_t *old = atomic_load_explicit(&sm->data_subscribers,
+                                                      memory_order_relaxed);
+    size_t count = old ? old->count : 0;
+
+    data_subscriber_set_t *set = malloc(sizeof(data_subscriber_set_t) +
+                                        (count + 1) * sizeof(data_subscriber_t));
+    if (!set) {
+        pthread_mutex_unlock(&sm->data_subscribe_lock);
+        free(id);
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const data_subscriber_t *src = &old->entries[i];
+        data_subscriber_t *dst = &set->entries[i];
+
+        dst->sensor_id = src->sensor_id;
+        dst->hash = src->hash;
+        dst->callback = src->callback;
+        dst->user_data = src->user_data;
+        atomic_init(&dst->flags, atomic_load_explicit(&src->flags, memory_order_relaxed));
+    }
+
+    data_subscriber_t *sub = &set->entries[count];
+    sub->sensor_id = id;
+    sub->hash = id ? sensor_id_hash(id, NULL) : 0;
+    sub->callback = callback;
+    sub->user_data = user_data;
+    atomic_init(&sub->flags, flags);
+    set->count = count + 1;
+
+    atomic_store(&sm->data_subscribers, set);
+
+    /* Free the old version once no dispatch can still be scanning it */
+    if (old) {
+        rcu_synchronize(&sm->data_rcu);
+        free(old);
+    }
+
+    pthread_mutex_unlock(&sm->data_subscribe_lock);
+
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_manager_subscribe_status(sensor_manager_t *sm, const char *sensor_id,
+                                                 sensor_status_callback_t callback,
+                                                 void *user_data) {
+    if (!sm || !callback) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    status_subscription_t *sub = calloc(1, sizeof(status_subscription_t));
+    if (!sub) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    sub->sensor_id = str_dup_or_null(sensor_id);
+    if (sensor_id && !sub->sensor_id) {
+        free(sub);
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+    sub->callback = callback;
+    sub->user_data = user_data;
+
+    pthread_rwlock_wrlock(&sm->subscriber_lock);
+    sub->next = sm->status_subscribers;
+    sm->status_subscribers = sub;
+    pthread_rwlock_unlock(&sm->subscriber_lock);
+
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_manager_subscribe_aggregates(sensor_manager_t *sm,
+                                                     const char *sensor_id,
+                                                     sensor_aggregate_callback_t callback,
+                                                     void *user_data) {
+    if (!sm || !callback) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    if (!sm->aggregator) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+
+    aggregate_subscription_t *sub = calloc(1, sizeof(aggregate_subscription_t));
+    if (!sub) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    sub->sensor_id = str_dup_or_null(sensor_id);
+    if (sensor_id && !sub->sensor_id) {
+        free(sub);
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+    sub->callback = callback;
+    sub->user_data = user_data;
+
+    pthread_rwlock_wrlock(&sm->subscriber_lock);
+    sub->next = sm->aggregate_subscribers;
+    sm->aggregate_subscribers = sub;
+    pthread_rwlock_unlock(&sm->subscriber_lock);
+
+    return PAUMIOT_SUCCESS;
+}
+
+paumiot_result_t sensor_manager_flush_aggregates(sensor_manager_t *sm, uint64_t now_ms) {
+    if (!sm) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    if (!sm->aggregator) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+
+    sensor_aggregator_advance(sm->aggregator, now_ms);
+    return PAUMIOT_SUCCESS;
+}
+
+/* ============================================================================
+ * HEALTH MONITORING API
+ * ========================================================================= */
+
+paumiot_result_t sensor_manager_check_health(sensor_manager_t *sm, uint64_t now_ms,
+                                             size_t *transitions) {
+    if (!sm) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    if (transitions) {
+        *transitions = 0;
+    }
+
+    if (!sm->health) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+
+    metrics_counter_inc(sm->health_checks);
+
+    sensor_health_node_t *expired[HEALTH_BATCH_SIZE];
+    status_transition_t *batch = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+
+    /* Records cannot be unregistered while the registry is read-locked */
+    pthread_rwlock_rdlock(&sm->registry_lock);
+
+    size_t n;
+    while ((n = sensor_health_expire(sm->health, now_ms, expired, HEALTH_BATCH_SIZE)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            sensor_record_t *record = (sensor_record_t *)((char *)expired[i] -
+                                                          offsetof(sensor_record_t, health));
+
+            /* Activity that raced with the expiry re-arms the deadline */
+            uint64_t seen = atomic_load_explicit(&record->seen_ms, memory_order_relaxed);
+            if (now_ms < seen + sm->config.offline_threshold_ms) {
+                sensor_health_touch(sm->health, &record->health, seen);
+                continue;
+            }
+
+            if (count == capacity) {
+                size_t grown = capacity ? capacity * 2 : HEALTH_BATCH_SIZE;
+                status_transition_t *resized = realloc(batch, grown * sizeof(*batch));
+                if (!resized) {
+                    /* Leave the sensor armed; the next check retries it */
+                    sensor_health_touch(sm->health, &record->health, now_ms);
+                    result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+                    continue;
+                }
+                batch = resized;
+                capacity = grown;
+            }
+
+            pthread_mutex_lock(&record->data_lock);
+            bool went_offline = record->entry.status == SENSOR_STATUS_ONLINE;
+            if (went_offline) {
+                record->entry.status = SENSOR_STATUS_OFFLINE;
+            }
+            pthread_mutex_unlock(&record->data_lock);
+
+            if (!went_offline) {
+                continue;
+            }
+            status_counters_update(sm, SENSOR_STATUS_ONLINE, SENSOR_STATUS_OFFLINE);
+
+            batch[count].sensor_id = strdup(record->entry.sensor_id);
+            if (!batch[count].sensor_id) {
+                result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+                continue;
+            }
+            batch[count].old_status = SENSOR_STATUS_ONLINE;
+            batch[count].new_status = SENSOR_STATUS_OFFLINE;
+            count++;
+        }
+    }
+
+    pthread_rwlock_unlock(&sm->registry_lock);
+
+    if (count > 0) {
+        LOG_DEBUG("Health check: %zu sensor(s) went offline", count);
+        dispatch_status_batch(sm, batch, count);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free(batch[i].sensor_id);
+    }
+    free(batch);
+
+    if (transitions) {
+        *transitions = count;
+    }
+    return result;
+}
+
+/* ============================================================================
+ * HISTORICAL DATA API
+ * ========================================================================= */
+
+/* Columnar accumulator for historical scans */
+typedef struct {
+    uint64_t *timestamps;
+    double *values;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} historical_collector_t;
+
+static void historical_collect(const uint64_t *timestamps, const double *values,
+                               size_t count, void *user_data) {
+    historical_collector_t *c = (historical_collector_t *)user_data;
+    if (c->failed) {
+        return;
+    }
+
+    if (c->count + count > c->capacity) {
+        size_t capacity = c->capacity ? c->capacity : 1024;
+        while (capacity < c->count + count) {
+            capacity *= 2;
+        }
+        uint64_t *ts = realloc(c->timestamps, capacity * sizeof(uint64_t));
+        if (ts) {
+            c->timestamps = ts;
+        }
+        double *vals = realloc(c->values, capacity * sizeof(double));
+        if (vals) {
+            c->values = vals;
+        }
+        if (!ts || !vals) {
+            c->failed = true;
+            return;
+        }
+        c->capacity = capacity;
+    }
+
+    memcpy(c->timestamps + c->count, timestamps, count * sizeof(uint64_t));
+    memcpy(c->values + c->count, values, count * sizeof(double));
+    c->count += count;
+}
+
+paumiot_result_t sensor_manager_query_historical(sensor_manager_t *sm, const char *sensor_id,
+                                                 uint64_t start_time, uint64_t end_time,
+                                                 sensor_data_t **data, size_t *count) {
+    if (!sm || !sensor_id || !data || !count || start_time > end_time) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    *data = NULL;
+    *count = 0;
+
+    if (!sm->tsdb) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+
+    historical_collector_t collector = {0};
+    paumiot_result_t result = sensor_tsdb_scan(sm->tsdb, sensor_id, start_time, end_time,
+                                               historical_collect, &collector);
+    if (result == PAUMIOT_SUCCESS && collector.failed) {
+        result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (result == PAUMIOT_SUCCESS && collector.count > 0) {
+        /* One allocation: records, then the 8-byte payloads, then the ID */
+        size_t n = collector.count;
+        size_t id_len = strlen(sensor_id) + 1;
+        uint8_t *block = malloc(n * (sizeof(sensor_data_t) + sizeof(double)) + id_len);
+
+        if (!block) {
+            result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+        } else {
+            sensor_data_t *records = (sensor_data_t *)block;
+            double *payloads = (double *)(block + n * sizeof(sensor_data_t));
+            char *id = (char *)(payloads + n);
+
+            memcpy(id, sensor_id, id_len);
+            memcpy(payloads, collector.values, n * sizeof(double));
+            for (size_t i = 0; i < n; i++) {
+                records[i].sensor_id = id;
+                records[i].topic = NULL;
+                records[i].payload = (uint8_t *)&payloads[i];
+                records[i].payload_len = sizeof(double);
+                records[i].format = DATA_FORMAT_RAW;
+                records[i].timestamp = collector.timestamps[i];
+                records[i].qos = QOS_LEVEL_0;
+            }
+
+            *data = records;
+            *count = n;
+        }
+    }
+
+    free(collector.timestamps);
+    free(collector.values);
+    return result;
+}
+
+static void historical_summarize(const uint64_t *timestamps, const double *values,
+                                 size_t count, void *user_data) {
+    (void)timestamps;
+    sensor_batch_stats_add_f64((sensor_batch_stats_t *)user_data, values, count);
+}
+
+paumiot_result_t sensor_manager_query_stats(sensor_manager_t *sm, const char *sensor_id,
+                                            uint64_t start_time, uint64_t end_time,
+                                            double threshold, sensor_batch_stats_t *stats) {
+    if (!sm || !sensor_id || !stats || start_time > end_time) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    sensor_batch_stats_init(stats, threshold);
+
+    if (!sm->tsdb) {
+        return PAUMIOT_ERROR_NOT_SUPPORTED;
+    }
+
+    return sensor_tsdb_scan(sm->tsdb, sensor_id, start_time, end_time,
+                            historical_summarize, stats);
+}
+
+/* ============================================================================
+ * STATISTICS API
+ * ========================================================================= */
+
+paumiot_result_t sensor_manager_get_stats(sensor_manager_t *sm, sensor_manager_stats_t *stats) {
+    if (!sm || !stats) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    pthread_rwlock_rdlock(&sm->registry_lock);
+    stats->total_sensors = sm->sensor_count;
+    pthread_rwlock_unlock(&sm->registry_lock);
+
+    stats->online_sensors = atomic_load(&sm->online_sensors);
+    stats->offline_sensors = atomic_load(&sm->offline_sensors);
+    stats->data_updates = metrics_counter_value(sm->data_updates);
+    stats->cache_hits = metrics_counter_value(sm->cache_hits);
+    stats->cache_misses = metrics_counter_value(sm->cache_misses);
+    stats->cache_memory_usage = sensor_cache_memory_usage(sm->cache);
+    stats->health_checks = metrics_counter_value(sm->health_checks);
+    stats->deferred_callbacks = metrics_counter_value(sm->deferred_callbacks);
+    stats->deferred_dropped = metrics_counter_value(sm->deferred_dropped);
+    stats->payloads_encoded = metrics_counter_value(sm->payloads_encoded);
+    stats->encode_failures = metrics_counter_value(sm->encode_failures);
+
+    return PAUMIOT_SUCCESS;
+}
+
+metrics_registry_t *sensor_manager_metrics(sensor_manager_t *sm) {
+    return sm ? sm->metrics : NULL;
+}
+
+paumiot_result_t sensor_manager_reset_stats(sensor_manager_t *sm) {
+    if (!sm) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    /* Sensor counts and memory usage are gauges and are not reset; scraped
+     * counters keep their totals */
+    for (size_t i = 0; i < sizeof(counter_metrics) / sizeof(counter_metrics[0]); i++) {
+        metrics_counter_reset(*(metrics_counter_t **)((char *)sm + counter_metrics[i].offset));
+    }
+
+    return PAUMIOT_SUCCESS;
+}
+
+/* ============================================================================
+ * UTILITY API
+ * ========================================================================= */
+
+void sensor_entry_free(sensor_entry_t *sensor) {
+    if (!sensor) {
+        return;
+    }
+
+    free(sensor->sensor_id);
+    free(sensor->name);
+    free(sensor->topic_pattern);
+    free(sensor->location);
+    memset(sensor, 0, sizeof(*sensor));
+}
+
+void sensor_data_free(sensor_data_t *data) {
+    if (!data) {
+        return;
+    }
+
+    free(data->sensor_id);
+    free(data->topic);
+    free(data->payload);
+    free(data);
+}
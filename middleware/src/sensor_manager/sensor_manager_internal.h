@@ -0,0 +1,67 @@
+/**
+ * @file sensor_manager_internal.h
+ * @brief Helpers shared by the sensor manager translation units
+ */
+
+#ifndef PAUMIOT_SENSOR_MANAGER_INTERNAL_H
+#define PAUMIOT_SENSOR_MANAGER_INTERNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief FNV-1a hash of a sensor ID
+ * @param sensor_id NUL-terminated sensor identifier
+ * @param len Length of the identifier (output, optional)
+ */
+static inline uint32_t sensor_id_hash(const char *sensor_id, size_t *len) {
+    uint32_t hash = 2166136261u;
+    const unsigned char *p = (const unsigned char *)sensor_id;
+    
+    while (*p) {
+        hash ^= *p++;
+        hash *= 16777619u;
+    }
+    
+    if (len) {
+        *len = (size_t)(p - (const unsigned char *)sensor_id);
+    }
+    return hash;
+}
+
+/**
+ * @brief Match a topic against a pattern
+ * @details Pattern levels of "+" or "{name}" match one topic level; a
+ *          trailing "#" matches the remainder.
+ */
+static inline bool sensor_topic_matches(const char *pattern, const char *topic) {
+    while (*pattern && *topic) {
+        const char *p_end = strchr(pattern, '/');
+        const char *t_end = strchr(topic, '/');
+        size_t p_len = p_end ? (size_t)(p_end - pattern) : strlen(pattern);
+        size_t t_len = t_end ? (size_t)(t_end - topic) : strlen(topic);
+
+        if (p_len == 1 && pattern[0] == '#') {
+            return true;
+        }
+
+        bool wildcard = (p_len == 1 && pattern[0] == '+') ||
+                        (p_len >= 2 && pattern[0] == '{' && pattern[p_len - 1] == '}');
+        if (!wildcard && (p_len != t_len || memcmp(pattern, topic, p_len) != 0)) {
+            return false;
+        }
+
+        if (!p_end || !t_end) {
+            return !p_end && !t_end;
+        }
+
+        pattern = p_end + 1;
+        topic = t_end + 1;
+    }
+
+    return *pattern == *topic || strcmp(pattern, "#") == 0;
+}
+
+#endif /* PAUMIOT_SENSOR_MANAGER_INTERNAL_H */
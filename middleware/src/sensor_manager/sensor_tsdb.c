@@ -0,0 +1,1003 @@
+/**
+ * @file sensor_tsdb.c
+ * @brief Columnar time-series segments with Gorilla-style compression
+ * @details Block layout: a fixed header (count, first timestamp, min/max
+ *          timestamp, payload length) followed by one bitstream. The first
+ *          point stores its raw 64-bit value; every later point stores a
+ *          delta-of-delta timestamp code followed by an XOR value code.
+ *          Writers append whole blocks with a single writev(); readers mmap
+ *          a segment and hop from header to header, decoding only blocks
+ *          whose [min, max] range overlaps the query.
+ */
+
+#include "sensor_manager/sensor_tsdb.h"
+#include "sensor_manager_internal.h"
+#include "logging.h"
+#include "time_utils.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define TSDB_SEGMENT_MAGIC 0x31535450u  /* "PTS1" */
+#define TSDB_BLOCK_MAGIC 0x314b4c42u    /* "BLK1" */
+#define TSDB_VERSION 1
+#define TSDB_DAY_MS 86400000ULL
+#define TSDB_SERIES_BUCKETS 1024
+#define TSDB_PATH_MAX 4096
+
+/* Worst case per point: 4 + 64 timestamp bits, 2 + 5 + 6 + 64 value bits */
+#define TSDB_MAX_POINT_BYTES 19
+#define TSDB_INITIAL_STREAM 256
+
+/* Segment file header */
+typedef struct {
+    uint32_t magic;                 /* TSDB_SEGMENT_MAGIC */
+    uint16_t version;               /* TSDB_VERSION */
+    uint16_t reserved;
+    uint64_t day;                   /* Days since Unix epoch (UTC) */
+} tsdb_segment_header_t;
+
+/* Block header (also the sparse time index entry for the block) */
+typedef struct {
+    uint32_t magic;                 /* TSDB_BLOCK_MAGIC */
+    uint32_t count;                 /* Points in the block */
+    uint64_t first_ts;              /* Timestamp of the first point */
+    uint64_t min_ts;                /* Smallest timestamp in the block */
+    uint64_t max_ts;                /* Largest timestamp in the block */
+    uint32_t data_len;              /* Bitstream bytes following the header */
+    uint32_t reserved;
+} tsdb_block_header_t;
+
+/* MSB-first bit writer */
+typedef struct {
+    uint8_t *buf;
+    size_t capacity;                /* Bytes allocated */
+    size_t bit_pos;                 /* Bits written */
+} bit_writer_t;
+
+/* MSB-first bit reader */
+typedef struct {
+    const uint8_t *buf;
+    size_t bit_len;                 /* Bits available */
+    size_t bit_pos;                 /* Bits consumed */
+} bit_reader_t;
+
+/* Per-sensor series with its open (unflushed) block */
+typedef struct tsdb_series {
+    char *sensor_id;                /* Owned copy of the sensor ID */
+    uint32_t hash;                  /* Hash of sensor_id */
+    pthread_mutex_t lock;           /* Guards the open block and appends */
+
+    bit_writer_t stream;            /* Open block bitstream */
+    uint32_t count;                 /* Points in the open block */
+    uint64_t day;                   /* UTC day of the open block */
+    uint64_t first_ts;
+    uint64_t min_ts;
+    uint64_t max_ts;
+
+    /* Encoder state */
+    uint64_t prev_ts;
+    int64_t prev_delta;
+    uint64_t prev_bits;
+    unsigned prev_leading;
+    unsigned prev_trailing;
+    bool has_window;                /* prev_leading/trailing are valid */
+
+    struct tsdb_series *next;       /* Hash chain */
+} tsdb_series_t;
+
+struct sensor_tsdb {
+    char *path;                     /* Root directory */
+    uint32_t retention_days;        /* 0 = keep forever */
+    pthread_mutex_t lock;           /* Guards the series table */
+    tsdb_series_t *buckets[TSDB_SERIES_BUCKETS];
+    atomic_uint_fast64_t retention_day; /* Day retention last ran */
+};
+
+/* Mapped segment */
+typedef struct {
+    void *addr;
+    size_t len;
+} tsdb_mapping_t;
+
+/* ============================================================================
+ * BITSTREAM
+ * ========================================================================= */
+
+static bool bits_reserve(bit_writer_t *w, size_t extra_bytes) {
+    size_t need = (w->bit_pos + 7) / 8 + extra_bytes;
+    if (need <= w->capacity) {
+        return true;
+    }
+
+    size_t capacity = w->capacity ? w->capacity : TSDB_INITIAL_STREAM;
+    while (capacity < need) {
+        capacity *= 2;
+    }
+
+    uint8_t *buf = realloc(w->buf, capacity);
+    if (!buf) {
+        return false;
+    }
+
+    w->buf = buf;
+    w->capacity = capacity;
+    return true;
+}
+
+static void bits_write(bit_writer_t *w, uint64_t value, unsigned nbits) {
+    while (nbits > 0) {
+        size_t byte = w->bit_pos >> 3;
+        unsigned used = (unsigned)(w->bit_pos & 7);
+        unsigned room = 8 - used;
+        unsigned take = nbits < room ? nbits : room;
+        uint8_t chunk = (uint8_t)((value >> (nbits - take)) & ((1u << take) - 1));
+
+        if (used == 0) {
+            w->buf[byte] = 0;
+        }
+        w->buf[byte] |= (uint8_t)(chunk << (room - take));
+        w->bit_pos += take;
+        nbits -= take;
+    }
+}
+
+static bool bits_read(bit_reader_t *r, unsigned nbits, uint64_t *out) {
+    if (r->bit_len - r->bit_pos < nbits) {
+        return false;
+    }
+
+    uint64_t value = 0;
+    while (nbits > 0) {
+        uint8_t byte = r->buf[r->bit_pos >> 3];
+        unsigned used = (unsigned)(r->bit_pos & 7);
+        unsigned room = 8 - used;
+        unsigned take = nbits < room ? nbits : room;
+        uint8_t chunk = (uint8_t)((byte >> (room - take)) & ((1u << take) - 1));
+
+        value = (value << take) | chunk;
+        r->bit_pos += take;
+        nbits -= take;
+    }
+
+    *out = value;
+    return true;
+}
+
+static int64_t sign_extend(uint64_t value, unsigned nbits) {
+    uint64_t sign = 1ULL << (nbits - 1);
+    return (int64_t)((value ^ sign) - sign);
+}
+
+static uint64_t double_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bits_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* ============================================================================
+ * BLOCK CODEC
+ * ========================================================================= */
+
+static void series_reset_block(tsdb_series_t *series) {
+    series->stream.bit_pos = 0;
+    series->count = 0;
+    series->has_window = false;
+}
+
+/**
+ * @brief Encode one point into the open block (caller reserved space)
+ */
+static void series_encode(tsdb_series_t *series, uint64_t timestamp, double value) {
+    bit_writer_t *w = &series->stream;
+    uint64_t bits = double_bits(value);
+
+    if (series->count == 0) {
+        series->day = timestamp / TSDB_DAY_MS;
+        series->first_ts = timestamp;
+        series->min_ts = timestamp;
+        series->max_ts = timestamp;
+        series->prev_ts = timestamp;
+        series->prev_delta = 0;
+        series->prev_bits = bits;
+        bits_write(w, bits, 64);
+        series->count = 1;
+        return;
+    }
+
+    /* Timestamp: delta-of-delta with variable-width buckets */
+    int64_t delta = (int64_t)(timestamp - series->prev_ts);
+    int64_t dod = delta - series->prev_delta;
+
+    if (dod == 0) {
+        bits_write(w, 0x0, 1);
+    } else if (dod >= -64 && dod <= 63) {
+        bits_write(w, 0x2, 2);
+        bits_write(w, (uint64_t)dod, 7);
+    } else if (dod >= -256 && dod <= 255) {
+        bits_write(w, 0x6, 3);
+        bits_write(w, (uint64_t)dod, 9);
+    } else if (dod >= -2048 && dod <= 2047) {
+        bits_write(w, 0xE, 4);
+        bits_write(w, (uint64_t)dod, 12);
+    } else {
+        bits_write(w, 0xF, 4);
+        bits_write(w, (uint64_t)dod, 64);
+    }
+
+    series->prev_delta = delta;
+    series->prev_ts = timestamp;
+
+    /* Value: XOR against the previous value */
+    uint64_t xor = bits ^ series->prev_bits;
+    if (xor == 0) {
+        bits_write(w, 0x0, 1);
+    } else {
+        unsigned leading = (unsigned)__builtin_clzll(xor);
+        unsigned trailing = (unsigned)__builtin_ctzll(xor);
+        if (leading > 31) {
+            leading = 31;
+        }
+
+        if (series->has_window && leading >= series->prev_leading &&
+            trailing >= series->prev_trailing) {
+            unsigned significant = 64 - series->prev_leading - series->prev_trailing;
+            bits_write(w, 0x2, 2);
+            bits_write(w, xor >> series->prev_trailing, significant);
+        } else {
+            unsigned significant = 64 - leading - trailing;
+            bits_write(w, 0x3, 2);
+            bits_write(w, leading, 5);
+            bits_write(w, significant - 1, 6);
+            bits_write(w, xor >> trailing, significant);
+            series->prev_leading = leading;
+            series->prev_trailing = trailing;
+            series->has_window = true;
+        }
+    }
+
+    series->prev_bits = bits;
+    if (timestamp < series->min_ts) {
+        series->min_ts = timestamp;
+    }
+    if (timestamp > series->max_ts) {
+        series->max_ts = timestamp;
+    }
+    series->count++;
+}
+
+/**
+ * @brief Decode a block and hand the points in [start, end] to the visitor
+ * @return false if the block is corrupt
+ */
+static bool block_decode(const tsdb_block_header_t *hdr, const uint8_t *data,
+                         uint64_t start, uint64_t end,
+                         sensor_tsdb_visit_fn visit, void *user_data) {
+    uint64_t timestamps[SENSOR_TSDB_BLOCK_POINTS];
+    double values[SENSOR_TSDB_BLOCK_POINTS];
+
+    if (hdr->count == 0 || hdr->count > SENSOR_TSDB_BLOCK_POINTS) {
+        return false;
+    }
+
+    bit_reader_t r = { .buf = data, .bit_len = (size_t)hdr->data_len * 8, .bit_pos = 0 };
+    bool filter = hdr->min_ts < start || hdr->max_ts > end;
+    size_t n = 0;
+
+    uint64_t ts = hdr->first_ts;
+    int64_t delta = 0;
+    uint64_t bits;
+    unsigned leading = 0;
+    unsigned trailing = 0;
+
+    if (!bits_read(&r, 64, &bits)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        if (i > 0) {
+            uint64_t code;
+            uint64_t raw;
+            int64_t dod = 0;
+
+            /* Timestamp prefix: 0, 10, 110, 1110, 1111 */
+            unsigned ones = 0;
+            while (ones < 4) {
+                if (!bits_read(&r, 1, &code)) {
+                    return false;
+                }
+                if (code == 0) {
+                    break;
+                }
+                ones++;
+            }
+
+            static const unsigned widths[5] = { 0, 7, 9, 12, 64 };
+            if (ones > 0) {
+                if (!bits_read(&r, widths[ones], &raw)) {
+                    return false;
+                }
+                dod = ones == 4 ? (int64_t)raw : sign_extend(raw, widths[ones]);
+            }
+            delta += dod;
+            ts += (uint64_t)delta;
+
+            /* Value */
+            if (!bits_read(&r, 1, &code)) {
+                return false;
+            }
+            if (code == 1) {
+                if (!bits_read(&r, 1, &code)) {
+                    return false;
+                }
+                if (code == 1) {
+                    uint64_t lead;
+                    uint64_t sig;
+                    if (!bits_read(&r, 5, &lead) || !bits_read(&r, 6, &sig)) {
+                        return false;
+                    }
+                    leading = (unsigned)lead;
+                    if (leading + sig + 1 > 64) {
+                        return false;
+                    }
+                    trailing = 64 - leading - (unsigned)(sig + 1);
+                }
+                unsigned significant = 64 - leading - trailing;
+                if (significant == 0 || !bits_read(&r, significant, &raw)) {
+                    return false;
+                }
+                bits ^= raw << trailing;
+            }
+        }
+
+        if (!filter || (ts >= start && ts <= end)) {
+            timestamps[n] = ts;
+            values[n] = bits_double(bits);
+            n++;
+        }
+    }
+
+    if (n > 0) {
+        visit(timestamps, values, n, user_data);
+    }
+    return true;
+}
+
+/* ============================================================================
+ * PATHS
+ * ========================================================================= */
+
+/**
+ * @brief Build `<root>/<escaped sensor_id>` (unsafe bytes become %XX)
+ */
+static bool series_dir_path(const sensor_tsdb_t *db, const char *sensor_id,
+                            char *out, size_t out_size) {
+    static const char hex[] = "0123456789ABCDEF";
+    int written = snprintf(out, out_size, "%s/", db->path);
+    if (written < 0 || (size_t)written >= out_size) {
+        return false;
+    }
+
+    size_t pos = (size_t)written;
+    for (const unsigned char *p = (const unsigned char *)sensor_id; *p; p++) {
+        bool safe = (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
+                    (*p >= '0' && *p <= '9') || *p == '-' || *p == '_' ||
+                    (*p == '.' && p != (const unsigned char *)sensor_id);
+        if (pos + 4 > out_size) {
+            return false;
+        }
+        if (safe) {
+            out[pos++] = (char)*p;
+        } else {
+            out[pos++] = '%';
+            out[pos++] = hex[*p >> 4];
+            out[pos++] = hex[*p & 0xF];
+        }
+    }
+    out[pos] = '\0';
+    return true;
+}
+
+static bool segment_path(const char *dir, uint64_t day, char *out, size_t out_size) {
+    time_t secs = (time_t)(day * 86400ULL);
+    struct tm tm;
+    if (!gmtime_r(&secs, &tm)) {
+        return false;
+    }
+
+    int written = snprintf(out, out_size, "%s/%04d%02d%02d.seg", dir,
+                           tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    return written > 0 && (size_t)written < out_size;
+}
+
+/**
+ * @brief Days since the Unix epoch for a proleptic Gregorian date
+ */
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+/**
+ * @brief Parse "YYYYMMDD.seg" into a day number
+ */
+static bool segment_name_day(const char *name, uint64_t *day) {
+    if (strlen(name) != 12 || strcmp(name + 8, ".seg") != 0) {
+        return false;
+    }
+
+    unsigned y = 0;
+    unsigned m = 0;
+    unsigned d = 0;
+    for (int i = 0; i < 8; i++) {
+        if (name[i] < '0' || name[i] > '9') {
+            return false;
+        }
+    }
+    if (sscanf(name, "%4u%2u%2u", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31) {
+        return false;
+    }
+
+    int64_t days = days_from_civil((int64_t)y, m, d);
+    if (days < 0) {
+        return false;
+    }
+
+    *day = (uint64_t)days;
+    return true;
+}
+
+static bool make_dirs(const char *path) {
+    char buf[TSDB_PATH_MAX];
+    size_t len = strlen(path);
+    if (len == 0 || len >= sizeof(buf)) {
+        return false;
+    }
+
+    memcpy(buf, path, len + 1);
+    for (size_t i = 1; i <= len; i++) {
+        if (buf[i] == '/' || buf[i] == '\0') {
+            char saved = buf[i];
+            buf[i] = '\0';
+            if (mkdir(buf, 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+            buf[i] = saved;
+        }
+    }
+    return true;
+}
+
+/* ============================================================================
+ * SERIES TABLE
+ * ========================================================================= */
+
+static tsdb_series_t *series_find_locked(sensor_tsdb_t *db, const char *sensor_id,
+                                         uint32_t hash) {
+    tsdb_series_t *series = db->buckets[hash % TSDB_SERIES_BUCKETS];
+    while (series) {
+        if (series->hash == hash && strcmp(series->sensor_id, sensor_id) == 0) {
+            return series;
+        }
+        series = series->next;
+    }
+    return NULL;
+}
+
+static tsdb_series_t *series_get(sensor_tsdb_t *db, const char *sensor_id, bool create) {
+    uint32_t hash = sensor_id_hash(sensor_id, NULL);
+
+    pthread_mutex_lock(&db->lock);
+
+    tsdb_series_t *series = series_find_locked(db, sensor_id, hash);
+    if (!series && create) {
+        series = calloc(1, sizeof(tsdb_series_t));
+        if (series) {
+            series->sensor_id = strdup(sensor_id);
+            if (!series->sensor_id) {
+                free(series);
+                series = NULL;
+            } else {
+                series->hash = hash;
+                pthread_mutex_init(&series->lock, NULL);
+                series->next = db->buckets[hash % TSDB_SERIES_BUCKETS];
+                db->buckets[hash % TSDB_SERIES_BUCKETS] = series;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&db->lock);
+    return series;
+}
+
+/**
+ * @brief Append the open block to its day segment (caller holds series lock)
+ * @details A failed or short write is cut back off the segment and the
+ *          block stays open for the next attempt, so a segment only ever
+ *          holds whole blocks. With sync the block is also forced to disk;
+ *          blocks that fill up in sensor_tsdb_append() are not, leaving
+ *          durability points to sensor_tsdb_flush().
+ */
+static paumiot_result_t series_flush_locked(sensor_tsdb_t *db, tsdb_series_t *series,
+                                            bool sync) {
+    if (series->count == 0) {
+        return PAUMIOT_SUCCESS;
+    }
+
+    char dir[TSDB_PATH_MAX];
+    char path[TSDB_PATH_MAX];
+    if (!series_dir_path(db, series->sensor_id, dir, sizeof(dir)) ||
+        !segment_path(dir, series->day, path, sizeof(path))) {
+        LOG_ERROR("TSDB path too long for sensor %s", series->sensor_id);
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        LOG_ERROR("TSDB failed to create %s: %s", dir, strerror(errno));
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        LOG_ERROR("TSDB failed to open %s: %s", path, strerror(errno));
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    tsdb_segment_header_t seg = {
+        .magic = TSDB_SEGMENT_MAGIC,
+        .version = TSDB_VERSION,
+        .day = series->day
+    };
+    tsdb_block_header_t hdr = {
+        .magic = TSDB_BLOCK_MAGIC,
+        .count = series->count,
+        .first_ts = series->first_ts,
+        .min_ts = series->min_ts,
+        .max_ts = series->max_ts,
+        .data_len = (uint32_t)((series->stream.bit_pos + 7) / 8)
+    };
+
+    /* One writev so a reader never sees a header without its data */
+    struct iovec iov[3];
+    int iovcnt = 0;
+    size_t total = 0;
+    if (st.st_size == 0) {
+        iov[iovcnt].iov_base = &seg;
+        iov[iovcnt++].iov_len = sizeof(seg);
+        total += sizeof(seg);
+    }
+    iov[iovcnt].iov_base = &hdr;
+    iov[iovcnt++].iov_len = sizeof(hdr);
+    iov[iovcnt].iov_base = series->stream.buf;
+    iov[iovcnt++].iov_len = hdr.data_len;
+    total += sizeof(hdr) + hdr.data_len;
+
+    ssize_t written;
+    do {
+        written = writev(fd, iov, iovcnt);
+    } while (written < 0 && errno == EINTR);
+
+    if (written < 0 || (size_t)written != total) {
+        LOG_ERROR("TSDB short write to %s: %s", path,
+                  written < 0 ? strerror(errno) : "partial block");
+        if (written > 0 && ftruncate(fd, st.st_size) != 0) {
+            LOG_ERROR("TSDB failed to cut partial block off %s: %s", path, strerror(errno));
+        }
+        close(fd);
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    /* The block is in the file either way; only its durability is in doubt */
+    series_reset_block(series);
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+    if (sync && fdatasync(fd) != 0) {
+        LOG_ERROR("TSDB failed to sync %s: %s", path, strerror(errno));
+        result = PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+    close(fd);
+    return result;
+}
+
+/**
+ * @brief Run retention at most once per UTC day
+ */
+static void tsdb_maybe_retain(sensor_tsdb_t *db) {
+    if (db->retention_days == 0) {
+        return;
+    }
+
+    uint64_t now = time_realtime_ms();
+    uint_fast64_t today = now / TSDB_DAY_MS;
+    uint_fast64_t last = atomic_load_explicit(&db->retention_day, memory_order_relaxed);
+    if (last < today &&
+        atomic_compare_exchange_strong(&db->retention_day, &last, today)) {
+        sensor_tsdb_enforce_retention(db, now, NULL);
+    }
+}
+
+/* ============================================================================
+ * SENSOR TSDB API
+ * ========================================================================= */
+
+sensor_tsdb_t *sensor_tsdb_open(const char *path, uint32_t retention_days) {
+    if (!path || !*path) {
+        return NULL;
+    }
+
+    if (!make_dirs(path)) {
+        LOG_ERROR("TSDB failed to create %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    sensor_tsdb_t *db = calloc(1, sizeof(sensor_tsdb_t));
+    if (!db) {
+        return NULL;
+    }
+
+    db->path = strdup(path);
+    if (!db->path) {
+        free(db);
+        return NULL;
+    }
+
+    db->retention_days = retention_days;
+    pthread_mutex_init(&db->lock, NULL);
+    atomic_init(&db->retention_day, 0);
+
+    return db;
+}
+
+void sensor_tsdb_close(sensor_tsdb_t *db) {
+    if (!db) {
+        return;
+    }
+
+    sensor_tsdb_flush(db);
+
+    for (size_t i = 0; i < TSDB_SERIES_BUCKETS; i++) {
+        tsdb_series_t *series = db->buckets[i];
+        while (series) {
+            tsdb_series_t *next = series->next;
+            pthread_mutex_destroy(&series->lock);
+            free(series->stream.buf);
+            free(series->sensor_id);
+            free(series);
+            series = next;
+        }
+    }
+
+    pthread_mutex_destroy(&db->lock);
+    free(db->path);
+    free(db);
+}
+
+paumiot_result_t sensor_tsdb_append(sensor_tsdb_t *db, const char *sensor_id,
+                                    uint64_t timestamp, double value) {
+    if (!db || !sensor_id || !*sensor_id) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    tsdb_series_t *series = series_get(db, sensor_id, true);
+    if (!series) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_lock(&series->lock);
+
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+    bool flushed = false;
+
+    /* A block never spans two days, so dropping a day file drops whole blocks */
+    if (series->count > 0 &&
+        (series->count >= SENSOR_TSDB_BLOCK_POINTS || timestamp / TSDB_DAY_MS != series->day)) {
+        result = series_flush_locked(db, series, false);
+        flushed = result == PAUMIOT_SUCCESS;
+    }
+
+    if (result == PAUMIOT_SUCCESS) {
+        if (bits_reserve(&series->stream, TSDB_MAX_POINT_BYTES)) {
+            series_encode(series, timestamp, value);
+        } else {
+            result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    pthread_mutex_unlock(&series->lock);
+
+    if (flushed) {
+        tsdb_maybe_retain(db);
+    }
+
+    return result;
+}
+
+paumiot_result_t sensor_tsdb_flush(sensor_tsdb_t *db) {
+    if (!db) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+
+    /* Series are never removed while the store is open */
+    pthread_mutex_lock(&db->lock);
+    for (size_t i = 0; i < TSDB_SERIES_BUCKETS; i++) {
+        for (tsdb_series_t *series = db->buckets[i]; series; series = series->next) {
+            pthread_mutex_lock(&series->lock);
+            paumiot_result_t r = series_flush_locked(db, series, true);
+            pthread_mutex_unlock(&series->lock);
+            if (r != PAUMIOT_SUCCESS) {
+                result = r;
+            }
+        }
+    }
+    pthread_mutex_unlock(&db->lock);
+
+    return result;
+}
+
+static int compare_day(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Map every segment of a series whose day overlaps [start, end]
+ */
+static paumiot_result_t series_map_segments(const char *dir, uint64_t start, uint64_t end,
+                                            tsdb_mapping_t **maps, size_t *map_count) {
+    *maps = NULL;
+    *map_count = 0;
+
+    DIR *d = opendir(dir);
+    if (!d) {
+        return errno == ENOENT ? PAUMIOT_SUCCESS : PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    uint64_t first_day = start / TSDB_DAY_MS;
+    uint64_t last_day = end / TSDB_DAY_MS;
+    uint64_t *days = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    paumiot_result_t result = PAUMIOT_SUCCESS;
+
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        uint64_t day;
+        if (!segment_name_day(ent->d_name, &day) || day < first_day || day > last_day) {
+            continue;
+        }
+        if (count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 16;
+            uint64_t *tmp = realloc(days, grown * sizeof(uint64_t));
+            if (!tmp) {
+                result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            days = tmp;
+            capacity = grown;
+        }
+        days[count++] = day;
+    }
+    closedir(d);
+
+    if (result != PAUMIOT_SUCCESS || count == 0) {
+        free(days);
+        return result;
+    }
+
+    qsort(days, count, sizeof(uint64_t), compare_day);
+
+    tsdb_mapping_t *out = calloc(count, sizeof(tsdb_mapping_t));
+    if (!out) {
+        free(days);
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t mapped = 0;
+    for (size_t i = 0; i < count; i++) {
+        char path[TSDB_PATH_MAX];
+        if (!segment_path(dir, days[i], path, sizeof(path))) {
+            continue;
+        }
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            continue;  /* Removed by retention since the listing */
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && (size_t)st.st_size > sizeof(tsdb_segment_header_t)) {
+            void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+                out[mapped].addr = addr;
+                out[mapped].len = (size_t)st.st_size;
+                mapped++;
+            }
+        }
+        close(fd);
+    }
+
+    free(days);
+    *maps = out;
+    *map_count = mapped;
+    return PAUMIOT_SUCCESS;
+}
+
+static void segment_scan(const tsdb_mapping_t *map, uint64_t start, uint64_t end,
+                         sensor_tsdb_visit_fn visit, void *user_data) {
+    const uint8_t *base = map->addr;
+    tsdb_segment_header_t seg;
+    memcpy(&seg, base, sizeof(seg));
+    if (seg.magic != TSDB_SEGMENT_MAGIC || seg.version != TSDB_VERSION) {
+        return;
+    }
+
+    size_t offset = sizeof(seg);
+    while (map->len - offset >= sizeof(tsdb_block_header_t)) {
+        tsdb_block_header_t hdr;
+        memcpy(&hdr, base + offset, sizeof(hdr));
+        offset += sizeof(hdr);
+
+        if (hdr.magic != TSDB_BLOCK_MAGIC || hdr.data_len > map->len - offset) {
+            LOG_WARN("TSDB stopping at corrupt block (offset %zu)", offset - sizeof(hdr));
+            return;
+        }
+
+        /* Sparse index: skip blocks outside the range without decoding */
+        if (hdr.max_ts >= start && hdr.min_ts <= end) {
+            block_decode(&hdr, base + offset, start, end, visit, user_data);
+        }
+        offset += hdr.data_len;
+    }
+}
+
+paumiot_result_t sensor_tsdb_scan(sensor_tsdb_t *db, const char *sensor_id,
+                                  uint64_t start_time, uint64_t end_time,
+                                  sensor_tsdb_visit_fn visit, void *user_data) {
+    if (!db || !sensor_id || !*sensor_id || !visit || start_time > end_time) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    char dir[TSDB_PATH_MAX];
+    if (!series_dir_path(db, sensor_id, dir, sizeof(dir))) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    /* Hold the series lock while mapping so no flush lands between the
+     * mapped file sizes and the snapshot of the open block */
+    tsdb_series_t *series = series_get(db, sensor_id, false);
+    if (series) {
+        pthread_mutex_lock(&series->lock);
+    }
+
+    tsdb_mapping_t *maps = NULL;
+    size_t map_count = 0;
+    paumiot_result_t result = series_map_segments(dir, start_time, end_time, &maps, &map_count);
+
+    tsdb_block_header_t open_hdr = {0};
+    uint8_t *open_data = NULL;
+    if (result == PAUMIOT_SUCCESS && series && series->count > 0 &&
+        series->max_ts >= start_time && series->min_ts <= end_time) {
+        open_hdr.magic = TSDB_BLOCK_MAGIC;
+        open_hdr.count = series->count;
+        open_hdr.first_ts = series->first_ts;
+        open_hdr.min_ts = series->min_ts;
+        open_hdr.max_ts = series->max_ts;
+        open_hdr.data_len = (uint32_t)((series->stream.bit_pos + 7) / 8);
+        open_data = malloc(open_hdr.data_len);
+        if (open_data) {
+            memcpy(open_data, series->stream.buf, open_hdr.data_len);
+        } else {
+            result = PAUMIOT_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (series) {
+        pthread_mutex_unlock(&series->lock);
+    }
+
+    for (size_t i = 0; i < map_count; i++) {
+        if (result == PAUMIOT_SUCCESS) {
+            segment_scan(&maps[i], start_time, end_time, visit, user_data);
+        }
+        munmap(maps[i].addr, maps[i].len);
+    }
+    free(maps);
+
+    if (result == PAUMIOT_SUCCESS && open_data) {
+        block_decode(&open_hdr, open_data, start_time, end_time, visit, user_data);
+    }
+    free(open_data);
+
+    return result;
+}
+
+paumiot_result_t sensor_tsdb_enforce_retention(sensor_tsdb_t *db, uint64_t now_ms,
+                                               size_t *removed) {
+    if (!db) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+
+    size_t count = 0;
+    if (removed) {
+        *removed = 0;
+    }
+
+    uint64_t today = now_ms / TSDB_DAY_MS;
+    if (db->retention_days == 0 || today < db->retention_days) {
+        return PAUMIOT_SUCCESS;
+    }
+    uint64_t cutoff = today - db->retention_days;
+
+    DIR *root = opendir(db->path);
+    if (!root) {
+        return PAUMIOT_ERROR_OPERATION_FAILED;
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(root)) != NULL) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+
+        char dir[TSDB_PATH_MAX];
+        int written = snprintf(dir, sizeof(dir), "%s/%s", db->path, ent->d_name);
+        if (written < 0 || (size_t)written >= sizeof(dir)) {
+            continue;
+        }
+
+        DIR *series_dir = opendir(dir);
+        if (!series_dir) {
+            continue;
+        }
+
+        struct dirent *seg;
+        while ((seg = readdir(series_dir)) != NULL) {
+            uint64_t day;
+            char path[TSDB_PATH_MAX];
+            if (segment_name_day(seg->d_name, &day) && day < cutoff &&
+                segment_path(dir, day, path, sizeof(path)) && unlink(path) == 0) {
+                count++;
+            }
+        }
+        closedir(series_dir);
+    }
+    closedir(root);
+
+    if (count > 0) {
+        LOG_INFO("TSDB retention removed %zu segment(s) older than %u days",
+                 count, db->retention_days);
+    }
+    if (removed) {
+        *removed = count;
+    }
+
+    return PAUMIOT_SUCCESS;
+}
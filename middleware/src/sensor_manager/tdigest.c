@@ -0,0 +1,181 @@
+/**
+ * @file tdigest.c
+ * @brief Merging t-digest (Dunning) with the k1 scale function
+ */
+
+#include "tdigest.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * @brief k1 scale: maps a quantile onto [-compression/4, compression/4]
+ */
+static double tdigest_scale(double q) {
+    return (double)TDIGEST_COMPRESSION / (2.0 * M_PI) * asin(2.0 * q - 1.0);
+}
+
+static int centroid_compare(const void *a, const void *b) {
+    double x = ((const tdigest_centroid_t *)a)->mean;
+    double y = ((const tdigest_centroid_t *)b)->mean;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Merge buffered samples into the centroid list
+ */
+static void tdigest_compress(tdigest_t *td) {
+    if (td->num_buffered == 0) {
+        return;
+    }
+
+    tdigest_centroid_t merged[TDIGEST_MAX_CENTROIDS + TDIGEST_BUFFER_SIZE];
+    double total = td->total_weight;
+    size_t n = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    qsort(td->buffer, td->num_buffered, sizeof(tdigest_centroid_t), centroid_compare);
+    for (size_t k = 0; k < td->num_buffered; k++) {
+        total += td->buffer[k].weight;
+    }
+
+    /* Both lists are sorted; merge them by mean */
+    while (i < td->num_centroids || j < td->num_buffered) {
+        if (j >= td->num_buffered ||
+            (i < td->num_centroids && td->centroids[i].mean <= td->buffer[j].mean)) {
+            merged[n++] = td->centroids[i++];
+        } else {
+            merged[n++] = td->buffer[j++];
+        }
+    }
+
+    /* Greedily combine neighbours while the pair spans at most one k unit */
+    double weight_so_far = 0.0;
+    size_t out = 0;
+    tdigest_centroid_t cur = merged[0];
+
+    for (size_t k = 1; k < n; k++) {
+        double q_left = weight_so_far / total;
+        double q_right = (weight_so_far + cur.weight + merged[k].weight) / total;
+
+        if (tdigest_scale(q_right) - tdigest_scale(q_left) <= 1.0) {
+            double weight = cur.weight + merged[k].weight;
+            cur.mean += (merged[k].mean - cur.mean) * merged[k].weight / weight;
+            cur.weight = weight;
+        } else {
+            td->centroids[out++] = cur;
+            weight_so_far += cur.weight;
+            cur = merged[k];
+        }
+    }
+    td->centroids[out++] = cur;
+
+    td->num_centroids = out;
+    td->num_buffered = 0;
+    td->total_weight = total;
+}
+
+void tdigest_reset(tdigest_t *td) {
+    td->num_centroids = 0;
+    td->num_buffered = 0;
+    td->total_weight = 0.0;
+    td->min = INFINITY;
+    td->max = -INFINITY;
+}
+
+void tdigest_add(tdigest_t *td, double value, double weight) {
+    if (isnan(value) || weight <= 0.0) {
+        return;
+    }
+
+    if (td->num_buffered == TDIGEST_BUFFER_SIZE) {
+        tdigest_compress(td);
+    }
+
+    td->buffer[td->num_buffered].mean = value;
+    td->buffer[td->num_buffered].weight = weight;
+    td->num_buffered++;
+
+    if (value < td->min) {
+        td->min = value;
+    }
+    if (value > td->max) {
+        td->max = value;
+    }
+}
+
+void tdigest_merge(tdigest_t *dst, const tdigest_t *src) {
+    for (size_t i = 0; i < src->num_centroids; i++) {
+        tdigest_add(dst, src->centroids[i].mean, src->centroids[i].weight);
+    }
+    for (size_t i = 0; i < src->num_buffered; i++) {
+        tdigest_add(dst, src->buffer[i].mean, src->buffer[i].weight);
+    }
+
+    /* Centroid means lie inside the range; keep the exact extremes */
+    if (src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+double tdigest_quantile(tdigest_t *td, double q) {
+    tdigest_compress(td);
+
+    size_t n = td->num_centroids;
+    if (n == 0) {
+        return NAN;
+    }
+    if (q <= 0.0) {
+        return td->min;
+    }
+    if (q >= 1.0) {
+        return td->max;
+    }
+
+    const tdigest_centroid_t *c = td->centroids;
+    if (n == 1) {
+        return c[0].mean;
+    }
+
+    double index = q * td->total_weight;
+
+    /* Left tail: interpolate from the minimum to the first centre */
+    double half = c[0].weight / 2.0;
+    if (index < half) {
+        return td->min + (c[0].mean - td->min) * index / half;
+    }
+
+    /* Between centroid centres */
+    double cum = half;
+    for (size_t i = 0; i + 1 < n; i++) {
+        double span = (c[i].weight + c[i + 1].weight) / 2.0;
+        if (index < cum + span) {
+            double t = (index - cum) / span;
+            return c[i].mean + t * (c[i + 1].mean - c[i].mean);
+        }
+        cum += span;
+    }
+
+    /* Right tail: interpolate from the last centre to the maximum */
+    half = c[n - 1].weight / 2.0;
+    double t = (index - cum) / half;
+    if (t > 1.0) {
+        t = 1.0;
+    }
+    return c[n - 1].mean + t * (td->max - c[n - 1].mean);
+}
+
+double tdigest_count(const tdigest_t *td) {
+    double total = td->total_weight;
+    for (size_t i = 0; i < td->num_buffered; i++) {
+        total += td->buffer[i].weight;
+    }
+    return total;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file tdigest.h
+ * @brief Fixed-size merging t-digest for streaming quantiles
+ * @details Storage is inline so a digest can be embedded in per-sensor
+ *          window state without extra allocations. The k1 (arcsine) scale
+ *          function bounds the number of centroids by the compression.
+ */
+
+#ifndef PAUMIOT_TDIGEST_H
+#define PAUMIOT_TDIGEST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Compression (higher = more accurate tails, more memory) */
+#ifndef TDIGEST_COMPRESSION
+#define TDIGEST_COMPRESSION 50
+#endif
+
+#define TDIGEST_MAX_CENTROIDS (2 * TDIGEST_COMPRESSION)
+#define TDIGEST_BUFFER_SIZE 32
+
+/* Centroid */
+typedef struct {
+    double mean;
+    double weight;
+} tdigest_centroid_t;
+
+/* Digest */
+typedef struct {
+    size_t num_centroids;           /* Merged centroids (sorted by mean) */
+    size_t num_buffered;            /* Unmerged samples */
+    double total_weight;            /* Weight of merged centroids */
+    double min;
+    double max;
+    tdigest_centroid_t centroids[TDIGEST_MAX_CENTROIDS];
+    tdigest_centroid_t buffer[TDIGEST_BUFFER_SIZE];
+} tdigest_t;
+
+/**
+ * @brief Reset a digest to empty
+ */
+void tdigest_reset(tdigest_t *td);
+
+/**
+ * @brief Add a sample with the given weight
+ */
+void tdigest_add(tdigest_t *td, double value, double weight);
+
+/**
+ * @brief Fold all centroids of `src` into `dst`
+ */
+void tdigest_merge(tdigest_t *dst, const tdigest_t *src);
+
+/**
+ * @brief Estimate the q-quantile (0 <= q <= 1)
+ * @return Estimate, or NAN if the digest is empty
+ */
+double tdigest_quantile(tdigest_t *td, double q);
+
+/**
+ * @brief Total weight (merged and buffered)
+ */
+double tdigest_count(const tdigest_t *td);
+
+#endif /* PAUMIOT_TDIGEST_H */
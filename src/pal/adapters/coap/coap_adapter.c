@@ -105,17 +105,11 @@ typedef struct {
 /* CoAP Adapter State */
 typedef struct {
     uint16_t next_message_id;
-    uint64_t packets_decoded;
-    uint64_t packets_encoded;
-    uint64_t errors;
 } coap_adapter_state_t;
 
 /* Global CoAP adapter state */
 static coap_adapter_state_t g_coap_state = {
-    .next_message_id = 1,
-    .packets_decoded = 0,
-    .packets_encoded = 0,
-    .errors = 0
+    .next_message_id = 1
 };
 
 /* Helper Functions */
@@ -154,7 +148,7 @@ static paumiot_result_t coap_decode_option_ext(const uint8_t *buffer, size_t buf
 /**
  * @brief Encode option delta/length with extended values
  */
-static paumiot_result_t coap_encode_option_ext(uint16_t value, uint8_t *buffer,
+static paumiot_result_t coap_encode_option_ext(uint32_t value, uint8_t *buffer,
                                                size_t buf_len, size_t *pos,
                                                uint8_t *base_value) {
     if (!buffer || !pos || !base_value) {
@@ -394,7 +388,6 @@ static paumiot_result_t coap_adapter_decode(const protocol_adapter_t *adapter,
     coap_message_t coap_msg = {0};
     paumiot_result_t result = coap_decode_message(packet, packet_len, &coap_msg);
     if (result != PAUMIOT_SUCCESS) {
-        g_coap_state.errors++;
         return result;
     }
     
@@ -444,7 +437,6 @@ static paumiot_result_t coap_adapter_decode(const protocol_adapter_t *adapter,
     
     coap_free_message(&coap_msg);
     *message = msg;
-    g_coap_state.packets_decoded++;
     
     return PAUMIOT_SUCCESS;
 }
@@ -553,7 +545,6 @@ static paumiot_result_t coap_adapter_encode(const protocol_adapter_t *adapter,
     }
     
     *bytes_written = pos;
-    g_coap_state.packets_encoded++;
     
     return PAUMIOT_SUCCESS;
 }
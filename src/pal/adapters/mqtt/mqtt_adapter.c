@@ -41,19 +41,13 @@ typedef struct {
     uint16_t next_packet_id;
     uint8_t protocol_version;
     bool session_present;
-    uint64_t packets_decoded;
-    uint64_t packets_encoded;
-    uint64_t errors;
 } mqtt_adapter_state_t;
 
 /* Global MQTT adapter state */
 static mqtt_adapter_state_t g_mqtt_state = {
     .next_packet_id = 1,
     .protocol_version = MQTT_PROTOCOL_LEVEL_5,
-    .session_present = false,
-    .packets_decoded = 0,
-    .packets_encoded = 0,
-    .errors = 0
+    .session_present = false
 };
 
 /* Helper Functions */
@@ -193,16 +187,13 @@ static paumiot_result_t mqtt_decode_publish(const uint8_t *packet, size_t packet
     /* Extract QoS from flags */
     uint8_t qos = (flags >> 1) & 0x03;
     bool retain = flags & 0x01;
-    bool dup = (flags >> 3) & 0x01;
     
-    /* Decode packet identifier (if QoS > 0) */
-    uint16_t packet_id = 0;
+    /* Skip packet identifier (if QoS > 0); acknowledgement is not handled here */
     if (qos > 0) {
         if (pos + 2 > packet_len) {
             free(topic);
             return PAUMIOT_ERROR_PACKET_MALFORMED;
         }
-        packet_id = (packet[pos] << 8) | packet[pos + 1];
         pos += 2;
     }
     
@@ -246,7 +237,6 @@ static paumiot_result_t mqtt_decode_publish(const uint8_t *packet, size_t packet
     }
     
     *message = msg;
-    g_mqtt_state.packets_decoded++;
     
     return PAUMIOT_SUCCESS;
 }
@@ -339,7 +329,6 @@ static paumiot_result_t mqtt_encode_publish(const message_t *message, uint8_t *b
     }
     
     *bytes_written = pos;
-    g_mqtt_state.packets_encoded++;
     
     return PAUMIOT_SUCCESS;
 }
@@ -371,13 +360,11 @@ static paumiot_result_t mqtt_adapter_decode(const protocol_adapter_t *adapter,
     uint32_t remaining_len = 0;
     paumiot_result_t result = mqtt_decode_var_int(packet, packet_len, &pos, &remaining_len);
     if (result != PAUMIOT_SUCCESS) {
-        g_mqtt_state.errors++;
         return result;
     }
     
     /* Validate remaining length */
     if (pos + remaining_len != packet_len) {
-        g_mqtt_state.errors++;
         return PAUMIOT_ERROR_PACKET_MALFORMED;
     }
     
@@ -399,10 +386,6 @@ static paumiot_result_t mqtt_adapter_decode(const protocol_adapter_t *adapter,
             break;
     }
     
-    if (result != PAUMIOT_SUCCESS) {
-        g_mqtt_state.errors++;
-    }
-    
     return result;
 }
 
@@ -421,12 +404,7 @@ static paumiot_result_t mqtt_adapter_encode(const protocol_adapter_t *adapter,
         return PAUMIOT_ERROR_PROTOCOL;
     }
     
-    paumiot_result_t result = mqtt_encode_publish(message, packet, packet_len, bytes_written);
-    if (result != PAUMIOT_SUCCESS) {
-        g_mqtt_state.errors++;
-    }
-    
-    return result;
+    return mqtt_encode_publish(message, packet, packet_len, bytes_written);
 }
 
 /**
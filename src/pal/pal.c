@@ -14,6 +14,10 @@
 #include <time.h>
 #include <uuid/uuid.h>
 
+/* Slot of the calling thread + 1 (0 = not assigned yet) */
+static __thread unsigned g_stats_slot_plus_one;
+static atomic_uint g_next_stats_slot;
+
 /* Message Utilities Implementation */
 
 /**
@@ -190,6 +194,171 @@ paumiot_result_t message_set_payload(message_t *message, const uint8_t *payload,
     return PAUMIOT_SUCCESS;
 }
 
+/* Statistics */
+
+/**
+ * @brief Give each thread its own counter cell
+ */
+unsigned pal_stats_thread_slot(void) {
+    unsigned slot = g_stats_slot_plus_one;
+    if (slot) {
+        return slot - 1;
+    }
+    
+    /* Threads beyond PAL_STATS_MAX_THREADS share cells; adds stay atomic */
+    slot = atomic_fetch_add_explicit(&g_next_stats_slot, 1, memory_order_relaxed) %
+           PAL_STATS_MAX_THREADS;
+    g_stats_slot_plus_one = slot + 1;
+    return slot;
+}
+
+/**
+ * @brief Count a failure under its result code
+ */
+void pal_stats_record_error(const protocol_adapter_t *adapter, paumiot_result_t result) {
+    if (!adapter || !adapter->stats || result == PAUMIOT_SUCCESS) {
+        return;
+    }
+    
+    pal_stats_counters_t *c = &adapter->stats->cells[pal_stats_thread_slot()].counters;
+    
+    for (size_t i = 0; i < PAL_STATS_MAX_ERROR_CODES; i++) {
+        int code = atomic_load_explicit(&c->error_codes[i], memory_order_acquire);
+        
+        /* Claim a free entry; a thread sharing the cell may win the race */
+        if (code == 0) {
+            int expected = 0;
+            if (atomic_compare_exchange_strong_explicit(&c->error_codes[i], &expected,
+                                                        (int)result,
+                                                        memory_order_acq_rel,
+                                                        memory_order_acquire)) {
+                code = (int)result;
+            } else {
+                code = expected;
+            }
+        }
+        
+        if (code == (int)result) {
+            atomic_fetch_add_explicit(&c->error_counts[i], 1, memory_order_relaxed);
+            return;
+        }
+    }
+    
+    atomic_fetch_add_explicit(&c->errors_other, 1, memory_order_relaxed);
+}
+
+static uint64_t stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void stats_record_decode_latency(const protocol_adapter_t *adapter, uint64_t ns) {
+    if (!adapter->stats) {
+        return;
+    }
+    
+    size_t bucket = 0;
+    while (bucket < PAL_STATS_LATENCY_BUCKETS - 1 &&
+           ns >= (1ULL << (PAL_STATS_LATENCY_MIN_SHIFT + bucket))) {
+        bucket++;
+    }
+    
+    ADAPTER_UPDATE_STATS(adapter, decode_latency[bucket], 1);
+    ADAPTER_UPDATE_STATS(adapter, decode_latency_sum_ns, ns);
+}
+
+static uint64_t stats_load(const atomic_uint_fast64_t *value) {
+    return atomic_load_explicit(value, memory_order_relaxed);
+}
+
+/**
+ * @brief Sum the cells of an adapter's statistics
+ */
+static void stats_merge(const pal_stats_t *stats, pal_adapter_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (!stats) {
+        return;
+    }
+    
+    for (size_t t = 0; t < PAL_STATS_MAX_THREADS; t++) {
+        const pal_stats_counters_t *c = &stats->cells[t].counters;
+        
+        out->packets_decoded += stats_load(&c->packets_decoded);
+        out->bytes_decoded += stats_load(&c->bytes_decoded);
+        out->packets_encoded += stats_load(&c->packets_encoded);
+        out->bytes_encoded += stats_load(&c->bytes_encoded);
+        out->decode_errors += stats_load(&c->decode_errors);
+        out->encode_errors += stats_load(&c->encode_errors);
+        out->errors_other += stats_load(&c->errors_other);
+        out->decode_latency_sum_ns += stats_load(&c->decode_latency_sum_ns);
+        
+        for (size_t b = 0; b < PAL_STATS_LATENCY_BUCKETS; b++) {
+            out->decode_latency[b] += stats_load(&c->decode_latency[b]);
+        }
+        
+        for (size_t i = 0; i < PAL_STATS_MAX_ERROR_CODES; i++) {
+            int code = atomic_load_explicit(&c->error_codes[i], memory_order_acquire);
+            if (code == 0) {
+                break;
+            }
+            
+            uint64_t count = stats_load(&c->error_counts[i]);
+            size_t j = 0;
+            while (j < out->num_error_codes && (int)out->errors[j].code != code) {
+                j++;
+            }
+            
+            if (j < out->num_error_codes) {
+                out->errors[j].count += count;
+            } else if (j < PAL_STATS_MAX_ERROR_CODES) {
+                out->errors[j].code = (paumiot_result_t)code;
+                out->errors[j].count = count;
+                out->num_error_codes++;
+            } else {
+                out->errors_other += count;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Add an adapter's counters to system-wide totals
+ */
+static void stats_accumulate(const pal_stats_t *stats, system_stats_t *totals) {
+    pal_adapter_stats_t merged;
+    stats_merge(stats, &merged);
+    
+    totals->messages_received += merged.packets_decoded;
+    totals->bytes_received += merged.bytes_decoded;
+    totals->messages_sent += merged.packets_encoded;
+    totals->bytes_sent += merged.bytes_encoded;
+    totals->errors += merged.decode_errors + merged.encode_errors;
+}
+
+/**
+ * @brief Attach zeroed statistics to an adapter being registered
+ */
+static paumiot_result_t stats_attach(protocol_adapter_t *adapter) {
+    void *stats = NULL;
+    if (posix_memalign(&stats, PAL_STATS_CACHE_LINE, sizeof(pal_stats_t)) != 0) {
+        return PAUMIOT_ERROR_OUT_OF_MEMORY;
+    }
+    
+    memset(stats, 0, sizeof(pal_stats_t));
+    adapter->stats = stats;
+    return PAUMIOT_SUCCESS;
+}
+
+/**
+ * @brief Fold an adapter's counters into the context and free them
+ */
+static void stats_detach(pal_context_t *ctx, protocol_adapter_t *adapter) {
+    stats_accumulate(adapter->stats, &ctx->stats);
+    free(adapter->stats);
+    adapter->stats = NULL;
+}
+
 /* PAL Core Implementation */
 
 /**
@@ -233,6 +402,9 @@ void pal_cleanup(pal_context_t *ctx) {
         if (ctx->adapters[i] && ctx->adapters[i]->cleanup) {
             ctx->adapters[i]->cleanup(ctx->adapters[i]);
         }
+        if (ctx->adapters[i]) {
+            stats_detach(ctx, ctx->adapters[i]);
+        }
     }
     
     free(ctx->adapters);
@@ -271,6 +443,14 @@ paumiot_result_t pal_register_adapter(pal_context_t *ctx, protocol_adapter_t *ad
         }
     }
     
+    paumiot_result_t result = stats_attach(adapter);
+    if (result != PAUMIOT_SUCCESS) {
+        if (adapter->cleanup) {
+            adapter->cleanup(adapter);
+        }
+        return result;
+    }
+    
     /* Register adapter */
     ctx->adapters[ctx->num_adapters] = adapter;
     ctx->num_adapters++;
@@ -297,6 +477,7 @@ paumiot_result_t pal_unregister_adapter(pal_context_t *ctx, protocol_type_t prot
             if (ctx->adapters[i]->cleanup) {
                 ctx->adapters[i]->cleanup(ctx->adapters[i]);
             }
+            stats_detach(ctx, ctx->adapters[i]);
             
             /* Shift remaining adapters */
             for (size_t j = i; j < ctx->num_adapters - 1; j++) {
@@ -353,14 +534,17 @@ paumiot_result_t pal_decode_packet(pal_context_t *ctx, protocol_type_t protocol_
         return PAUMIOT_ERROR_NOT_SUPPORTED;
     }
     
+    uint64_t start = stats_now_ns();
     paumiot_result_t result = adapter->decode(adapter, packet, packet_len, message);
+    stats_record_decode_latency(adapter, stats_now_ns() - start);
     
     /* Update statistics */
     if (result == PAUMIOT_SUCCESS) {
-        ctx->stats.messages_received++;
-        ctx->stats.bytes_received += packet_len;
+        ADAPTER_UPDATE_STATS(adapter, packets_decoded, 1);
+        ADAPTER_UPDATE_STATS(adapter, bytes_decoded, packet_len);
     } else {
-        ctx->stats.errors++;
+        ADAPTER_UPDATE_STATS(adapter, decode_errors, 1);
+        pal_stats_record_error(adapter, result);
     }
     
     return result;
@@ -393,10 +577,11 @@ paumiot_result_t pal_encode_message(pal_context_t *ctx, const message_t *message
     
     /* Update statistics */
     if (result == PAUMIOT_SUCCESS) {
-        ctx->stats.messages_sent++;
-        ctx->stats.bytes_sent += *bytes_written;
+        ADAPTER_UPDATE_STATS(adapter, packets_encoded, 1);
+        ADAPTER_UPDATE_STATS(adapter, bytes_encoded, *bytes_written);
     } else {
-        ctx->stats.errors++;
+        ADAPTER_UPDATE_STATS(adapter, encode_errors, 1);
+        pal_stats_record_error(adapter, result);
     }
     
     return result;
@@ -415,5 +600,31 @@ paumiot_result_t pal_get_stats(pal_context_t *ctx, system_stats_t *stats) {
     }
     
     *stats = ctx->stats;
+    for (size_t i = 0; i < ctx->num_adapters; i++) {
+        stats_accumulate(ctx->adapters[i]->stats, stats);
+    }
+    
+    return PAUMIOT_SUCCESS;
+}
+
+/**
+ * @brief Get statistics of one adapter
+ */
+paumiot_result_t pal_get_adapter_stats(pal_context_t *ctx, protocol_type_t protocol_type,
+                                       pal_adapter_stats_t *stats) {
+    if (!ctx || !stats) {
+        return PAUMIOT_ERROR_INVALID_PARAM;
+    }
+    
+    if (!ctx->initialized) {
+        return PAUMIOT_ERROR_NOT_INITIALIZED;
+    }
+    
+    protocol_adapter_t *adapter = pal_find_adapter(ctx, protocol_type);
+    if (!adapter) {
+        return PAUMIOT_ERROR_PROTOCOL_UNKNOWN;
+    }
+    
+    stats_merge(adapter->stats, stats);
     return PAUMIOT_SUCCESS;
 }
\ No newline at end of file
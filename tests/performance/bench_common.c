@@ -0,0 +1,204 @@
+/**
+ * @file bench_common.c
+ * @brief Microbenchmarks of the common utilities' hot paths
+ * @details Usage: bench_common [--samples N] [--warmup N] [--scale X] [--filter NAME]
+ *          Prints one JSON object per benchmark (see bench_harness.h).
+ *
+ *          queue_*      one operation = one element enqueued and dequeued
+ *          pool_*       one operation = one block allocated and freed
+ *          pipeline_*   one operation = one pooled message filled, queued,
+ *                       dequeued, checksummed and freed (single thread)
+ *          log_message  one operation = one call; "emitted" writes to
+ *                       /dev/null, "filtered" is below the log level
+ */
+
+#include "bench_harness.h"
+#include "queue.h"
+#include "memory_pool.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define QUEUE_CAPACITY 1024
+#define MESSAGE_SIZE 64
+#define BURST 256
+#define PIPELINE_DEPTH 16               /* Queue capacity of the integration test */
+
+typedef struct {
+    queue_t *queue;
+    uint8_t element[MESSAGE_SIZE];
+} queue_bench_t;
+
+typedef struct {
+    memory_pool_t *pool;
+    void *blocks[BURST];
+} pool_bench_t;
+
+typedef struct {
+    memory_pool_t *pool;
+    queue_t *queue;                     /* Of message pointers */
+} pipeline_bench_t;
+
+/* ============================================================================
+ * QUEUE
+ * ========================================================================= */
+
+/* Producer and consumer in lockstep: the queue stays nearly empty */
+static void queue_ping(void *arg, size_t ops) {
+    queue_bench_t *b = arg;
+    uint8_t out[MESSAGE_SIZE];
+
+    for (size_t i = 0; i < ops; i++) {
+        b->element[0] = (uint8_t)i;
+        queue_enqueue(b->queue, b->element);
+        queue_dequeue(b->queue, out);
+    }
+    bench_consume(out[0]);
+}
+
+/* Fill BURST elements, then drain them, like a consumer that fell behind */
+static void queue_burst(void *arg, size_t ops) {
+    queue_bench_t *b = arg;
+    uint8_t out[MESSAGE_SIZE];
+
+    for (size_t done = 0; done < ops; done += BURST) {
+        size_t n = ops - done < BURST ? ops - done : BURST;
+        for (size_t i = 0; i < n; i++) {
+            queue_enqueue(b->queue, b->element);
+        }
+        for (size_t i = 0; i < n; i++) {
+            queue_dequeue(b->queue, out);
+        }
+    }
+    bench_consume(out[0]);
+}
+
+/* ============================================================================
+ * MEMORY POOL
+ * ========================================================================= */
+
+static void pool_ping(void *arg, size_t ops) {
+    pool_bench_t *b = arg;
+
+    for (size_t i = 0; i < ops; i++) {
+        void *block = pool_alloc(b->pool);
+        bench_consume((uintptr_t)block);
+        pool_free(b->pool, block);
+    }
+}
+
+static void pool_burst(void *arg, size_t ops) {
+    pool_bench_t *b = arg;
+
+    for (size_t done = 0; done < ops; done += BURST) {
+        size_t n = ops - done < BURST ? ops - done : BURST;
+        for (size_t i = 0; i < n; i++) {
+            b->blocks[i] = pool_alloc(b->pool);
+        }
+        for (size_t i = n; i-- > 0;) {
+            pool_free(b->pool, b->blocks[i]);
+        }
+    }
+}
+
+/* ============================================================================
+ * PIPELINE
+ * ========================================================================= */
+
+/* The integration test's producer/consumer pipeline without the threads:
+ * fill the queue with pooled messages, then drain it */
+static void pipeline(void *arg, size_t ops) {
+    pipeline_bench_t *b = arg;
+    uint32_t checksum = 0;
+
+    for (size_t done = 0; done < ops; done += PIPELINE_DEPTH) {
+        size_t n = ops - done < PIPELINE_DEPTH ? ops - done : PIPELINE_DEPTH;
+        for (size_t i = 0; i < n; i++) {
+            uint8_t *msg = pool_alloc(b->pool);
+            memset(msg, (int)(done + i), MESSAGE_SIZE);
+            queue_enqueue(b->queue, &msg);
+        }
+        for (size_t i = 0; i < n; i++) {
+            uint8_t *msg;
+            queue_dequeue(b->queue, &msg);
+            for (size_t j = 0; j < MESSAGE_SIZE; j++) {
+                checksum += msg[j];
+            }
+            pool_free(b->pool, msg);
+        }
+    }
+    bench_consume(checksum);
+}
+
+/* ============================================================================
+ * LOGGING
+ * ========================================================================= */
+
+static void log_calls(void *arg, size_t ops) {
+    log_level_t level = *(const log_level_t *)arg;
+
+    for (size_t i = 0; i < ops; i++) {
+        log_message(level, __FILE__, __LINE__, "sensor %s value %d", "t1", (int)i);
+    }
+}
+
+int main(int argc, char **argv) {
+    bench_options_t options;
+    if (bench_parse_args(argc, argv, "common", &options) != 0) {
+        return 1;
+    }
+
+    queue_bench_t qb;
+    memset(&qb, 0, sizeof(qb));
+    qb.queue = queue_create(QUEUE_CAPACITY, MESSAGE_SIZE);
+    pool_bench_t pb;
+    memset(&pb, 0, sizeof(pb));
+    pb.pool = pool_create(BURST, MESSAGE_SIZE);
+    pipeline_bench_t lb;
+    lb.pool = pool_create(2 * PIPELINE_DEPTH, MESSAGE_SIZE);
+    lb.queue = queue_create(PIPELINE_DEPTH, sizeof(uint8_t *));
+    if (!qb.queue || !pb.pool || !lb.pool || !lb.queue) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    bench_run(&options, "queue_enqueue_dequeue", 4096, queue_ping, &qb, NULL);
+    bench_run(&options, "queue_burst_256", 4096, queue_burst, &qb, NULL);
+    bench_run(&options, "pool_alloc_free", 4096, pool_ping, &pb, NULL);
+    bench_run(&options, "pool_burst_256", 4096, pool_burst, &pb, NULL);
+    bench_run(&options, "pipeline_pool_queue", 4096, pipeline, &lb, NULL);
+
+    /* Log lines go to stderr; send them to /dev/null while measuring */
+    int saved_stderr = dup(STDERR_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (saved_stderr >= 0 && devnull >= 0) {
+        log_set_level(LOG_LEVEL_INFO);
+        log_level_t filtered = LOG_LEVEL_DEBUG;
+        log_level_t emitted = LOG_LEVEL_INFO;
+
+        fflush(stderr);
+        dup2(devnull, STDERR_FILENO);
+        bench_run(&options, "log_message_filtered", 4096, log_calls, &filtered, NULL);
+        /* Writing the line makes this one noisier than the rest */
+        options.threshold = 0.25;
+        bench_run(&options, "log_message_emitted", 256, log_calls, &emitted, NULL);
+        options.threshold = 0.0;
+        fflush(stderr);
+        dup2(saved_stderr, STDERR_FILENO);
+    }
+    if (devnull >= 0) {
+        close(devnull);
+    }
+    if (saved_stderr >= 0) {
+        close(saved_stderr);
+    }
+
+    queue_destroy(qb.queue);
+    pool_destroy(pb.pool);
+    queue_destroy(lb.queue);
+    pool_destroy(lb.pool);
+    return 0;
+}
@@ -0,0 +1,383 @@
+/**
+ * @file bench_compare.c
+ * @brief Compare repeated benchmark runs against a stored baseline
+ * @details Usage: bench_compare [--threshold PCT] [--update] BASELINE RUNS...
+ *
+ *          RUNS are files of benchmark JSON lines (see bench_harness.h),
+ *          typically several passes of the same suites appended together.
+ *          Every pass contributes one ns_per_op value per benchmark; the
+ *          tool reports the median over the passes with a distribution-free
+ *          95% confidence interval (order statistics of the binomial), and
+ *          compares it to the baseline entry of the same suite and name.
+ *
+ *          A benchmark regresses when its median is more than the threshold
+ *          (default 10%, or the "threshold" of its baseline entry or, failing
+ *          that, of its runs) above the baseline
+ *          AND its interval lies entirely above the baseline interval, so
+ *          one noisy pass does not fail the check. An increase in
+ *          allocations per operation is a regression at any size, since it
+ *          is deterministic.
+ *
+ *          The baseline holds one flat JSON object per benchmark:
+ *
+ *          {"suite":"pal","name":"mqtt_decode_mix","runs":5,"ns_per_op":4440,
+ *           "ci_low_ns":4402,"ci_high_ns":4480,"allocs_per_op":5}
+ *
+ *          Absolute timings only compare on the machine that produced them,
+ *          so the baseline is recorded locally (make bench-baseline) rather
+ *          than shared. --update rewrites BASELINE from the runs, keeping
+ *          per-entry thresholds. Exit status: 0 pass, 1 regression, 2 usage
+ *          or I/O (including a missing baseline).
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BENCHMARKS 256
+#define MAX_RUNS 64
+#define MAX_OBJECT 1024
+#define DEFAULT_THRESHOLD 0.10
+#define CONFIDENCE 0.95
+
+typedef struct {
+    char suite[32];
+    char name[64];
+
+    /* Current runs */
+    double values[MAX_RUNS];
+    size_t runs;
+    double allocs;                      /* Highest seen, negative if unknown */
+
+    /* Baseline */
+    bool has_baseline;
+    double base_ns;
+    double base_low;
+    double base_high;
+    double base_allocs;                 /* Negative if unknown */
+    double threshold;                   /* Negative = command line default */
+} entry_t;
+
+typedef struct {
+    entry_t entries[MAX_BENCHMARKS];
+    size_t count;
+} table_t;
+
+/* ============================================================================
+ * FLAT JSON OBJECTS
+ * ========================================================================= */
+
+static bool json_string(const char *obj, const char *key, char *out, size_t size) {
+    char pattern[48];
+    snprintf(pattern, sizeof(pattern), "\"%s\":\"", key);
+    const char *p = strstr(obj, pattern);
+    if (!p) {
+        return false;
+    }
+    p += strlen(pattern);
+    const char *end = strchr(p, '"');
+    if (!end || (size_t)(end - p) >= size) {
+        return false;
+    }
+    memcpy(out, p, (size_t)(end - p));
+    out[end - p] = '\0';
+    return true;
+}
+
+/* false for a missing key or null */
+static bool json_number(const char *obj, const char *key, double *out) {
+    char pattern[48];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(obj, pattern);
+    if (!p) {
+        return false;
+    }
+    char *end;
+    *out = strtod(p + strlen(pattern), &end);
+    return end != p + strlen(pattern);
+}
+
+static entry_t *find_entry(table_t *table, const char *suite, const char *name) {
+    for (size_t i = 0; i < table->count; i++) {
+        entry_t *e = &table->entries[i];
+        if (strcmp(e->suite, suite) == 0 && strcmp(e->name, name) == 0) {
+            return e;
+        }
+    }
+    if (table->count == MAX_BENCHMARKS) {
+        return NULL;
+    }
+
+    entry_t *e = &table->entries[table->count++];
+    memset(e, 0, sizeof(*e));
+    snprintf(e->suite, sizeof(e->suite), "%s", suite);
+    snprintf(e->name, sizeof(e->name), "%s", name);
+    e->allocs = -1;
+    e->base_allocs = -1;
+    e->threshold = -1;
+    return e;
+}
+
+/**
+ * Call fn for every top-level {...} object in a file
+ * @return false if the file cannot be read
+ */
+static bool for_each_object(const char *path, table_t *table, bool baseline,
+                            void (*fn)(table_t *, const char *, bool)) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+
+    char obj[MAX_OBJECT];
+    size_t len = 0;
+    bool inside = false;
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        if (c == '{') {
+            inside = true;
+            len = 0;
+        } else if (c == '}' && inside) {
+            obj[len] = '\0';
+            fn(table, obj, baseline);
+            inside = false;
+        } else if (inside && len < sizeof(obj) - 1) {
+            obj[len++] = (char)c;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static void add_object(table_t *table, const char *obj, bool baseline) {
+    char suite[32];
+    char name[64];
+    double ns;
+    if (!json_string(obj, "suite", suite, sizeof(suite)) ||
+        !json_string(obj, "name", name, sizeof(name)) || !json_number(obj, "ns_per_op", &ns)) {
+        return;
+    }
+    entry_t *e = find_entry(table, suite, name);
+    if (!e) {
+        return;
+    }
+
+    double allocs;
+    bool has_allocs = json_number(obj, "allocs_per_op", &allocs);
+
+    if (baseline) {
+        e->has_baseline = true;
+        e->base_ns = ns;
+        if (!json_number(obj, "ci_low_ns", &e->base_low)) {
+            e->base_low = ns;
+        }
+        if (!json_number(obj, "ci_high_ns", &e->base_high)) {
+            e->base_high = ns;
+        }
+        e->base_allocs = has_allocs ? allocs : -1;
+        if (!json_number(obj, "threshold", &e->threshold)) {
+            e->threshold = -1;
+        }
+        return;
+    }
+
+    if (e->runs < MAX_RUNS) {
+        e->values[e->runs++] = ns;
+    }
+    if (has_allocs && allocs > e->allocs) {
+        e->allocs = allocs;
+    }
+    if (e->threshold < 0 && !json_number(obj, "threshold", &e->threshold)) {
+        e->threshold = -1;
+    }
+}
+
+/* ============================================================================
+ * STATISTICS
+ * ========================================================================= */
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(const double *sorted, size_t n) {
+    return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+/**
+ * Distribution-free confidence interval of the median
+ * @details [x(j), x(n-j+1)] covers the median with probability
+ *          1 - 2 * P(Binomial(n, 1/2) < j). Picks the narrowest such
+ *          interval reaching CONFIDENCE; below 6 runs that is the full range.
+ */
+static void median_interval(const double *sorted, size_t n, double *low, double *high) {
+    size_t j = 1;                       /* 1-based order statistic */
+    double tail = pow(0.5, (double)n);  /* P(X <= j - 1) for j = 1 */
+    double term = tail;
+
+    for (size_t k = 1; k < n / 2; k++) {
+        term = term * (double)(n - k + 1) / (double)k;
+        if (1.0 - 2.0 * (tail + term) < CONFIDENCE) {
+            break;
+        }
+        tail += term;
+        j = k + 1;
+    }
+    *low = sorted[j - 1];
+    *high = sorted[n - j];
+}
+
+/* ============================================================================
+ * REPORT
+ * ========================================================================= */
+
+typedef struct {
+    double median;
+    double low;
+    double high;
+} summary_t;
+
+static summary_t summarize(entry_t *e) {
+    summary_t s = { 0, 0, 0 };
+    if (e->runs == 0) {
+        return s;
+    }
+    qsort(e->values, e->runs, sizeof(double), compare_doubles);
+    s.median = median(e->values, e->runs);
+    median_interval(e->values, e->runs, &s.low, &s.high);
+    return s;
+}
+
+static int write_baseline(const char *path, table_t *table) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return 2;
+    }
+
+    fprintf(f, "[\n");
+    bool first = true;
+    for (size_t i = 0; i < table->count; i++) {
+        entry_t *e = &table->entries[i];
+        if (e->runs == 0) {
+            continue;                   /* Dropped from the suite */
+        }
+        summary_t s = summarize(e);
+        fprintf(f, "%s{\"suite\":\"%s\",\"name\":\"%s\",\"runs\":%zu,\"ns_per_op\":%.4g,"
+                   "\"ci_low_ns\":%.4g,\"ci_high_ns\":%.4g",
+                first ? "" : ",\n", e->suite, e->name, e->runs, s.median, s.low, s.high);
+        if (e->allocs >= 0) {
+            fprintf(f, ",\"allocs_per_op\":%.4g", e->allocs);
+        }
+        if (e->threshold >= 0) {
+            fprintf(f, ",\"threshold\":%.4g", e->threshold);
+        }
+        fprintf(f, "}");
+        first = false;
+    }
+    fprintf(f, "\n]\n");
+
+    if (fclose(f) != 0) {
+        perror(path);
+        return 2;
+    }
+    printf("Baseline written to %s\n", path);
+    return 0;
+}
+
+static int compare(table_t *table, double default_threshold) {
+    size_t regressions = 0;
+    size_t compared = 0;
+
+    printf("%-34s %12s %28s %8s  %s\n", "benchmark", "baseline ns", "median ns [95% CI]",
+           "change", "verdict");
+
+    for (size_t i = 0; i < table->count; i++) {
+        entry_t *e = &table->entries[i];
+        char label[100];
+        snprintf(label, sizeof(label), "%s/%s", e->suite, e->name);
+
+        if (e->runs == 0) {
+            printf("%-34s %12.4g %28s %8s  missing\n", label, e->base_ns, "-", "-");
+            continue;
+        }
+
+        summary_t s = summarize(e);
+        char current[64];
+        snprintf(current, sizeof(current), "%.4g [%.4g, %.4g]", s.median, s.low, s.high);
+
+        if (!e->has_baseline) {
+            printf("%-34s %12s %28s %8s  new\n", label, "-", current, "-");
+            continue;
+        }
+
+        compared++;
+        double threshold = e->threshold >= 0 ? e->threshold : default_threshold;
+        double change = e->base_ns > 0 ? s.median / e->base_ns - 1.0 : 0.0;
+        const char *verdict = "ok";
+
+        if (e->base_allocs >= 0 && e->allocs > e->base_allocs + 1e-9) {
+            verdict = "REGRESSION (allocations)";
+            regressions++;
+        } else if (change > threshold && s.low > e->base_high) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (change > threshold) {
+            verdict = "slower, within noise";
+        } else if (change < -threshold && s.high < e->base_low) {
+            verdict = "faster";
+        }
+
+        printf("%-34s %12.4g %28s %+7.1f%%  %s\n", label, e->base_ns, current, change * 100.0,
+               verdict);
+    }
+
+    printf("\n%zu compared, %zu regressed (threshold %.0f%%)\n", compared, regressions,
+           default_threshold * 100.0);
+    return regressions ? 1 : 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--threshold PCT] [--update] BASELINE RUNS...\n", prog);
+}
+
+int main(int argc, char **argv) {
+    double threshold = DEFAULT_THRESHOLD;
+    bool update = false;
+    int arg = 1;
+
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--update") == 0) {
+            update = true;
+        } else if (strcmp(argv[arg], "--threshold") == 0 && arg + 1 < argc) {
+            threshold = strtod(argv[++arg], NULL) / 100.0;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - arg < 2 || threshold <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    static table_t table;
+    const char *baseline = argv[arg++];
+    if (!for_each_object(baseline, &table, true, add_object) && !update) {
+        perror(baseline);
+        fprintf(stderr, "Record a baseline on this machine first: make bench-baseline\n");
+        return 2;
+    }
+    for (; arg < argc; arg++) {
+        if (!for_each_object(argv[arg], &table, false, add_object)) {
+            perror(argv[arg]);
+            return 2;
+        }
+    }
+
+    return update ? write_baseline(baseline, &table) : compare(&table, threshold);
+}
@@ -0,0 +1,256 @@
+/**
+ * @file bench_harness.c
+ * @brief Microbenchmark harness implementation
+ */
+
+#include "bench_harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+/* ============================================================================
+ * ALLOCATION COUNTING
+ * ========================================================================= */
+
+#ifdef __GLIBC__
+
+/*
+ * Interpose the allocator entry points and forward to glibc. Calls made
+ * inside libc (strdup, fopen, ...) go through these too.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static atomic_uint_fast64_t g_allocations;
+
+void *malloc(size_t size) {
+    atomic_fetch_add_explicit(&g_allocations, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    atomic_fetch_add_explicit(&g_allocations, 1, memory_order_relaxed);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    atomic_fetch_add_explicit(&g_allocations, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+uint64_t bench_allocations(void) {
+    return atomic_load_explicit(&g_allocations, memory_order_relaxed);
+}
+
+#else
+
+uint64_t bench_allocations(void) {
+    return UINT64_MAX;
+}
+
+#endif
+
+/* ============================================================================
+ * HELPERS
+ * ========================================================================= */
+
+static volatile uintptr_t g_sink;
+
+void bench_consume(uintptr_t value) {
+    g_sink += value;
+}
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted values */
+static double percentile(const double *sorted, size_t n, double p) {
+    size_t rank = (size_t)(p / 100.0 * (double)n + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > n) {
+        rank = n;
+    }
+    return sorted[rank - 1];
+}
+
+/* ============================================================================
+ * HISTOGRAM
+ * ========================================================================= */
+
+static unsigned hist_index(uint64_t ns) {
+    if (ns < (1u << BENCH_HIST_SUB_BITS)) {
+        return (unsigned)ns;
+    }
+    unsigned shift = 63 - (unsigned)__builtin_clzll(ns) - BENCH_HIST_SUB_BITS;
+    unsigned sub = (unsigned)(ns >> shift) & ((1u << BENCH_HIST_SUB_BITS) - 1);
+    return (shift + 1) << BENCH_HIST_SUB_BITS | sub;
+}
+
+static uint64_t hist_upper(unsigned index) {
+    if (index < (1u << BENCH_HIST_SUB_BITS)) {
+        return index;
+    }
+    unsigned shift = (index >> BENCH_HIST_SUB_BITS) - 1;
+    uint64_t sub = index & ((1u << BENCH_HIST_SUB_BITS) - 1);
+    return (((1ULL << BENCH_HIST_SUB_BITS) | sub) << shift) + (1ULL << shift) - 1;
+}
+
+void bench_hist_record(bench_hist_t *hist, uint64_t ns) {
+    hist->counts[hist_index(ns)]++;
+    hist->total++;
+    if (ns > hist->max) {
+        hist->max = ns;
+    }
+}
+
+void bench_hist_merge(bench_hist_t *dst, const bench_hist_t *src) {
+    for (unsigned i = 0; i < BENCH_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+uint64_t bench_hist_percentile(const bench_hist_t *hist, double p) {
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)hist->total + 0.5);
+    uint64_t seen = 0;
+
+    rank = rank ? rank : 1;
+    for (unsigned i = 0; i < BENCH_HIST_BUCKETS && hist->total; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            return hist_upper(i) < hist->max ? hist_upper(i) : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+/* ============================================================================
+ * HARNESS API
+ * ========================================================================= */
+
+int bench_parse_args(int argc, char **argv, const char *suite, bench_options_t *options) {
+    options->suite = suite;
+    options->samples = BENCH_DEFAULT_SAMPLES;
+    options->warmup = BENCH_DEFAULT_WARMUP;
+    options->scale = 1.0;
+    options->filter = NULL;
+    options->threshold = 0.0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--samples") == 0 && value) {
+            options->samples = strtoul(value, NULL, 10);
+        } else if (strcmp(argv[i], "--warmup") == 0 && value) {
+            options->warmup = strtoul(value, NULL, 10);
+        } else if (strcmp(argv[i], "--scale") == 0 && value) {
+            options->scale = strtod(value, NULL);
+        } else if (strcmp(argv[i], "--filter") == 0 && value) {
+            options->filter = value;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--samples N] [--warmup N] [--scale X] [--filter NAME]\n",
+                    argv[0]);
+            return -1;
+        }
+        i++;
+    }
+
+    if (options->samples == 0 || !(options->scale > 0.0)) {
+        fprintf(stderr, "%s: samples and scale must be positive\n", argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+bool bench_run(const bench_options_t *options, const char *name, size_t ops_per_sample,
+               bench_fn_t fn, void *arg, bench_result_t *result) {
+    if (options->filter && !strstr(name, options->filter)) {
+        return false;
+    }
+
+    size_t ops = (size_t)((double)ops_per_sample * options->scale + 0.5);
+    if (ops == 0) {
+        ops = 1;
+    }
+
+    double *sample_ns = malloc(options->samples * sizeof(double));
+    if (!sample_ns) {
+        return false;
+    }
+
+    for (size_t i = 0; i < options->warmup; i++) {
+        fn(arg, ops);
+    }
+
+    uint64_t allocations = bench_allocations();
+    uint64_t total_ns = 0;
+    for (size_t i = 0; i < options->samples; i++) {
+        uint64_t start = bench_now_ns();
+        fn(arg, ops);
+        uint64_t elapsed = bench_now_ns() - start;
+        total_ns += elapsed;
+        sample_ns[i] = (double)elapsed / (double)ops;
+    }
+    uint64_t allocations_end = bench_allocations();
+
+    qsort(sample_ns, options->samples, sizeof(double), compare_doubles);
+
+    double total_ops = (double)ops * (double)options->samples;
+    bench_result_t r = {
+        .name = name,
+        .samples = options->samples,
+        .ops_per_sample = ops,
+        .ns_per_op = (double)total_ns / total_ops,
+        .ops_per_sec = total_ns ? total_ops * 1e9 / (double)total_ns : 0.0,
+        /* The harness's own malloc above happened before the first reading */
+        .allocs_per_op = allocations == UINT64_MAX
+                             ? -1.0
+                             : (double)(allocations_end - allocations) / total_ops,
+        .p50_ns = percentile(sample_ns, options->samples, 50.0),
+        .p90_ns = percentile(sample_ns, options->samples, 90.0),
+        .p99_ns = percentile(sample_ns, options->samples, 99.0),
+        .max_ns = sample_ns[options->samples - 1],
+    };
+    free(sample_ns);
+
+    char allocs[32];
+    if (r.allocs_per_op < 0.0) {
+        snprintf(allocs, sizeof(allocs), "null");
+    } else {
+        snprintf(allocs, sizeof(allocs), "%.4g", r.allocs_per_op);
+    }
+
+    char threshold[32] = "";
+    if (options->threshold > 0.0) {
+        snprintf(threshold, sizeof(threshold), ",\"threshold\":%.4g", options->threshold);
+    }
+
+    printf("{\"suite\":\"%s\",\"name\":\"%s\",\"samples\":%zu,\"ops_per_sample\":%zu,"
+           "\"ns_per_op\":%.4g,\"ops_per_sec\":%.6g,\"allocs_per_op\":%s,"
+           "\"p50_ns\":%.4g,\"p90_ns\":%.4g,\"p99_ns\":%.4g,\"max_ns\":%.4g%s}\n",
+           options->suite, name, r.samples, r.ops_per_sample, r.ns_per_op, r.ops_per_sec,
+           allocs, r.p50_ns, r.p90_ns, r.p99_ns, r.max_ns, threshold);
+    fflush(stdout);
+
+    if (result) {
+        *result = r;
+    }
+    return true;
+}
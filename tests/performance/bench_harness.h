@@ -0,0 +1,141 @@
+/**
+ * @file bench_harness.h
+ * @brief Timing, allocation counting and JSON output for microbenchmarks
+ * @details A benchmark is a function that performs a given number of
+ *          operations. The harness calls it for a fixed number of samples
+ *          of a fixed batch size, so two runs of the same build do the same
+ *          work, and prints one JSON object per benchmark on stdout:
+ *
+ *          {"suite":"common","name":"queue_enqueue_dequeue","samples":200,
+ *           "ops_per_sample":4096,"ns_per_op":21.4,"ops_per_sec":4.67e+07,
+ *           "allocs_per_op":0,"p50_ns":21.1,"p90_ns":22.0,"p99_ns":25.3,
+ *           "max_ns":31.2}
+ *
+ *          A benchmark known to be noisy adds "threshold", the regression
+ *          margin (a fraction) bench_compare should allow it.
+ *
+ *          Percentiles are over the per-sample mean latency of an operation;
+ *          timing single operations of a few nanoseconds would mostly
+ *          measure the clock. Allocations count malloc, calloc and realloc
+ *          calls (glibc only, otherwise "allocs_per_op" is null).
+ *
+ *          The harness only uses the C library, so it links with both the
+ *          common/ utilities and the include/ PAL tree.
+ */
+
+#ifndef PAUMIOT_BENCH_HARNESS_H
+#define PAUMIOT_BENCH_HARNESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Defaults, overridable on the command line */
+#define BENCH_DEFAULT_SAMPLES 200
+#define BENCH_DEFAULT_WARMUP 20
+
+/**
+ * Run options shared by every benchmark of a program
+ */
+typedef struct {
+    const char *suite;          /* Reported as "suite" */
+    size_t samples;             /* Measured samples per benchmark */
+    size_t warmup;              /* Samples run and discarded first */
+    double scale;               /* Multiplies every batch size */
+    const char *filter;         /* Run only names containing this (NULL = all) */
+    double threshold;           /* Reported regression margin (0 = not reported) */
+} bench_options_t;
+
+/**
+ * Results of one benchmark (also printed as JSON)
+ */
+typedef struct {
+    const char *name;
+    size_t samples;
+    size_t ops_per_sample;
+    double ns_per_op;           /* Total time / total operations */
+    double ops_per_sec;
+    double allocs_per_op;       /* Negative if allocations are not counted */
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+    double max_ns;
+} bench_result_t;
+
+/* Latency histogram: 16 linear sub-buckets per power of two of nanoseconds */
+#define BENCH_HIST_SUB_BITS 4
+#define BENCH_HIST_BUCKETS (64 << BENCH_HIST_SUB_BITS)
+
+/**
+ * Histogram for benchmarks that time individual operations across threads
+ * (one per thread, merged at the end); relative error is below 1/16
+ */
+typedef struct {
+    uint64_t counts[BENCH_HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} bench_hist_t;
+
+/**
+ * Benchmark body: perform ops operations
+ */
+typedef void (*bench_fn_t)(void *arg, size_t ops);
+
+/**
+ * Parse "--samples N --warmup N --scale X --filter S" into options
+ *
+ * @param argc Argument count
+ * @param argv Arguments
+ * @param suite Suite name
+ * @param options Receives the options
+ * @return 0 on success, -1 after printing usage
+ */
+int bench_parse_args(int argc, char **argv, const char *suite, bench_options_t *options);
+
+/**
+ * Run a benchmark and print its JSON line
+ *
+ * @param options Run options
+ * @param name Benchmark name
+ * @param ops_per_sample Operations per sample before scaling
+ * @param fn Benchmark body
+ * @param arg Passed to fn
+ * @param result Receives the results (can be NULL)
+ * @return false if the filter skipped the benchmark or memory ran out
+ */
+bool bench_run(const bench_options_t *options, const char *name, size_t ops_per_sample,
+               bench_fn_t fn, void *arg, bench_result_t *result);
+
+/**
+ * Allocations made by the process so far
+ *
+ * @return Allocation count, or UINT64_MAX if allocations are not counted
+ */
+uint64_t bench_allocations(void);
+
+/**
+ * Monotonic clock in nanoseconds
+ */
+uint64_t bench_now_ns(void);
+
+/**
+ * Record a latency
+ */
+void bench_hist_record(bench_hist_t *hist, uint64_t ns);
+
+/**
+ * Add src into dst
+ */
+void bench_hist_merge(bench_hist_t *dst, const bench_hist_t *src);
+
+/**
+ * Upper bound of the bucket holding percentile p (0-100), capped at the maximum
+ */
+uint64_t bench_hist_percentile(const bench_hist_t *hist, double p);
+
+/**
+ * Keep a value observable so the compiler cannot drop the work behind it
+ */
+void bench_consume(uintptr_t value);
+
+#endif /* PAUMIOT_BENCH_HARNESS_H */
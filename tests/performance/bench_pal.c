@@ -0,0 +1,182 @@
+/**
+ * @file bench_pal.c
+ * @brief Microbenchmarks of the Protocol Adaptation Layer hot paths
+ * @details Usage: bench_pal [--samples N] [--warmup N] [--scale X] [--filter NAME]
+ *          Prints one JSON object per benchmark (see bench_harness.h).
+ *
+ *          message_*     one operation = create (or copy) and free a message
+ *          *_decode_mix  one operation = pal_decode_packet + message_free
+ *          *_encode_mix  one operation = pal_encode_message
+ *
+ *          The packet mix repeats a fixed schedule of 20 messages: 14 small
+ *          telemetry readings (32 byte payload, QoS 0), 5 medium batches
+ *          (256 bytes, QoS 1) and 1 large blob (1024 bytes, QoS 0), spread
+ *          over 16 topics. Packets are produced by the adapters' own
+ *          encoders so they are always valid.
+ */
+
+#include "bench_harness.h"
+#include "pal/pal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIX_LEN 20
+#define NUM_TOPICS 16
+#define PACKET_BUFFER 2048
+
+typedef struct {
+    pal_context_t *pal;
+    message_t *messages[MIX_LEN];
+    uint8_t packets[MIX_LEN][PACKET_BUFFER];
+    size_t packet_lens[MIX_LEN];
+} mix_t;
+
+/* ============================================================================
+ * WORKLOAD
+ * ========================================================================= */
+
+static message_t *make_message(protocol_type_t protocol, unsigned index) {
+    size_t payload_len;
+    qos_level_t qos;
+    if (index % MIX_LEN == 7) {
+        payload_len = 1024;
+        qos = QOS_LEVEL_0;
+    } else if (index % 4 == 1) {
+        payload_len = 256;
+        qos = QOS_LEVEL_1;
+    } else {
+        payload_len = 32;
+        qos = QOS_LEVEL_0;
+    }
+
+    message_t *msg = message_create();
+    if (!msg) {
+        return NULL;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%ssensors/building1/floor%u/temperature",
+             protocol == PROTOCOL_TYPE_COAP ? "/" : "", index % NUM_TOPICS);
+    msg->destination = strdup(topic);
+    if (!msg->destination) {
+        message_free(msg);
+        return NULL;
+    }
+
+    uint8_t payload[1024];
+    for (size_t i = 0; i < payload_len; i++) {
+        payload[i] = (uint8_t)('a' + (i + index) % 26);
+    }
+    message_set_payload(msg, payload, payload_len);
+
+    msg->metadata.protocol = protocol;
+    msg->metadata.qos = qos;
+    return msg;
+}
+
+static bool mix_init(mix_t *mix, pal_context_t *pal, protocol_type_t protocol) {
+    memset(mix, 0, sizeof(*mix));
+    mix->pal = pal;
+
+    for (unsigned i = 0; i < MIX_LEN; i++) {
+        mix->messages[i] = make_message(protocol, i);
+        if (!mix->messages[i] ||
+            pal_encode_message(pal, mix->messages[i], mix->packets[i], PACKET_BUFFER,
+                               &mix->packet_lens[i]) != PAUMIOT_SUCCESS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void mix_free(mix_t *mix) {
+    for (unsigned i = 0; i < MIX_LEN; i++) {
+        message_free(mix->messages[i]);
+    }
+}
+
+/* ============================================================================
+ * BENCHMARK BODIES
+ * ========================================================================= */
+
+static void message_create_free(void *arg, size_t ops) {
+    (void)arg;
+    for (size_t i = 0; i < ops; i++) {
+        message_t *msg = message_create();
+        bench_consume((uintptr_t)msg);
+        message_free(msg);
+    }
+}
+
+static void message_copy_free(void *arg, size_t ops) {
+    const mix_t *mix = arg;
+    for (size_t i = 0; i < ops; i++) {
+        message_t *copy = message_copy(mix->messages[i % MIX_LEN]);
+        bench_consume((uintptr_t)copy);
+        message_free(copy);
+    }
+}
+
+static void decode_mix(void *arg, size_t ops, protocol_type_t protocol) {
+    const mix_t *mix = arg;
+    for (size_t i = 0; i < ops; i++) {
+        size_t k = i % MIX_LEN;
+        message_t *msg = NULL;
+        pal_decode_packet(mix->pal, protocol, mix->packets[k], mix->packet_lens[k], &msg);
+        bench_consume((uintptr_t)msg);
+        message_free(msg);
+    }
+}
+
+static void mqtt_decode_mix(void *arg, size_t ops) {
+    decode_mix(arg, ops, PROTOCOL_TYPE_MQTT);
+}
+
+static void coap_decode_mix(void *arg, size_t ops) {
+    decode_mix(arg, ops, PROTOCOL_TYPE_COAP);
+}
+
+static void encode_mix(void *arg, size_t ops) {
+    const mix_t *mix = arg;
+    uint8_t packet[PACKET_BUFFER];
+    size_t written = 0;
+    for (size_t i = 0; i < ops; i++) {
+        pal_encode_message(mix->pal, mix->messages[i % MIX_LEN], packet, sizeof(packet),
+                           &written);
+    }
+    bench_consume(written + packet[0]);
+}
+
+int main(int argc, char **argv) {
+    bench_options_t options;
+    if (bench_parse_args(argc, argv, "pal", &options) != 0) {
+        return 1;
+    }
+
+    pal_context_t *pal = pal_init(NULL);
+    if (!pal || pal_register_adapter(pal, &mqtt_adapter) != PAUMIOT_SUCCESS ||
+        pal_register_adapter(pal, &coap_adapter) != PAUMIOT_SUCCESS) {
+        fprintf(stderr, "cannot set up the PAL\n");
+        return 1;
+    }
+
+    static mix_t mqtt;
+    static mix_t coap;
+    if (!mix_init(&mqtt, pal, PROTOCOL_TYPE_MQTT) || !mix_init(&coap, pal, PROTOCOL_TYPE_COAP)) {
+        fprintf(stderr, "cannot build the packet mix\n");
+        return 1;
+    }
+
+    bench_run(&options, "message_create_free", 1000, message_create_free, NULL, NULL);
+    bench_run(&options, "message_copy_free", 1000, message_copy_free, &mqtt, NULL);
+    bench_run(&options, "mqtt_decode_mix", 1000, mqtt_decode_mix, &mqtt, NULL);
+    bench_run(&options, "mqtt_encode_mix", 1000, encode_mix, &mqtt, NULL);
+    bench_run(&options, "coap_decode_mix", 1000, coap_decode_mix, &coap, NULL);
+    bench_run(&options, "coap_encode_mix", 1000, encode_mix, &coap, NULL);
+
+    mix_free(&mqtt);
+    mix_free(&coap);
+    pal_cleanup(pal);
+    return 0;
+}
@@ -0,0 +1,540 @@
+/**
+ * @file bench_pipeline.c
+ * @brief Multi-threaded pipeline throughput: pool -> queue -> decode/route/encode
+ * @details The benchmark form of test_multithreaded_pipeline
+ *          (tests/integration/test_integration.c). Producers take a block
+ *          from a shared memory_pool_t, write a raw MQTT PUBLISH frame into
+ *          it and queue the pointer on a shared queue_t. Consumers dequeue
+ *          it, then decode the frame, route it by topic and re-encode it as
+ *          a CoAP POST --work times, and free the block.
+ *
+ *          Usage: bench_pipeline [--producers N] [--consumers N] [--capacity N]
+ *                                [--size BYTES] [--work N] [--messages N]
+ *                                [--samples N] [--warmup N] [--scale X]
+ *                                [--filter NAME]
+ *
+ *          Without any of the first five options a fixed sweep runs (thread
+ *          counts, queue capacity, message size and work), one JSON line per
+ *          configuration:
+ *
+ *          {"suite":"pipeline","name":"p2c2_q1024_s64_w1","producers":2,...,
+ *           "ns_per_op":310,"msgs_per_sec":3.2e+06,"msgs_per_core_sec":1.6e+06,
+ *           "cores_busy":2.0,"p50_us":..,"p99_us":..,"errors":0}
+ *
+ *          One operation is one message end to end; ns_per_op is wall time
+ *          per message, so bench_compare can check it. Latency runs from just
+ *          before the enqueue to the end of processing. msgs_per_core_sec
+ *          divides by the process CPU time (user + system), so spinning or
+ *          lock contention shows up as lower efficiency even when throughput
+ *          holds. The pool is not thread-safe and is used under a mutex, as
+ *          any multi-threaded user of memory_pool_t must.
+ */
+
+#include "bench_harness.h"
+#include "queue.h"
+#include "memory_pool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#define MAX_THREADS 64
+#define NUM_TOPICS 64
+#define NUM_ROUTES 256
+#define MIN_SIZE 64
+#define MAX_SIZE 65536
+#define DEFAULT_MESSAGES 100000
+#define DEFAULT_SAMPLES 5
+#define DEFAULT_WARMUP 1
+
+/* Regression margin reported to bench_compare: scheduling makes runs noisy */
+#define PIPELINE_THRESHOLD 0.25
+
+typedef struct {
+    unsigned producers;
+    unsigned consumers;
+    size_t capacity;                    /* Queue slots (power of two) */
+    size_t size;                        /* Frame bytes per message */
+    unsigned work;                      /* decode->route->encode passes */
+} config_t;
+
+/* Pooled message */
+typedef struct {
+    uint64_t enqueued_ns;
+    uint32_t seq;
+    uint32_t len;
+    uint8_t frame[];
+} pipeline_msg_t;
+
+typedef struct {
+    memory_pool_t *pool;
+    pthread_mutex_t pool_lock;
+    queue_t *queue;                     /* Of pipeline_msg_t pointers */
+    atomic_bool producers_done;
+    pthread_barrier_t start;
+} pipeline_t;
+
+typedef struct {
+    const config_t *cfg;
+    pipeline_t *pipeline;
+    pthread_t thread;
+
+    /* Producer */
+    uint32_t first_seq;
+    size_t count;
+
+    /* Both: sum of sequence numbers, to prove nothing was lost or duplicated */
+    uint64_t seq_sum;
+
+    /* Consumer */
+    uint64_t processed;
+    uint64_t errors;
+    uint32_t routes[NUM_ROUTES];
+    bench_hist_t latency;
+    uint8_t *out;                       /* Re-encoding buffer */
+} worker_t;
+
+/* ============================================================================
+ * FRAMES
+ * ========================================================================= */
+
+/* MQTT PUBLISH, QoS 0, filling exactly size bytes */
+static size_t encode_publish(uint8_t *buf, size_t size, uint32_t seq) {
+    char topic[48];
+    int topic_len = snprintf(topic, sizeof(topic), "sensors/building1/floor%u/temperature",
+                             (unsigned)(seq % NUM_TOPICS));
+
+    /* Fixed header: type byte and as many length bytes as the rest needs */
+    size_t header = 2;
+    while (size - header >= (size_t)1 << (7 * (header - 1))) {
+        header++;
+    }
+
+    size_t pos = 0;
+    buf[pos++] = 0x30;
+    for (size_t value = size - header; pos < header; value >>= 7) {
+        uint8_t byte = (uint8_t)(value & 0x7F);
+        buf[pos] = pos + 1 < header ? byte | 0x80 : byte;
+        pos++;
+    }
+    buf[pos++] = (uint8_t)(topic_len >> 8);
+    buf[pos++] = (uint8_t)topic_len;
+    memcpy(buf + pos, topic, (size_t)topic_len);
+    pos += (size_t)topic_len;
+
+    /* Payload: sequence number, then filler */
+    memcpy(buf + pos, &seq, sizeof(seq));
+    for (size_t i = pos + sizeof(seq); i < size; i++) {
+        buf[i] = (uint8_t)('a' + i % 26);
+    }
+    return size;
+}
+
+/**
+ * Decode the PUBLISH, pick a route from the topic and encode a CoAP POST
+ * @return Encoded length, 0 if the frame is malformed
+ */
+static size_t transcode(worker_t *w, const pipeline_msg_t *msg) {
+    const uint8_t *buf = msg->frame;
+    size_t len = msg->len;
+
+    /* Decode */
+    if (len < 2 || buf[0] >> 4 != 3) {
+        return 0;
+    }
+    size_t remaining = 0;
+    size_t pos = 1;
+    for (unsigned shift = 0; pos < len && shift <= 21; shift += 7) {
+        uint8_t byte = buf[pos++];
+        remaining |= (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    if (remaining != len - pos || remaining < 2) {
+        return 0;
+    }
+    size_t topic_len = (size_t)buf[pos] << 8 | buf[pos + 1];
+    const uint8_t *topic = buf + pos + 2;
+    if (topic_len > remaining - 2) {
+        return 0;
+    }
+    const uint8_t *payload = topic + topic_len;
+    size_t payload_len = remaining - 2 - topic_len;
+
+    /* Route: FNV-1a of the topic */
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < topic_len; i++) {
+        hash = (hash ^ topic[i]) * 16777619u;
+    }
+    w->routes[hash % NUM_ROUTES]++;
+
+    /* Encode: CoAP NON POST with one Uri-Path option per topic level */
+    uint8_t *out = w->out;
+    size_t o = 0;
+    out[o++] = 0x50;
+    out[o++] = 0x02;
+    out[o++] = (uint8_t)(msg->seq >> 8);
+    out[o++] = (uint8_t)msg->seq;
+    unsigned delta = 11;                /* Uri-Path */
+    for (size_t start = 0, i = 0; i <= topic_len; i++) {
+        if (i < topic_len && topic[i] != '/') {
+            continue;
+        }
+        size_t seg = i - start;
+        if (seg < 13) {
+            out[o++] = (uint8_t)(delta << 4 | seg);
+        } else {
+            out[o++] = (uint8_t)(delta << 4 | 13);
+            out[o++] = (uint8_t)(seg - 13);
+        }
+        memcpy(out + o, topic + start, seg);
+        o += seg;
+        delta = 0;
+        start = i + 1;
+    }
+    out[o++] = 0xFF;
+    memcpy(out + o, payload, payload_len);
+    return o + payload_len;
+}
+
+/* ============================================================================
+ * THREADS
+ * ========================================================================= */
+
+static void *producer(void *arg) {
+    worker_t *w = arg;
+    pipeline_t *p = w->pipeline;
+
+    pthread_barrier_wait(&p->start);
+    for (size_t i = 0; i < w->count;) {
+        pthread_mutex_lock(&p->pool_lock);
+        pipeline_msg_t *msg = pool_alloc(p->pool);
+        pthread_mutex_unlock(&p->pool_lock);
+        if (!msg) {
+            sched_yield();              /* Every block is in flight */
+            continue;
+        }
+
+        msg->seq = w->first_seq + (uint32_t)i;
+        msg->len = (uint32_t)encode_publish(msg->frame, w->cfg->size, msg->seq);
+        w->seq_sum += msg->seq;
+
+        msg->enqueued_ns = bench_now_ns();
+        while (queue_enqueue(p->queue, &msg) != PAUMIOT_SUCCESS) {
+            sched_yield();
+        }
+        i++;
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    worker_t *w = arg;
+    pipeline_t *p = w->pipeline;
+    uint64_t sink = 0;
+
+    pthread_barrier_wait(&p->start);
+    for (;;) {
+        pipeline_msg_t *msg;
+        if (queue_dequeue(p->queue, &msg) != PAUMIOT_SUCCESS) {
+            if (atomic_load(&p->producers_done) && queue_is_empty(p->queue)) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+
+        if (!msg) {
+            w->errors++;
+            continue;
+        }
+        for (unsigned k = 0; k < w->cfg->work; k++) {
+            size_t n = transcode(w, msg);
+            if (n == 0) {
+                w->errors++;
+                break;
+            }
+            sink += w->out[n - 1];
+        }
+        w->seq_sum += msg->seq;
+        w->processed++;
+        bench_hist_record(&w->latency, bench_now_ns() - msg->enqueued_ns);
+
+        pthread_mutex_lock(&p->pool_lock);
+        pool_free(p->pool, msg);
+        pthread_mutex_unlock(&p->pool_lock);
+    }
+    bench_consume(sink);
+    return NULL;
+}
+
+static double cpu_seconds(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1e6 +
+           (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1e6;
+}
+
+/* ============================================================================
+ * RUNS
+ * ========================================================================= */
+
+typedef struct {
+    uint64_t messages;
+    uint64_t wall_ns;
+    double cpu_s;
+    uint64_t errors;
+    bench_hist_t latency;
+} totals_t;
+
+/**
+ * Push messages through the pipeline once
+ * @return false on setup failure or if messages were lost or duplicated
+ */
+static bool run_once(const config_t *cfg, size_t messages, totals_t *totals, bool record) {
+    pipeline_t p;
+    unsigned threads = cfg->producers + cfg->consumers;
+    worker_t *workers = calloc(threads, sizeof(worker_t));
+
+    /* Blocks rounded up so every header stays 8-byte aligned */
+    size_t block = (sizeof(pipeline_msg_t) + cfg->size + 7) & ~(size_t)7;
+    memset(&p, 0, sizeof(p));
+    p.pool = pool_create(cfg->capacity + threads, block);
+    p.queue = queue_create(cfg->capacity, sizeof(pipeline_msg_t *));
+    if (!workers || !p.pool || !p.queue) {
+        free(workers);
+        pool_destroy(p.pool);
+        queue_destroy(p.queue);
+        return false;
+    }
+    pthread_mutex_init(&p.pool_lock, NULL);
+    atomic_init(&p.producers_done, false);
+    pthread_barrier_init(&p.start, NULL, threads + 1);
+
+    bool ok = true;
+    for (unsigned i = 0; i < threads; i++) {
+        worker_t *w = &workers[i];
+        w->cfg = cfg;
+        w->pipeline = &p;
+        if (i < cfg->producers) {
+            size_t share = messages / cfg->producers;
+            w->count = share + (i < messages % cfg->producers ? 1 : 0);
+            w->first_seq = (uint32_t)(i * (share + 1));
+        } else {
+            w->out = malloc(cfg->size + 64);
+            ok = ok && w->out;
+        }
+    }
+
+    unsigned started = 0;
+    for (; ok && started < threads; started++) {
+        ok = pthread_create(&workers[started].thread, NULL,
+                            started < cfg->producers ? producer : consumer,
+                            &workers[started]) == 0;
+    }
+    if (!ok) {
+        /* Cannot release the barrier short of its count: give up on the process */
+        fprintf(stderr, "cannot start %u threads\n", threads);
+        exit(1);
+    }
+
+    double cpu_start = cpu_seconds();
+    pthread_barrier_wait(&p.start);
+    uint64_t start = bench_now_ns();
+
+    for (unsigned i = 0; i < cfg->producers; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    atomic_store(&p.producers_done, true);
+    for (unsigned i = cfg->producers; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    uint64_t wall = bench_now_ns() - start;
+    double cpu = cpu_seconds() - cpu_start;
+
+    uint64_t produced_sum = 0;
+    uint64_t consumed_sum = 0;
+    uint64_t processed = 0;
+    uint64_t errors = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        worker_t *w = &workers[i];
+        if (i < cfg->producers) {
+            produced_sum += w->seq_sum;
+        } else {
+            consumed_sum += w->seq_sum;
+            processed += w->processed;
+            errors += w->errors;
+            if (record) {
+                bench_hist_merge(&totals->latency, &w->latency);
+            }
+        }
+        free(w->out);
+    }
+    if (processed != messages || produced_sum != consumed_sum) {
+        errors++;
+    }
+
+    if (record) {
+        totals->messages += messages;
+        totals->wall_ns += wall;
+        totals->cpu_s += cpu;
+        totals->errors += errors;
+    }
+
+    pthread_barrier_destroy(&p.start);
+    pthread_mutex_destroy(&p.pool_lock);
+    queue_destroy(p.queue);
+    pool_destroy(p.pool);
+    free(workers);
+    return errors == 0;
+}
+
+static bool run_config(const config_t *cfg, const bench_options_t *options, size_t messages) {
+    char name[64];
+    snprintf(name, sizeof(name), "p%uc%u_q%zu_s%zu_w%u", cfg->producers, cfg->consumers,
+             cfg->capacity, cfg->size, cfg->work);
+    if (options->filter && !strstr(name, options->filter)) {
+        return true;
+    }
+
+    size_t n = (size_t)((double)messages * options->scale + 0.5);
+    n = n ? n : 1;
+
+    static totals_t totals;
+    memset(&totals, 0, sizeof(totals));
+    for (size_t i = 0; i < options->warmup; i++) {
+        run_once(cfg, n, &totals, false);
+    }
+    for (size_t i = 0; i < options->samples; i++) {
+        if (!run_once(cfg, n, &totals, true)) {
+            break;
+        }
+    }
+
+    double seconds = (double)totals.wall_ns / 1e9;
+    printf("{\"suite\":\"%s\",\"name\":\"%s\",\"producers\":%u,\"consumers\":%u,"
+           "\"capacity\":%zu,\"message_size\":%zu,\"work\":%u,\"samples\":%zu,"
+           "\"messages\":%zu,\"ns_per_op\":%.4g,\"msgs_per_sec\":%.6g,"
+           "\"msgs_per_core_sec\":%.6g,\"cores_busy\":%.3g,\"p50_us\":%.4g,"
+           "\"p90_us\":%.4g,\"p99_us\":%.4g,\"p999_us\":%.4g,\"max_us\":%.4g,\"errors\":%llu,"
+           "\"threshold\":%.4g}\n",
+           options->suite, name, cfg->producers, cfg->consumers, cfg->capacity, cfg->size,
+           cfg->work, options->samples, n,
+           totals.messages ? (double)totals.wall_ns / (double)totals.messages : 0.0,
+           seconds > 0 ? (double)totals.messages / seconds : 0.0,
+           totals.cpu_s > 0 ? (double)totals.messages / totals.cpu_s : 0.0,
+           seconds > 0 ? totals.cpu_s / seconds : 0.0,
+           bench_hist_percentile(&totals.latency, 50) / 1e3,
+           bench_hist_percentile(&totals.latency, 90) / 1e3,
+           bench_hist_percentile(&totals.latency, 99) / 1e3,
+           bench_hist_percentile(&totals.latency, 99.9) / 1e3, totals.latency.max / 1e3,
+           (unsigned long long)totals.errors, options->threshold);
+    fflush(stdout);
+
+    if (totals.errors) {
+        fprintf(stderr, "%s: messages lost, duplicated or corrupted\n", name);
+        return false;
+    }
+    return true;
+}
+
+/* ============================================================================
+ * MAIN
+ * ========================================================================= */
+
+/* Scaling curve, then one knob at a time around p2c2_q1024_s64_w1 */
+static const config_t sweep[] = {
+    { 1, 1, 1024, 64, 1 },
+    { 2, 2, 1024, 64, 1 },
+    { 4, 4, 1024, 64, 1 },
+    { 2, 2, 16, 64, 1 },
+    { 2, 2, 1024, 512, 1 },
+    { 2, 2, 1024, 64, 0 },
+    { 2, 2, 1024, 64, 4 },
+};
+
+static int usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [--producers N] [--consumers N] [--capacity N] [--size BYTES]\n"
+            "       [--work N] [--messages N] [--samples N] [--warmup N] [--scale X]\n"
+            "       [--filter NAME]\n",
+            prog);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    config_t single = { 2, 2, 1024, 64, 1 };
+    bool custom = false;
+    size_t messages = DEFAULT_MESSAGES;
+    bench_options_t options = {
+        .suite = "pipeline",
+        .samples = DEFAULT_SAMPLES,
+        .warmup = DEFAULT_WARMUP,
+        .scale = 1.0,
+        .filter = NULL,
+        .threshold = PIPELINE_THRESHOLD,
+    };
+
+    for (int i = 1; i < argc; i += 2) {
+        const char *flag = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            return usage(argv[0]);
+        }
+        unsigned long n = strtoul(value, NULL, 10);
+        if (strcmp(flag, "--producers") == 0) {
+            single.producers = (unsigned)n;
+            custom = true;
+        } else if (strcmp(flag, "--consumers") == 0) {
+            single.consumers = (unsigned)n;
+            custom = true;
+        } else if (strcmp(flag, "--capacity") == 0) {
+            single.capacity = n;
+            custom = true;
+        } else if (strcmp(flag, "--size") == 0) {
+            single.size = n;
+            custom = true;
+        } else if (strcmp(flag, "--work") == 0) {
+            single.work = (unsigned)n;
+            custom = true;
+        } else if (strcmp(flag, "--messages") == 0) {
+            messages = n;
+        } else if (strcmp(flag, "--samples") == 0) {
+            options.samples = n;
+        } else if (strcmp(flag, "--warmup") == 0) {
+            options.warmup = n;
+        } else if (strcmp(flag, "--scale") == 0) {
+            options.scale = strtod(value, NULL);
+        } else if (strcmp(flag, "--filter") == 0) {
+            options.filter = value;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    if (single.producers == 0 || single.consumers == 0 ||
+        single.producers + single.consumers > MAX_THREADS || single.capacity == 0 ||
+        (single.capacity & (single.capacity - 1)) != 0 || single.size < MIN_SIZE ||
+        single.size > MAX_SIZE || messages == 0 || options.samples == 0 ||
+        !(options.scale > 0.0)) {
+        fprintf(stderr, "%s: thread counts 1..%d in total, capacity a power of two, "
+                        "size %d..%d bytes\n",
+                argv[0], MAX_THREADS, MIN_SIZE, MAX_SIZE);
+        return 1;
+    }
+
+    if (custom) {
+        return run_config(&single, &options, messages) ? 0 : 1;
+    }
+    for (size_t i = 0; i < sizeof(sweep) / sizeof(sweep[0]); i++) {
+        if (!run_config(&sweep[i], &options, messages)) {
+            return 1;
+        }
+    }
+    return 0;
+}
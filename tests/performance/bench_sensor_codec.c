@@ -0,0 +1,87 @@
+/**
+ * @file bench_sensor_codec.c
+ * @brief JSON/CBOR transcoding cost and payload size on sensor documents
+ * @details Usage: bench_sensor_codec [iterations]
+ *          Reports ns/document and MB/s (of the input) in each direction,
+ *          and the size of each document in both encodings.
+ */
+
+#include "sensor_manager/sensor_codec.h"
+#include "time_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    const char *json;
+} document_t;
+
+static const document_t documents[] = {
+    { "reading",
+      "{\"sensor\":\"temp-01\",\"ts\":1700000000123,\"value\":23.45,\"unit\":\"C\"}" },
+    { "telemetry",
+      "{\"sensor\":\"greenhouse/temp-01\",\"ts\":1700000000123,\"value\":23.45,"
+      "\"unit\":\"C\",\"battery\":0.5,\"ok\":true,\"samples\":[23.5,23.25,23.0,22.75],"
+      "\"meta\":{\"fw\":\"1.2.3\",\"rssi\":-71}}" },
+    { "batch",
+      "{\"device\":\"gw-7\",\"readings\":["
+      "{\"id\":1,\"ts\":1700000000000,\"v\":21.5},{\"id\":2,\"ts\":1700000000100,\"v\":21.75},"
+      "{\"id\":3,\"ts\":1700000000200,\"v\":22},{\"id\":4,\"ts\":1700000000300,\"v\":-3.5},"
+      "{\"id\":5,\"ts\":1700000000400,\"v\":1013.25},{\"id\":6,\"ts\":1700000000500,\"v\":0.125},"
+      "{\"id\":7,\"ts\":1700000000600,\"v\":65.5},{\"id\":8,\"ts\":1700000000700,\"v\":12}]}" },
+    { "pretty",
+      "{\n  \"sensor\": \"humidity-03\",\n  \"ts\": 1700000000123,\n"
+      "  \"value\": 61.2,\n  \"unit\": \"%RH\",\n  \"note\": \"door \\\"B\\\" open\"\n}\n" },
+};
+
+/* Keeps the results observable so the loops are not elided */
+static volatile size_t sink;
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    printf("JSON/CBOR transcoding: %d iterations per document\n\n", iterations);
+    printf("%-10s %6s %6s %7s %12s %10s %12s %10s\n", "document", "json", "cbor", "saved",
+           "json>cbor ns", "MB/s", "cbor>json ns", "MB/s");
+
+    for (size_t d = 0; d < sizeof(documents) / sizeof(documents[0]); d++) {
+        const char *json = documents[d].json;
+        size_t json_len = strlen(json);
+        uint8_t cbor[1024];
+        char text[1024];
+        size_t cbor_len;
+        size_t text_len;
+
+        if (sensor_codec_json_to_cbor(json, json_len, cbor, sizeof(cbor), &cbor_len) !=
+            PAUMIOT_SUCCESS) {
+            fprintf(stderr, "%s: conversion failed\n", documents[d].name);
+            return 1;
+        }
+
+        uint64_t start = time_monotonic_ns();
+        for (int it = 0; it < iterations; it++) {
+            sensor_codec_json_to_cbor(json, json_len, cbor, sizeof(cbor), &cbor_len);
+            sink = cbor_len;
+        }
+        double encode_ns = (double)(time_monotonic_ns() - start) / iterations;
+
+        start = time_monotonic_ns();
+        for (int it = 0; it < iterations; it++) {
+            sensor_codec_cbor_to_json(cbor, cbor_len, text, sizeof(text), &text_len);
+            sink = text_len;
+        }
+        double decode_ns = (double)(time_monotonic_ns() - start) / iterations;
+
+        printf("%-10s %6zu %6zu %6.1f%% %12.1f %10.1f %12.1f %10.1f\n", documents[d].name,
+               json_len, cbor_len, 100.0 * (1.0 - (double)cbor_len / (double)json_len),
+               encode_ns, (double)json_len / encode_ns * 1e3,
+               decode_ns, (double)cbor_len / decode_ns * 1e3);
+    }
+
+    return 0;
+}
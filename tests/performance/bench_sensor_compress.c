@@ -0,0 +1,115 @@
+/**
+ * @file bench_sensor_compress.c
+ * @brief Compression ratio and speed on small sensor payloads
+ * @details Usage: bench_sensor_compress [iterations] [dict_size]
+ *          Trains a dictionary on one set of telemetry payloads and
+ *          compresses a disjoint set, reporting total frame size and
+ *          ns/payload per codec, with and without the dictionary.
+ */
+
+#include "sensor_manager/sensor_compress.h"
+#include "time_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_TRAINING 500
+#define NUM_PAYLOADS 500
+
+static size_t make_payload(char *buf, size_t size, int i) {
+    static const char *units[] = { "C", "%RH", "hPa", "lx" };
+    return (size_t)snprintf(buf, size,
+                            "{\"sensor\":\"greenhouse-%d/probe-%02d\",\"ts\":%llu,"
+                            "\"value\":%d.%02d,\"unit\":\"%s\",\"battery\":%d,\"status\":\"ok\"}",
+                            i % 7, i % 13, 1700000000000ull + (unsigned long long)i * 997,
+                            (i * 37) % 100, (i * 11) % 100, units[i % 4], 100 - i % 50);
+}
+
+static char payloads[NUM_TRAINING + NUM_PAYLOADS][192];
+static size_t sizes[NUM_TRAINING + NUM_PAYLOADS];
+
+static void run(sensor_compressor_t *compressor, sensor_compression_t codec,
+                const sensor_compress_dict_t *dict, int iterations, size_t raw_total) {
+    size_t frame_total = 0;
+    uint64_t compress_ns = 0;
+    uint64_t decompress_ns = 0;
+
+    for (int it = 0; it < iterations; it++) {
+        for (int i = NUM_TRAINING; i < NUM_TRAINING + NUM_PAYLOADS; i++) {
+            uint8_t *frame, *out;
+            size_t frame_len, out_len;
+
+            uint64_t start = time_monotonic_ns();
+            if (sensor_compressor_compress(compressor, codec, dict, (const uint8_t *)payloads[i],
+                                           sizes[i], &frame, &frame_len) != PAUMIOT_SUCCESS) {
+                fprintf(stderr, "compression failed\n");
+                exit(1);
+            }
+            uint64_t middle = time_monotonic_ns();
+            if (sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len,
+                                             NULL) != PAUMIOT_SUCCESS) {
+                fprintf(stderr, "decompression failed\n");
+                exit(1);
+            }
+            decompress_ns += time_monotonic_ns() - middle;
+            compress_ns += middle - start;
+
+            if (it == 0) {
+                frame_total += frame_len;
+            }
+            sensor_compressor_release(compressor, frame);
+            sensor_compressor_release(compressor, out);
+        }
+    }
+
+    double payloads_run = (double)iterations * NUM_PAYLOADS;
+    printf("%-10s %10zu %7.1f%% %14.1f %16.1f\n", sensor_compress_encoding(codec), frame_total,
+           100.0 * (1.0 - (double)frame_total / (double)raw_total),
+           (double)compress_ns / payloads_run, (double)decompress_ns / payloads_run);
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    size_t dict_size = argc > 2 ? strtoul(argv[2], NULL, 10) : 2048;
+    if (iterations <= 0 || dict_size == 0 || dict_size > SENSOR_COMPRESS_MAX_DICT_SIZE) {
+        fprintf(stderr, "usage: %s [iterations] [dict_size]\n", argv[0]);
+        return 1;
+    }
+
+    const uint8_t *samples[NUM_TRAINING];
+    size_t raw_total = 0;
+    for (int i = 0; i < NUM_TRAINING + NUM_PAYLOADS; i++) {
+        sizes[i] = make_payload(payloads[i], sizeof(payloads[i]), i * 7919);
+        if (i < NUM_TRAINING) {
+            samples[i] = (const uint8_t *)payloads[i];
+        } else {
+            raw_total += sizes[i];
+        }
+    }
+
+    uint64_t start = time_monotonic_ns();
+    sensor_compress_dict_t *dict = sensor_compress_dict_train(samples, sizes, NUM_TRAINING,
+                                                              dict_size);
+    double train_ms = (double)(time_monotonic_ns() - start) / 1e6;
+    if (!dict) {
+        fprintf(stderr, "training failed\n");
+        return 1;
+    }
+
+    sensor_compress_dict_data(dict, &dict_size);
+    sensor_compressor_t *compressor = sensor_compressor_create(192, 4);
+    sensor_compressor_add_dict(compressor, dict);
+
+    printf("Compression: %d payloads (%zu bytes, avg %.0f), %d iterations, "
+           "%zu-byte dictionary trained in %.1f ms\n\n",
+           NUM_PAYLOADS, raw_total, (double)raw_total / NUM_PAYLOADS, iterations, dict_size,
+           train_ms);
+    printf("%-10s %10s %8s %14s %16s\n", "codec", "bytes", "saved", "compress ns", "decompress ns");
+
+    run(compressor, SENSOR_COMPRESSION_NONE, NULL, iterations, raw_total);
+    run(compressor, SENSOR_COMPRESSION_LZ4, NULL, iterations, raw_total);
+    run(compressor, SENSOR_COMPRESSION_LZ4_DICT, dict, iterations, raw_total);
+
+    sensor_compressor_destroy(compressor);
+    sensor_compress_dict_destroy(dict);
+    return 0;
+}
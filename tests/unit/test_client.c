@@ -0,0 +1,1685 @@
+/**
+ * @file test_client.c
+ * @brief Unit tests for the client plugin against an in-process MQTT broker
+ *        and CoAP server
+ */
+
+#include "paumiot_client.h"
+#include "client_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#define TEST_DEADLINE_NS (5ull * 1000000000ull)
+#define MAX_PENDING 1024
+#define BROKER_BUFFER_SIZE 65536
+#define SHARED_CLIENTS 8
+#define COAP_MAX_HELD 64
+#define COAP_MAX_SEEN 4096
+#define COAP_CONTENT 0x45           /* 2.05 Content */
+
+/* ========================================
+ * Fake Broker
+ * ======================================== */
+
+/* One connection at a time, scripted by the fields set before start */
+typedef struct {
+    int listen_fd;
+    uint16_t port;
+    pthread_t thread;
+
+    /* Behaviour */
+    size_t hold_acks;           /* Withhold acks until this many are pending */
+    size_t close_after;         /* Drop the connection after N publishes (0 = never) */
+    size_t accepts;             /* Connections to serve before exiting (0 = 1) */
+    bool publish_on_subscribe;  /* Answer SUBSCRIBE with a QoS 1 message */
+    bool also_publish_qos0;     /* ...followed by a QoS 0 one */
+
+    /* Observations (read after broker_stop) */
+    size_t publishes;
+    size_t max_pending;
+    size_t max_publishes_per_read; /* Most publishes arriving in one recv() */
+    size_t topic_switches;      /* Publishes whose topic starts unlike the previous one */
+    char last_topic_start;
+    bool client_acked;          /* PUBACK for the message we sent */
+    bool disconnect_seen;
+} broker_t;
+
+static void broker_send(int fd, const uint8_t *data, size_t len) {
+    assert(send(fd, data, len, MSG_NOSIGNAL) == (ssize_t)len);
+}
+
+/* Acknowledge pending publishes newest first, so the client must match by ID */
+static void broker_release(int fd, uint16_t *pending, uint8_t *types, size_t *count) {
+    while (*count > 0) {
+        (*count)--;
+        uint8_t ack[4];
+        broker_send(fd, ack, client_mqtt_encode_ack(ack, types[*count], pending[*count]));
+    }
+}
+
+static void broker_serve(broker_t *broker, int fd, uint8_t *buf) {
+    size_t len = 0;
+    uint16_t pending[MAX_PENDING];
+    uint8_t types[MAX_PENDING];
+    size_t pending_count = 0;
+    bool open = true;
+
+    while (open) {
+        ssize_t n = recv(fd, buf + len, BROKER_BUFFER_SIZE - len, 0);
+        if (n <= 0) {
+            break;
+        }
+        len += (size_t)n;
+        size_t read_publishes = 0;
+
+        for (;;) {
+            uint8_t type;
+            uint8_t flags;
+            size_t body;
+            size_t body_len;
+            long packet = client_mqtt_parse(buf, len, &type, &flags, &body, &body_len);
+            assert(packet >= 0);
+            if (packet == 0) {
+                break;
+            }
+            const uint8_t *p = buf + body;
+
+            if (type == CLIENT_MQTT_CONNECT) {
+                const uint8_t connack[4] = { 0x20, 0x02, 0x00, 0x00 };
+                broker_send(fd, connack, sizeof(connack));
+            } else if (type == CLIENT_MQTT_PUBLISH) {
+                int qos = (flags >> 1) & 0x03;
+                broker->publishes++;
+                if (broker->publishes > 1 && (char)p[2] != broker->last_topic_start) {
+                    broker->topic_switches++;
+                }
+                broker->last_topic_start = (char)p[2];
+                if (++read_publishes > broker->max_publishes_per_read) {
+                    broker->max_publishes_per_read = read_publishes;
+                }
+                if (qos > 0) {
+                    size_t topic_len = (size_t)((p[0] << 8) | p[1]);
+                    assert(pending_count < MAX_PENDING);
+                    pending[pending_count] = (uint16_t)((p[2 + topic_len] << 8) | p[3 + topic_len]);
+                    types[pending_count] = qos == 1 ? CLIENT_MQTT_PUBACK : CLIENT_MQTT_PUBREC;
+                    pending_count++;
+                    if (pending_count > broker->max_pending) {
+                        broker->max_pending = pending_count;
+                    }
+                    if (pending_count >= broker->hold_acks) {
+                        broker_release(fd, pending, types, &pending_count);
+                    }
+                }
+                if (broker->close_after && broker->publishes == broker->close_after) {
+                    open = false;
+                    break;
+                }
+            } else if (type == CLIENT_MQTT_PUBREL) {
+                uint8_t ack[4];
+                broker_send(fd, ack, client_mqtt_encode_ack(ack, CLIENT_MQTT_PUBCOMP,
+                                                            (uint16_t)((p[0] << 8) | p[1])));
+            } else if (type == CLIENT_MQTT_SUBSCRIBE) {
+                uint8_t suback[5] = { 0x90, 0x03, p[0], p[1], p[body_len - 1] };
+                broker_send(fd, suback, sizeof(suback));
+                if (broker->publish_on_subscribe) {
+                    uint8_t msg[64];
+                    const char *payload = "21.5";
+                    broker_send(fd, msg, client_mqtt_encode_publish(
+                        msg, sizeof(msg), "sensors/a/temp", 14, (const uint8_t *)payload,
+                        strlen(payload), PAUMIOT_QOS_1, false, 7));
+                    if (broker->also_publish_qos0) {
+                        broker_send(fd, msg, client_mqtt_encode_publish(
+                            msg, sizeof(msg), "sensors/b/temp", 14, (const uint8_t *)"-3",
+                            2, PAUMIOT_QOS_0, true, 0));
+                    }
+                }
+            } else if (type == CLIENT_MQTT_PUBACK) {
+                broker->client_acked = (((p[0] << 8) | p[1]) == 7);
+            } else if (type == CLIENT_MQTT_PINGREQ) {
+                const uint8_t pingresp[2] = { 0xD0, 0x00 };
+                broker_send(fd, pingresp, sizeof(pingresp));
+            } else if (type == CLIENT_MQTT_DISCONNECT) {
+                broker->disconnect_seen = true;
+                open = false;
+                break;
+            }
+
+            memmove(buf, buf + packet, len - (size_t)packet);
+            len -= (size_t)packet;
+        }
+    }
+}
+
+static void *broker_thread(void *arg) {
+    broker_t *broker = (broker_t *)arg;
+    uint8_t *buf = (uint8_t *)malloc(BROKER_BUFFER_SIZE);
+    assert(buf != NULL);
+
+    size_t accepts = broker->accepts ? broker->accepts : 1;
+    for (size_t i = 0; i < accepts; i++) {
+        int fd = accept(broker->listen_fd, NULL, NULL);
+        assert(fd >= 0);
+        broker_serve(broker, fd, buf);
+        close(fd);
+    }
+    free(buf);
+    return NULL;
+}
+
+static void broker_start(broker_t *broker) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    broker->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(broker->listen_fd >= 0);
+    assert(bind(broker->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(listen(broker->listen_fd, 4) == 0);
+
+    socklen_t addr_len = sizeof(addr);
+    assert(getsockname(broker->listen_fd, (struct sockaddr *)&addr, &addr_len) == 0);
+    broker->port = ntohs(addr.sin_port);
+    assert(pthread_create(&broker->thread, NULL, broker_thread, broker) == 0);
+}
+
+static void broker_stop(broker_t *broker) {
+    pthread_join(broker->thread, NULL);
+    close(broker->listen_fd);
+}
+
+/* ========================================
+ * Fake CoAP Server
+ * ======================================== */
+
+/* Answers every request with its own payload in a 2.05 response, except:
+ * "silent" is never answered, "separate" gets an empty ACK and then a
+ * confirmable response, "reset" gets RST */
+typedef struct {
+    int fd;
+    uint16_t port;
+    pthread_t thread;
+    bool stop;
+
+    /* Behaviour */
+    size_t hold;                /* Answer once this many are unanswered, newest first */
+    bool drop_first;            /* Ignore the first copy of each CON request */
+
+    /* Observations (read after coap_server_stop) */
+    size_t requests;            /* Distinct requests */
+    size_t max_outstanding;     /* Most requests waiting for an answer at once */
+    size_t silent_copies;       /* Copies of "silent" received */
+    size_t acks;                /* Empty ACKs for our confirmable responses */
+} coap_server_t;
+
+typedef struct {
+    uint8_t type;
+    uint16_t mid;
+    uint8_t token[8];
+    size_t token_len;
+    uint8_t payload[16];
+    size_t payload_len;
+} coap_held_t;
+
+static void coap_server_send(coap_server_t *server, const struct sockaddr_in *to, uint8_t type,
+                             uint8_t code, uint16_t mid, const coap_held_t *req) {
+    uint8_t buf[64];
+    size_t len = client_coap_encode(buf, sizeof(buf), type, code, mid, req->token,
+                                    req->token_len, "", req->payload, req->payload_len);
+    assert(len > 0);
+    assert(sendto(server->fd, buf, len, 0, (const struct sockaddr *)to, sizeof(*to)) ==
+           (ssize_t)len);
+}
+
+static void coap_server_answer(coap_server_t *server, const struct sockaddr_in *to,
+                               const coap_held_t *req, uint16_t *next_mid) {
+    if (req->type == CLIENT_COAP_CON) {
+        coap_server_send(server, to, CLIENT_COAP_ACK, COAP_CONTENT, req->mid, req);
+    } else {
+        coap_server_send(server, to, CLIENT_COAP_NON, COAP_CONTENT, (*next_mid)++, req);
+    }
+}
+
+static bool payload_is(const coap_held_t *req, const char *text) {
+    return req->payload_len == strlen(text) && memcmp(req->payload, text, req->payload_len) == 0;
+}
+
+static void *coap_server_thread(void *arg) {
+    coap_server_t *server = (coap_server_t *)arg;
+    coap_held_t held[COAP_MAX_HELD];
+    size_t held_count = 0;
+    uint16_t *seen = (uint16_t *)malloc(COAP_MAX_SEEN * sizeof(uint16_t));
+    size_t seen_count = 0;
+    uint16_t next_mid = 0x7000;
+    struct sockaddr_in peer;
+    memset(&peer, 0, sizeof(peer));
+    assert(seen != NULL);
+
+    for (;;) {
+        struct pollfd pfd = { .fd = server->fd, .events = POLLIN, .revents = 0 };
+        if (poll(&pfd, 1, 20) != 1) {
+            /* Idle: answer the rest, or exit once asked to */
+            while (held_count > 0) {
+                coap_server_answer(server, &peer, &held[--held_count], &next_mid);
+            }
+            if (__atomic_load_n(&server->stop, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            continue;
+        }
+
+        uint8_t buf[1500];
+        socklen_t peer_len = sizeof(peer);
+        ssize_t n = recvfrom(server->fd, buf, sizeof(buf), 0, (struct sockaddr *)&peer,
+                             &peer_len);
+        assert(n > 0);
+        client_coap_message_t msg;
+        assert(client_coap_parse(buf, (size_t)n, &msg));
+        if (msg.code == 0) {
+            assert(msg.type == CLIENT_COAP_ACK);
+            server->acks++;
+            continue;
+        }
+
+        coap_held_t req;
+        req.type = msg.type;
+        req.mid = msg.mid;
+        req.token_len = msg.token_len;
+        memcpy(req.token, msg.token, msg.token_len);
+        assert(msg.payload_len <= sizeof(req.payload));
+        req.payload_len = msg.payload_len;
+        memcpy(req.payload, msg.payload, msg.payload_len);
+
+        bool first = true;
+        for (size_t i = 0; i < seen_count && first; i++) {
+            first = seen[i] != msg.mid;
+        }
+        if (first) {
+            assert(seen_count < COAP_MAX_SEEN);
+            seen[seen_count++] = msg.mid;
+            server->requests++;
+        }
+        if (payload_is(&req, "silent")) {
+            server->silent_copies++;
+            continue;
+        }
+        if (server->drop_first && first && req.type == CLIENT_COAP_CON) {
+            continue;
+        }
+
+        if (payload_is(&req, "separate")) {
+            uint8_t ack[4];
+            client_coap_encode_empty(ack, CLIENT_COAP_ACK, req.mid);
+            assert(sendto(server->fd, ack, 4, 0, (struct sockaddr *)&peer, sizeof(peer)) == 4);
+            coap_server_send(server, &peer, CLIENT_COAP_CON, COAP_CONTENT, next_mid++, &req);
+        } else if (payload_is(&req, "reset")) {
+            uint8_t rst[4];
+            client_coap_encode_empty(rst, CLIENT_COAP_RST, req.mid);
+            assert(sendto(server->fd, rst, 4, 0, (struct sockaddr *)&peer, sizeof(peer)) == 4);
+        } else if (server->hold > 0) {
+            assert(held_count < COAP_MAX_HELD);
+            held[held_count++] = req;
+            if (held_count > server->max_outstanding) {
+                server->max_outstanding = held_count;
+            }
+            if (held_count == server->hold) {
+                while (held_count > 0) {
+                    coap_server_answer(server, &peer, &held[--held_count], &next_mid);
+                }
+            }
+        } else {
+            coap_server_answer(server, &peer, &req, &next_mid);
+        }
+    }
+    free(seen);
+    return NULL;
+}
+
+static void coap_server_start(coap_server_t *server) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    server->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(server->fd >= 0);
+    assert(bind(server->fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    socklen_t addr_len = sizeof(addr);
+    assert(getsockname(server->fd, (struct sockaddr *)&addr, &addr_len) == 0);
+    server->port = ntohs(addr.sin_port);
+    assert(pthread_create(&server->thread, NULL, coap_server_thread, server) == 0);
+}
+
+static void coap_server_stop(coap_server_t *server) {
+    __atomic_store_n(&server->stop, true, __ATOMIC_RELEASE);
+    pthread_join(server->thread, NULL);
+    close(server->fd);
+}
+
+/* ========================================
+ * Helpers
+ * ======================================== */
+
+typedef struct {
+    size_t done;
+    size_t succeeded;
+    pthread_t thread;           /* Thread of the last callback */
+} publish_counter_t;
+
+static void count_publish(paumiot_client_t *client, const char *message_id, bool success,
+                          void *user_data) {
+    (void)client;
+    assert(message_id != NULL && message_id[0] != '\0');
+    publish_counter_t *counter = (publish_counter_t *)user_data;
+    counter->thread = pthread_self();
+    counter->succeeded += success ? 1 : 0;
+    __atomic_add_fetch(&counter->done, 1, __ATOMIC_RELEASE);   /* Polled by the loop thread test */
+}
+
+static paumiot_client_t *connect_client(paumiot_client_config_t *config, broker_t *broker,
+                                        size_t window) {
+    paumiot_client_config_init(config);
+    config->host = "127.0.0.1";
+    config->port = broker->port;
+    config->max_inflight_messages = window;
+    config->client_id = "test-client";
+
+    paumiot_client_t *client = paumiot_client_create(config);
+    assert(client != NULL);
+    assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_is_connected(client));
+    return client;
+}
+
+/* Wait for a counter advanced by a loop thread */
+static void wait_for(const size_t *count, size_t target) {
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    while (__atomic_load_n(count, __ATOMIC_ACQUIRE) < target) {
+        assert(client_now_ns() < deadline);
+        usleep(1000);
+    }
+}
+
+static bool fd_readable(int fd, int timeout_ms) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+    return poll(&pfd, 1, timeout_ms) == 1 && (pfd.revents & POLLIN);
+}
+
+/* Run the loop until *count reaches target */
+static void loop_until(paumiot_client_t *client, const size_t *count, size_t target) {
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    while (*count < target) {
+        assert(client_now_ns() < deadline);
+        paumiot_client_loop(client, 10);
+    }
+}
+
+/* ========================================
+ * Basic Functionality Tests
+ * ======================================== */
+
+static void test_client_config_defaults(void) {
+    printf("Testing config defaults and errors...\n");
+
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    assert(config.port == CLIENT_DEFAULT_MQTT_PORT);
+    assert(config.max_inflight_messages == CLIENT_DEFAULT_MAX_INFLIGHT);
+    assert(config.send_buffer_size > 0 && config.recv_buffer_size > 0);
+
+    int major, minor, patch;
+    paumiot_client_get_version(&major, &minor, &patch);
+    assert(major == PAUMIOT_CLIENT_VERSION_MAJOR);
+    assert(strcmp(paumiot_client_error_string(PAUMIOT_CLIENT_ERROR_WOULD_BLOCK),
+                  "Unknown error") != 0);
+
+    /* Invalid configurations */
+    assert(paumiot_client_create(NULL) == NULL);
+    config.max_inflight_messages = 0;
+    assert(paumiot_client_create(&config) == NULL);
+    config.max_inflight_messages = 8;
+    config.protocol = PAUMIOT_PROTOCOL_HTTP;
+    assert(paumiot_client_create(&config) == NULL);
+
+    /* Not connected */
+    config.protocol = PAUMIOT_PROTOCOL_MQTT;
+    paumiot_client_t *client = paumiot_client_create(&config);
+    assert(client != NULL);
+    assert(paumiot_client_get_state(client) == PAUMIOT_STATE_DISCONNECTED);
+    assert(paumiot_client_publish_async(client, "a/b", NULL, 0, PAUMIOT_QOS_1, false, NULL,
+                                        NULL) == PAUMIOT_CLIENT_ERROR_NOT_CONNECTED);
+    assert(paumiot_client_publish_async(client, "a/+", NULL, 0, PAUMIOT_QOS_0, false, NULL,
+                                        NULL) == PAUMIOT_CLIENT_ERROR_INVALID_PARAM);
+    assert(paumiot_client_loop(client, 0) == PAUMIOT_CLIENT_ERROR_NOT_CONNECTED);
+    paumiot_client_destroy(client);
+    paumiot_client_destroy(NULL);
+
+    printf("  ✓ Config defaults test passed\n");
+}
+
+static void test_client_topic_matching(void) {
+    printf("Testing topic filter matching...\n");
+
+    assert(client_mqtt_topic_matches("a/b", "a/b", 3));
+    assert(!client_mqtt_topic_matches("a/b", "a/bc", 4));
+    assert(!client_mqtt_topic_matches("a/b", "a/b/c", 5));
+    assert(client_mqtt_topic_matches("a/+/c", "a/x/c", 5));
+    assert(!client_mqtt_topic_matches("a/+/c", "a/x/y/c", 7));
+    assert(client_mqtt_topic_matches("a/+", "a/", 2));
+    assert(client_mqtt_topic_matches("a/#", "a", 1));
+    assert(client_mqtt_topic_matches("a/#", "a/b/c", 5));
+    assert(client_mqtt_topic_matches("#", "x/y", 3));
+    assert(!client_mqtt_topic_matches("#", "$SYS/x", 6));
+    assert(!client_mqtt_topic_matches("+/x", "$SYS/x", 6));
+
+    /* Length-bounded: the topic need not be NUL-terminated */
+    assert(client_mqtt_topic_matches("a/b", "a/bXYZ", 3));
+
+    printf("  ✓ Topic matching test passed\n");
+}
+
+static void test_client_connect_refused(void) {
+    printf("Testing connect to a closed port...\n");
+
+    /* Bind and close to find a port nobody listens on */
+    broker_t probe;
+    memset(&probe, 0, sizeof(probe));
+    probe.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    assert(bind(probe.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(getsockname(probe.listen_fd, (struct sockaddr *)&addr, &addr_len) == 0);
+    close(probe.listen_fd);
+
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    config.host = "127.0.0.1";
+    config.port = ntohs(addr.sin_port);
+    config.connect_timeout_ms = 1000;
+    paumiot_client_t *client = paumiot_client_create(&config);
+    assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_ERROR_CONNECTION_FAILED);
+    assert(paumiot_client_get_state(client) == PAUMIOT_STATE_DISCONNECTED);
+    paumiot_client_destroy(client);
+
+    printf("  ✓ Connect refused test passed\n");
+}
+
+/* ========================================
+ * Inflight Window Tests
+ * ======================================== */
+
+static void test_client_inflight_window(void) {
+    printf("Testing pipelined QoS 1 publishes with an inflight window...\n");
+
+    /* The broker acks only once 8 publishes are outstanding: a client doing
+     * stop-and-wait would never get an ack */
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker.hold_acks = 8;
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_t *client = connect_client(&config, &broker, 8);
+    publish_counter_t counter = { 0, 0, pthread_self() };
+    const uint8_t payload[] = "reading";
+
+    for (int i = 0; i < 8; i++) {
+        assert(paumiot_client_publish_async(client, "sensors/1", payload, sizeof(payload),
+                                            PAUMIOT_QOS_1, false, count_publish,
+                                            &counter) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    assert(paumiot_client_publish_async(client, "sensors/1", payload, sizeof(payload),
+                                        PAUMIOT_QOS_1, false, count_publish,
+                                        &counter) == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK);
+    assert(counter.done == 0);
+
+    /* Acks arrive newest first and each finds its slot by packet ID */
+    loop_until(client, &counter.done, 8);
+    assert(counter.succeeded == 8);
+
+    /* Keep the window full for a longer run */
+    size_t sent = 8;
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    while (sent < 200) {
+        assert(client_now_ns() < deadline);
+        paumiot_client_result_t result = paumiot_client_publish_async(
+            client, "sensors/1", payload, sizeof(payload), PAUMIOT_QOS_1, false,
+            count_publish, &counter);
+        if (result == PAUMIOT_CLIENT_SUCCESS) {
+            sent++;
+        } else {
+            assert(result == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK);
+            paumiot_client_loop(client, 10);
+        }
+    }
+    loop_until(client, &counter.done, 200);
+    assert(counter.succeeded == 200);
+
+    /* QoS 0 callbacks wait for the loop */
+    publish_counter_t qos0 = { 0, 0, pthread_self() };
+    assert(paumiot_client_publish_async(client, "sensors/1", payload, sizeof(payload),
+                                        PAUMIOT_QOS_0, false, count_publish,
+                                        &qos0) == PAUMIOT_CLIENT_SUCCESS);
+    assert(qos0.done == 0);
+    loop_until(client, &qos0.done, 1);
+    assert(qos0.succeeded == 1);
+
+    assert(paumiot_client_disconnect(client) == PAUMIOT_CLIENT_SUCCESS);
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+
+    assert(broker.publishes == 201);
+    assert(broker.max_pending == 8);
+    assert(broker.disconnect_seen);
+
+    printf("  ✓ Inflight window test passed\n");
+}
+
+static void test_client_publish_batch(void) {
+    printf("Testing batch publish with one socket write...\n");
+
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_t *client = connect_client(&config, &broker, 8);
+    publish_counter_t counter = { 0, 0, pthread_self() };
+    char topics[50][sizeof("sensors/-2147483648/temp")];
+    uint8_t readings[50];
+    paumiot_message_t messages[50];
+
+    for (int i = 0; i < 50; i++) {
+        snprintf(topics[i], sizeof(topics[i]), "sensors/%d/temp", i);
+        readings[i] = (uint8_t)i;
+        messages[i].topic = topics[i];
+        messages[i].payload = &readings[i];
+        messages[i].payload_len = 1;
+        messages[i].qos = PAUMIOT_QOS_0;
+        messages[i].retain = false;
+        messages[i].user_data = &counter;
+    }
+
+    /* An invalid message rejects the whole batch */
+    size_t published = 99;
+    messages[3].topic = "sensors/+/temp";
+    assert(paumiot_client_publish_batch(client, messages, 50, count_publish,
+                                        &published) == PAUMIOT_CLIENT_ERROR_INVALID_PARAM);
+    assert(published == 0);
+    messages[3].topic = topics[3];
+
+    /* Fifty readings arrive at the broker in a single read */
+    assert(paumiot_client_publish_batch(client, messages, 50, count_publish,
+                                        &published) == PAUMIOT_CLIENT_SUCCESS);
+    assert(published == 50);
+    loop_until(client, &counter.done, 50);
+    assert(counter.succeeded == 50);
+
+    /* QoS 1 messages beyond the window are left to the caller */
+    for (int i = 0; i < 10; i++) {
+        messages[i].qos = PAUMIOT_QOS_1;
+    }
+    assert(paumiot_client_publish_batch(client, messages, 10, count_publish,
+                                        &published) == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK);
+    assert(published == 8);
+    loop_until(client, &counter.done, 58);
+    assert(paumiot_client_publish_batch(client, messages + 8, 2, count_publish,
+                                        &published) == PAUMIOT_CLIENT_SUCCESS);
+    assert(published == 2);
+    loop_until(client, &counter.done, 60);
+    assert(counter.succeeded == 60);
+
+    assert(paumiot_client_disconnect(client) == PAUMIOT_CLIENT_SUCCESS);
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+
+    assert(broker.publishes == 60);
+    assert(broker.max_publishes_per_read == 50);
+
+    printf("  ✓ Batch publish test passed\n");
+}
+
+static void test_client_qos2(void) {
+    printf("Testing QoS 2 publish flow...\n");
+
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker.hold_acks = 4;
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_t *client = connect_client(&config, &broker, 4);
+    publish_counter_t counter = { 0, 0, pthread_self() };
+
+    for (int i = 0; i < 4; i++) {
+        assert(paumiot_client_publish_async(client, "sensors/2", (const uint8_t *)"x", 1,
+                                            PAUMIOT_QOS_2, false, count_publish,
+                                            &counter) == PAUMIOT_CLIENT_SUCCESS);
+    }
+
+    /* PUBREC -> PUBREL -> PUBCOMP before the callback */
+    loop_until(client, &counter.done, 4);
+    assert(counter.succeeded == 4);
+
+    paumiot_client_disconnect(client);
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+    assert(broker.max_pending == 4);
+
+    printf("  ✓ QoS 2 test passed\n");
+}
+
+typedef struct {
+    size_t received;
+    char topic[32];
+    char payload[16];
+} message_log_t;
+
+static void log_message(paumiot_client_t *client, const paumiot_message_t *message,
+                        void *user_data) {
+    (void)client;
+    message_log_t *log = (message_log_t *)user_data;
+    snprintf(log->topic, sizeof(log->topic), "%s", message->topic);
+    snprintf(log->payload, sizeof(log->payload), "%.*s", (int)message->payload_len,
+             (const char *)message->payload);
+    assert(message->qos == PAUMIOT_QOS_1);
+    log->received++;
+}
+
+static void test_client_subscribe(void) {
+    printf("Testing subscribe and message delivery...\n");
+
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker.publish_on_subscribe = true;
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_t *client = connect_client(&config, &broker, 4);
+    message_log_t log;
+    memset(&log, 0, sizeof(log));
+
+    assert(paumiot_client_subscribe(client, "sensors/+/temp", PAUMIOT_QOS_1, log_message,
+                                    &log) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_subscribe(client, "sensors/+/temp", PAUMIOT_QOS_1, log_message,
+                                    &log) == PAUMIOT_CLIENT_ERROR_ALREADY_SUBSCRIBED);
+    loop_until(client, &log.received, 1);
+    assert(strcmp(log.topic, "sensors/a/temp") == 0);
+    assert(strcmp(log.payload, "21.5") == 0);
+
+    assert(paumiot_client_unsubscribe(client, "sensors/+/temp") == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_unsubscribe(client, "sensors/+/temp") ==
+           PAUMIOT_CLIENT_ERROR_NOT_SUBSCRIBED);
+
+    paumiot_client_disconnect(client);
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+    assert(broker.client_acked);
+
+    printf("  ✓ Subscribe test passed\n");
+}
+
+typedef struct {
+    const paumiot_client_t *client;
+    size_t received;
+    size_t borrowed;            /* Topic and payload inside the receive buffer */
+    paumiot_message_t *kept[2];
+} borrow_log_t;
+
+static bool in_recv_buffer(const paumiot_client_t *client, const void *p, size_t len) {
+    const uint8_t *byte = (const uint8_t *)p;
+    return byte >= client->in.data && byte + len <= client->in.data + client->in.size;
+}
+
+static void keep_message(paumiot_client_t *client, const paumiot_message_t *message,
+                         void *user_data) {
+    borrow_log_t *log = (borrow_log_t *)user_data;
+    assert(client == log->client && log->received < 2);
+    if (in_recv_buffer(client, message->topic, strlen(message->topic) + 1) &&
+        in_recv_buffer(client, message->payload, message->payload_len)) {
+        log->borrowed++;
+    }
+    log->kept[log->received++] = paumiot_message_retain(message);
+}
+
+static void test_client_zero_copy(void) {
+    printf("Testing zero-copy receive and retain...\n");
+
+    for (int zero_copy = 0; zero_copy <= 1; zero_copy++) {
+        broker_t broker;
+        memset(&broker, 0, sizeof(broker));
+        broker.publish_on_subscribe = true;
+        broker.also_publish_qos0 = true;
+        broker_start(&broker);
+
+        paumiot_client_config_t config;
+        paumiot_client_config_init(&config);
+        config.host = "127.0.0.1";
+        config.port = broker.port;
+        config.zero_copy_receive = zero_copy;
+        paumiot_client_t *client = paumiot_client_create(&config);
+        assert(client != NULL);
+        assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_SUCCESS);
+
+        borrow_log_t log;
+        memset(&log, 0, sizeof(log));
+        log.client = client;
+        assert(paumiot_client_subscribe(client, "sensors/#", PAUMIOT_QOS_1, keep_message,
+                                        &log) == PAUMIOT_CLIENT_SUCCESS);
+        loop_until(client, &log.received, 2);
+        assert(log.borrowed == (zero_copy ? 2u : 0u));
+
+        /* The copies outlive the callback and the client */
+        paumiot_client_disconnect(client);
+        paumiot_client_destroy(client);
+        broker_stop(&broker);
+        assert(broker.client_acked);
+
+        assert(log.kept[0] && log.kept[1]);
+        assert(strcmp(log.kept[0]->topic, "sensors/a/temp") == 0);
+        assert(log.kept[0]->payload_len == 4 && memcmp(log.kept[0]->payload, "21.5", 4) == 0);
+        assert(log.kept[0]->qos == PAUMIOT_QOS_1 && !log.kept[0]->retain);
+        assert(strcmp(log.kept[1]->topic, "sensors/b/temp") == 0);
+        assert(log.kept[1]->payload_len == 2 && memcmp(log.kept[1]->payload, "-3", 2) == 0);
+        assert(log.kept[1]->qos == PAUMIOT_QOS_0 && log.kept[1]->retain);
+        paumiot_message_release(log.kept[0]);
+        paumiot_message_release(log.kept[1]);
+    }
+
+    /* Empty payloads and argument checks */
+    paumiot_message_t empty = { (char *)"t", NULL, 0, PAUMIOT_QOS_0, false, NULL };
+    paumiot_message_t *copy = paumiot_message_retain(&empty);
+    assert(copy != NULL && strcmp(copy->topic, "t") == 0 && copy->payload_len == 0);
+    paumiot_message_release(copy);
+    assert(paumiot_message_retain(NULL) == NULL);
+    paumiot_message_release(NULL);
+
+    printf("  ✓ Zero-copy receive test passed\n");
+}
+
+/* ========================================
+ * Threading and Failure Tests
+ * ======================================== */
+
+static void test_client_loop_thread(void) {
+    printf("Testing background loop thread...\n");
+
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker.hold_acks = 1;
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_t *client = connect_client(&config, &broker, 16);
+    assert(paumiot_client_loop_start(client) == PAUMIOT_CLIENT_SUCCESS);
+
+    /* Synchronous publishes wait on the loop thread */
+    for (int i = 0; i < 20; i++) {
+        assert(paumiot_client_publish(client, "sensors/3", (const uint8_t *)"v", 1,
+                                      PAUMIOT_QOS_1, false) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    assert(paumiot_client_publish(client, "sensors/3", (const uint8_t *)"v", 1, PAUMIOT_QOS_0,
+                                  false) == PAUMIOT_CLIENT_SUCCESS);
+
+    /* Asynchronous callbacks fire on the loop thread */
+    publish_counter_t counter = { 0, 0, pthread_self() };
+    assert(paumiot_client_publish_async(client, "sensors/3", (const uint8_t *)"v", 1,
+                                        PAUMIOT_QOS_1, false, count_publish,
+                                        &counter) == PAUMIOT_CLIENT_SUCCESS);
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    while (paumiot_client_get_state(client) == PAUMIOT_STATE_CONNECTED &&
+           __atomic_load_n(&counter.done, __ATOMIC_ACQUIRE) == 0) {
+        assert(client_now_ns() < deadline);
+        usleep(1000);
+    }
+    assert(counter.succeeded == 1);
+    assert(!pthread_equal(counter.thread, pthread_self()));
+
+    assert(paumiot_client_disconnect(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_get_state(client) == PAUMIOT_STATE_DISCONNECTED);
+    assert(paumiot_client_loop_stop(client) == PAUMIOT_CLIENT_SUCCESS);
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+    assert(broker.publishes == 22);
+
+    printf("  ✓ Loop thread test passed\n");
+}
+
+static void test_client_embedded_fd(void) {
+    printf("Testing the descriptor for application event loops...\n");
+
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    config.host = "127.0.0.1";
+    config.port = broker.port;
+    config.keepalive_interval_ms = 100;
+    paumiot_client_t *client = paumiot_client_create(&config);
+    assert(client != NULL);
+    int fd = paumiot_client_get_fd(client);
+    assert(fd >= 0);
+    assert(paumiot_client_get_fd(NULL) == -1);
+    assert(paumiot_client_next_timeout(client) == -1);
+
+    assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_get_fd(client) == fd);
+    int timeout = paumiot_client_next_timeout(client);
+    assert(timeout >= 0 && timeout <= 100);
+
+    /* Connecting woke the loop; one pass arms the keep-alive timer */
+    assert(fd_readable(fd, 0));
+    assert(paumiot_client_loop(client, 0) == PAUMIOT_CLIENT_SUCCESS);
+    assert(!fd_readable(fd, 0));
+
+    /* A queued QoS 0 callback makes the descriptor readable */
+    publish_counter_t counter = { 0, 0, pthread_self() };
+    assert(paumiot_client_publish_async(client, "sensors/4", (const uint8_t *)"v", 1,
+                                        PAUMIOT_QOS_0, false, count_publish,
+                                        &counter) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_next_timeout(client) == 0);
+    assert(fd_readable(fd, 0));
+    assert(paumiot_client_loop(client, 0) == PAUMIOT_CLIENT_SUCCESS);
+    assert(counter.done == 1);
+
+    /* The keep-alive timer wakes the descriptor without any traffic, and
+     * the PINGREQ it triggers is answered */
+    for (int i = 0; i < 6; i++) {
+        assert(fd_readable(fd, 1000));
+        assert(paumiot_client_loop(client, 0) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    assert(paumiot_client_is_connected(client));
+
+    assert(paumiot_client_disconnect(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_next_timeout(client) == -1);
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+
+    printf("  ✓ Embedded descriptor test passed\n");
+}
+
+static void test_client_shared_event_loop(void) {
+    printf("Testing many clients on one event loop...\n");
+
+    broker_t brokers[SHARED_CLIENTS];
+    paumiot_client_config_t configs[SHARED_CLIENTS];
+    paumiot_client_t *clients[SHARED_CLIENTS];
+    publish_counter_t counter = { 0, 0, pthread_self() };
+
+    paumiot_event_loop_t *loop = paumiot_event_loop_create();
+    assert(loop != NULL);
+    for (int i = 0; i < SHARED_CLIENTS; i++) {
+        memset(&brokers[i], 0, sizeof(brokers[i]));
+        brokers[i].hold_acks = 4;
+        broker_start(&brokers[i]);
+        clients[i] = connect_client(&configs[i], &brokers[i], 4);
+        assert(paumiot_event_loop_add(loop, clients[i]) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    assert(paumiot_event_loop_add(loop, clients[0]) == PAUMIOT_CLIENT_ERROR_INVALID_PARAM);
+    assert(paumiot_client_loop_start(clients[0]) == PAUMIOT_CLIENT_ERROR_INVALID_PARAM);
+
+    /* Driven by the application */
+    for (int i = 0; i < SHARED_CLIENTS; i++) {
+        for (int j = 0; j < 4; j++) {
+            assert(paumiot_client_publish_async(clients[i], "sensors/5", (const uint8_t *)"v", 1,
+                                                PAUMIOT_QOS_1, false, count_publish,
+                                                &counter) == PAUMIOT_CLIENT_SUCCESS);
+        }
+    }
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    while (counter.done < 4 * SHARED_CLIENTS) {
+        assert(client_now_ns() < deadline);
+        assert(paumiot_event_loop_run(loop, 10) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    assert(pthread_equal(counter.thread, pthread_self()));
+
+    /* Driven by one I/O thread */
+    assert(paumiot_event_loop_start(loop) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_event_loop_run(loop, 0) == PAUMIOT_CLIENT_ERROR_INVALID_PARAM);
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < SHARED_CLIENTS; i++) {
+            for (int j = 0; j < 4; j++) {
+                for (;;) {
+                    paumiot_client_result_t result = paumiot_client_publish_async(
+                        clients[i], "sensors/5", (const uint8_t *)"v", 1, PAUMIOT_QOS_1, false,
+                        count_publish, &counter);
+                    if (result == PAUMIOT_CLIENT_SUCCESS) {
+                        break;
+                    }
+                    assert(result == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK);
+                    usleep(100);
+                }
+            }
+        }
+    }
+    wait_for(&counter.done, 44 * SHARED_CLIENTS);
+    assert(counter.succeeded == 44 * SHARED_CLIENTS);
+    assert(!pthread_equal(counter.thread, pthread_self()));
+
+    /* Detached clients are served by nobody */
+    assert(paumiot_event_loop_remove(loop, clients[0]) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_event_loop_remove(loop, clients[0]) == PAUMIOT_CLIENT_ERROR_INVALID_PARAM);
+
+    assert(paumiot_event_loop_stop(loop) == PAUMIOT_CLIENT_SUCCESS);
+    for (int i = 0; i < SHARED_CLIENTS; i++) {
+        assert(paumiot_client_disconnect(clients[i]) == PAUMIOT_CLIENT_SUCCESS);
+        paumiot_client_destroy(clients[i]);
+        broker_stop(&brokers[i]);
+    }
+    paumiot_event_loop_destroy(loop);
+
+    printf("  ✓ Shared event loop test passed\n");
+}
+
+static void test_client_connection_loss(void) {
+    printf("Testing connection loss with publishes in flight...\n");
+
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker.hold_acks = 100;
+    broker.close_after = 3;
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_t *client = connect_client(&config, &broker, 8);
+    publish_counter_t counter = { 0, 0, pthread_self() };
+
+    for (int i = 0; i < 3; i++) {
+        assert(paumiot_client_publish_async(client, "sensors/4", (const uint8_t *)"v", 1,
+                                            PAUMIOT_QOS_1, false, count_publish,
+                                            &counter) == PAUMIOT_CLIENT_SUCCESS);
+    }
+
+    /* Every outstanding publish reports failure */
+    loop_until(client, &counter.done, 3);
+    assert(counter.succeeded == 0);
+    assert(!paumiot_client_is_connected(client));
+    assert(paumiot_client_publish_async(client, "sensors/4", (const uint8_t *)"v", 1,
+                                        PAUMIOT_QOS_1, false, NULL,
+                                        NULL) == PAUMIOT_CLIENT_ERROR_NOT_CONNECTED);
+
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+
+    /* More publishes than one callback batch all fail, once, before disconnect returns */
+    memset(&broker, 0, sizeof(broker));
+    broker.hold_acks = 1000;
+    broker_start(&broker);
+    client = connect_client(&config, &broker, 256);
+    publish_counter_t many = { 0, 0, pthread_self() };
+    for (int i = 0; i < 200; i++) {
+        assert(paumiot_client_publish_async(client, "sensors/4", (const uint8_t *)"v", 1,
+                                            PAUMIOT_QOS_1, false, count_publish,
+                                            &many) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    assert(paumiot_client_disconnect(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(many.done == 200 && many.succeeded == 0);
+    assert(client->inflight_count == 0);
+
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+
+    /* A synchronous publish that timed out is still reported to, after it returned */
+    memset(&broker, 0, sizeof(broker));
+    broker.hold_acks = 1000;
+    broker_start(&broker);
+    client = connect_client(&config, &broker, 8);
+    assert(paumiot_client_loop_start(client) == PAUMIOT_CLIENT_SUCCESS);
+    config.connect_timeout_ms = 50;
+    for (int i = 0; i < 4; i++) {
+        assert(paumiot_client_publish(client, "sensors/4", (const uint8_t *)"v", 1,
+                                      PAUMIOT_QOS_1, false) == PAUMIOT_CLIENT_ERROR_TIMEOUT);
+    }
+    assert(paumiot_client_disconnect(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_loop_stop(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(client->inflight_count == 0);
+
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+
+    printf("  ✓ Connection loss test passed\n");
+}
+
+static void test_client_reconnect_backoff(void) {
+    printf("Testing jittered reconnect backoff...\n");
+
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker.close_after = 1;
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    assert(config.reconnect_max_delay_ms == CLIENT_DEFAULT_RECONNECT_MAX_DELAY_MS);
+    config.host = "127.0.0.1";
+    config.port = broker.port;
+    config.client_id = "test-client";
+    config.auto_reconnect = true;
+    config.reconnect_delay_ms = 10;
+    config.reconnect_max_delay_ms = 80;
+    config.max_reconnect_attempts = 6;
+    paumiot_client_t *client = paumiot_client_create(&config);
+    assert(client != NULL);
+    assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_SUCCESS);
+
+    /* The broker drops the connection and goes away: every attempt is refused */
+    assert(paumiot_client_publish_async(client, "a/b", (const uint8_t *)"v", 1, PAUMIOT_QOS_0,
+                                        false, NULL, NULL) == PAUMIOT_CLIENT_SUCCESS);
+    broker_stop(&broker);
+
+    uint32_t delays[8];
+    size_t attempts = 0;
+    uint32_t seen_attempts = UINT32_MAX;
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    for (;;) {
+        assert(client_now_ns() < deadline);
+        paumiot_client_loop(client, 5);
+        pthread_mutex_lock(&client->lock);
+        bool scheduled = client->reconnect_at_ns != 0;
+        uint32_t made = client->reconnect_attempts;
+        uint32_t delay = client->reconnect_delay_ms;
+        pthread_mutex_unlock(&client->lock);
+
+        if (scheduled && made != seen_attempts) {
+            assert(attempts < 8);
+            delays[attempts++] = delay;
+            seen_attempts = made;
+        }
+        if (!scheduled && made == config.max_reconnect_attempts) {
+            break;                      /* Gave up */
+        }
+    }
+
+    /* One delay per wait: [base, 3 x previous], capped */
+    assert(attempts == 6);
+    bool jittered = false;
+    for (size_t i = 0; i < attempts; i++) {
+        uint32_t high = i == 0 ? 30 : delays[i - 1] * 3;
+        assert(delays[i] >= 10 && delays[i] <= (high < 80 ? high : 80));
+        jittered |= i > 0 && delays[i] != delays[i - 1];
+    }
+    assert(jittered);
+    assert(paumiot_client_next_timeout(client) == -1);
+
+    paumiot_client_destroy(client);
+
+    printf("  ✓ Reconnect backoff test passed\n");
+}
+
+static void test_client_reconnect_nonblocking(void) {
+    printf("Testing reconnects without stalling a shared event loop...\n");
+
+    broker_t live;
+    memset(&live, 0, sizeof(live));
+    broker_start(&live);
+    broker_t mute;
+    memset(&mute, 0, sizeof(mute));
+    mute.close_after = 1;
+    broker_start(&mute);
+
+    paumiot_client_config_t live_config;
+    paumiot_client_config_t mute_config;
+    paumiot_client_t *a = connect_client(&live_config, &live, 4);
+    paumiot_client_t *b = connect_client(&mute_config, &mute, 4);
+    mute_config.auto_reconnect = true;
+    mute_config.reconnect_delay_ms = 10;
+    mute_config.connect_timeout_ms = 500;
+    mute_config.max_reconnect_attempts = 2;
+
+    paumiot_event_loop_t *loop = paumiot_event_loop_create();
+    assert(loop != NULL);
+    assert(paumiot_event_loop_add(loop, a) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_event_loop_add(loop, b) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_event_loop_start(loop) == PAUMIOT_CLIENT_SUCCESS);
+
+    /* The broker drops b, then only its listen backlog answers: the TCP
+     * connect succeeds and the CONNACK never comes */
+    assert(paumiot_client_publish_async(b, "a/b", (const uint8_t *)"v", 1, PAUMIOT_QOS_0,
+                                        false, NULL, NULL) == PAUMIOT_CLIENT_SUCCESS);
+    pthread_join(mute.thread, NULL);
+
+    /* a keeps its round trips short while b's first attempt times out and
+     * the second one hangs */
+    uint64_t slowest = 0;
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    for (;;) {
+        assert(client_now_ns() < deadline);
+        uint64_t start = client_now_ns();
+        assert(paumiot_client_publish(a, "sensors/6", (const uint8_t *)"v", 1, PAUMIOT_QOS_1,
+                                      false) == PAUMIOT_CLIENT_SUCCESS);
+        uint64_t took = client_now_ns() - start;
+        slowest = took > slowest ? took : slowest;
+
+        pthread_mutex_lock(&b->lock);
+        bool handshaking = b->handshake_fd >= 0;
+        uint32_t made = b->reconnect_attempts;
+        pthread_mutex_unlock(&b->lock);
+        if (handshaking && made == 2) {
+            break;
+        }
+    }
+    assert(slowest < 250ull * 1000000ull);
+    assert(paumiot_client_get_state(b) == PAUMIOT_STATE_CONNECTING);
+
+    /* Disconnecting gives up the attempt in progress */
+    assert(paumiot_client_disconnect(b) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_get_state(b) == PAUMIOT_STATE_DISCONNECTED);
+    assert(paumiot_client_next_timeout(b) == -1);
+    assert(paumiot_client_disconnect(b) == PAUMIOT_CLIENT_ERROR_NOT_CONNECTED);
+
+    assert(paumiot_event_loop_stop(loop) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_disconnect(a) == PAUMIOT_CLIENT_SUCCESS);
+    paumiot_client_destroy(a);
+    paumiot_client_destroy(b);
+    paumiot_event_loop_destroy(loop);
+    broker_stop(&live);
+    close(mute.listen_fd);
+
+    printf("  ✓ Non-blocking reconnect test passed\n");
+}
+
+/* ========================================
+ * Offline Spool Tests
+ * ======================================== */
+
+static void spool_append(client_spool_t *spool, const char *topic, size_t payload_len, bool fits) {
+    static const uint8_t payload[1024];
+    client_spool_record_t record = { PAUMIOT_QOS_1, false, topic, strlen(topic), payload,
+                                     payload_len };
+    assert(client_spool_append(spool, &record) == fits);
+}
+
+static void test_client_spool_file(void) {
+    printf("Testing spool persistence and recovery...\n");
+
+    char dir[] = "/tmp/paumiot_spool_XXXXXX";
+    assert(mkdtemp(dir) != NULL);
+    char path[64];
+    snprintf(path, sizeof(path), "%s/spool", dir);
+
+    client_spool_t spool;
+    assert(client_spool_open(&spool, path, 8192) == PAUMIOT_CLIENT_SUCCESS);
+    char topic[16];
+    for (int i = 0; i < 10; i++) {
+        snprintf(topic, sizeof(topic), "t/%d", i);
+        spool_append(&spool, topic, 7, true);
+    }
+
+    /* Send three; acknowledging the first and third moves head past the first only */
+    client_spool_record_t record;
+    uint64_t tickets[3];
+    for (int i = 0; i < 3; i++) {
+        assert(client_spool_peek(&spool, &record));
+        assert(client_spool_next_ticket(&spool) != 0);
+        tickets[i] = client_spool_take(&spool);
+        assert(tickets[i] != 0);
+    }
+    client_spool_ack(&spool, tickets[0]);
+    client_spool_ack(&spool, tickets[2]);
+    assert(spool.records == 9);
+    client_spool_close(&spool);
+
+    /* Reopening resends from the unacknowledged second record */
+    assert(client_spool_open(&spool, path, 8192) == PAUMIOT_CLIENT_SUCCESS);
+    assert(spool.records == 9);
+    assert(client_spool_peek(&spool, &record));
+    assert(record.topic_len == 3 && memcmp(record.topic, "t/1", 3) == 0);
+    assert(record.qos == PAUMIOT_QOS_1 && !record.retain && record.payload_len == 7);
+
+    /* A torn append (corrupt body) is dropped on recovery; 4096 is the header page */
+    uint64_t tail = spool.tail;
+    spool_append(&spool, "t/torn", 7, true);
+    spool.map[4096 + tail % spool.capacity + 20] ^= 0xFF;
+    client_spool_close(&spool);
+    assert(client_spool_open(&spool, path, 8192) == PAUMIOT_CLIENT_SUCCESS);
+    assert(spool.records == 9 && spool.tail == tail);
+
+    /* Fill, drain, and fill again across the end of the ring */
+    size_t appended = 0;
+    while (spool.tail - spool.head + 1024 < spool.capacity) {
+        spool_append(&spool, "t/full", 1000, true);
+        appended++;
+    }
+    spool_append(&spool, "t/full", 1000, false);
+    assert(appended > 0);
+    while (client_spool_peek(&spool, &record)) {
+        client_spool_ack(&spool, client_spool_take(&spool));
+    }
+    assert(spool.records == 0);
+    for (int i = 0; i < 5; i++) {
+        spool_append(&spool, i == 0 ? "t/lap" : "t/full", 1000, true);
+    }
+    client_spool_close(&spool);
+    assert(client_spool_open(&spool, path, 8192) == PAUMIOT_CLIENT_SUCCESS);
+    assert(spool.records == 5);
+    assert(client_spool_peek(&spool, &record));
+    assert(record.topic_len == 5 && memcmp(record.topic, "t/lap", 5) == 0);
+    client_spool_close(&spool);
+
+    /* A different size starts empty */
+    assert(client_spool_open(&spool, path, 16384) == PAUMIOT_CLIENT_SUCCESS);
+    assert(spool.records == 0);
+    client_spool_close(&spool);
+
+    unlink(path);
+    rmdir(dir);
+
+    printf("  ✓ Spool file test passed\n");
+}
+
+static void test_client_spool_reconnect(void) {
+    printf("Testing offline spooling and draining after reconnect...\n");
+
+    char dir[] = "/tmp/paumiot_spool_XXXXXX";
+    assert(mkdtemp(dir) != NULL);
+    char path[64];
+    snprintf(path, sizeof(path), "%s/spool", dir);
+
+    broker_t broker;
+    memset(&broker, 0, sizeof(broker));
+    broker.accepts = 2;
+    broker.close_after = 5;
+    broker_start(&broker);
+
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    config.host = "127.0.0.1";
+    config.port = broker.port;
+    config.client_id = "test-client";
+    config.max_inflight_messages = 8;
+    config.auto_reconnect = true;
+    config.reconnect_delay_ms = 50;
+    config.spool_path = path;
+    config.spool_drain_ratio = 0;
+    assert(paumiot_client_create(&config) == NULL);
+    config.spool_drain_ratio = CLIENT_DEFAULT_SPOOL_DRAIN_RATIO;
+
+    paumiot_client_t *client = paumiot_client_create(&config);
+    assert(client != NULL);
+    assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_SUCCESS);
+
+    /* The broker drops the connection after five publishes */
+    publish_counter_t counter = { 0, 0, pthread_self() };
+    for (int i = 0; i < 5; i++) {
+        assert(paumiot_client_publish_async(client, "x/first", (const uint8_t *)"v", 1,
+                                            PAUMIOT_QOS_1, false, NULL,
+                                            NULL) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    while (paumiot_client_is_connected(client)) {
+        assert(client_now_ns() < deadline);
+        paumiot_client_loop(client, 10);
+    }
+
+    /* Publishes while disconnected are stored and reported done */
+    char topic[32];
+    for (int i = 0; i < 200; i++) {
+        snprintf(topic, sizeof(topic), "s/%d", i);
+        assert(paumiot_client_publish_async(client, topic, (const uint8_t *)"v", 1,
+                                            PAUMIOT_QOS_1, false, count_publish,
+                                            &counter) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    assert(paumiot_client_spooled(client) == 200);
+    assert(paumiot_client_next_timeout(client) >= 0);
+    loop_until(client, &counter.done, 200);
+    assert(counter.succeeded == 200);
+
+    /* Reconnect, then publish live messages while the spool drains */
+    while (!paumiot_client_is_connected(client)) {
+        assert(client_now_ns() < deadline);
+        paumiot_client_loop(client, 10);
+    }
+    size_t live = 0;
+    while (live < 100 || paumiot_client_spooled(client) > 0 || counter.done < 300) {
+        assert(client_now_ns() < deadline);
+        if (live < 100) {
+            snprintf(topic, sizeof(topic), "l/%zu", live);
+            paumiot_client_result_t result = paumiot_client_publish_async(
+                client, topic, (const uint8_t *)"v", 1, PAUMIOT_QOS_1, false, count_publish,
+                &counter);
+            assert(result == PAUMIOT_CLIENT_SUCCESS || result == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK);
+            live += result == PAUMIOT_CLIENT_SUCCESS ? 1 : 0;
+        }
+        paumiot_client_loop(client, live < 100 ? 0 : 10);
+    }
+    assert(counter.succeeded == 300);
+
+    assert(paumiot_client_disconnect(client) == PAUMIOT_CLIENT_SUCCESS);
+    paumiot_client_destroy(client);
+    broker_stop(&broker);
+
+    /* Every message arrived once, spooled and live ones interleaved */
+    assert(broker.publishes == 5 + 200 + 100);
+    assert(broker.topic_switches > 10);
+
+    unlink(path);
+    rmdir(dir);
+
+    printf("  ✓ Spool reconnect test passed\n");
+}
+
+/* ========================================
+ * CoAP Tests
+ * ======================================== */
+
+static void test_client_coap_codec(void) {
+    printf("Testing CoAP message encoding...\n");
+
+    const uint8_t token[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    const uint8_t expected[] = { 0x48, 0x01, 0x12, 0x34, 1, 2, 3, 4, 5, 6, 7, 8,
+                                 0xB7, 's', 'e', 'n', 's', 'o', 'r', 's',
+                                 0x01, 'a', 0x04, 't', 'e', 'm', 'p' };
+    uint8_t buf[400];
+    size_t len = client_coap_encode(buf, sizeof(buf), CLIENT_COAP_CON, PAUMIOT_COAP_GET, 0x1234,
+                                    token, 8, "/sensors/a//temp", NULL, 0);
+    assert(len == sizeof(expected) && memcmp(buf, expected, len) == 0);
+    assert(client_coap_encoded_size("/sensors/a//temp", 8, 0) == len);
+    assert(client_coap_encode(buf, len - 1, CLIENT_COAP_CON, PAUMIOT_COAP_GET, 0x1234, token, 8,
+                              "sensors/a/temp", NULL, 0) == 0);
+
+    client_coap_message_t msg;
+    assert(client_coap_parse(buf, len, &msg));
+    assert(msg.type == CLIENT_COAP_CON && msg.code == PAUMIOT_COAP_GET && msg.mid == 0x1234);
+    assert(msg.token_len == 8 && memcmp(msg.token, token, 8) == 0 && msg.payload == NULL);
+
+    /* Extended option length and a payload */
+    char segment[21];
+    memset(segment, 'x', 20);
+    segment[20] = '\0';
+    len = client_coap_encode(buf, sizeof(buf), CLIENT_COAP_NON, PAUMIOT_COAP_POST, 7, token, 2,
+                             segment, (const uint8_t *)"21.5", 4);
+    assert(len == 4 + 2 + 2 + 20 + 1 + 4);
+    assert(buf[0] == 0x52 && buf[6] == 0xBD && buf[7] == 20 - 13 && buf[28] == 0xFF);
+    assert(client_coap_parse(buf, len, &msg));
+    assert(msg.type == CLIENT_COAP_NON && msg.payload_len == 4 &&
+           memcmp(msg.payload, "21.5", 4) == 0);
+
+    /* Uri-Path segments are at most 255 bytes */
+    char too_long[300];
+    memset(too_long, 'y', sizeof(too_long) - 1);
+    too_long[sizeof(too_long) - 1] = '\0';
+    assert(client_coap_encoded_size(too_long, 8, 0) == 0);
+
+    /* Empty messages and malformed ones */
+    assert(client_coap_encode_empty(buf, CLIENT_COAP_ACK, 0x1234) == 4);
+    assert(buf[0] == 0x60 && buf[1] == 0 && buf[2] == 0x12 && buf[3] == 0x34);
+    assert(client_coap_parse(buf, 4, &msg) && msg.code == 0 && msg.type == CLIENT_COAP_ACK);
+    const uint8_t empty_with_token[] = { 0x61, 0x00, 0x00, 0x01, 0xAA };
+    const uint8_t short_token[] = { 0x48, 0x45, 0x00, 0x01, 1, 2 };
+    const uint8_t bare_marker[] = { 0x40, 0x45, 0x00, 0x01, 0xFF };
+    const uint8_t bad_version[] = { 0x80, 0x45, 0x00, 0x01 };
+    const uint8_t option_overrun[] = { 0x40, 0x45, 0x00, 0x01, 0xB5, 'a' };
+    assert(!client_coap_parse(empty_with_token, sizeof(empty_with_token), &msg));
+    assert(!client_coap_parse(short_token, sizeof(short_token), &msg));
+    assert(!client_coap_parse(bare_marker, sizeof(bare_marker), &msg));
+    assert(!client_coap_parse(bad_version, sizeof(bad_version), &msg));
+    assert(!client_coap_parse(option_overrun, sizeof(option_overrun), &msg));
+
+    printf("  ✓ CoAP codec test passed\n");
+}
+
+typedef struct {
+    size_t done;
+    size_t succeeded;
+} coap_log_t;
+
+typedef struct {
+    coap_log_t *log;
+    char payload[16];
+    paumiot_client_result_t result;
+    bool answered;
+} coap_call_t;
+
+static void log_response(paumiot_client_t *client, paumiot_client_result_t result,
+                         const paumiot_coap_response_t *response, void *user_data) {
+    (void)client;
+    coap_call_t *call = (coap_call_t *)user_data;
+    assert(!call->answered);
+    call->answered = true;
+    call->result = result;
+    assert((response != NULL) == (result == PAUMIOT_CLIENT_SUCCESS));
+    if (response) {
+        /* Tokens matched the response to this request */
+        assert(response->code == COAP_CONTENT);
+        assert(response->payload_len == strlen(call->payload) &&
+               memcmp(response->payload, call->payload, response->payload_len) == 0);
+        call->log->succeeded++;
+    }
+    call->log->done++;
+}
+
+static void test_client_coap_requests(void) {
+    printf("Testing concurrent CoAP requests under NSTART...\n");
+
+    enum { REQUESTS = 300 };
+    coap_server_t server;
+    memset(&server, 0, sizeof(server));
+    server.hold = 8;                    /* Answers only a full NSTART, newest first */
+    coap_server_start(&server);
+
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    config.host = "127.0.0.1";
+    config.port = server.port;
+    config.protocol = PAUMIOT_PROTOCOL_COAP;
+    config.max_inflight_messages = 64;
+    config.coap_nstart = 8;
+    paumiot_client_t *client = paumiot_client_create(&config);
+    assert(client != NULL);
+    assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_publish_async(client, "t", NULL, 0, PAUMIOT_QOS_0, false, NULL,
+                                        NULL) == PAUMIOT_CLIENT_ERROR_PROTOCOL);
+    assert(paumiot_client_subscribe(client, "t", PAUMIOT_QOS_0, log_message, NULL) ==
+           PAUMIOT_CLIENT_ERROR_PROTOCOL);
+
+    coap_log_t log = { 0, 0 };
+    coap_call_t *calls = (coap_call_t *)calloc(REQUESTS, sizeof(coap_call_t));
+    assert(calls != NULL);
+    size_t submitted = 0;
+    size_t blocked = 0;
+    uint64_t deadline = client_now_ns() + TEST_DEADLINE_NS;
+    while (log.done < REQUESTS) {
+        assert(client_now_ns() < deadline);
+        while (submitted < REQUESTS) {
+            coap_call_t *call = &calls[submitted];
+            call->log = &log;
+            snprintf(call->payload, sizeof(call->payload), "r%zu", submitted);
+            paumiot_client_result_t result = paumiot_client_request(
+                client, PAUMIOT_COAP_POST, "sensors/1/cmd", (const uint8_t *)call->payload,
+                strlen(call->payload), true, log_response, call);
+            if (result == PAUMIOT_CLIENT_ERROR_WOULD_BLOCK) {
+                blocked++;
+                break;
+            }
+            assert(result == PAUMIOT_CLIENT_SUCCESS);
+            submitted++;
+        }
+        paumiot_client_loop(client, 10);
+    }
+    assert(log.succeeded == REQUESTS);
+    assert(blocked > 0);                /* The exchange table holds 64 */
+    assert(paumiot_client_next_timeout(client) == -1);
+
+    paumiot_client_disconnect(client);
+    paumiot_client_destroy(client);
+    coap_server_stop(&server);
+    assert(server.requests == REQUESTS);
+    assert(server.max_outstanding == 8);
+    free(calls);
+
+    /* Settings CoAP cannot work without */
+    paumiot_client_config_init(&config);
+    config.protocol = PAUMIOT_PROTOCOL_COAP;
+    config.coap_nstart = 0;
+    assert(paumiot_client_create(&config) == NULL);
+
+    printf("  ✓ Concurrent CoAP request test passed\n");
+}
+
+static void test_client_coap_message_ids(void) {
+    printf("Testing CoAP message ID reuse...\n");
+
+    /* One at a time, so every request takes the same slot */
+    enum { REQUESTS = 2500 };
+    coap_server_t server;
+    memset(&server, 0, sizeof(server));
+    coap_server_start(&server);
+
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    config.host = "127.0.0.1";
+    config.port = server.port;
+    config.protocol = PAUMIOT_PROTOCOL_COAP;
+    paumiot_client_t *client = paumiot_client_create(&config);
+    assert(client != NULL);
+    assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_SUCCESS);
+
+    coap_log_t log = { 0, 0 };
+    coap_call_t call;
+    for (size_t i = 0; i < REQUESTS; i++) {
+        memset(&call, 0, sizeof(call));
+        call.log = &log;
+        snprintf(call.payload, sizeof(call.payload), "m%zu", i);
+        assert(paumiot_client_request(client, PAUMIOT_COAP_POST, "sensors/1/cmd",
+                                      (const uint8_t *)call.payload, strlen(call.payload), true,
+                                      log_response, &call) == PAUMIOT_CLIENT_SUCCESS);
+        loop_until(client, &log.done, i + 1);
+    }
+    assert(log.succeeded == REQUESTS);
+
+    paumiot_client_disconnect(client);
+    paumiot_client_destroy(client);
+    coap_server_stop(&server);
+
+    /* The server counts distinct message IDs: none was reused */
+    assert(server.requests == REQUESTS);
+
+    printf("  ✓ CoAP message ID test passed\n");
+}
+
+static void test_client_coap_retransmit(void) {
+    printf("Testing CoAP retransmission, separate responses and timeouts...\n");
+
+    coap_server_t server;
+    memset(&server, 0, sizeof(server));
+    server.drop_first = true;
+    coap_server_start(&server);
+
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    config.host = "127.0.0.1";
+    config.port = server.port;
+    config.protocol = PAUMIOT_PROTOCOL_COAP;
+    config.max_inflight_messages = 8;
+    config.coap_nstart = 8;
+    config.coap_ack_timeout_ms = 20;
+    paumiot_client_t *client = paumiot_client_create(&config);
+    assert(client != NULL);
+    assert(paumiot_client_request(client, PAUMIOT_COAP_GET, "x", NULL, 0, true, NULL, NULL) ==
+           PAUMIOT_CLIENT_ERROR_NOT_CONNECTED);
+    assert(paumiot_client_connect(client) == PAUMIOT_CLIENT_SUCCESS);
+
+    /* The server drops the first copy of every CON request */
+    static const char *const payloads[] = { "lost", "separate", "reset", "silent", "non" };
+    enum { CALLS = 5 };
+    coap_log_t log = { 0, 0 };
+    coap_call_t calls[CALLS];
+    memset(calls, 0, sizeof(calls));
+    for (size_t i = 0; i < CALLS; i++) {
+        calls[i].log = &log;
+        snprintf(calls[i].payload, sizeof(calls[i].payload), "%s", payloads[i]);
+        assert(paumiot_client_request(client, PAUMIOT_COAP_PUT, "a/b",
+                                      (const uint8_t *)calls[i].payload,
+                                      strlen(calls[i].payload), i < CALLS - 1, log_response,
+                                      &calls[i]) == PAUMIOT_CLIENT_SUCCESS);
+    }
+    int timeout = paumiot_client_next_timeout(client);
+    assert(timeout >= 0 && timeout <= 40);
+
+    uint64_t start = client_now_ns();
+    loop_until(client, &log.done, CALLS);
+    uint64_t elapsed_ms = (client_now_ns() - start) / 1000000;
+
+    assert(calls[0].result == PAUMIOT_CLIENT_SUCCESS);      /* Retransmitted */
+    assert(calls[1].result == PAUMIOT_CLIENT_SUCCESS);      /* Separate response */
+    assert(calls[2].result == PAUMIOT_CLIENT_ERROR_PROTOCOL);
+    assert(calls[3].result == PAUMIOT_CLIENT_ERROR_TIMEOUT);
+    assert(calls[4].result == PAUMIOT_CLIENT_SUCCESS);      /* NON */
+    assert(elapsed_ms >= 600);          /* 31 initial timeouts of at least 20 ms */
+
+    /* Disconnecting fails what is still outstanding */
+    coap_call_t pending;
+    memset(&pending, 0, sizeof(pending));
+    pending.log = &log;
+    snprintf(pending.payload, sizeof(pending.payload), "silent");
+    assert(paumiot_client_request(client, PAUMIOT_COAP_GET, "a", (const uint8_t *)"silent", 6,
+                                  true, log_response, &pending) == PAUMIOT_CLIENT_SUCCESS);
+    assert(paumiot_client_disconnect(client) == PAUMIOT_CLIENT_SUCCESS);
+    assert(pending.answered && pending.result == PAUMIOT_CLIENT_ERROR_NOT_CONNECTED);
+
+    paumiot_client_destroy(client);
+    coap_server_stop(&server);
+    assert(server.silent_copies >= 1 + 4);     /* Sent, then retransmitted 4 times */
+    assert(server.acks == 1);           /* For the confirmable separate response */
+
+    printf("  ✓ CoAP retransmission test passed\n");
+}
+
+/* ========================================
+ * Main Test Runner
+ * ======================================== */
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running paumiot_client.h tests...\n");
+    printf("========================================\n\n");
+
+    /* Basic functionality tests */
+    test_client_config_defaults();
+    test_client_topic_matching();
+    test_client_connect_refused();
+
+    /* Inflight window tests */
+    test_client_inflight_window();
+    test_client_publish_batch();
+    test_client_qos2();
+    test_client_subscribe();
+    test_client_zero_copy();
+
+    /* Threading and failure tests */
+    test_client_loop_thread();
+    test_client_embedded_fd();
+    test_client_shared_event_loop();
+    test_client_connection_loss();
+    test_client_reconnect_backoff();
+    test_client_reconnect_nonblocking();
+
+    /* Offline spool tests */
+    test_client_spool_file();
+    test_client_spool_reconnect();
+
+    /* CoAP tests */
+    test_client_coap_codec();
+    test_client_coap_requests();
+    test_client_coap_message_ids();
+    test_client_coap_retransmit();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
@@ -0,0 +1,401 @@
+/**
+ * @file test_client_cpp.cpp
+ * @brief Unit tests for the C++ client wrapper against an in-process echo broker
+ */
+
+#include "paumiot_client.hpp"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define TEST_DEADLINE std::chrono::seconds(5)
+#define PIPELINED 32
+
+/* ========================================
+ * Fake Broker
+ * ======================================== */
+
+/* Serves one connection; publishes on echo/... come back as QoS 0 once
+ * something is subscribed */
+struct broker_t {
+    int listen_fd = -1;
+    uint16_t port = 0;
+    std::thread thread;
+
+    /* Behaviour */
+    size_t hold_acks = 0;       /* Withhold PUBACKs until this many are pending */
+
+    /* Observations (read after broker_stop) */
+    size_t publishes = 0;
+    size_t max_pending = 0;
+};
+
+static void broker_send(int fd, const std::vector<uint8_t> &packet) {
+    assert(send(fd, packet.data(), packet.size(), MSG_NOSIGNAL) == (ssize_t)packet.size());
+}
+
+static std::vector<uint8_t> packet(uint8_t header, const std::vector<uint8_t> &body) {
+    std::vector<uint8_t> out{ header };
+    size_t len = body.size();
+    do {
+        uint8_t byte = len % 128;
+        len /= 128;
+        out.push_back(len > 0 ? (uint8_t)(byte | 0x80) : byte);
+    } while (len > 0);
+    out.insert(out.end(), body.begin(), body.end());
+    return out;
+}
+
+static void broker_serve(broker_t *broker, int fd) {
+    std::vector<uint8_t> buf;
+    std::vector<uint16_t> pending;
+    size_t subscriptions = 0;
+    uint8_t chunk[4096];
+
+    for (;;) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return;
+        }
+        buf.insert(buf.end(), chunk, chunk + n);
+
+        for (;;) {
+            /* Fixed header and remaining length */
+            size_t len = 0;
+            size_t pos = 1;
+            int shift = 0;
+            bool complete = false;
+            while (pos < buf.size() && pos < 5) {
+                len |= (size_t)(buf[pos] & 0x7F) << shift;
+                shift += 7;
+                if (!(buf[pos++] & 0x80)) {
+                    complete = true;
+                    break;
+                }
+            }
+            if (!complete || buf.size() < pos + len) {
+                break;
+            }
+            uint8_t type = buf[0] >> 4;
+            uint8_t flags = buf[0] & 0x0F;
+            std::vector<uint8_t> body(buf.begin() + pos, buf.begin() + pos + len);
+            buf.erase(buf.begin(), buf.begin() + pos + len);
+
+            if (type == 1) {                    /* CONNECT */
+                broker_send(fd, packet(0x20, { 0x00, 0x00 }));
+            } else if (type == 8) {             /* SUBSCRIBE */
+                broker_send(fd, packet(0x90, { body[0], body[1], body.back() }));
+                subscriptions++;
+            } else if (type == 10) {            /* UNSUBSCRIBE */
+                broker_send(fd, packet(0xB0, { body[0], body[1] }));
+                subscriptions--;
+            } else if (type == 3) {             /* PUBLISH */
+                int qos = (flags >> 1) & 0x03;
+                size_t topic_len = (size_t)((body[0] << 8) | body[1]);
+                size_t payload_at = 2 + topic_len + (qos > 0 ? 2 : 0);
+                broker->publishes++;
+                if (qos > 0) {
+                    pending.push_back((uint16_t)((body[2 + topic_len] << 8) | body[3 + topic_len]));
+                    if (pending.size() > broker->max_pending) {
+                        broker->max_pending = pending.size();
+                    }
+                    if (pending.size() >= broker->hold_acks) {
+                        for (uint16_t id : pending) {
+                            broker_send(fd, packet(0x40, { (uint8_t)(id >> 8), (uint8_t)id }));
+                        }
+                        pending.clear();
+                    }
+                }
+                if (subscriptions > 0 && topic_len >= 5 && memcmp(&body[2], "echo/", 5) == 0) {
+                    std::vector<uint8_t> echo(body.begin(), body.begin() + 2 + topic_len);
+                    echo.insert(echo.end(), body.begin() + payload_at, body.end());
+                    broker_send(fd, packet(0x30, echo));
+                }
+            } else if (type == 12) {            /* PINGREQ */
+                broker_send(fd, packet(0xD0, {}));
+            } else if (type == 14) {            /* DISCONNECT */
+                return;
+            }
+        }
+    }
+}
+
+static void broker_start(broker_t *broker) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    broker->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(broker->listen_fd >= 0);
+    assert(bind(broker->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(listen(broker->listen_fd, 4) == 0);
+
+    socklen_t addr_len = sizeof(addr);
+    assert(getsockname(broker->listen_fd, (struct sockaddr *)&addr, &addr_len) == 0);
+    broker->port = ntohs(addr.sin_port);
+    broker->thread = std::thread([broker] {
+        int fd = accept(broker->listen_fd, nullptr, nullptr);
+        assert(fd >= 0);
+        broker_serve(broker, fd);
+        close(fd);
+    });
+}
+
+static void broker_stop(broker_t *broker) {
+    broker->thread.join();
+    close(broker->listen_fd);
+}
+
+/* ========================================
+ * Helpers
+ * ======================================== */
+
+/* Fire-and-forget coroutine; the tests keep their state alive until it ends */
+struct detached {
+    struct promise_type {
+        detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+static paumiot_client_config_t broker_config(const broker_t &broker, const char *host) {
+    paumiot_client_config_t config;
+    paumiot_client_config_init(&config);
+    config.host = host;
+    config.port = broker.port;
+    config.max_inflight_messages = 64;
+    return config;
+}
+
+/* Queued, or already done without error */
+static bool accepted(const paumiot::publish_operation &op) {
+    return !op.ready() || op.get() == PAUMIOT_CLIENT_SUCCESS;
+}
+
+static void loop_until(paumiot::client &client, const bool &done) {
+    auto deadline = std::chrono::steady_clock::now() + TEST_DEADLINE;
+    while (!done) {
+        assert(std::chrono::steady_clock::now() < deadline);
+        assert(client.loop(10) == PAUMIOT_CLIENT_SUCCESS);
+    }
+}
+
+/* ========================================
+ * Message Tests
+ * ======================================== */
+
+static void test_message_ownership() {
+    printf("Testing lent and retained messages...\n");
+
+    uint8_t payload[] = { '2', '1', '.', '5' };
+    char topic[] = "sensors/a/temp";
+    paumiot_message_t raw = { topic, payload, sizeof(payload), PAUMIOT_QOS_1, true, nullptr };
+
+    paumiot::message lent = paumiot::message::lend(&raw);
+    assert(lent && lent.lent() && lent.get() == &raw);
+    assert(lent.topic() == "sensors/a/temp" && lent.payload() == "21.5");
+    assert(lent.bytes().data() == payload && lent.bytes().size() == 4);
+    assert(lent.qos() == PAUMIOT_QOS_1 && lent.retain_flag());
+
+    /* Moving keeps the view; retaining detaches it from the buffer */
+    paumiot::message kept = std::move(lent);
+    assert(!lent && kept.lent());
+    kept.retain();
+    assert(!kept.lent() && kept.get() != &raw && kept.payload().data() != (const char *)payload);
+    memset(payload, 0, sizeof(payload));
+    assert(kept.topic() == "sensors/a/temp" && kept.payload() == "21.5");
+    kept.retain();
+    paumiot::message empty;
+    empty.retain();
+    assert(!empty);
+    empty = std::move(kept);
+    assert(empty && !kept);
+
+    printf("  ✓ Message ownership test passed\n");
+}
+
+/* ========================================
+ * Client Tests
+ * ======================================== */
+
+static void test_client_pipelined_publish() {
+    printf("Testing pipelined co_await publish...\n");
+
+    broker_t broker;
+    broker.hold_acks = PIPELINED;       /* Acks come only once all are in flight */
+    broker_start(&broker);
+
+    /* The client copies the strings it is configured with */
+    std::string host = "127.0.0.1";
+    paumiot::client client(broker_config(broker, host.c_str()));
+    host.assign("not a usable host name");
+    assert(client.connect() == PAUMIOT_CLIENT_SUCCESS);
+
+    bool done = false;
+    size_t acknowledged = 0;
+    auto publisher = [&]() -> detached {
+        std::vector<paumiot::publish_operation> ops;
+        std::vector<uint8_t> reading = { 0x01, 0x02, 0x03 };
+        for (int i = 0; i < PIPELINED; i++) {
+            ops.push_back(i % 2 ? client.publish("sensors/1/raw", reading, PAUMIOT_QOS_1)
+                                : client.publish("sensors/1/temp", "21.5", PAUMIOT_QOS_1));
+        }
+        for (auto &op : ops) {
+            if (co_await op == PAUMIOT_CLIENT_SUCCESS) {
+                acknowledged++;
+            }
+        }
+        done = true;
+    };
+    publisher();
+    loop_until(client, done);
+    assert(acknowledged == PIPELINED);
+
+    /* Awaited inline, and after the outcome is known */
+    done = false;
+    paumiot::result inline_result = PAUMIOT_CLIENT_ERROR_PROTOCOL;
+    auto single = [&]() -> detached {
+        inline_result = co_await client.publish("sensors/1/temp", "22.0", PAUMIOT_QOS_0);
+        done = true;
+    };
+    single();
+    loop_until(client, done);
+    assert(inline_result == PAUMIOT_CLIENT_SUCCESS);
+
+    client.disconnect();
+    auto failed = client.publish("sensors/1/temp", "x");
+    assert(failed.ready() && failed.get() == PAUMIOT_CLIENT_ERROR_NOT_CONNECTED);
+    broker_stop(&broker);
+    assert(broker.publishes == PIPELINED + 1);
+    assert(broker.max_pending == PIPELINED);
+
+    printf("  ✓ Pipelined publish test passed\n");
+}
+
+static void test_client_receive() {
+    printf("Testing co_await receive and queued messages...\n");
+
+    broker_t broker;
+    broker_start(&broker);
+
+    paumiot_client_config_t config = broker_config(broker, "127.0.0.1");
+    config.zero_copy_receive = true;
+    std::optional<paumiot::client> client(std::in_place, config);
+    assert(client->connect() == PAUMIOT_CLIENT_SUCCESS);
+    paumiot::subscription sub = client->subscribe("echo/#", PAUMIOT_QOS_1);
+    assert(sub.filter() == "echo/#");
+
+    /* Subscriptions end with their handle */
+    bool threw = false;
+    try {
+        client->subscribe("echo/#");
+    } catch (const paumiot::client_error &e) {
+        threw = e.code() == PAUMIOT_CLIENT_ERROR_ALREADY_SUBSCRIBED;
+    }
+    assert(threw);
+    {
+        paumiot::subscription scoped = client->subscribe("alerts/#");
+    }
+    paumiot::subscription again = client->subscribe("alerts/#");
+
+    /* Messages arriving while the coroutine waits are lent to it */
+    bool done = false;
+    size_t lent = 0;
+    std::vector<std::string> seen;
+    paumiot::message kept;
+    auto receiver = [&]() -> detached {
+        for (int i = 0; i < 3; i++) {
+            paumiot::message msg = co_await sub.next();
+            assert(msg && msg.topic() == "echo/readings");
+            lent += msg.lent();
+            seen.emplace_back(msg.payload());
+            if (i == 0) {
+                msg.retain();
+                kept = std::move(msg);
+            }
+        }
+        done = true;
+    };
+    receiver();
+    for (const char *payload : { "a", "bb", "ccc" }) {
+        assert(accepted(client->publish("echo/readings", payload)));
+    }
+    loop_until(*client, done);
+    assert(lent == 3);
+    assert((seen == std::vector<std::string>{ "a", "bb", "ccc" }));
+    assert(kept && !kept.lent() && kept.payload() == "a");
+
+    /* Without a waiter they are retained and queued */
+    assert(accepted(client->publish("echo/readings", "dd")));
+    assert(accepted(client->publish("echo/readings", "eee")));
+    auto deadline = std::chrono::steady_clock::now() + TEST_DEADLINE;
+    while (sub.queued() < 2) {
+        assert(std::chrono::steady_clock::now() < deadline);
+        client->loop(10);
+    }
+    std::optional<paumiot::message> queued = sub.try_receive();
+    assert(queued && !queued->lent() && queued->payload() == "dd");
+
+    /* A waiter is woken with an empty message when the client goes away */
+    done = false;
+    bool woke_empty = false;
+    auto last = [&]() -> detached {
+        paumiot::message msg = co_await sub.next();
+        assert(msg && msg.payload() == "eee");
+        msg = co_await sub.next();
+        woke_empty = !msg;
+        done = true;
+    };
+    last();
+    assert(!done);
+    client.reset();
+    assert(done && woke_empty);
+    assert(!sub.try_receive());
+    broker_stop(&broker);
+
+    /* Rejected configurations and subscriptions */
+    paumiot_client_config_t bad;
+    paumiot_client_config_init(&bad);
+    bad.host = nullptr;
+    threw = false;
+    try {
+        paumiot::client rejected(bad);
+    } catch (const paumiot::client_error &e) {
+        threw = e.code() == PAUMIOT_CLIENT_ERROR_INVALID_PARAM;
+    }
+    assert(threw);
+
+    printf("  ✓ Receive test passed\n");
+}
+
+/* ========================================
+ * Main Test Runner
+ * ======================================== */
+
+int main() {
+    printf("\n========================================\n");
+    printf("Running paumiot_client.hpp tests...\n");
+    printf("========================================\n\n");
+
+    test_message_ownership();
+    test_client_pipelined_publish();
+    test_client_receive();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
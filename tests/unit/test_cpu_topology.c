@@ -0,0 +1,165 @@
+/**
+ * @file test_cpu_topology.c
+ * @brief Unit tests for CPU/NUMA discovery and thread pinning
+ * @details Discovery is exercised against fake sysfs trees under build/.
+ */
+
+#include "cpu_topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/stat.h>
+
+#define SYSFS_ROOT "build/test_cpu_topology_sysfs"
+
+static void make_dirs(const char *path) {
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(buf, 0755);
+            *p = '/';
+        }
+    }
+    mkdir(buf, 0755);
+}
+
+static void write_sysfs(const char *relative, const char *content) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", SYSFS_ROOT, relative);
+
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", path);
+    *strrchr(dir, '/') = '\0';
+    make_dirs(dir);
+
+    FILE *file = fopen(path, "w");
+    assert(file);
+    fputs(content, file);
+    fclose(file);
+}
+
+static void reset_sysfs(void) {
+    assert(system("rm -rf " SYSFS_ROOT) == 0);
+}
+
+static void test_two_socket_topology(void) {
+    printf("Testing two-socket topology...\n");
+
+    reset_sysfs();
+    write_sysfs("devices/system/cpu/online", "0-7\n");
+    write_sysfs("devices/system/node/node1/cpulist", "4-7\n");
+    write_sysfs("devices/system/node/node0/cpulist", "0-3\n");
+    write_sysfs("devices/system/node/node2/cpulist", "\n");     /* Memory only */
+    write_sysfs("devices/system/node/online", "0-2\n");          /* Not a node */
+
+    cpu_topology_t topology;
+    assert(cpu_topology_discover(&topology, SYSFS_ROOT));
+    assert(topology.num_cpus == 8);
+    assert(topology.num_nodes == 2);
+    assert(topology.node_ids[0] == 0 && topology.node_ids[1] == 1);
+    for (int cpu = 0; cpu < 8; cpu++) {
+        assert(topology.cpus[cpu] == cpu);
+        assert(cpu_topology_node(&topology, cpu) == cpu / 4);
+    }
+    assert(cpu_topology_node(&topology, 8) == -1);
+    assert(cpu_topology_node(&topology, -1) == -1);
+    assert(cpu_topology_node(&topology, CPU_TOPOLOGY_MAX_CPUS) == -1);
+    assert(cpu_topology_node(NULL, 0) == -1);
+
+    printf("  ✓ Two-socket topology test passed\n");
+}
+
+static void test_sparse_topology(void) {
+    printf("Testing sparse and offline CPUs...\n");
+
+    reset_sysfs();
+    write_sysfs("devices/system/cpu/online", "0-2,5,8-9\n");
+    write_sysfs("devices/system/node/node0/cpulist", "0-1,8-9\n");
+    write_sysfs("devices/system/node/node3/cpulist", "2-7\n");
+
+    cpu_topology_t topology;
+    assert(cpu_topology_discover(&topology, SYSFS_ROOT));
+    assert(topology.num_cpus == 6);
+    static const uint16_t expected[] = { 0, 1, 2, 5, 8, 9 };
+    assert(memcmp(topology.cpus, expected, sizeof(expected)) == 0);
+    assert(topology.num_nodes == 2);
+    assert(topology.node_ids[0] == 0 && topology.node_ids[1] == 3);
+    assert(cpu_topology_node(&topology, 9) == 0);
+    assert(cpu_topology_node(&topology, 5) == 1);
+    assert(cpu_topology_node(&topology, 4) == -1);             /* Offline */
+
+    /* Nodes whose CPUs are all offline are left out */
+    write_sysfs("devices/system/cpu/online", "0-1\n");
+    assert(cpu_topology_discover(&topology, SYSFS_ROOT));
+    assert(topology.num_nodes == 1 && topology.num_cpus == 2);
+
+    printf("  ✓ Sparse topology test passed\n");
+}
+
+static void test_no_numa_information(void) {
+    printf("Testing topology without NUMA nodes...\n");
+
+    reset_sysfs();
+    write_sysfs("devices/system/cpu/online", "0-3\n");
+
+    cpu_topology_t topology;
+    assert(cpu_topology_discover(&topology, SYSFS_ROOT));
+    assert(topology.num_cpus == 4 && topology.num_nodes == 1);
+    assert(cpu_topology_node(&topology, 3) == 0);
+
+    /* CPUs a node list misses join the first node */
+    write_sysfs("devices/system/node/node1/cpulist", "2-3\n");
+    assert(cpu_topology_discover(&topology, SYSFS_ROOT));
+    assert(topology.num_nodes == 1 && topology.node_ids[0] == 1);
+    assert(cpu_topology_node(&topology, 0) == 0);
+
+    /* No CPUs at all */
+    reset_sysfs();
+    assert(!cpu_topology_discover(&topology, SYSFS_ROOT));
+    assert(!cpu_topology_discover(NULL, NULL));
+    reset_sysfs();
+
+    printf("  ✓ No NUMA information test passed\n");
+}
+
+static void test_host_topology_and_pinning(void) {
+    printf("Testing host topology and pinning...\n");
+
+    cpu_topology_t topology;
+    assert(cpu_topology_discover(&topology, NULL));
+    assert(topology.num_cpus > 0 && topology.num_nodes > 0);
+
+    int cpu = cpu_current();
+    assert(cpu >= 0);
+    assert(cpu_topology_node(&topology, cpu) >= 0);
+
+    int target = topology.cpus[topology.num_cpus - 1];
+    assert(cpu_pin_current_thread(target));
+    assert(cpu_current() == target);
+
+    assert(!cpu_pin_current_thread(-1));
+    assert(!cpu_pin_current_thread(1 << 20));
+
+    printf("  ✓ Host topology (%u CPUs, %u nodes) and pinning test passed\n",
+           topology.num_cpus, topology.num_nodes);
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running cpu_topology.h tests...\n");
+    printf("========================================\n\n");
+
+    test_two_socket_topology();
+    test_sparse_topology();
+    test_no_numa_information();
+    test_host_topology_and_pinning();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file test_metrics.c
+ * @brief Unit tests for the metrics registry
+ */
+
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define TEST_THREADS 4
+#define TEST_INCREMENTS 100000
+
+static void test_counter_basics(void) {
+    printf("Testing counter basics...\n");
+
+    metrics_registry_t *registry = metrics_registry_create();
+    assert(registry);
+
+    metrics_counter_t *counter = metrics_counter_register(registry, "test_events_total",
+                                                          "Events seen");
+    assert(counter);
+    assert(metrics_counter_total(counter) == 0);
+
+    metrics_counter_inc(counter);
+    metrics_counter_add(counter, 41);
+    assert(metrics_counter_total(counter) == 42);
+    assert(metrics_counter_value(counter) == 42);
+
+    /* Reset restarts the value but not the exposed total */
+    metrics_counter_reset(counter);
+    assert(metrics_counter_value(counter) == 0);
+    metrics_counter_add(counter, 3);
+    assert(metrics_counter_value(counter) == 3);
+    assert(metrics_counter_total(counter) == 45);
+
+    /* Names must be unique and valid */
+    assert(!metrics_counter_register(registry, "test_events_total", "Again"));
+    assert(!metrics_counter_register(registry, "9lives", "Bad name"));
+    assert(!metrics_counter_register(registry, "bad-name", "Bad name"));
+    assert(!metrics_counter_register(registry, "", "Empty"));
+    assert(!metrics_counter_register(NULL, "test_other_total", "No registry"));
+    assert(metrics_counter_register(registry, "ns:test_other_total", NULL));
+
+    metrics_registry_destroy(registry);
+    metrics_registry_destroy(NULL);
+
+    printf("  ✓ Counter basics test passed\n");
+}
+
+typedef struct {
+    metrics_counter_t *counter;
+    metrics_histogram_t *histogram;
+} worker_args_t;
+
+static void *increment_worker(void *arg) {
+    worker_args_t *args = arg;
+    for (int i = 0; i < TEST_INCREMENTS; i++) {
+        metrics_counter_inc(args->counter);
+        metrics_histogram_observe(args->histogram, (uint64_t)(i % 200));
+    }
+    return NULL;
+}
+
+static void test_concurrent_updates(void) {
+    printf("Testing concurrent updates from %d threads...\n", TEST_THREADS);
+
+    static const uint64_t bounds[] = { 50, 100 };
+    metrics_registry_t *registry = metrics_registry_create();
+    worker_args_t args = {
+        metrics_counter_register(registry, "test_concurrent_total", "Concurrent increments"),
+        metrics_histogram_register(registry, "test_concurrent_values", "Concurrent values",
+                                   bounds, 2, 1.0),
+    };
+    assert(args.counter && args.histogram);
+
+    pthread_t threads[TEST_THREADS];
+    for (int t = 0; t < TEST_THREADS; t++) {
+        assert(pthread_create(&threads[t], NULL, increment_worker, &args) == 0);
+    }
+
+    /* Scrapes run alongside the writers */
+    for (int i = 0; i < 50; i++) {
+        char *text = metrics_render(registry, NULL);
+        assert(text);
+        free(text);
+    }
+
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    assert(metrics_counter_total(args.counter) == (uint64_t)TEST_THREADS * TEST_INCREMENTS);
+    assert(metrics_histogram_count(args.histogram) == (uint64_t)TEST_THREADS * TEST_INCREMENTS);
+
+    /* Threads landed in different slots */
+    assert(args.counter->cells[metrics_thread_slot()].value == 0);
+
+    metrics_registry_destroy(registry);
+
+    printf("  ✓ Concurrent update test passed\n");
+}
+
+static void collect(metrics_writer_t *writer, void *user_data) {
+    metrics_write(writer, METRICS_GAUGE, "test_temperature_celsius", "Temperature",
+                  *(double *)user_data);
+    metrics_write(writer, METRICS_COUNTER, "test_restarts_total", "Restarts", 2);
+    metrics_write(writer, METRICS_GAUGE, "bad name", "Skipped", 1);
+}
+
+static void test_render_format(void) {
+    printf("Testing Prometheus text format...\n");
+
+    metrics_registry_t *registry = metrics_registry_create();
+    metrics_counter_t *counter = metrics_counter_register(registry, "test_requests_total",
+                                                          "Requests\\handled\nso far");
+    static const uint64_t bounds[] = { 100, 1000, 10000 };
+    metrics_histogram_t *histogram = metrics_histogram_register(
+        registry, "test_latency_seconds", "Latency", bounds, 3, 1e-6);
+    assert(counter && histogram);
+
+    metrics_counter_add(counter, 7);
+    metrics_histogram_observe(histogram, 50);
+    metrics_histogram_observe(histogram, 100);      /* Bounds are inclusive */
+    metrics_histogram_observe(histogram, 500);
+    metrics_histogram_observe(histogram, 20000);
+
+    double temperature = 21.5;
+    assert(metrics_collector_register(registry, collect, &temperature));
+
+    size_t length;
+    char *text = metrics_render(registry, &length);
+    assert(text && length == strlen(text));
+
+    assert(strstr(text, "# HELP test_requests_total Requests\\\\handled\\nso far\n"
+                        "# TYPE test_requests_total counter\n"
+                        "test_requests_total 7\n"));
+    assert(strstr(text, "# TYPE test_latency_seconds histogram\n"
+                        "test_latency_seconds_bucket{le=\"0.0001\"} 2\n"
+                        "test_latency_seconds_bucket{le=\"0.001\"} 3\n"
+                        "test_latency_seconds_bucket{le=\"0.01\"} 3\n"
+                        "test_latency_seconds_bucket{le=\"+Inf\"} 4\n"
+                        "test_latency_seconds_sum 0.02065\n"
+                        "test_latency_seconds_count 4\n"));
+    assert(strstr(text, "# TYPE test_temperature_celsius gauge\ntest_temperature_celsius 21.5\n"));
+    assert(strstr(text, "test_restarts_total 2\n"));
+    assert(!strstr(text, "bad name"));
+
+    /* Registration order is kept */
+    assert(strstr(text, "test_requests_total") < strstr(text, "test_latency_seconds"));
+    free(text);
+
+    /* Removed metrics and collectors disappear from the output */
+    metrics_unregister(registry, "test_requests_total");
+    metrics_collector_unregister(registry, collect, &temperature);
+    text = metrics_render(registry, NULL);
+    assert(!strstr(text, "test_requests_total"));
+    assert(!strstr(text, "test_temperature_celsius"));
+    assert(strstr(text, "test_latency_seconds_count 4\n"));
+    free(text);
+
+    /* The name is free again */
+    counter = metrics_counter_register(registry, "test_requests_total", "Requests");
+    assert(counter && metrics_counter_total(counter) == 0);
+    text = metrics_render(registry, NULL);
+    assert(strstr(text, "test_latency_seconds") < strstr(text, "test_requests_total"));
+    free(text);
+
+    metrics_registry_destroy(registry);
+
+    printf("  ✓ Render format test passed\n");
+}
+
+static void test_histogram_validation(void) {
+    printf("Testing histogram validation...\n");
+
+    metrics_registry_t *registry = metrics_registry_create();
+    static const uint64_t unsorted[] = { 10, 5 };
+    static const uint64_t sorted[] = { 5, 10 };
+    uint64_t many[METRICS_MAX_BUCKETS + 1];
+    for (int i = 0; i <= METRICS_MAX_BUCKETS; i++) {
+        many[i] = (uint64_t)i + 1;
+    }
+
+    assert(!metrics_histogram_register(registry, "h1", "", unsorted, 2, 1.0));
+    assert(!metrics_histogram_register(registry, "h1", "", sorted, 0, 1.0));
+    assert(!metrics_histogram_register(registry, "h1", "", sorted, 2, 0.0));
+    assert(!metrics_histogram_register(registry, "h1", "", NULL, 2, 1.0));
+    assert(!metrics_histogram_register(registry, "h1", "", many, METRICS_MAX_BUCKETS + 1, 1.0));
+    assert(metrics_histogram_register(registry, "h1", "", many, METRICS_MAX_BUCKETS, 1.0));
+    assert(!metrics_histogram_register(registry, "h1", "", sorted, 2, 1.0));
+
+    metrics_registry_destroy(registry);
+
+    printf("  ✓ Histogram validation test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running metrics.h tests...\n");
+    printf("========================================\n\n");
+
+    test_counter_basics();
+    test_concurrent_updates();
+    test_render_format();
+    test_histogram_validation();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
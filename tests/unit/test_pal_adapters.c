@@ -235,6 +235,79 @@ void test_pal_packet_processing(void) {
     TEST_CASE_END();
 }
 
+void test_pal_statistics(void) {
+    TEST_CASE("PAL Per-Adapter Statistics");
+    
+    pal_config_t config = {0};
+    pal_context_t *ctx = pal_init(&config);
+    ASSERT_NOT_NULL(ctx);
+    ASSERT_SUCCESS(pal_register_adapter(ctx, &mqtt_adapter));
+    ASSERT_SUCCESS(pal_register_adapter(ctx, &coap_adapter));
+    
+    /* Two good packets, one truncated, one of an unsupported type */
+    static const uint8_t truncated[] = { 0x30, 0x19, 0x00 };
+    static const uint8_t subscribe[] = { 0x82, 0x00 };
+    message_t *message = NULL;
+    for (int i = 0; i < 2; i++) {
+        ASSERT_SUCCESS(pal_decode_packet(ctx, PROTOCOL_TYPE_MQTT, test_mqtt_publish,
+                                         sizeof(test_mqtt_publish), &message));
+        message_free(message);
+    }
+    ASSERT_EQ(PAUMIOT_ERROR_PACKET_MALFORMED,
+              pal_decode_packet(ctx, PROTOCOL_TYPE_MQTT, truncated, sizeof(truncated), &message));
+    ASSERT_EQ(PAUMIOT_ERROR_PROTOCOL_UNSUPPORTED,
+              pal_decode_packet(ctx, PROTOCOL_TYPE_MQTT, subscribe, sizeof(subscribe), &message));
+    
+    /* One encode that fits and one that does not */
+    ASSERT_SUCCESS(pal_decode_packet(ctx, PROTOCOL_TYPE_MQTT, test_mqtt_publish,
+                                     sizeof(test_mqtt_publish), &message));
+    uint8_t buffer[256];
+    size_t bytes_written = 0;
+    ASSERT_SUCCESS(pal_encode_message(ctx, message, buffer, sizeof(buffer), &bytes_written));
+    ASSERT_EQ(PAUMIOT_ERROR_BUFFER_OVERFLOW,
+              pal_encode_message(ctx, message, buffer, 8, &bytes_written));
+    message_free(message);
+    
+    pal_adapter_stats_t stats;
+    ASSERT_SUCCESS(pal_get_adapter_stats(ctx, PROTOCOL_TYPE_MQTT, &stats));
+    ASSERT_EQ(3, stats.packets_decoded);
+    ASSERT_EQ(3 * sizeof(test_mqtt_publish), stats.bytes_decoded);
+    ASSERT_EQ(2, stats.decode_errors);
+    ASSERT_EQ(1, stats.packets_encoded);
+    ASSERT_EQ(1, stats.encode_errors);
+    ASSERT_EQ(3, stats.num_error_codes);
+    ASSERT_EQ(PAUMIOT_ERROR_PACKET_MALFORMED, stats.errors[0].code);
+    ASSERT_EQ(PAUMIOT_ERROR_PROTOCOL_UNSUPPORTED, stats.errors[1].code);
+    ASSERT_EQ(PAUMIOT_ERROR_BUFFER_OVERFLOW, stats.errors[2].code);
+    ASSERT_EQ(1, stats.errors[2].count);
+    
+    /* Every decode lands in exactly one latency bucket */
+    uint64_t timed = 0;
+    for (size_t b = 0; b < PAL_STATS_LATENCY_BUCKETS; b++) {
+        timed += stats.decode_latency[b];
+    }
+    ASSERT_EQ(5, timed);
+    
+    ASSERT_SUCCESS(pal_get_adapter_stats(ctx, PROTOCOL_TYPE_COAP, &stats));
+    ASSERT_EQ(0, stats.packets_decoded);
+    ASSERT_EQ(PAUMIOT_ERROR_PROTOCOL_UNKNOWN,
+              pal_get_adapter_stats(ctx, PROTOCOL_TYPE_CUSTOM, &stats));
+    
+    /* Totals survive unregistering the adapter */
+    system_stats_t totals;
+    ASSERT_SUCCESS(pal_unregister_adapter(ctx, PROTOCOL_TYPE_MQTT));
+    ASSERT_NULL(mqtt_adapter.stats);
+    ASSERT_SUCCESS(pal_get_stats(ctx, &totals));
+    ASSERT_EQ(3, totals.messages_received);
+    ASSERT_EQ(1, totals.messages_sent);
+    ASSERT_EQ(bytes_written, totals.bytes_sent);
+    ASSERT_EQ(3, totals.errors);
+    
+    pal_cleanup(ctx);
+    
+    TEST_CASE_END();
+}
+
 void test_adapter_capabilities(void) {
     TEST_CASE("Adapter Capabilities");
     
@@ -257,8 +330,6 @@ void test_invalid_inputs(void) {
     TEST_CASE("Invalid Input Handling");
     
     message_t *message = NULL;
-    uint8_t buffer[256];
-    size_t bytes_written = 0;
     
     /* Test NULL adapter */
     paumiot_result_t result = mqtt_adapter.decode(NULL,
@@ -304,6 +375,7 @@ int main(void) {
     test_mqtt_adapter_decode();
     test_mqtt_adapter_encode();
     test_pal_packet_processing();
+    test_pal_statistics();
     test_adapter_capabilities();
     test_invalid_inputs();
     
@@ -0,0 +1,292 @@
+/**
+ * @file test_paumiot_admission.c
+ * @brief Unit tests for CONNECT admission control
+ */
+
+#include "paumiot_admission.h"
+#include "paumiot_config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define MS 1000000ull
+#define SEC 1000000000ull
+
+static void make_config(initiator_config_t *config, uint32_t rate, uint32_t burst,
+                        uint32_t queue) {
+    initiator_config_init(config);
+    config->connect_rate_limit = rate;
+    config->connect_burst = burst;
+    config->admission_queue_size = queue;
+    config->connection_timeout_ms = 5000;
+}
+
+/* Connection handles are just tags */
+static void *conn(uintptr_t id) {
+    return (void *)id;
+}
+
+static void test_unlimited(void) {
+    printf("Testing unlimited admission...\n");
+
+    initiator_config_t config;
+    make_config(&config, 0, 1, 4);
+    paumiot_admission_t *admission = paumiot_admission_create(&config, NULL);
+    assert(admission != NULL);
+
+    for (uintptr_t i = 1; i <= 1000; i++) {
+        assert(paumiot_admission_request(admission, conn(i), false, SEC) == PAUMIOT_ADMIT_NOW);
+    }
+    assert(paumiot_admission_next_ms(admission, SEC) == -1);
+
+    paumiot_admission_stats_t stats;
+    paumiot_admission_get_stats(admission, SEC, &stats);
+    assert(stats.admitted == 1000 && stats.queued == 0 && stats.queue_depth == 0);
+
+    paumiot_admission_destroy(admission);
+    paumiot_admission_destroy(NULL);
+
+    printf("  ✓ Unlimited admission test passed\n");
+}
+
+static void test_rate_and_burst(void) {
+    printf("Testing handshake rate and burst...\n");
+
+    /* 100/s: one every 10 ms, 5 at once after a lull */
+    initiator_config_t config;
+    make_config(&config, 100, 5, 1000);
+    paumiot_admission_t *admission = paumiot_admission_create(&config, NULL);
+    assert(admission != NULL);
+
+    uint64_t now = 10 * SEC;
+    for (uintptr_t i = 1; i <= 5; i++) {
+        assert(paumiot_admission_request(admission, conn(i), false, now) == PAUMIOT_ADMIT_NOW);
+    }
+    for (uintptr_t i = 6; i <= 105; i++) {
+        assert(paumiot_admission_request(admission, conn(i), false, now) ==
+               PAUMIOT_ADMIT_QUEUED);
+    }
+    assert(paumiot_admission_next_ms(admission, now) == 10);
+
+    /* Nothing before the next credit, then one per 10 ms in arrival order */
+    paumiot_admission_entry_t entries[200];
+    assert(paumiot_admission_poll(admission, now + 5 * MS, entries, 200) == 0);
+    assert(paumiot_admission_poll(admission, now + 10 * MS, entries, 200) == 1);
+    assert(entries[0].connection == conn(6) && !entries[0].expired);
+
+    /* Over one second the queue drains at the configured rate */
+    size_t admitted = 1;
+    uintptr_t expected = 7;
+    for (uint64_t t = now + 11 * MS; t <= now + SEC; t += MS) {
+        size_t n = paumiot_admission_poll(admission, t, entries, 200);
+        for (size_t i = 0; i < n; i++) {
+            assert(entries[i].connection == conn(expected++));
+        }
+        admitted += n;
+    }
+    assert(admitted == 100);
+
+    paumiot_admission_stats_t stats;
+    paumiot_admission_get_stats(admission, now + SEC, &stats);
+    assert(stats.admitted == 105 && stats.queued == 100 && stats.queue_depth == 0);
+    assert(stats.admit_rate > 90.0 && stats.admit_rate < 110.0);
+
+    /* A quiet second restores the burst, not more */
+    uint64_t later = now + 3 * SEC;
+    for (uintptr_t i = 1; i <= 5; i++) {
+        assert(paumiot_admission_request(admission, conn(i), false, later) == PAUMIOT_ADMIT_NOW);
+    }
+    assert(paumiot_admission_request(admission, conn(6), false, later) == PAUMIOT_ADMIT_QUEUED);
+
+    paumiot_admission_destroy(admission);
+
+    printf("  ✓ Rate and burst test passed\n");
+}
+
+static void test_established_first(void) {
+    printf("Testing priority of established sessions...\n");
+
+    initiator_config_t config;
+    make_config(&config, 10, 1, 100);
+    paumiot_admission_t *admission = paumiot_admission_create(&config, NULL);
+    assert(admission != NULL);
+
+    uint64_t now = SEC;
+    assert(paumiot_admission_request(admission, conn(1), false, now) == PAUMIOT_ADMIT_NOW);
+    for (uintptr_t i = 2; i <= 4; i++) {
+        assert(paumiot_admission_request(admission, conn(i), false, now) ==
+               PAUMIOT_ADMIT_QUEUED);
+    }
+    assert(paumiot_admission_request(admission, conn(100), true, now + MS) ==
+           PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(101), true, now + MS) ==
+           PAUMIOT_ADMIT_QUEUED);
+
+    /* Established sessions jump the queue of new ones */
+    static const uintptr_t order[] = { 100, 101, 2, 3, 4 };
+    paumiot_admission_entry_t entry;
+    uint64_t t = now;
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        t += 100 * MS;
+        assert(paumiot_admission_poll(admission, t, &entry, 1) == 1);
+        assert(entry.connection == conn(order[i]) && !entry.expired);
+    }
+
+    /* A waiting established session holds back new ones with credit to spare */
+    t += 10 * SEC;
+    assert(paumiot_admission_request(admission, conn(5), false, t) == PAUMIOT_ADMIT_NOW);
+    assert(paumiot_admission_request(admission, conn(102), true, t) == PAUMIOT_ADMIT_QUEUED);
+    t += 100 * MS;
+    assert(paumiot_admission_request(admission, conn(6), false, t) == PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_poll(admission, t, &entry, 1) == 1);
+    assert(entry.connection == conn(102));
+
+    paumiot_admission_destroy(admission);
+
+    printf("  ✓ Established-first test passed\n");
+}
+
+static void test_queue_limits(void) {
+    printf("Testing queue overflow, expiry and cancel...\n");
+
+    initiator_config_t config;
+    make_config(&config, 1, 1, 3);
+    paumiot_admission_t *admission = paumiot_admission_create(&config, NULL);
+    assert(admission != NULL);
+
+    uint64_t now = SEC;
+    assert(paumiot_admission_request(admission, conn(1), false, now) == PAUMIOT_ADMIT_NOW);
+    assert(paumiot_admission_request(admission, conn(2), false, now) == PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(3), true, now) == PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(4), false, now) == PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(5), true, now) == PAUMIOT_ADMIT_REJECTED);
+
+    /* The client of 4 hung up */
+    assert(paumiot_admission_cancel(admission, conn(4)));
+    assert(!paumiot_admission_cancel(admission, conn(4)));
+
+    /* Credit goes to the established session; after connection_timeout_ms
+     * the new one comes back expired, without credit */
+    assert(paumiot_admission_next_ms(admission, now) == 1000);
+    paumiot_admission_entry_t entries[4];
+    assert(paumiot_admission_poll(admission, now + 4 * SEC, entries, 4) == 1);
+    assert(entries[0].connection == conn(3) && !entries[0].expired);
+    assert(paumiot_admission_poll(admission, now + 5 * SEC, entries, 4) == 1);
+    assert(entries[0].connection == conn(2) && entries[0].expired);
+    assert(paumiot_admission_next_ms(admission, now + 5 * SEC) == -1);
+
+    paumiot_admission_stats_t stats;
+    paumiot_admission_get_stats(admission, now + 5 * SEC, &stats);
+    assert(stats.rejected == 1 && stats.expired == 1 && stats.admitted == 2);
+
+    /* Reloading lifts the limit */
+    config.connect_rate_limit = 0;
+    paumiot_admission_configure(admission, &config);
+    assert(paumiot_admission_request(admission, conn(6), false, now + 5 * SEC) ==
+           PAUMIOT_ADMIT_NOW);
+
+    paumiot_admission_destroy(admission);
+
+    printf("  ✓ Queue limits test passed\n");
+}
+
+static void test_queue_resize(void) {
+    printf("Testing queue resize on reload...\n");
+
+    initiator_config_t config;
+    make_config(&config, 1, 1, 2);
+    paumiot_admission_t *admission = paumiot_admission_create(&config, NULL);
+    assert(admission != NULL);
+
+    /* Fill the queue with its ring wrapped around */
+    assert(paumiot_admission_request(admission, conn(1), false, SEC) == PAUMIOT_ADMIT_NOW);
+    assert(paumiot_admission_request(admission, conn(2), false, SEC) == PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(3), false, SEC) == PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(4), false, SEC) == PAUMIOT_ADMIT_REJECTED);
+    paumiot_admission_entry_t entries[4];
+    assert(paumiot_admission_poll(admission, 2 * SEC, entries, 4) == 1);
+    assert(entries[0].connection == conn(2));
+    assert(paumiot_admission_request(admission, conn(5), false, 2 * SEC) ==
+           PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(6), false, 2 * SEC) ==
+           PAUMIOT_ADMIT_REJECTED);
+
+    /* A larger queue takes more, and those waiting keep their turn */
+    config.admission_queue_size = 4;
+    paumiot_admission_configure(admission, &config);
+    assert(paumiot_admission_request(admission, conn(7), false, 2 * SEC) ==
+           PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(8), false, 2 * SEC) ==
+           PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(9), false, 2 * SEC) ==
+           PAUMIOT_ADMIT_REJECTED);
+
+    uintptr_t order[] = {3, 5, 7, 8};
+    for (size_t i = 0; i < 4; i++) {
+        assert(paumiot_admission_poll(admission, (3 + i) * SEC, entries, 4) == 1);
+        assert(entries[0].connection == conn(order[i]) && !entries[0].expired);
+    }
+
+    /* A smaller one refuses once it holds that many */
+    config.admission_queue_size = 1;
+    paumiot_admission_configure(admission, &config);
+    assert(paumiot_admission_request(admission, conn(10), false, 6 * SEC) ==
+           PAUMIOT_ADMIT_QUEUED);
+    assert(paumiot_admission_request(admission, conn(11), false, 6 * SEC) ==
+           PAUMIOT_ADMIT_REJECTED);
+
+    paumiot_admission_destroy(admission);
+
+    printf("  ✓ Queue resize test passed\n");
+}
+
+static void test_metrics(void) {
+    printf("Testing admission metrics...\n");
+
+    metrics_registry_t *registry = metrics_registry_create();
+    assert(registry != NULL);
+
+    initiator_config_t config;
+    make_config(&config, 50, 1, 10);
+    paumiot_admission_t *admission = paumiot_admission_create(&config, registry);
+    assert(admission != NULL);
+    assert(paumiot_admission_request(admission, conn(1), false, SEC) == PAUMIOT_ADMIT_NOW);
+    assert(paumiot_admission_request(admission, conn(2), false, SEC) == PAUMIOT_ADMIT_QUEUED);
+
+    char *text = metrics_render(registry, NULL);
+    assert(text != NULL);
+    assert(strstr(text, "paumiot_initiator_connects_admitted_total 1") != NULL);
+    assert(strstr(text, "paumiot_initiator_connects_queued_total 1") != NULL);
+    assert(strstr(text, "paumiot_initiator_admission_queue_depth 1") != NULL);
+    assert(strstr(text, "paumiot_initiator_admission_rate_limit 50") != NULL);
+    assert(strstr(text, "# TYPE paumiot_initiator_admission_rate gauge") != NULL);
+    free(text);
+
+    paumiot_admission_destroy(admission);
+    text = metrics_render(registry, NULL);
+    assert(text != NULL && strstr(text, "paumiot_initiator") == NULL);
+    free(text);
+    metrics_registry_destroy(registry);
+
+    printf("  ✓ Admission metrics test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running paumiot_admission.h tests...\n");
+    printf("========================================\n\n");
+
+    test_unlimited();
+    test_rate_and_burst();
+    test_established_first();
+    test_queue_limits();
+    test_queue_resize();
+    test_metrics();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
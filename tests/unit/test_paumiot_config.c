@@ -0,0 +1,793 @@
+/**
+ * @file test_paumiot_config.c
+ * @brief Unit tests for paumiot.conf loading and validation
+ * @details Run from the repository root so config/paumiot.conf is found.
+ */
+
+#include "paumiot_config.h"
+#include "paumiot_admission.h"
+#include "sensor_manager/sensor_codec.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define SHIPPED_CONFIG "config/paumiot.conf"
+#define LIVE_CONFIG "build/test_paumiot_config_live.conf"
+#define NUM_READERS 3
+#define NUM_RELOADS 50
+
+static void write_file(const char *path, const char *text) {
+    FILE *file = fopen(path, "w");
+    assert(file);
+    fputs(text, file);
+    fclose(file);
+}
+
+/* A configuration whose hot settings all derive from `n` */
+static void write_live_config(int n, const char *extra) {
+    char text[512];
+    snprintf(text, sizeof(text),
+             "[general]\nlog_level = \"%s\"\n"
+             "[network]\nconnect_rate_limit = %d\nconnect_burst = %d\n"
+             "admission_queue_size = %d\nconnection_timeout = \"%dms\"\n"
+             "[bll]\ncache_ttl = %d\n%s",
+             n % 2 ? "WARN" : "INFO", n * 10, n * 4, n * 8, n, n, extra ? extra : "");
+    write_file(LIVE_CONFIG, text);
+}
+
+static paumiot_result_t parse(const char *text, paumiot_runtime_config_t *config,
+                              paumiot_config_error_t *error) {
+    paumiot_runtime_config_init(config);
+    return paumiot_runtime_config_parse(text, strlen(text), config, error);
+}
+
+static void test_size_parsing(void) {
+    printf("Testing size parsing...\n");
+
+    uint64_t bytes;
+    assert(paumiot_config_parse_size("65536", &bytes) && bytes == 65536);
+    assert(paumiot_config_parse_size("512MB", &bytes) && bytes == 512ull << 20);
+    assert(paumiot_config_parse_size("512 MiB", &bytes) && bytes == 512ull << 20);
+    assert(paumiot_config_parse_size("10mb", &bytes) && bytes == 10ull << 20);
+    assert(paumiot_config_parse_size("1.5K", &bytes) && bytes == 1536);
+    assert(paumiot_config_parse_size("2GiB", &bytes) && bytes == 2ull << 30);
+    assert(paumiot_config_parse_size("1TB", &bytes) && bytes == 1ull << 40);
+    assert(paumiot_config_parse_size("1_048_576", &bytes) && bytes == 1048576);
+
+    assert(!paumiot_config_parse_size("", &bytes));
+    assert(!paumiot_config_parse_size("MB", &bytes));
+    assert(!paumiot_config_parse_size("-1MB", &bytes));
+    assert(!paumiot_config_parse_size("12XB", &bytes));
+    assert(!paumiot_config_parse_size("1.1B", &bytes));          /* Not a whole byte */
+    assert(!paumiot_config_parse_size("1.", &bytes));
+    assert(!paumiot_config_parse_size("1__0", &bytes));
+    assert(!paumiot_config_parse_size("20000000TB", &bytes));    /* Overflows */
+
+    printf("  ✓ Size parsing passed\n");
+}
+
+static void test_duration_parsing(void) {
+    printf("Testing duration parsing...\n");
+
+    uint64_t us;
+    assert(paumiot_config_parse_duration("30", 1000000, &us) && us == 30000000);
+    assert(paumiot_config_parse_duration("250ms", 1000000, &us) && us == 250000);
+    assert(paumiot_config_parse_duration("1.5s", 1000, &us) && us == 1500000);
+    assert(paumiot_config_parse_duration("5m", 1, &us) && us == 300000000);
+    assert(paumiot_config_parse_duration("5min", 1, &us) && us == 300000000);
+    assert(paumiot_config_parse_duration("2h", 1, &us) && us == 7200000000ull);
+    assert(paumiot_config_parse_duration("30d", 1, &us) && us == 30ull * 86400000000ull);
+    assert(paumiot_config_parse_duration("1w", 1, &us) && us == 7ull * 86400000000ull);
+    assert(paumiot_config_parse_duration("10us", 1000, &us) && us == 10);
+
+    assert(!paumiot_config_parse_duration("30x", 1, &us));
+    assert(!paumiot_config_parse_duration("s", 1, &us));
+    assert(!paumiot_config_parse_duration("1.5us", 1, &us));
+    assert(!paumiot_config_parse_duration("30", 0, &us));
+
+    printf("  ✓ Duration parsing passed\n");
+}
+
+static void test_shipped_config(void) {
+    printf("Testing shipped paumiot.conf...\n");
+
+    paumiot_runtime_config_t *config = malloc(sizeof(*config));
+    paumiot_config_error_t error;
+    assert(config);
+
+    paumiot_runtime_config_init(config);
+    assert(paumiot_runtime_config_load(SHIPPED_CONFIG, config, &error) == PAUMIOT_SUCCESS);
+    assert(paumiot_runtime_config_validate(config, &error) == PAUMIOT_SUCCESS);
+
+    /* Hot settings */
+    assert(config->sensor_manager.enable_compression);
+    assert(config->core.worker_threads == 4 && config->core.io_threads == 2);
+    assert(config->core.memory_limit == 512u << 20);
+    assert(config->core.request_timeout_ms == 30000);
+    assert(config->core.max_queue_size == 10000);
+    assert(config->core.cpu_affinity_count == 0);
+
+    /* Strings land in the configuration's own storage */
+    assert(strcmp(config->core.log_level, "INFO") == 0);
+    assert(strcmp(config->core.host, "0.0.0.0") == 0);
+    assert(config->core.log_file >= config->core.string_storage &&
+           config->core.log_file < config->core.string_storage + PAUMIOT_CONFIG_STRING_STORAGE);
+    assert(config->core.state_persistence);
+    assert(strcmp(config->core.state_db_path, "/var/lib/paumiot/state.db") == 0);
+    assert(config->state.enable_persistence && config->state.db_path == config->core.state_db_path);
+    assert(!config->core.enable_tls);
+    assert(strcmp(config->core.cert_file, "/etc/paumiot/certs/server.crt") == 0);
+
+    /* Ports reach both the core and the initiator */
+    assert(config->core.mqtt_port == 1883 && config->initiator.mqtt_port == 1883);
+    assert(config->core.coap_port == 5683 && config->initiator.coap_port == 5683);
+
+    /* Units convert into each layer's field */
+    assert(config->engine.worker_threads == 4);
+    assert(config->engine.max_payload_size == 65536);
+    assert(config->sensor_manager.max_payload_size == 65536);
+    assert(config->engine.max_inflight_messages == 20);
+    assert(config->engine.request_timeout_ms == 30000);
+    assert(config->initiator.max_connections == 1000);
+    assert(config->initiator.connection_timeout_ms == 30000);
+    assert(config->initiator.connect_rate_limit == 1000);
+    assert(config->initiator.admission_queue_size == 10000);
+    assert(config->initiator.recv_buffer_size == 1048576);
+    assert(strcmp(config->initiator.lb_algorithm, "round_robin") == 0);
+    assert(config->sensor_manager.dispatch_threads == 4);
+    assert(config->sensor_manager.cache_size == 10000);
+    assert(config->sensor_manager.cache_ttl_ms == 300000);
+    assert(config->sensor_manager.enable_aggregation);
+    assert(config->sensor_manager.aggregation_window_ms == 60000);
+    assert(config->sensor_manager.aggregation_grace_ms == 5000);
+    assert(config->sensor_manager.health_check_interval_ms == 5000);
+    assert(config->sensor_manager.retention_days == 30);
+
+    /* The core-only loader sees the same core settings */
+    paumiot_config_t *core = malloc(sizeof(*core));
+    assert(core);
+    paumiot_config_init(core);
+    assert(paumiot_config_load(SHIPPED_CONFIG, core) == PAUMIOT_SUCCESS);
+    assert(paumiot_config_validate(core) == PAUMIOT_SUCCESS);
+    assert(core->memory_limit == config->core.memory_limit);
+    assert(core->sensor_cache_ttl_ms == 300000);
+
+    free(core);
+    free(config);
+    printf("  ✓ Shipped paumiot.conf passed\n");
+}
+
+static void test_syntax(void) {
+    printf("Testing syntax handling...\n");
+
+    paumiot_runtime_config_t *config = malloc(sizeof(*config));
+    paumiot_config_error_t error;
+    assert(config);
+
+    /* Comments, blank lines, CRLF, unknown keys and sections, escapes */
+    const char *text =
+        "# leading comment\r\n"
+        "\n"
+        "[ general ]\r\n"
+        "log_file = \"/tmp/a \\\"b\\\".log\"  # trailing\r\n"
+        "future_option = [1.5, \"x]\", true]\n"
+        "[nonexistent.section]\n"
+        "anything = whatever\n"
+        "[performance]\n"
+        "worker_threads=8\n"
+        "memory_limit = 1_073_741_824\n"
+        "[bll]\n"
+        "request_timeout = \"1500ms\"\n";
+    assert(parse(text, config, &error) == PAUMIOT_SUCCESS);
+    assert(strcmp(config->core.log_file, "/tmp/a \"b\".log") == 0);
+    assert(config->core.worker_threads == 8 && config->engine.worker_threads == 8);
+    assert(config->core.memory_limit == 1u << 30);
+    assert(config->core.request_timeout_ms == 1500);
+    /* Untouched settings keep their defaults */
+    assert(config->core.io_threads == 2 && config->core.mqtt_port == 1883);
+
+    static const struct {
+        const char *text;
+        uint32_t line;
+    } bad[] = {
+        { "[performance]\nworker_threads = many\n", 2 },
+        { "[performance]\nworker_threads = -1\n", 2 },
+        { "[performance]\nworker_threads = 4294967296\n", 2 },
+        { "[bll]\ncache_enabled = yes\n", 2 },
+        { "[performance]\nmemory_limit = \"lots\"\n", 2 },
+        { "\n\n[pdl.mqtt]\nport = 70000\n", 4 },
+        { "[general]\nlog_level = INFO\n", 2 },
+        { "[general]\nlog_file = \"unterminated\n", 2 },
+        { "[general]\nlog_file = \"bad \\q escape\"\n", 2 },
+        { "[general\n", 1 },
+        { "[]\n", 1 },
+        { "[general] extra\n", 1 },
+        { "[general]\nlog_level\n", 2 },
+        { "[general]\nlog_level =\n", 2 },
+        { "[general]\nlog_level = \"INFO\" \"DEBUG\"\n", 2 },
+        { "[general]\n= 1\n", 2 },
+        { "[bll]\nrequest_timeout = \"1.5ms\"\n", 2 },       /* Not whole milliseconds */
+        { "[bll]\nrequest_timeout = [30]\n", 2 },
+        { "[dal.database]\nretention_policy = \"12h\"\n", 2 },  /* Not whole days */
+        { "[performance]\ncpu_affinity = 3\n", 2 },
+        { "[performance]\ncpu_affinity = [0, 1\n", 2 },
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        memset(&error, 0, sizeof(error));
+        assert(parse(bad[i].text, config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+        assert(error.line == bad[i].line);
+        assert(error.message[0] != '\0');
+    }
+
+    /* A key name is reported */
+    parse("[performance]\nio_threads = x\n", config, &error);
+    assert(strstr(error.message, "io_threads") != NULL);
+
+    free(config);
+    printf("  ✓ Syntax handling passed\n");
+}
+
+static void test_cpu_affinity(void) {
+    printf("Testing cpu_affinity lists...\n");
+
+    paumiot_runtime_config_t *config = malloc(sizeof(*config));
+    paumiot_config_error_t error;
+    assert(config);
+
+    assert(parse("[performance]\ncpu_affinity = [0, 2, \"4-7\", \"9\",]\n", config, &error) ==
+           PAUMIOT_SUCCESS);
+    static const uint16_t expected[] = { 0, 2, 4, 5, 6, 7, 9 };
+    assert(config->core.cpu_affinity_count == 7);
+    assert(memcmp(config->core.cpu_affinity, expected, sizeof(expected)) == 0);
+
+    assert(parse("[performance]\ncpu_affinity = []\n", config, &error) == PAUMIOT_SUCCESS);
+    assert(config->core.cpu_affinity_count == 0);
+
+    /* Duplicates, reversed and oversized ranges, out-of-range ids */
+    assert(parse("[performance]\ncpu_affinity = [1, \"0-3\"]\n", config, &error) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(strstr(error.message, "twice") != NULL);
+    assert(parse("[performance]\ncpu_affinity = [\"7-4\"]\n", config, &error) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(parse("[performance]\ncpu_affinity = [\"0-64\"]\n", config, &error) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(parse("[performance]\ncpu_affinity = [1024]\n", config, &error) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(parse("[performance]\ncpu_affinity = [1 2]\n", config, &error) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+
+    free(config);
+    printf("  ✓ cpu_affinity lists passed\n");
+}
+
+static void test_cpu_placement(void) {
+    printf("Testing dispatch worker placement...\n");
+
+    paumiot_runtime_config_t *config = malloc(sizeof(*config));
+    paumiot_config_error_t error;
+    assert(config);
+
+    /* Two nodes of four CPUs */
+    cpu_topology_t topology;
+    memset(&topology, 0, sizeof(topology));
+    for (int cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+        topology.cpu_node[cpu] = CPU_TOPOLOGY_NO_NODE;
+    }
+    for (uint16_t cpu = 0; cpu < 8; cpu++) {
+        topology.cpus[topology.num_cpus++] = cpu;
+        topology.cpu_node[cpu] = cpu / 4;
+    }
+    topology.node_ids[1] = 1;
+    topology.num_nodes = 2;
+
+    /* Dispatch workers take the worker CPUs, clear of the reactors */
+    assert(parse("[performance]\nio_threads = 2\nworker_threads = 4\n"
+                 "cpu_affinity = [\"0-7\"]\n", config, &error) == PAUMIOT_SUCCESS);
+    assert(paumiot_runtime_config_place(config, &topology, &error) == PAUMIOT_SUCCESS);
+    static const int16_t expected[] = { 1, 2, 5, 6 };
+    assert(config->sensor_manager.dispatch_threads == 4);
+    assert(config->sensor_manager.dispatch_cpus == config->dispatch_cpus);
+    assert(memcmp(config->dispatch_cpus, expected, sizeof(expected)) == 0);
+
+    /* No cpu_affinity, no pinning */
+    assert(parse("[performance]\nworker_threads = 4\n", config, &error) == PAUMIOT_SUCCESS);
+    assert(paumiot_runtime_config_place(config, &topology, &error) == PAUMIOT_SUCCESS);
+    assert(config->sensor_manager.dispatch_cpus == NULL);
+
+    /* A CPU the topology cannot use */
+    assert(parse("[performance]\ncpu_affinity = [9]\n", config, &error) == PAUMIOT_SUCCESS);
+    assert(paumiot_runtime_config_place(config, &topology, &error) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(strstr(error.message, "cpu_affinity") != NULL);
+    assert(config->sensor_manager.dispatch_cpus == NULL);
+    free(config);
+
+    /* Stores place every snapshot on this host */
+    cpu_topology_t host;
+    assert(cpu_topology_discover(&host, NULL));
+    char extra[64];
+    snprintf(extra, sizeof(extra), "[performance]\ncpu_affinity = [%u]\n", host.cpus[0]);
+    write_live_config(2, extra);
+    paumiot_config_store_t *store = paumiot_config_store_create(LIVE_CONFIG, &error);
+    assert(store);
+    unsigned token;
+    const paumiot_runtime_config_t *snapshot = paumiot_config_store_acquire(store, &token);
+    assert(snapshot->sensor_manager.dispatch_cpus == snapshot->dispatch_cpus);
+    for (size_t i = 0; i < snapshot->sensor_manager.dispatch_threads; i++) {
+        assert(snapshot->dispatch_cpus[i] == (int16_t)host.cpus[0]);
+    }
+    paumiot_config_store_release(store, token);
+    paumiot_config_store_destroy(store);
+    remove(LIVE_CONFIG);
+
+    printf("  ✓ Dispatch worker placement passed\n");
+}
+
+static void test_string_storage(void) {
+    printf("Testing string storage limits...\n");
+
+    paumiot_runtime_config_t *config = malloc(sizeof(*config));
+    paumiot_config_error_t error;
+    char text[8192];
+    char value[400];
+    size_t len = 0;
+    assert(config);
+
+    memset(value, 'x', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+
+    /* Each assignment takes fresh storage, so enough of them exhaust it */
+    len += (size_t)snprintf(text + len, sizeof(text) - len, "[general]\n");
+    for (int i = 0; i < 8; i++) {
+        len += (size_t)snprintf(text + len, sizeof(text) - len, "log_file = \"%s\"\n", value);
+    }
+    assert(parse(text, config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(error.line > 2);
+    assert(config->core.string_storage_used <= PAUMIOT_CONFIG_STRING_STORAGE);
+
+    /* A key shared by two layers stores its string once */
+    assert(parse("[network]\nbind_address = \"10.0.0.1\"\n", config, &error) == PAUMIOT_SUCCESS);
+    assert(config->core.host == config->initiator.bind_address);
+    assert(config->core.string_storage_used == sizeof("10.0.0.1"));
+
+    free(config);
+    printf("  ✓ String storage limits passed\n");
+}
+
+static void test_validation(void) {
+    printf("Testing validation...\n");
+
+    paumiot_runtime_config_t *config = malloc(sizeof(*config));
+    paumiot_config_error_t error;
+    assert(config);
+
+    paumiot_runtime_config_init(config);
+    assert(paumiot_runtime_config_validate(config, &error) == PAUMIOT_SUCCESS);
+    assert(paumiot_config_validate(&config->core) == PAUMIOT_SUCCESS);
+
+    static const char *invalid[] = {
+        "[pdl.coap]\nport = 1883\n",                            /* Port clash */
+        "[pdl.mqtt]\nport = 0\n",
+        "[performance]\nio_threads = 0\n",
+        "[performance]\nworker_threads = 2000\n",
+        "[performance]\nmemory_limit = \"64KB\"\n",
+        "[general]\nlog_level = \"VERBOSE\"\n",
+        "[smp]\nstate_persistence = true\n",                    /* No state_file */
+        "[security]\ntls_enabled = true\ncert_file = \"a.crt\"\n",  /* No key_file */
+        "[pal]\nmessage_queue_size = 100\n",                    /* Below watermarks */
+        "[pdl]\nmax_packet_size = \"2MB\"\n",                   /* Exceeds buffers */
+        "[pdl]\nload_balancing = \"weighted\"\n",
+        "[bll]\naggregation_enabled = true\naggregation_window = 0\n",
+        "[dal]\nbuffer_size = 0\n",
+        "[network]\nmax_connections = 0\n",
+        "[network]\nconnect_burst = 0\n",                      /* Rate limited by default */
+        "[network]\nbind_address = \"\"\n",
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        memset(&error, 0, sizeof(error));
+        assert(parse(invalid[i], config, &error) == PAUMIOT_SUCCESS);
+        assert(paumiot_runtime_config_validate(config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+        assert(error.message[0] != '\0');
+    }
+
+    /* Consistent settings across layers pass */
+    assert(parse("[smp]\nstate_persistence = true\nstate_file = \"/tmp/s.db\"\n"
+                 "[security]\ntls_enabled = true\ncert_file = \"a.crt\"\nkey_file = \"a.key\"\n"
+                 "[pal]\nmessage_queue_size = 100000\n"
+                 "[pdl]\nmax_packet_size = \"256KB\"\nbuffer_size = \"256KB\"\n",
+                 config, &error) == PAUMIOT_SUCCESS);
+    assert(paumiot_runtime_config_validate(config, &error) == PAUMIOT_SUCCESS);
+
+    assert(paumiot_config_validate(NULL) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(paumiot_runtime_config_validate(NULL, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    free(config);
+    printf("  ✓ Validation passed\n");
+}
+
+static void test_file_errors(void) {
+    printf("Testing file errors...\n");
+
+    paumiot_runtime_config_t *config = malloc(sizeof(*config));
+    paumiot_config_error_t error;
+    assert(config);
+
+    paumiot_runtime_config_init(config);
+    assert(paumiot_runtime_config_load("/nonexistent/paumiot.conf", config, &error) ==
+           PAUMIOT_ERROR_OPERATION_FAILED);
+    assert(error.line == 0 && strstr(error.message, "/nonexistent/paumiot.conf"));
+    assert(paumiot_config_load("/nonexistent/paumiot.conf", &config->core) ==
+           PAUMIOT_ERROR_OPERATION_FAILED);
+
+    /* A malformed file reports the offending line */
+    const char *path = "build/test_paumiot_config.conf";
+    FILE *file = fopen(path, "w");
+    assert(file);
+    fputs("[performance]\nworker_threads = 4\nio_threads = two\n", file);
+    fclose(file);
+    assert(paumiot_runtime_config_load(path, config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(error.line == 3);
+    assert(paumiot_config_load(path, &config->core) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    /* A well-formed file with invalid values is rejected too */
+    file = fopen(path, "w");
+    assert(file);
+    fputs("[pdl.mqtt]\nport = 5683\n[pdl.coap]\nport = 5683\n", file);
+    fclose(file);
+    paumiot_config_init(&config->core);
+    assert(paumiot_config_load(path, &config->core) == PAUMIOT_ERROR_INVALID_PARAM);
+    remove(path);
+
+    assert(paumiot_runtime_config_load(NULL, config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(paumiot_config_load(SHIPPED_CONFIG, NULL) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    free(config);
+    printf("  ✓ File errors passed\n");
+}
+
+static void test_needs_restart(void) {
+    printf("Testing restart detection...\n");
+
+    paumiot_runtime_config_t *running = malloc(sizeof(*running));
+    paumiot_runtime_config_t *updated = malloc(sizeof(*updated));
+    paumiot_config_error_t error;
+    assert(running && updated);
+
+    paumiot_runtime_config_init(running);
+    assert(paumiot_runtime_config_load(SHIPPED_CONFIG, running, &error) == PAUMIOT_SUCCESS);
+
+    /* Identical settings, with strings stored at different addresses */
+    paumiot_runtime_config_init(updated);
+    assert(paumiot_runtime_config_load(SHIPPED_CONFIG, updated, &error) == PAUMIOT_SUCCESS);
+    assert(!paumiot_runtime_config_needs_restart(running, updated, &error));
+
+    /* Hot settings change freely */
+    const char *hot = "[general]\nlog_level = \"DEBUG\"\n"
+                      "[network]\nconnect_rate_limit = 500\nconnect_burst = 5\n"
+                      "admission_queue_size = 64\nconnection_timeout = 5\n"
+                      "[bll]\ncache_ttl = \"1m\"\n[dal]\ncompression_enabled = false\n";
+    assert(paumiot_runtime_config_parse(hot, strlen(hot), updated, &error) == PAUMIOT_SUCCESS);
+    assert(!paumiot_runtime_config_needs_restart(running, updated, &error));
+
+    static const char *cold[] = {
+        "[pdl.mqtt]\nport = 1884\n",
+        "[performance]\nworker_threads = 8\n",
+        "[performance]\ncpu_affinity = [1]\n",
+        "[network]\nbind_address = \"127.0.0.1\"\n",
+        "[dal]\nbuffer_size = 5\n",
+        "[smp]\nstate_persistence = false\n",
+        /* Nothing applies these live yet */
+        "[network]\nmax_connections = 10\n",
+        "[network]\nglobal_rate_limit = 500\n",
+        "[network]\nper_client_rate_limit = 5\n",
+        "[pdl]\nmax_packet_size = \"32KB\"\n",
+        "[pdl]\nload_balancing = \"random\"\n",
+        "[pal]\nhigh_watermark = 9000\n",
+        "[pal]\nlow_watermark = 100\n",
+        "[pal.mqtt]\nmax_inflight = 5\n",
+        "[bll]\nrequest_timeout = \"5s\"\n",
+    };
+    for (size_t i = 0; i < sizeof(cold) / sizeof(cold[0]); i++) {
+        paumiot_runtime_config_init(updated);
+        assert(paumiot_runtime_config_load(SHIPPED_CONFIG, updated, &error) == PAUMIOT_SUCCESS);
+        assert(paumiot_runtime_config_parse(cold[i], strlen(cold[i]), updated, &error) ==
+               PAUMIOT_SUCCESS);
+        memset(&error, 0, sizeof(error));
+        assert(paumiot_runtime_config_needs_restart(running, updated, &error));
+        assert(strstr(error.message, "restart") != NULL);
+    }
+
+    free(running);
+    free(updated);
+    printf("  ✓ Restart detection passed\n");
+}
+
+typedef struct {
+    int calls;
+    uint32_t previous_ttl;
+    uint32_t current_ttl;
+} listener_record_t;
+
+static void record_reload(const paumiot_runtime_config_t *previous,
+                          const paumiot_runtime_config_t *current, void *user_data) {
+    listener_record_t *record = user_data;
+    record->calls++;
+    record->previous_ttl = previous->sensor_manager.cache_ttl_ms;
+    record->current_ttl = current->sensor_manager.cache_ttl_ms;
+}
+
+static void test_store_reload(void) {
+    printf("Testing configuration store reload...\n");
+
+    paumiot_config_error_t error;
+    listener_record_t record = { 0, 0, 0 };
+    log_level_t saved_level = log_get_level();
+    unsigned token;
+
+    /* Unreadable or invalid files create nothing */
+    assert(paumiot_config_store_create("/nonexistent/paumiot.conf", &error) == NULL);
+    write_file(LIVE_CONFIG, "[pdl.coap]\nport = 1883\n");
+    assert(paumiot_config_store_create(LIVE_CONFIG, &error) == NULL);
+
+    write_live_config(2, NULL);
+    paumiot_config_store_t *store = paumiot_config_store_create(LIVE_CONFIG, &error);
+    assert(store);
+    assert(paumiot_config_store_generation(store) == 1);
+    assert(log_get_level() == LOG_LEVEL_INFO);
+    assert(paumiot_config_store_add_listener(store, record_reload, &record) == PAUMIOT_SUCCESS);
+
+    const paumiot_runtime_config_t *config = paumiot_config_store_acquire(store, &token);
+    assert(config->initiator.connect_rate_limit == 20 && config->initiator.connect_burst == 8);
+    assert(config->initiator.connection_timeout_ms == 2);
+    paumiot_config_store_release(store, token);
+
+    /* Hot settings are published together */
+    write_live_config(3, NULL);
+    assert(paumiot_config_store_reload(store, &error) == PAUMIOT_SUCCESS);
+    assert(paumiot_config_store_generation(store) == 2);
+    config = paumiot_config_store_acquire(store, &token);
+    assert(config->initiator.connect_rate_limit == 30 && config->initiator.connect_burst == 12);
+    assert(config->initiator.admission_queue_size == 24);
+    assert(config->sensor_manager.cache_ttl_ms == 3000);
+    paumiot_config_store_release(store, token);
+    assert(log_get_level() == LOG_LEVEL_WARN);
+    assert(record.calls == 1 && record.previous_ttl == 2000 && record.current_ttl == 3000);
+
+    /* Settings fixed at startup, broken files and missing files keep the running config */
+    write_live_config(4, "[pdl.mqtt]\nport = 1884\n");
+    assert(paumiot_config_store_reload(store, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(strstr(error.message, "port") != NULL);
+    write_live_config(4, "[performance]\nio_threads = lots\n");
+    assert(paumiot_config_store_reload(store, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(error.line > 0);
+    write_live_config(4, "[network]\nconnect_burst = 0\n");     /* Rate limit without burst */
+    assert(paumiot_config_store_reload(store, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    remove(LIVE_CONFIG);
+    assert(paumiot_config_store_reload(store, &error) == PAUMIOT_ERROR_OPERATION_FAILED);
+
+    assert(paumiot_config_store_generation(store) == 2 && record.calls == 1);
+    config = paumiot_config_store_acquire(store, &token);
+    assert(config->initiator.connect_burst == 12 && config->initiator.mqtt_port == 1883);
+    paumiot_config_store_release(store, token);
+
+    /* Listener slots are bounded */
+    for (int i = 1; i < PAUMIOT_CONFIG_MAX_LISTENERS; i++) {
+        assert(paumiot_config_store_add_listener(store, record_reload, &record) ==
+               PAUMIOT_SUCCESS);
+    }
+    assert(paumiot_config_store_add_listener(store, record_reload, &record) ==
+           PAUMIOT_ERROR_OUT_OF_MEMORY);
+
+    paumiot_config_store_destroy(store);
+    paumiot_config_store_destroy(NULL);
+    log_set_level(saved_level);
+    printf("  ✓ Configuration store reload passed\n");
+}
+
+static void on_delivery(const char *sensor_id, const sensor_data_t *data, void *user_data) {
+    (void)sensor_id;
+    *(bool *)user_data = data->compressed;
+}
+
+static void test_reload_listeners(void) {
+    printf("Testing reload listeners...\n");
+
+    paumiot_config_error_t error;
+    log_level_t saved_level = log_get_level();
+    unsigned token;
+
+    write_live_config(2, "[dal]\ncompression_enabled = true\n");
+    paumiot_config_store_t *store = paumiot_config_store_create(LIVE_CONFIG, &error);
+    assert(store);
+
+    /* Components start from the published configuration */
+    sensor_codec_routes_t *routes = sensor_codec_routes_create();
+    sensor_codec_route_t route = { DATA_FORMAT_JSON, SENSOR_COMPRESSION_LZ4, NULL };
+    assert(routes);
+    assert(sensor_codec_routes_add_route(routes, "#", &route) == PAUMIOT_SUCCESS);
+
+    metrics_registry_t *registry = metrics_registry_create();
+    const paumiot_runtime_config_t *config = paumiot_config_store_acquire(store, &token);
+    sensor_manager_config_t sensor_config = config->sensor_manager;
+    sensor_config.routes = routes;
+    sensor_manager_t *sm = sensor_manager_init(&sensor_config);
+    paumiot_admission_t *admission = paumiot_admission_create(&config->initiator, registry);
+    paumiot_config_store_release(store, token);
+    assert(registry && sm && admission);
+
+    assert(paumiot_config_store_add_listener(store, paumiot_config_apply_sensor_manager, sm) ==
+           PAUMIOT_SUCCESS);
+    assert(paumiot_config_store_add_listener(store, paumiot_config_apply_admission,
+                                             admission) == PAUMIOT_SUCCESS);
+
+    sensor_entry_t entry = { .sensor_id = (char *)"s", .topic_pattern = (char *)"t" };
+    sensor_data_t data = {
+        .sensor_id = (char *)"s",
+        .topic = (char *)"t",
+        .payload = (uint8_t *)"{\"v\":1}",
+        .payload_len = 7,
+        .format = DATA_FORMAT_JSON,
+    };
+    bool compressed = false;
+    assert(sensor_manager_register(sm, &entry) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_subscribe_data(sm, NULL, on_delivery, &compressed) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    assert(compressed);
+
+    char *text = metrics_render(registry, NULL);
+    assert(text && strstr(text, "paumiot_initiator_admission_rate_limit 20") != NULL);
+    free(text);
+
+    /* A reload reaches both components */
+    write_live_config(3, NULL);
+    assert(paumiot_config_store_reload(store, &error) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    assert(!compressed);
+
+    text = metrics_render(registry, NULL);
+    assert(text && strstr(text, "paumiot_initiator_admission_rate_limit 30") != NULL);
+    free(text);
+
+    paumiot_config_store_destroy(store);
+    paumiot_admission_destroy(admission);
+    sensor_manager_cleanup(sm);
+    sensor_codec_routes_destroy(routes);
+    metrics_registry_destroy(registry);
+    log_set_level(saved_level);
+    remove(LIVE_CONFIG);
+    printf("  ✓ Reload listeners passed\n");
+}
+
+typedef struct {
+    paumiot_config_store_t *store;
+    atomic_bool *stop;
+    uint64_t reads;
+} reader_args_t;
+
+static void *reader_main(void *arg) {
+    reader_args_t *args = arg;
+
+    while (!atomic_load(args->stop)) {
+        unsigned token;
+        const paumiot_runtime_config_t *config = paumiot_config_store_acquire(args->store, &token);
+
+        /* Every field comes from the same file */
+        uint32_t n = config->initiator.connection_timeout_ms;
+        assert(config->initiator.connect_burst == n * 4);
+        assert(config->initiator.connect_rate_limit == n * 10);
+        assert(config->initiator.admission_queue_size == n * 8);
+        assert(config->sensor_manager.cache_ttl_ms == n * 1000);
+
+        paumiot_config_store_release(args->store, token);
+        args->reads++;
+    }
+    return NULL;
+}
+
+static void test_concurrent_reload(void) {
+    printf("Testing reload under concurrent readers...\n");
+
+    paumiot_config_error_t error;
+    log_level_t saved_level = log_get_level();
+    atomic_bool stop = false;
+    pthread_t threads[NUM_READERS];
+    reader_args_t args[NUM_READERS];
+
+    write_live_config(1, NULL);
+    paumiot_config_store_t *store = paumiot_config_store_create(LIVE_CONFIG, &error);
+    assert(store);
+
+    for (int i = 0; i < NUM_READERS; i++) {
+        args[i] = (reader_args_t){ store, &stop, 0 };
+        assert(pthread_create(&threads[i], NULL, reader_main, &args[i]) == 0);
+    }
+
+    log_set_level(LOG_LEVEL_NONE);
+    for (int i = 2; i < NUM_RELOADS + 2; i++) {
+        write_live_config(i, NULL);
+        assert(paumiot_config_store_reload(store, &error) == PAUMIOT_SUCCESS);
+    }
+
+    atomic_store(&stop, true);
+    uint64_t reads = 0;
+    for (int i = 0; i < NUM_READERS; i++) {
+        pthread_join(threads[i], NULL);
+        reads += args[i].reads;
+    }
+    assert(paumiot_config_store_generation(store) == NUM_RELOADS + 1);
+
+    paumiot_config_store_destroy(store);
+    log_set_level(saved_level);
+    remove(LIVE_CONFIG);
+    printf("  ✓ %d reloads under %llu reads passed\n", NUM_RELOADS, (unsigned long long)reads);
+}
+
+static void test_sighup_reload(void) {
+    printf("Testing SIGHUP reload...\n");
+
+    paumiot_config_error_t error;
+    log_level_t saved_level = log_get_level();
+
+    write_live_config(2, NULL);
+    paumiot_config_store_t *store = paumiot_config_store_create(LIVE_CONFIG, &error);
+    paumiot_config_store_t *other = paumiot_config_store_create(LIVE_CONFIG, &error);
+    assert(store && other);
+
+    assert(paumiot_config_store_watch_sighup(store) == PAUMIOT_SUCCESS);
+    assert(paumiot_config_store_watch_sighup(other) == PAUMIOT_ERROR_ALREADY_INITIALIZED);
+
+    write_live_config(5, NULL);
+    assert(raise(SIGHUP) == 0);
+    for (int i = 0; i < 500 && paumiot_config_store_generation(store) == 1; i++) {
+        usleep(10 * 1000);
+    }
+    assert(paumiot_config_store_generation(store) == 2);
+    assert(paumiot_config_store_generation(other) == 1);
+
+    unsigned token;
+    const paumiot_runtime_config_t *config = paumiot_config_store_acquire(store, &token);
+    assert(config->initiator.connection_timeout_ms == 5);
+    paumiot_config_store_release(store, token);
+
+    /* Destroying the watcher frees SIGHUP for another store */
+    paumiot_config_store_destroy(store);
+    assert(paumiot_config_store_watch_sighup(other) == PAUMIOT_SUCCESS);
+    paumiot_config_store_destroy(other);
+
+    log_set_level(saved_level);
+    remove(LIVE_CONFIG);
+    printf("  ✓ SIGHUP reload passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running paumiot_config.h tests...\n");
+    printf("========================================\n\n");
+
+    test_size_parsing();
+    test_duration_parsing();
+    test_shipped_config();
+    test_syntax();
+    test_cpu_affinity();
+    test_cpu_placement();
+    test_string_storage();
+    test_validation();
+    test_file_errors();
+    test_needs_restart();
+    test_store_reload();
+    test_reload_listeners();
+    test_concurrent_reload();
+    test_sighup_reload();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
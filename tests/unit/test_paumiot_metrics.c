@@ -0,0 +1,397 @@
+/**
+ * @file test_paumiot_metrics.c
+ * @brief Unit tests for the Prometheus metrics endpoint
+ */
+
+#include "paumiot_metrics.h"
+#include "paumiot_config.h"
+#include "sensor_manager/sensor_manager.h"
+#include "logging.h"
+#include "time_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/* Open a connection to the server */
+static int connect_to(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+/* Send a raw request and read the whole response */
+static char *http_request(uint16_t port, const char *request) {
+    int fd = connect_to(port);
+    assert(send(fd, request, strlen(request), 0) == (ssize_t)strlen(request));
+    shutdown(fd, SHUT_WR);
+
+    size_t capacity = 4096;
+    size_t length = 0;
+    char *response = malloc(capacity);
+    ssize_t n;
+    while ((n = recv(fd, response + length, capacity - length - 1, 0)) > 0) {
+        length += (size_t)n;
+        if (capacity - length < 1024) {
+            capacity *= 2;
+            response = realloc(response, capacity);
+        }
+    }
+    response[length] = '\0';
+    close(fd);
+    return response;
+}
+
+static void make_config(paumiot_config_t *config) {
+    paumiot_config_init(config);
+    config->host = "127.0.0.1";
+    config->metrics_enabled = true;
+    config->metrics_port = 0;
+}
+
+static void test_endpoints(void) {
+    printf("Testing metrics and health endpoints...\n");
+
+    metrics_registry_t *registry = metrics_registry_create();
+    metrics_counter_t *counter = metrics_counter_register(registry, "test_scrapes_total", "Test");
+    metrics_counter_add(counter, 5);
+    assert(metrics_counter_register(registry, "test_escaped_total", "Path C:\\x\nnext line"));
+
+    paumiot_config_t config;
+    make_config(&config);
+    paumiot_metrics_server_t *server = paumiot_metrics_server_start(&config, registry);
+    assert(server);
+    uint16_t port = paumiot_metrics_server_port(server);
+    assert(port != 0);
+
+    char *response = http_request(port, "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(strncmp(response, "HTTP/1.1 200 OK\r\n", 17) == 0);
+    assert(strstr(response, "Content-Type: text/plain; version=0.0.4"));
+    assert(strstr(response, "\r\n\r\n# HELP test_scrapes_total Test\n"));
+    assert(strstr(response, "test_scrapes_total 5\n"));
+    assert(strstr(response, "# HELP test_escaped_total Path C:\\\\x\\nnext line\n"));
+    free(response);
+
+    /* Query strings are ignored */
+    response = http_request(port, "GET /metrics?name[]=x HTTP/1.0\r\n\r\n");
+    assert(strstr(response, "test_scrapes_total 5\n"));
+    free(response);
+
+    response = http_request(port, "GET /health HTTP/1.1\r\n\r\n");
+    assert(strncmp(response, "HTTP/1.1 200 OK\r\n", 17) == 0);
+    assert(strstr(response, "\r\n\r\nOK\n"));
+    free(response);
+
+    response = http_request(port, "HEAD /metrics HTTP/1.1\r\n\r\n");
+    assert(strncmp(response, "HTTP/1.1 200 OK\r\n", 17) == 0);
+    assert(!strstr(response, "test_scrapes_total"));
+    free(response);
+
+    response = http_request(port, "GET /other HTTP/1.1\r\n\r\n");
+    assert(strncmp(response, "HTTP/1.1 404", 12) == 0);
+    free(response);
+
+    response = http_request(port, "POST /metrics HTTP/1.1\r\n\r\n");
+    assert(strncmp(response, "HTTP/1.1 405", 12) == 0);
+    free(response);
+
+    response = http_request(port, "garbage\r\n\r\n");
+    assert(strncmp(response, "HTTP/1.1 400", 12) == 0);
+    free(response);
+
+    char big[PAUMIOT_METRICS_MAX_REQUEST + 64];
+    memset(big, 'a', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    memcpy(big, "GET /", 5);
+    response = http_request(port, big);
+    assert(strncmp(response, "HTTP/1.1 431", 12) == 0);
+    free(response);
+
+    /* A client that closes without a request does not stall the server */
+    free(http_request(port, ""));
+    response = http_request(port, "GET /health HTTP/1.1\r\n\r\n");
+    assert(strstr(response, "200 OK"));
+    free(response);
+
+    paumiot_metrics_server_stop(server);
+    paumiot_metrics_server_stop(NULL);
+    metrics_registry_destroy(registry);
+
+    printf("  ✓ Endpoint test passed\n");
+}
+
+static void test_start_errors(void) {
+    printf("Testing server start errors...\n");
+
+    metrics_registry_t *registry = metrics_registry_create();
+    paumiot_config_t config;
+    make_config(&config);
+
+    assert(!paumiot_metrics_server_start(NULL, registry));
+    assert(!paumiot_metrics_server_start(&config, NULL));
+
+    config.host = "not-an-address";
+    assert(!paumiot_metrics_server_start(&config, registry));
+
+    /* Port in use */
+    make_config(&config);
+    paumiot_metrics_server_t *server = paumiot_metrics_server_start(&config, registry);
+    assert(server);
+    config.metrics_port = paumiot_metrics_server_port(server);
+    assert(!paumiot_metrics_server_start(&config, registry));
+    paumiot_metrics_server_stop(server);
+
+    metrics_registry_destroy(registry);
+
+    printf("  ✓ Start error test passed\n");
+}
+
+typedef struct {
+    uint16_t port;
+    const char *prefix;             /* Sent first */
+    useconds_t interval_us;         /* Between the bytes that follow (0 = flood) */
+    atomic_bool stop;
+} slow_client_t;
+
+/* Send a request prefix, then keep sending until the server gives up */
+static void *slow_client_main(void *arg) {
+    slow_client_t *client = arg;
+    char filler[4096];
+    memset(filler, 'x', sizeof(filler));
+
+    int fd = connect_to(client->port);
+    assert(send(fd, client->prefix, strlen(client->prefix), 0) ==
+           (ssize_t)strlen(client->prefix));
+    while (!atomic_load(&client->stop)) {
+        size_t len = client->interval_us ? 1 : sizeof(filler);
+        if (send(fd, filler, len, MSG_NOSIGNAL) < 0) {
+            break;
+        }
+        if (client->interval_us) {
+            usleep(client->interval_us);
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+static void test_slow_clients(void) {
+    printf("Testing slow clients...\n");
+
+    metrics_registry_t *registry = metrics_registry_create();
+    paumiot_config_t config;
+    make_config(&config);
+    paumiot_metrics_server_t *server = paumiot_metrics_server_start(&config, registry);
+    assert(server);
+    uint16_t port = paumiot_metrics_server_port(server);
+
+    /* A header trickling in a byte at a time is cut off at the deadline */
+    slow_client_t trickle = { port, "GET /health HTTP/1.1\r\nX: ", 50 * 1000, false };
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, slow_client_main, &trickle) == 0);
+    usleep(100 * 1000);
+    uint64_t start = time_monotonic_ms();
+    char *response = http_request(port, "GET /health HTTP/1.1\r\n\r\n");
+    assert(strstr(response, "200 OK"));
+    assert(time_monotonic_ms() - start < PAUMIOT_METRICS_IO_TIMEOUT_MS + 1000);
+    free(response);
+    atomic_store(&trickle.stop, true);
+    pthread_join(thread, NULL);
+
+    /* A client that never stops sending after its request is drained a bounded amount */
+    slow_client_t flood = { port, "GET /health HTTP/1.1\r\n\r\n", 0, false };
+    assert(pthread_create(&thread, NULL, slow_client_main, &flood) == 0);
+    usleep(100 * 1000);
+    start = time_monotonic_ms();
+    response = http_request(port, "GET /health HTTP/1.1\r\n\r\n");
+    assert(strstr(response, "200 OK"));
+    assert(time_monotonic_ms() - start < PAUMIOT_METRICS_IO_TIMEOUT_MS);
+    free(response);
+    atomic_store(&flood.stop, true);
+    pthread_join(thread, NULL);
+
+    /* Stopping does not wait for a connection in progress */
+    slow_client_t stalled = { port, "GET /hea", 100 * 1000, false };
+    assert(pthread_create(&thread, NULL, slow_client_main, &stalled) == 0);
+    usleep(100 * 1000);
+    start = time_monotonic_ms();
+    paumiot_metrics_server_stop(server);
+    assert(time_monotonic_ms() - start < PAUMIOT_METRICS_IO_TIMEOUT_MS / 2);
+    atomic_store(&stalled.stop, true);
+    pthread_join(thread, NULL);
+
+    metrics_registry_destroy(registry);
+
+    printf("  ✓ Slow client test passed\n");
+}
+
+typedef struct {
+    sensor_manager_t *sm;
+    atomic_bool stop;
+} updater_args_t;
+
+static void *update_sensor(void *arg) {
+    updater_args_t *args = arg;
+    char payload[32];
+    sensor_data_t data = { .sensor_id = (char *)"t1", .payload = (uint8_t *)payload,
+                           .format = DATA_FORMAT_JSON };
+    for (unsigned i = 0; !atomic_load(&args->stop); i++) {
+        data.payload_len = (size_t)snprintf(payload, sizeof(payload), "%u", i);
+        data.timestamp = i;
+        assert(sensor_manager_update_data(args->sm, &data) == PAUMIOT_SUCCESS);
+    }
+    return NULL;
+}
+
+static void test_sensor_manager_scrape(void) {
+    printf("Testing scrapes of a busy sensor manager...\n");
+
+    metrics_registry_t *registry = metrics_registry_create();
+    sensor_manager_config_t sm_config;
+    sensor_manager_config_init(&sm_config);
+    sm_config.enable_health_monitoring = false;
+    sm_config.metrics = registry;
+
+    sensor_manager_t *sm = sensor_manager_init(&sm_config);
+    assert(sm);
+    assert(sensor_manager_metrics(sm) == registry);
+
+    /* A second manager cannot register the same names in the same registry */
+    assert(!sensor_manager_init(&sm_config));
+
+    sensor_entry_t sensor = { .sensor_id = (char *)"t1", .name = (char *)"Temperature",
+                              .type = SENSOR_TYPE_TEMPERATURE, .status = SENSOR_STATUS_ONLINE };
+    assert(sensor_manager_register(sm, &sensor) == PAUMIOT_SUCCESS);
+
+    paumiot_config_t config;
+    make_config(&config);
+    paumiot_metrics_server_t *server = paumiot_metrics_server_start(&config, registry);
+    assert(server);
+    uint16_t port = paumiot_metrics_server_port(server);
+
+    updater_args_t args = { sm, false };
+    pthread_t updater;
+    assert(pthread_create(&updater, NULL, update_sensor, &args) == 0);
+
+    uint64_t previous = 0;
+    for (int i = 0; i < 20; i++) {
+        char *response = http_request(port, "GET /metrics HTTP/1.1\r\n\r\n");
+        const char *line = strstr(response, "\npaumiot_sensor_data_updates_total ");
+        assert(line);
+        uint64_t updates = strtoull(line + strlen("\npaumiot_sensor_data_updates_total "),
+                                    NULL, 10);
+        assert(updates >= previous);
+        previous = updates;
+        assert(strstr(response, "\npaumiot_sensors_registered 1\n"));
+        assert(strstr(response, "\npaumiot_sensors_online 1\n"));
+        assert(strstr(response, "# TYPE paumiot_sensor_callback_duration_seconds histogram\n"));
+        free(response);
+    }
+
+    atomic_store(&args.stop, true);
+    pthread_join(updater, NULL);
+
+    /* Resetting the stats does not move the scraped total backwards */
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.data_updates >= previous);
+    uint64_t total = stats.data_updates;
+    assert(sensor_manager_reset_stats(sm) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.data_updates == 0);
+
+    char *response = http_request(port, "GET /metrics HTTP/1.1\r\n\r\n");
+    char expected[96];
+    snprintf(expected, sizeof(expected), "\npaumiot_sensor_data_updates_total %llu\n",
+             (unsigned long long)total);
+    assert(strstr(response, expected));
+    free(response);
+
+    /* The manager's metrics leave the registry with it */
+    sensor_manager_cleanup(sm);
+    response = http_request(port, "GET /metrics HTTP/1.1\r\n\r\n");
+    assert(!strstr(response, "paumiot_sensor"));
+    free(response);
+
+    sm = sensor_manager_init(&sm_config);
+    assert(sm);
+    sensor_manager_cleanup(sm);
+
+    paumiot_metrics_server_stop(server);
+    metrics_registry_destroy(registry);
+
+    printf("  ✓ Sensor manager scrape test passed (%llu updates)\n",
+           (unsigned long long)total);
+}
+
+static void test_monitoring_config(void) {
+    printf("Testing [monitoring] configuration...\n");
+
+    static const char text[] =
+        "[monitoring]\n"
+        "metrics_enabled = true\n"
+        "metrics_port = 9191\n"
+        "metrics_endpoint = \"/prom\"\n"
+        "health_endpoint = \"/live\"\n";
+
+    paumiot_runtime_config_t config;
+    paumiot_config_error_t error;
+    paumiot_runtime_config_init(&config);
+    assert(!config.core.metrics_enabled);
+    assert(config.core.metrics_port == 9090);
+    assert(paumiot_runtime_config_parse(text, strlen(text), &config, &error) == PAUMIOT_SUCCESS);
+    assert(config.core.metrics_enabled);
+    assert(config.core.metrics_port == 9191);
+    assert(strcmp(config.core.metrics_endpoint, "/prom") == 0);
+    assert(strcmp(config.core.health_endpoint, "/live") == 0);
+    assert(paumiot_runtime_config_validate(&config, &error) == PAUMIOT_SUCCESS);
+
+    config.core.metrics_port = config.core.mqtt_port;
+    assert(paumiot_runtime_config_validate(&config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    config.core.metrics_port = 0;
+    assert(paumiot_runtime_config_validate(&config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    config.core.metrics_port = 9191;
+    config.core.metrics_endpoint = "metrics";
+    assert(paumiot_runtime_config_validate(&config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+    config.core.metrics_endpoint = "/live";
+    assert(paumiot_runtime_config_validate(&config, &error) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    /* Nothing is checked while metrics are off */
+    config.core.metrics_enabled = false;
+    assert(paumiot_runtime_config_validate(&config, &error) == PAUMIOT_SUCCESS);
+
+    printf("  ✓ Monitoring configuration test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running paumiot_metrics.h tests...\n");
+    printf("========================================\n\n");
+
+    log_set_level(LOG_LEVEL_WARN);
+
+    test_endpoints();
+    test_start_errors();
+    test_slow_clients();
+    test_sensor_manager_scrape();
+    test_monitoring_config();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
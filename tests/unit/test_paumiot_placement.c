@@ -0,0 +1,238 @@
+/**
+ * @file test_paumiot_placement.c
+ * @brief Unit tests for NUMA-aware thread placement
+ */
+
+#include "paumiot_placement.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+/* Build a topology of consecutive CPUs, `per_node[n]` of them on node n */
+static void make_topology(cpu_topology_t *topology, const uint16_t *per_node, uint16_t nodes) {
+    memset(topology, 0, sizeof(*topology));
+    for (int cpu = 0; cpu < CPU_TOPOLOGY_MAX_CPUS; cpu++) {
+        topology->cpu_node[cpu] = CPU_TOPOLOGY_NO_NODE;
+    }
+    uint16_t cpu = 0;
+    for (uint16_t n = 0; n < nodes; n++) {
+        topology->node_ids[n] = n;
+        for (uint16_t i = 0; i < per_node[n]; i++, cpu++) {
+            topology->cpus[topology->num_cpus++] = cpu;
+            topology->cpu_node[cpu] = n;
+        }
+    }
+    topology->num_nodes = nodes;
+}
+
+static void make_config(paumiot_config_t *config, uint32_t io, uint32_t workers) {
+    memset(config, 0, sizeof(*config));
+    config->io_threads = io;
+    config->worker_threads = workers;
+}
+
+static void test_two_sockets(void) {
+    printf("Testing placement on two sockets...\n");
+
+    static const uint16_t per_node[] = { 4, 4 };
+    cpu_topology_t topology;
+    make_topology(&topology, per_node, 2);
+
+    paumiot_config_t config;
+    make_config(&config, 2, 4);
+
+    static paumiot_placement_t placement;
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_SUCCESS);
+    assert(placement.num_nodes == 2);
+    assert(placement.io_cpu[0] == 0 && placement.io_node[0] == 0);
+    assert(placement.io_cpu[1] == 4 && placement.io_node[1] == 1);
+
+    static const int16_t expected[] = { 1, 2, 5, 6 };
+    for (int w = 0; w < 4; w++) {
+        assert(placement.worker_cpu[w] == expected[w]);
+        assert(placement.worker_node[w] == w / 2);
+    }
+    assert(placement.node_first_worker[0] == 0 && placement.node_workers[0] == 2);
+    assert(placement.node_first_worker[1] == 2 && placement.node_workers[1] == 2);
+
+    /* Connections stay on the reactor's node */
+    for (uint32_t hash = 0; hash < 16; hash++) {
+        assert(placement.worker_node[paumiot_placement_worker_for_node(&placement, 0, hash)] == 0);
+        assert(placement.worker_node[paumiot_placement_worker_for_node(&placement, 1, hash)] == 1);
+        assert(paumiot_placement_worker_for_node(&placement, 1, hash) ==
+               paumiot_placement_worker_for_node(&placement, 1, hash));
+        assert(placement.worker_node[paumiot_placement_worker_for_cpu(&placement, &topology,
+                                                                      6, hash)] == 1);
+        assert(paumiot_placement_worker_for_cpu(&placement, &topology, -1, hash) < 4);
+    }
+
+    printf("  ✓ Two-socket placement test passed\n");
+}
+
+static void test_uneven_nodes(void) {
+    printf("Testing placement on uneven nodes...\n");
+
+    static const uint16_t per_node[] = { 12, 4 };
+    cpu_topology_t topology;
+    make_topology(&topology, per_node, 2);
+
+    paumiot_config_t config;
+    make_config(&config, 1, 8);
+
+    static paumiot_placement_t placement;
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_SUCCESS);
+    assert(placement.node_workers[0] == 6 && placement.node_workers[1] == 2);
+
+    /* Too few reactors for one per node: proportional share only */
+    assert(placement.io_node[0] == 0 && placement.io_cpu[0] == 0);
+    assert(placement.worker_cpu[0] == 1);
+    assert(placement.worker_cpu[6] == 12);
+
+    /* A node without reactors still has workers; node 1 keeps its CPUs */
+    for (int w = 6; w < 8; w++) {
+        assert(placement.worker_node[w] == 1);
+    }
+
+    printf("  ✓ Uneven node placement test passed\n");
+}
+
+static void test_cpu_affinity(void) {
+    printf("Testing placement restricted by cpu_affinity...\n");
+
+    static const uint16_t per_node[] = { 4, 4 };
+    cpu_topology_t topology;
+    make_topology(&topology, per_node, 2);
+
+    paumiot_config_t config;
+    make_config(&config, 1, 3);
+    config.cpu_affinity_count = 4;
+    for (int i = 0; i < 4; i++) {
+        config.cpu_affinity[i] = 4 + i;
+    }
+
+    static paumiot_placement_t placement;
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_SUCCESS);
+    assert(placement.io_cpu[0] == 4);
+    for (int w = 0; w < 3; w++) {
+        assert(placement.worker_cpu[w] == 5 + w);
+        assert(placement.worker_node[w] == 1);
+    }
+    assert(placement.node_workers[0] == 0);
+
+    /* Node 0 has no workers: steering falls back to any worker */
+    for (uint32_t hash = 0; hash < 8; hash++) {
+        assert(paumiot_placement_worker_for_node(&placement, 0, hash) == hash % 3);
+        assert(paumiot_placement_worker_for_cpu(&placement, &topology, 1, hash) == hash % 3);
+    }
+
+    /* A CPU that is not usable */
+    config.cpu_affinity[3] = 8;
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    printf("  ✓ cpu_affinity placement test passed\n");
+}
+
+static void test_oversubscription(void) {
+    printf("Testing oversubscribed placement...\n");
+
+    static const uint16_t per_node[] = { 2 };
+    cpu_topology_t topology;
+    make_topology(&topology, per_node, 1);
+
+    paumiot_config_t config;
+    make_config(&config, 2, 5);
+
+    static paumiot_placement_t placement;
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_SUCCESS);
+    assert(placement.io_cpu[0] == 0 && placement.io_cpu[1] == 1);
+    static const int16_t expected[] = { 0, 1, 0, 1, 0 };
+    for (int w = 0; w < 5; w++) {
+        assert(placement.worker_cpu[w] == expected[w]);
+    }
+
+    /* One reactor leaves one spare CPU for all workers */
+    make_config(&config, 1, 3);
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_SUCCESS);
+    for (int w = 0; w < 3; w++) {
+        assert(placement.worker_cpu[w] == 1);
+    }
+
+    printf("  ✓ Oversubscription test passed\n");
+}
+
+static void test_invalid_parameters(void) {
+    printf("Testing invalid placement parameters...\n");
+
+    static const uint16_t per_node[] = { 2 };
+    cpu_topology_t topology;
+    make_topology(&topology, per_node, 1);
+
+    paumiot_config_t config;
+    static paumiot_placement_t placement;
+
+    make_config(&config, 0, 1);
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+    make_config(&config, 1, 0);
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+    make_config(&config, PAUMIOT_MAX_IO_THREADS + 1, 1);
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+    make_config(&config, 1, PAUMIOT_MAX_WORKER_THREADS + 1);
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    make_config(&config, 1, 1);
+    assert(paumiot_placement_plan(NULL, &topology, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(paumiot_placement_plan(&config, NULL, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(paumiot_placement_plan(&config, &topology, NULL) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    topology.num_nodes = 0;
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    /* A node without CPUs leaves nothing to share threads over */
+    static const uint16_t empty[] = { 0 };
+    make_topology(&topology, empty, 1);
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    printf("  ✓ Invalid parameter test passed\n");
+}
+
+static void test_host_placement(void) {
+    printf("Testing placement on this host...\n");
+
+    cpu_topology_t topology;
+    assert(cpu_topology_discover(&topology, NULL));
+
+    paumiot_config_t config;
+    make_config(&config, 4, 16);
+
+    static paumiot_placement_t placement;
+    assert(paumiot_placement_plan(&config, &topology, &placement) == PAUMIOT_SUCCESS);
+    uint32_t total = 0;
+    for (uint16_t n = 0; n < placement.num_nodes; n++) {
+        total += placement.node_workers[n];
+    }
+    assert(total == 16);
+    for (int w = 0; w < 16; w++) {
+        assert(cpu_topology_node(&topology, placement.worker_cpu[w]) == placement.worker_node[w]);
+    }
+
+    printf("  ✓ Host placement test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running paumiot_placement.h tests...\n");
+    printf("========================================\n\n");
+
+    test_two_sockets();
+    test_uneven_nodes();
+    test_cpu_affinity();
+    test_oversubscription();
+    test_invalid_parameters();
+    test_host_placement();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
@@ -11,6 +11,9 @@
 #include <assert.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 /* Test message structure */
 typedef struct {
@@ -26,6 +29,26 @@ typedef struct {
     int* consumed;
 } thread_data_t;
 
+/* Element of the exactly-once test; check and fill catch torn copies */
+typedef struct {
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t check;
+    uint32_t fill[13];
+} tagged_item_t;
+
+#define MPMC_PRODUCERS 4
+#define MPMC_CONSUMERS 4
+#define MPMC_ITEMS_PER_PRODUCER 20000
+
+/* Shared state of the exactly-once test */
+typedef struct {
+    queue_t* queue;
+    uint32_t producer;                  /* Producer index (producers only) */
+    atomic_int* remaining;              /* Items not yet consumed */
+    atomic_uchar* seen;                 /* Deliveries per item */
+} mpmc_data_t;
+
 /* ========================================
  * Basic Functionality Tests
  * ======================================== */
@@ -446,6 +469,139 @@ static void test_queue_multiple_producers_consumers(void) {
     printf("  ✓ Multiple producers/consumers test passed\n");
 }
 
+static uint32_t item_check(uint32_t producer, uint32_t seq) {
+    return (producer * 2654435761u) ^ (seq * 40503u) ^ 0x5a5a5a5au;
+}
+
+static void* tagged_producer_thread(void* arg) {
+    mpmc_data_t* data = (mpmc_data_t*)arg;
+    
+    for (uint32_t i = 0; i < MPMC_ITEMS_PER_PRODUCER; i++) {
+        tagged_item_t item = { data->producer, i, item_check(data->producer, i), { 0 } };
+        for (size_t j = 0; j < sizeof(item.fill) / sizeof(item.fill[0]); j++) {
+            item.fill[j] = item.check;
+        }
+        while (queue_enqueue(data->queue, &item) != PAUMIOT_SUCCESS) {
+            sched_yield();
+        }
+    }
+    
+    return NULL;
+}
+
+static void* tagged_consumer_thread(void* arg) {
+    mpmc_data_t* data = (mpmc_data_t*)arg;
+    int64_t last_seq[MPMC_PRODUCERS];
+    
+    for (int i = 0; i < MPMC_PRODUCERS; i++) {
+        last_seq[i] = -1;
+    }
+    
+    while (atomic_load(data->remaining) > 0) {
+        tagged_item_t item;
+        if (queue_dequeue(data->queue, &item) != PAUMIOT_SUCCESS) {
+            sched_yield();
+            continue;
+        }
+        
+        assert(item.producer < MPMC_PRODUCERS);
+        assert(item.seq < MPMC_ITEMS_PER_PRODUCER);
+        assert(item.check == item_check(item.producer, item.seq));
+        for (size_t j = 0; j < sizeof(item.fill) / sizeof(item.fill[0]); j++) {
+            assert(item.fill[j] == item.check);
+        }
+        
+        /* One producer's items reach any one consumer in order */
+        assert((int64_t)item.seq > last_seq[item.producer]);
+        last_seq[item.producer] = item.seq;
+        
+        atomic_fetch_add(&data->seen[item.producer * MPMC_ITEMS_PER_PRODUCER + item.seq], 1);
+        atomic_fetch_sub(data->remaining, 1);
+    }
+    
+    return NULL;
+}
+
+static void test_queue_mpmc_exactly_once(void) {
+    printf("Testing every item is delivered exactly once under MPMC load...\n");
+    
+    const size_t total = (size_t)MPMC_PRODUCERS * MPMC_ITEMS_PER_PRODUCER;
+    queue_t* queue = queue_create(64, sizeof(tagged_item_t));
+    atomic_uchar* seen = calloc(total, sizeof(atomic_uchar));
+    atomic_int remaining;
+    assert(queue != NULL && seen != NULL);
+    atomic_init(&remaining, (int)total);
+    
+    mpmc_data_t producer_data[MPMC_PRODUCERS];
+    mpmc_data_t consumer_data[MPMC_CONSUMERS];
+    pthread_t producers[MPMC_PRODUCERS];
+    pthread_t consumers[MPMC_CONSUMERS];
+    
+    for (int i = 0; i < MPMC_CONSUMERS; i++) {
+        consumer_data[i] = (mpmc_data_t){ queue, 0, &remaining, seen };
+        pthread_create(&consumers[i], NULL, tagged_consumer_thread, &consumer_data[i]);
+    }
+    for (int i = 0; i < MPMC_PRODUCERS; i++) {
+        producer_data[i] = (mpmc_data_t){ queue, (uint32_t)i, &remaining, seen };
+        pthread_create(&producers[i], NULL, tagged_producer_thread, &producer_data[i]);
+    }
+    
+    for (int i = 0; i < MPMC_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    for (int i = 0; i < MPMC_CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+    
+    assert(atomic_load(&remaining) == 0);
+    for (size_t i = 0; i < total; i++) {
+        assert(atomic_load(&seen[i]) == 1);
+    }
+    assert(queue_is_empty(queue));
+    assert(queue_size(queue) == 0);
+    
+    free(seen);
+    queue_destroy(queue);
+    printf("  ✓ MPMC exactly-once test passed\n");
+}
+
+static void test_queue_is_empty_agrees_with_dequeue(void) {
+    printf("Testing queue_is_empty agrees with queue_dequeue under load...\n");
+    
+    const size_t total = (size_t)2 * MPMC_ITEMS_PER_PRODUCER;
+    queue_t* queue = queue_create(16, sizeof(tagged_item_t));
+    assert(queue != NULL);
+    
+    mpmc_data_t producer_data[2];
+    pthread_t producers[2];
+    for (int i = 0; i < 2; i++) {
+        producer_data[i] = (mpmc_data_t){ queue, (uint32_t)i, NULL, NULL };
+        pthread_create(&producers[i], NULL, tagged_producer_thread, &producer_data[i]);
+    }
+    
+    /* As the only consumer, a non-empty answer must leave an element to take */
+    size_t consumed = 0;
+    while (consumed < total) {
+        if (queue_is_empty(queue)) {
+            sched_yield();
+            continue;
+        }
+        
+        tagged_item_t item;
+        assert(queue_dequeue(queue, &item) == PAUMIOT_SUCCESS);
+        assert(item.check == item_check(item.producer, item.seq));
+        consumed++;
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    assert(queue_is_empty(queue));
+    
+    queue_destroy(queue);
+    printf("  ✓ Empty check consistency test passed\n");
+}
+
 /* ========================================
  * Main Test Runner
  * ======================================== */
@@ -469,6 +625,8 @@ int main(void) {
     /* Concurrent tests */
     test_queue_single_producer_consumer();
     test_queue_multiple_producers_consumers();
+    test_queue_mpmc_exactly_once();
+    test_queue_is_empty_agrees_with_dequeue();
     
     printf("\n========================================\n");
     printf("✅ All tests passed successfully!\n");
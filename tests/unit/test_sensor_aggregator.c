@@ -0,0 +1,255 @@
+/**
+ * @file test_sensor_aggregator.c
+ * @brief Unit tests for windowed sensor aggregation
+ */
+
+#include "sensor_manager/sensor_aggregator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#define BASE_TS 1700000000000ULL
+#define MAX_CAPTURED 64
+
+typedef struct {
+    sensor_aggregate_t windows[MAX_CAPTURED];
+    size_t count;
+} capture_t;
+
+static void capture(const sensor_aggregate_t* aggregate, void* user_data) {
+    capture_t* c = (capture_t*)user_data;
+    assert(c->count < MAX_CAPTURED);
+    c->windows[c->count++] = *aggregate;
+}
+
+static bool near(double a, double b, double tolerance) {
+    return fabs(a - b) <= tolerance;
+}
+
+static void test_aggregator_create(void) {
+    printf("Testing aggregator create...\n");
+
+    capture_t c = {0};
+    sensor_aggregator_t* agg = sensor_aggregator_create(60000, 0, capture, &c);
+    assert(agg != NULL);
+    sensor_aggregator_destroy(agg);
+
+    agg = sensor_aggregator_create(60000, 10000, capture, &c);
+    assert(agg != NULL);
+    sensor_aggregator_destroy(agg);
+
+    /* Invalid windows */
+    assert(sensor_aggregator_create(0, 0, capture, &c) == NULL);
+    assert(sensor_aggregator_create(60000, 7000, capture, &c) == NULL);
+    assert(sensor_aggregator_create(60000, 120000, capture, &c) == NULL);
+    assert(sensor_aggregator_create(60000, 100, capture, &c) == NULL);
+    assert(sensor_aggregator_create(60000, 0, NULL, NULL) == NULL);
+
+    sensor_aggregator_destroy(NULL);
+
+    printf("  ✓ Aggregator create test passed\n");
+}
+
+static void test_aggregator_tumbling(void) {
+    printf("Testing tumbling windows...\n");
+
+    capture_t c = {0};
+    sensor_aggregator_t* agg = sensor_aggregator_create(1000, 0, capture, &c);
+    assert(agg != NULL);
+
+    /* Ten samples 1..10 in the first second */
+    for (int i = 0; i < 10; i++) {
+        assert(sensor_aggregator_add(agg, "t1", BASE_TS + (uint64_t)i * 100, i + 1.0) ==
+               PAUMIOT_SUCCESS);
+    }
+    assert(c.count == 0);
+
+    /* The first sample of the next second closes the window */
+    assert(sensor_aggregator_add(agg, "t1", BASE_TS + 1000, 42.0) == PAUMIOT_SUCCESS);
+    assert(c.count == 1);
+
+    sensor_aggregate_t* w = &c.windows[0];
+    assert(strcmp(w->sensor_id, "t1") == 0);
+    assert(w->window_start == BASE_TS);
+    assert(w->window_end == BASE_TS + 1000);
+    assert(w->count == 10);
+    assert(w->sum == 55.0);
+    assert(w->min == 1.0);
+    assert(w->max == 10.0);
+    assert(w->mean == 5.5);
+    assert(w->last == 10.0);
+    assert(w->last_timestamp == BASE_TS + 900);
+    assert(near(w->p50, 5.5, 0.5));
+    assert(w->p99 <= 10.0 && w->p99 >= 9.0);
+
+    /* Idle sensors are closed by advancing time */
+    sensor_aggregator_advance(agg, BASE_TS + 1999);
+    assert(c.count == 1);
+    sensor_aggregator_advance(agg, BASE_TS + 2000);
+    assert(c.count == 2);
+    assert(c.windows[1].count == 1);
+    assert(c.windows[1].last == 42.0);
+
+    /* Samples for closed windows are late */
+    assert(sensor_aggregator_add(agg, "t1", BASE_TS + 1500, 1.0) == PAUMIOT_SUCCESS);
+    assert(sensor_aggregator_late_samples(agg) == 1);
+
+    /* Sensors are independent */
+    assert(sensor_aggregator_add(agg, "t2", BASE_TS + 5000, 7.0) == PAUMIOT_SUCCESS);
+    sensor_aggregator_advance(agg, BASE_TS + 6000);
+    assert(c.count == 3);
+    assert(strcmp(c.windows[2].sensor_id, "t2") == 0);
+
+    /* A long gap emits nothing for empty windows */
+    size_t before = c.count;
+    assert(sensor_aggregator_add(agg, "t2", BASE_TS + 3600000, 1.0) == PAUMIOT_SUCCESS);
+    assert(c.count == before);
+
+    sensor_aggregator_destroy(agg);
+
+    printf("  ✓ Tumbling window test passed\n");
+}
+
+static void test_aggregator_sliding(void) {
+    printf("Testing sliding windows...\n");
+
+    capture_t c = {0};
+    sensor_aggregator_t* agg = sensor_aggregator_create(3000, 1000, capture, &c);
+    assert(agg != NULL);
+
+    /* One sample per second: 1, 2, 3, 4 */
+    for (int i = 0; i < 4; i++) {
+        assert(sensor_aggregator_add(agg, "s", BASE_TS + 500 + (uint64_t)i * 1000, i + 1.0) ==
+               PAUMIOT_SUCCESS);
+    }
+
+    /* Windows ending at +1s, +2s, +3s have closed */
+    assert(c.count == 3);
+    assert(c.windows[0].count == 1 && c.windows[0].window_end == BASE_TS + 1000);
+    assert(c.windows[1].count == 2 && c.windows[1].sum == 3.0);
+    assert(c.windows[2].count == 3 && c.windows[2].sum == 6.0);
+    assert(c.windows[2].window_start == BASE_TS);
+    assert(c.windows[2].window_end == BASE_TS + 3000);
+
+    /* The window ending at +4s drops the first sample */
+    sensor_aggregator_advance(agg, BASE_TS + 4000);
+    assert(c.count == 4);
+    assert(c.windows[3].count == 3);
+    assert(c.windows[3].sum == 9.0);
+    assert(c.windows[3].min == 2.0);
+    assert(c.windows[3].max == 4.0);
+    assert(c.windows[3].last == 4.0);
+    assert(near(c.windows[3].p50, 3.0, 0.5));
+
+    /* Remaining windows drain as the samples slide out */
+    sensor_aggregator_advance(agg, BASE_TS + 100000);
+    assert(c.count == 6);
+    assert(c.windows[5].count == 1);
+
+    /* Removing a sensor discards its state */
+    assert(sensor_aggregator_add(agg, "s", BASE_TS + 200500, 1.0) == PAUMIOT_SUCCESS);
+    sensor_aggregator_remove(agg, "s");
+    sensor_aggregator_advance(agg, BASE_TS + 300000);
+    assert(c.count == 6);
+
+    /* A reference held across removal stays valid but no longer records */
+    sensor_aggregator_series_t* series = sensor_aggregator_acquire(agg, "s");
+    assert(series != NULL);
+    sensor_aggregator_remove(agg, "s");
+    assert(sensor_aggregator_add_series(agg, series, BASE_TS + 300500, 1.0) ==
+           PAUMIOT_SUCCESS);
+    sensor_aggregator_release(series);
+    sensor_aggregator_advance(agg, BASE_TS + 400000);
+    assert(c.count == 6);
+
+    sensor_aggregator_destroy(agg);
+
+    printf("  ✓ Sliding window test passed\n");
+}
+
+static void test_aggregator_quantiles(void) {
+    printf("Testing t-digest quantiles...\n");
+
+    capture_t c = {0};
+    sensor_aggregator_t* agg = sensor_aggregator_create(60000, 10000, capture, &c);
+    assert(agg != NULL);
+
+    /* 100k uniform samples in [0, 1) spread over one minute */
+    srand(7);
+    const int n = 100000;
+    for (int i = 0; i < n; i++) {
+        double v = (double)rand() / ((double)RAND_MAX + 1.0);
+        uint64_t ts = BASE_TS + (uint64_t)i * 60000 / n;
+        assert(sensor_aggregator_add(agg, "q", ts, v) == PAUMIOT_SUCCESS);
+    }
+    sensor_aggregator_advance(agg, BASE_TS + 60000);
+
+    sensor_aggregate_t* w = &c.windows[c.count - 1];
+    assert(w->count == (uint64_t)n);
+    assert(w->window_start == BASE_TS && w->window_end == BASE_TS + 60000);
+    printf("  p50=%.4f p90=%.4f p99=%.4f\n", w->p50, w->p90, w->p99);
+    assert(near(w->p50, 0.50, 0.02));
+    assert(near(w->p90, 0.90, 0.02));
+    assert(near(w->p99, 0.99, 0.01));
+    assert(near(w->mean, 0.5, 0.01));
+
+    sensor_aggregator_destroy(agg);
+
+    printf("  ✓ Quantile test passed\n");
+}
+
+static void test_aggregate_json(void) {
+    printf("Testing aggregate JSON rendering...\n");
+
+    sensor_aggregate_t a = {
+        .sensor_id = "temp\"1",
+        .window_start = 1000,
+        .window_end = 2000,
+        .count = 2,
+        .sum = 3.0,
+        .min = 1.0,
+        .max = 2.0,
+        .mean = 1.5,
+        .last = 2.0,
+        .p50 = 1.5,
+        .p90 = 1.9,
+        .p99 = 2.0
+    };
+
+    char buf[512];
+    int len = sensor_aggregate_to_json(&a, buf, sizeof(buf));
+    assert(len > 0 && (size_t)len == strlen(buf));
+    assert(strstr(buf, "\"sensor_id\":\"temp\\\"1\"") != NULL);
+    assert(strstr(buf, "\"count\":2") != NULL);
+    assert(strstr(buf, "\"mean\":1.5") != NULL);
+
+    char small[16];
+    assert(sensor_aggregate_to_json(&a, small, sizeof(small)) == -1);
+
+    /* Control characters cannot appear raw in a JSON string */
+    a.sensor_id = "line\n\x01" "end";
+    assert(sensor_aggregate_to_json(&a, buf, sizeof(buf)) > 0);
+    assert(strstr(buf, "\"sensor_id\":\"line\\u000a\\u0001end\"") != NULL);
+
+    printf("  ✓ Aggregate JSON test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running sensor_aggregator.h tests...\n");
+    printf("========================================\n\n");
+
+    test_aggregator_create();
+    test_aggregator_tumbling();
+    test_aggregator_sliding();
+    test_aggregator_quantiles();
+    test_aggregate_json();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
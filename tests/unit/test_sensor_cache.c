@@ -0,0 +1,416 @@
+/**
+ * @file test_sensor_cache.c
+ * @brief Unit tests for the sensor last-value cache
+ */
+
+#include "sensor_manager/sensor_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+static sensor_data_t make_data(const char* id, const char* topic,
+                               const uint8_t* payload, size_t len) {
+    sensor_data_t data = {
+        .sensor_id = (char*)id,
+        .topic = (char*)topic,
+        .payload = (uint8_t*)payload,
+        .payload_len = len,
+        .format = DATA_FORMAT_JSON,
+        .timestamp = 1000,
+        .qos = QOS_LEVEL_1
+    };
+    return data;
+}
+
+static void test_cache_create_destroy(void) {
+    printf("Testing cache create/destroy...\n");
+
+    sensor_cache_t* cache = sensor_cache_create(16, 0, 0);
+    assert(cache != NULL);
+    assert(sensor_cache_count(cache) == 0);
+    assert(sensor_cache_memory_usage(cache) == 0);
+    sensor_cache_destroy(cache);
+
+    /* Invalid parameters */
+    assert(sensor_cache_create(0, 0, 0) == NULL);
+
+    /* NULL handling */
+    sensor_cache_destroy(NULL);
+    assert(sensor_cache_count(NULL) == 0);
+    assert(sensor_cache_memory_usage(NULL) == 0);
+
+    printf("  ✓ Cache create/destroy test passed\n");
+}
+
+static void test_cache_put_get(void) {
+    printf("Testing cache put/get...\n");
+
+    sensor_cache_t* cache = sensor_cache_create(16, 0, 0);
+    assert(cache != NULL);
+
+    const uint8_t payload[] = "{\"t\":21.5}";
+    sensor_data_t data = make_data("temp-1", "sensors/temp/1", payload, sizeof(payload) - 1);
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+    assert(sensor_cache_count(cache) == 1);
+    assert(sensor_cache_memory_usage(cache) ==
+           strlen("temp-1") + strlen("sensors/temp/1") + sizeof(payload) - 1);
+
+    sensor_cache_value_t value;
+    assert(sensor_cache_get(cache, "temp-1", &value) == PAUMIOT_SUCCESS);
+    assert(strcmp(value.sensor_id, "temp-1") == 0);
+    assert(strcmp(value.topic, "sensors/temp/1") == 0);
+    assert(value.payload_len == sizeof(payload) - 1);
+    assert(memcmp(value.payload, payload, value.payload_len) == 0);
+    assert(value.format == DATA_FORMAT_JSON);
+    assert(value.timestamp == 1000);
+    assert(value.qos == QOS_LEVEL_1);
+
+    /* Overwrite keeps a single entry */
+    const uint8_t payload2[] = "{\"t\":22}";
+    data = make_data("temp-1", "sensors/temp/1", payload2, sizeof(payload2) - 1);
+    data.timestamp = 2000;
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+    assert(sensor_cache_count(cache) == 1);
+    assert(sensor_cache_get(cache, "temp-1", &value) == PAUMIOT_SUCCESS);
+    assert(value.timestamp == 2000);
+    assert(memcmp(value.payload, payload2, value.payload_len) == 0);
+
+    /* Miss */
+    assert(sensor_cache_get(cache, "temp-2", &value) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+
+    /* Invalid parameters */
+    assert(sensor_cache_put(NULL, &data) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(sensor_cache_get(cache, NULL, &value) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    sensor_cache_destroy(cache);
+
+    printf("  ✓ Cache put/get test passed\n");
+}
+
+static void test_cache_ttl(void) {
+    printf("Testing cache TTL...\n");
+
+    sensor_cache_t* cache = sensor_cache_create(4, 0, 20);
+    assert(cache != NULL);
+
+    const uint8_t payload[] = "1";
+    sensor_data_t data = make_data("s1", NULL, payload, 1);
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+
+    sensor_cache_value_t value;
+    assert(sensor_cache_get(cache, "s1", &value) == PAUMIOT_SUCCESS);
+    assert(value.topic[0] == '\0');
+
+    usleep(50 * 1000);
+    assert(sensor_cache_get(cache, "s1", &value) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+
+    /* A fresh write makes the entry readable again */
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+    assert(sensor_cache_get(cache, "s1", &value) == PAUMIOT_SUCCESS);
+
+    /* A changed TTL applies to entries already cached */
+    usleep(50 * 1000);
+    sensor_cache_set_ttl(cache, 0);
+    assert(sensor_cache_get(cache, "s1", &value) == PAUMIOT_SUCCESS);
+    sensor_cache_set_ttl(cache, 20);
+    assert(sensor_cache_get(cache, "s1", &value) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+
+    sensor_cache_destroy(cache);
+
+    printf("  ✓ Cache TTL test passed\n");
+}
+
+static void test_cache_clock_eviction(void) {
+    printf("Testing cache CLOCK eviction...\n");
+
+    sensor_cache_t* cache = sensor_cache_create(4, 0, 0);
+    assert(cache != NULL);
+
+    const uint8_t payload[] = "x";
+    char id[16];
+    for (int i = 0; i < 4; i++) {
+        snprintf(id, sizeof(id), "s%d", i);
+        sensor_data_t data = make_data(id, NULL, payload, 1);
+        assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+    }
+    assert(sensor_cache_count(cache) == 4);
+
+    /* Inserting a fifth entry evicts one; the count stays bounded */
+    sensor_data_t data = make_data("s4", NULL, payload, 1);
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+    assert(sensor_cache_count(cache) == 4);
+
+    sensor_cache_value_t value;
+    assert(sensor_cache_get(cache, "s4", &value) == PAUMIOT_SUCCESS);
+
+    /* Recently read entries survive the next sweep */
+    assert(sensor_cache_get(cache, "s4", &value) == PAUMIOT_SUCCESS);
+    data = make_data("s5", NULL, payload, 1);
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+    assert(sensor_cache_get(cache, "s4", &value) == PAUMIOT_SUCCESS);
+    assert(sensor_cache_get(cache, "s5", &value) == PAUMIOT_SUCCESS);
+
+    int present = 0;
+    for (int i = 0; i < 6; i++) {
+        snprintf(id, sizeof(id), "s%d", i);
+        if (sensor_cache_get(cache, id, &value) == PAUMIOT_SUCCESS) {
+            present++;
+        }
+    }
+    assert(present == 4);
+
+    sensor_cache_destroy(cache);
+
+    printf("  ✓ Cache CLOCK eviction test passed\n");
+}
+
+static void test_cache_byte_budget(void) {
+    printf("Testing cache byte budget...\n");
+
+    /* Each entry charges 2 (id) + 10 (payload) = 12 bytes */
+    sensor_cache_t* cache = sensor_cache_create(64, 40, 0);
+    assert(cache != NULL);
+
+    const uint8_t payload[10] = {0};
+    char id[8];
+    for (int i = 0; i < 10; i++) {
+        snprintf(id, sizeof(id), "s%d", i);
+        sensor_data_t data = make_data(id, NULL, payload, sizeof(payload));
+        assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+        assert(sensor_cache_memory_usage(cache) <= 40);
+    }
+    assert(sensor_cache_count(cache) == 3);
+    assert(sensor_cache_memory_usage(cache) == 36);
+
+    /* An entry larger than the whole budget is rejected */
+    uint8_t big[64] = {0};
+    sensor_data_t data = make_data("s9", NULL, big, sizeof(big));
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_ERROR_NOT_SUPPORTED);
+
+    sensor_cache_destroy(cache);
+
+    printf("  ✓ Cache byte budget test passed\n");
+}
+
+static void test_cache_oversized_drops_stale(void) {
+    printf("Testing cache oversized payload...\n");
+
+    sensor_cache_t* cache = sensor_cache_create(8, 0, 0);
+    assert(cache != NULL);
+
+    const uint8_t small[] = "1";
+    sensor_data_t data = make_data("s1", NULL, small, 1);
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_SUCCESS);
+
+    uint8_t big[SENSOR_CACHE_MAX_PAYLOAD + 1];
+    memset(big, 'a', sizeof(big));
+    data = make_data("s1", NULL, big, sizeof(big));
+    assert(sensor_cache_put(cache, &data) == PAUMIOT_ERROR_NOT_SUPPORTED);
+
+    /* The older small value must not be served any more */
+    sensor_cache_value_t value;
+    assert(sensor_cache_get(cache, "s1", &value) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+    assert(sensor_cache_count(cache) == 0);
+
+    sensor_cache_destroy(cache);
+
+    printf("  ✓ Cache oversized payload test passed\n");
+}
+
+static void test_cache_remove_clear(void) {
+    printf("Testing cache remove/clear...\n");
+
+    sensor_cache_t* cache = sensor_cache_create(8, 0, 0);
+    assert(cache != NULL);
+
+    const uint8_t payload[] = "1";
+    sensor_data_t a = make_data("a", NULL, payload, 1);
+    sensor_data_t b = make_data("b", NULL, payload, 1);
+    assert(sensor_cache_put(cache, &a) == PAUMIOT_SUCCESS);
+    assert(sensor_cache_put(cache, &b) == PAUMIOT_SUCCESS);
+
+    sensor_cache_remove(cache, "a");
+    sensor_cache_remove(cache, "missing");
+    assert(sensor_cache_count(cache) == 1);
+
+    sensor_cache_value_t value;
+    assert(sensor_cache_get(cache, "a", &value) != PAUMIOT_SUCCESS);
+    assert(sensor_cache_get(cache, "b", &value) == PAUMIOT_SUCCESS);
+
+    sensor_cache_clear(cache);
+    assert(sensor_cache_count(cache) == 0);
+    assert(sensor_cache_memory_usage(cache) == 0);
+
+    sensor_cache_destroy(cache);
+
+    printf("  ✓ Cache remove/clear test passed\n");
+}
+
+/* ========================================
+ * Concurrency Test
+ * ======================================== */
+
+/* Reads each reader must make while a write lands, proving the readers
+ * raced the writer instead of running before or after it */
+#define CONCURRENT_MIN_OVERLAPS 25
+#define CONCURRENT_MIN_WRITES 20000
+#define CONCURRENT_DEADLINE_S 20
+#define CONCURRENT_READERS 2
+
+typedef struct {
+    sensor_cache_t* cache;
+    atomic_bool* stop;
+    atomic_uint_fast64_t* writes;   /* Puts started by the writer */
+    atomic_int overlaps;            /* Hits during which a put started */
+    int hits;
+    int torn_reads;
+} reader_data_t;
+
+typedef struct {
+    sensor_cache_t* cache;
+    atomic_bool* stop;
+    atomic_uint_fast64_t* writes;
+    reader_data_t* readers;
+    uint64_t last;                  /* Timestamp of the final write */
+} writer_data_t;
+
+static bool readers_satisfied(writer_data_t* data) {
+    for (int r = 0; r < CONCURRENT_READERS; r++) {
+        if (atomic_load(&data->readers[r].overlaps) < CONCURRENT_MIN_OVERLAPS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void* writer_thread(void* arg) {
+    writer_data_t* data = (writer_data_t*)arg;
+    uint8_t payload[64];
+    time_t deadline = time(NULL) + CONCURRENT_DEADLINE_S;
+
+    /* Keep overwriting until every reader has raced enough writes; the
+     * test fails on the overlap counts if the deadline cuts this short */
+    uint64_t i = 0;
+    for (;; i++) {
+        /* Every byte of a reading carries the same value */
+        memset(payload, (int)(i & 0xFF), sizeof(payload));
+        sensor_data_t reading = make_data("hot", "sensors/hot", payload,
+                                          16 + (size_t)(i % 48));
+        reading.timestamp = i;
+        atomic_fetch_add(data->writes, 1);
+        sensor_cache_put(data->cache, &reading);
+        if (i >= CONCURRENT_MIN_WRITES && i % 1024 == 0 &&
+            (readers_satisfied(data) || time(NULL) >= deadline)) {
+            break;
+        }
+    }
+
+    data->last = i;
+    atomic_store(data->stop, true);
+    return NULL;
+}
+
+static void* reader_thread(void* arg) {
+    reader_data_t* data = (reader_data_t*)arg;
+    sensor_cache_value_t value;
+
+    while (!atomic_load(data->stop)) {
+        uint64_t before = atomic_load(data->writes);
+        if (sensor_cache_get(data->cache, "hot", &value) != PAUMIOT_SUCCESS) {
+            continue;
+        }
+        data->hits++;
+        if (atomic_load(data->writes) != before) {
+            atomic_fetch_add(&data->overlaps, 1);
+        }
+
+        uint8_t expected = (uint8_t)(value.timestamp & 0xFF);
+        if (value.payload_len != 16 + (size_t)(value.timestamp % 48)) {
+            data->torn_reads++;
+            continue;
+        }
+        for (size_t i = 0; i < value.payload_len; i++) {
+            if (value.payload[i] != expected) {
+                data->torn_reads++;
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void test_cache_concurrent_consistency(void) {
+    printf("Testing cache concurrent reader/writer consistency...\n");
+
+    sensor_cache_t* cache = sensor_cache_create(8, 0, 0);
+    assert(cache != NULL);
+
+    atomic_bool stop;
+    atomic_init(&stop, false);
+    atomic_uint_fast64_t writes;
+    atomic_init(&writes, 0);
+
+    reader_data_t readers[CONCURRENT_READERS];
+    for (int i = 0; i < CONCURRENT_READERS; i++) {
+        readers[i] = (reader_data_t){ .cache = cache, .stop = &stop, .writes = &writes };
+        atomic_init(&readers[i].overlaps, 0);
+    }
+    writer_data_t writer = { .cache = cache, .stop = &stop, .writes = &writes,
+                             .readers = readers };
+
+    pthread_t writer_tid;
+    pthread_t reader_tids[CONCURRENT_READERS];
+
+    for (int i = 0; i < CONCURRENT_READERS; i++) {
+        pthread_create(&reader_tids[i], NULL, reader_thread, &readers[i]);
+    }
+    pthread_create(&writer_tid, NULL, writer_thread, &writer);
+
+    pthread_join(writer_tid, NULL);
+    for (int i = 0; i < CONCURRENT_READERS; i++) {
+        pthread_join(reader_tids[i], NULL);
+        assert(readers[i].torn_reads == 0);
+        assert(atomic_load(&readers[i].overlaps) >= CONCURRENT_MIN_OVERLAPS);
+    }
+
+    /* The final value is always visible once writers are done */
+    sensor_cache_value_t value;
+    assert(sensor_cache_get(cache, "hot", &value) == PAUMIOT_SUCCESS);
+    assert(value.timestamp == writer.last);
+
+    sensor_cache_destroy(cache);
+
+    printf("  ✓ Cache concurrent consistency test passed (%d + %d reads, %d + %d during writes)\n",
+           readers[0].hits, readers[1].hits,
+           atomic_load(&readers[0].overlaps), atomic_load(&readers[1].overlaps));
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running sensor_cache.h tests...\n");
+    printf("========================================\n\n");
+
+    test_cache_create_destroy();
+    test_cache_put_get();
+    test_cache_ttl();
+    test_cache_clock_eviction();
+    test_cache_byte_budget();
+    test_cache_oversized_drops_stale();
+    test_cache_remove_clear();
+    test_cache_concurrent_consistency();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
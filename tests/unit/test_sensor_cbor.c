@@ -0,0 +1,298 @@
+/**
+ * @file test_sensor_cbor.c
+ * @brief Unit tests for the streaming CBOR encoder and decoder
+ * @details Expected encodings are from RFC 8949 Appendix A.
+ */
+
+#include "sensor_manager/sensor_cbor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+static size_t from_hex(const char* hex, uint8_t* out) {
+    size_t n = 0;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned byte;
+        sscanf(hex, "%2x", &byte);
+        out[n++] = (uint8_t)byte;
+    }
+    return n;
+}
+
+static void assert_encoding(const cbor_writer_t* writer, const char* hex) {
+    uint8_t expected[64];
+    size_t n = from_hex(hex, expected);
+    assert(cbor_writer_result(writer) == PAUMIOT_SUCCESS);
+    assert(writer->len == n);
+    assert(memcmp(writer->buf, expected, n) == 0);
+}
+
+static void test_cbor_write_scalars(void) {
+    printf("Testing CBOR scalar encoding...\n");
+
+    static const struct { uint64_t value; const char* hex; } uints[] = {
+        {0, "00"}, {23, "17"}, {24, "1818"}, {100, "1864"}, {1000, "1903e8"},
+        {1000000, "1a000f4240"}, {1000000000000ULL, "1b000000e8d4a51000"},
+        {UINT64_MAX, "1bffffffffffffffff"}
+    };
+    static const struct { int64_t value; const char* hex; } ints[] = {
+        {-1, "20"}, {-10, "29"}, {-100, "3863"}, {-1000, "3903e7"},
+        {INT64_MIN, "3b7fffffffffffffff"}
+    };
+    static const struct { double value; const char* hex; } floats[] = {
+        {0.0, "f90000"}, {-0.0, "f98000"}, {1.0, "f93c00"}, {1.1, "fb3ff199999999999a"},
+        {1.5, "f93e00"}, {65504.0, "f97bff"}, {100000.0, "fa47c35000"},
+        {3.4028234663852886e+38, "fa7f7fffff"}, {1.0e+300, "fb7e37e43c8800759c"},
+        {5.960464477539063e-8, "f90001"}, {0.00006103515625, "f90400"}, {-4.0, "f9c400"},
+        {-4.1, "fbc010666666666666"}
+    };
+
+    uint8_t buf[64];
+    cbor_writer_t writer;
+
+    for (size_t i = 0; i < sizeof(uints) / sizeof(uints[0]); i++) {
+        cbor_writer_init(&writer, buf, sizeof(buf));
+        cbor_write_uint(&writer, uints[i].value);
+        assert_encoding(&writer, uints[i].hex);
+    }
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        cbor_writer_init(&writer, buf, sizeof(buf));
+        cbor_write_int(&writer, ints[i].value);
+        assert_encoding(&writer, ints[i].hex);
+    }
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) {
+        cbor_writer_init(&writer, buf, sizeof(buf));
+        cbor_write_double(&writer, floats[i].value);
+        assert_encoding(&writer, floats[i].hex);
+    }
+
+    cbor_writer_init(&writer, buf, sizeof(buf));
+    cbor_write_double(&writer, INFINITY);
+    cbor_write_double(&writer, NAN);
+    cbor_write_double(&writer, -INFINITY);
+    cbor_write_bool(&writer, false);
+    cbor_write_bool(&writer, true);
+    cbor_write_null(&writer);
+    assert_encoding(&writer, "f97c00f97e00f9fc00f4f5f6");
+
+    cbor_writer_init(&writer, buf, sizeof(buf));
+    cbor_write_text(&writer, "", 0);
+    cbor_write_text(&writer, "IETF", 4);
+    cbor_write_bytes(&writer, (const uint8_t*)"\x01\x02\x03\x04", 4);
+    cbor_write_tag(&writer, 1);
+    cbor_write_uint(&writer, 1363896240);
+    assert_encoding(&writer, "6064494554464401020304c11a514b67b0");
+
+    printf("  ✓ Scalar encoding test passed\n");
+}
+
+static void test_cbor_write_containers(void) {
+    printf("Testing CBOR container encoding...\n");
+
+    uint8_t buf[64];
+    cbor_writer_t writer;
+
+    /* {"a": 1, "b": [2, 3]} */
+    cbor_writer_init(&writer, buf, sizeof(buf));
+    cbor_write_map(&writer, 2);
+    cbor_write_text(&writer, "a", 1);
+    cbor_write_uint(&writer, 1);
+    cbor_write_text(&writer, "b", 1);
+    cbor_write_array(&writer, 2);
+    cbor_write_uint(&writer, 2);
+    cbor_write_uint(&writer, 3);
+    assert_encoding(&writer, "a26161016162820203");
+
+    /* [_ 1, [2, 3], [_ 4, 5]] */
+    cbor_writer_init(&writer, buf, sizeof(buf));
+    cbor_write_array_indefinite(&writer);
+    cbor_write_uint(&writer, 1);
+    cbor_write_array(&writer, 2);
+    cbor_write_uint(&writer, 2);
+    cbor_write_uint(&writer, 3);
+    cbor_write_array_indefinite(&writer);
+    cbor_write_uint(&writer, 4);
+    cbor_write_uint(&writer, 5);
+    cbor_write_break(&writer);
+    cbor_write_break(&writer);
+    assert_encoding(&writer, "9f018202039f0405ffff");
+
+    /* 25 items need a one-byte count */
+    cbor_writer_init(&writer, buf, sizeof(buf));
+    cbor_write_array(&writer, 25);
+    assert_encoding(&writer, "9819");
+
+    /* Fixed-width heads for later patching */
+    cbor_writer_init(&writer, buf, sizeof(buf));
+    cbor_write_head_fixed(&writer, CBOR_MAJOR_MAP, 3, 2);
+    assert_encoding(&writer, "b90003");
+    assert(cbor_head_size(23) == 1);
+    assert(cbor_head_size(24) == 2);
+    assert(cbor_head_size(65536) == 5);
+    assert(cbor_head_size(UINT64_MAX) == 9);
+
+    printf("  ✓ Container encoding test passed\n");
+}
+
+static void test_cbor_write_overflow(void) {
+    printf("Testing CBOR writer overflow...\n");
+
+    uint8_t buf[4];
+    cbor_writer_t writer;
+
+    /* Measuring with no buffer */
+    cbor_writer_init(&writer, NULL, 0);
+    cbor_write_text(&writer, "IETF", 4);
+    assert(cbor_writer_result(&writer) == (paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL);
+    assert(writer.len == 5);
+
+    /* Items after an overflow are measured, never written */
+    cbor_writer_init(&writer, buf, sizeof(buf));
+    cbor_write_uint(&writer, 1);
+    cbor_write_text(&writer, "IETF", 4);
+    cbor_write_uint(&writer, 2);
+    assert(writer.overflow);
+    assert(writer.len == 7);
+    assert(buf[0] == 0x01);
+
+    printf("  ✓ Writer overflow test passed\n");
+}
+
+static void test_cbor_read(void) {
+    printf("Testing CBOR decoding...\n");
+
+    uint8_t buf[64];
+    size_t n = from_hex("1bffffffffffffffff3903e7f93e00fa47c35000fb7e37e43c8800759c"
+                        "f90001f97c00f4f5f6f7f0f8ff6449455446", buf);
+    cbor_reader_t reader;
+    cbor_item_t item;
+    cbor_reader_init(&reader, buf, n);
+
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(item.type == CBOR_TYPE_UINT && item.value == UINT64_MAX);
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(item.type == CBOR_TYPE_NEGINT && item.value == 999);
+
+    static const double numbers[] = {1.5, 100000.0, 1.0e+300, 5.960464477539063e-8, INFINITY};
+    for (size_t i = 0; i < 5; i++) {
+        assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+        assert(item.type == CBOR_TYPE_FLOAT);
+        assert(item.number == numbers[i]);
+    }
+
+    static const cbor_type_t simple[] = {
+        CBOR_TYPE_FALSE, CBOR_TYPE_TRUE, CBOR_TYPE_NULL, CBOR_TYPE_UNDEFINED, CBOR_TYPE_SIMPLE,
+        CBOR_TYPE_SIMPLE
+    };
+    for (size_t i = 0; i < 6; i++) {
+        assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+        assert(item.type == simple[i]);
+    }
+    assert(item.value == 255);
+
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(item.type == CBOR_TYPE_TEXT && item.value == 4);
+    assert(memcmp(item.data, "IETF", 4) == 0);
+    assert(cbor_reader_next(&reader, &item) == (paumiot_result_t)SENSOR_MANAGER_ERROR_NO_DATA);
+
+    /* Round trip through the writer */
+    uint8_t out[16];
+    cbor_writer_t writer;
+    cbor_writer_init(&writer, out, sizeof(out));
+    cbor_write_double(&writer, 23.45);
+    cbor_write_int(&writer, -42);
+    cbor_reader_init(&reader, out, writer.len);
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(item.type == CBOR_TYPE_FLOAT && item.number == 23.45);
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(item.type == CBOR_TYPE_NEGINT && item.value == 41);
+
+    printf("  ✓ Decoding test passed\n");
+}
+
+static void test_cbor_skip(void) {
+    printf("Testing CBOR item skipping...\n");
+
+    /* {"a": [_ 1, {"x": (_ h'0102', h'03')}], "b": 2}, then 7 */
+    uint8_t buf[64];
+    size_t n = from_hex("a261619f01a161785f4201024103ffff61620207", buf);
+
+    cbor_reader_t reader;
+    cbor_item_t item;
+    cbor_reader_init(&reader, buf, n);
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(item.type == CBOR_TYPE_MAP && item.value == 2);
+    assert(cbor_reader_skip(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(item.type == CBOR_TYPE_UINT && item.value == 7);
+
+    /* Tagged scalars and empty containers are complete immediately */
+    n = from_hex("c11a514b67b080a0", buf);
+    cbor_reader_init(&reader, buf, n);
+    for (int i = 0; i < 3; i++) {
+        assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+        assert(cbor_reader_skip(&reader, &item) == PAUMIOT_SUCCESS);
+    }
+    assert(reader.pos == n);
+
+    /* Truncated container */
+    n = from_hex("83010203", buf);
+    cbor_reader_init(&reader, buf, n - 1);
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(cbor_reader_skip(&reader, &item) == (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED);
+
+    printf("  ✓ Skip test passed\n");
+}
+
+static void test_cbor_malformed(void) {
+    printf("Testing malformed CBOR...\n");
+
+    static const char* cases[] = {
+        "18",               /* Missing argument byte */
+        "1c",               /* Reserved additional information */
+        "1f",               /* Indefinite unsigned integer */
+        "dfff",             /* Indefinite tag */
+        "6461",             /* Text shorter than its length */
+        "f801",             /* Two-byte simple value below 32 */
+        "5bffffffffffffffff00" /* Length beyond the input */
+    };
+
+    uint8_t buf[16];
+    cbor_reader_t reader;
+    cbor_item_t item;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        size_t n = from_hex(cases[i], buf);
+        cbor_reader_init(&reader, buf, n);
+        assert(cbor_reader_next(&reader, &item) == (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED);
+    }
+
+    /* Break outside an indefinite-length item */
+    size_t n = from_hex("81ff", buf);
+    cbor_reader_init(&reader, buf, n);
+    assert(cbor_reader_next(&reader, &item) == PAUMIOT_SUCCESS);
+    assert(cbor_reader_skip(&reader, &item) == (paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED);
+
+    printf("  ✓ Malformed input test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running sensor_cbor.h tests...\n");
+    printf("========================================\n\n");
+
+    test_cbor_write_scalars();
+    test_cbor_write_containers();
+    test_cbor_write_overflow();
+    test_cbor_read();
+    test_cbor_skip();
+    test_cbor_malformed();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
@@ -0,0 +1,309 @@
+/**
+ * @file test_sensor_codec.c
+ * @brief Unit tests for JSON/CBOR transcoding and format routes
+ */
+
+#include "sensor_manager/sensor_codec.h"
+#include "sensor_manager/sensor_cbor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define MALFORMED ((paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED)
+#define TOO_SMALL ((paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL)
+
+static size_t from_hex(const char* hex, uint8_t* out) {
+    size_t n = 0;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned byte;
+        sscanf(hex, "%2x", &byte);
+        out[n++] = (uint8_t)byte;
+    }
+    return n;
+}
+
+static void assert_json_to_cbor(const char* json, const char* hex) {
+    uint8_t expected[256];
+    uint8_t out[256];
+    size_t n = from_hex(hex, expected);
+    size_t out_len = 0;
+
+    assert(sensor_codec_json_to_cbor(json, strlen(json), out, sizeof(out), &out_len) ==
+           PAUMIOT_SUCCESS);
+    assert(out_len == n);
+    assert(memcmp(out, expected, n) == 0);
+}
+
+static void assert_cbor_to_json(const char* hex, const char* json) {
+    uint8_t in[256];
+    char out[256];
+    size_t n = from_hex(hex, in);
+    size_t out_len = 0;
+
+    assert(sensor_codec_cbor_to_json(in, n, out, sizeof(out), &out_len) == PAUMIOT_SUCCESS);
+    assert(out_len == strlen(json));
+    assert(memcmp(out, json, out_len) == 0);
+}
+
+static paumiot_result_t json_to_cbor(const char* json) {
+    uint8_t out[256];
+    size_t out_len;
+    return sensor_codec_json_to_cbor(json, strlen(json), out, sizeof(out), &out_len);
+}
+
+static void test_codec_json_to_cbor(void) {
+    printf("Testing JSON to CBOR...\n");
+
+    assert_json_to_cbor("{\"a\": 1, \"b\": [2, 3]}", "a26161016162820203");
+    assert_json_to_cbor("[]", "80");
+    assert_json_to_cbor(" { } ", "a0");
+    assert_json_to_cbor("[true,false,null]", "83f5f4f6");
+
+    /* Integers, shortest floats, and the edges of the 64-bit range */
+    assert_json_to_cbor("[0,-1,1000,-1000,23.5,-0,1.1,1500e0]",
+                        "880020" "1903e8" "3903e7" "f94de0" "f98000" "fb3ff199999999999a" "f965dc");
+    assert_json_to_cbor("[18446744073709551615,-18446744073709551616]",
+                        "821bffffffffffffffff3bffffffffffffffff");
+    assert_json_to_cbor("18446744073709551616", "fa5f800000");
+    assert_json_to_cbor("1e400", "f97c00");
+
+    /* Escapes, including a surrogate pair */
+    assert_json_to_cbor("\"a\\\"b\\\\c\\/\\n\\u00e9\\ud83d\\ude00\"",
+                        "6d612262" "5c632f0a" "c3a9" "f09f9880");
+
+    /* Indented documents match compact ones */
+    const char* pretty =
+        "{\n"
+        "                    \"sensor\" :    \"t1\",\r\n"
+        "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\"value\":\n\n\n 21\n"
+        "}                                  ";
+    assert_json_to_cbor(pretty, "a266" "73656e736f72" "6274" "31" "6576616c7565" "15");
+
+    printf("  ✓ JSON to CBOR test passed\n");
+}
+
+static void test_codec_head_resizing(void) {
+    printf("Testing container and string head resizing...\n");
+
+    /* 30 elements widen the array head after the fact */
+    char json[256];
+    size_t pos = 0;
+    json[pos++] = '[';
+    for (int i = 0; i < 30; i++) {
+        pos += (size_t)sprintf(json + pos, "%s%d", i ? "," : "", i);
+    }
+    json[pos++] = ']';
+    json[pos] = '\0';
+
+    uint8_t out[256];
+    size_t out_len;
+    assert(sensor_codec_json_to_cbor(json, pos, out, sizeof(out), &out_len) == PAUMIOT_SUCCESS);
+    assert(out[0] == 0x98 && out[1] == 30);
+    assert(out[2] == 0x00 && out[25] == 0x17 && out[26] == 0x18 && out[27] == 24);
+    assert(out_len == 2 + 24 + 6 * 2);
+
+    /* 24 escaped characters decode to 12 bytes: the string head shrinks */
+    const char* escaped = "\"\\n\\n\\n\\n\\n\\n\\n\\n\\n\\n\\n\\n\"";
+    assert(sensor_codec_json_to_cbor(escaped, strlen(escaped), out, sizeof(out), &out_len) ==
+           PAUMIOT_SUCCESS);
+    assert(out_len == 13);
+    assert(out[0] == 0x6c && out[1] == '\n' && out[12] == '\n');
+
+    /* Measuring reports the widened size */
+    assert(sensor_codec_json_to_cbor(json, pos, NULL, 0, &out_len) == TOO_SMALL);
+    assert(out_len == 2 + 24 + 6 * 2);
+
+    printf("  ✓ Head resizing test passed\n");
+}
+
+static void test_codec_json_malformed(void) {
+    printf("Testing malformed JSON...\n");
+
+    static const char* cases[] = {
+        "", " ", "{", "[1,]", "{\"a\"}", "{\"a\":1,}", "{1:2}", "tru", "nul", "01",
+        "-", "1.", "1e", "+1", "\"abc", "\"a\x01\"", "\"\\x\"", "\"\\u12\"", "\"\\udc00\"",
+        "\"\\ud83d\"", "{} x", "[1 2]", "{\"a\" 1}"
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        assert(json_to_cbor(cases[i]) == MALFORMED);
+    }
+
+    /* Nesting limit */
+    char deep[2 * SENSOR_CODEC_MAX_DEPTH + 3];
+    memset(deep, '[', SENSOR_CODEC_MAX_DEPTH);
+    memset(deep + SENSOR_CODEC_MAX_DEPTH, ']', SENSOR_CODEC_MAX_DEPTH);
+    deep[2 * SENSOR_CODEC_MAX_DEPTH] = '\0';
+    assert(json_to_cbor(deep) == PAUMIOT_SUCCESS);
+
+    memset(deep, '[', SENSOR_CODEC_MAX_DEPTH + 1);
+    memset(deep + SENSOR_CODEC_MAX_DEPTH + 1, ']', SENSOR_CODEC_MAX_DEPTH + 1);
+    deep[2 * SENSOR_CODEC_MAX_DEPTH + 2] = '\0';
+    assert(json_to_cbor(deep) == PAUMIOT_ERROR_NOT_SUPPORTED);
+
+    printf("  ✓ Malformed JSON test passed\n");
+}
+
+static void test_codec_cbor_to_json(void) {
+    printf("Testing CBOR to JSON...\n");
+
+    assert_cbor_to_json("a26161016162820203", "{\"a\":1,\"b\":[2,3]}");
+    assert_cbor_to_json("9f018202039f0405ffff", "[1,[2,3],[4,5]]");
+    assert_cbor_to_json("bf6346756ef563416d7421ff", "{\"Fun\":true,\"Amt\":-2}");
+    assert_cbor_to_json("80", "[]");
+    assert_cbor_to_json("a0", "{}");
+    assert_cbor_to_json("8180", "[[]]");
+
+    /* Numbers */
+    assert_cbor_to_json("1bffffffffffffffff", "18446744073709551615");
+    assert_cbor_to_json("3bffffffffffffffff", "-18446744073709551616");
+    assert_cbor_to_json("3903e7", "-1000");
+    assert_cbor_to_json("f93c00", "1.0");
+    assert_cbor_to_json("fb3ff199999999999a", "1.1");
+    assert_cbor_to_json("fb7e37e43c8800759c", "1e+300");
+    assert_cbor_to_json("f94de0", "23.5");
+    assert_cbor_to_json("83f97c00f97e00f7", "[null,null,null]");
+
+    /* Strings: escaping, byte strings as base64url, chunks */
+    assert_cbor_to_json("6761220a5c01c3a9", "\"a\\\"\\n\\\\\\u0001\xc3\xa9\"");
+    assert_cbor_to_json("42fbff", "\"-_8\"");
+    assert_cbor_to_json("5f4101420203ff", "\"AQID\"");
+    assert_cbor_to_json("7f657374726561646d696e67ff", "\"streaming\"");
+
+    /* Tags are dropped; integer keys become strings */
+    assert_cbor_to_json("c11a514b67b0", "1363896240");
+    assert_cbor_to_json("a2016161206162", "{\"1\":\"a\",\"-1\":\"b\"}");
+
+    printf("  ✓ CBOR to JSON test passed\n");
+}
+
+static void test_codec_cbor_malformed(void) {
+    printf("Testing malformed CBOR input...\n");
+
+    static const char* malformed[] = {
+        "", "83010203ff", "8301", "a161", "ff", "bf6161ff", "5f01ff", "7f4161ff", "0000"
+    };
+
+    uint8_t in[64];
+    char out[64];
+    size_t out_len;
+
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+        size_t n = from_hex(malformed[i], in);
+        assert(sensor_codec_cbor_to_json(in, n, out, sizeof(out), &out_len) == MALFORMED);
+    }
+
+    /* Keys with no JSON form */
+    size_t n = from_hex("a18000", in);
+    assert(sensor_codec_cbor_to_json(in, n, out, sizeof(out), &out_len) ==
+           PAUMIOT_ERROR_NOT_SUPPORTED);
+
+    /* Measuring */
+    n = from_hex("a26161016162820203", in);
+    assert(sensor_codec_cbor_to_json(in, n, NULL, 0, &out_len) == TOO_SMALL);
+    assert(out_len == strlen("{\"a\":1,\"b\":[2,3]}"));
+    assert(sensor_codec_cbor_to_json(in, n, out, out_len, &out_len) == PAUMIOT_SUCCESS);
+
+    printf("  ✓ Malformed CBOR test passed\n");
+}
+
+static void test_codec_round_trip(void) {
+    printf("Testing sensor document round trip...\n");
+
+    const char* doc = "{\"sensor\":\"greenhouse/temp-01\",\"ts\":1700000000123,"
+                      "\"value\":23.45,\"unit\":\"C\",\"battery\":0.5,\"ok\":true,"
+                      "\"samples\":[23.5,23.25,-4.0],\"meta\":{\"fw\":\"1.2.3\",\"rssi\":-71}}";
+    size_t doc_len = strlen(doc);
+
+    uint8_t cbor[256];
+    size_t cbor_len;
+    assert(sensor_codec_transcode(DATA_FORMAT_JSON, DATA_FORMAT_CBOR, (const uint8_t*)doc,
+                                  doc_len, cbor, sizeof(cbor), &cbor_len) == PAUMIOT_SUCCESS);
+
+    char json[256];
+    size_t json_len;
+    assert(sensor_codec_transcode(DATA_FORMAT_CBOR, DATA_FORMAT_JSON, cbor, cbor_len,
+                                  (uint8_t*)json, sizeof(json), &json_len) == PAUMIOT_SUCCESS);
+    assert(json_len == doc_len);
+    assert(memcmp(json, doc, doc_len) == 0);
+
+    printf("  %zu bytes of JSON -> %zu bytes of CBOR (%.0f%% smaller)\n",
+           doc_len, cbor_len, 100.0 * (1.0 - (double)cbor_len / (double)doc_len));
+    assert(cbor_len * 4 < doc_len * 3);
+
+    /* Same-format copies and unsupported conversions */
+    uint8_t copy[8];
+    size_t copy_len;
+    assert(sensor_codec_transcode(DATA_FORMAT_RAW, DATA_FORMAT_RAW, (const uint8_t*)"abc", 3,
+                                  copy, sizeof(copy), &copy_len) == PAUMIOT_SUCCESS);
+    assert(copy_len == 3 && memcmp(copy, "abc", 3) == 0);
+    assert(sensor_codec_transcode(DATA_FORMAT_RAW, DATA_FORMAT_RAW, (const uint8_t*)"abc", 3,
+                                  copy, 2, &copy_len) == TOO_SMALL);
+    assert(sensor_codec_transcode(DATA_FORMAT_RAW, DATA_FORMAT_JSON, (const uint8_t*)"abc", 3,
+                                  copy, sizeof(copy), &copy_len) == PAUMIOT_ERROR_NOT_SUPPORTED);
+    assert(sensor_codec_transcode(DATA_FORMAT_JSON, DATA_FORMAT_PROTOBUF, (const uint8_t*)"1", 1,
+                                  copy, sizeof(copy), &copy_len) == PAUMIOT_ERROR_NOT_SUPPORTED);
+
+    printf("  ✓ Round trip test passed\n");
+}
+
+static void test_codec_routes(void) {
+    printf("Testing format routes...\n");
+
+    sensor_codec_routes_t* routes = sensor_codec_routes_create();
+    assert(routes != NULL);
+
+    assert(sensor_codec_routes_add(routes, "coap/+/telemetry", DATA_FORMAT_CBOR) == PAUMIOT_SUCCESS);
+    assert(sensor_codec_routes_add(routes, "coap/#", DATA_FORMAT_JSON) == PAUMIOT_SUCCESS);
+    assert(sensor_codec_routes_add(routes, "legacy/{site}/raw", DATA_FORMAT_RAW) == PAUMIOT_SUCCESS);
+    assert(sensor_codec_routes_add(routes, NULL, DATA_FORMAT_CBOR) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(sensor_codec_routes_add(routes, "x", (data_format_t)9) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    /* First match wins */
+    assert(sensor_codec_routes_format(routes, "coap/gh1/telemetry", DATA_FORMAT_JSON) ==
+           DATA_FORMAT_CBOR);
+    assert(sensor_codec_routes_format(routes, "coap/gh1/config", DATA_FORMAT_CBOR) ==
+           DATA_FORMAT_JSON);
+    assert(sensor_codec_routes_format(routes, "legacy/north/raw", DATA_FORMAT_JSON) ==
+           DATA_FORMAT_RAW);
+
+    /* No route: delivered as published */
+    assert(sensor_codec_routes_format(routes, "mqtt/gh1/telemetry", DATA_FORMAT_JSON) ==
+           DATA_FORMAT_JSON);
+    assert(sensor_codec_routes_format(NULL, "coap/gh1/telemetry", DATA_FORMAT_JSON) ==
+           DATA_FORMAT_JSON);
+
+    /* Grows past its initial capacity */
+    char filter[32];
+    for (int i = 0; i < 20; i++) {
+        snprintf(filter, sizeof(filter), "bulk/%d", i);
+        assert(sensor_codec_routes_add(routes, filter, DATA_FORMAT_CBOR) == PAUMIOT_SUCCESS);
+    }
+    assert(sensor_codec_routes_format(routes, "bulk/19", DATA_FORMAT_JSON) == DATA_FORMAT_CBOR);
+
+    sensor_codec_routes_destroy(routes);
+    sensor_codec_routes_destroy(NULL);
+
+    printf("  ✓ Routes test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running sensor_codec.h tests...\n");
+    printf("========================================\n\n");
+
+    test_codec_json_to_cbor();
+    test_codec_head_resizing();
+    test_codec_json_malformed();
+    test_codec_cbor_to_json();
+    test_codec_cbor_malformed();
+    test_codec_round_trip();
+    test_codec_routes();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
@@ -0,0 +1,530 @@
+/**
+ * @file test_sensor_compress.c
+ * @brief Unit tests for payload compression, dictionaries and frames
+ */
+
+#include "sensor_manager/sensor_compress.h"
+#include "sensor_manager/sensor_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define MALFORMED ((paumiot_result_t)SENSOR_MANAGER_ERROR_MALFORMED)
+#define TOO_SMALL ((paumiot_result_t)SENSOR_MANAGER_ERROR_BUFFER_TOO_SMALL)
+
+#define NUM_SAMPLES 200
+
+/* Sensor telemetry like the backhaul carries */
+static size_t make_payload(char *buf, size_t size, int i) {
+    static const char *units[] = { "C", "%RH", "hPa", "lx" };
+    return (size_t)snprintf(buf, size,
+                            "{\"sensor\":\"greenhouse-%d/probe-%02d\",\"ts\":%llu,"
+                            "\"value\":%d.%02d,\"unit\":\"%s\",\"battery\":%d,\"status\":\"ok\"}",
+                            i % 7, i % 13, 1700000000000ull + (unsigned long long)i * 997,
+                            (i * 37) % 100, (i * 11) % 100, units[i % 4], 100 - i % 50);
+}
+
+static void assert_lz4_round_trip(const uint8_t *in, size_t len,
+                                  const sensor_compress_dict_t *dict) {
+    size_t bound = sensor_compress_lz4_bound(len);
+    uint8_t *compressed = malloc(bound);
+    uint8_t *decoded = malloc(len + 1);
+    size_t compressed_len, decoded_len;
+
+    assert(compressed && decoded);
+    assert(sensor_compress_lz4(in, len, dict, compressed, bound, &compressed_len) ==
+           PAUMIOT_SUCCESS);
+    assert(compressed_len <= bound);
+    assert(sensor_decompress_lz4(compressed, compressed_len, dict, decoded, len + 1,
+                                 &decoded_len) == PAUMIOT_SUCCESS);
+    assert(decoded_len == len);
+    assert(len == 0 || memcmp(decoded, in, len) == 0);
+
+    /* One byte short of the output is detected, not overrun */
+    if (len > 0) {
+        assert(sensor_decompress_lz4(compressed, compressed_len, dict, decoded, len - 1,
+                                     &decoded_len) == TOO_SMALL);
+    }
+
+    free(compressed);
+    free(decoded);
+}
+
+static void test_lz4_round_trip(void) {
+    printf("Testing LZ4 round trip...\n");
+
+    assert_lz4_round_trip((const uint8_t *)"", 0, NULL);
+    assert_lz4_round_trip((const uint8_t *)"short", 5, NULL);
+    assert_lz4_round_trip((const uint8_t *)"abcdefghijklm", 13, NULL);
+
+    /* Long runs exercise overlapping copies and extended lengths */
+    uint8_t run[1000];
+    memset(run, 'a', sizeof(run));
+    assert_lz4_round_trip(run, sizeof(run), NULL);
+
+    size_t len = 200000;
+    uint8_t *data = malloc(len);
+    assert(data != NULL);
+
+    /* Pseudo-random: incompressible */
+    uint32_t state = 12345;
+    for (size_t i = 0; i < len; i++) {
+        state = state * 1103515245u + 12345u;
+        data[i] = (uint8_t)(state >> 24);
+    }
+    assert_lz4_round_trip(data, len, NULL);
+
+    /* Text beyond the 64 KiB window */
+    size_t pos = 0;
+    for (int i = 0; pos + 200 < len; i++) {
+        pos += make_payload((char *)data + pos, len - pos, i);
+    }
+    assert_lz4_round_trip(data, pos, NULL);
+
+    size_t compressed_len;
+    uint8_t *compressed = malloc(sensor_compress_lz4_bound(pos));
+    assert(sensor_compress_lz4(data, pos, NULL, compressed, sensor_compress_lz4_bound(pos),
+                               &compressed_len) == PAUMIOT_SUCCESS);
+    assert(compressed_len < pos / 3);
+
+    /* A short output buffer fails cleanly */
+    assert(sensor_compress_lz4(data, pos, NULL, compressed, 100, &compressed_len) == TOO_SMALL);
+
+    free(compressed);
+    free(data);
+
+    printf("  ✓ LZ4 round trip test passed\n");
+}
+
+static void test_lz4_block_format(void) {
+    printf("Testing LZ4 block format...\n");
+
+    /* "abc" then a 15-byte match at offset 3, then "hello" */
+    static const uint8_t block[] = { 0x3b, 'a', 'b', 'c', 0x03, 0x00,
+                                     0x50, 'h', 'e', 'l', 'l', 'o' };
+    uint8_t out[64];
+    size_t out_len;
+
+    assert(sensor_decompress_lz4(block, sizeof(block), NULL, out, sizeof(out), &out_len) ==
+           PAUMIOT_SUCCESS);
+    assert(out_len == 23);
+    assert(memcmp(out, "abcabcabcabcabcabchello", 23) == 0);
+
+    /* Malformed blocks */
+    static const uint8_t zero_offset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+    static const uint8_t far_offset[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+    static const uint8_t short_literals[] = { 0x50, 'a', 'b' };
+    static const uint8_t short_length[] = { 0xf0, 0xff };
+    static const uint8_t short_offset[] = { 0x10, 'a', 0x01 };
+    static const uint8_t no_final[] = { 0x10, 'a', 0x01, 0x00 };
+
+    assert(sensor_decompress_lz4(zero_offset, sizeof(zero_offset), NULL, out, sizeof(out),
+                                 &out_len) == MALFORMED);
+    assert(sensor_decompress_lz4(far_offset, sizeof(far_offset), NULL, out, sizeof(out),
+                                 &out_len) == MALFORMED);
+    assert(sensor_decompress_lz4(short_literals, sizeof(short_literals), NULL, out, sizeof(out),
+                                 &out_len) == MALFORMED);
+    assert(sensor_decompress_lz4(short_length, sizeof(short_length), NULL, out, sizeof(out),
+                                 &out_len) == MALFORMED);
+    assert(sensor_decompress_lz4(short_offset, sizeof(short_offset), NULL, out, sizeof(out),
+                                 &out_len) == MALFORMED);
+    assert(sensor_decompress_lz4(no_final, sizeof(no_final), NULL, out, sizeof(out),
+                                 &out_len) == MALFORMED);
+    assert(sensor_decompress_lz4(block, 0, NULL, out, sizeof(out), &out_len) == MALFORMED);
+
+    printf("  ✓ LZ4 block format test passed\n");
+}
+
+static void test_lz4_dictionary(void) {
+    printf("Testing LZ4 with a dictionary...\n");
+
+    assert(sensor_compress_dict_create(NULL, 4) == NULL);
+    assert(sensor_compress_dict_create((const uint8_t *)"x", 0) == NULL);
+
+    /* A match that starts in the dictionary and continues into the input */
+    const char *text = "the quick brown fox jumps over the lazy dog";
+    sensor_compress_dict_t *dict = sensor_compress_dict_create((const uint8_t *)text, 20);
+    assert(dict != NULL);
+
+    size_t len;
+    const uint8_t *contents = sensor_compress_dict_data(dict, &len);
+    assert(len == 20 && memcmp(contents, text, 20) == 0);
+    assert(sensor_compress_dict_id(dict) != 0);
+
+    const char *input = "brown fox brown fox brown fox jumps";
+    assert_lz4_round_trip((const uint8_t *)input, strlen(input), dict);
+
+    uint8_t compressed[128];
+    size_t compressed_len;
+    assert(sensor_compress_lz4((const uint8_t *)input, strlen(input), dict, compressed,
+                               sizeof(compressed), &compressed_len) == PAUMIOT_SUCCESS);
+    assert(compressed_len < strlen(input) / 2);
+
+    /* Decoding without the dictionary fails */
+    uint8_t out[128];
+    assert(sensor_decompress_lz4(compressed, compressed_len, NULL, out, sizeof(out), &len) ==
+           MALFORMED);
+
+    sensor_compress_dict_destroy(dict);
+    sensor_compress_dict_destroy(NULL);
+
+    printf("  ✓ LZ4 dictionary test passed\n");
+}
+
+static void test_dictionary_training(void) {
+    printf("Testing dictionary training...\n");
+
+    char payloads[NUM_SAMPLES + 1][256];
+    const uint8_t *samples[NUM_SAMPLES];
+    size_t sizes[NUM_SAMPLES];
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        sizes[i] = make_payload(payloads[i], sizeof(payloads[i]), i);
+        samples[i] = (const uint8_t *)payloads[i];
+    }
+
+    assert(sensor_compress_dict_train(NULL, sizes, NUM_SAMPLES, 1024) == NULL);
+    assert(sensor_compress_dict_train(samples, sizes, NUM_SAMPLES, 0) == NULL);
+    assert(sensor_compress_dict_train(samples, sizes, NUM_SAMPLES,
+                                      SENSOR_COMPRESS_MAX_DICT_SIZE + 1) == NULL);
+
+    sensor_compress_dict_t *dict = sensor_compress_dict_train(samples, sizes, NUM_SAMPLES, 1024);
+    assert(dict != NULL);
+
+    size_t dict_len;
+    sensor_compress_dict_data(dict, &dict_len);
+    assert(dict_len > 0 && dict_len <= 1024);
+
+    /* Training is deterministic */
+    sensor_compress_dict_t *again = sensor_compress_dict_train(samples, sizes, NUM_SAMPLES, 1024);
+    assert(sensor_compress_dict_id(again) == sensor_compress_dict_id(dict));
+    sensor_compress_dict_destroy(again);
+
+    /* An unseen payload compresses far better with the dictionary */
+    size_t len = make_payload(payloads[NUM_SAMPLES], sizeof(payloads[NUM_SAMPLES]), 4242);
+    const uint8_t *payload = (const uint8_t *)payloads[NUM_SAMPLES];
+    uint8_t out[512];
+    size_t plain_len, dict_out_len;
+
+    assert(sensor_compress_lz4(payload, len, NULL, out, sizeof(out), &plain_len) ==
+           PAUMIOT_SUCCESS);
+    assert(sensor_compress_lz4(payload, len, dict, out, sizeof(out), &dict_out_len) ==
+           PAUMIOT_SUCCESS);
+    assert_lz4_round_trip(payload, len, dict);
+
+    printf("  %zu-byte payload: %zu bytes plain LZ4, %zu bytes with a %zu-byte dictionary\n",
+           len, plain_len, dict_out_len, dict_len);
+    assert(dict_out_len * 2 < len);
+    assert(dict_out_len * 3 < plain_len * 2);
+
+    /* Nothing in common: no dictionary */
+    const uint8_t *distinct[] = { (const uint8_t *)"0123456789abcdef",
+                                  (const uint8_t *)"ghijklmnopqrstuv" };
+    size_t distinct_sizes[] = { 16, 16 };
+    assert(sensor_compress_dict_train(distinct, distinct_sizes, 2, 1024) == NULL);
+
+    sensor_compress_dict_destroy(dict);
+
+    printf("  ✓ Dictionary training test passed\n");
+}
+
+static paumiot_result_t copy_compress(const uint8_t *in, size_t len,
+                                      const sensor_compress_dict_t *dict,
+                                      uint8_t *out, size_t capacity, size_t *out_len) {
+    (void)dict;
+    if (len < 2 || capacity < len / 2) {
+        return TOO_SMALL;
+    }
+    /* Keeps every other byte: only for payloads of repeated pairs */
+    for (size_t i = 0; i < len / 2; i++) {
+        out[i] = in[2 * i];
+    }
+    *out_len = len / 2;
+    return PAUMIOT_SUCCESS;
+}
+
+static paumiot_result_t copy_decompress(const uint8_t *in, size_t len,
+                                        const sensor_compress_dict_t *dict,
+                                        uint8_t *out, size_t capacity, size_t *out_len) {
+    (void)dict;
+    if (capacity < len * 2) {
+        return TOO_SMALL;
+    }
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = out[2 * i + 1] = in[i];
+    }
+    *out_len = len * 2;
+    return PAUMIOT_SUCCESS;
+}
+
+static void test_codec_registry(void) {
+    printf("Testing codec registry...\n");
+
+    assert(sensor_compress_available(SENSOR_COMPRESSION_NONE));
+    assert(sensor_compress_available(SENSOR_COMPRESSION_LZ4));
+    assert(sensor_compress_available(SENSOR_COMPRESSION_LZ4_DICT));
+    assert(!sensor_compress_available(SENSOR_COMPRESSION_ZSTD));
+    assert(!sensor_compress_available(SENSOR_COMPRESSION_MAX));
+
+    assert(strcmp(sensor_compress_encoding(SENSOR_COMPRESSION_NONE), "identity") == 0);
+    assert(strcmp(sensor_compress_encoding(SENSOR_COMPRESSION_LZ4), "lz4") == 0);
+    assert(sensor_compress_encoding(SENSOR_COMPRESSION_ZSTD) == NULL);
+
+    static const sensor_compress_codec_t pairs = {
+        "pairs", false, copy_compress, copy_decompress
+    };
+    static const sensor_compress_codec_t incomplete = { "broken", false, NULL, NULL };
+
+    assert(sensor_compress_register(SENSOR_COMPRESSION_NONE, &pairs) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(sensor_compress_register(SENSOR_COMPRESSION_ZSTD, &incomplete) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(sensor_compress_register(SENSOR_COMPRESSION_ZSTD, &pairs) == PAUMIOT_SUCCESS);
+    assert(strcmp(sensor_compress_encoding(SENSOR_COMPRESSION_ZSTD), "pairs") == 0);
+
+    sensor_compressor_t *compressor = sensor_compressor_create(64, 4);
+    uint8_t *frame, *out;
+    size_t frame_len, out_len;
+    sensor_compression_t codec;
+
+    assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_ZSTD, NULL,
+                                      (const uint8_t *)"aabbccddeeff", 12, &frame,
+                                      &frame_len) == PAUMIOT_SUCCESS);
+    assert(frame[0] == SENSOR_COMPRESSION_ZSTD && frame_len == 2 + 6);
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, &codec) ==
+           PAUMIOT_SUCCESS);
+    assert(codec == SENSOR_COMPRESSION_ZSTD && out_len == 12);
+    assert(memcmp(out, "aabbccddeeff", 12) == 0);
+    sensor_compressor_release(compressor, out);
+
+    /* Once removed, its frames can no longer be read */
+    assert(sensor_compress_register(SENSOR_COMPRESSION_ZSTD, NULL) == PAUMIOT_SUCCESS);
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, NULL) ==
+           PAUMIOT_ERROR_NOT_SUPPORTED);
+    assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_ZSTD, NULL,
+                                      (const uint8_t *)"aa", 2, &out, &out_len) ==
+           PAUMIOT_ERROR_NOT_SUPPORTED);
+    sensor_compressor_release(compressor, frame);
+
+    /* Failed calls hand their buffers back */
+    uint8_t *held[4];
+    for (int i = 0; i < 4; i++) {
+        assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_NONE, NULL,
+                                          (const uint8_t *)"a", 1, &held[i], &frame_len) ==
+               PAUMIOT_SUCCESS);
+    }
+    for (int i = 0; i < 4; i++) {
+        sensor_compressor_release(compressor, held[i]);
+    }
+    sensor_compressor_destroy(compressor);
+
+    printf("  ✓ Codec registry test passed\n");
+}
+
+static void test_compressor_frames(void) {
+    printf("Testing compressor frames...\n");
+
+    assert(sensor_compressor_create(0, 4) == NULL);
+    assert(sensor_compressor_create(256, 0) == NULL);
+
+    sensor_compressor_t *compressor = sensor_compressor_create(256, 2);
+    assert(compressor != NULL);
+
+    char payload[256];
+    size_t len = make_payload(payload, sizeof(payload), 7);
+    char repeated[256];
+    memset(repeated, 'x', 200);
+
+    uint8_t *frame, *out;
+    size_t frame_len, out_len;
+    sensor_compression_t codec;
+
+    /* Compressible: LZ4 frame, varint length 200 = c8 01 */
+    assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_LZ4, NULL,
+                                      (const uint8_t *)repeated, 200, &frame, &frame_len) ==
+           PAUMIOT_SUCCESS);
+    assert(frame[0] == SENSOR_COMPRESSION_LZ4 && frame[1] == 0xc8 && frame[2] == 0x01);
+    assert(frame_len < 20);
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, &codec) ==
+           PAUMIOT_SUCCESS);
+    assert(codec == SENSOR_COMPRESSION_LZ4 && out_len == 200);
+    assert(memcmp(out, repeated, 200) == 0);
+
+    /* Both buffers are in use */
+    uint8_t *extra;
+    size_t extra_len;
+    assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_NONE, NULL,
+                                      (const uint8_t *)"a", 1, &extra, &extra_len) ==
+           PAUMIOT_ERROR_OUT_OF_MEMORY);
+    sensor_compressor_release(compressor, frame);
+    sensor_compressor_release(compressor, out);
+    sensor_compressor_release(compressor, NULL);
+
+    /* Incompressible: stored */
+    assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_LZ4, NULL,
+                                      (const uint8_t *)"abcdefgh", 8, &frame, &frame_len) ==
+           PAUMIOT_SUCCESS);
+    assert(frame[0] == SENSOR_COMPRESSION_NONE && frame[1] == 8 && frame_len == 10);
+    assert(memcmp(frame + 2, "abcdefgh", 8) == 0);
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, &codec) ==
+           PAUMIOT_SUCCESS);
+    assert(codec == SENSOR_COMPRESSION_NONE && out_len == 8);
+    sensor_compressor_release(compressor, out);
+
+    /* Corrupt frames */
+    frame[1] = 9;
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, NULL) ==
+           MALFORMED);
+    frame[0] = SENSOR_COMPRESSION_MAX;
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, NULL) ==
+           MALFORMED);
+    frame[0] = SENSOR_COMPRESSION_ZSTD;
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, NULL) ==
+           PAUMIOT_ERROR_NOT_SUPPORTED);
+    static const uint8_t unterminated[] = { 0x00, 0x80, 0x80 };
+    assert(sensor_compressor_decompress(compressor, unterminated, sizeof(unterminated), &out,
+                                        &out_len, NULL) == MALFORMED);
+    static const uint8_t oversized[] = { 0x00, 0x80, 0x04 };
+    assert(sensor_compressor_decompress(compressor, oversized, sizeof(oversized), &out,
+                                        &out_len, NULL) == TOO_SMALL);
+    sensor_compressor_release(compressor, frame);
+
+    /* Length recorded in the frame must match the decoded data */
+    assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_LZ4, NULL,
+                                      (const uint8_t *)repeated, 200, &frame, &frame_len) ==
+           PAUMIOT_SUCCESS);
+    frame[1] = 0xc7;
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, NULL) ==
+           MALFORMED);
+    frame[1] = 0xc9;
+    assert(sensor_compressor_decompress(compressor, frame, frame_len, &out, &out_len, NULL) ==
+           MALFORMED);
+    sensor_compressor_release(compressor, frame);
+
+    /* Limits */
+    assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_LZ4, NULL,
+                                      (const uint8_t *)repeated, 257, &frame, &frame_len) ==
+           TOO_SMALL);
+    assert(sensor_compressor_compress(compressor, SENSOR_COMPRESSION_LZ4_DICT, NULL,
+                                      (const uint8_t *)payload, len, &frame, &frame_len) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+
+    sensor_compressor_destroy(compressor);
+    sensor_compressor_destroy(NULL);
+
+    printf("  ✓ Compressor frames test passed\n");
+}
+
+static void test_compressor_dictionary_frames(void) {
+    printf("Testing dictionary frames...\n");
+
+    char payloads[NUM_SAMPLES][256];
+    const uint8_t *samples[NUM_SAMPLES];
+    size_t sizes[NUM_SAMPLES];
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        sizes[i] = make_payload(payloads[i], sizeof(payloads[i]), i);
+        samples[i] = (const uint8_t *)payloads[i];
+    }
+    sensor_compress_dict_t *dict = sensor_compress_dict_train(samples, sizes, NUM_SAMPLES, 2048);
+    assert(dict != NULL);
+
+    sensor_compressor_t *sender = sensor_compressor_create(256, 4);
+    sensor_compressor_t *receiver = sensor_compressor_create(256, 4);
+
+    char payload[256];
+    size_t len = make_payload(payload, sizeof(payload), 9001);
+    uint8_t *frame, *out;
+    size_t frame_len, out_len;
+    sensor_compression_t codec;
+
+    assert(sensor_compressor_compress(sender, SENSOR_COMPRESSION_LZ4_DICT, dict,
+                                      (const uint8_t *)payload, len, &frame, &frame_len) ==
+           PAUMIOT_SUCCESS);
+    assert(frame[0] == SENSOR_COMPRESSION_LZ4_DICT);
+    uint32_t id = sensor_compress_dict_id(dict);
+    assert(frame[2] == (uint8_t)id && frame[5] == (uint8_t)(id >> 24));
+
+    /* The receiver has to know the dictionary */
+    assert(sensor_compressor_decompress(receiver, frame, frame_len, &out, &out_len, NULL) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+    assert(sensor_compressor_add_dict(receiver, dict) == PAUMIOT_SUCCESS);
+    assert(sensor_compressor_decompress(receiver, frame, frame_len, &out, &out_len, &codec) ==
+           PAUMIOT_SUCCESS);
+    assert(codec == SENSOR_COMPRESSION_LZ4_DICT);
+    assert(out_len == len && memcmp(out, payload, len) == 0);
+    printf("  %zu-byte payload -> %zu-byte frame\n", len, frame_len);
+    assert(frame_len * 2 < len);
+
+    sensor_compressor_release(receiver, out);
+    sensor_compressor_release(sender, frame);
+
+    /* Dictionary slots are bounded */
+    for (int i = 1; i < 8; i++) {
+        assert(sensor_compressor_add_dict(receiver, dict) == PAUMIOT_SUCCESS);
+    }
+    assert(sensor_compressor_add_dict(receiver, dict) == PAUMIOT_ERROR_OUT_OF_MEMORY);
+
+    sensor_compressor_destroy(sender);
+    sensor_compressor_destroy(receiver);
+    sensor_compress_dict_destroy(dict);
+
+    printf("  ✓ Dictionary frames test passed\n");
+}
+
+static void test_compression_routes(void) {
+    printf("Testing compression routes...\n");
+
+    sensor_compress_dict_t *dict =
+        sensor_compress_dict_create((const uint8_t *)"{\"sensor\":\"", 11);
+    sensor_codec_routes_t *routes = sensor_codec_routes_create();
+
+    sensor_codec_route_t backhaul = { DATA_FORMAT_CBOR, SENSOR_COMPRESSION_LZ4_DICT, dict };
+    sensor_codec_route_t invalid = { DATA_FORMAT_CBOR, SENSOR_COMPRESSION_MAX, NULL };
+    assert(sensor_codec_routes_add_route(routes, "uplink/#", &backhaul) == PAUMIOT_SUCCESS);
+    assert(sensor_codec_routes_add_route(routes, "uplink/#", &invalid) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(sensor_codec_routes_add_route(routes, "uplink/#", NULL) == PAUMIOT_ERROR_INVALID_PARAM);
+    assert(sensor_codec_routes_add(routes, "local/#", DATA_FORMAT_JSON) == PAUMIOT_SUCCESS);
+
+    sensor_codec_route_t route;
+    assert(sensor_codec_routes_lookup(routes, "uplink/site-1/temp", &route));
+    assert(route.format == DATA_FORMAT_CBOR);
+    assert(route.compression == SENSOR_COMPRESSION_LZ4_DICT && route.dict == dict);
+
+    assert(sensor_codec_routes_lookup(routes, "local/temp", &route));
+    assert(route.format == DATA_FORMAT_JSON && route.compression == SENSOR_COMPRESSION_NONE);
+
+    assert(!sensor_codec_routes_lookup(routes, "other/temp", &route));
+    assert(!sensor_codec_routes_lookup(NULL, "uplink/x", &route));
+    assert(sensor_codec_routes_format(routes, "uplink/x", DATA_FORMAT_JSON) == DATA_FORMAT_CBOR);
+
+    assert(strcmp(sensor_codec_content_type(DATA_FORMAT_CBOR), "application/cbor") == 0);
+    assert(strcmp(sensor_codec_content_type(DATA_FORMAT_JSON), "application/json") == 0);
+    assert(strcmp(sensor_codec_content_type(DATA_FORMAT_RAW), "application/octet-stream") == 0);
+
+    sensor_codec_routes_destroy(routes);
+    sensor_compress_dict_destroy(dict);
+
+    printf("  ✓ Compression routes test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running sensor_compress.h tests...\n");
+    printf("========================================\n\n");
+
+    test_lz4_round_trip();
+    test_lz4_block_format();
+    test_lz4_dictionary();
+    test_dictionary_training();
+    test_codec_registry();
+    test_compressor_frames();
+    test_compressor_dictionary_frames();
+    test_compression_routes();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file test_sensor_kernels.c
+ * @brief Unit tests for vectorized batch statistics
+ */
+
+#include "sensor_manager/sensor_kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+
+#define NUM_VALUES 10007   /* Odd length exercises the scalar tails */
+
+static const sensor_kernel_isa_t all_isas[] = {
+    SENSOR_KERNEL_SCALAR, SENSOR_KERNEL_SSE42, SENSOR_KERNEL_AVX2, SENSOR_KERNEL_NEON
+};
+
+static bool close_rel(double a, double b, double tolerance) {
+    return fabs(a - b) <= tolerance * fmax(1.0, fmax(fabs(a), fabs(b)));
+}
+
+/* Reference: straightforward two-pass computation */
+static void reference_stats(const double* v, size_t n, double threshold,
+                            sensor_batch_stats_t* out) {
+    sensor_batch_stats_init(out, threshold);
+    out->count = n;
+    out->first = v[0];
+    out->last = v[n - 1];
+    for (size_t i = 0; i < n; i++) {
+        out->sum += v[i];
+        out->min = v[i] < out->min ? v[i] : out->min;
+        out->max = v[i] > out->max ? v[i] : out->max;
+        if (i > 0 && (v[i] >= threshold) != (v[i - 1] >= threshold)) {
+            out->crossings++;
+        }
+    }
+    double mean = out->sum / (double)n;
+    for (size_t i = 0; i < n; i++) {
+        out->m2 += (v[i] - mean) * (v[i] - mean);
+    }
+}
+
+static void assert_stats_match(const sensor_batch_stats_t* a, const sensor_batch_stats_t* b) {
+    assert(a->count == b->count);
+    assert(a->min == b->min);
+    assert(a->max == b->max);
+    assert(a->first == b->first);
+    assert(a->last == b->last);
+    assert(a->crossings == b->crossings);
+    assert(close_rel(a->sum, b->sum, 1e-12));
+    assert(close_rel(a->m2, b->m2, 1e-9));
+}
+
+static void test_kernels_dispatch(void) {
+    printf("Testing kernel dispatch...\n");
+
+    sensor_kernel_isa_t active = sensor_kernels_active();
+    printf("  active kernel: %s\n", sensor_kernels_isa_name(active));
+    assert(sensor_kernels_supported(active));
+    assert(sensor_kernels_supported(SENSOR_KERNEL_SCALAR));
+
+    for (size_t i = 0; i < sizeof(all_isas) / sizeof(all_isas[0]); i++) {
+        paumiot_result_t expected = sensor_kernels_supported(all_isas[i]) ?
+                                    PAUMIOT_SUCCESS : PAUMIOT_ERROR_NOT_SUPPORTED;
+        assert(sensor_kernels_select(all_isas[i]) == expected);
+    }
+    assert(strcmp(sensor_kernels_isa_name(SENSOR_KERNEL_AVX2), "avx2") == 0);
+
+    assert(sensor_kernels_select(active) == PAUMIOT_SUCCESS);
+
+    printf("  ✓ Kernel dispatch test passed\n");
+}
+
+static void test_kernels_parity(void) {
+    printf("Testing kernel parity with scalar...\n");
+
+    double* values = malloc(NUM_VALUES * sizeof(double));
+    float* floats = malloc(NUM_VALUES * sizeof(float));
+    int32_t* ints = malloc(NUM_VALUES * sizeof(int32_t));
+    assert(values && floats && ints);
+
+    /* Noisy sine around 20 so the threshold is crossed often */
+    srand(42);
+    int32_t int_min = INT32_MAX;
+    for (size_t i = 0; i < NUM_VALUES; i++) {
+        double noise = (double)rand() / RAND_MAX - 0.5;
+        values[i] = 20.0 + 5.0 * sin((double)i / 50.0) + noise;
+        floats[i] = (float)values[i];
+        ints[i] = (int32_t)(values[i] * 100.0);
+        int_min = ints[i] < int_min ? ints[i] : int_min;
+    }
+
+    sensor_batch_stats_t expected;
+    reference_stats(values, NUM_VALUES, 20.0, &expected);
+    assert(expected.crossings > 100);
+
+    sensor_kernel_isa_t active = sensor_kernels_active();
+
+    for (size_t k = 0; k < sizeof(all_isas) / sizeof(all_isas[0]); k++) {
+        if (sensor_kernels_select(all_isas[k]) != PAUMIOT_SUCCESS) {
+            continue;
+        }
+
+        /* Whole array, every short length, and uneven batches */
+        sensor_batch_stats_t stats;
+        sensor_batch_stats_init(&stats, 20.0);
+        sensor_batch_stats_add_f64(&stats, values, NUM_VALUES);
+        assert_stats_match(&stats, &expected);
+
+        for (size_t n = 1; n <= 33; n++) {
+            sensor_batch_stats_t ref;
+            reference_stats(values + 7, n, 20.0, &ref);
+            sensor_batch_stats_init(&stats, 20.0);
+            sensor_batch_stats_add_f64(&stats, values + 7, n);
+            assert_stats_match(&stats, &ref);
+        }
+
+        sensor_batch_stats_init(&stats, 20.0);
+        for (size_t i = 0; i < NUM_VALUES; ) {
+            size_t n = 1 + (i * 7919) % 1500;
+            if (n > NUM_VALUES - i) {
+                n = NUM_VALUES - i;
+            }
+            sensor_batch_stats_add_f64(&stats, values + i, n);
+            i += n;
+        }
+        assert_stats_match(&stats, &expected);
+
+        /* Narrow element types go through the same kernels */
+        sensor_batch_stats_t f32;
+        sensor_batch_stats_init(&f32, 20.0);
+        sensor_batch_stats_add_f32(&f32, floats, NUM_VALUES);
+        assert(f32.count == NUM_VALUES);
+        assert(f32.crossings > 100);
+        assert(close_rel(sensor_batch_stats_mean(&f32), sensor_batch_stats_mean(&expected), 1e-6));
+
+        sensor_batch_stats_t i32;
+        sensor_batch_stats_init(&i32, 2000.0);
+        sensor_batch_stats_add_i32(&i32, ints, NUM_VALUES);
+        assert(i32.count == NUM_VALUES);
+        assert(i32.min == (double)int_min);
+        assert(close_rel(sensor_batch_stats_mean(&i32) / 100.0,
+                         sensor_batch_stats_mean(&expected), 1e-3));
+
+        printf("  ✓ %s matches scalar\n", sensor_kernels_isa_name(all_isas[k]));
+    }
+
+    assert(sensor_kernels_select(active) == PAUMIOT_SUCCESS);
+
+    free(values);
+    free(floats);
+    free(ints);
+
+    printf("  ✓ Kernel parity test passed\n");
+}
+
+static void test_batch_stats_merge(void) {
+    printf("Testing batch stats merge...\n");
+
+    const double a[] = { 1.0, 2.0, 3.0, 4.0 };
+    const double b[] = { 10.0, 11.0 };
+    const double all[] = { 1.0, 2.0, 3.0, 4.0, 10.0, 11.0 };
+
+    sensor_batch_stats_t sa;
+    sensor_batch_stats_t sb;
+    sensor_batch_stats_t ref;
+    sensor_batch_stats_init(&sa, 5.0);
+    sensor_batch_stats_init(&sb, 5.0);
+    sensor_batch_stats_add_f64(&sa, a, 4);
+    sensor_batch_stats_add_f64(&sb, b, 2);
+    reference_stats(all, 6, 5.0, &ref);
+
+    sensor_batch_stats_merge(&sa, &sb);
+    assert_stats_match(&sa, &ref);
+    assert(sa.crossings == 1);
+    assert(sensor_batch_stats_mean(&sa) == 31.0 / 6.0);
+    assert(close_rel(sensor_batch_stats_variance(&sa), ref.m2 / 6.0, 1e-12));
+
+    /* Empty stats */
+    sensor_batch_stats_t empty;
+    sensor_batch_stats_init(&empty, NAN);
+    assert(isnan(sensor_batch_stats_mean(&empty)));
+    assert(isnan(sensor_batch_stats_variance(&empty)));
+    sensor_batch_stats_add_f64(&empty, a, 0);
+    assert(empty.count == 0);
+
+    /* NAN threshold disables crossing counting */
+    sensor_batch_stats_add_f64(&empty, all, 6);
+    assert(empty.crossings == 0);
+    assert(empty.min == 1.0 && empty.max == 11.0);
+
+    printf("  ✓ Batch stats merge test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running sensor_kernels.h tests...\n");
+    printf("========================================\n\n");
+
+    test_kernels_dispatch();
+    test_kernels_parity();
+    test_batch_stats_merge();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
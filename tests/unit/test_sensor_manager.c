@@ -0,0 +1,1050 @@
+/**
+ * @file test_sensor_manager.c
+ * @brief Unit tests for the sensor manager registry and data path
+ */
+
+#include "sensor_manager/sensor_manager.h"
+#include "sensor_manager/sensor_aggregator.h"
+#include "sensor_manager/sensor_kernels.h"
+#include "sensor_manager/sensor_codec.h"
+#include "sensor_manager/sensor_compress.h"
+#include "time_utils.h"
+#include "cpu_topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+static sensor_entry_t make_entry(const char* id, const char* topic) {
+    sensor_entry_t entry = {
+        .sensor_id = (char*)id,
+        .name = (char*)"Test sensor",
+        .type = SENSOR_TYPE_TEMPERATURE,
+        .topic_pattern = (char*)topic,
+        .location = (char*)"lab",
+        .status = SENSOR_STATUS_ONLINE
+    };
+    return entry;
+}
+
+static sensor_data_t make_data(const char* id, const char* payload, uint64_t ts) {
+    sensor_data_t data = {
+        .sensor_id = (char*)id,
+        .topic = (char*)"sensors/temp/1",
+        .payload = (uint8_t*)payload,
+        .payload_len = strlen(payload),
+        .format = DATA_FORMAT_JSON,
+        .timestamp = ts,
+        .qos = QOS_LEVEL_0
+    };
+    return data;
+}
+
+static void test_manager_lifecycle(void) {
+    printf("Testing sensor manager lifecycle...\n");
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    assert(config.enable_cache);
+    assert(config.cache_size > 0);
+
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+    assert(sensor_manager_start(sm) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_start(sm) == PAUMIOT_ERROR_ALREADY_INITIALIZED);
+    assert(sensor_manager_stop(sm) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_stop(sm) == PAUMIOT_ERROR_NOT_INITIALIZED);
+    sensor_manager_cleanup(sm);
+
+    /* Default configuration */
+    sm = sensor_manager_init(NULL);
+    assert(sm != NULL);
+    sensor_manager_cleanup(sm);
+    sensor_manager_cleanup(NULL);
+
+    printf("  ✓ Lifecycle test passed\n");
+}
+
+static void test_manager_registry(void) {
+    printf("Testing sensor registry...\n");
+
+    sensor_manager_t* sm = sensor_manager_init(NULL);
+    assert(sm != NULL);
+
+    sensor_entry_t entry = make_entry("temp-1", "sensors/temp/{id}");
+    assert(sensor_manager_register(sm, &entry) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_register(sm, &entry) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_ALREADY_EXISTS);
+
+    sensor_entry_t entry2 = make_entry("hum-1", "sensors/humidity/+");
+    assert(sensor_manager_register(sm, &entry2) == PAUMIOT_SUCCESS);
+
+    sensor_entry_t out;
+    assert(sensor_manager_get_sensor(sm, "temp-1", &out) == PAUMIOT_SUCCESS);
+    assert(strcmp(out.sensor_id, "temp-1") == 0);
+    assert(strcmp(out.location, "lab") == 0);
+    assert(out.type == SENSOR_TYPE_TEMPERATURE);
+    sensor_entry_free(&out);
+
+    assert(sensor_manager_get_sensor(sm, "nope", &out) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+
+    sensor_entry_t* list = NULL;
+    size_t count = 0;
+    assert(sensor_manager_list_sensors(sm, &list, &count) == PAUMIOT_SUCCESS);
+    assert(count == 2);
+    for (size_t i = 0; i < count; i++) {
+        sensor_entry_free(&list[i]);
+    }
+    free(list);
+
+    assert(sensor_manager_find_by_topic(sm, "sensors/humidity/7", &list, &count) ==
+           PAUMIOT_SUCCESS);
+    assert(count == 1);
+    assert(strcmp(list[0].sensor_id, "hum-1") == 0);
+    for (size_t i = 0; i < count; i++) {
+        sensor_entry_free(&list[i]);
+    }
+    free(list);
+
+    assert(sensor_manager_unregister(sm, "temp-1") == PAUMIOT_SUCCESS);
+    assert(sensor_manager_unregister(sm, "temp-1") ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.total_sensors == 1);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Registry test passed\n");
+}
+
+static void test_manager_registry_growth(void) {
+    printf("Testing registry growth...\n");
+
+    sensor_manager_t* sm = sensor_manager_init(NULL);
+    assert(sm != NULL);
+
+    char id[32];
+    for (int i = 0; i < 5000; i++) {
+        snprintf(id, sizeof(id), "sensor-%d", i);
+        sensor_entry_t entry = make_entry(id, "sensors/+");
+        assert(sensor_manager_register(sm, &entry) == PAUMIOT_SUCCESS);
+    }
+
+    for (int i = 0; i < 5000; i += 97) {
+        snprintf(id, sizeof(id), "sensor-%d", i);
+        sensor_entry_t out;
+        assert(sensor_manager_get_sensor(sm, id, &out) == PAUMIOT_SUCCESS);
+        sensor_entry_free(&out);
+    }
+
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.total_sensors == 5000);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Registry growth test passed\n");
+}
+
+static void test_manager_data_cache(void) {
+    printf("Testing data path with cache...\n");
+
+    sensor_manager_t* sm = sensor_manager_init(NULL);
+    assert(sm != NULL);
+
+    sensor_entry_t entry = make_entry("temp-1", "sensors/temp/{id}");
+    assert(sensor_manager_register(sm, &entry) == PAUMIOT_SUCCESS);
+
+    sensor_data_t* out = NULL;
+    assert(sensor_manager_get_data(sm, "temp-1", &out) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NO_DATA);
+
+    sensor_data_t data = make_data("temp-1", "{\"t\":21}", 1000);
+    assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+
+    /* Updates for unknown sensors are rejected */
+    sensor_data_t unknown = make_data("ghost", "{}", 1);
+    assert(sensor_manager_update_data(sm, &unknown) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+
+    assert(sensor_manager_reset_stats(sm) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_get_data(sm, "temp-1", &out) == PAUMIOT_SUCCESS);
+    assert(out->payload_len == strlen("{\"t\":21}"));
+    assert(memcmp(out->payload, "{\"t\":21}", out->payload_len) == 0);
+    assert(out->timestamp == 1000);
+    sensor_data_free(out);
+
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.cache_hits == 1);
+    assert(stats.cache_misses == 0);
+    assert(stats.cache_memory_usage > 0);
+
+    /* Latest value wins */
+    data = make_data("temp-1", "{\"t\":23}", 2000);
+    assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_get_data(sm, "temp-1", &out) == PAUMIOT_SUCCESS);
+    assert(out->timestamp == 2000);
+    sensor_data_free(out);
+
+    /* Unregistering drops the cached value */
+    assert(sensor_manager_unregister(sm, "temp-1") == PAUMIOT_SUCCESS);
+    assert(sensor_manager_get_data(sm, "temp-1", &out) ==
+           (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Data cache test passed\n");
+}
+
+static void test_manager_cache_miss_refill(void) {
+    printf("Testing cache miss refill...\n");
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.cache_size = 1;
+
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    sensor_entry_t b = make_entry("b", "sensors/b");
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_register(sm, &b) == PAUMIOT_SUCCESS);
+
+    sensor_data_t da = make_data("a", "1", 1);
+    sensor_data_t db = make_data("b", "2", 2);
+    assert(sensor_manager_update_data(sm, &da) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_data(sm, &db) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_reset_stats(sm) == PAUMIOT_SUCCESS);
+
+    /* "a" was evicted by "b"; it is served from the registry and refilled */
+    sensor_data_t* out = NULL;
+    assert(sensor_manager_get_data(sm, "a", &out) == PAUMIOT_SUCCESS);
+    assert(out->timestamp == 1);
+    sensor_data_free(out);
+    assert(sensor_manager_get_data(sm, "a", &out) == PAUMIOT_SUCCESS);
+    sensor_data_free(out);
+
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.cache_misses == 1);
+    assert(stats.cache_hits == 1);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Cache miss refill test passed\n");
+}
+
+static void test_manager_historical(void) {
+    printf("Testing historical queries...\n");
+
+    sensor_manager_t* sm = sensor_manager_init(NULL);
+    assert(sm != NULL);
+    sensor_data_t* history = NULL;
+    size_t count = 0;
+    assert(sensor_manager_query_historical(sm, "a", 0, UINT64_MAX, &history, &count) ==
+           PAUMIOT_ERROR_NOT_SUPPORTED);
+    sensor_manager_cleanup(sm);
+
+    char tmpl[] = "/tmp/paumiot_history_XXXXXX";
+    char* dir = mkdtemp(tmpl);
+    assert(dir != NULL);
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.enable_historical = true;
+    config.storage_path = dir;
+    config.retention_days = 0;
+
+    sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+
+    /* JSON "value" member, bare number, native double, and a non-numeric payload */
+    sensor_data_t d1 = make_data("a", "{\"unit\":\"C\",\"value\": 21.5}", 1700000000000ULL);
+    sensor_data_t d2 = make_data("a", "22.25", 1700000001000ULL);
+    double raw = 23.0;
+    sensor_data_t d3 = make_data("a", "", 1700000002000ULL);
+    d3.payload = (uint8_t*)&raw;
+    d3.payload_len = sizeof(raw);
+    d3.format = DATA_FORMAT_RAW;
+    sensor_data_t d4 = make_data("a", "{\"state\":\"open\"}", 1700000003000ULL);
+    assert(sensor_manager_update_data(sm, &d1) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_data(sm, &d2) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_data(sm, &d3) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_data(sm, &d4) == PAUMIOT_SUCCESS);
+
+    assert(sensor_manager_query_historical(sm, "a", 1700000000000ULL, 1700000001500ULL,
+                                           &history, &count) == PAUMIOT_SUCCESS);
+    assert(count == 2);
+    double v;
+    memcpy(&v, history[0].payload, sizeof(v));
+    assert(v == 21.5 && history[0].timestamp == 1700000000000ULL);
+    memcpy(&v, history[1].payload, sizeof(v));
+    assert(v == 22.25 && history[1].format == DATA_FORMAT_RAW);
+    assert(strcmp(history[1].sensor_id, "a") == 0);
+    free(history);
+
+    assert(sensor_manager_query_historical(sm, "a", 0, UINT64_MAX, &history, &count) ==
+           PAUMIOT_SUCCESS);
+    assert(count == 3);
+    free(history);
+
+    assert(sensor_manager_query_historical(sm, "b", 0, UINT64_MAX, &history, &count) ==
+           PAUMIOT_SUCCESS);
+    assert(count == 0 && history == NULL);
+
+    /* Summaries scan the same points without materialising them */
+    sensor_batch_stats_t stats;
+    assert(sensor_manager_query_stats(sm, "a", 0, UINT64_MAX, 22.0, &stats) ==
+           PAUMIOT_SUCCESS);
+    assert(stats.count == 3);
+    assert(stats.min == 21.5 && stats.max == 23.0);
+    assert(sensor_batch_stats_mean(&stats) == 66.75 / 3.0);
+    assert(stats.crossings == 1);
+    assert(sensor_manager_query_stats(sm, "b", 0, UINT64_MAX, NAN, &stats) ==
+           PAUMIOT_SUCCESS);
+    assert(stats.count == 0);
+
+    /* Non-finite readings are not recorded */
+    sensor_data_t d5 = make_data("a", "nan", 1700000004000ULL);
+    assert(sensor_manager_update_data(sm, &d5) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_query_stats(sm, "a", 0, UINT64_MAX, NAN, &stats) ==
+           PAUMIOT_SUCCESS);
+    assert(stats.count == 3);
+
+    sensor_manager_cleanup(sm);
+
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", dir);
+    assert(system(cmd) == 0);
+
+    printf("  ✓ Historical query test passed\n");
+}
+
+static void on_aggregate(const sensor_aggregate_t* aggregate, void* user_data) {
+    sensor_aggregate_t* last = (sensor_aggregate_t*)user_data;
+    *last = *aggregate;
+    last->sensor_id = NULL;  /* Not valid after the callback */
+}
+
+static void count_aggregate(const sensor_aggregate_t* aggregate, void* user_data) {
+    (void)aggregate;
+    atomic_fetch_add((atomic_int*)user_data, 1);
+}
+
+static void test_manager_aggregation(void) {
+    printf("Testing aggregation...\n");
+
+    sensor_manager_t* sm = sensor_manager_init(NULL);
+    assert(sm != NULL);
+    sensor_aggregate_t last = {0};
+    assert(sensor_manager_subscribe_aggregates(sm, NULL, on_aggregate, &last) ==
+           PAUMIOT_ERROR_NOT_SUPPORTED);
+    assert(sensor_manager_flush_aggregates(sm, 0) == PAUMIOT_ERROR_NOT_SUPPORTED);
+    sensor_manager_cleanup(sm);
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.enable_aggregation = true;
+    config.aggregation_window_ms = 60000;
+
+    sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_subscribe_aggregates(sm, "a", on_aggregate, &last) ==
+           PAUMIOT_SUCCESS);
+
+    /* 10Hz for one minute becomes a single message */
+    const uint64_t base = 1700000040000ULL;
+    char payload[32];
+    for (int i = 0; i < 600; i++) {
+        snprintf(payload, sizeof(payload), "%d", i % 10);
+        sensor_data_t d = make_data("a", payload, base + (uint64_t)i * 100);
+        assert(sensor_manager_update_data(sm, &d) == PAUMIOT_SUCCESS);
+    }
+    assert(last.count == 0);
+
+    assert(sensor_manager_flush_aggregates(sm, base + 60000) == PAUMIOT_SUCCESS);
+    assert(last.count == 600);
+    assert(last.window_start == base && last.window_end == base + 60000);
+    assert(last.min == 0.0 && last.max == 9.0);
+    assert(last.mean == 4.5);
+
+    sensor_manager_config_t bad = config;
+    bad.aggregation_slide_ms = 7000;
+    assert(sensor_manager_init(&bad) == NULL);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Aggregation test passed\n");
+}
+
+static void test_manager_aggregation_timer(void) {
+    printf("Testing idle window flush...\n");
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.enable_aggregation = true;
+    config.aggregation_window_ms = 100;
+    config.aggregation_grace_ms = 0;
+
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+    atomic_int emitted = 0;
+    assert(sensor_manager_subscribe_aggregates(sm, "a", count_aggregate, &emitted) ==
+           PAUMIOT_SUCCESS);
+    assert(sensor_manager_start(sm) == PAUMIOT_SUCCESS);
+
+    /* One reading, then silence: the timer closes the window on its own */
+    sensor_data_t d = make_data("a", "21.5", time_realtime_ms());
+    assert(sensor_manager_update_data(sm, &d) == PAUMIOT_SUCCESS);
+    for (int i = 0; i < 200 && atomic_load(&emitted) == 0; i++) {
+        usleep(10000);
+    }
+    assert(atomic_load(&emitted) == 1);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Idle window flush test passed\n");
+}
+
+/* ========================================
+ * Callback Tests
+ * ======================================== */
+
+typedef struct {
+    int data_calls;
+    int status_calls;
+    sensor_status_t last_status;
+} callback_counter_t;
+
+static void on_data(const char* sensor_id, const sensor_data_t* data, void* user_data) {
+    callback_counter_t* counter = (callback_counter_t*)user_data;
+    assert(strcmp(sensor_id, data->sensor_id) == 0);
+    counter->data_calls++;
+}
+
+static void on_status(const char* sensor_id, sensor_status_t old_status,
+                      sensor_status_t new_status, void* user_data) {
+    callback_counter_t* counter = (callback_counter_t*)user_data;
+    (void)sensor_id;
+    assert(old_status != new_status);
+    counter->status_calls++;
+    counter->last_status = new_status;
+}
+
+static void test_manager_callbacks(void) {
+    printf("Testing subscriber callbacks...\n");
+
+    sensor_manager_t* sm = sensor_manager_init(NULL);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    sensor_entry_t b = make_entry("b", "sensors/b");
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_register(sm, &b) == PAUMIOT_SUCCESS);
+
+    callback_counter_t all = {0};
+    callback_counter_t only_a = {0};
+    assert(sensor_manager_subscribe_data(sm, NULL, on_data, &all) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_subscribe_data(sm, "a", on_data, &only_a) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_subscribe_status(sm, "a", on_status, &only_a) == PAUMIOT_SUCCESS);
+
+    sensor_data_t da = make_data("a", "1", 1);
+    sensor_data_t db = make_data("b", "2", 2);
+    assert(sensor_manager_update_data(sm, &da) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_data(sm, &db) == PAUMIOT_SUCCESS);
+    assert(all.data_calls == 2);
+    assert(only_a.data_calls == 1);
+
+    /* Status callbacks fire only on change */
+    assert(sensor_manager_update_status(sm, "a", SENSOR_STATUS_ONLINE) == PAUMIOT_SUCCESS);
+    assert(only_a.status_calls == 0);
+    assert(sensor_manager_update_status(sm, "a", SENSOR_STATUS_OFFLINE) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_status(sm, "b", SENSOR_STATUS_OFFLINE) == PAUMIOT_SUCCESS);
+    assert(only_a.status_calls == 1);
+    assert(only_a.last_status == SENSOR_STATUS_OFFLINE);
+
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.online_sensors == 0);
+    assert(stats.offline_sensors == 2);
+    assert(stats.data_updates == 2);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Callback test passed\n");
+}
+
+static void test_manager_health(void) {
+    printf("Testing health monitoring...\n");
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.enable_health_monitoring = false;
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+    assert(sensor_manager_check_health(sm, 0, NULL) == PAUMIOT_ERROR_NOT_SUPPORTED);
+    sensor_manager_cleanup(sm);
+
+    config.enable_health_monitoring = true;
+    config.health_check_interval_ms = 0;
+    assert(sensor_manager_init(&config) == NULL);
+
+    config.health_check_interval_ms = 10;
+    config.offline_threshold_ms = 50;
+    sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    sensor_entry_t b = make_entry("b", "sensors/b");
+    sensor_entry_t m = make_entry("m", "sensors/m");
+    m.status = SENSOR_STATUS_MAINTENANCE;
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_register(sm, &b) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_register(sm, &m) == PAUMIOT_SUCCESS);
+
+    callback_counter_t all = {0};
+    assert(sensor_manager_subscribe_status(sm, NULL, on_status, &all) == PAUMIOT_SUCCESS);
+
+    /* Nothing is due yet */
+    uint64_t now = time_monotonic_ms();
+    size_t transitions = 99;
+    assert(sensor_manager_check_health(sm, now, &transitions) == PAUMIOT_SUCCESS);
+    assert(transitions == 0 && all.status_calls == 0);
+
+    /* b keeps reporting; a and m go quiet (m is in maintenance and stays so) */
+    sensor_data_t db = make_data("b", "1", 1);
+    assert(sensor_manager_update_data(sm, &db) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_check_health(sm, time_monotonic_ms() + 49, &transitions) ==
+           PAUMIOT_SUCCESS);
+    assert(sensor_manager_check_health(sm, now + 100, &transitions) == PAUMIOT_SUCCESS);
+    assert(all.status_calls >= 1 && all.last_status == SENSOR_STATUS_OFFLINE);
+
+    sensor_entry_t entry;
+    assert(sensor_manager_get_sensor(sm, "a", &entry) == PAUMIOT_SUCCESS);
+    assert(entry.status == SENSOR_STATUS_OFFLINE);
+    sensor_entry_free(&entry);
+    assert(sensor_manager_get_sensor(sm, "m", &entry) == PAUMIOT_SUCCESS);
+    assert(entry.status == SENSOR_STATUS_MAINTENANCE);
+    sensor_entry_free(&entry);
+
+    /* A reading brings the sensor back */
+    int calls = all.status_calls;
+    sensor_data_t da = make_data("a", "1", 2);
+    assert(sensor_manager_update_data(sm, &da) == PAUMIOT_SUCCESS);
+    assert(all.status_calls == calls + 1 && all.last_status == SENSOR_STATUS_ONLINE);
+
+    /* Long after the last reading both are offline, reported in one pass */
+    assert(sensor_manager_check_health(sm, time_monotonic_ms() + 1000, &transitions) ==
+           PAUMIOT_SUCCESS);
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.online_sensors == 0);
+    assert(stats.offline_sensors == 2);
+    assert(stats.health_checks == 4);
+
+    /* Unregistered sensors are no longer tracked */
+    assert(sensor_manager_unregister(sm, "a") == PAUMIOT_SUCCESS);
+    assert(sensor_manager_update_data(sm, &db) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_unregister(sm, "b") == PAUMIOT_SUCCESS);
+    assert(sensor_manager_check_health(sm, time_monotonic_ms() + 10000, &transitions) ==
+           PAUMIOT_SUCCESS);
+    assert(transitions == 0);
+
+    sensor_manager_cleanup(sm);
+
+    /* The background monitor does the same on its own */
+    sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+    sensor_entry_t c = make_entry("c", "sensors/c");
+    assert(sensor_manager_start(sm) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_register(sm, &c) == PAUMIOT_SUCCESS);
+    for (int i = 0; i < 200; i++) {
+        assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+        if (stats.offline_sensors == 1) {
+            break;
+        }
+        usleep(10000);
+    }
+    assert(stats.offline_sensors == 1);
+    assert(stats.health_checks > 0);
+    assert(sensor_manager_stop(sm) == PAUMIOT_SUCCESS);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Health monitoring test passed\n");
+}
+
+/* Records deferred deliveries and the thread that ran them */
+typedef struct {
+    atomic_int calls;
+    atomic_int out_of_order;
+    atomic_int block;               /* Spin while set */
+    uint64_t last_ts;
+    pthread_t thread;
+    useconds_t delay_us;            /* Sleep in the first call */
+    int cpu;                        /* CPU of the last call */
+} deferred_counter_t;
+
+static void on_deferred(const char* sensor_id, const sensor_data_t* data, void* user_data) {
+    deferred_counter_t* counter = user_data;
+    assert(strcmp(sensor_id, data->sensor_id) == 0);
+
+    while (atomic_load(&counter->block)) {
+        usleep(100);
+    }
+    if (counter->delay_us > 0 && atomic_load(&counter->calls) == 0) {
+        usleep(counter->delay_us);
+    }
+
+    if (data->timestamp <= counter->last_ts) {
+        atomic_fetch_add(&counter->out_of_order, 1);
+    }
+    counter->last_ts = data->timestamp;
+    counter->thread = pthread_self();
+    counter->cpu = cpu_current();
+    atomic_fetch_add(&counter->calls, 1);
+}
+
+static void wait_for_calls(deferred_counter_t* counter, int expected) {
+    for (int i = 0; i < 2000 && atomic_load(&counter->calls) < expected; i++) {
+        usleep(1000);
+    }
+    assert(atomic_load(&counter->calls) == expected);
+}
+
+static void test_manager_deferred_dispatch(void) {
+    printf("Testing deferred data callbacks...\n");
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.dispatch_threads = 2;
+    config.dispatch_queue_size = 4;
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+
+    deferred_counter_t inline_counter = {0};
+    deferred_counter_t deferred = {0};
+    assert(sensor_manager_subscribe_data_ex(sm, "a", on_deferred, &deferred, 0x80) ==
+           PAUMIOT_ERROR_INVALID_PARAM);
+    assert(sensor_manager_subscribe_data(sm, "a", on_deferred, &inline_counter) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_subscribe_data_ex(sm, "a", on_deferred, &deferred,
+                                            SENSOR_SUBSCRIBE_DEFERRED) == PAUMIOT_SUCCESS);
+
+    /* Deferred readings arrive in order on a worker */
+    for (uint64_t ts = 1; ts <= 4; ts++) {
+        sensor_data_t data = make_data("a", "1", ts);
+        assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    }
+    assert(atomic_load(&inline_counter.calls) == 4);
+    assert(pthread_equal(inline_counter.thread, pthread_self()));
+    wait_for_calls(&deferred, 4);
+    assert(atomic_load(&deferred.out_of_order) == 0);
+    assert(!pthread_equal(deferred.thread, pthread_self()));
+
+    /* A stalled worker drops what its queue cannot hold */
+    atomic_store(&deferred.block, 1);
+    sensor_data_t first = make_data("a", "1", 5);
+    assert(sensor_manager_update_data(sm, &first) == PAUMIOT_SUCCESS);
+    /* Let the worker take it off the queue and stall */
+    usleep(10000);
+    for (uint64_t ts = 6; ts <= 12; ts++) {
+        sensor_data_t data = make_data("a", "1", ts);
+        assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    }
+    atomic_store(&deferred.block, 0);
+    wait_for_calls(&deferred, 4 + 1 + 4);
+    assert(atomic_load(&deferred.out_of_order) == 0);
+
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.deferred_callbacks == 9);
+    assert(stats.deferred_dropped == 3);
+
+    sensor_manager_cleanup(sm);
+
+    /* No workers, no deferral */
+    config.dispatch_threads = 0;
+    sm = sensor_manager_init(&config);
+    assert(sensor_manager_subscribe_data_ex(sm, NULL, on_deferred, &deferred,
+                                            SENSOR_SUBSCRIBE_DEFERRED) == PAUMIOT_ERROR_NOT_SUPPORTED);
+    sensor_manager_cleanup(sm);
+    config.slow_callback_us = 1000;
+    assert(sensor_manager_init(&config) == NULL);
+
+    printf("  ✓ Deferred callback test passed\n");
+}
+
+static void test_manager_pinned_dispatch(void) {
+    printf("Testing pinned dispatch workers...\n");
+
+    cpu_topology_t topology;
+    assert(cpu_topology_discover(&topology, NULL));
+    int16_t cpus[2] = { (int16_t)topology.cpus[topology.num_cpus - 1], -1 };
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.dispatch_threads = 2;
+    config.dispatch_cpus = cpus;
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    /* The manager keeps its own copy */
+    int16_t pinned = cpus[0];
+    cpus[0] = -1;
+
+    /* Sensors are sharded over the workers; some land on the pinned one */
+    deferred_counter_t deferred[8];
+    memset(deferred, 0, sizeof(deferred));
+    char ids[8][sizeof("s-2147483648")];
+    for (int i = 0; i < 8; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "s%d", i);
+        sensor_entry_t entry = make_entry(ids[i], "sensors/x");
+        assert(sensor_manager_register(sm, &entry) == PAUMIOT_SUCCESS);
+        assert(sensor_manager_subscribe_data_ex(sm, ids[i], on_deferred, &deferred[i],
+                                                SENSOR_SUBSCRIBE_DEFERRED) == PAUMIOT_SUCCESS);
+        sensor_data_t data = make_data(ids[i], "1", 1);
+        assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    }
+
+    bool seen_pinned = false;
+    for (int i = 0; i < 8; i++) {
+        wait_for_calls(&deferred[i], 1);
+        seen_pinned = seen_pinned || deferred[i].cpu == pinned;
+    }
+    assert(seen_pinned);
+
+    sensor_manager_cleanup(sm);
+    printf("  ✓ Pinned dispatch test passed\n");
+}
+
+static void test_manager_slow_callback(void) {
+    printf("Testing slow callback deferral...\n");
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.slow_callback_us = 2000;
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+
+    deferred_counter_t fast = {0};
+    deferred_counter_t slow = {.delay_us = 20000};
+    assert(sensor_manager_subscribe_data(sm, NULL, on_deferred, &fast) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_subscribe_data(sm, NULL, on_deferred, &slow) == PAUMIOT_SUCCESS);
+
+    /* The first, slow call runs inline; later ones move to a worker */
+    for (uint64_t ts = 1; ts <= 3; ts++) {
+        sensor_data_t data = make_data("a", "1", ts);
+        assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    }
+    assert(atomic_load(&fast.calls) == 3);
+    assert(pthread_equal(fast.thread, pthread_self()));
+    wait_for_calls(&slow, 3);
+    assert(!pthread_equal(slow.thread, pthread_self()));
+    assert(atomic_load(&slow.out_of_order) == 0);
+
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.deferred_callbacks == 2);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Slow callback test passed\n");
+}
+
+typedef struct {
+    sensor_manager_t* sm;
+    atomic_int stop;
+    uint64_t updates;
+} update_worker_t;
+
+static void* update_worker_main(void* arg) {
+    update_worker_t* worker = arg;
+    while (!atomic_load(&worker->stop)) {
+        sensor_data_t data = make_data("a", "1", ++worker->updates);
+        assert(sensor_manager_update_data(worker->sm, &data) == PAUMIOT_SUCCESS);
+    }
+    return NULL;
+}
+
+static void test_manager_concurrent_subscribe(void) {
+    printf("Testing subscribe during dispatch...\n");
+
+    sensor_manager_t* sm = sensor_manager_init(NULL);
+    assert(sm != NULL);
+
+    sensor_entry_t a = make_entry("a", "sensors/a");
+    assert(sensor_manager_register(sm, &a) == PAUMIOT_SUCCESS);
+
+    enum { SUBSCRIBERS = 64 };
+    static callback_counter_t counters[SUBSCRIBERS];
+    memset(counters, 0, sizeof(counters));
+
+    update_worker_t worker = {.sm = sm};
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, update_worker_main, &worker) == 0);
+
+    for (int i = 0; i < SUBSCRIBERS; i++) {
+        const char* filter = (i % 2) ? "a" : NULL;
+        assert(sensor_manager_subscribe_data(sm, filter, on_data, &counters[i]) ==
+               PAUMIOT_SUCCESS);
+        usleep(100);
+    }
+
+    atomic_store(&worker.stop, 1);
+    pthread_join(thread, NULL);
+
+    /* Earlier subscribers saw at least as many updates as later ones */
+    assert(worker.updates > 0);
+    for (int i = 1; i < SUBSCRIBERS; i++) {
+        assert(counters[i].data_calls <= counters[i - 1].data_calls);
+    }
+
+    /* Every subscriber sees updates after the last swap */
+    int before = counters[SUBSCRIBERS - 1].data_calls;
+    sensor_data_t data = make_data("a", "1", worker.updates + 1);
+    assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    assert(counters[SUBSCRIBERS - 1].data_calls == before + 1);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Concurrent subscribe test passed\n");
+}
+
+typedef struct {
+    sensor_manager_t* sm;
+    atomic_int stop;
+} churn_worker_t;
+
+static void* churn_update_main(void* arg) {
+    churn_worker_t* worker = arg;
+    uint64_t ts = 1700000000000ULL;
+    while (!atomic_load(&worker->stop)) {
+        sensor_data_t data = make_data("c", "1", ts);
+        ts += 250;
+        paumiot_result_t result = sensor_manager_update_data(worker->sm, &data);
+        assert(result == PAUMIOT_SUCCESS ||
+               result == (paumiot_result_t)SENSOR_MANAGER_ERROR_NOT_FOUND);
+    }
+    return NULL;
+}
+
+static void test_manager_unregister_during_update(void) {
+    printf("Testing unregister during update...\n");
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    config.enable_aggregation = true;
+    config.aggregation_window_ms = 1000;
+
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    atomic_int emitted = 0;
+    assert(sensor_manager_subscribe_aggregates(sm, "c", count_aggregate, &emitted) ==
+           PAUMIOT_SUCCESS);
+
+    enum { UPDATERS = 4 };
+    churn_worker_t worker = {.sm = sm};
+    pthread_t threads[UPDATERS];
+    for (int i = 0; i < UPDATERS; i++) {
+        assert(pthread_create(&threads[i], NULL, churn_update_main, &worker) == 0);
+    }
+
+    sensor_entry_t c = make_entry("c", "sensors/c");
+    for (int i = 0; i < 2000; i++) {
+        assert(sensor_manager_register(sm, &c) == PAUMIOT_SUCCESS);
+        if (i % 16 == 0) {
+            usleep(50);
+        }
+        assert(sensor_manager_unregister(sm, "c") == PAUMIOT_SUCCESS);
+    }
+
+    atomic_store(&worker.stop, 1);
+    for (int i = 0; i < UPDATERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Late updates must not have recreated window state for the removed sensor */
+    int before = atomic_load(&emitted);
+    assert(sensor_manager_flush_aggregates(sm, UINT64_MAX / 2) == PAUMIOT_SUCCESS);
+    assert(atomic_load(&emitted) == before);
+
+    sensor_manager_cleanup(sm);
+
+    printf("  ✓ Unregister during update test passed\n");
+}
+
+/* Copy of the last delivery seen by on_encoded */
+typedef struct {
+    int calls;
+    bool compressed;
+    data_format_t format;
+    size_t len;
+    uint8_t payload[1024];
+} delivery_t;
+
+static void on_encoded(const char* sensor_id, const sensor_data_t* data, void* user_data) {
+    delivery_t* delivery = (delivery_t*)user_data;
+    (void)sensor_id;
+    assert(data->payload_len <= sizeof(delivery->payload));
+    delivery->calls++;
+    delivery->compressed = data->compressed;
+    delivery->format = data->format;
+    delivery->len = data->payload_len;
+    memcpy(delivery->payload, data->payload, data->payload_len);
+}
+
+static void test_manager_delivery_encoding(void) {
+    printf("Testing route encoding on delivery...\n");
+
+    static const char json[] =
+        "{\"readings\":[21.5,21.5,21.5,21.5,21.5,21.5,21.5,21.5,21.5,21.5,"
+        "21.5,21.5,21.5,21.5,21.5,21.5],\"unit\":\"celsius\",\"ok\":true}";
+    uint8_t cbor[512];
+    size_t cbor_len;
+    assert(sensor_codec_json_to_cbor(json, strlen(json), cbor, sizeof(cbor), &cbor_len) ==
+           PAUMIOT_SUCCESS);
+
+    sensor_codec_routes_t* routes = sensor_codec_routes_create();
+    assert(routes != NULL);
+    sensor_codec_route_t route = {
+        .format = DATA_FORMAT_CBOR,
+        .compression = SENSOR_COMPRESSION_LZ4,
+        .dict = NULL
+    };
+    assert(sensor_codec_routes_add_route(routes, "sensors/temp/#", &route) == PAUMIOT_SUCCESS);
+
+    sensor_manager_config_t config;
+    sensor_manager_config_init(&config);
+    assert(config.routes == NULL && !config.enable_compression);
+    config.routes = routes;
+    config.enable_compression = true;
+    config.max_payload_size = 1024;
+    sensor_manager_t* sm = sensor_manager_init(&config);
+    assert(sm != NULL);
+
+    sensor_entry_t entry = make_entry("temp-1", "sensors/temp/{id}");
+    sensor_entry_t other = make_entry("other", "sensors/other");
+    assert(sensor_manager_register(sm, &entry) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_register(sm, &other) == PAUMIOT_SUCCESS);
+
+    delivery_t first = {0};
+    delivery_t second = {0};
+    assert(sensor_manager_subscribe_data(sm, NULL, on_encoded, &first) == PAUMIOT_SUCCESS);
+    assert(sensor_manager_subscribe_data(sm, "temp-1", on_encoded, &second) == PAUMIOT_SUCCESS);
+
+    /* Subscribers receive a compressed CBOR frame, encoded once */
+    sensor_data_t data = make_data("temp-1", json, 1000);
+    assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    assert(first.calls == 1 && second.calls == 1);
+    assert(first.compressed && first.format == DATA_FORMAT_CBOR);
+    assert(first.len == second.len && memcmp(first.payload, second.payload, first.len) == 0);
+    assert(first.len < cbor_len);
+
+    sensor_compressor_t* decoder = sensor_compressor_create(1024, 2);
+    assert(decoder != NULL);
+    uint8_t* decoded;
+    size_t decoded_len;
+    sensor_compression_t codec;
+    assert(sensor_compressor_decompress(decoder, first.payload, first.len, &decoded,
+                                        &decoded_len, &codec) == PAUMIOT_SUCCESS);
+    assert(codec == SENSOR_COMPRESSION_LZ4);
+    assert(decoded_len == cbor_len && memcmp(decoded, cbor, cbor_len) == 0);
+    sensor_compressor_release(decoder, decoded);
+
+    /* The reading is stored as published */
+    sensor_data_t* out = NULL;
+    assert(sensor_manager_get_data(sm, "temp-1", &out) == PAUMIOT_SUCCESS);
+    assert(out->format == DATA_FORMAT_JSON && !out->compressed);
+    assert(out->payload_len == strlen(json) && memcmp(out->payload, json, out->payload_len) == 0);
+    sensor_data_free(out);
+
+    /* Topics without a route are delivered as published */
+    sensor_data_t plain = make_data("other", "{\"t\":1}", 1000);
+    plain.topic = (char*)"sensors/other";
+    assert(sensor_manager_update_data(sm, &plain) == PAUMIOT_SUCCESS);
+    assert(first.calls == 2 && !first.compressed && first.format == DATA_FORMAT_JSON);
+    assert(first.len == strlen("{\"t\":1}"));
+
+    /* Unconvertible payloads fall back to the published bytes */
+    sensor_data_t broken = make_data("temp-1", "{\"t\":", 2000);
+    assert(sensor_manager_update_data(sm, &broken) == PAUMIOT_SUCCESS);
+    assert(first.calls == 3 && !first.compressed && first.format == DATA_FORMAT_JSON);
+    assert(first.len == strlen("{\"t\":"));
+
+    /* With compression disabled the route still converts the format */
+    config.enable_compression = false;
+    assert(sensor_manager_reconfigure(sm, &config) == PAUMIOT_SUCCESS);
+    data.timestamp = 3000;
+    assert(sensor_manager_update_data(sm, &data) == PAUMIOT_SUCCESS);
+    assert(first.calls == 4 && !first.compressed && first.format == DATA_FORMAT_CBOR);
+    assert(first.len == cbor_len && memcmp(first.payload, cbor, cbor_len) == 0);
+
+    /* Publishers cannot hand in frames */
+    data.compressed = true;
+    assert(sensor_manager_update_data(sm, &data) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    sensor_manager_stats_t stats;
+    assert(sensor_manager_get_stats(sm, &stats) == PAUMIOT_SUCCESS);
+    assert(stats.payloads_encoded == 2);
+    assert(stats.encode_failures == 1);
+
+    sensor_manager_cleanup(sm);
+    sensor_compressor_destroy(decoder);
+    sensor_codec_routes_destroy(routes);
+
+    printf("  ✓ Delivery encoding test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running sensor_manager.h tests...\n");
+    printf("========================================\n\n");
+
+    test_manager_lifecycle();
+    test_manager_registry();
+    test_manager_registry_growth();
+    test_manager_data_cache();
+    test_manager_cache_miss_refill();
+    test_manager_historical();
+    test_manager_aggregation();
+    test_manager_aggregation_timer();
+    test_manager_callbacks();
+    test_manager_deferred_dispatch();
+    test_manager_pinned_dispatch();
+    test_manager_slow_callback();
+    test_manager_concurrent_subscribe();
+    test_manager_unregister_during_update();
+    test_manager_delivery_encoding();
+    test_manager_health();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
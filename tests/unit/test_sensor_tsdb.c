@@ -0,0 +1,348 @@
+/**
+ * @file test_sensor_tsdb.c
+ * @brief Unit tests for the sensor time-series store
+ */
+
+#include "sensor_manager/sensor_tsdb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#define DAY_MS 86400000ULL
+
+/* 2023-11-14 00:00:00 UTC plus one hour */
+#define BASE_TS (19675ULL * DAY_MS + 3600000ULL)
+
+typedef struct {
+    uint64_t* timestamps;
+    double* values;
+    size_t count;
+    size_t capacity;
+    size_t batches;
+} collector_t;
+
+static void collect(const uint64_t* timestamps, const double* values,
+                    size_t count, void* user_data) {
+    collector_t* c = (collector_t*)user_data;
+    assert(c->count + count <= c->capacity);
+    memcpy(c->timestamps + c->count, timestamps, count * sizeof(uint64_t));
+    memcpy(c->values + c->count, values, count * sizeof(double));
+    c->count += count;
+    c->batches++;
+}
+
+static collector_t collector_new(size_t capacity) {
+    collector_t c = {
+        .timestamps = malloc(capacity * sizeof(uint64_t)),
+        .values = malloc(capacity * sizeof(double)),
+        .capacity = capacity
+    };
+    assert(c.timestamps && c.values);
+    return c;
+}
+
+static void collector_free(collector_t* c) {
+    free(c->timestamps);
+    free(c->values);
+}
+
+static char* make_temp_dir(void) {
+    char tmpl[] = "/tmp/paumiot_tsdb_XXXXXX";
+    char* dir = mkdtemp(tmpl);
+    assert(dir != NULL);
+    return strdup(dir);
+}
+
+static void remove_temp_dir(char* dir) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", dir);
+    assert(system(cmd) == 0);
+    free(dir);
+}
+
+static bool same_bits(double a, double b) {
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static void test_tsdb_open_close(void) {
+    printf("Testing TSDB open/close...\n");
+
+    char* dir = make_temp_dir();
+    char path[512];
+    snprintf(path, sizeof(path), "%s/nested/store", dir);
+
+    sensor_tsdb_t* db = sensor_tsdb_open(path, 0);
+    assert(db != NULL);
+
+    struct stat st;
+    assert(stat(path, &st) == 0 && S_ISDIR(st.st_mode));
+
+    sensor_tsdb_close(db);
+    sensor_tsdb_close(NULL);
+
+    assert(sensor_tsdb_open(NULL, 0) == NULL);
+    assert(sensor_tsdb_open("", 0) == NULL);
+
+    remove_temp_dir(dir);
+
+    printf("  ✓ TSDB open/close test passed\n");
+}
+
+static void test_tsdb_roundtrip(void) {
+    printf("Testing TSDB encode/decode round trip...\n");
+
+    char* dir = make_temp_dir();
+    sensor_tsdb_t* db = sensor_tsdb_open(dir, 0);
+    assert(db != NULL);
+
+    /* Spans several blocks: 1Hz with jitter, gaps, and awkward values */
+    const size_t n = 5000;
+    uint64_t* ts = malloc(n * sizeof(uint64_t));
+    double* vals = malloc(n * sizeof(double));
+    assert(ts && vals);
+
+    uint64_t t = BASE_TS;
+    double v = 20.0;
+    srand(42);
+    for (size_t i = 0; i < n; i++) {
+        t += 1000 + (uint64_t)(rand() % 7);
+        if (i % 777 == 0) {
+            t += 3600000;  /* Large gap */
+        }
+        v += (rand() % 200 - 100) / 100.0;
+        ts[i] = t;
+        vals[i] = v;
+    }
+    vals[10] = 0.0;
+    vals[11] = -0.0;
+    vals[12] = NAN;
+    vals[13] = INFINITY;
+    vals[14] = -1e300;
+    vals[15] = 5e-324;
+    ts[20] = ts[19] - 500;  /* Out-of-order point */
+
+    for (size_t i = 0; i < n; i++) {
+        assert(sensor_tsdb_append(db, "temp-1", ts[i], vals[i]) == PAUMIOT_SUCCESS);
+    }
+
+    /* Pending points are visible before any flush */
+    collector_t c = collector_new(n);
+    assert(sensor_tsdb_scan(db, "temp-1", 0, UINT64_MAX, collect, &c) == PAUMIOT_SUCCESS);
+    assert(c.count == n);
+    for (size_t i = 0; i < n; i++) {
+        assert(c.timestamps[i] == ts[i]);
+        assert(same_bits(c.values[i], vals[i]));
+    }
+    assert(c.batches >= n / SENSOR_TSDB_BLOCK_POINTS);
+
+    /* Range filtering */
+    c.count = 0;
+    uint64_t start = ts[1500];
+    uint64_t end = ts[3499];
+    assert(sensor_tsdb_scan(db, "temp-1", start, end, collect, &c) == PAUMIOT_SUCCESS);
+    assert(c.count == 2000);
+    for (size_t i = 0; i < c.count; i++) {
+        assert(c.timestamps[i] >= start && c.timestamps[i] <= end);
+    }
+
+    /* Unknown sensor and invalid ranges */
+    c.count = 0;
+    assert(sensor_tsdb_scan(db, "none", 0, UINT64_MAX, collect, &c) == PAUMIOT_SUCCESS);
+    assert(c.count == 0);
+    assert(sensor_tsdb_scan(db, "temp-1", 10, 5, collect, &c) == PAUMIOT_ERROR_INVALID_PARAM);
+
+    /* Everything survives close and reopen */
+    sensor_tsdb_close(db);
+    db = sensor_tsdb_open(dir, 0);
+    assert(db != NULL);
+
+    c.count = 0;
+    assert(sensor_tsdb_scan(db, "temp-1", 0, UINT64_MAX, collect, &c) == PAUMIOT_SUCCESS);
+    assert(c.count == n);
+    for (size_t i = 0; i < n; i++) {
+        assert(c.timestamps[i] == ts[i]);
+        assert(same_bits(c.values[i], vals[i]));
+    }
+
+    collector_free(&c);
+    free(ts);
+    free(vals);
+    sensor_tsdb_close(db);
+    remove_temp_dir(dir);
+
+    printf("  ✓ TSDB round trip test passed\n");
+}
+
+static void test_tsdb_compression(void) {
+    printf("Testing TSDB compression...\n");
+
+    char* dir = make_temp_dir();
+    sensor_tsdb_t* db = sensor_tsdb_open(dir, 0);
+    assert(db != NULL);
+
+    /* Regular 1Hz samples of a slowly changing value */
+    const size_t n = 3600;
+    for (size_t i = 0; i < n; i++) {
+        double v = 21.0 + (double)(i / 600) * 0.5;
+        assert(sensor_tsdb_append(db, "steady", BASE_TS + i * 1000, v) == PAUMIOT_SUCCESS);
+    }
+    assert(sensor_tsdb_flush(db) == PAUMIOT_SUCCESS);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/steady/20231114.seg", dir);
+    struct stat st;
+    assert(stat(path, &st) == 0);
+
+    /* Raw storage would be 16 bytes per point */
+    printf("  %zu points in %lld bytes (%.2f bytes/point)\n",
+           n, (long long)st.st_size, (double)st.st_size / (double)n);
+    assert((size_t)st.st_size < n);
+
+    sensor_tsdb_close(db);
+    remove_temp_dir(dir);
+
+    printf("  ✓ TSDB compression test passed\n");
+}
+
+static size_t count_segments(const char* dir) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        return 0;
+    }
+    size_t n = 0;
+    struct dirent* ent;
+    while ((ent = readdir(d)) != NULL) {
+        if (strstr(ent->d_name, ".seg")) {
+            n++;
+        }
+    }
+    closedir(d);
+    return n;
+}
+
+static void test_tsdb_daily_roll_and_retention(void) {
+    printf("Testing TSDB daily roll and retention...\n");
+
+    char* dir = make_temp_dir();
+    sensor_tsdb_t* db = sensor_tsdb_open(dir, 3);
+    assert(db != NULL);
+
+    /* Recent days, so retention triggered by block flushes keeps them */
+    uint64_t day0 = (uint64_t)time(NULL) / 86400 - 2;
+    for (uint64_t d = 0; d < 3; d++) {
+        for (uint64_t i = 0; i < 10; i++) {
+            uint64_t t = (day0 + d) * DAY_MS + i * 60000;
+            assert(sensor_tsdb_append(db, "roll/1", t, (double)d) == PAUMIOT_SUCCESS);
+        }
+    }
+    assert(sensor_tsdb_flush(db) == PAUMIOT_SUCCESS);
+
+    /* IDs are escaped into a single directory name */
+    char series_dir[512];
+    snprintf(series_dir, sizeof(series_dir), "%s/roll%%2F1", dir);
+    assert(count_segments(series_dir) == 3);
+
+    /* Three days before day0 + 4 reach back to day0 + 1: only day0 goes */
+    size_t removed = 0;
+    assert(sensor_tsdb_enforce_retention(db, (day0 + 4) * DAY_MS + 5, &removed) ==
+           PAUMIOT_SUCCESS);
+    assert(removed == 1);
+    assert(count_segments(series_dir) == 2);
+
+    collector_t c = collector_new(64);
+    assert(sensor_tsdb_scan(db, "roll/1", 0, UINT64_MAX, collect, &c) == PAUMIOT_SUCCESS);
+    assert(c.count == 20);
+    assert(c.values[0] == 1.0);
+    collector_free(&c);
+
+    sensor_tsdb_close(db);
+    remove_temp_dir(dir);
+
+    printf("  ✓ TSDB daily roll and retention test passed\n");
+}
+
+static off_t file_size(const char* path) {
+    struct stat st;
+    assert(stat(path, &st) == 0);
+    return st.st_size;
+}
+
+static void test_tsdb_short_write(void) {
+    printf("Testing TSDB recovery from a short write...\n");
+
+    char* dir = make_temp_dir();
+    sensor_tsdb_t* db = sensor_tsdb_open(dir, 0);
+    assert(db != NULL);
+
+    for (uint64_t i = 0; i < 100; i++) {
+        assert(sensor_tsdb_append(db, "short", BASE_TS + i * 1000, (double)i) ==
+               PAUMIOT_SUCCESS);
+    }
+    assert(sensor_tsdb_flush(db) == PAUMIOT_SUCCESS);
+
+    char segment[512];
+    snprintf(segment, sizeof(segment), "%s/short/20231114.seg", dir);
+    off_t whole = file_size(segment);
+
+    /* A file size limit a few bytes past the end cuts the next block short */
+    for (uint64_t i = 100; i < 200; i++) {
+        assert(sensor_tsdb_append(db, "short", BASE_TS + i * 1000, (double)i) ==
+               PAUMIOT_SUCCESS);
+    }
+    struct rlimit saved;
+    assert(getrlimit(RLIMIT_FSIZE, &saved) == 0);
+    struct rlimit limit = { (rlim_t)whole + 10, saved.rlim_max };
+    signal(SIGXFSZ, SIG_IGN);
+    assert(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+    assert(sensor_tsdb_flush(db) == PAUMIOT_ERROR_OPERATION_FAILED);
+    assert(setrlimit(RLIMIT_FSIZE, &saved) == 0);
+    signal(SIGXFSZ, SIG_DFL);
+    assert(file_size(segment) == whole);
+
+    /* The block stayed open: it is still visible and written whole later */
+    collector_t c = collector_new(256);
+    assert(sensor_tsdb_scan(db, "short", 0, UINT64_MAX, collect, &c) == PAUMIOT_SUCCESS);
+    assert(c.count == 200);
+    assert(sensor_tsdb_flush(db) == PAUMIOT_SUCCESS);
+    sensor_tsdb_close(db);
+
+    db = sensor_tsdb_open(dir, 0);
+    assert(db != NULL);
+    c.count = 0;
+    assert(sensor_tsdb_scan(db, "short", 0, UINT64_MAX, collect, &c) == PAUMIOT_SUCCESS);
+    assert(c.count == 200);
+    for (size_t i = 0; i < c.count; i++) {
+        assert(c.values[i] == (double)i);
+    }
+    collector_free(&c);
+
+    sensor_tsdb_close(db);
+    remove_temp_dir(dir);
+
+    printf("  ✓ TSDB short write test passed\n");
+}
+
+int main(void) {
+    printf("\n========================================\n");
+    printf("Running sensor_tsdb.h tests...\n");
+    printf("========================================\n\n");
+
+    test_tsdb_open_close();
+    test_tsdb_roundtrip();
+    test_tsdb_compression();
+    test_tsdb_daily_roll_and_retention();
+    test_tsdb_short_write();
+
+    printf("\n========================================\n");
+    printf("✅ All tests passed successfully!\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
@@ -0,0 +1,415 @@
+/**
+ * @file loadgen.c
+ * @brief paumiot-loadgen entry point: options, threads and the report
+ * @details Usage: paumiot-loadgen [options], see --help. The text report
+ *          (or one JSON object with --json) gives throughput over the
+ *          publishing window and p50/p90/p99/p99.9/max for each latency.
+ */
+
+#include "loadgen.h"
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+typedef struct {
+    loadgen_worker_t *worker;
+    uint64_t start_ns;
+    pthread_t thread;
+} worker_slot_t;
+
+/* ============================================================================
+ * HISTOGRAMS
+ * ========================================================================= */
+
+static unsigned hist_index(uint64_t ns) {
+    if (ns < (1u << LOADGEN_HIST_SUB_BITS)) {
+        return (unsigned)ns;
+    }
+    unsigned msb = 63 - (unsigned)__builtin_clzll(ns);
+    unsigned shift = msb - LOADGEN_HIST_SUB_BITS;
+    unsigned sub = (unsigned)(ns >> shift) & ((1u << LOADGEN_HIST_SUB_BITS) - 1);
+    return (shift + 1) << LOADGEN_HIST_SUB_BITS | sub;
+}
+
+static uint64_t hist_upper(unsigned index) {
+    if (index < (1u << LOADGEN_HIST_SUB_BITS)) {
+        return index;
+    }
+    unsigned shift = (index >> LOADGEN_HIST_SUB_BITS) - 1;
+    uint64_t sub = index & ((1u << LOADGEN_HIST_SUB_BITS) - 1);
+    uint64_t lower = ((1ULL << LOADGEN_HIST_SUB_BITS) | sub) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+void loadgen_hist_record(loadgen_hist_t *hist, uint64_t ns) {
+    hist->counts[hist_index(ns)]++;
+    hist->total++;
+    if (ns > hist->max) {
+        hist->max = ns;
+    }
+}
+
+void loadgen_hist_merge(loadgen_hist_t *dst, const loadgen_hist_t *src) {
+    for (unsigned i = 0; i < LOADGEN_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+uint64_t loadgen_hist_percentile(const loadgen_hist_t *hist, double p) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)hist->total + 0.5);
+    rank = rank ? rank : 1;
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < LOADGEN_HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t upper = hist_upper(i);
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+void loadgen_stats_merge(loadgen_stats_t *dst, const loadgen_stats_t *src) {
+    dst->mqtt_published += src->mqtt_published;
+    dst->mqtt_acked += src->mqtt_acked;
+    dst->mqtt_delivered += src->mqtt_delivered;
+    dst->throttled += src->throttled;
+    dst->coap_sent += src->coap_sent;
+    dst->coap_acked += src->coap_acked;
+    dst->coap_lost += src->coap_lost;
+    dst->bytes_sent += src->bytes_sent;
+    dst->bytes_received += src->bytes_received;
+    dst->connects += src->connects;
+    dst->connect_failures += src->connect_failures;
+    dst->disconnects += src->disconnects;
+    dst->storm_drops += src->storm_drops;
+    dst->protocol_errors += src->protocol_errors;
+
+    loadgen_hist_merge(&dst->e2e, &src->e2e);
+    loadgen_hist_merge(&dst->mqtt_ack, &src->mqtt_ack);
+    loadgen_hist_merge(&dst->coap_ack, &src->coap_ack);
+    loadgen_hist_merge(&dst->connect, &src->connect);
+}
+
+/* ============================================================================
+ * OPTIONS
+ * ========================================================================= */
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options]\n"
+           "\n"
+           "Gateway:\n"
+           "  --host ADDR          IPv4 address (default 127.0.0.1)\n"
+           "  --mqtt-port PORT     MQTT port (default 1883)\n"
+           "  --coap-port PORT     CoAP port (default 5683)\n"
+           "\n"
+           "Fleet:\n"
+           "  --mqtt N             MQTT publishers (default 100)\n"
+           "  --coap N             CoAP publishers (default 0)\n"
+           "  --subscribers N      MQTT subscribers to loadgen/t/# (default 1)\n"
+           "  --threads N          epoll worker threads (default 2)\n"
+           "\n"
+           "Traffic:\n"
+           "  --rate R             messages/s per publisher (default 1)\n"
+           "  --poisson            exponential gaps instead of fixed ones\n"
+           "  --payload SPEC       fixed:N | uniform:MIN:MAX | exp:MEAN[:MAX] (default fixed:64)\n"
+           "  --topics K           topic cardinality (default 100)\n"
+           "  --qos1 PCT           share of QoS 1 / CON messages (default 0)\n"
+           "  --keepalive S        MQTT keep-alive (default 60)\n"
+           "  --storm S:FRACTION   every S seconds drop FRACTION of MQTT sessions\n"
+           "\n"
+           "Run:\n"
+           "  --duration S         publishing time (default 10)\n"
+           "  --ramp S             spread connections over S seconds (default 1)\n"
+           "  --drain S            wait for acks and deliveries after (default 2)\n"
+           "  --seed N             random seed (default 1)\n"
+           "  --json               print the report as one JSON object\n",
+           prog);
+}
+
+static bool parse_payload(const char *spec, loadgen_payload_spec_t *out) {
+    unsigned long a = 0;
+    unsigned long b = 0;
+    char tail;
+
+    memset(out, 0, sizeof(*out));
+    if (sscanf(spec, "fixed:%lu%c", &a, &tail) == 1) {
+        out->dist = PAYLOAD_FIXED;
+        out->min = out->max = a;
+    } else if (sscanf(spec, "uniform:%lu:%lu%c", &a, &b, &tail) == 2 && a <= b) {
+        out->dist = PAYLOAD_UNIFORM;
+        out->min = a;
+        out->max = b;
+    } else if (sscanf(spec, "exp:%lu:%lu%c", &a, &b, &tail) == 2 ||
+               sscanf(spec, "exp:%lu%c", &a, &tail) == 1) {
+        out->dist = PAYLOAD_EXPONENTIAL;
+        out->min = LOADGEN_PAYLOAD_HEADER;
+        out->max = b ? b : LOADGEN_MAX_PAYLOAD;
+        out->mean = (double)a;
+    } else {
+        return false;
+    }
+
+    /* Every payload carries the timestamp header */
+    if (out->min < LOADGEN_PAYLOAD_HEADER) {
+        out->min = LOADGEN_PAYLOAD_HEADER;
+    }
+    if (out->max > LOADGEN_MAX_PAYLOAD) {
+        out->max = LOADGEN_MAX_PAYLOAD;
+    }
+    return out->min <= out->max && (out->dist != PAYLOAD_EXPONENTIAL || out->mean > out->min);
+}
+
+static int parse_args(int argc, char **argv, loadgen_options_t *opt) {
+    static const struct option long_options[] = {
+        { "host", required_argument, NULL, 'h' },
+        { "mqtt-port", required_argument, NULL, 'P' },
+        { "coap-port", required_argument, NULL, 'C' },
+        { "mqtt", required_argument, NULL, 'm' },
+        { "coap", required_argument, NULL, 'c' },
+        { "subscribers", required_argument, NULL, 's' },
+        { "threads", required_argument, NULL, 't' },
+        { "rate", required_argument, NULL, 'r' },
+        { "poisson", no_argument, NULL, 'p' },
+        { "payload", required_argument, NULL, 'l' },
+        { "topics", required_argument, NULL, 'k' },
+        { "qos1", required_argument, NULL, 'q' },
+        { "keepalive", required_argument, NULL, 'K' },
+        { "storm", required_argument, NULL, 'S' },
+        { "duration", required_argument, NULL, 'd' },
+        { "ramp", required_argument, NULL, 'R' },
+        { "drain", required_argument, NULL, 'D' },
+        { "seed", required_argument, NULL, 'x' },
+        { "json", no_argument, NULL, 'j' },
+        { "help", no_argument, NULL, 'H' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    memset(opt, 0, sizeof(*opt));
+    opt->host = "127.0.0.1";
+    opt->mqtt_port = 1883;
+    opt->coap_port = 5683;
+    opt->mqtt_devices = 100;
+    opt->subscribers = 1;
+    opt->threads = 2;
+    opt->rate = 1.0;
+    opt->duration_s = 10.0;
+    opt->ramp_s = 1.0;
+    opt->drain_s = 2.0;
+    parse_payload("fixed:64", &opt->payload);
+    opt->topics = 100;
+    opt->keepalive_s = 60;
+    opt->seed = 1;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'h': opt->host = optarg; break;
+        case 'P': opt->mqtt_port = (uint16_t)strtoul(optarg, NULL, 10); break;
+        case 'C': opt->coap_port = (uint16_t)strtoul(optarg, NULL, 10); break;
+        case 'm': opt->mqtt_devices = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 'c': opt->coap_devices = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 's': opt->subscribers = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 't': opt->threads = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 'r': opt->rate = strtod(optarg, NULL); break;
+        case 'p': opt->poisson = true; break;
+        case 'k': opt->topics = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 'q': opt->qos1_percent = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 'K': opt->keepalive_s = (uint16_t)strtoul(optarg, NULL, 10); break;
+        case 'd': opt->duration_s = strtod(optarg, NULL); break;
+        case 'R': opt->ramp_s = strtod(optarg, NULL); break;
+        case 'D': opt->drain_s = strtod(optarg, NULL); break;
+        case 'x': opt->seed = strtoull(optarg, NULL, 0); break;
+        case 'j': opt->json = true; break;
+        case 'l':
+            if (!parse_payload(optarg, &opt->payload)) {
+                fprintf(stderr, "invalid --payload '%s'\n", optarg);
+                return -1;
+            }
+            break;
+        case 'S':
+            if (sscanf(optarg, "%lf:%lf", &opt->storm_interval_s, &opt->storm_fraction) != 2 ||
+                opt->storm_interval_s <= 0 || opt->storm_fraction < 0 ||
+                opt->storm_fraction > 1) {
+                fprintf(stderr, "invalid --storm '%s'\n", optarg);
+                return -1;
+            }
+            break;
+        case 'H':
+            usage(argv[0]);
+            return 1;
+        default:
+            fprintf(stderr, "see --help\n");
+            return -1;
+        }
+    }
+
+    if (optind < argc || opt->threads == 0 || opt->threads > LOADGEN_MAX_THREADS ||
+        opt->rate <= 0 || opt->topics == 0 || opt->qos1_percent > 100 ||
+        opt->keepalive_s == 0 || opt->duration_s <= 0 || opt->ramp_s < 0 || opt->drain_s < 0) {
+        fprintf(stderr, "invalid options, see --help\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * REPORT
+ * ========================================================================= */
+
+static void print_hist_text(const char *name, const loadgen_hist_t *hist) {
+    printf("  %-14s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name,
+           (unsigned long long)hist->total, loadgen_hist_percentile(hist, 50) / 1e3,
+           loadgen_hist_percentile(hist, 90) / 1e3, loadgen_hist_percentile(hist, 99) / 1e3,
+           loadgen_hist_percentile(hist, 99.9) / 1e3, hist->max / 1e3);
+}
+
+static void print_hist_json(const char *name, const loadgen_hist_t *hist) {
+    printf(",\"%s\":{\"count\":%llu,\"p50_us\":%.1f,\"p90_us\":%.1f,\"p99_us\":%.1f,"
+           "\"p999_us\":%.1f,\"max_us\":%.1f}",
+           name, (unsigned long long)hist->total, loadgen_hist_percentile(hist, 50) / 1e3,
+           loadgen_hist_percentile(hist, 90) / 1e3, loadgen_hist_percentile(hist, 99) / 1e3,
+           loadgen_hist_percentile(hist, 99.9) / 1e3, hist->max / 1e3);
+}
+
+static void print_report(const loadgen_options_t *opt, const loadgen_stats_t *s) {
+    /* Rates are averaged over the whole publishing window, ramp included */
+    double window = opt->ramp_s + opt->duration_s;
+
+    if (opt->json) {
+        printf("{\"mqtt_devices\":%u,\"coap_devices\":%u,\"subscribers\":%u,\"threads\":%u,"
+               "\"window_s\":%.3f,\"mqtt_published\":%llu,\"mqtt_acked\":%llu,"
+               "\"mqtt_delivered\":%llu,\"coap_sent\":%llu,\"coap_acked\":%llu,"
+               "\"coap_lost\":%llu,\"throttled\":%llu,\"publish_per_s\":%.1f,"
+               "\"deliver_per_s\":%.1f,\"mb_out_per_s\":%.3f,\"mb_in_per_s\":%.3f,"
+               "\"connects\":%llu,\"connect_failures\":%llu,\"disconnects\":%llu,"
+               "\"storm_drops\":%llu,\"protocol_errors\":%llu",
+               opt->mqtt_devices, opt->coap_devices, opt->subscribers, opt->threads, window,
+               (unsigned long long)s->mqtt_published, (unsigned long long)s->mqtt_acked,
+               (unsigned long long)s->mqtt_delivered, (unsigned long long)s->coap_sent,
+               (unsigned long long)s->coap_acked, (unsigned long long)s->coap_lost,
+               (unsigned long long)s->throttled,
+               (double)(s->mqtt_published + s->coap_sent) / window,
+               (double)s->mqtt_delivered / window, (double)s->bytes_sent / window / 1e6,
+               (double)s->bytes_received / window / 1e6, (unsigned long long)s->connects,
+               (unsigned long long)s->connect_failures, (unsigned long long)s->disconnects,
+               (unsigned long long)s->storm_drops, (unsigned long long)s->protocol_errors);
+        print_hist_json("e2e", &s->e2e);
+        print_hist_json("mqtt_ack", &s->mqtt_ack);
+        print_hist_json("coap_ack", &s->coap_ack);
+        print_hist_json("connect", &s->connect);
+        printf("}\n");
+        return;
+    }
+
+    printf("paumiot-loadgen: %u MQTT + %u CoAP publishers, %u subscribers, %u threads, "
+           "%.1f s window\n\n",
+           opt->mqtt_devices, opt->coap_devices, opt->subscribers, opt->threads, window);
+    printf("Messages\n");
+    printf("  MQTT published %10llu  (%.1f/s), acked %llu\n",
+           (unsigned long long)s->mqtt_published, (double)s->mqtt_published / window,
+           (unsigned long long)s->mqtt_acked);
+    printf("  MQTT delivered %10llu  (%.1f/s)\n", (unsigned long long)s->mqtt_delivered,
+           (double)s->mqtt_delivered / window);
+    printf("  CoAP sent      %10llu  (%.1f/s), acked %llu, lost %llu\n",
+           (unsigned long long)s->coap_sent, (double)s->coap_sent / window,
+           (unsigned long long)s->coap_acked, (unsigned long long)s->coap_lost);
+    printf("  Throttled      %10llu\n", (unsigned long long)s->throttled);
+    printf("  Bytes out/in   %.2f / %.2f MB/s\n\n", (double)s->bytes_sent / window / 1e6,
+           (double)s->bytes_received / window / 1e6);
+
+    printf("Latency (us)          count        p50        p90        p99      p99.9        max\n");
+    print_hist_text("end-to-end", &s->e2e);
+    print_hist_text("MQTT PUBACK", &s->mqtt_ack);
+    print_hist_text("CoAP ACK", &s->coap_ack);
+    print_hist_text("connect", &s->connect);
+
+    printf("\nSessions: %llu connects, %llu failures, %llu closed by gateway, "
+           "%llu storm drops, %llu protocol errors\n",
+           (unsigned long long)s->connects, (unsigned long long)s->connect_failures,
+           (unsigned long long)s->disconnects, (unsigned long long)s->storm_drops,
+           (unsigned long long)s->protocol_errors);
+}
+
+/* ============================================================================
+ * MAIN
+ * ========================================================================= */
+
+static void *worker_thread(void *arg) {
+    worker_slot_t *slot = arg;
+    loadgen_worker_run(slot->worker, slot->start_ns);
+    return NULL;
+}
+
+/* One descriptor per device plus slack */
+static void raise_fd_limit(unsigned devices) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur >= (rlim_t)devices + 64) {
+        return;
+    }
+    rl.rlim_cur = (rlim_t)devices + 64 < rl.rlim_max ? (rlim_t)devices + 64 : rl.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur < (rlim_t)devices + 64) {
+        fprintf(stderr, "warning: open file limit %llu is below %u devices\n",
+                (unsigned long long)rl.rlim_cur, devices);
+    }
+}
+
+/* Share of count owned by worker index out of n */
+static unsigned share(unsigned count, unsigned index, unsigned n) {
+    return count / n + (index < count % n ? 1 : 0);
+}
+
+int main(int argc, char **argv) {
+    loadgen_options_t options;
+    int rc = parse_args(argc, argv, &options);
+    if (rc != 0) {
+        return rc > 0 ? 0 : 2;
+    }
+
+    unsigned devices = options.mqtt_devices + options.coap_devices + options.subscribers;
+    raise_fd_limit(devices);
+
+    static worker_slot_t slots[LOADGEN_MAX_THREADS];
+    unsigned first_device = 0;
+    for (unsigned i = 0; i < options.threads; i++) {
+        unsigned mqtt = share(options.mqtt_devices, i, options.threads);
+        unsigned coap = share(options.coap_devices, i, options.threads);
+        unsigned subs = share(options.subscribers, i, options.threads);
+        slots[i].worker = loadgen_worker_create(&options, i, first_device, mqtt, coap, subs);
+        if (!slots[i].worker) {
+            fprintf(stderr, "cannot create worker %u (is --host an IPv4 address?)\n", i);
+            return 1;
+        }
+        first_device += mqtt + coap + subs;
+    }
+
+    uint64_t start_ns = loadgen_now_ns();
+    for (unsigned i = 0; i < options.threads; i++) {
+        slots[i].start_ns = start_ns;
+        if (pthread_create(&slots[i].thread, NULL, worker_thread, &slots[i]) != 0) {
+            fprintf(stderr, "cannot start worker %u\n", i);
+            return 1;
+        }
+    }
+
+    static loadgen_stats_t total;
+    for (unsigned i = 0; i < options.threads; i++) {
+        pthread_join(slots[i].thread, NULL);
+        loadgen_stats_merge(&total, loadgen_worker_stats(slots[i].worker));
+        loadgen_worker_destroy(slots[i].worker);
+    }
+
+    print_report(&options, &total);
+    return total.connects == 0 && total.coap_sent == 0 ? 1 : 0;
+}
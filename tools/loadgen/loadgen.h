@@ -0,0 +1,263 @@
+/**
+ * @file loadgen.h
+ * @brief paumiot-loadgen - simulated MQTT/CoAP device fleets
+ * @details Drives many virtual devices from a few epoll threads against a
+ *          gateway (any MQTT 3.1.1 broker and CoAP server will do):
+ *
+ *          - MQTT publishers connect, then publish at a set rate with a mix
+ *            of QoS 0 and QoS 1 to one of --topics topics.
+ *          - MQTT subscribers subscribe to every loadgen topic, so each
+ *            publish fans out to all of them.
+ *          - CoAP devices POST the same payloads, CON for the QoS 1 share
+ *            and NON otherwise.
+ *
+ *          Every payload starts with a header carrying the send time, so a
+ *          subscriber can time delivery end to end (sender and receiver
+ *          share this host's monotonic clock). Acknowledgements (PUBACK,
+ *          CoAP ACK) and connection setup are timed as well.
+ *
+ *          Each worker thread owns its devices outright: sockets, timers
+ *          and statistics are never shared, and the main thread merges the
+ *          statistics after the workers stop.
+ */
+
+#ifndef PAUMIOT_LOADGEN_H
+#define PAUMIOT_LOADGEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Limits */
+#define LOADGEN_MAX_THREADS 64
+#define LOADGEN_MAX_PAYLOAD 60000       /* Fits a UDP datagram */
+#define LOADGEN_PAYLOAD_HEADER 16       /* Magic + send time */
+#define LOADGEN_WINDOW 64               /* Unacknowledged QoS 1/CON per device */
+#define LOADGEN_TOPIC_PREFIX "loadgen/t/"
+
+/* Latency histogram: 16 linear sub-buckets per power of two of nanoseconds */
+#define LOADGEN_HIST_SUB_BITS 4
+#define LOADGEN_HIST_BUCKETS (64 << LOADGEN_HIST_SUB_BITS)
+
+/* ============================================================================
+ * OPTIONS
+ * ========================================================================= */
+
+typedef enum {
+    PAYLOAD_FIXED,                      /* Always min bytes */
+    PAYLOAD_UNIFORM,                    /* Uniform in [min, max] */
+    PAYLOAD_EXPONENTIAL                 /* min + Exp(mean - min), capped at max */
+} loadgen_payload_dist_t;
+
+typedef struct {
+    loadgen_payload_dist_t dist;
+    size_t min;
+    size_t max;
+    double mean;
+} loadgen_payload_spec_t;
+
+typedef struct {
+    const char *host;                   /* IPv4 address of the gateway */
+    uint16_t mqtt_port;
+    uint16_t coap_port;
+
+    unsigned mqtt_devices;              /* MQTT publishers */
+    unsigned coap_devices;              /* CoAP publishers */
+    unsigned subscribers;               /* MQTT subscribers (fan-out) */
+    unsigned threads;                   /* Epoll worker threads */
+
+    double rate;                        /* Messages per second per publisher */
+    bool poisson;                       /* Exponential gaps instead of fixed */
+    double duration_s;                  /* Publishing time */
+    double ramp_s;                      /* Connections spread over this time */
+    double drain_s;                     /* Wait for acks/deliveries after */
+
+    loadgen_payload_spec_t payload;
+    unsigned topics;                    /* Topic cardinality */
+    unsigned qos1_percent;              /* Share of QoS 1 (MQTT) / CON (CoAP) */
+    uint16_t keepalive_s;
+
+    double storm_interval_s;            /* 0 = no reconnect storms */
+    double storm_fraction;              /* Share of MQTT devices dropped */
+
+    uint64_t seed;
+    bool json;                          /* Print the report as JSON */
+} loadgen_options_t;
+
+/* ============================================================================
+ * STATISTICS
+ * ========================================================================= */
+
+typedef struct {
+    uint64_t counts[LOADGEN_HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} loadgen_hist_t;
+
+typedef struct {
+    uint64_t mqtt_published;
+    uint64_t mqtt_acked;                /* PUBACKs */
+    uint64_t mqtt_delivered;            /* PUBLISHes received by subscribers */
+    uint64_t throttled;                 /* Publishes skipped: window or socket full */
+    uint64_t coap_sent;
+    uint64_t coap_acked;
+    uint64_t coap_lost;                 /* CON never acknowledged */
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t connects;                  /* Completed MQTT sessions */
+    uint64_t connect_failures;
+    uint64_t disconnects;               /* Closed by the gateway */
+    uint64_t storm_drops;               /* Closed by a reconnect storm */
+    uint64_t protocol_errors;
+
+    loadgen_hist_t e2e;                 /* Publish to subscriber delivery */
+    loadgen_hist_t mqtt_ack;            /* PUBLISH to PUBACK */
+    loadgen_hist_t coap_ack;            /* CON to ACK */
+    loadgen_hist_t connect;             /* TCP connect to CONNACK/SUBACK */
+} loadgen_stats_t;
+
+/**
+ * Record a latency
+ */
+void loadgen_hist_record(loadgen_hist_t *hist, uint64_t ns);
+
+/**
+ * Add src into dst
+ */
+void loadgen_hist_merge(loadgen_hist_t *dst, const loadgen_hist_t *src);
+
+/**
+ * Upper bound of the bucket holding percentile p (0-100)
+ */
+uint64_t loadgen_hist_percentile(const loadgen_hist_t *hist, double p);
+
+/**
+ * Add every counter and histogram of src into dst
+ */
+void loadgen_stats_merge(loadgen_stats_t *dst, const loadgen_stats_t *src);
+
+/* ============================================================================
+ * WIRE FORMATS (loadgen_proto.c)
+ * ========================================================================= */
+
+/* MQTT control packet types */
+#define MQTT_CONNECT 1
+#define MQTT_CONNACK 2
+#define MQTT_PUBLISH 3
+#define MQTT_PUBACK 4
+#define MQTT_SUBSCRIBE 8
+#define MQTT_SUBACK 9
+#define MQTT_PINGREQ 12
+#define MQTT_PINGRESP 13
+#define MQTT_DISCONNECT 14
+
+/**
+ * Encode CONNECT (clean session, no credentials)
+ * @return Bytes written, 0 if buf is too small
+ */
+size_t mqtt_encode_connect(uint8_t *buf, size_t size, const char *client_id,
+                           uint16_t keepalive_s);
+
+/**
+ * Encode PUBLISH; packet_id is ignored for QoS 0
+ * @return Bytes written, 0 if buf is too small
+ */
+size_t mqtt_encode_publish(uint8_t *buf, size_t size, const char *topic, int qos,
+                           uint16_t packet_id, const uint8_t *payload, size_t payload_len);
+
+/**
+ * Encode SUBSCRIBE for one filter
+ * @return Bytes written, 0 if buf is too small
+ */
+size_t mqtt_encode_subscribe(uint8_t *buf, size_t size, uint16_t packet_id,
+                             const char *filter, int qos);
+
+/**
+ * Encode a two-byte packet (PINGREQ, DISCONNECT)
+ * @return Bytes written
+ */
+size_t mqtt_encode_simple(uint8_t *buf, uint8_t type);
+
+/**
+ * Find the next complete packet in a receive buffer
+ * @param buf Received bytes
+ * @param len Number of bytes
+ * @param type Receives the packet type
+ * @param flags Receives the fixed header flags
+ * @param body Receives the offset of the variable header
+ * @param body_len Receives the remaining length
+ * @return Total packet length, 0 if incomplete, or -1 if malformed
+ */
+long mqtt_parse_packet(const uint8_t *buf, size_t len, uint8_t *type, uint8_t *flags,
+                       size_t *body, size_t *body_len);
+
+/**
+ * Locate the payload of a PUBLISH body
+ * @return Payload offset within the body, or -1 if malformed
+ */
+long mqtt_publish_payload(const uint8_t *body, size_t body_len, uint8_t flags);
+
+/**
+ * Encode a CoAP POST to /loadgen/t/<topic>
+ * @return Bytes written, 0 if buf is too small
+ */
+size_t coap_encode_post(uint8_t *buf, size_t size, bool confirmable, uint16_t message_id,
+                        unsigned topic, const uint8_t *payload, size_t payload_len);
+
+/**
+ * Read the type and message ID of a CoAP datagram
+ * @return true if the header is valid
+ */
+bool coap_parse_header(const uint8_t *buf, size_t len, uint8_t *type, uint16_t *message_id);
+
+/**
+ * Write the payload header: magic and send time
+ */
+void loadgen_payload_stamp(uint8_t *payload, uint64_t now_ns);
+
+/**
+ * Read the send time from a payload header
+ * @return true if the payload carries one
+ */
+bool loadgen_payload_time(const uint8_t *payload, size_t len, uint64_t *sent_ns);
+
+/* ============================================================================
+ * WORKERS (loadgen_worker.c)
+ * ========================================================================= */
+
+typedef struct loadgen_worker loadgen_worker_t;
+
+/**
+ * Create a worker for a slice of the fleet
+ * @param options Run options (must outlive the worker)
+ * @param index Worker index
+ * @param first_device First global device index owned by this worker
+ * @param mqtt, coap, subscribers Number of devices of each kind
+ * @return Worker or NULL on failure
+ */
+loadgen_worker_t *loadgen_worker_create(const loadgen_options_t *options, unsigned index,
+                                        unsigned first_device, unsigned mqtt, unsigned coap,
+                                        unsigned subscribers);
+
+/**
+ * Run the worker until publishing and draining are over
+ * @param start_ns Common start time
+ */
+void loadgen_worker_run(loadgen_worker_t *worker, uint64_t start_ns);
+
+/**
+ * Statistics of a finished worker
+ */
+const loadgen_stats_t *loadgen_worker_stats(const loadgen_worker_t *worker);
+
+/**
+ * Close every socket and free the worker
+ */
+void loadgen_worker_destroy(loadgen_worker_t *worker);
+
+/**
+ * Monotonic clock in nanoseconds
+ */
+uint64_t loadgen_now_ns(void);
+
+#endif /* PAUMIOT_LOADGEN_H */
@@ -0,0 +1,218 @@
+/**
+ * @file loadgen_proto.c
+ * @brief Minimal MQTT 3.1.1 and CoAP framing for paumiot-loadgen
+ * @details Only what a simulated device sends and needs to read back. The
+ *          PAL adapters build a message_t per packet; a load generator
+ *          producing hundreds of thousands of packets per second writes the
+ *          bytes directly instead.
+ */
+
+#include "loadgen.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PAYLOAD_MAGIC "PLG1"
+
+/* ============================================================================
+ * MQTT
+ * ========================================================================= */
+
+static size_t put_var_int(uint8_t *buf, size_t value) {
+    size_t n = 0;
+    do {
+        uint8_t byte = value % 128;
+        value /= 128;
+        buf[n++] = value ? byte | 0x80 : byte;
+    } while (value);
+    return n;
+}
+
+static size_t put_string(uint8_t *buf, const char *s, size_t len) {
+    buf[0] = (uint8_t)(len >> 8);
+    buf[1] = (uint8_t)len;
+    memcpy(buf + 2, s, len);
+    return len + 2;
+}
+
+/* Fixed header + remaining length; returns the header size */
+static size_t put_header(uint8_t *buf, uint8_t first, size_t remaining) {
+    buf[0] = first;
+    return 1 + put_var_int(buf + 1, remaining);
+}
+
+size_t mqtt_encode_connect(uint8_t *buf, size_t size, const char *client_id,
+                           uint16_t keepalive_s) {
+    size_t id_len = strlen(client_id);
+    size_t remaining = 10 + 2 + id_len;
+    if (id_len > 65535 || size < remaining + 5) {
+        return 0;
+    }
+
+    size_t pos = put_header(buf, MQTT_CONNECT << 4, remaining);
+    pos += put_string(buf + pos, "MQTT", 4);
+    buf[pos++] = 4;                         /* Protocol level 3.1.1 */
+    buf[pos++] = 0x02;                      /* Clean session */
+    buf[pos++] = (uint8_t)(keepalive_s >> 8);
+    buf[pos++] = (uint8_t)keepalive_s;
+    pos += put_string(buf + pos, client_id, id_len);
+    return pos;
+}
+
+size_t mqtt_encode_publish(uint8_t *buf, size_t size, const char *topic, int qos,
+                           uint16_t packet_id, const uint8_t *payload, size_t payload_len) {
+    size_t topic_len = strlen(topic);
+    size_t remaining = 2 + topic_len + (qos > 0 ? 2 : 0) + payload_len;
+    if (topic_len > 65535 || size < remaining + 5) {
+        return 0;
+    }
+
+    size_t pos = put_header(buf, (uint8_t)(MQTT_PUBLISH << 4 | (qos & 3) << 1), remaining);
+    pos += put_string(buf + pos, topic, topic_len);
+    if (qos > 0) {
+        buf[pos++] = (uint8_t)(packet_id >> 8);
+        buf[pos++] = (uint8_t)packet_id;
+    }
+    memcpy(buf + pos, payload, payload_len);
+    return pos + payload_len;
+}
+
+size_t mqtt_encode_subscribe(uint8_t *buf, size_t size, uint16_t packet_id,
+                             const char *filter, int qos) {
+    size_t filter_len = strlen(filter);
+    size_t remaining = 2 + 2 + filter_len + 1;
+    if (filter_len > 65535 || size < remaining + 5) {
+        return 0;
+    }
+
+    size_t pos = put_header(buf, MQTT_SUBSCRIBE << 4 | 0x02, remaining);
+    buf[pos++] = (uint8_t)(packet_id >> 8);
+    buf[pos++] = (uint8_t)packet_id;
+    pos += put_string(buf + pos, filter, filter_len);
+    buf[pos++] = (uint8_t)qos;
+    return pos;
+}
+
+size_t mqtt_encode_simple(uint8_t *buf, uint8_t type) {
+    buf[0] = (uint8_t)(type << 4);
+    buf[1] = 0;
+    return 2;
+}
+
+long mqtt_parse_packet(const uint8_t *buf, size_t len, uint8_t *type, uint8_t *flags,
+                       size_t *body, size_t *body_len) {
+    if (len < 2) {
+        return 0;
+    }
+
+    size_t remaining = 0;
+    size_t pos = 1;
+    for (unsigned shift = 0;; shift += 7) {
+        if (pos >= len) {
+            return 0;
+        }
+        if (shift > 21) {
+            return -1;
+        }
+        uint8_t byte = buf[pos++];
+        remaining |= (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    if (len - pos < remaining) {
+        return 0;
+    }
+    *type = buf[0] >> 4;
+    *flags = buf[0] & 0x0F;
+    *body = pos;
+    *body_len = remaining;
+    return (long)(pos + remaining);
+}
+
+long mqtt_publish_payload(const uint8_t *body, size_t body_len, uint8_t flags) {
+    if (body_len < 2) {
+        return -1;
+    }
+    size_t pos = 2 + ((size_t)body[0] << 8 | body[1]);
+    if ((flags >> 1) & 3) {
+        pos += 2;
+    }
+    return pos <= body_len ? (long)pos : -1;
+}
+
+/* ============================================================================
+ * COAP
+ * ========================================================================= */
+
+#define COAP_TYPE_CON 0
+#define COAP_TYPE_NON 1
+#define COAP_CODE_POST 2
+#define COAP_OPTION_URI_PATH 11
+
+static size_t put_uri_segment(uint8_t *buf, unsigned delta, const char *segment) {
+    size_t len = strlen(segment);          /* Segments here are < 13 bytes */
+    buf[0] = (uint8_t)(delta << 4 | len);
+    memcpy(buf + 1, segment, len);
+    return len + 1;
+}
+
+size_t coap_encode_post(uint8_t *buf, size_t size, bool confirmable, uint16_t message_id,
+                        unsigned topic, const uint8_t *payload, size_t payload_len) {
+    char topic_segment[12];
+    snprintf(topic_segment, sizeof(topic_segment), "%u", topic);
+    if (size < 4 + 9 + 2 + 12 + 1 + payload_len) {
+        return 0;
+    }
+
+    size_t pos = 0;
+    buf[pos++] = (uint8_t)(1 << 6 | (confirmable ? COAP_TYPE_CON : COAP_TYPE_NON) << 4);
+    buf[pos++] = COAP_CODE_POST;
+    buf[pos++] = (uint8_t)(message_id >> 8);
+    buf[pos++] = (uint8_t)message_id;
+
+    /* Uri-Path: loadgen / t / <topic> */
+    pos += put_uri_segment(buf + pos, COAP_OPTION_URI_PATH, "loadgen");
+    pos += put_uri_segment(buf + pos, 0, "t");
+    pos += put_uri_segment(buf + pos, 0, topic_segment);
+
+    if (payload_len > 0) {
+        buf[pos++] = 0xFF;
+        memcpy(buf + pos, payload, payload_len);
+        pos += payload_len;
+    }
+    return pos;
+}
+
+bool coap_parse_header(const uint8_t *buf, size_t len, uint8_t *type, uint16_t *message_id) {
+    if (len < 4 || (buf[0] >> 6) != 1) {
+        return false;
+    }
+    *type = (buf[0] >> 4) & 3;
+    *message_id = (uint16_t)(buf[2] << 8 | buf[3]);
+    return true;
+}
+
+/* ============================================================================
+ * PAYLOAD HEADER
+ * ========================================================================= */
+
+void loadgen_payload_stamp(uint8_t *payload, uint64_t now_ns) {
+    memcpy(payload, PAYLOAD_MAGIC, 4);
+    memset(payload + 4, 0, 4);
+    for (int i = 0; i < 8; i++) {
+        payload[8 + i] = (uint8_t)(now_ns >> (56 - 8 * i));
+    }
+}
+
+bool loadgen_payload_time(const uint8_t *payload, size_t len, uint64_t *sent_ns) {
+    if (len < LOADGEN_PAYLOAD_HEADER || memcmp(payload, PAYLOAD_MAGIC, 4) != 0) {
+        return false;
+    }
+    uint64_t t = 0;
+    for (int i = 0; i < 8; i++) {
+        t = t << 8 | payload[8 + i];
+    }
+    *sent_ns = t;
+    return true;
+}
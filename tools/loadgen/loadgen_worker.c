@@ -0,0 +1,846 @@
+/**
+ * @file loadgen_worker.c
+ * @brief Epoll worker driving a slice of the simulated fleet
+ * @details Every device has one deadline (connect, publish, keep-alive or
+ *          reconnect) kept in a binary min-heap; the loop sleeps in
+ *          epoll_wait() until the earliest one or until a socket is ready.
+ *          Sends go straight to the socket and only bytes the kernel would
+ *          not take are buffered per device.
+ */
+
+#include "loadgen.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#define NS_PER_SEC 1000000000ULL
+#define CONNECT_TIMEOUT_NS (5 * NS_PER_SEC)
+#define RECONNECT_DELAY_NS NS_PER_SEC
+#define MAX_BACKLOG (256 * 1024)        /* Unsent bytes before publishes are skipped */
+#define SCRATCH_SIZE (LOADGEN_MAX_PAYLOAD + 256)
+#define MAX_EVENTS 256
+#define NEVER UINT64_MAX
+
+typedef enum {
+    KIND_MQTT_PUB,
+    KIND_MQTT_SUB,
+    KIND_COAP
+} device_kind_t;
+
+typedef enum {
+    STATE_DOWN,                         /* Waiting to (re)connect */
+    STATE_CONNECTING,                   /* TCP connect in progress */
+    STATE_HANDSHAKE,                    /* CONNECT or SUBSCRIBE sent */
+    STATE_READY,
+    STATE_CLOSED                        /* Run over */
+} device_state_t;
+
+typedef struct {
+    device_kind_t kind;
+    device_state_t state;
+    int fd;
+    unsigned id;                        /* Global device index */
+    unsigned topic;
+
+    uint64_t due;                       /* Next timer */
+    size_t heap_pos;
+    uint64_t next_publish;
+    uint64_t last_tx;
+    uint64_t connect_start;
+
+    uint8_t *rx;                        /* Partial MQTT packets */
+    size_t rx_len;
+    size_t rx_cap;
+    uint8_t *tx;                        /* Bytes the socket did not take */
+    size_t tx_len;
+    size_t tx_cap;
+    bool polling_out;
+
+    /* QoS 1 / CON exchanges in flight, slot = id % LOADGEN_WINDOW */
+    uint16_t next_id;
+    uint16_t window_id[LOADGEN_WINDOW];
+    uint64_t window_sent[LOADGEN_WINDOW];   /* 0 = free */
+    unsigned inflight;
+} device_t;
+
+struct loadgen_worker {
+    const loadgen_options_t *options;
+    unsigned index;
+    int epoll_fd;
+
+    device_t *devices;
+    unsigned num_devices;
+    device_t **heap;
+    size_t heap_len;
+
+    struct sockaddr_in mqtt_addr;
+    struct sockaddr_in coap_addr;
+    uint64_t rng;
+    uint64_t ramp_end;
+    uint64_t publish_end;
+    uint64_t end;
+    uint64_t next_storm;
+
+    loadgen_stats_t stats;
+    uint8_t payload[LOADGEN_MAX_PAYLOAD];
+    uint8_t scratch[SCRATCH_SIZE];
+};
+
+uint64_t loadgen_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+/* ============================================================================
+ * RANDOMNESS
+ * ========================================================================= */
+
+static uint64_t rng_next(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ULL;
+}
+
+/* Uniform in (0, 1] */
+static double rng_unit(uint64_t *state) {
+    return ((double)(rng_next(state) >> 11) + 1.0) / 9007199254740992.0;
+}
+
+static size_t payload_size(loadgen_worker_t *w) {
+    const loadgen_payload_spec_t *spec = &w->options->payload;
+    size_t size;
+
+    switch (spec->dist) {
+    case PAYLOAD_UNIFORM:
+        size = spec->min + (size_t)(rng_next(&w->rng) % (spec->max - spec->min + 1));
+        break;
+    case PAYLOAD_EXPONENTIAL:
+        size = spec->min + (size_t)(-log(rng_unit(&w->rng)) * (spec->mean - (double)spec->min));
+        break;
+    default:
+        size = spec->min;
+        break;
+    }
+    return size < spec->max ? size : spec->max;
+}
+
+static uint64_t publish_gap(loadgen_worker_t *w) {
+    double gap = (double)NS_PER_SEC / w->options->rate;
+    if (w->options->poisson) {
+        gap *= -log(rng_unit(&w->rng));
+    }
+    return (uint64_t)gap + 1;
+}
+
+/* ============================================================================
+ * TIMER HEAP
+ * ========================================================================= */
+
+static void heap_swap(loadgen_worker_t *w, size_t a, size_t b) {
+    device_t *tmp = w->heap[a];
+    w->heap[a] = w->heap[b];
+    w->heap[b] = tmp;
+    w->heap[a]->heap_pos = a;
+    w->heap[b]->heap_pos = b;
+}
+
+static void heap_fix(loadgen_worker_t *w, device_t *dev) {
+    size_t i = dev->heap_pos;
+
+    while (i > 0 && w->heap[(i - 1) / 2]->due > w->heap[i]->due) {
+        heap_swap(w, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    for (;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < w->heap_len && w->heap[left]->due < w->heap[smallest]->due) {
+            smallest = left;
+        }
+        if (right < w->heap_len && w->heap[right]->due < w->heap[smallest]->due) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        heap_swap(w, i, smallest);
+        i = smallest;
+    }
+}
+
+static void set_due(loadgen_worker_t *w, device_t *dev, uint64_t due) {
+    dev->due = due;
+    heap_fix(w, dev);
+}
+
+/* ============================================================================
+ * SOCKETS
+ * ========================================================================= */
+
+static void set_polling(loadgen_worker_t *w, device_t *dev, bool out) {
+    if (dev->polling_out == out) {
+        return;
+    }
+    struct epoll_event ev = { .events = EPOLLIN | (out ? EPOLLOUT : 0), .data.ptr = dev };
+    epoll_ctl(w->epoll_fd, EPOLL_CTL_MOD, dev->fd, &ev);
+    dev->polling_out = out;
+}
+
+static void close_device(device_t *dev, bool abort_connection) {
+    if (dev->fd >= 0) {
+        if (abort_connection) {
+            /* Reset instead of FIN, like a device losing power */
+            struct linger lg = { 1, 0 };
+            setsockopt(dev->fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        }
+        close(dev->fd);
+        dev->fd = -1;
+    }
+    dev->rx_len = 0;
+    dev->tx_len = 0;
+    dev->polling_out = false;
+    dev->inflight = 0;
+    memset(dev->window_sent, 0, sizeof(dev->window_sent));
+}
+
+/* Close and come back after delay_ns (if still publishing) */
+static void reconnect_later(loadgen_worker_t *w, device_t *dev, uint64_t now, uint64_t delay_ns,
+                            bool abort_connection) {
+    close_device(dev, abort_connection);
+    dev->state = STATE_DOWN;
+    set_due(w, dev, now + delay_ns < w->publish_end ? now + delay_ns : NEVER);
+}
+
+static bool append_tx(device_t *dev, const uint8_t *data, size_t len) {
+    if (dev->tx_len + len > dev->tx_cap) {
+        size_t cap = dev->tx_cap ? dev->tx_cap : 4096;
+        while (cap < dev->tx_len + len) {
+            cap *= 2;
+        }
+        uint8_t *tx = realloc(dev->tx, cap);
+        if (!tx) {
+            return false;
+        }
+        dev->tx = tx;
+        dev->tx_cap = cap;
+    }
+    memcpy(dev->tx + dev->tx_len, data, len);
+    dev->tx_len += len;
+    return true;
+}
+
+/**
+ * Send on a stream socket, keeping what does not fit
+ * @return false if the connection failed
+ */
+static bool send_stream(loadgen_worker_t *w, device_t *dev, const uint8_t *data, size_t len,
+                        uint64_t now) {
+    size_t sent = 0;
+
+    if (dev->tx_len == 0) {
+        while (sent < len) {
+            ssize_t n = send(dev->fd, data + sent, len - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += (size_t)n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    if (sent < len) {
+        if (!append_tx(dev, data + sent, len - sent)) {
+            return false;
+        }
+        set_polling(w, dev, true);
+    }
+
+    w->stats.bytes_sent += len;
+    dev->last_tx = now;
+    return true;
+}
+
+static bool flush_stream(loadgen_worker_t *w, device_t *dev) {
+    size_t sent = 0;
+
+    while (sent < dev->tx_len) {
+        ssize_t n = send(dev->fd, dev->tx + sent, dev->tx_len - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    memmove(dev->tx, dev->tx + sent, dev->tx_len - sent);
+    dev->tx_len -= sent;
+    set_polling(w, dev, dev->tx_len > 0);
+    return true;
+}
+
+/* ============================================================================
+ * CONNECTION SETUP
+ * ========================================================================= */
+
+static uint64_t ready_due(loadgen_worker_t *w, const device_t *dev) {
+    uint64_t due = NEVER;
+
+    if (dev->kind != KIND_MQTT_SUB && dev->next_publish < w->publish_end) {
+        due = dev->next_publish;
+    }
+    if (dev->kind != KIND_COAP) {
+        uint64_t ping = dev->last_tx + (uint64_t)w->options->keepalive_s * NS_PER_SEC / 2;
+        due = ping < due ? ping : due;
+    }
+    return due;
+}
+
+static void become_ready(loadgen_worker_t *w, device_t *dev, uint64_t now) {
+    dev->state = STATE_READY;
+    if (dev->kind != KIND_COAP) {
+        w->stats.connects++;
+        loadgen_hist_record(&w->stats.connect, now - dev->connect_start);
+    }
+
+    /* Random phase so devices that connected together do not publish together */
+    dev->next_publish = now + (uint64_t)((double)publish_gap(w) * rng_unit(&w->rng));
+    set_due(w, dev, ready_due(w, dev));
+}
+
+static void start_connect(loadgen_worker_t *w, device_t *dev, uint64_t now) {
+    bool stream = dev->kind != KIND_COAP;
+    const struct sockaddr_in *addr = stream ? &w->mqtt_addr : &w->coap_addr;
+
+    dev->fd = socket(AF_INET, (stream ? SOCK_STREAM : SOCK_DGRAM) | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                     0);
+    if (dev->fd < 0) {
+        w->stats.connect_failures++;
+        reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+        return;
+    }
+    if (stream) {
+        int one = 1;
+        setsockopt(dev->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN | (stream ? EPOLLOUT : 0), .data.ptr = dev };
+    dev->polling_out = stream;
+    dev->connect_start = now;
+    if (epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, dev->fd, &ev) != 0 ||
+        (connect(dev->fd, (const struct sockaddr *)addr, sizeof(*addr)) != 0 &&
+         errno != EINPROGRESS)) {
+        w->stats.connect_failures++;
+        reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+        return;
+    }
+
+    if (!stream) {
+        become_ready(w, dev, now);
+        return;
+    }
+    dev->state = STATE_CONNECTING;
+    set_due(w, dev, now + CONNECT_TIMEOUT_NS);
+}
+
+/* TCP connect finished: send CONNECT */
+static void on_connected(loadgen_worker_t *w, device_t *dev, uint64_t now) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(dev->fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+        w->stats.connect_failures++;
+        reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+        return;
+    }
+
+    char client_id[32];
+    snprintf(client_id, sizeof(client_id), "plg-%u", dev->id);
+    size_t n = mqtt_encode_connect(w->scratch, sizeof(w->scratch), client_id,
+                                   w->options->keepalive_s);
+
+    dev->state = STATE_HANDSHAKE;
+    set_polling(w, dev, false);
+    if (!send_stream(w, dev, w->scratch, n, now)) {
+        w->stats.connect_failures++;
+        reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+    }
+}
+
+/* ============================================================================
+ * PUBLISHING
+ * ========================================================================= */
+
+static void publish_mqtt(loadgen_worker_t *w, device_t *dev, uint64_t now) {
+    int qos = rng_next(&w->rng) % 100 < w->options->qos1_percent ? 1 : 0;
+    uint16_t id = 0;
+
+    if (dev->tx_len > MAX_BACKLOG) {
+        w->stats.throttled++;
+        return;
+    }
+    if (qos == 1) {
+        id = ++dev->next_id ? dev->next_id : ++dev->next_id;
+        if (dev->window_sent[id % LOADGEN_WINDOW]) {
+            dev->next_id--;
+            w->stats.throttled++;
+            return;
+        }
+    }
+
+    char topic[32];
+    snprintf(topic, sizeof(topic), LOADGEN_TOPIC_PREFIX "%u", dev->topic);
+    size_t len = payload_size(w);
+    loadgen_payload_stamp(w->payload, now);
+    size_t n = mqtt_encode_publish(w->scratch, sizeof(w->scratch), topic, qos, id, w->payload, len);
+
+    if (!send_stream(w, dev, w->scratch, n, now)) {
+        w->stats.disconnects++;
+        reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+        return;
+    }
+    w->stats.mqtt_published++;
+    if (qos == 1) {
+        dev->window_id[id % LOADGEN_WINDOW] = id;
+        dev->window_sent[id % LOADGEN_WINDOW] = now;
+        dev->inflight++;
+    }
+}
+
+static void publish_coap(loadgen_worker_t *w, device_t *dev, uint64_t now) {
+    bool con = rng_next(&w->rng) % 100 < w->options->qos1_percent;
+    uint16_t mid = dev->next_id++;
+    size_t slot = mid % LOADGEN_WINDOW;
+
+    size_t len = payload_size(w);
+    loadgen_payload_stamp(w->payload, now);
+    size_t n = coap_encode_post(w->scratch, sizeof(w->scratch), con, mid, dev->topic,
+                                w->payload, len);
+
+    ssize_t sent = send(dev->fd, w->scratch, n, MSG_NOSIGNAL);
+    if (sent != (ssize_t)n) {
+        /* Full socket buffer, or ICMP unreachable reported on a connected socket */
+        w->stats.throttled++;
+        return;
+    }
+    w->stats.coap_sent++;
+    w->stats.bytes_sent += n;
+
+    if (con) {
+        if (dev->window_sent[slot]) {
+            w->stats.coap_lost++;   /* Slot reused: the older CON never got its ACK */
+            dev->inflight--;
+        }
+        dev->window_id[slot] = mid;
+        dev->window_sent[slot] = now;
+        dev->inflight++;
+    }
+}
+
+/* ============================================================================
+ * RECEIVING
+ * ========================================================================= */
+
+static void ack_window(device_t *dev, uint16_t id, uint64_t now, loadgen_hist_t *hist,
+                       uint64_t *acked) {
+    size_t slot = id % LOADGEN_WINDOW;
+    if (dev->window_sent[slot] && dev->window_id[slot] == id) {
+        loadgen_hist_record(hist, now - dev->window_sent[slot]);
+        dev->window_sent[slot] = 0;
+        dev->inflight--;
+        (*acked)++;
+    }
+}
+
+/**
+ * Handle one MQTT packet
+ * @return false if the connection must be dropped
+ */
+static bool handle_mqtt_packet(loadgen_worker_t *w, device_t *dev, uint8_t type, uint8_t flags,
+                               const uint8_t *body, size_t body_len, uint64_t now) {
+    switch (type) {
+    case MQTT_CONNACK:
+        if (dev->state != STATE_HANDSHAKE || body_len < 2 || body[1] != 0) {
+            return false;
+        }
+        if (dev->kind == KIND_MQTT_SUB) {
+            size_t n = mqtt_encode_subscribe(w->scratch, sizeof(w->scratch), 1,
+                                             LOADGEN_TOPIC_PREFIX "#", 0);
+            return send_stream(w, dev, w->scratch, n, now);
+        }
+        become_ready(w, dev, now);
+        return true;
+
+    case MQTT_SUBACK:
+        if (dev->state != STATE_HANDSHAKE || body_len < 3 || body[2] == 0x80) {
+            return false;
+        }
+        become_ready(w, dev, now);
+        return true;
+
+    case MQTT_PUBACK:
+        if (body_len >= 2) {
+            ack_window(dev, (uint16_t)(body[0] << 8 | body[1]), now, &w->stats.mqtt_ack,
+                       &w->stats.mqtt_acked);
+        }
+        return true;
+
+    case MQTT_PUBLISH: {
+        long offset = mqtt_publish_payload(body, body_len, flags);
+        if (offset < 0) {
+            return false;
+        }
+        w->stats.mqtt_delivered++;
+
+        uint64_t sent_ns;
+        if (loadgen_payload_time(body + offset, body_len - (size_t)offset, &sent_ns) &&
+            sent_ns <= now) {
+            loadgen_hist_record(&w->stats.e2e, now - sent_ns);
+        }
+
+        /* Acknowledge if the gateway delivered above the granted QoS 0 */
+        if ((flags >> 1) & 3) {
+            uint8_t puback[4] = { MQTT_PUBACK << 4, 2, body[2 + (body[0] << 8 | body[1])],
+                                  body[3 + (body[0] << 8 | body[1])] };
+            return send_stream(w, dev, puback, sizeof(puback), now);
+        }
+        return true;
+    }
+
+    default:
+        return true;                    /* PINGRESP and anything else */
+    }
+}
+
+static void read_stream(loadgen_worker_t *w, device_t *dev, uint64_t now) {
+    for (;;) {
+        if (dev->rx_cap - dev->rx_len < 4096) {
+            size_t cap = dev->rx_cap ? dev->rx_cap * 2 : 4096;
+            uint8_t *rx = realloc(dev->rx, cap);
+            if (!rx) {
+                reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+                return;
+            }
+            dev->rx = rx;
+            dev->rx_cap = cap;
+        }
+
+        ssize_t n = recv(dev->fd, dev->rx + dev->rx_len, dev->rx_cap - dev->rx_len, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (n <= 0) {
+            w->stats.disconnects++;
+            reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+            return;
+        }
+        dev->rx_len += (size_t)n;
+        w->stats.bytes_received += (size_t)n;
+    }
+
+    size_t offset = 0;
+    for (;;) {
+        uint8_t type;
+        uint8_t flags;
+        size_t body;
+        size_t body_len;
+        long len = mqtt_parse_packet(dev->rx + offset, dev->rx_len - offset, &type, &flags,
+                                     &body, &body_len);
+        if (len == 0) {
+            break;
+        }
+        if (len < 0 ||
+            !handle_mqtt_packet(w, dev, type, flags, dev->rx + offset + body, body_len, now)) {
+            w->stats.protocol_errors++;
+            reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+            return;
+        }
+        if (dev->fd < 0) {
+            return;
+        }
+        offset += (size_t)len;
+    }
+
+    memmove(dev->rx, dev->rx + offset, dev->rx_len - offset);
+    dev->rx_len -= offset;
+}
+
+static void read_datagrams(loadgen_worker_t *w, device_t *dev, uint64_t now) {
+    uint8_t buf[1500];
+
+    for (;;) {
+        ssize_t n = recv(dev->fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            break;                      /* EAGAIN, or ICMP errors on a connected socket */
+        }
+        w->stats.bytes_received += (size_t)n;
+
+        uint8_t type;
+        uint16_t mid;
+        if (!coap_parse_header(buf, (size_t)n, &type, &mid)) {
+            w->stats.protocol_errors++;
+        } else if (type == 2) {         /* ACK */
+            ack_window(dev, mid, now, &w->stats.coap_ack, &w->stats.coap_acked);
+        } else if (type == 3) {         /* RST */
+            w->stats.protocol_errors++;
+        }
+    }
+}
+
+static void handle_event(loadgen_worker_t *w, device_t *dev, uint32_t events, uint64_t now) {
+    if (dev->fd < 0) {
+        return;
+    }
+
+    if (dev->kind == KIND_COAP) {
+        read_datagrams(w, dev, now);
+        return;
+    }
+
+    if (dev->state == STATE_CONNECTING) {
+        if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+            on_connected(w, dev, now);
+        }
+        return;
+    }
+
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        read_stream(w, dev, now);
+    }
+    if (dev->fd >= 0 && (events & EPOLLOUT) && !flush_stream(w, dev)) {
+        w->stats.disconnects++;
+        reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+    }
+}
+
+/* ============================================================================
+ * TIMERS
+ * ========================================================================= */
+
+static void on_timer(loadgen_worker_t *w, device_t *dev, uint64_t now) {
+    switch (dev->state) {
+    case STATE_DOWN:
+        if (now < w->publish_end) {
+            start_connect(w, dev, now);
+        } else {
+            set_due(w, dev, NEVER);
+        }
+        return;
+
+    case STATE_CONNECTING:
+    case STATE_HANDSHAKE:
+        w->stats.connect_failures++;
+        reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+        return;
+
+    case STATE_READY:
+        break;
+
+    default:
+        set_due(w, dev, NEVER);
+        return;
+    }
+
+    if (dev->kind != KIND_MQTT_SUB && now >= dev->next_publish && now >= w->publish_end) {
+        dev->next_publish = NEVER;      /* Publishing is over */
+    } else if (dev->kind != KIND_MQTT_SUB && now >= dev->next_publish) {
+        if (dev->kind == KIND_COAP) {
+            publish_coap(w, dev, now);
+        } else {
+            publish_mqtt(w, dev, now);
+        }
+        if (dev->fd < 0) {
+            return;
+        }
+
+        /* Keep the schedule, but do not try to catch up on more than a second */
+        dev->next_publish += publish_gap(w);
+        if (dev->next_publish + NS_PER_SEC < now) {
+            dev->next_publish = now;
+        }
+    }
+
+    if (dev->kind != KIND_COAP &&
+        now >= dev->last_tx + (uint64_t)w->options->keepalive_s * NS_PER_SEC / 2) {
+        size_t n = mqtt_encode_simple(w->scratch, MQTT_PINGREQ);
+        if (!send_stream(w, dev, w->scratch, n, now)) {
+            w->stats.disconnects++;
+            reconnect_later(w, dev, now, RECONNECT_DELAY_NS, false);
+            return;
+        }
+    }
+
+    set_due(w, dev, ready_due(w, dev));
+}
+
+/* Drop a share of the MQTT sessions at once; they all reconnect immediately */
+static void reconnect_storm(loadgen_worker_t *w, uint64_t now) {
+    for (unsigned i = 0; i < w->num_devices; i++) {
+        device_t *dev = &w->devices[i];
+        if (dev->kind == KIND_COAP || dev->state == STATE_DOWN ||
+            rng_unit(&w->rng) > w->options->storm_fraction) {
+            continue;
+        }
+        w->stats.storm_drops++;
+        reconnect_later(w, dev, now, 0, true);
+    }
+}
+
+/* ============================================================================
+ * WORKER API
+ * ========================================================================= */
+
+loadgen_worker_t *loadgen_worker_create(const loadgen_options_t *options, unsigned index,
+                                        unsigned first_device, unsigned mqtt, unsigned coap,
+                                        unsigned subscribers) {
+    loadgen_worker_t *w = calloc(1, sizeof(*w));
+    if (!w) {
+        return NULL;
+    }
+    w->options = options;
+    w->index = index;
+    w->num_devices = mqtt + coap + subscribers;
+    w->rng = options->seed ^ (0x9E3779B97F4A7C15ULL * (index + 1));
+    w->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    w->devices = calloc(w->num_devices ? w->num_devices : 1, sizeof(device_t));
+    w->heap = calloc(w->num_devices ? w->num_devices : 1, sizeof(device_t *));
+    if (w->epoll_fd < 0 || !w->devices || !w->heap) {
+        loadgen_worker_destroy(w);
+        return NULL;
+    }
+
+    w->mqtt_addr.sin_family = AF_INET;
+    w->mqtt_addr.sin_port = htons(options->mqtt_port);
+    w->coap_addr.sin_family = AF_INET;
+    w->coap_addr.sin_port = htons(options->coap_port);
+    if (inet_pton(AF_INET, options->host, &w->mqtt_addr.sin_addr) != 1) {
+        loadgen_worker_destroy(w);
+        return NULL;
+    }
+    w->coap_addr.sin_addr = w->mqtt_addr.sin_addr;
+
+    /* Payload filler; the header is stamped per message */
+    for (size_t i = 0; i < sizeof(w->payload); i++) {
+        w->payload[i] = (uint8_t)('a' + i % 26);
+    }
+
+    for (unsigned i = 0; i < w->num_devices; i++) {
+        device_t *dev = &w->devices[i];
+        dev->kind = i < mqtt ? KIND_MQTT_PUB : i < mqtt + coap ? KIND_COAP : KIND_MQTT_SUB;
+        dev->id = first_device + i;
+        dev->topic = dev->id % options->topics;
+        dev->fd = -1;
+        dev->next_id = (uint16_t)rng_next(&w->rng);
+        dev->heap_pos = i;
+        w->heap[i] = dev;
+    }
+    w->heap_len = w->num_devices;
+
+    return w;
+}
+
+void loadgen_worker_run(loadgen_worker_t *w, uint64_t start_ns) {
+    const loadgen_options_t *opt = w->options;
+    w->ramp_end = start_ns + (uint64_t)(opt->ramp_s * NS_PER_SEC);
+    w->publish_end = w->ramp_end + (uint64_t)(opt->duration_s * NS_PER_SEC);
+    w->end = w->publish_end + (uint64_t)(opt->drain_s * NS_PER_SEC);
+    w->next_storm = opt->storm_interval_s > 0
+                        ? w->ramp_end + (uint64_t)(opt->storm_interval_s * NS_PER_SEC)
+                        : NEVER;
+
+    /* Subscribers connect first so the first publishes have an audience */
+    for (unsigned i = 0; i < w->num_devices; i++) {
+        device_t *dev = &w->devices[i];
+        double at = dev->kind == KIND_MQTT_SUB ? 0.0 : (double)(i + 1) / (w->num_devices + 1);
+        set_due(w, dev, start_ns + (uint64_t)(at * opt->ramp_s * NS_PER_SEC));
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    uint64_t now = loadgen_now_ns();
+
+    while (now < w->end) {
+        uint64_t wake = w->heap_len ? w->heap[0]->due : NEVER;
+        wake = wake < w->next_storm ? wake : w->next_storm;
+        wake = wake < w->end ? wake : w->end;
+        int timeout_ms = wake > now ? (int)((wake - now + 999999) / 1000000) : 0;
+
+        int n = epoll_wait(w->epoll_fd, events, MAX_EVENTS, timeout_ms);
+        now = loadgen_now_ns();
+        for (int i = 0; i < n; i++) {
+            handle_event(w, events[i].data.ptr, events[i].events, now);
+        }
+
+        if (now >= w->next_storm) {
+            if (now < w->publish_end) {
+                reconnect_storm(w, now);
+                w->next_storm += (uint64_t)(opt->storm_interval_s * NS_PER_SEC);
+            } else {
+                w->next_storm = NEVER;
+            }
+        }
+
+        while (w->heap_len && w->heap[0]->due <= now) {
+            on_timer(w, w->heap[0], now);
+        }
+    }
+
+    /* Say goodbye; anything still unacknowledged is lost */
+    for (unsigned i = 0; i < w->num_devices; i++) {
+        device_t *dev = &w->devices[i];
+        if (dev->kind == KIND_COAP) {
+            w->stats.coap_lost += dev->inflight;
+        } else if (dev->state == STATE_READY && dev->tx_len == 0) {
+            size_t len = mqtt_encode_simple(w->scratch, MQTT_DISCONNECT);
+            send(dev->fd, w->scratch, len, MSG_NOSIGNAL);
+        }
+        close_device(dev, false);
+        dev->state = STATE_CLOSED;
+    }
+}
+
+const loadgen_stats_t *loadgen_worker_stats(const loadgen_worker_t *w) {
+    return &w->stats;
+}
+
+void loadgen_worker_destroy(loadgen_worker_t *w) {
+    if (!w) {
+        return;
+    }
+    for (unsigned i = 0; w->devices && i < w->num_devices; i++) {
+        close_device(&w->devices[i], false);
+        free(w->devices[i].rx);
+        free(w->devices[i].tx);
+    }
+    if (w->epoll_fd >= 0) {
+        close(w->epoll_fd);
+    }
+    free(w->devices);
+    free(w->heap);
+    free(w);
+}